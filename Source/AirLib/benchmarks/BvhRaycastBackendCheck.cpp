@@ -0,0 +1,163 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+// Headless check of BvhRaycastBackend: writes a small mesh set in the simGetMeshPositionVertexBuffers JSON layout,
+// loads it and compares ray hits with analytic results. The set is a ground plane and a cube turned 45 degrees around
+// z whose position and orientation fields are not identity, so applying them a second time moves the hits. Random rays
+// are also checked against a brute force loop over all triangles. Distances are in Unreal units (cm).
+//
+// Build from Source/AirLib/include:
+//   g++ -std=c++17 -O2 -I. -I/usr/include/eigen3 ../benchmarks/BvhRaycastBackendCheck.cpp -o raycast_check
+// Exits with 1 on any failure.
+
+#include "common/Common.hpp"
+#include "sensors/raycast/BvhRaycastBackend.hpp"
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+using namespace msr::airlib;
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char* what, float expected = 0, float actual = 0)
+    {
+        if (!condition) {
+            if (failures < 10)
+                std::printf("FAILED: %s (expected %f, got %f)\n", what, expected, actual);
+            ++failures;
+        }
+    }
+
+    nlohmann::json makeMesh(const std::string& name, const std::vector<Vector3r>& vertices, const std::vector<uint32_t>& indices,
+                            const Vector3r& position, const Quaternionr& orientation)
+    {
+        nlohmann::json mesh;
+        mesh["name"] = name;
+        mesh["position"] = { position.x(), position.y(), position.z() };
+        mesh["orientation"] = { orientation.w(), orientation.x(), orientation.y(), orientation.z() };
+        std::vector<float> flat;
+        for (const Vector3r& vertex : vertices) {
+            flat.push_back(vertex.x());
+            flat.push_back(vertex.y());
+            flat.push_back(vertex.z());
+        }
+        mesh["vertices"] = flat;
+        mesh["indices"] = indices;
+        mesh["material"] = name + "_material";
+        return mesh;
+    }
+
+    //closest hit over all triangles, the reference for the BVH traversal
+    float bruteForce(const std::vector<std::array<Vector3r, 3>>& triangles, const Vector3r& start, const Vector3r& end)
+    {
+        const Vector3r delta = end - start;
+        const float length = delta.norm();
+        const Vector3r direction = delta / length;
+        float closest = -1;
+        for (const auto& triangle : triangles) {
+            const Vector3r edge1 = triangle[1] - triangle[0], edge2 = triangle[2] - triangle[0];
+            const Vector3r p = direction.cross(edge2);
+            const float determinant = edge1.dot(p);
+            if (std::abs(determinant) < 1e-7f)
+                continue;
+            const Vector3r s = start - triangle[0];
+            const float u = s.dot(p) / determinant;
+            const Vector3r q = s.cross(edge1);
+            const float v = direction.dot(q) / determinant;
+            const float t = edge2.dot(q) / determinant;
+            if (u >= 0 && v >= 0 && u + v <= 1 && t > 0 && t <= length && (closest < 0 || t < closest))
+                closest = t;
+        }
+        return closest;
+    }
+}
+
+int main()
+{
+    const float half_size = 100;
+    const Vector3r cube_center(500, 0, 100);
+    const Quaternionr cube_rotation(Eigen::AngleAxisf(float(M_PI / 4), Vector3r::UnitZ()));
+
+    //vertices are written in world space like GetStaticMeshComponents does
+    std::vector<Vector3r> cube_vertices;
+    for (int i = 0; i < 8; ++i) {
+        const Vector3r corner((i & 1) ? half_size : -half_size, (i & 2) ? half_size : -half_size, (i & 4) ? half_size : -half_size);
+        cube_vertices.push_back(cube_rotation._transformVector(corner) + cube_center);
+    }
+    const std::vector<uint32_t> cube_indices = { 0, 1, 3, 0, 3, 2, 4, 6, 7, 4, 7, 5, 0, 4, 5, 0, 5, 1,
+                                                 2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 5, 7, 1, 7, 3 };
+    const std::vector<Vector3r> ground_vertices = { Vector3r(-5000, -5000, 0), Vector3r(5000, -5000, 0), Vector3r(5000, 5000, 0), Vector3r(-5000, 5000, 0) };
+    const std::vector<uint32_t> ground_indices = { 0, 1, 2, 0, 2, 3 };
+
+    nlohmann::json doc = nlohmann::json::array();
+    doc.push_back(makeMesh("Ground", ground_vertices, ground_indices, Vector3r(0, 0, 0), Quaternionr::Identity()));
+    doc.push_back(makeMesh("Cube", cube_vertices, cube_indices, cube_center, cube_rotation));
+    const std::string file_path = "bvh_raycast_check_meshes.json";
+    {
+        std::ofstream file(file_path);
+        file << doc.dump();
+    }
+
+    BvhRaycastBackend backend;
+    check(backend.loadMeshFile(file_path), "load mesh file");
+    std::remove(file_path.c_str());
+    check(backend.getObjectCount() == 2, "object count", 2, float(backend.getObjectCount()));
+    check(backend.getTriangleCount() == 14, "triangle count", 14, float(backend.getTriangleCount()));
+
+    //the cube footprint is the square |x - 500| + |y| <= 100 sqrt(2), rays along x at height 100
+    const float diagonal = half_size * std::sqrt(2.0f);
+    for (float y : { -120.0f, -50.0f, 20.0f, 75.0f }) {
+        IRaycastBackend::RaycastHit hit;
+        const Vector3r start(0, y, 100);
+        check(backend.raycast(start, Vector3r(2000, y, 100), hit), "cube hit");
+        const float expected_x = cube_center.x() - diagonal + std::abs(y);
+        check(std::abs(hit.point.x() - expected_x) < 1e-2f, "cube entry x", expected_x, hit.point.x());
+        check(std::abs(hit.distance - expected_x) < 1e-2f, "cube entry distance", expected_x, hit.distance);
+        check(hit.label == "Cube" && hit.material == "Cube_material", "cube label");
+        const Vector3r expected_normal = Vector3r(-1, y > 0 ? 1 : -1, 0).normalized();
+        check((hit.normal - expected_normal).norm() < 1e-4f, "cube normal", 0, (hit.normal - expected_normal).norm());
+
+        vector<IRaycastBackend::RaycastHit> hits;
+        check(backend.raycastMulti(start, Vector3r(2000, y, 100), hits) == 2, "cube entry and exit", 2, float(hits.size()));
+        if (hits.size() == 2) {
+            const float exit_x = cube_center.x() + diagonal - std::abs(y);
+            check(std::abs(hits[1].point.x() - exit_x) < 1e-2f, "cube exit x", exit_x, hits[1].point.x());
+        }
+    }
+
+    //outside the footprint the ray passes the cube, straight down it hits the top face or the ground
+    IRaycastBackend::RaycastHit hit;
+    check(!backend.raycast(Vector3r(0, 150, 100), Vector3r(2000, 150, 100), hit), "ray beside the cube misses");
+    check(backend.raycast(Vector3r(500, 30, 1000), Vector3r(500, 30, -1000), hit) && std::abs(hit.point.z() - 200) < 1e-3f,
+          "cube top", 200, hit.point.z());
+    check(backend.raycast(Vector3r(-300, 40, 1000), Vector3r(-300, 40, -1000), hit) && std::abs(hit.point.z()) < 1e-3f && hit.label == "Ground",
+          "ground", 0, hit.point.z());
+    check(!backend.raycast(Vector3r(-300, 40, 1000), Vector3r(-300, 40, 10), hit), "segment ends above the ground");
+
+    //random segments against the brute force reference
+    std::vector<std::array<Vector3r, 3>> triangles;
+    for (size_t i = 0; i < ground_indices.size(); i += 3)
+        triangles.push_back({ ground_vertices[ground_indices[i]], ground_vertices[ground_indices[i + 1]], ground_vertices[ground_indices[i + 2]] });
+    for (size_t i = 0; i < cube_indices.size(); i += 3)
+        triangles.push_back({ cube_vertices[cube_indices[i]], cube_vertices[cube_indices[i + 1]], cube_vertices[cube_indices[i + 2]] });
+
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> uniform(-1000, 1000);
+    int rays = 0, hit_count = 0;
+    for (; rays < 20000; ++rays) {
+        const Vector3r start(uniform(random) + 500, uniform(random), std::abs(uniform(random)) + 1);
+        const Vector3r end(uniform(random) + 500, uniform(random), uniform(random));
+        const float expected = bruteForce(triangles, start, end);
+        const bool is_hit = backend.raycast(start, end, hit);
+        check(is_hit == (expected >= 0), "random ray hit", expected, is_hit ? hit.distance : -1);
+        if (is_hit && expected >= 0) {
+            check(std::abs(hit.distance - expected) < 1e-2f, "random ray distance", expected, hit.distance);
+            ++hit_count;
+        }
+    }
+
+    std::printf("rays=%d hits=%d failures=%d\n", rays, hit_count, failures);
+    return failures == 0 ? 0 : 1;
+}
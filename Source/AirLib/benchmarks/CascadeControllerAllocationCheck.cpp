@@ -0,0 +1,223 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+// Counts heap allocations of the simple_flight CascadeController over a scripted mission that switches goal modes
+// the way the API commands do: climb by velocity, moveByVelocity, moveToPosition, hover at a fixed z, angle and rate
+// commands, with gains changes in between. Every operator new after construction counts. The mission is flown once
+// with and once without bumpless transfer, and the largest output jump at a mode switch is reported for both.
+//
+// Build from Source/AirLib/include:
+//   g++ -std=c++17 -O2 -I. -I/usr/include/eigen3 ../benchmarks/CascadeControllerAllocationCheck.cpp -o cascade_allocation_check
+// Exits with 1 when the controller allocates after construction.
+
+#include "common/common_utils/Utils.hpp"
+#include "vehicles/multirotor/firmwares/simple_flight/firmware/CascadeController.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    long allocation_count = 0;
+
+    void* countedAllocate(size_t size)
+    {
+        ++allocation_count;
+        void* memory = std::malloc(size > 0 ? size : 1);
+        if (memory == nullptr)
+            throw std::bad_alloc();
+        return memory;
+    }
+}
+
+void* operator new(size_t size)
+{
+    return countedAllocate(size);
+}
+void* operator new[](size_t size)
+{
+    return countedAllocate(size);
+}
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+void operator delete[](void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+using namespace simple_flight;
+
+namespace
+{
+    class Clock : public IBoardClock
+    {
+    public:
+        uint64_t now_micros = 0;
+
+        virtual uint64_t micros() const override
+        {
+            return now_micros;
+        }
+        virtual uint64_t millis() const override
+        {
+            return now_micros / 1000;
+        }
+    };
+
+    class Goal : public IGoal
+    {
+    public:
+        Axis4r value;
+        GoalMode mode;
+
+        virtual const Axis4r& getGoalValue() const override
+        {
+            return value;
+        }
+        virtual const GoalMode& getGoalMode() const override
+        {
+            return mode;
+        }
+    };
+
+    //a vehicle slowly drifting and turning, enough to give every controller an error to work on
+    class StateEstimator : public IStateEstimator
+    {
+    public:
+        float t = 0;
+
+        virtual Axis3r getAngles() const override
+        {
+            return Axis3r(0.05f * std::sin(t), 0.05f * std::cos(t), 0.1f * t);
+        }
+        virtual Axis3r getAngularVelocity() const override
+        {
+            return Axis3r(0.05f * std::cos(t), -0.05f * std::sin(t), 0.1f);
+        }
+        virtual Axis3r getPosition() const override
+        {
+            return Axis3r(std::sin(0.3f * t), std::cos(0.3f * t), -10);
+        }
+        virtual Axis3r getLinearVelocity() const override
+        {
+            return Axis3r(0.3f * std::cos(0.3f * t), -0.3f * std::sin(0.3f * t), 0);
+        }
+        virtual Axis4r getOrientation() const override
+        {
+            return Axis4r(1, 0, 0, 0);
+        }
+        virtual GeoPoint getGeoPoint() const override
+        {
+            return GeoPoint();
+        }
+        virtual KinematicsState getKinematicsEstimated() const override
+        {
+            return KinematicsState();
+        }
+        virtual GeoPoint getHomeGeoPoint() const override
+        {
+            return GeoPoint();
+        }
+        virtual Axis3r transformToBodyFrame(const Axis3r& world_frame_val) const override
+        {
+            return world_frame_val;
+        }
+    };
+
+    class CommLink : public ICommLink
+    {
+    public:
+        virtual void log(const std::string& message, int32_t log_level) override
+        {
+            unused(message);
+            unused(log_level);
+        }
+    };
+
+    struct MissionLeg
+    {
+        GoalMode mode;
+        Axis4r value;
+    };
+
+    struct MissionResult
+    {
+        long allocations = 0;
+        float max_jump = 0;
+    };
+
+    MissionResult fly(bool bumpless_transfer, int steps)
+    {
+        Params params;
+        params.bumpless_transfer = bumpless_transfer;
+        Clock clock;
+        Goal goal;
+        StateEstimator state_estimator;
+        CommLink comm_link;
+
+        //what the API commands set, see SimpleFlightApi
+        const MissionLeg legs[] = {
+            { GoalMode::getVelocityMode(), Axis4r(0, 0, -1, 0) }, //climb
+            { GoalMode::getVelocityMode(), Axis4r(2, 1, 0, 0) }, //moveByVelocity
+            { GoalMode::getPositionMode(), Axis4r(10, 5, -10, 0) }, //moveToPosition
+            { GoalMode::getVelocityXYPosZMode(), Axis4r(0, 0, -10, 0) }, //hover
+            { GoalMode::getStandardAngleMode(), Axis4r(0.1f, -0.1f, 0.2f, 0.6f) }, //moveByRollPitchYawThrottle
+            { GoalMode::getAllRateMode(), Axis4r(0.2f, 0.1f, 0.3f, 0.6f) }, //moveByAngleRatesThrottle
+            { GoalMode::getPositionMode(), Axis4r(0, 0, -10, 0) } //goHome
+        };
+        const int leg_steps = 1000;
+
+        CascadeController controller(&params, &clock, &comm_link);
+        controller.initialize(&goal, &state_estimator);
+        controller.reset();
+
+        MissionResult result;
+        const long allocations_before = allocation_count;
+        Axis4r last_output;
+        for (int step = 0; step < steps; ++step) {
+            clock.now_micros += 3000;
+            state_estimator.t += 0.003f;
+            const MissionLeg& leg = legs[(step / leg_steps) % (sizeof(legs) / sizeof(legs[0]))];
+            goal.mode = leg.mode;
+            goal.value = leg.value;
+            if (step % 5000 == 2500)
+                params.gains_changed = true;
+
+            controller.update();
+            const Axis4r& output = controller.getOutput();
+            if (step > 0 && step % leg_steps == 0) {
+                for (unsigned int axis = 0; axis < Axis4r::AxisCount(); ++axis)
+                    result.max_jump = std::max(result.max_jump, std::abs(output[axis] - last_output[axis]));
+            }
+            last_output = output;
+        }
+        result.allocations = allocation_count - allocations_before;
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int steps = argc > 1 ? std::atoi(argv[1]) : 40000;
+
+    int failures = 0;
+    for (const bool bumpless_transfer : { false, true }) {
+        const MissionResult result = fly(bumpless_transfer, steps);
+        std::printf("bumpless transfer %-3s: %ld allocations in %d steps, largest output jump at a mode switch %.4f\n",
+                    bumpless_transfer ? "on" : "off", result.allocations, steps, result.max_jump);
+        if (result.allocations != 0)
+            ++failures;
+    }
+    std::printf("failures=%d\n", failures);
+    return failures == 0 ? 0 : 1;
+}
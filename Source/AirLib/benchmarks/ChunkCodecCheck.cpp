@@ -0,0 +1,143 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+// Round trip and corrupt input check of ChunkCodec. Random, repetitive and mixed buffers must decompress to the
+// original with both codecs. Truncated streams, flipped bytes, wrong raw sizes, raw sizes above kMaxChunkSize and
+// streams whose literal or match lengths run past the raw size must be rejected without growing the output past the
+// raw size. Also times compression and decompression of a 4 MB chunk.
+//
+// Build from Source/AirLib/include:
+//   g++ -std=c++17 -O2 -I. -I/usr/include/eigen3 ../benchmarks/ChunkCodecCheck.cpp -o chunk_codec_check
+// Exits with 1 on any failure.
+
+#include "common/Common.hpp"
+#include "recording/ChunkCodec.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+using namespace msr::airlib;
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const std::string& what)
+    {
+        if (!condition) {
+            if (failures < 10)
+                std::printf("FAILED: %s\n", what.c_str());
+            ++failures;
+        }
+    }
+
+    std::vector<uint8_t> makeBuffer(int kind, size_t size, std::mt19937& random)
+    {
+        std::vector<uint8_t> buffer(size);
+        std::uniform_int_distribution<int> byte(0, 255);
+        for (size_t i = 0; i < size; ++i) {
+            switch (kind) {
+            case 0: //incompressible
+                buffer[i] = static_cast<uint8_t>(byte(random));
+                break;
+            case 1: //long runs, overlapping matches
+                buffer[i] = static_cast<uint8_t>((i / 300) & 0xFF);
+                break;
+            default: //text like pose records with some noise
+                buffer[i] = static_cast<uint8_t>("Drone1\t1234\t0.5\t-2.25\t10\n"[i % 26] + (byte(random) < 8 ? 1 : 0));
+                break;
+            }
+        }
+        return buffer;
+    }
+
+    //the decoder must never hold more than raw_size bytes, whatever the input says
+    bool decompressBounded(const std::vector<uint8_t>& stored, size_t raw_size, std::vector<uint8_t>& out)
+    {
+        const bool ok = ChunkCodec::decompress(ChunkCodec::Type::Lz, stored.data(), stored.size(), raw_size, out);
+        check(out.size() <= raw_size, Utils::stringf("output of %zu bytes stays within raw size %zu", out.size(), raw_size));
+        return ok;
+    }
+}
+
+int main()
+{
+    std::mt19937 random(11);
+    std::vector<uint8_t> stored, out;
+    int round_trips = 0, corrupt_inputs = 0;
+
+    for (const size_t size : { size_t(0), size_t(1), size_t(3), size_t(4), size_t(15), size_t(16), size_t(300), size_t(70000), size_t(1) << 20 }) {
+        for (int kind = 0; kind < 3; ++kind) {
+            const std::vector<uint8_t> raw = makeBuffer(kind, size, random);
+            for (const ChunkCodec::Type type : { ChunkCodec::Type::None, ChunkCodec::Type::Lz }) {
+                ChunkCodec::compress(type, raw.data(), raw.size(), stored);
+                check(ChunkCodec::decompress(type, stored.data(), stored.size(), raw.size(), out) && out == raw,
+                      Utils::stringf("round trip of %zu bytes, kind %d, codec %d", size, kind, static_cast<int>(type)));
+                ++round_trips;
+            }
+
+            ChunkCodec::compress(ChunkCodec::Type::Lz, raw.data(), raw.size(), stored);
+            //wrong raw sizes, both smaller ones (lengths run past it) and larger ones
+            if (size > 0) {
+                check(!decompressBounded(stored, raw.size() - 1, out), Utils::stringf("raw size one short, %zu bytes kind %d", size, kind));
+                check(!decompressBounded(stored, raw.size() / 2, out), Utils::stringf("raw size halved, %zu bytes kind %d", size, kind));
+                corrupt_inputs += 2;
+            }
+            check(!decompressBounded(stored, raw.size() + 1, out), Utils::stringf("raw size one long, %zu bytes kind %d", size, kind));
+            ++corrupt_inputs;
+
+            //truncated streams
+            for (size_t cut : { size_t(1), size_t(2), stored.size() / 2 }) {
+                if (cut == 0 || cut > stored.size())
+                    continue;
+                const std::vector<uint8_t> truncated(stored.begin(), stored.end() - cut);
+                check(!decompressBounded(truncated, raw.size(), out), Utils::stringf("truncated by %zu, %zu bytes kind %d", cut, size, kind));
+                ++corrupt_inputs;
+            }
+
+            //flipped bytes may still decode to something of the right size, they only must not overrun
+            if (!stored.empty()) {
+                for (int flip = 0; flip < 200; ++flip) {
+                    std::vector<uint8_t> corrupt = stored;
+                    corrupt[random() % corrupt.size()] ^= static_cast<uint8_t>(1 + random() % 255);
+                    decompressBounded(corrupt, raw.size(), out);
+                    ++corrupt_inputs;
+                }
+            }
+        }
+    }
+
+    //a header claiming more than the limit is refused before anything is allocated
+    const std::vector<uint8_t> small = { 0x10, 'a' };
+    std::vector<uint8_t> fresh;
+    check(!ChunkCodec::decompress(ChunkCodec::Type::Lz, small.data(), small.size(), ChunkCodec::kMaxChunkSize + 1, fresh) && fresh.capacity() < (size_t(1) << 20),
+          "raw size above kMaxChunkSize");
+    check(!ChunkCodec::decompress(ChunkCodec::Type::None, small.data(), small.size(), ChunkCodec::kMaxChunkSize + 1, out), "stored raw size above kMaxChunkSize");
+
+    //one literal and a match of 15 + 255 * 1000 bytes, far more than the raw size of 64 says
+    std::vector<uint8_t> long_match = { 0x1F, 'a', 0x01, 0x00 };
+    long_match.insert(long_match.end(), 1000, 255);
+    long_match.push_back(0);
+    check(!decompressBounded(long_match, 64, out), "match past the raw size");
+    //a literal run that claims more bytes than the raw size
+    std::vector<uint8_t> long_literals = { 0xF0, 100 };
+    long_literals.insert(long_literals.end(), 115, 'b');
+    check(!decompressBounded(long_literals, 64, out), "literals past the raw size");
+    //a match offset before the start of the output
+    const std::vector<uint8_t> bad_offset = { 0x10, 'a', 0x05, 0x00 };
+    check(!decompressBounded(bad_offset, 64, out), "offset before the output");
+    corrupt_inputs += 5;
+
+    //timing on a chunk of the writer's default size
+    const std::vector<uint8_t> chunk = makeBuffer(2, 4 << 20, random);
+    const auto start = std::chrono::steady_clock::now();
+    ChunkCodec::compress(ChunkCodec::Type::Lz, chunk.data(), chunk.size(), stored);
+    const auto compressed = std::chrono::steady_clock::now();
+    check(ChunkCodec::decompress(ChunkCodec::Type::Lz, stored.data(), stored.size(), chunk.size(), out) && out == chunk, "4 MB round trip");
+    const auto decompressed = std::chrono::steady_clock::now();
+    const double mb = chunk.size() / 1048576.0;
+    std::printf("4 MB chunk: ratio %.2f, compress %.0f MB/s, decompress %.0f MB/s\n", double(chunk.size()) / stored.size(),
+                mb / std::chrono::duration<double>(compressed - start).count(), mb / std::chrono::duration<double>(decompressed - compressed).count());
+
+    std::printf("round_trips=%d corrupt_inputs=%d failures=%d\n", round_trips, corrupt_inputs, failures);
+    return failures == 0 ? 0 : 1;
+}
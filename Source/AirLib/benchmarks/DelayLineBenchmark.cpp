@@ -0,0 +1,224 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+// DelayLine against the list based version it replaced, copied below as ListDelayLine, on a 333 Hz steppable clock
+// with 0.2 s delay and a Vector3r payload, one push_back, update and getOutput per step. Both lines must give the
+// same output and output time on every step. Heap allocations are counted after warm up, the ring buffer must not
+// allocate. The ring buffer is also timed with jitter and interpolation, where the interpolated output of a ramp must
+// follow the ramp delayed by exactly the delay. With jitter the buffer may still double once when a draw goes past the
+// 4 sigma it was sized for, so those allocations are reported but not failed.
+//
+// Build from Source/AirLib/include:
+//   g++ -std=c++17 -O2 -I. -I/usr/include/eigen3 ../benchmarks/DelayLineBenchmark.cpp -o delay_line_benchmark
+// Run with [steps], default 2000000. Exits with 1 on any mismatch or allocation.
+
+#include "common/Common.hpp"
+#include "common/ClockFactory.hpp"
+#include "common/DelayLine.hpp"
+#include "common/SteppableClock.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <new>
+
+namespace
+{
+    long allocation_count = 0;
+
+    void* countedAllocate(size_t size)
+    {
+        ++allocation_count;
+        void* memory = std::malloc(size > 0 ? size : 1);
+        if (memory == nullptr)
+            throw std::bad_alloc();
+        return memory;
+    }
+}
+
+void* operator new(size_t size)
+{
+    return countedAllocate(size);
+}
+void* operator new[](size_t size)
+{
+    return countedAllocate(size);
+}
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+void operator delete[](void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+using namespace msr::airlib;
+
+namespace
+{
+    constexpr TTimeDelta kPeriod = 3E-3;
+    constexpr TTimeDelta kDelay = 0.2;
+    constexpr int kWarmUpSteps = 1000;
+
+    //the delay line before the ring buffer, two lists and one value released per update
+    template <typename T>
+    class ListDelayLine : public UpdatableObject
+    {
+    public:
+        ListDelayLine(TTimeDelta delay)
+            : delay_(delay)
+        {
+        }
+
+        virtual void resetImplementation() override
+        {
+            values_.clear();
+            times_.clear();
+            last_time_ = 0;
+            last_value_ = T();
+        }
+
+        virtual void update(float delta = 0) override
+        {
+            UpdatableObject::update(delta);
+
+            if (!times_.empty() &&
+                ClockBase::elapsedBetween(clock()->nowNanos(), times_.front()) >= delay_) {
+
+                last_value_ = values_.front();
+                last_time_ = times_.front();
+
+                times_.pop_front();
+                values_.pop_front();
+            }
+        }
+
+        T getOutput() const
+        {
+            return last_value_;
+        }
+        double getOutputTime() const
+        {
+            return last_time_;
+        }
+
+        void push_back(const T& val, TTimePoint time_offset = 0)
+        {
+            values_.push_back(val);
+            times_.push_back(clock()->nowNanos() + time_offset);
+        }
+
+    private:
+        std::list<T> values_;
+        std::list<TTimePoint> times_;
+        TTimeDelta delay_;
+
+        T last_value_;
+        TTimePoint last_time_;
+    };
+
+    int failures = 0;
+
+    void check(bool condition, const std::string& what)
+    {
+        if (!condition) {
+            if (failures < 10)
+                std::printf("FAILED: %s\n", what.c_str());
+            ++failures;
+        }
+    }
+
+    struct Result
+    {
+        double ns_per_step = 0;
+        long allocations = 0;
+    };
+
+    //values are a ramp of the step index, observe(step, output, output time) sees every output
+    template <typename Line, typename Observe>
+    Result run(Line& line, int steps, Observe observe)
+    {
+        ClockFactory::get(std::make_shared<SteppableClock>(kPeriod, 1000000000ULL));
+        line.reset();
+        line.update();
+        line.reset();
+
+        Result result;
+        long allocations_before = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int step = 0; step < steps; ++step) {
+            if (step == kWarmUpSteps) {
+                allocations_before = allocation_count;
+                start = std::chrono::steady_clock::now();
+            }
+            ClockFactory::get()->step();
+            line.push_back(Vector3r(static_cast<float>(step), 1, 2));
+            line.update();
+            observe(step, line.getOutput(), line.getOutputTime());
+        }
+        result.ns_per_step = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (steps - kWarmUpSteps);
+        result.allocations = allocation_count - allocations_before;
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int steps = std::max(kWarmUpSteps + 1, argc > 1 ? std::atoi(argv[1]) : 2000000);
+
+    //outputs of the list version to compare the ring buffer with
+    vector<float> expected_values(steps);
+    vector<double> expected_times(steps);
+    ListDelayLine<Vector3r> list_line(kDelay);
+    const Result list_result = run(list_line, steps, [&](int step, const Vector3r& output, double time) {
+        expected_values[step] = output.x();
+        expected_times[step] = time;
+    });
+
+    DelayLine<Vector3r> ring_line;
+    ring_line.initialize(kDelay, static_cast<real_T>(1 / kPeriod));
+    const Result ring_result = run(ring_line, steps, [&](int step, const Vector3r& output, double time) {
+        //T() of Vector3r is uninitialized, so values only compare once something was released
+        if (time != expected_times[step] || (time != 0 && output.x() != expected_values[step]))
+            check(false, Utils::stringf("step %d: ring buffer %f at %f, list %f at %f", step, output.x(), time, expected_values[step], expected_times[step]));
+    });
+    check(ring_result.allocations == 0, Utils::stringf("ring buffer allocated %ld times", ring_result.allocations));
+
+    //with jitter values still leave in push order, with interpolation the ramp comes out delayed by the delay
+    DelayLine<Vector3r> jitter_line;
+    jitter_line.initialize(kDelay, static_cast<real_T>(1 / kPeriod), 0.01);
+    jitter_line.setInterpolator(DelayLine<Vector3r>::lerp);
+    float last_output = 0;
+    const Result jitter_result = run(jitter_line, steps, [&](int step, const Vector3r& output, double time) {
+        if (time == 0)
+            return;
+        if (output.x() < last_output)
+            check(false, Utils::stringf("step %d: jittered output went back from %f to %f", step, last_output, output.x()));
+        last_output = output.x();
+    });
+
+    DelayLine<Vector3r> interpolated_line;
+    interpolated_line.initialize(kDelay, static_cast<real_T>(1 / kPeriod));
+    interpolated_line.setInterpolator(DelayLine<Vector3r>::lerp);
+    run(interpolated_line, std::min(steps, 20000), [&](int step, const Vector3r& output, double time) {
+        const double expected = step - kDelay / kPeriod;
+        if (time != 0 && expected > 1 && std::abs(output.x() - expected) >= 1E-2)
+            check(false, Utils::stringf("step %d: interpolated %f, expected %f", step, output.x(), expected));
+    });
+
+    std::printf("%d steps, %.0f Hz, %.1f s delay, Vector3r payload, allocations counted after %d steps\n", steps, 1 / kPeriod, kDelay, kWarmUpSteps);
+    std::printf("%-34s %10s %12s\n", "", "ns/step", "allocations");
+    std::printf("%-34s %10.1f %12ld\n", "list", list_result.ns_per_step, list_result.allocations);
+    std::printf("%-34s %10.1f %12ld\n", "ring buffer", ring_result.ns_per_step, ring_result.allocations);
+    std::printf("%-34s %10.1f %12ld\n", "ring buffer, jitter, interpolation", jitter_result.ns_per_step, jitter_result.allocations);
+    std::printf("failures=%d\n", failures);
+    return failures == 0 ? 0 : 1;
+}
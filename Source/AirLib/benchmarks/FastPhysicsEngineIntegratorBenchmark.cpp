@@ -0,0 +1,272 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+// Accuracy against CPU of the FastPhysicsEngine integrators on three aggressive maneuvers of a 1 kg quadrotor under a
+// simple rate controller: a 15 rad/s flip, a high drag dash and a tilted yaw spin, 3 s each. The error of every
+// integrator and physics period is the largest position and attitude difference from RK4 at 200 us sub-steps fed the
+// same control schedule, so only integration error is measured. CPU is engine time per simulated second. For each
+// period the cheapest integrator whose position error stays below the bound on all maneuvers is listed.
+//
+// Build from Source/AirLib/include:
+//   g++ -std=c++17 -O2 -I. -I/usr/include/eigen3 ../benchmarks/FastPhysicsEngineIntegratorBenchmark.cpp -o integrator_benchmark
+// Run with [max position error in m, default 0.01].
+
+#include "common/Common.hpp"
+#include "common/ClockFactory.hpp"
+#include "common/SteppableClock.hpp"
+#include "physics/FastPhysicsEngine.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace msr::airlib;
+
+namespace
+{
+    typedef FastPhysicsEngine::Integrator Integrator;
+
+    constexpr float kArm = 0.18f;
+    constexpr float kYawTorquePerThrust = 0.02f;
+    constexpr double kManeuverSeconds = 3.0;
+    const Vector3r kInertia(0.0066f, 0.0081f, 0.0142f);
+
+    class Rotor : public PhysicsBodyVertex
+    {
+    public:
+        float thrust = 0;
+
+        Rotor(const Vector3r& position, float direction)
+            : PhysicsBodyVertex(position, Vector3r(0, 0, -1)), direction_(direction)
+        {
+        }
+
+    protected:
+        virtual void setWrench(Wrench& wrench) override
+        {
+            wrench.force = Vector3r(0, 0, -thrust);
+            wrench.torque = Vector3r(0, 0, direction_ * kYawTorquePerThrust * thrust);
+        }
+
+    private:
+        float direction_;
+    };
+
+    class Quadrotor : public PhysicsBody
+    {
+    public:
+        std::vector<Rotor> rotors;
+        std::vector<PhysicsBodyVertex> drag_faces;
+        Kinematics kinematics;
+        Environment environment;
+
+        Quadrotor()
+            : kinematics(Kinematics::State::zero()), environment(Environment::State(Vector3r(0, 0, -100), GeoPoint(47.6, -122.1, 100)))
+        {
+            rotors.emplace_back(Vector3r(kArm, kArm, 0), 1.0f);
+            rotors.emplace_back(Vector3r(-kArm, -kArm, 0), 1.0f);
+            rotors.emplace_back(Vector3r(kArm, -kArm, 0), -1.0f);
+            rotors.emplace_back(Vector3r(-kArm, kArm, 0), -1.0f);
+
+            //a box body, top and bottom three times the side drag
+            const float drag = 0.25f * 1.3f / 2 * 0.1f;
+            drag_faces.emplace_back(Vector3r(0, 0, -0.1f), Vector3r(0, 0, -1), drag * 3);
+            drag_faces.emplace_back(Vector3r(0, 0, 0.1f), Vector3r(0, 0, 1), drag * 3);
+            drag_faces.emplace_back(Vector3r(0, -0.1f, 0), Vector3r(0, -1, 0), drag);
+            drag_faces.emplace_back(Vector3r(0, 0.1f, 0), Vector3r(0, 1, 0), drag);
+            drag_faces.emplace_back(Vector3r(-0.1f, 0, 0), Vector3r(-1, 0, 0), drag);
+            drag_faces.emplace_back(Vector3r(0.1f, 0, 0), Vector3r(1, 0, 0), drag);
+
+            Matrix3x3r inertia = Matrix3x3r::Zero();
+            inertia.diagonal() = kInertia;
+            initialize(1.0f, inertia, &kinematics, &environment);
+        }
+
+        virtual uint wrenchVertexCount() const override
+        {
+            return static_cast<uint>(rotors.size());
+        }
+        virtual PhysicsBodyVertex& getWrenchVertex(uint index) override
+        {
+            return rotors[index];
+        }
+        virtual const PhysicsBodyVertex& getWrenchVertex(uint index) const override
+        {
+            return rotors[index];
+        }
+        virtual uint dragVertexCount() const override
+        {
+            return static_cast<uint>(drag_faces.size());
+        }
+        virtual PhysicsBodyVertex& getDragVertex(uint index) override
+        {
+            return drag_faces[index];
+        }
+        virtual const PhysicsBodyVertex& getDragVertex(uint index) const override
+        {
+            return drag_faces[index];
+        }
+        virtual real_T getRestitution() const override
+        {
+            return 0.5f;
+        }
+        virtual real_T getFriction() const override
+        {
+            return 0.5f;
+        }
+    };
+
+    const char* kManeuvers[] = { "flip", "dash", "yaw spin" };
+
+    //body rate command and thrust in multiples of hover thrust of a maneuver at time t
+    Vector3r getRateCommand(int maneuver, double t, float& thrust_scale)
+    {
+        switch (maneuver) {
+        case 0:
+            thrust_scale = 1.6f;
+            return t < 0.42 ? Vector3r(15, 0, 0) : Vector3r::Zero();
+        case 1:
+            thrust_scale = 1.4f;
+            if (t < 0.1)
+                return Vector3r(0, -6, 0);
+            return t > 1.6 && t < 1.7 ? Vector3r(0, 6, 0) : Vector3r::Zero();
+        default:
+            thrust_scale = 1.1f;
+            return Vector3r(0.8f * float(std::sin(3 * t)), 0.8f * float(std::cos(3 * t)), 8);
+        }
+    }
+
+    struct Result
+    {
+        double max_position_error = 0;
+        double max_attitude_error = 0;
+        double cpu_seconds = 0;
+        std::vector<Kinematics::State> trajectory;
+    };
+
+    //without a reference the trajectory is recorded, with one the errors against it are
+    Result fly(int maneuver, double period, const FastPhysicsEngine::IntegratorParams& params, const Result* reference)
+    {
+        ClockFactory::get(std::make_shared<SteppableClock>(period, 1000000000ULL));
+        Quadrotor quadrotor;
+        FastPhysicsEngine engine;
+        engine.setIntegratorParams(params);
+        quadrotor.kinematics.reset();
+        quadrotor.reset();
+        for (Rotor& rotor : quadrotor.rotors)
+            rotor.reset();
+        for (PhysicsBodyVertex& face : quadrotor.drag_faces)
+            face.reset();
+        engine.reset();
+        engine.insert(&quadrotor);
+
+        Result result;
+        const int ticks = static_cast<int>(kManeuverSeconds / period + 0.5);
+        for (int tick = 0; tick < ticks; ++tick) {
+            const Kinematics::State& state = quadrotor.getKinematics();
+            float thrust_scale;
+            const Vector3r rate_command = getRateCommand(maneuver, tick * period, thrust_scale);
+            const Vector3r torque = kInertia.cwiseProduct((rate_command - state.twist.angular) * 20.0f);
+
+            //mix torque and thrust into the X layout
+            const float hover = 9.81f * thrust_scale / 4;
+            const float yaw = torque.z() / (4 * kYawTorquePerThrust);
+            quadrotor.rotors[0].thrust = hover + (-torque.x() + torque.y()) / (4 * kArm) + yaw;
+            quadrotor.rotors[1].thrust = hover + (torque.x() - torque.y()) / (4 * kArm) + yaw;
+            quadrotor.rotors[2].thrust = hover + (torque.x() + torque.y()) / (4 * kArm) - yaw;
+            quadrotor.rotors[3].thrust = hover + (-torque.x() - torque.y()) / (4 * kArm) - yaw;
+            for (Rotor& rotor : quadrotor.rotors) {
+                rotor.thrust = std::max(0.0f, rotor.thrust);
+                rotor.update();
+            }
+            for (PhysicsBodyVertex& face : quadrotor.drag_faces)
+                face.update();
+
+            ClockFactory::get()->step();
+            const auto start = std::chrono::steady_clock::now();
+            engine.update();
+            result.cpu_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            const Kinematics::State& next = quadrotor.getKinematics();
+            if (reference) {
+                const Kinematics::State& expected = reference->trajectory[tick];
+                result.max_position_error = std::max(result.max_position_error, double((next.pose.position - expected.pose.position).norm()));
+                result.max_attitude_error = std::max(result.max_attitude_error, double(next.pose.orientation.angularDistance(expected.pose.orientation)));
+            }
+            else
+                result.trajectory.push_back(next);
+        }
+        result.cpu_seconds /= kManeuverSeconds;
+        return result;
+    }
+
+    struct Configuration
+    {
+        const char* name;
+        Integrator integrator;
+        TTimeDelta max_sub_step;
+        real_T tolerance;
+    };
+}
+
+int main(int argc, char** argv)
+{
+    const double max_error = argc > 1 ? std::atof(argv[1]) : 0.01;
+
+    const Configuration configurations[] = {
+        { "Verlet", Integrator::Verlet, 0, 0 },
+        { "Verlet/1ms", Integrator::Verlet, 1E-3, 0 },
+        { "SemiImplicitEuler", Integrator::SemiImplicitEuler, 0, 0 },
+        { "SemiImplicitEuler/1ms", Integrator::SemiImplicitEuler, 1E-3, 0 },
+        { "RK4", Integrator::RK4, 0, 0 },
+        { "RK4/2ms", Integrator::RK4, 2E-3, 0 },
+        { "Adaptive 1e-3", Integrator::Adaptive, 0, 1E-3f },
+        { "Adaptive 1e-5", Integrator::Adaptive, 0, 1E-5f }
+    };
+
+    for (const double period : { 3E-3, 6E-3, 12E-3 }) {
+        Result references[3];
+        FastPhysicsEngine::IntegratorParams reference_params;
+        reference_params.integrator = Integrator::RK4;
+        reference_params.max_sub_step = 200E-6;
+        for (int maneuver = 0; maneuver < 3; ++maneuver)
+            references[maneuver] = fly(maneuver, period, reference_params, nullptr);
+
+        std::printf("\nphysics period %.0f ms, error in m and rad, cpu in us per simulated second\n", period * 1E3);
+        std::printf("%-22s", "");
+        for (const char* maneuver : kManeuvers)
+            std::printf(" | %-24s", maneuver);
+        std::printf("\n%-22s", "integrator");
+        for (int maneuver = 0; maneuver < 3; ++maneuver)
+            std::printf(" | %8s %8s %6s", "position", "attitude", "cpu");
+        std::printf("\n");
+
+        const char* cheapest = nullptr;
+        double cheapest_cpu = 0;
+        for (const Configuration& configuration : configurations) {
+            FastPhysicsEngine::IntegratorParams params;
+            params.integrator = configuration.integrator;
+            params.max_sub_step = configuration.max_sub_step;
+            if (configuration.tolerance > 0)
+                params.tolerance = configuration.tolerance;
+
+            std::printf("%-22s", configuration.name);
+            double worst_error = 0, total_cpu = 0;
+            for (int maneuver = 0; maneuver < 3; ++maneuver) {
+                const Result result = fly(maneuver, period, params, &references[maneuver]);
+                std::printf(" | %8.2e %8.2e %6.0f", result.max_position_error, result.max_attitude_error, result.cpu_seconds * 1E6);
+                worst_error = std::max(worst_error, result.max_position_error);
+                total_cpu += result.cpu_seconds;
+            }
+            std::printf("\n");
+
+            if (worst_error <= max_error && (!cheapest || total_cpu < cheapest_cpu)) {
+                cheapest = configuration.name;
+                cheapest_cpu = total_cpu;
+            }
+        }
+        if (cheapest)
+            std::printf("cheapest within %.2e m: %s\n", max_error, cheapest);
+        else
+            std::printf("no integrator within %.2e m\n", max_error);
+    }
+    return 0;
+}
@@ -0,0 +1,159 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+// Measures what ASimModeBase::getMeshPoses and the regex paths of the mesh annotation setters cost at 1k, 10k and
+// 50k components, one blocking game thread task per component against one task per request. The game thread is a
+// worker that runs queued tasks, the caller waits for each like UAirBlueprintLib::RunCommandOnGameThread(..., true).
+// In the editor a task waits for the game thread to pick it up, usually once per frame, so real round trips cost
+// far more than here and this only gives a lower bound for the per component version.
+//
+// Build from Source/AirLib/include:
+//   g++ -std=c++17 -O2 -I. -I/usr/include/eigen3 ../benchmarks/GameThreadBatchBenchmark.cpp -o batch_benchmark -pthread
+
+#include "common/Common.hpp"
+#include "common/VectorMath.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <regex>
+#include <thread>
+
+using namespace msr::airlib;
+
+namespace
+{
+    class GameThread
+    {
+    public:
+        GameThread()
+            : thread_([this]() { run(); })
+        {
+        }
+        ~GameThread()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            wake_.notify_one();
+            thread_.join();
+        }
+
+        void runAndWait(const std::function<void()>& task)
+        {
+            bool done = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                tasks_.push_back([&]() {
+                    task();
+                    std::lock_guard<std::mutex> done_lock(mutex_);
+                    done = true;
+                    done_.notify_one();
+                });
+            }
+            wake_.notify_one();
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_.wait(lock, [&done]() { return done; });
+        }
+
+    private:
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (true) {
+                wake_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+                if (tasks_.empty())
+                    return;
+                std::function<void()> task = std::move(tasks_.front());
+                tasks_.pop_front();
+                lock.unlock();
+                task();
+                lock.lock();
+            }
+        }
+
+        std::mutex mutex_;
+        std::condition_variable wake_, done_;
+        std::deque<std::function<void()>> tasks_;
+        bool stop_ = false;
+        std::thread thread_;
+    };
+
+    //stands in for a mesh component and its annotation
+    struct Component
+    {
+        std::string name;
+        Vector3r location;
+        Quaternionr rotation;
+        int object_id = 0;
+    };
+
+    Pose getPose(const Component& component)
+    {
+        return Pose(component.location, component.rotation);
+    }
+
+    template <typename Function>
+    double seconds(Function function)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main()
+{
+    GameThread game_thread;
+
+    std::printf("%10s %24s %24s %24s %24s\n", "components", "poses per component ms", "poses batched ms",
+                "regex per match ms", "regex batched ms");
+    for (const int count : { 1000, 10000, 50000 }) {
+        std::vector<Component> components(count);
+        for (int i = 0; i < count; ++i) {
+            components[i].name = Utils::stringf("SM_Building_%d_Window%d", i / 8, i % 8);
+            components[i].location = Vector3r(float(i), float(i % 97), float(i % 13));
+            components[i].rotation = VectorMath::toQuaternion(0, 0, i * 0.01f);
+        }
+
+        std::vector<Pose> poses;
+        const double poses_per_component = seconds([&]() {
+            poses.clear();
+            for (const Component& component : components)
+                game_thread.runAndWait([&]() { poses.push_back(getPose(component)); });
+        });
+        const double poses_batched = seconds([&]() {
+            game_thread.runAndWait([&]() {
+                poses.clear();
+                poses.reserve(components.size());
+                for (const Component& component : components)
+                    poses.push_back(getPose(component));
+            });
+        });
+
+        //one in eight names matches
+        const std::string pattern = "sm_building_[0-9]+_window3";
+        const double regex_per_match = seconds([&]() {
+            const std::regex compiled(pattern, std::regex_constants::icase);
+            for (Component& component : components) {
+                if (std::regex_match(component.name, compiled))
+                    game_thread.runAndWait([&]() { component.object_id = 1; });
+            }
+        });
+        const double regex_batched = seconds([&]() {
+            const std::regex compiled(pattern, std::regex_constants::icase);
+            game_thread.runAndWait([&]() {
+                for (Component& component : components) {
+                    if (std::regex_match(component.name, compiled))
+                        component.object_id = 2;
+                }
+            });
+        });
+
+        std::printf("%10d %24.2f %24.2f %24.2f %24.2f\n", count, poses_per_component * 1E3, poses_batched * 1E3,
+                    regex_per_match * 1E3, regex_batched * 1E3);
+    }
+    return 0;
+}
@@ -0,0 +1,416 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+// Headless check of the path tracking behind moveOnPath, moveToPosition, moveToZ and moveToGPS. A SimpleFlight quad
+// flies on FastPhysicsEngine with the world stepping on its own thread like in the simulator, while the caller issues
+// the commands. Every case is flown twice from the same hover, once with the planned trajectory tracker and once with
+// the carrot follower that moveOnPath used before, copied below. Reports the time the call took, the largest and RMS
+// distance from the commanded polyline until two seconds after the call, the distance to the goal when the call
+// returned and the largest distance to the goal in those two seconds.
+//
+// Build from Source/AirLib/include:
+//   g++ -std=c++17 -O2 -I. -I/usr/include/eigen3 ../benchmarks/MoveOnPathTrackingCheck.cpp
+//       ../src/vehicles/multirotor/api/MultirotorApiBase.cpp ../src/safety/*.cpp -o tracking_check -pthread
+// Run with [speedup], the world runs that many times faster than real time (default 3). Exits with 1 when a tracked
+// call fails or ends further from the goal or the path than the carrot follower.
+
+#include "common/Common.hpp"
+#include "common/ClockFactory.hpp"
+#include "common/SteppableClock.hpp"
+#include "physics/World.hpp"
+#include "physics/FastPhysicsEngine.hpp"
+#include "sensors/SensorFactory.hpp"
+#include "vehicles/multirotor/MultiRotorPhysicsBody.hpp"
+#include "vehicles/multirotor/firmwares/simple_flight/SimpleFlightQuadXParams.hpp"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+using namespace msr::airlib;
+
+namespace
+{
+    //SimpleFlightApi plus the carrot follower of the old moveOnPath
+    class CarrotFollowerApi : public SimpleFlightApi
+    {
+    public:
+        CarrotFollowerApi(const MultiRotorParams* vehicle_params, const AirSimSettings::VehicleSetting* vehicle_setting)
+            : SimpleFlightApi(vehicle_params, vehicle_setting)
+        {
+        }
+
+        bool moveOnPathCarrot(const vector<Vector3r>& path, float velocity, float timeout_sec, DrivetrainType drivetrain, const YawMode& yaw_mode,
+                              float lookahead, float adaptive_lookahead)
+        {
+            SingleTaskCall lock(this);
+
+            float command_period_dist = velocity * getCommandPeriod();
+            if (lookahead == 0)
+                throw std::invalid_argument("lookahead distance cannot be 0");
+            else if (lookahead > 0) {
+                if (command_period_dist > lookahead || getDistanceAccuracy() > lookahead)
+                    throw std::invalid_argument("lookahead is too small");
+            }
+            else
+                lookahead = getAutoLookahead(velocity, adaptive_lookahead);
+
+            vector<Vector3r> path3d;
+            vector<PathSegment> path_segs;
+            path3d.push_back(getKinematicsEstimated().pose.position);
+
+            Vector3r point;
+            float path_length = 0;
+            for (uint i = 0; i < path.size(); ++i) {
+                point = path.at(i);
+                PathSegment path_seg(path3d.at(i), point, velocity, path_length);
+                path_length += path_seg.seg_length;
+                path_segs.push_back(path_seg);
+                path3d.push_back(point);
+            }
+            path_segs.push_back(PathSegment(point, point, velocity, path_length));
+
+            float breaking_dist = 0;
+            if (velocity > getMultirotorApiParams().breaking_vel) {
+                breaking_dist = Utils::clip(velocity * getMultirotorApiParams().vel_to_breaking_dist,
+                                            getMultirotorApiParams().min_breaking_dist,
+                                            getMultirotorApiParams().max_breaking_dist);
+            }
+
+            PathPosition cur_path_loc, next_path_loc;
+            cur_path_loc.seg_index = 0;
+            cur_path_loc.offset = 0;
+            cur_path_loc.position = path3d[0];
+
+            float lookahead_error = 0;
+            Waiter waiter(getCommandPeriod(), timeout_sec, getCancelToken());
+
+            setNextPathPosition(path3d, path_segs, cur_path_loc, lookahead + lookahead_error, next_path_loc);
+            float goal_dist = 0;
+
+            while (!waiter.isTimeout() && (next_path_loc.seg_index < path_segs.size() - 1 || goal_dist > 0)) {
+                float seg_velocity = path_segs.at(next_path_loc.seg_index).seg_velocity;
+                float path_length_remaining = path_length - path_segs.at(cur_path_loc.seg_index).seg_path_length - cur_path_loc.offset;
+                if (seg_velocity > getMultirotorApiParams().min_vel_for_breaking && path_length_remaining <= breaking_dist)
+                    seg_velocity = getMultirotorApiParams().breaking_vel;
+
+                moveToPathPosition(next_path_loc.position, seg_velocity, drivetrain, yaw_mode);
+
+                if (!waiter.sleep())
+                    return false;
+
+                const Vector3r& goal_vect = next_path_loc.position - cur_path_loc.position;
+                if (!goal_vect.isZero()) {
+                    const Vector3r& actual_vect = getPosition() - cur_path_loc.position;
+                    const Vector3r& goal_normalized = goal_vect.normalized();
+                    goal_dist = actual_vect.dot(goal_normalized);
+                    if (adaptive_lookahead) {
+                        const Vector3r& actual_on_goal = goal_normalized * goal_dist;
+                        lookahead_error = (actual_vect - actual_on_goal).norm() * adaptive_lookahead;
+                    }
+                }
+                else {
+                    goal_dist = 0;
+                    lookahead_error = 0;
+                    waiter.complete();
+                }
+
+                if (goal_dist >= 0)
+                    setNextPathPosition(path3d, path_segs, cur_path_loc, goal_dist, cur_path_loc);
+                setNextPathPosition(path3d, path_segs, cur_path_loc, lookahead + lookahead_error, next_path_loc);
+            }
+
+            return waiter.isComplete();
+        }
+
+    private:
+        struct PathPosition
+        {
+            uint seg_index;
+            float offset;
+            Vector3r position;
+        };
+
+        struct PathSegment
+        {
+            Vector3r seg_normalized;
+            Vector3r seg;
+            float seg_length;
+            float seg_velocity;
+            float start_z;
+            float seg_path_length;
+
+            PathSegment(const Vector3r& start, const Vector3r& end, float velocity, float path_length)
+            {
+                seg = end - start;
+                seg_length = seg.norm();
+                seg_normalized = seg.normalized();
+                start_z = start.z();
+                seg_path_length = path_length;
+                seg_velocity = velocity;
+            }
+        };
+
+        void moveToPathPosition(const Vector3r& dest, float velocity, DrivetrainType drivetrain, YawMode yaw_mode)
+        {
+            float expected_dist = velocity * getCommandPeriod();
+            const Vector3r cur = getPosition();
+            const Vector3r cur_dest = dest - cur;
+            float cur_dest_norm = cur_dest.norm();
+
+            //adjustYaw of MultirotorApiBase
+            if (drivetrain == DrivetrainType::ForwardOnly && !yaw_mode.is_rate) {
+                if (cur_dest_norm > getDistanceAccuracy())
+                    yaw_mode.yaw_or_rate = VectorMath::normalizeAngle(yaw_mode.yaw_or_rate + std::atan2(cur_dest.y(), cur_dest.x()) * 180 / M_PIf);
+                else
+                    yaw_mode.setZeroRate();
+            }
+
+            Vector3r velocity_vect;
+            if (cur_dest_norm < getDistanceAccuracy())
+                velocity_vect = Vector3r::Zero();
+            else if (cur_dest_norm >= expected_dist)
+                velocity_vect = (cur_dest / cur_dest_norm) * velocity;
+            else
+                velocity_vect = (cur_dest / cur_dest_norm) * (cur_dest_norm / getCommandPeriod());
+
+            if (std::abs(cur.z() - dest.z()) <= getDistanceAccuracy())
+                moveByVelocityInternal(velocity_vect.x(), velocity_vect.y(), 0, yaw_mode);
+            else
+                moveByVelocityInternal(velocity_vect.x(), velocity_vect.y(), velocity_vect.z(), yaw_mode);
+        }
+
+        float setNextPathPosition(const vector<Vector3r>& path, const vector<PathSegment>& path_segs,
+                                  const PathPosition& cur_path_loc, float next_dist, PathPosition& next_path_loc)
+        {
+            uint i = cur_path_loc.seg_index;
+            float offset = cur_path_loc.offset;
+            while (i < path.size() - 1) {
+                const PathSegment& seg = path_segs.at(i);
+                if (seg.seg_length > 0 && seg.seg_length >= next_dist + offset) {
+                    next_path_loc.seg_index = i;
+                    next_path_loc.offset = next_dist + offset;
+                    next_path_loc.position = path.at(i) + seg.seg_normalized * next_path_loc.offset;
+                    return 0;
+                }
+                next_dist -= seg.seg_length - offset;
+                offset = 0;
+                ++i;
+            }
+
+            next_path_loc.seg_index = i;
+            next_path_loc.offset = 0;
+            next_path_loc.position = path.at(i);
+            return next_dist;
+        }
+    };
+
+    //records the true position after every physics step while armed
+    class TrackRecorder : public UpdatableObject
+    {
+    public:
+        TrackRecorder(const Kinematics* kinematics)
+            : kinematics_(kinematics)
+        {
+        }
+
+        virtual void resetImplementation() override
+        {
+        }
+
+        virtual void update(float delta = 0) override
+        {
+            UpdatableObject::update(delta);
+            if (!is_recording_)
+                return;
+            std::lock_guard<std::mutex> lock(mutex_);
+            positions_.push_back(kinematics_->getPose().position);
+        }
+
+        void start()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            positions_.clear();
+            is_recording_ = true;
+        }
+
+        vector<Vector3r> stop()
+        {
+            is_recording_ = false;
+            std::lock_guard<std::mutex> lock(mutex_);
+            return positions_;
+        }
+
+    private:
+        const Kinematics* kinematics_;
+        std::atomic<bool> is_recording_{ false };
+        std::mutex mutex_;
+        vector<Vector3r> positions_;
+    };
+
+    float distanceToPolyline(const Vector3r& point, const vector<Vector3r>& polyline)
+    {
+        float closest = (point - polyline.front()).norm();
+        for (size_t i = 1; i < polyline.size(); ++i) {
+            const Vector3r segment = polyline[i] - polyline[i - 1];
+            const float length_squared = segment.squaredNorm();
+            const float t = length_squared > 0 ? Utils::clip((point - polyline[i - 1]).dot(segment) / length_squared, 0.0f, 1.0f) : 0;
+            closest = std::min(closest, (point - (polyline[i - 1] + segment * t)).norm());
+        }
+        return closest;
+    }
+
+    struct Result
+    {
+        bool is_complete = false;
+        float duration = 0;
+        float max_path_error = 0;
+        float rms_path_error = 0;
+        float end_error = 0;
+        float settle_error = 0;
+    };
+
+    struct Case
+    {
+        const char* name;
+        vector<Vector3r> path;
+        float velocity;
+    };
+}
+
+int main(int argc, char** argv)
+{
+    const float speedup = argc > 1 ? static_cast<float>(std::atof(argv[1])) : 3;
+    const TTimeDelta step = 0.003;
+    ClockFactory::get(std::make_shared<SteppableClock>(step));
+
+    AirSimSettings::VehicleSetting setting("SimpleFlight", AirSimSettings::kVehicleTypeSimpleFlight);
+    auto sensor_factory = std::make_shared<SensorFactory>();
+    SimpleFlightQuadXParams params(&setting, sensor_factory);
+    params.initialize(&setting);
+    CarrotFollowerApi api(&params, &setting);
+
+    const Vector3r start(0, 0, -10);
+    Kinematics::State initial = Kinematics::State::zero();
+    initial.pose.position = start;
+    Kinematics kinematics(initial);
+    Environment environment(Environment::State(start, msr::airlib::GeoPoint(47.641468, -122.140165, 122)));
+    MultiRotorPhysicsBody body(&params, &api, &kinematics, &environment);
+    api.setSimulatedGroundTruth(&kinematics.getState(), &environment);
+    TrackRecorder recorder(&kinematics);
+
+    World world(std::unique_ptr<PhysicsEngineBase>(new FastPhysicsEngine(false)));
+    world.insert(&body);
+    world.insert(&recorder);
+    kinematics.reset();
+    api.reset();
+    world.reset();
+
+    //steps like World::startAsyncUpdator but sleeps between steps, the executor spins and would starve the caller on
+    //a machine with one core
+    std::mutex world_mutex;
+    std::atomic<bool> is_running{ true };
+    std::thread world_thread([&]() {
+        const auto period = std::chrono::duration<double>(step / speedup);
+        auto next = std::chrono::steady_clock::now();
+        while (is_running) {
+            {
+                std::lock_guard<std::mutex> lock(world_mutex);
+                world.update();
+            }
+            next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+            std::this_thread::sleep_until(next);
+        }
+    });
+
+    const vector<Case> cases = {
+        { "straight 30 m", { Vector3r(30, 0, -10) }, 3 },
+        { "straight 30 m", { Vector3r(30, 0, -10) }, 6 },
+        { "straight 30 m", { Vector3r(30, 0, -10) }, 12 },
+        { "climb 20 m", { Vector3r(0, 0, -30) }, 4 },
+        { "diagonal", { Vector3r(25, 15, -18) }, 8 },
+        { "square 20 m", { Vector3r(20, 0, -10), Vector3r(20, 20, -10), Vector3r(0, 20, -10), Vector3r(0, 0, -10) }, 3 },
+        { "square 20 m", { Vector3r(20, 0, -10), Vector3r(20, 20, -10), Vector3r(0, 20, -10), Vector3r(0, 0, -10) }, 6 },
+        { "square 20 m", { Vector3r(20, 0, -10), Vector3r(20, 20, -10), Vector3r(0, 20, -10), Vector3r(0, 0, -10) }, 10 },
+        { "zigzag", { Vector3r(10, 8, -12), Vector3r(20, -8, -8), Vector3r(30, 8, -12), Vector3r(40, 0, -10) }, 6 },
+    };
+
+    int failures = 0;
+    std::printf("%-14s %5s | %-8s %8s %8s %8s %8s %8s\n", "case", "m/s", "method", "time s", "max m", "rms m", "end m", "settle m");
+    for (const Case& test_case : cases) {
+        Result results[2];
+        for (int method = 0; method < 2; ++method) {
+            //every flight starts from the same hover
+            api.enableApiControl(true);
+            api.armDisarm(true);
+            api.moveByVelocity(0, 0, 0, 3, DrivetrainType::MaxDegreeOfFreedom, YawMode::Zero());
+
+            vector<Vector3r> polyline = { kinematics.getPose().position };
+            polyline.insert(polyline.end(), test_case.path.begin(), test_case.path.end());
+            const float timeout = 120;
+
+            recorder.start();
+            const TTimePoint call_start = ClockFactory::get()->nowNanos();
+            Result& result = results[method];
+            try {
+                const Vector3r& goal = test_case.path.back();
+                if (method == 0 && test_case.path.size() == 1)
+                    result.is_complete = api.moveToPosition(goal.x(), goal.y(), goal.z(), test_case.velocity, timeout, DrivetrainType::MaxDegreeOfFreedom, YawMode::Zero(), -1, 1);
+                else if (method == 0)
+                    result.is_complete = api.moveOnPath(test_case.path, test_case.velocity, timeout, DrivetrainType::MaxDegreeOfFreedom, YawMode::Zero(), -1, 1);
+                else
+                    result.is_complete = api.moveOnPathCarrot(test_case.path, test_case.velocity, timeout, DrivetrainType::MaxDegreeOfFreedom, YawMode::Zero(), -1, 1);
+            }
+            catch (const std::exception& ex) {
+                std::printf("%s threw: %s\n", test_case.name, ex.what());
+            }
+            result.duration = static_cast<float>(ClockFactory::get()->elapsedSince(call_start));
+            result.end_error = (kinematics.getPose().position - test_case.path.back()).norm();
+
+            //the tracker ends with a hover command, the carrot follower leaves its last velocity command to time out
+            const TTimePoint settle_start = ClockFactory::get()->nowNanos();
+            while (ClockFactory::get()->elapsedSince(settle_start) < 2) {
+                result.settle_error = std::max(result.settle_error, (kinematics.getPose().position - test_case.path.back()).norm());
+                ClockFactory::get()->sleep_for(step);
+            }
+            const vector<Vector3r> flown = recorder.stop();
+
+            //back to the start for the next flight, UpdatableObject ignores a reset until it was updated once so
+            //this has to follow the flight
+            {
+                std::lock_guard<std::mutex> lock(world_mutex);
+                kinematics.reset();
+                api.reset();
+                world.reset();
+            }
+
+            double sum_squared = 0;
+            for (const Vector3r& position : flown) {
+                const float error = distanceToPolyline(position, polyline);
+                result.max_path_error = std::max(result.max_path_error, error);
+                sum_squared += error * error;
+            }
+            result.rms_path_error = flown.empty() ? 0 : static_cast<float>(std::sqrt(sum_squared / flown.size()));
+
+            std::printf("%-14s %5.1f | %-8s %8.2f %8.2f %8.2f %8.2f %8.2f%s\n", test_case.name, test_case.velocity, method == 0 ? "tracker" : "carrot",
+                        result.duration, result.max_path_error, result.rms_path_error, result.end_error, result.settle_error,
+                        result.is_complete ? "" : "  (not completed)");
+        }
+
+        //the tracker has to finish, and be at least as close to the path and the goal as the old follower
+        const Result& tracker = results[0];
+        const Result& carrot = results[1];
+        if (!tracker.is_complete || tracker.max_path_error > carrot.max_path_error + 0.1f ||
+            tracker.settle_error > std::max(carrot.settle_error, 0.5f)) {
+            std::printf("FAILED: %s at %.1f m/s\n", test_case.name, test_case.velocity);
+            ++failures;
+        }
+    }
+
+    is_running = false;
+    world_thread.join();
+    std::printf("cases=%zu failures=%d\n", cases.size(), failures);
+    return failures == 0 ? 0 : 1;
+}
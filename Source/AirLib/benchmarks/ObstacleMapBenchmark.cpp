@@ -0,0 +1,303 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+// Checks and measures ObstacleMap against the mutex based map it replaced, copied below as LockedObstacleMap.
+//   - replays random 2D updates, blind spot changes and queries on both maps, every query must give the same answer
+//   - bins synthetic lidar scans seen from a tilted and offset sensor into 360 ticks and 8 elevation sectors and
+//     compares every bin with a scalar reference using std::atan2. Points are kept clear of bin edges so the
+//     polynomial atan2 of the map cannot legitimately pick the neighbouring bin.
+//   - times scan ingest, and query latency while another thread keeps updating the map
+//
+// Build from Source/AirLib/include:
+//   g++ -std=c++17 -O2 -I. -I/usr/include/eigen3 ../benchmarks/ObstacleMapBenchmark.cpp ../src/safety/ObstacleMap.cpp
+//       -o obstacle_map_benchmark -pthread
+// Run with [points per scan], default 32768. Exits with 1 on any mismatch.
+
+#include "common/Common.hpp"
+#include "safety/ObstacleMap.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <thread>
+
+using namespace msr::airlib;
+
+namespace
+{
+    //the map before it became lock free, 2D only and every call serialized on one mutex
+    class LockedObstacleMap
+    {
+    public:
+        LockedObstacleMap(int ticks)
+            : distances_(ticks, Utils::max<float>() / 2), confidences_(ticks, 1), ticks_(ticks), blindspots_(ticks, false)
+        {
+        }
+
+        void update(float distance, int tick, int window, float confidence)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (int i = tick - window; i <= tick + window; ++i) {
+                const int iw = wrap(i);
+                distances_[iw] = distance;
+                confidences_[iw] = confidence;
+            }
+        }
+
+        void update(float distances[], float confidences[])
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::copy(distances, distances + ticks_, std::begin(distances_));
+            std::copy(confidences, confidences + ticks_, std::begin(confidences_));
+        }
+
+        void setBlindspot(int tick, bool blindspot)
+        {
+            blindspots_.at(tick) = blindspot;
+        }
+
+        ObstacleMap::ObstacleInfo hasObstacle(int from_tick, int to_tick)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (blindspots_.at(wrap(from_tick)))
+                from_tick--;
+            if (blindspots_.at(wrap(to_tick)))
+                to_tick++;
+            return hasObstacle_(from_tick, to_tick);
+        }
+
+        ObstacleMap::ObstacleInfo getClosestObstacle()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return hasObstacle_(0, ticks_ - 1);
+        }
+
+    private:
+        ObstacleMap::ObstacleInfo hasObstacle_(int from_tick, int to_tick) const
+        {
+            if (from_tick > to_tick) {
+                from_tick = wrap(from_tick);
+                to_tick = wrap(to_tick);
+                if (from_tick > to_tick)
+                    to_tick += ticks_;
+            }
+
+            ObstacleMap::ObstacleInfo obs;
+            obs.distance = Utils::max<float>();
+            obs.confidence = 0;
+            for (int i = from_tick; i <= to_tick; ++i) {
+                const int iw = wrap(i);
+                if (obs.distance > distances_[iw]) {
+                    obs.tick = iw;
+                    obs.distance = distances_[iw];
+                    obs.confidence = confidences_[iw];
+                }
+            }
+            return obs;
+        }
+
+        int wrap(int tick) const
+        {
+            int iw = tick % ticks_;
+            if (iw < 0)
+                iw = ticks_ + iw;
+            return iw;
+        }
+
+        vector<float> distances_;
+        vector<float> confidences_;
+        int ticks_;
+        vector<bool> blindspots_;
+        std::mutex mutex_;
+    };
+
+    int failures = 0;
+
+    void check(bool condition, const std::string& what)
+    {
+        if (!condition) {
+            if (failures < 10)
+                std::printf("FAILED: %s\n", what.c_str());
+            ++failures;
+        }
+    }
+
+    bool sameInfo(const ObstacleMap::ObstacleInfo& a, const ObstacleMap::ObstacleInfo& b)
+    {
+        return a.tick == b.tick && a.distance == b.distance && a.confidence == b.confidence;
+    }
+
+    int replay2D(int updates)
+    {
+        const int ticks = 64;
+        ObstacleMap map(ticks, true);
+        LockedObstacleMap locked(ticks);
+        for (int tick = 1; tick < ticks; tick += 2)
+            locked.setBlindspot(tick, true);
+
+        std::mt19937 random(5);
+        std::uniform_int_distribution<int> tick_value(-2 * ticks, 2 * ticks), window(0, 4), kind(0, 19);
+        std::uniform_real_distribution<float> distance(0.1f, 50), confidence(0, 1);
+        vector<float> distances(ticks), confidences(ticks);
+        int queries = 0;
+        for (int step = 0; step < updates; ++step) {
+            switch (kind(random)) {
+            case 0: {
+                for (int tick = 0; tick < ticks; ++tick) {
+                    distances[tick] = distance(random);
+                    confidences[tick] = confidence(random);
+                }
+                map.update(distances.data(), confidences.data());
+                locked.update(distances.data(), confidences.data());
+                break;
+            }
+            case 1: {
+                const int tick = std::uniform_int_distribution<int>(0, ticks - 1)(random);
+                const bool blindspot = kind(random) < 10;
+                map.setBlindspot(tick, blindspot);
+                locked.setBlindspot(tick, blindspot);
+                break;
+            }
+            default: {
+                const float d = distance(random), c = confidence(random);
+                const int tick = tick_value(random), w = window(random);
+                map.update(d, tick, w, c);
+                locked.update(d, tick, w, c);
+                break;
+            }
+            }
+
+            const int from = tick_value(random), to = tick_value(random);
+            check(sameInfo(map.hasObstacle(from, to), locked.hasObstacle(from, to)), Utils::stringf("2D query %d..%d after update %d", from, to, step));
+            check(sameInfo(map.getClosestObstacle(), locked.getClosestObstacle()), Utils::stringf("closest obstacle after update %d", step));
+            queries += 2;
+        }
+        return queries;
+    }
+
+    //points in the body frame away from tick and sector edges, returned in the sensor frame
+    vector<real_T> makeScan(const ObstacleMap& map, const Pose& sensor_pose, float max_range, int point_count, std::mt19937& random,
+                            vector<Vector3r>& body_points)
+    {
+        const float edge_margin = 2E-3f;
+        const float tick_width = 2 * M_PIf / map.getTicks(), sector_height = M_PIf / map.getSectors();
+        std::uniform_int_distribution<int> tick(0, map.getTicks() - 1), sector(0, map.getSectors() - 1);
+        std::uniform_real_distribution<float> unit(0, 1), range(0.3f, max_range * 1.2f);
+
+        vector<real_T> point_cloud;
+        body_points.clear();
+        const Quaternionr to_sensor = sensor_pose.orientation.inverse();
+        for (int i = 0; i < point_count; ++i) {
+            const float azimuth = map.tickToAngleStart(tick(random)) + edge_margin + unit(random) * (tick_width - 2 * edge_margin);
+            const float elevation = -M_PIf / 2 + sector(random) * sector_height + edge_margin + unit(random) * (sector_height - 2 * edge_margin);
+            const float r = range(random);
+            const Vector3r body(r * std::cos(elevation) * std::cos(azimuth), r * std::cos(elevation) * std::sin(azimuth), -r * std::sin(elevation));
+            body_points.push_back(body);
+            const Vector3r sensor = to_sensor._transformVector(body - sensor_pose.position);
+            point_cloud.insert(point_cloud.end(), { sensor.x(), sensor.y(), sensor.z() });
+        }
+        return point_cloud;
+    }
+
+    template <typename Function>
+    double seconds(Function function)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double percentile(vector<double>& values, double fraction)
+    {
+        std::sort(values.begin(), values.end());
+        return values.empty() ? 0 : values[static_cast<size_t>(fraction * (values.size() - 1))];
+    }
+
+    //query latency in us while writer() runs on another thread
+    template <typename Query, typename Writer>
+    void measureQueries(Query query, Writer writer, double& p50, double& p99)
+    {
+        std::atomic<bool> is_running{ true };
+        std::thread writer_thread([&]() {
+            while (is_running)
+                writer();
+        });
+
+        vector<double> latencies;
+        const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+        while (std::chrono::steady_clock::now() < end) {
+            const auto start = std::chrono::steady_clock::now();
+            query();
+            latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        }
+        is_running = false;
+        writer_thread.join();
+
+        p50 = percentile(latencies, 0.5);
+        p99 = percentile(latencies, 0.99);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int point_count = argc > 1 ? std::atoi(argv[1]) : 32768;
+    const int ticks = 360, sectors = 8;
+    const float max_range = 40;
+
+    const int queries = replay2D(20000);
+
+    //sensor 10 cm above and ahead of the body origin, pitched down and yawed
+    ObstacleMap map(ticks, false, sectors);
+    const Pose sensor_pose(Vector3r(0.1f, 0, -0.1f), VectorMath::toQuaternion(-0.2f, 0.05f, 0.4f));
+    std::mt19937 random(9);
+    vector<Vector3r> body_points;
+    int scan_bins = 0;
+    for (int scan = 0; scan < 3; ++scan) {
+        const vector<real_T> point_cloud = makeScan(map, sensor_pose, max_range, scan == 0 ? 200 : point_count, random, body_points);
+        map.update(point_cloud, sensor_pose, max_range, 0.5f);
+
+        vector<float> expected(ticks * sectors, max_range);
+        for (const Vector3r& point : body_points) {
+            const float range = point.norm();
+            if (range >= max_range)
+                continue;
+            int tick = map.angleToTick(std::atan2(point.y(), point.x())) % ticks;
+            tick = tick < 0 ? tick + ticks : tick;
+            const int sector = map.elevationToSector(std::atan2(-point.z(), point.head<2>().norm()));
+            expected[sector * ticks + tick] = std::min(expected[sector * ticks + tick], range);
+        }
+        for (int sector = 0; sector < sectors; ++sector) {
+            for (int tick = 0; tick < ticks; ++tick) {
+                const float actual = map.hasObstacle(tick, tick, sector, sector).distance;
+                check(std::abs(actual - expected[sector * ticks + tick]) < 1E-3f,
+                      Utils::stringf("scan %d tick %d sector %d: expected %f, got %f", scan, tick, sector, expected[sector * ticks + tick], actual));
+                ++scan_bins;
+            }
+        }
+    }
+
+    //ingest throughput
+    const vector<real_T> point_cloud = makeScan(map, sensor_pose, max_range, point_count, random, body_points);
+    const int scans = 50;
+    const double ingest_seconds = seconds([&]() {
+        for (int scan = 0; scan < scans; ++scan)
+            map.update(point_cloud, sensor_pose, max_range, 0.5f);
+    });
+    const double scan_us = ingest_seconds / scans * 1E6;
+
+    //queries of the front cone while the other thread writes
+    double p50, p99, locked_p50, locked_p99;
+    measureQueries([&]() { map.hasObstacle(-10, 10); }, [&]() { map.update(point_cloud, sensor_pose, max_range, 0.5f); }, p50, p99);
+    LockedObstacleMap locked(ticks);
+    vector<float> distances(ticks, 10), confidences(ticks, 0.5f);
+    measureQueries([&]() { locked.hasObstacle(-10, 10); }, [&]() { locked.update(distances.data(), confidences.data()); }, locked_p50, locked_p99);
+
+    std::printf("2D replay: %d queries against the locked map\n", queries);
+    std::printf("scan binning: %d bins checked\n", scan_bins);
+    std::printf("ingest: %d points into %dx%d bins, %.0f us per scan (%.1f Mpoints/s)\n", point_count, ticks, sectors, scan_us, point_count / scan_us);
+    std::printf("query under concurrent updates: p50 %.2f us, p99 %.2f us (locked map: p50 %.2f us, p99 %.2f us)\n", p50, p99, locked_p50, locked_p99);
+    std::printf("failures=%d\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,432 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+// Frames per second of the recording write path with a fake capture instead of Unreal. RecordingFile depends on
+// Unreal, so its queue, writer threads and reorder buffer are copied below without the Unreal types as
+// RecordingPipeline. Every record is a 640x480 PNG sized blob, a 320x240 PPM and a 320x240 PFM, and the capture
+// thread records as fast as it can, like a recording interval shorter than the write time. Writing inline, as before
+// the writer pool, is compared with writer pools with and without dropping on a full queue.
+//   - frames/s and how long appendRecord holds up the capture thread
+//   - the record file lists the records in capture order, every written record has its images on disk with the
+//     right size, and captured = written + dropped
+//
+// Build from Source/AirLib/include:
+//   g++ -std=c++17 -O2 -I. -I/usr/include/eigen3 ../benchmarks/RecordingPipelineBenchmark.cpp -o recording_benchmark -pthread
+// Run with [records output_folder], default 300 and a folder in the temp directory, which is removed afterwards.
+// Exits with 1 on any mismatch.
+
+#include "common/Common.hpp"
+#include "common/ImageCaptureBase.hpp"
+#include "common/common_utils/FileSystem.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+
+using namespace msr::airlib;
+
+namespace
+{
+    typedef ImageCaptureBase::ImageResponse ImageResponse;
+
+    //the write path of Source/Recording/RecordingFile.cpp for image files and airsim_rec.txt
+    class RecordingPipeline
+    {
+    public:
+        struct WriterStats
+        {
+            uint64_t captured = 0;
+            uint64_t written = 0;
+            uint64_t dropped = 0;
+            uint64_t failed = 0;
+            uint64_t max_queue_depth = 0;
+        };
+
+        RecordingPipeline(const std::string& folder)
+            : image_path_(common_utils::FileSystem::combine(folder, "images")), record_file_(common_utils::FileSystem::combine(folder, "airsim_rec.txt"))
+        {
+            std::filesystem::create_directories(image_path_);
+        }
+
+        ~RecordingPipeline()
+        {
+            stopWriters();
+        }
+
+        bool appendRecord(std::vector<ImageResponse>&& responses, uint64_t capture)
+        {
+            PendingRecord record;
+            std::ostringstream image_file_names;
+            for (size_t i = 0; i < responses.size(); ++i) {
+                const auto& response = responses.at(i);
+                std::ostringstream image_file_name;
+                image_file_name << "img_Drone1_" << response.camera_name << "_" << common_utils::Utils::toNumeric(response.image_type)
+                                << "_" << capture << (response.pixels_as_float ? ".pfm" : response.compress ? ".png" : ".ppm");
+                if (i > 0)
+                    image_file_names << ";";
+                image_file_names << image_file_name.str();
+                record.image_file_list.push_back(image_file_name.str());
+            }
+            record.image_file_names = image_file_names.str();
+            record.record_line = std::to_string(capture) + "\t";
+            record.responses = std::move(responses);
+
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                ++stats_.captured;
+
+                if (!writers_.empty()) {
+                    if (queue_.size() >= queue_size_) {
+                        if (drop_when_full_) {
+                            ++stats_.dropped;
+                            return false;
+                        }
+                        queue_not_full_.wait(lock, [this]() { return queue_.size() < queue_size_ || stop_writers_; });
+                    }
+
+                    if (!stop_writers_) {
+                        record.sequence = next_sequence_++;
+                        queue_.push_back(std::move(record));
+                        stats_.max_queue_depth = std::max<uint64_t>(stats_.max_queue_depth, queue_.size());
+                        lock.unlock();
+                        queue_not_empty_.notify_one();
+                        return true;
+                    }
+                }
+
+                record.sequence = next_sequence_++;
+            }
+
+            writeRecord(record);
+            return true;
+        }
+
+        void startWriters(int writer_threads, int queue_size, bool drop_when_full)
+        {
+            stopWriters();
+
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            queue_size_ = static_cast<size_t>(std::max(1, queue_size));
+            drop_when_full_ = drop_when_full;
+            stop_writers_ = false;
+            for (int i = 0; i < writer_threads; ++i)
+                writers_.emplace_back(&RecordingPipeline::writerLoop, this);
+        }
+
+        void stopWriters()
+        {
+            std::vector<std::thread> writers;
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex_);
+                stop_writers_ = true;
+                writers.swap(writers_);
+            }
+            queue_not_empty_.notify_all();
+            queue_not_full_.notify_all();
+
+            for (auto& writer : writers)
+                writer.join();
+            record_file_.flush();
+        }
+
+        WriterStats getStats() const
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            return stats_;
+        }
+
+        const std::string& getImagePath() const
+        {
+            return image_path_;
+        }
+
+    private:
+        struct PendingRecord
+        {
+            uint64_t sequence = 0;
+            std::vector<ImageResponse> responses;
+            std::vector<std::string> image_file_list;
+            std::string image_file_names;
+            std::string record_line;
+        };
+
+        struct FinishedRecord
+        {
+            bool success = false;
+            std::string line;
+        };
+
+        void writerLoop()
+        {
+            while (true) {
+                PendingRecord record;
+                {
+                    std::unique_lock<std::mutex> lock(queue_mutex_);
+                    queue_not_empty_.wait(lock, [this]() { return !queue_.empty() || stop_writers_; });
+                    if (queue_.empty())
+                        return;
+
+                    record = std::move(queue_.front());
+                    queue_.pop_front();
+                }
+                queue_not_full_.notify_one();
+
+                writeRecord(record);
+            }
+        }
+
+        void writeRecord(const PendingRecord& record)
+        {
+            bool save_success = false;
+            FinishedRecord finished;
+            for (size_t i = 0; i < record.responses.size(); ++i) {
+                const auto& response = record.responses.at(i);
+                const std::string image_full_file_path = common_utils::FileSystem::combine(image_path_, record.image_file_list.at(i));
+                try {
+                    if (response.pixels_as_float)
+                        common_utils::Utils::writePFMfile(response.image_data_float.data(), response.width, response.height, image_full_file_path);
+                    else if (!response.compress)
+                        common_utils::Utils::writePPMfile(response.image_data_uint8.data(), response.width, response.height, image_full_file_path);
+                    else {
+                        std::ofstream file(image_full_file_path, std::ios::binary);
+                        file.write(reinterpret_cast<const char*>(response.image_data_uint8.data()), response.image_data_uint8.size());
+                        file.close();
+                    }
+                    save_success = true;
+                }
+                catch (std::exception&) {
+                    save_success = false;
+                }
+            }
+
+            finished.success = save_success || record.responses.size() == 0;
+            if (finished.success)
+                finished.line = record.record_line + record.image_file_names;
+            commitRecord(record.sequence, std::move(finished));
+        }
+
+        void commitRecord(uint64_t sequence, FinishedRecord&& record)
+        {
+            std::lock_guard<std::mutex> lock(line_mutex_);
+            finished_records_[sequence] = std::move(record);
+
+            auto it = finished_records_.begin();
+            while (it != finished_records_.end() && it->first == next_commit_sequence_) {
+                const FinishedRecord& finished = it->second;
+                if (finished.success)
+                    record_file_ << finished.line << "\n";
+
+                {
+                    std::lock_guard<std::mutex> stats_lock(queue_mutex_);
+                    if (finished.success)
+                        ++stats_.written;
+                    else
+                        ++stats_.failed;
+                }
+
+                it = finished_records_.erase(it);
+                ++next_commit_sequence_;
+            }
+        }
+
+    private:
+        std::string image_path_;
+        std::ofstream record_file_;
+
+        std::vector<std::thread> writers_;
+        std::deque<PendingRecord> queue_;
+        size_t queue_size_ = 0;
+        bool drop_when_full_ = false;
+        bool stop_writers_ = false;
+        uint64_t next_sequence_ = 0;
+        mutable std::mutex queue_mutex_;
+        std::condition_variable queue_not_empty_;
+        std::condition_variable queue_not_full_;
+
+        std::map<uint64_t, FinishedRecord> finished_records_;
+        uint64_t next_commit_sequence_ = 0;
+        std::mutex line_mutex_;
+
+        WriterStats stats_;
+    };
+
+    //what getImages returns for a scene PNG, a segmentation PPM and a depth PFM
+    class FakeCapture
+    {
+    public:
+        FakeCapture()
+        {
+            std::mt19937 random(11);
+            std::uniform_int_distribution<int> byte(0, 255);
+            std::uniform_real_distribution<float> depth(0.5f, 100);
+
+            ImageResponse scene;
+            scene.camera_name = "front_center";
+            scene.image_type = ImageCaptureBase::ImageType::Scene;
+            scene.width = 640;
+            scene.height = 480;
+            scene.image_data_uint8.resize(640 * 480);
+            for (auto& value : scene.image_data_uint8)
+                value = static_cast<uint8_t>(byte(random));
+
+            ImageResponse segmentation;
+            segmentation.camera_name = "front_center";
+            segmentation.image_type = ImageCaptureBase::ImageType::Segmentation;
+            segmentation.compress = false;
+            segmentation.width = 320;
+            segmentation.height = 240;
+            segmentation.image_data_uint8.resize(320 * 240 * 3);
+            for (auto& value : segmentation.image_data_uint8)
+                value = static_cast<uint8_t>(byte(random) & 0xF0);
+
+            ImageResponse depth_image;
+            depth_image.camera_name = "front_center";
+            depth_image.image_type = ImageCaptureBase::ImageType::DepthPlanar;
+            depth_image.pixels_as_float = true;
+            depth_image.width = 320;
+            depth_image.height = 240;
+            depth_image.image_data_float.resize(320 * 240);
+            for (auto& value : depth_image.image_data_float)
+                value = depth(random);
+
+            responses_ = { scene, segmentation, depth_image };
+        }
+
+        std::vector<ImageResponse> getImages() const
+        {
+            return responses_;
+        }
+
+        //size of the file writeRecord produces for each response
+        static uintmax_t fileSize(const ImageResponse& response)
+        {
+            if (response.pixels_as_float)
+                return std::to_string(response.width).size() + std::to_string(response.height).size() + 8 +
+                       response.image_data_float.size() * sizeof(float);
+            if (!response.compress)
+                return std::to_string(response.width).size() + std::to_string(response.height).size() + 9 + response.image_data_uint8.size();
+            return response.image_data_uint8.size();
+        }
+
+        const std::vector<ImageResponse>& getResponses() const
+        {
+            return responses_;
+        }
+
+    private:
+        std::vector<ImageResponse> responses_;
+    };
+
+    int failures = 0;
+
+    void check(bool condition, const std::string& what)
+    {
+        if (!condition) {
+            if (failures < 10)
+                std::printf("FAILED: %s\n", what.c_str());
+            ++failures;
+        }
+    }
+
+    double percentile(std::vector<double>& values, double fraction)
+    {
+        std::sort(values.begin(), values.end());
+        return values.empty() ? 0 : values[static_cast<size_t>(fraction * (values.size() - 1))];
+    }
+
+    struct Configuration
+    {
+        const char* name;
+        int writer_threads;
+        int queue_size;
+        bool drop_when_full;
+    };
+
+    //records as fast as the pipeline takes them, then checks what ended up on disk
+    void run(const Configuration& configuration, const FakeCapture& capture, int records, const std::string& folder)
+    {
+        std::filesystem::remove_all(folder);
+        std::filesystem::create_directories(folder);
+        std::vector<double> append_ms;
+        RecordingPipeline::WriterStats stats;
+        std::string image_path;
+        const auto start = std::chrono::steady_clock::now();
+        {
+            RecordingPipeline pipeline(folder);
+            image_path = pipeline.getImagePath();
+            pipeline.startWriters(configuration.writer_threads, configuration.queue_size, configuration.drop_when_full);
+            for (int record = 0; record < records; ++record) {
+                std::vector<ImageResponse> responses = capture.getImages();
+                const auto append_start = std::chrono::steady_clock::now();
+                pipeline.appendRecord(std::move(responses), record);
+                append_ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - append_start).count());
+            }
+            pipeline.stopWriters();
+            stats = pipeline.getStats();
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        check(stats.captured == static_cast<uint64_t>(records), Utils::stringf("%s: captured %llu of %d", configuration.name, static_cast<unsigned long long>(stats.captured), records));
+        check(stats.written + stats.dropped == stats.captured && stats.failed == 0, Utils::stringf("%s: written + dropped != captured", configuration.name));
+        check(configuration.drop_when_full || stats.dropped == 0, Utils::stringf("%s: dropped without DropWhenFull", configuration.name));
+
+        std::ifstream record_file(common_utils::FileSystem::combine(folder, "airsim_rec.txt"));
+        std::string line;
+        long last_capture = -1;
+        uint64_t lines = 0;
+        while (std::getline(record_file, line)) {
+            ++lines;
+            const long capture_index = std::atol(line.c_str());
+            check(capture_index > last_capture, Utils::stringf("%s: record %ld after %ld", configuration.name, capture_index, last_capture));
+            last_capture = capture_index;
+
+            std::istringstream file_names(line.substr(line.find('\t') + 1));
+            std::string file_name;
+            for (const ImageResponse& response : capture.getResponses()) {
+                std::getline(file_names, file_name, ';');
+                const std::string path = common_utils::FileSystem::combine(image_path, file_name);
+                std::error_code error;
+                check(std::filesystem::file_size(path, error) == FakeCapture::fileSize(response) && !error,
+                      Utils::stringf("%s: %s missing or wrong size", configuration.name, file_name.c_str()));
+            }
+        }
+        check(lines == stats.written, Utils::stringf("%s: %llu lines for %llu written records", configuration.name,
+                                                     static_cast<unsigned long long>(lines), static_cast<unsigned long long>(stats.written)));
+        std::filesystem::remove_all(folder);
+
+        std::printf("%-26s %8.1f %8llu %8llu %10.2f %10.2f %8llu\n", configuration.name, stats.written / seconds,
+                    static_cast<unsigned long long>(stats.written), static_cast<unsigned long long>(stats.dropped),
+                    percentile(append_ms, 0.5), percentile(append_ms, 0.99), static_cast<unsigned long long>(stats.max_queue_depth));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int records = argc > 1 ? std::atoi(argv[1]) : 300;
+    const std::string folder = argc > 2 ? std::string(argv[2]) : (std::filesystem::temp_directory_path() / "airsim_recording_benchmark").string();
+
+    const Configuration configurations[] = {
+        { "inline (WriterThreads 0)", 0, 32, false },
+        { "1 writer", 1, 32, false },
+        { "2 writers", 2, 32, false },
+        { "4 writers", 4, 32, false },
+        { "2 writers, DropWhenFull", 2, 32, true }
+    };
+
+    const FakeCapture capture;
+    std::printf("%d records of 3 images, %u cores\n", records, std::thread::hardware_concurrency());
+    std::printf("%-26s %8s %8s %8s %10s %10s %8s\n", "", "frames/s", "written", "dropped", "append p50", "append p99", "queue");
+    for (const Configuration& configuration : configurations)
+        run(configuration, capture, records, folder);
+    std::printf("append in ms on the capture thread, queue is the largest queue depth\n");
+    std::printf("failures=%d\n", failures);
+    return failures == 0 ? 0 : 1;
+}
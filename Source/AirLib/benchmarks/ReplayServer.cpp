@@ -0,0 +1,216 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+// Minimal host for replaying recordings without Unreal, and a check of it.
+//
+//   ReplayServer --serve [port] file.asrec [more.asrec ...]
+//       serves the recording through ReplayRpcLibServer until enter is pressed
+//   ReplayServer
+//       writes a small recording of two vehicles, serves it on a local port and drives it with ReplayRpcLibClient:
+//       steps frames with replayAdvanceFrame, reads the images of both vehicles every frame, the IMU and the ground
+//       truth kinematics, seeks and loops. Exits with 1 on any failure.
+//
+// Links against AirLib and rpclib like any other AirLib client. Built with -DAIRLIB_NO_RPC the check drives
+// ReplayApiProvider directly instead, which only needs the AirLib headers, from Source/AirLib/include:
+//   g++ -std=c++17 -O2 -DAIRLIB_NO_RPC -I. -I/usr/include/eigen3 ../benchmarks/ReplayServer.cpp -o replay_check -pthread
+
+#include "common/Common.hpp"
+#include "common/AirSimSettings.hpp"
+#include "recording/ReplayApi.hpp"
+#include "recording/RecordingConverter.hpp"
+#ifndef AIRLIB_NO_RPC
+#include "recording/ReplayRpcLibServer.hpp"
+#include "recording/ReplayRpcLibClient.hpp"
+#endif
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+
+using namespace msr::airlib;
+
+namespace
+{
+    const char* kVehicles[] = { "Drone1", "Drone2" };
+    constexpr int kFrameCount = 50;
+    constexpr TTimePoint kStartTime = 1000000000ull;
+    constexpr TTimePoint kFramePeriod = 50000000ull;
+
+    int failures = 0;
+
+    void check(bool condition, const std::string& what)
+    {
+        if (!condition) {
+            if (failures < 10)
+                std::printf("FAILED: %s\n", what.c_str());
+            ++failures;
+        }
+    }
+
+    // Every frame holds a pose line, an image and an IMU sample per vehicle, the image pixel and the IMU angular
+    // velocity carry the frame index so the check can tell which frame a result came from
+    void writeRecording(const std::string& path)
+    {
+        RecordingContainerWriter writer;
+        writer.open(path, ChunkCodec::Type::Lz, 4096);
+        const auto pose_channel = writer.addChannel("pose", RecordingContainer::ChannelType::TextLine,
+                                                    "VehicleName\tTimeStamp\tPOS_X\tPOS_Y\tPOS_Z\tQ_W\tQ_X\tQ_Y\tQ_Z\tImageFile");
+        const auto image_channel = writer.addChannel("images", RecordingContainer::ChannelType::ImageFile);
+        std::vector<uint32_t> imu_channels;
+        for (const char* vehicle : kVehicles)
+            imu_channels.push_back(writer.addChannel(std::string("sensors/") + vehicle + "/Imu", RecordingContainer::ChannelType::SensorMessage,
+                                                     SensorMessageCodec::getMetadata(SensorBase::SensorType::Imu)));
+
+        for (int frame = 0; frame < kFrameCount; ++frame) {
+            const TTimePoint time = kStartTime + frame * kFramePeriod;
+            for (size_t vehicle = 0; vehicle < 2; ++vehicle) {
+                ImuBase::Output imu;
+                imu.time_stamp = time;
+                imu.angular_velocity = Vector3r(float(frame), float(vehicle), 0);
+                imu.linear_acceleration = Vector3r::Zero();
+                imu.orientation = Quaternionr::Identity();
+                std::vector<uint8_t> message;
+                SensorMessageCodec::encode(imu, message);
+                writer.write(imu_channels[vehicle], time, message);
+
+                ImageCaptureBase::ImageResponse image;
+                image.width = 1;
+                image.height = 1;
+                image.compress = false;
+                image.image_data_uint8 = { uint8_t(frame), uint8_t(vehicle), 0 };
+                std::vector<uint8_t> file, record;
+                RecordingConverter::encodeImageFile(image, file);
+                const std::string name = Utils::stringf("img_%s_front_0_%llu.ppm", kVehicles[vehicle], static_cast<unsigned long long>(time));
+                RecordingConverter::encodeImageRecord(name, file, record);
+                writer.write(image_channel, time, record);
+
+                writer.write(pose_channel, time, Utils::stringf("%s\t%llu\t%f\t%zu\t0\t1\t0\t0\t0\t%s", kVehicles[vehicle], static_cast<unsigned long long>(time / 1000000), frame * 0.5, vehicle, name.c_str()));
+            }
+        }
+        writer.close();
+    }
+
+    // What the check needs from a replay, over RPC or straight from the provider
+    struct ReplayAccess
+    {
+        std::function<bool()> advance_frame;
+        std::function<void(double)> seek;
+        std::function<void(bool)> set_loop;
+        std::function<std::vector<ImageCaptureBase::ImageResponse>(const std::string&)> get_images;
+        std::function<ImuBase::Output(const std::string&)> get_imu;
+        std::function<Kinematics::State(const std::string&)> get_kinematics;
+    };
+
+    void checkReplay(const ReplayAccess& replay)
+    {
+        replay.seek(0);
+        for (int frame = 0; frame < kFrameCount; ++frame) {
+            check(replay.advance_frame(), Utils::stringf("advance to frame %d", frame));
+            //several image requests per frame must all see the same frame
+            for (int repeat = 0; repeat < 2; ++repeat) {
+                for (size_t vehicle = 0; vehicle < 2; ++vehicle) {
+                    const auto images = replay.get_images(kVehicles[vehicle]);
+                    check(images.size() == 1 && images[0].image_data_uint8.size() == 3 && images[0].image_data_uint8[0] == frame &&
+                              images[0].image_data_uint8[1] == vehicle,
+                          Utils::stringf("image of %s in frame %d", kVehicles[vehicle], frame));
+                }
+            }
+            for (size_t vehicle = 0; vehicle < 2; ++vehicle) {
+                const ImuBase::Output imu = replay.get_imu(kVehicles[vehicle]);
+                check(imu.angular_velocity.x() == frame && imu.angular_velocity.y() == vehicle, Utils::stringf("IMU of %s in frame %d", kVehicles[vehicle], frame));
+                const Kinematics::State kinematics = replay.get_kinematics(kVehicles[vehicle]);
+                check(std::abs(kinematics.pose.position.x() - frame * 0.5f) < 1e-4f && std::abs(kinematics.pose.position.y() - vehicle) < 1e-4f,
+                      Utils::stringf("pose of %s in frame %d", kVehicles[vehicle], frame));
+            }
+        }
+        check(!replay.advance_frame(), "end of the recording without looping");
+
+        replay.seek(1.0);
+        replay.advance_frame();
+        check(replay.get_imu(kVehicles[0]).angular_velocity.x() == 20, "seek to 1 s");
+
+        replay.set_loop(true);
+        replay.seek(100);
+        replay.advance_frame();
+        check(replay.advance_frame() && replay.get_imu(kVehicles[0]).angular_velocity.x() == 0, "loop to the first frame");
+    }
+
+    std::vector<ImageCaptureBase::ImageRequest> frontRequest()
+    {
+        return { ImageCaptureBase::ImageRequest("front", ImageCaptureBase::ImageType::Scene, false, false) };
+    }
+}
+
+int main(int argc, char** argv)
+{
+#ifndef AIRLIB_NO_RPC
+    if (argc > 1 && std::string(argv[1]) == "--serve") {
+        int first_file = 2;
+        uint16_t port = RpcLibPort;
+        if (argc > 2 && std::atoi(argv[2]) > 0) {
+            port = static_cast<uint16_t>(std::atoi(argv[2]));
+            first_file = 3;
+        }
+        if (first_file >= argc) {
+            std::printf("usage: %s --serve [port] file.asrec [more.asrec ...]\n", argv[0]);
+            return 1;
+        }
+
+        RecordingReplay replay;
+        for (int i = first_file; i < argc; ++i)
+            replay.addFile(argv[i]);
+        ReplayApiProvider provider(&replay);
+        ReplayRpcLibServer server(&replay, &provider, "", port);
+        server.start(false, 4);
+        std::printf("Serving %zu vehicles on port %u, press enter to stop\n", replay.getVehicleNames().size(), static_cast<unsigned>(port));
+        std::cin.get();
+        server.stop();
+        return 0;
+    }
+#else
+    unused(argc);
+    unused(argv);
+#endif
+
+    const std::string path = "replay_server_check.asrec";
+    writeRecording(path);
+    RecordingReplay replay;
+    replay.addFile(path);
+    ReplayApiProvider provider(&replay);
+    replay.setPlayback(RecordingReplay::PlaybackMode::AsFastAsPossible);
+
+    ReplayAccess access;
+#ifndef AIRLIB_NO_RPC
+    const uint16_t port = RpcLibPort + 17;
+    ReplayRpcLibServer server(&replay, &provider, "127.0.0.1", port);
+    server.start(false, 4);
+    ReplayRpcLibClient client("127.0.0.1", port);
+    client.confirmConnection();
+
+    access.advance_frame = [&]() { return client.replayAdvanceFrame(); };
+    access.seek = [&](double seconds) { client.replaySeek(seconds); };
+    access.set_loop = [&](bool loop) { client.replaySetLoop(loop); };
+    access.get_images = [&](const std::string& vehicle) { return client.simGetImages(frontRequest(), vehicle); };
+    access.get_imu = [&](const std::string& vehicle) { return client.getImuData("Imu", vehicle); };
+    access.get_kinematics = [&](const std::string& vehicle) { return client.simGetGroundTruthKinematics(vehicle); };
+#else
+    access.advance_frame = [&]() { return replay.advanceFrame(); };
+    access.seek = [&](double seconds) { replay.seekRelative(seconds); };
+    access.set_loop = [&](bool loop) { replay.setLoop(loop); };
+    access.get_images = [&](const std::string& vehicle) {
+        std::vector<ImageCaptureBase::ImageResponse> responses;
+        provider.getVehicleSimApi(vehicle)->getImageCapture()->getImages(frontRequest(), responses);
+        return responses;
+    };
+    access.get_imu = [&](const std::string& vehicle) { return provider.getVehicleApi(vehicle)->getImuData("Imu"); };
+    access.get_kinematics = [&](const std::string& vehicle) { return *provider.getVehicleSimApi(vehicle)->getGroundTruthKinematics(); };
+#endif
+
+    checkReplay(access);
+
+#ifndef AIRLIB_NO_RPC
+    server.stop();
+#endif
+    std::remove(path.c_str());
+    std::printf("frames=%d vehicles=2 failures=%d\n", kFrameCount, failures);
+    return failures == 0 ? 0 : 1;
+}
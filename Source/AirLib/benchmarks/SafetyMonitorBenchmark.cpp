@@ -0,0 +1,218 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+// SafetyMonitor against brute force on a swarm flying a random walk through 100 jagged keep out fences inside one
+// jagged keep in fence, all polygons of 2000 vertices.
+//   - PolygonGeoFence::contains against the even-odd test over every edge of the polygon, on random points
+//   - every step, the violation state each vehicle has from the monitor's events against checking every fence
+//     and every other vehicle
+//   - time per step of the monitor and of the brute force check
+//
+// Build from Source/AirLib/include:
+//   g++ -std=c++17 -O2 -I. -I/usr/include/eigen3 ../benchmarks/SafetyMonitorBenchmark.cpp ../src/safety/SafetyMonitor.cpp
+//       -o safety_monitor_benchmark -pthread
+// Run with [vehicles steps], default 500 300. Exits with 1 on any mismatch.
+
+#include "common/Common.hpp"
+#include "common/ClockFactory.hpp"
+#include "common/SteppableClock.hpp"
+#include "safety/SafetyMonitor.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+using namespace msr::airlib;
+
+namespace
+{
+    constexpr int kVertices = 2000;
+    constexpr float kSeparation = 3;
+
+    struct Fence
+    {
+        vector<Vector2r> vertices;
+        float min_z, max_z;
+        bool keep_out;
+        Vector2r box_min, box_max;
+    };
+
+    int failures = 0;
+
+    void check(bool condition, const std::string& what)
+    {
+        if (!condition) {
+            if (failures < 10)
+                std::printf("FAILED: %s\n", what.c_str());
+            ++failures;
+        }
+    }
+
+    //star shaped polygon with a random radius at every vertex
+    Fence makeFence(const Vector2r& center, float radius, bool keep_out, std::mt19937& random)
+    {
+        std::uniform_real_distribution<float> jag(0.6f, 1.0f);
+        Fence fence;
+        for (int i = 0; i < kVertices; ++i) {
+            const float angle = 2 * M_PIf * i / kVertices;
+            fence.vertices.push_back(center + radius * jag(random) * Vector2r(std::cos(angle), std::sin(angle)));
+        }
+        fence.min_z = keep_out ? -40.0f : -120.0f;
+        fence.max_z = 0;
+        fence.keep_out = keep_out;
+        fence.box_min = fence.box_max = fence.vertices[0];
+        for (const Vector2r& vertex : fence.vertices) {
+            fence.box_min = fence.box_min.cwiseMin(vertex);
+            fence.box_max = fence.box_max.cwiseMax(vertex);
+        }
+        return fence;
+    }
+
+    //even-odd over every edge, with the same float arithmetic as the banded test
+    bool bruteForceContains(const Fence& fence, const Vector3r& point, bool use_box)
+    {
+        if (point.z() < fence.min_z || point.z() > fence.max_z)
+            return false;
+        if (use_box && !(point.x() >= fence.box_min.x() && point.x() <= fence.box_max.x() &&
+                         point.y() >= fence.box_min.y() && point.y() <= fence.box_max.y()))
+            return false;
+
+        const float x = point.x(), y = point.y();
+        bool inside = false;
+        for (size_t i = 0; i < fence.vertices.size(); ++i) {
+            const Vector2r& a = fence.vertices[i];
+            const Vector2r& b = fence.vertices[(i + 1) % fence.vertices.size()];
+            const float dy = b.y() - a.y();
+            if (dy == 0)
+                continue;
+            if ((a.y() > y) != (b.y() > y) && x < a.x() + (y - a.y()) * ((b.x() - a.x()) / dy))
+                inside = !inside;
+        }
+        return inside;
+    }
+
+    //whether each vehicle violates a fence and separation
+    void bruteForceStates(const vector<Fence>& fences, const vector<Kinematics::State>& states, bool use_box,
+                          vector<bool>& fence_violations, vector<bool>& separation_violations)
+    {
+        const size_t count = states.size();
+        fence_violations.assign(count, false);
+        separation_violations.assign(count, false);
+        for (size_t vehicle = 0; vehicle < count; ++vehicle) {
+            const Vector3r& position = states[vehicle].pose.position;
+            bool in_keep_out = false, has_keep_in = false, in_keep_in = false;
+            for (const Fence& fence : fences) {
+                has_keep_in |= !fence.keep_out;
+                const bool inside = bruteForceContains(fence, position, use_box);
+                if (fence.keep_out)
+                    in_keep_out |= inside;
+                else
+                    in_keep_in |= inside;
+            }
+            fence_violations[vehicle] = in_keep_out || (has_keep_in && !in_keep_in);
+
+            for (size_t other = 0; other < count; ++other) {
+                if (other != vehicle && (states[other].pose.position - position).squaredNorm() < kSeparation * kSeparation)
+                    separation_violations[vehicle] = true;
+            }
+        }
+    }
+
+    template <typename Function>
+    double seconds(Function function)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int vehicle_count = argc > 2 ? std::atoi(argv[1]) : 500;
+    const int steps = argc > 2 ? std::atoi(argv[2]) : 300;
+    const float area = 200;
+
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> coordinate(-area / 2, area / 2), radius(3, 10), unit(-1, 1);
+    vector<Fence> fences;
+    fences.push_back(makeFence(Vector2r::Zero(), area * 0.55f, false, random));
+    for (int i = 0; i < 100; ++i)
+        fences.push_back(makeFence(Vector2r(coordinate(random), coordinate(random)), radius(random), true, random));
+
+    SafetyMonitor monitor(1 << 16);
+    for (const Fence& fence : fences)
+        monitor.addFence(std::make_shared<PolygonGeoFence>(fence.vertices, fence.min_z, fence.max_z), fence.keep_out);
+    monitor.setSeparation(kSeparation);
+
+    //point queries, 4000 per fence spread over its box and a margin around it
+    int points = 0;
+    for (const Fence& fence : fences) {
+        const PolygonGeoFence polygon(fence.vertices, fence.min_z, fence.max_z);
+        const Vector2r margin = (fence.box_max - fence.box_min) * 0.1f;
+        std::uniform_real_distribution<float> x(fence.box_min.x() - margin.x(), fence.box_max.x() + margin.x());
+        std::uniform_real_distribution<float> y(fence.box_min.y() - margin.y(), fence.box_max.y() + margin.y());
+        std::uniform_real_distribution<float> z(fence.min_z - 5, fence.max_z + 5);
+        for (int i = 0; i < 4000; ++i, ++points) {
+            const Vector3r point(x(random), y(random), z(random));
+            check(polygon.contains(point) == bruteForceContains(fence, point, false),
+                  Utils::stringf("contains(%s)", VectorMath::toString(point).c_str()));
+        }
+    }
+
+    ClockFactory::get(std::make_shared<SteppableClock>(3E-3f, 1000000000ULL));
+    vector<Kinematics::State> states(vehicle_count, Kinematics::State::zero());
+    vector<Vector3r> velocities(vehicle_count);
+    for (int vehicle = 0; vehicle < vehicle_count; ++vehicle) {
+        states[vehicle].pose.position = Vector3r(coordinate(random) * 1.2f, coordinate(random) * 1.2f, -20 + 5 * unit(random));
+        velocities[vehicle] = Vector3r(unit(random), unit(random), 0.1f * unit(random));
+        monitor.addVehicle(Utils::stringf("Drone%d", vehicle), &states[vehicle]);
+    }
+    monitor.reset();
+
+    vector<bool> fence_states(vehicle_count, false), separation_states(vehicle_count, false);
+    vector<bool> expected_fences, expected_separations;
+    double monitor_seconds = 0;
+    int fence_violations = 0, separation_violations = 0;
+    uint64_t events = 0;
+    for (int step = 0; step < steps; ++step) {
+        for (int vehicle = 0; vehicle < vehicle_count; ++vehicle) {
+            velocities[vehicle] += 0.2f * Vector3r(unit(random), unit(random), 0.1f * unit(random));
+            velocities[vehicle] = velocities[vehicle].cwiseMax(-2).cwiseMin(2);
+            states[vehicle].pose.position += velocities[vehicle];
+        }
+
+        ClockFactory::get()->step();
+        monitor_seconds += seconds([&]() { monitor.update(); });
+
+        SafetyMonitor::Event event;
+        while (monitor.popEvent(event)) {
+            ++events;
+            vector<bool>& vehicle_states = event.type == SafetyMonitor::EventType::GeoFence ? fence_states : separation_states;
+            vehicle_states.at(event.vehicle) = event.is_violation;
+        }
+
+        bruteForceStates(fences, states, true, expected_fences, expected_separations);
+        for (int vehicle = 0; vehicle < vehicle_count; ++vehicle) {
+            check(fence_states[vehicle] == expected_fences[vehicle], Utils::stringf("step %d vehicle %d fence state", step, vehicle));
+            check(separation_states[vehicle] == expected_separations[vehicle], Utils::stringf("step %d vehicle %d separation state", step, vehicle));
+            fence_violations += expected_fences[vehicle];
+            separation_violations += expected_separations[vehicle];
+        }
+    }
+    check(monitor.getDroppedEventCount() == 0, "no events dropped");
+
+    //the brute force check without bounding boxes is what every step costs without an index
+    const int brute_force_steps = 3;
+    const double brute_force_seconds = seconds([&]() {
+        for (int step = 0; step < brute_force_steps; ++step)
+            bruteForceStates(fences, states, false, expected_fences, expected_separations);
+    });
+
+    std::printf("point queries: %d against the even-odd test over all edges\n", points);
+    std::printf("%d vehicles, %d fences of %d vertices, %d steps: %llu events, %d fence and %d separation violations checked\n",
+                vehicle_count, static_cast<int>(fences.size()), kVertices, steps, static_cast<unsigned long long>(events),
+                fence_violations, separation_violations);
+    std::printf("per step: monitor %.0f us, brute force %.1f ms\n", monitor_seconds / steps * 1E6, brute_force_seconds / brute_force_steps * 1E3);
+    std::printf("failures=%d\n", failures);
+    return failures == 0 ? 0 : 1;
+}
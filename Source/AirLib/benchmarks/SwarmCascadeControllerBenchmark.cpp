@@ -0,0 +1,211 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+// Checks that SwarmCascadeController gives exactly the motor outputs of one CascadeController per vehicle and
+// measures both. Every vehicle exists twice on the same kinematics, once with its own controller and once in the
+// swarm, and both get the same goals, mode switches, gain changes, removals and additions. Some vehicles skip
+// ticks, the swarm is then run at the end of the tick like SimpleFlightApi::completeActuation does.
+//
+// Build from Source/AirLib/include:
+//   g++ -std=c++17 -O2 -I. -I/usr/include/eigen3 ../benchmarks/SwarmCascadeControllerBenchmark.cpp -o swarm_benchmark
+// Run with [vehicles] [ticks] [timing_only], exits with 1 on any mismatch.
+
+#include "common/Common.hpp"
+#include "vehicles/multirotor/firmwares/simple_flight/firmware/Firmware.hpp"
+#include "vehicles/multirotor/firmwares/simple_flight/AirSimSimpleFlightEstimator.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+using namespace msr::airlib;
+using namespace simple_flight;
+
+namespace
+{
+    uint64_t millis_now = 0;
+
+    class Board : public IBoard
+    {
+    public:
+        float outputs[4] = {};
+
+        virtual uint64_t micros() const override
+        {
+            return millis_now * 1000;
+        }
+        virtual uint64_t millis() const override
+        {
+            return millis_now;
+        }
+        virtual float readChannel(uint16_t index) const override
+        {
+            unused(index);
+            return 0;
+        }
+        virtual bool isRcConnected() const override
+        {
+            return false;
+        }
+        virtual float getAvgMotorOutput() const override
+        {
+            return (outputs[0] + outputs[1] + outputs[2] + outputs[3]) / 4;
+        }
+        virtual void writeOutput(uint16_t index, float value) override
+        {
+            outputs[index] = value;
+        }
+        virtual void setLed(uint8_t index, int32_t color) override
+        {
+            unused(index);
+            unused(color);
+        }
+        virtual void readAccel(float accel[3]) const override
+        {
+            accel[0] = accel[1] = 0;
+            accel[2] = -9.8f;
+        }
+        virtual void readGyro(float gyro[3]) const override
+        {
+            gyro[0] = gyro[1] = gyro[2] = 0;
+        }
+    };
+
+    class CommLink : public ICommLink
+    {
+    public:
+        virtual void log(const std::string& message, int32_t log_level) override
+        {
+            unused(message);
+            unused(log_level);
+        }
+    };
+
+    struct Vehicle
+    {
+        Params params;
+        Board board;
+        CommLink comm_link;
+        AirSimSimpleFlightEstimator estimator;
+        std::unique_ptr<Firmware> firmware;
+
+        Vehicle(const Kinematics::State* kinematics, const Environment* environment, SwarmCascadeController* swarm, bool bumpless_transfer)
+        {
+            params.rc.allow_api_always = true;
+            params.default_vehicle_state = VehicleStateType::Armed;
+            params.bumpless_transfer = bumpless_transfer;
+            estimator.setGroundTruthKinematics(kinematics, environment);
+            firmware.reset(new Firmware(&params, &board, &comm_link, &estimator, swarm));
+
+            std::string message;
+            firmware->reset();
+            firmware->offboardApi().requestApiControl(message);
+            firmware->offboardApi().arm(message);
+        }
+    };
+}
+
+int main(int argc, char** argv)
+{
+    const int vehicle_count = argc > 1 ? std::atoi(argv[1]) : 64;
+    const int ticks = argc > 2 ? std::atoi(argv[2]) : 3000;
+    const bool timing_only = argc > 3;
+
+    std::vector<Kinematics::State> kinematics(vehicle_count, Kinematics::State::zero());
+    Environment environment(Environment::State(Vector3r::Zero(), msr::airlib::GeoPoint(47.6, -122.1, 10)));
+    SwarmCascadeController swarm(&AirSimSimpleFlightCommon::transformToBodyFrame);
+
+    //single[i] and swarmed[i] fly on kinematics[kinematics_index[i]]
+    std::vector<std::unique_ptr<Vehicle>> single, swarmed;
+    std::vector<int> kinematics_index;
+    for (int i = 0; i < vehicle_count; ++i) {
+        single.emplace_back(new Vehicle(&kinematics[i], &environment, nullptr, i % 2 != 0));
+        swarmed.emplace_back(new Vehicle(&kinematics[i], &environment, &swarm, i % 2 != 0));
+        kinematics_index.push_back(i);
+    }
+
+    const GoalMode modes[] = { GoalMode::getStandardAngleMode(), GoalMode::getVelocityMode(), GoalMode::getPositionMode(),
+                               GoalMode::getAllRateMode(), GoalMode::getVelocityXYPosZMode() };
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> uniform(-1, 1);
+    std::string message;
+    long mismatches = 0;
+    double single_seconds = 0, swarm_seconds = 0;
+
+    for (int tick = 0; tick < ticks; ++tick) {
+        millis_now += 3;
+
+        for (size_t i = 0; i < single.size(); ++i) {
+            Kinematics::State& state = kinematics[kinematics_index[i]];
+            state.pose.position += Vector3r(uniform(random), uniform(random), uniform(random)) * 0.05f;
+            state.twist.linear = Vector3r(uniform(random), uniform(random), uniform(random));
+            state.twist.angular = Vector3r(uniform(random), uniform(random), uniform(random)) * 0.3f;
+            state.pose.orientation = VectorMath::toQuaternion(uniform(random) * 0.3f, uniform(random) * 0.3f, uniform(random) * 3.1f);
+
+            const int phase = tick + static_cast<int>(i) * 37;
+            if (phase % 400 == 0) {
+                const GoalMode& mode = modes[(phase / 400 + i) % 5];
+                Axis4r goal(uniform(random), uniform(random), uniform(random), 0.5f + 0.3f * uniform(random));
+                single[i]->firmware->offboardApi().setGoalAndMode(&goal, &mode, message);
+                swarmed[i]->firmware->offboardApi().setGoalAndMode(&goal, &mode, message);
+            }
+            else if (tick % 50 == 0) {
+                //refresh the goal so that it does not time out
+                Axis4r goal(uniform(random), uniform(random), uniform(random), 0.5f);
+                single[i]->firmware->offboardApi().setGoalAndMode(&goal, nullptr, message);
+                swarmed[i]->firmware->offboardApi().setGoalAndMode(&goal, nullptr, message);
+            }
+            if ((tick + i) % 997 == 0)
+                single[i]->params.gains_changed = swarmed[i]->params.gains_changed = true;
+        }
+
+        //vehicles leave and join halfway
+        if (tick == ticks / 2 && vehicle_count > 4) {
+            single.erase(single.begin() + 3);
+            swarmed.erase(swarmed.begin() + 3);
+            kinematics_index.erase(kinematics_index.begin() + 3);
+        }
+        if (tick == ticks / 2 + 100 && vehicle_count > 4) {
+            single.emplace_back(new Vehicle(&kinematics[3], &environment, nullptr, true));
+            swarmed.emplace_back(new Vehicle(&kinematics[3], &environment, &swarm, true));
+            kinematics_index.push_back(3);
+        }
+
+        //every 7th tick one vehicle is not updated, the others must still get their output in this tick
+        const size_t skipped = timing_only || tick % 7 != 0 ? single.size() : (tick / 7) % single.size();
+
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < single.size(); ++i) {
+            if (i != skipped)
+                single[i]->firmware->update();
+        }
+        const auto single_end = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < swarmed.size(); ++i) {
+            if (i != skipped)
+                swarmed[i]->firmware->update();
+        }
+        swarm.update();
+        const auto swarm_end = std::chrono::steady_clock::now();
+        single_seconds += std::chrono::duration<double>(single_end - start).count();
+        swarm_seconds += std::chrono::duration<double>(swarm_end - single_end).count();
+
+        if (timing_only)
+            continue;
+        for (size_t i = 0; i < single.size(); ++i) {
+            const float* expected = single[i]->board.outputs;
+            const float* actual = swarmed[i]->board.outputs;
+            if (std::memcmp(expected, actual, sizeof(single[i]->board.outputs)) != 0) {
+                if (mismatches < 5)
+                    std::printf("tick %d vehicle %d: %.9g %.9g %.9g %.9g vs %.9g %.9g %.9g %.9g\n", tick, static_cast<int>(i),
+                                expected[0], expected[1], expected[2], expected[3], actual[0], actual[1], actual[2], actual[3]);
+                ++mismatches;
+            }
+        }
+    }
+
+    const double single_us = single_seconds / ticks / single.size() * 1E6;
+    const double swarm_us = swarm_seconds / ticks / swarmed.size() * 1E6;
+    std::printf("vehicles=%d ticks=%d mismatches=%ld\n", vehicle_count, ticks, mismatches);
+    std::printf("per vehicle controllers: %.2f us per vehicle tick, swarm: %.2f us per vehicle tick\n", single_us, swarm_us);
+    return mismatches == 0 ? 0 : 1;
+}
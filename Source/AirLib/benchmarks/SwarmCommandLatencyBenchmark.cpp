@@ -0,0 +1,393 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+// Command latency of the swarm commands against one call per vehicle at 10, 50 and 100 vehicles. The vehicles are
+// stubs that fly exactly what they are commanded, a world thread updates them every 3 ms like the physics loop, and
+// every per vehicle call runs on its own thread like an RPC worker. Latency is the wall time from issuing the calls
+// until the last vehicle received its first command, spread is how many physics steps lie between the first and the
+// last vehicle starting. rpclib serialization is not included.
+//
+// Build from Source/AirLib/include:
+//   g++ -std=c++17 -O2 -I. -I/usr/include/eigen3 ../benchmarks/SwarmCommandLatencyBenchmark.cpp
+//       ../src/vehicles/multirotor/api/MultirotorApiBase.cpp ../src/safety/*.cpp -o swarm_latency_benchmark -pthread
+// Exits with 1 when a swarm command does not start all its vehicles in the same physics step or does not complete.
+
+#include "common/Common.hpp"
+#include "common/ClockFactory.hpp"
+#include "common/SteppableClock.hpp"
+#include "vehicles/multirotor/api/MultirotorApiBase.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+using namespace msr::airlib;
+
+namespace
+{
+    int64_t wallNanos()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    //moveOnPath logs every plan it makes, only warnings are printed
+    class WarningLogger : public Utils::Logger
+    {
+    public:
+        virtual void log(int level, const std::string& message) override
+        {
+            if (level <= Utils::kLogLevelWarn)
+                Utils::Logger::log(level, message);
+        }
+    };
+
+    //flies every command exactly, remembers when and in which physics step the first command of a run came in
+    class StubMultirotorApi : public MultirotorApiBase
+    {
+    public:
+        StubMultirotorApi(const Vector3r& position)
+        {
+            state_ = Kinematics::State::zero();
+            state_.pose.position = position;
+        }
+
+        //every run starts from a hover
+        void startRun()
+        {
+            first_command_nanos_ = 0;
+            first_command_step_ = 0;
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            state_.twist.linear = Vector3r::Zero();
+        }
+        int64_t getFirstCommandNanos() const
+        {
+            return first_command_nanos_;
+        }
+        uint64_t getFirstCommandStep() const
+        {
+            return first_command_step_;
+        }
+
+        //called by the world thread after update
+        void integrate(TTimeDelta dt)
+        {
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            state_.pose.position += state_.twist.linear * static_cast<float>(dt);
+        }
+
+        virtual void enableApiControl(bool is_enabled) override
+        {
+            unused(is_enabled);
+        }
+        virtual bool isApiControlEnabled() const override
+        {
+            return true;
+        }
+        virtual bool armDisarm(bool arm) override
+        {
+            unused(arm);
+            return true;
+        }
+        virtual GeoPoint getHomeGeoPoint() const override
+        {
+            return GeoPoint();
+        }
+
+    protected:
+        virtual void commandMotorPWMs(float front_right_pwm, float rear_left_pwm, float front_left_pwm, float rear_right_pwm) override
+        {
+            unused(front_right_pwm);
+            unused(rear_left_pwm);
+            unused(front_left_pwm);
+            unused(rear_right_pwm);
+            recordCommand();
+        }
+        virtual void commandRollPitchYawrateThrottle(float roll, float pitch, float yaw_rate, float throttle) override
+        {
+            unused(roll);
+            unused(pitch);
+            unused(yaw_rate);
+            unused(throttle);
+            recordCommand();
+        }
+        virtual void commandRollPitchYawZ(float roll, float pitch, float yaw, float z) override
+        {
+            unused(roll);
+            unused(pitch);
+            unused(yaw);
+            unused(z);
+            recordCommand();
+        }
+        virtual void commandRollPitchYawThrottle(float roll, float pitch, float yaw, float throttle) override
+        {
+            unused(roll);
+            unused(pitch);
+            unused(yaw);
+            unused(throttle);
+            recordCommand();
+        }
+        virtual void commandRollPitchYawrateZ(float roll, float pitch, float yaw_rate, float z) override
+        {
+            unused(roll);
+            unused(pitch);
+            unused(yaw_rate);
+            unused(z);
+            recordCommand();
+        }
+        virtual void commandAngleRatesZ(float roll_rate, float pitch_rate, float yaw_rate, float z) override
+        {
+            unused(roll_rate);
+            unused(pitch_rate);
+            unused(yaw_rate);
+            unused(z);
+            recordCommand();
+        }
+        virtual void commandAngleRatesThrottle(float roll_rate, float pitch_rate, float yaw_rate, float throttle) override
+        {
+            unused(roll_rate);
+            unused(pitch_rate);
+            unused(yaw_rate);
+            unused(throttle);
+            recordCommand();
+        }
+        virtual void commandVelocity(float vx, float vy, float vz, const YawMode& yaw_mode) override
+        {
+            unused(yaw_mode);
+            recordCommand();
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            state_.twist.linear = Vector3r(vx, vy, vz);
+        }
+        virtual void commandVelocityZ(float vx, float vy, float z, const YawMode& yaw_mode) override
+        {
+            unused(yaw_mode);
+            recordCommand();
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            state_.twist.linear = Vector3r(vx, vy, 0);
+            state_.pose.position.z() = z;
+        }
+        virtual void commandPosition(float x, float y, float z, const YawMode& yaw_mode) override
+        {
+            unused(yaw_mode);
+            recordCommand();
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            state_.twist.linear = Vector3r::Zero();
+            state_.pose.position = Vector3r(x, y, z);
+        }
+        virtual void setControllerGains(uint8_t controller_type, const vector<float>& kp, const vector<float>& ki, const vector<float>& kd) override
+        {
+            unused(controller_type);
+            unused(kp);
+            unused(ki);
+            unused(kd);
+        }
+
+        virtual Kinematics::State getKinematicsEstimated() const override
+        {
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            return state_;
+        }
+        virtual LandedState getLandedState() const override
+        {
+            return LandedState::Flying;
+        }
+        virtual GeoPoint getGpsLocation() const override
+        {
+            return GeoPoint();
+        }
+        virtual const MultirotorApiParams& getMultirotorApiParams() const override
+        {
+            return api_params_;
+        }
+        virtual float getCommandPeriod() const override
+        {
+            return 1.0f / 50;
+        }
+        virtual float getTakeoffZ() const override
+        {
+            return -3;
+        }
+        virtual float getDistanceAccuracy() const override
+        {
+            return 0.5f;
+        }
+
+    private:
+        void recordCommand()
+        {
+            int64_t expected = 0;
+            if (first_command_nanos_.compare_exchange_strong(expected, wallNanos()))
+                first_command_step_ = ClockFactory::get()->getStepCount();
+        }
+
+        mutable std::mutex state_mutex_;
+        Kinematics::State state_;
+        MultirotorApiParams api_params_;
+        std::atomic<int64_t> first_command_nanos_{ 0 };
+        std::atomic<uint64_t> first_command_step_{ 0 };
+    };
+
+    struct RunResult
+    {
+        double latency_ms = 0;
+        uint64_t spread_steps = 0;
+        bool all_started = true;
+        bool all_completed = true;
+    };
+
+    RunResult collect(const vector<std::unique_ptr<StubMultirotorApi>>& vehicles, int64_t start_nanos)
+    {
+        RunResult result;
+        int64_t last_nanos = start_nanos;
+        uint64_t first_step = std::numeric_limits<uint64_t>::max(), last_step = 0;
+        for (const auto& vehicle : vehicles) {
+            if (vehicle->getFirstCommandNanos() == 0) {
+                result.all_started = false;
+                continue;
+            }
+            last_nanos = std::max(last_nanos, vehicle->getFirstCommandNanos());
+            first_step = std::min(first_step, vehicle->getFirstCommandStep());
+            last_step = std::max(last_step, vehicle->getFirstCommandStep());
+        }
+        result.latency_ms = (last_nanos - start_nanos) * 1E-6;
+        result.spread_steps = last_step >= first_step ? last_step - first_step : 0;
+        return result;
+    }
+
+    //one thread per vehicle like the RPC workers, all released at once after they are running
+    RunResult runPerVehicle(const vector<std::unique_ptr<StubMultirotorApi>>& vehicles,
+                            const std::function<bool(StubMultirotorApi&, size_t)>& command)
+    {
+        std::mutex mutex;
+        std::condition_variable release;
+        bool is_released = false;
+        std::atomic<bool> all_completed{ true };
+        vector<std::thread> workers;
+        for (size_t i = 0; i < vehicles.size(); ++i) {
+            vehicles[i]->startRun();
+            workers.emplace_back([&, i]() {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    release.wait(lock, [&]() { return is_released; });
+                }
+                if (!command(*vehicles[i], i))
+                    all_completed = false;
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        const int64_t start_nanos = wallNanos();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            is_released = true;
+        }
+        release.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+
+        RunResult result = collect(vehicles, start_nanos);
+        result.all_completed = all_completed;
+        return result;
+    }
+
+    RunResult runSwarm(const vector<std::unique_ptr<StubMultirotorApi>>& vehicles, const vector<SwarmCommand>& commands)
+    {
+        vector<MultirotorApiBase*> apis;
+        for (const auto& vehicle : vehicles) {
+            vehicle->startRun();
+            apis.push_back(vehicle.get());
+        }
+
+        const int64_t start_nanos = wallNanos();
+        const vector<bool> completed = MultirotorApiBase::moveSwarm(apis, commands, SwarmWaitMode::WaitAll);
+
+        RunResult result = collect(vehicles, start_nanos);
+        for (bool is_complete : completed)
+            result.all_completed = result.all_completed && is_complete;
+        return result;
+    }
+
+    //moves of 1 m at 2 m/s, alternately away from and back to the start
+    vector<Vector3r> getTargets(const vector<std::unique_ptr<StubMultirotorApi>>& vehicles, int run)
+    {
+        vector<Vector3r> targets;
+        for (size_t i = 0; i < vehicles.size(); ++i)
+            targets.push_back(Vector3r(float(i) * 5 + (run % 2 == 0 ? 1 : 0), 0, -10));
+        return targets;
+    }
+}
+
+int main()
+{
+    const TTimeDelta step = 0.003;
+    ClockFactory::get(std::make_shared<SteppableClock>(step));
+    WarningLogger logger;
+    Utils::getSetLogger(&logger);
+
+    int failures = 0;
+    std::printf("%8s | %-22s %12s %12s %10s\n", "vehicles", "command", "latency ms", "spread steps", "completed");
+    for (const int count : { 10, 50, 100 }) {
+        vector<std::unique_ptr<StubMultirotorApi>> vehicles;
+        for (int i = 0; i < count; ++i) {
+            vehicles.emplace_back(new StubMultirotorApi(Vector3r(float(i) * 5, 0, -10)));
+            vehicles.back()->reset();
+        }
+
+        //steps like the physics loop at 333 Hz, sleeping between steps so that the callers get the core
+        std::mutex world_mutex;
+        std::atomic<bool> is_running{ true };
+        std::thread world_thread([&]() {
+            auto next = std::chrono::steady_clock::now();
+            while (is_running) {
+                {
+                    std::lock_guard<std::mutex> lock(world_mutex);
+                    ClockFactory::get()->step();
+                    for (const auto& vehicle : vehicles) {
+                        vehicle->update();
+                        vehicle->integrate(step);
+                    }
+                }
+                next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(step));
+                std::this_thread::sleep_until(next);
+            }
+        });
+
+        auto report = [&](const char* name, const RunResult& result, bool is_swarm) {
+            std::printf("%8d | %-22s %12.2f %12llu %10s\n", count, name, result.latency_ms, static_cast<unsigned long long>(result.spread_steps),
+                        result.all_completed ? "all" : "not all");
+            if (!result.all_started) {
+                std::printf("FAILED: %s did not start every vehicle\n", name);
+                ++failures;
+            }
+            if (is_swarm && (result.spread_steps != 0 || !result.all_completed)) {
+                std::printf("FAILED: %s at %d vehicles\n", name, count);
+                ++failures;
+            }
+        };
+
+        const float duration = 0.2f;
+        report("moveByVelocity", runPerVehicle(vehicles, [&](StubMultirotorApi& api, size_t index) {
+                   unused(index);
+                   return api.moveByVelocity(1, 0, 0, duration, DrivetrainType::MaxDegreeOfFreedom, YawMode::Zero());
+               }),
+               false);
+        report("moveSwarmByVelocity", runSwarm(vehicles, { SwarmCommand::byVelocity(Vector3r(-1, 0, 0), duration, DrivetrainType::MaxDegreeOfFreedom, YawMode::Zero()) }), true);
+
+        const vector<Vector3r> targets = getTargets(vehicles, 0);
+        report("moveToPosition", runPerVehicle(vehicles, [&](StubMultirotorApi& api, size_t index) {
+                   const Vector3r& target = targets[index];
+                   return api.moveToPosition(target.x(), target.y(), target.z(), 2, 30, DrivetrainType::MaxDegreeOfFreedom, YawMode::Zero(), -1, 1);
+               }),
+               false);
+        vector<SwarmCommand> commands;
+        for (const Vector3r& target : getTargets(vehicles, 1))
+            commands.push_back(SwarmCommand::onPath({ target }, 2, 30, DrivetrainType::MaxDegreeOfFreedom, YawMode::Zero()));
+        report("moveSwarmToPosition", runSwarm(vehicles, commands), true);
+
+        is_running = false;
+        world_thread.join();
+    }
+
+    std::printf("failures=%d\n", failures);
+    return failures == 0 ? 0 : 1;
+}
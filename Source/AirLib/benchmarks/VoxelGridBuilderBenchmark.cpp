@@ -0,0 +1,167 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+// VoxelGridBuilder against the per cell loop simCreateVoxelGrid used before, on a synthetic scene of a ground plane
+// and 60 random boxes. The overlap function stands in for OverlapBlockingTestByChannel, a box test plus a fixed amount
+// of work for the cost of a physics query, and counts its calls. The per cell loop fills a full grid like the old
+// implementation did, the builder streams binvox once serially and once on a thread per core. The streamed file is
+// decoded and compared cell by cell with the per cell grid, and the parallel file with the serial one.
+//
+// Build from Source/AirLib/include:
+//   g++ -std=c++17 -O2 -I. -I/usr/include/eigen3 ../benchmarks/VoxelGridBuilderBenchmark.cpp -o voxel_benchmark -pthread
+// Run with [x_size y_size z_size resolution] in meters, default 100 100 30 0.25. Exits with 1 on any mismatch.
+
+#include "common/Common.hpp"
+#include "common/VoxelGridBuilder.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <thread>
+
+using namespace msr::airlib;
+
+namespace
+{
+    struct Box
+    {
+        Vector3r min, max;
+    };
+
+    std::vector<Box> boxes;
+    std::atomic<uint64_t> overlap_calls{ 0 };
+
+    bool overlap(const Vector3r& center, const Vector3r& half_extent)
+    {
+        ++overlap_calls;
+
+        //stands in for the cost of a physics overlap query
+        volatile float sink = 0;
+        for (int i = 0; i < 200; ++i)
+            sink = sink + i * 0.5f;
+
+        const Vector3r min = center - half_extent, max = center + half_extent;
+        for (const Box& box : boxes) {
+            if ((min.array() <= box.max.array()).all() && (max.array() >= box.min.array()).all())
+                return true;
+        }
+        return false;
+    }
+
+    template <typename Function>
+    double seconds(Function function)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    //decodes the run length encoded data of a binvox file and compares it with the grid
+    bool matchesGrid(const std::string& binvox, const std::vector<bool>& grid)
+    {
+        size_t pos = binvox.find("data\n");
+        if (pos == std::string::npos)
+            return false;
+        size_t index = 0;
+        for (pos += 5; pos + 1 < binvox.size(); pos += 2) {
+            const bool value = binvox[pos] != 0;
+            const uint8_t count = static_cast<uint8_t>(binvox[pos + 1]);
+            if (count == 0 || index + count > grid.size())
+                return false;
+            for (uint8_t i = 0; i < count; ++i, ++index) {
+                if (grid[index] != value)
+                    return false;
+            }
+        }
+        return pos == binvox.size() && index == grid.size();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const float x_size = argc > 4 ? static_cast<float>(std::atof(argv[1])) : 100;
+    const float y_size = argc > 4 ? static_cast<float>(std::atof(argv[2])) : 100;
+    const float z_size = argc > 4 ? static_cast<float>(std::atof(argv[3])) : 30;
+    const float resolution = argc > 4 ? static_cast<float>(std::atof(argv[4])) : 0.25f;
+    const int ncells_x = static_cast<int>(x_size / resolution);
+    const int ncells_y = static_cast<int>(y_size / resolution);
+    const int ncells_z = static_cast<int>(z_size / resolution);
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> position(-0.45f, 0.45f), extent(0.5f, 4);
+    for (int i = 0; i < 60; ++i) {
+        const Vector3r center(position(random) * x_size, position(random) * y_size, -z_size / 3 + extent(random));
+        const Vector3r half_extent(extent(random), extent(random), extent(random));
+        boxes.push_back({ center - half_extent, center + half_extent });
+    }
+    boxes.push_back({ Vector3r(-x_size, -y_size, -z_size / 3 - 3), Vector3r(x_size, y_size, -z_size / 3 - 2) });
+
+    //the loop and cell layout of the original WorldSimApi::createVoxelGrid
+    std::vector<bool> grid(static_cast<size_t>(ncells_x) * ncells_y * ncells_z);
+    const Vector3r cell_half_extent = Vector3r::Constant(resolution / 2);
+    const double per_cell_seconds = seconds([&]() {
+        for (int i = 0; i < ncells_x; i++) {
+            for (int k = 0; k < ncells_z; k++) {
+                for (int j = 0; j < ncells_y; j++) {
+                    const Vector3r center((i - ncells_x / 2) * resolution, (j - ncells_y / 2) * resolution, (k - ncells_z / 2) * resolution);
+                    grid[i + ncells_x * (k + static_cast<size_t>(ncells_z) * j)] = overlap(center, cell_half_extent);
+                }
+            }
+        }
+    });
+    const uint64_t per_cell_calls = overlap_calls.exchange(0);
+    size_t occupied = 0;
+    for (bool cell : grid)
+        occupied += cell;
+
+    VoxelGridBuilder builder(ncells_x, ncells_y, ncells_z, resolution);
+    float progress = 0;
+    builder.setProgress([&progress](float fraction, uint64_t overlap_tests) {
+        unused(overlap_tests);
+        progress = fraction;
+    });
+
+    std::ostringstream serial_output;
+    VoxelGridBuilder::Stats stats;
+    const double serial_seconds = seconds([&]() { stats = builder.writeBinvox(serial_output, overlap, x_size, y_size, z_size); });
+    const uint64_t serial_calls = overlap_calls.exchange(0);
+
+    const unsigned thread_count = std::max(1u, std::thread::hardware_concurrency());
+    builder.setParallel([thread_count](int count, const std::function<void(int)>& body) {
+        std::atomic<int> next{ 0 };
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < thread_count; ++t) {
+            threads.emplace_back([&]() {
+                for (int i = next++; i < count; i = next++)
+                    body(i);
+            });
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+    });
+    std::ostringstream parallel_output;
+    const double parallel_seconds = seconds([&]() { builder.writeBinvox(parallel_output, overlap, x_size, y_size, z_size); });
+    const uint64_t parallel_calls = overlap_calls.exchange(0);
+
+    int failures = 0;
+    auto check = [&failures](bool condition, const char* what) {
+        if (!condition) {
+            std::printf("FAILED: %s\n", what);
+            ++failures;
+        }
+    };
+    check(matchesGrid(serial_output.str(), grid), "streamed grid matches the per cell grid");
+    check(parallel_output.str() == serial_output.str(), "parallel output matches the serial output");
+    check(stats.occupied_cells == occupied, "occupied cell count");
+    check(stats.overlap_tests == serial_calls, "overlap test count");
+    check(progress == 1, "progress reaches 1");
+
+    std::printf("grid %dx%dx%d (%zu cells, %zu occupied)\n", ncells_x, ncells_y, ncells_z, grid.size(), occupied);
+    std::printf("%-22s %12s %10s\n", "", "queries", "seconds");
+    std::printf("%-22s %12llu %10.2f\n", "per cell loop", static_cast<unsigned long long>(per_cell_calls), per_cell_seconds);
+    std::printf("%-22s %12llu %10.2f\n", "hierarchical", static_cast<unsigned long long>(serial_calls), serial_seconds);
+    std::printf("%-22s %12llu %10.2f  (%u threads)\n", "hierarchical parallel", static_cast<unsigned long long>(parallel_calls), parallel_seconds, thread_count);
+    std::printf("failures=%d\n", failures);
+    return failures == 0 ? 0 : 1;
+}
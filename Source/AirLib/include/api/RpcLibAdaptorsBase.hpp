@@ -402,6 +402,68 @@ namespace airlib_rpclib
             }
         };
 
+        struct SafetyEvent
+        {
+            uint64_t step = 0;
+            std::string type;
+            bool is_violation = false;
+            std::string vehicle_name;
+            int fence_id = -1;
+            std::string other_vehicle_name;
+            Vector3r position;
+            float distance = 0;
+
+            MSGPACK_DEFINE_MAP(step, type, is_violation, vehicle_name, fence_id, other_vehicle_name, position, distance);
+
+            SafetyEvent()
+            {
+            }
+
+            SafetyEvent(const msr::airlib::SafetyEvent& e)
+            {
+                step = e.step;
+                type = e.type;
+                is_violation = e.is_violation;
+                vehicle_name = e.vehicle_name;
+                fence_id = e.fence_id;
+                other_vehicle_name = e.other_vehicle_name;
+                position = e.position;
+                distance = e.distance;
+            }
+
+            msr::airlib::SafetyEvent to() const
+            {
+                msr::airlib::SafetyEvent e;
+                e.step = step;
+                e.type = type;
+                e.is_violation = is_violation;
+                e.vehicle_name = vehicle_name;
+                e.fence_id = fence_id;
+                e.other_vehicle_name = other_vehicle_name;
+                e.position = position.to();
+                e.distance = distance;
+
+                return e;
+            }
+
+            static std::vector<SafetyEvent> from(const std::vector<msr::airlib::SafetyEvent>& events)
+            {
+                std::vector<SafetyEvent> events_adaptor;
+                for (const auto& item : events)
+                    events_adaptor.push_back(SafetyEvent(item));
+
+                return events_adaptor;
+            }
+            static std::vector<msr::airlib::SafetyEvent> to(const std::vector<SafetyEvent>& events_adaptor)
+            {
+                std::vector<msr::airlib::SafetyEvent> events;
+                for (const auto& item : events_adaptor)
+                    events.push_back(item.to());
+
+                return events;
+            }
+        };
+
         struct CameraInfo
         {
             Pose pose;
@@ -175,6 +175,16 @@ namespace airlib
         void simSetCameraFov(const std::string& camera_name, float fov_degrees, const std::string& vehicle_name = "");
 
         bool simCreateVoxelGrid(const Vector3r& position, const int& x_size, const int& y_size, const int& z_size, const float& res, const std::string& output_file);
+        bool simBuildOccupancyMap(const Vector3r& center, float size, float resolution);
+        int simGetOccupancy(const Vector3r& point);
+        Vector3r simCastRayOccupancyMap(const Vector3r& start, const Vector3r& end);
+        std::vector<float> simGetOccupancyMapRegion(const Vector3r& min, const Vector3r& max);
+        bool simSaveOccupancyMap(const std::string& file_path);
+        bool simLoadOccupancyMap(const std::string& file_path);
+        int simAddGeoFence(const std::vector<float>& vertices, float min_z, float max_z, bool keep_out);
+        bool simRemoveGeoFence(int fence_id);
+        bool simSetSafetySeparation(float distance);
+        std::vector<SafetyEvent> simGetSafetyEvents();
         msr::airlib::Kinematics::State simGetGroundTruthKinematics(const std::string& vehicle_name = "") const;
         void simSetKinematics(const Kinematics::State& state, bool ignore_collision, const std::string& vehicle_name = "");
         msr::airlib::Kinematics::State simGetPhysicsRawKinematics(const std::string& vehicle_name = "") const;
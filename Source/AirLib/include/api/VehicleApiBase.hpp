@@ -82,6 +82,10 @@ Some methods may not be applicable to specific vehicle in which case an exceptio
         {
             throw VehicleCommandNotImplementedException("getActuatorCount API is not supported for this vehicle");
         }
+        //called once per physics step before getActuation, for controllers whose output can be finished after update() returned
+        virtual void completeActuation()
+        {
+        }
 
         virtual void getStatusMessages(std::vector<std::string>& messages)
         {
@@ -101,6 +101,20 @@ namespace airlib
 
         virtual bool createVoxelGrid(const Vector3r& position, const int& x_size, const int& y_size, const int& z_size, const float& res, const std::string& output_file) = 0;
 
+        // Occupancy map APIs, positions are NED in meters
+        virtual bool buildOccupancyMap(const Vector3r& center, float size, float resolution) = 0;
+        virtual int getOccupancy(const Vector3r& point) const = 0; // -1 outside the map, 0 free, 1 occupied
+        virtual Vector3r castRayOccupancyMap(const Vector3r& start, const Vector3r& end) const = 0; // NaN if nothing was hit
+        virtual std::vector<float> getOccupancyMapRegion(const Vector3r& min, const Vector3r& max) const = 0; // x, y, z, size per occupied cell
+        virtual bool saveOccupancyMap(const std::string& file_path) const = 0;
+        virtual bool loadOccupancyMap(const std::string& file_path) = 0;
+
+        // Safety monitor APIs, checked every physics step. Fences are prisms over an NED x-y polygon given as x0, y0, x1, y1, ...
+        virtual int addGeoFence(const std::vector<float>& vertices, float min_z, float max_z, bool keep_out) = 0; // fence id, -1 without a physics loop
+        virtual bool removeGeoFence(int fence_id) = 0;
+        virtual bool setSafetySeparation(float distance) = 0; // 0 turns the check off
+        virtual std::vector<SafetyEvent> getSafetyEvents() = 0; // changes since the last call
+
         // Recording APIs
         virtual void startRecording() = 0;
         virtual void stopRecording() = 0;
@@ -101,8 +101,17 @@ namespace msr
                 float record_interval = 0.05f;
                 std::string folder = "";
                 bool enabled = false;
+                int writer_threads = 2; // threads encoding and writing captures, 0 writes on the capture thread
+                int queue_size = 32; // captures waiting for a writer before backpressure kicks in
+                bool drop_when_full = false; // drop captures on a full queue instead of stalling the capture thread
+                std::string format = "Files"; // "Files": airsim_rec.txt plus one file per image, "Container": single chunked .asrec file
+                bool compress_chunks = true; // compress container chunks
+                float max_file_size_mb = 0; // roll over to a new container file past this size, 0 for a single file
+                float sensor_buffer_mb = 64; // sensor samples waiting to be written, samples beyond this are dropped
+                float sensor_overhead_budget_us = 20; // average time a recorded sample may cost the sensor thread
 
                 std::map<std::string, std::vector<ImageCaptureBase::ImageRequest>> requests;
+                std::map<std::string, std::vector<std::string>> sensors; // per vehicle, names of the sensors to record, "*" for all
 
                 RecordingSetting()
                 {
@@ -423,6 +432,8 @@ namespace msr
                 bool enable_trace = false;
                 bool enable_collisions = true;
                 bool is_fpv_vehicle = false;
+                //simple_flight only, run the cascade controller in the engine shared by all such vehicles
+                bool swarm_controller = false;
 
                 //nan means use player start
                 Vector3r position = VectorMath::nanVector(); //in global NED
@@ -516,6 +527,12 @@ namespace msr
 
                 // Used to accept connections from drone over TCP: needed only if use_tcp = true
                 bool lock_step = true;
+                // ArduPilot lock step is off unless LockStep is set explicitly, the default above is the PX4 one
+                bool ardupilot_lock_step = false;
+                // ArduPilot lock step: wait per attempt for the control packet answering a sensor frame, and how
+                // often the frame is resent before the step is counted as a stall
+                int lock_step_timeout_ms = 100;
+                int lock_step_max_resends = 2;
                 bool use_tcp = false;
                 int tcp_port = 4560;
 
@@ -569,6 +586,29 @@ namespace msr
                 bool move_sun = true;
             };
 
+            struct OccupancyMapSetting
+            {
+                bool enabled = false;
+                Vector3r center = Vector3r::Zero(); //NED, meters
+                float size = 256;
+                float resolution = 0.5f;
+                std::string file_path = ""; //loaded instead of building when set and the file exists
+            };
+
+            struct GeoFenceSetting
+            {
+                bool keep_out = true;
+                float min_z = -100; //NED, meters
+                float max_z = 0;
+                std::vector<Vector2r> vertices; //NED x-y polygon
+            };
+
+            struct SafetyMonitorSetting
+            {
+                float separation = 0; //meters between vehicles, 0 turns the check off
+                std::vector<GeoFenceSetting> geofences;
+            };
+
         private: //fields
             float settings_version_actual;
             float settings_version_minimum = 2.0f;
@@ -580,6 +620,8 @@ namespace msr
             std::vector<SubwindowSetting> subwindow_settings;
             RecordingSetting recording_setting;
             TimeOfDaySetting tod_setting;
+            OccupancyMapSetting occupancy_map_setting;
+            SafetyMonitorSetting safety_monitor_setting;
             std::vector<AnnotatorSetting> annotator_settings;
 
             std::vector<std::string> warning_messages;
@@ -879,6 +921,7 @@ namespace msr
             void loadDefaultRecordingSettings()
             {
                 recording_setting.requests.clear();
+                recording_setting.sensors.clear();
                 // Add Scene image for each vehicle
                 for (const auto& vehicle : vehicles) {
                     recording_setting.requests[vehicle.first].push_back(ImageCaptureBase::ImageRequest(
@@ -896,6 +939,29 @@ namespace msr
                     recording_setting.record_interval = recording_json.getFloat("RecordInterval", recording_setting.record_interval);
                     recording_setting.folder = recording_json.getString("Folder", recording_setting.folder);
                     recording_setting.enabled = recording_json.getBool("Enabled", recording_setting.enabled);
+                    recording_setting.writer_threads = recording_json.getInt("WriterThreads", recording_setting.writer_threads);
+                    recording_setting.queue_size = recording_json.getInt("QueueSize", recording_setting.queue_size);
+                    recording_setting.drop_when_full = recording_json.getBool("DropWhenFull", recording_setting.drop_when_full);
+                    recording_setting.format = recording_json.getString("Format", recording_setting.format);
+                    recording_setting.compress_chunks = recording_json.getBool("CompressChunks", recording_setting.compress_chunks);
+                    recording_setting.max_file_size_mb = recording_json.getFloat("MaxFileSizeMB", recording_setting.max_file_size_mb);
+                    recording_setting.sensor_buffer_mb = recording_json.getFloat("SensorBufferMB", recording_setting.sensor_buffer_mb);
+                    recording_setting.sensor_overhead_budget_us = recording_json.getFloat("SensorOverheadBudgetUs", recording_setting.sensor_overhead_budget_us);
+
+                    Settings req_sensors_settings;
+                    if (recording_json.getChild("Sensors", req_sensors_settings)) {
+                        std::string default_vehicle_name = vehicles.begin()->first;
+
+                        for (size_t child_index = 0; child_index < req_sensors_settings.size(); ++child_index) {
+                            Settings req_sensor_settings;
+
+                            if (req_sensors_settings.getChild(child_index, req_sensor_settings)) {
+                                std::string vehicle_name = req_sensor_settings.getString("VehicleName", default_vehicle_name);
+                                std::string sensor_name = req_sensor_settings.getString("SensorName", "*");
+                                recording_setting.sensors[vehicle_name].push_back(sensor_name);
+                            }
+                        }
+                    }
 
                     Settings req_cameras_settings;
                     if (recording_json.getChild("Cameras", req_cameras_settings)) {
@@ -1000,6 +1066,9 @@ namespace msr
                 connection_info.udp_port = settings_json.getInt("UdpPort", connection_info.udp_port);
                 connection_info.use_tcp = settings_json.getBool("UseTcp", connection_info.use_tcp);
                 connection_info.lock_step = settings_json.getBool("LockStep", connection_info.lock_step);
+                connection_info.ardupilot_lock_step = settings_json.hasKey("LockStep") && connection_info.lock_step;
+                connection_info.lock_step_timeout_ms = settings_json.getInt("LockStepTimeoutMs", connection_info.lock_step_timeout_ms);
+                connection_info.lock_step_max_resends = settings_json.getInt("LockStepMaxResends", connection_info.lock_step_max_resends);
                 connection_info.tcp_port = settings_json.getInt("TcpPort", connection_info.tcp_port);
                 connection_info.serial_port = settings_json.getString("SerialPort", connection_info.serial_port);
                 connection_info.baud_rate = settings_json.getInt("SerialBaudRate", connection_info.baud_rate);
@@ -1057,6 +1126,8 @@ namespace msr
                     vehicle_setting->enable_collisions);
                 vehicle_setting->is_fpv_vehicle = settings_json.getBool("IsFpvVehicle",
                     vehicle_setting->is_fpv_vehicle);
+                vehicle_setting->swarm_controller = settings_json.getBool("SwarmController",
+                    vehicle_setting->swarm_controller);
 
                 loadRCSetting(simmode_name, settings_json, vehicle_setting->rc);
 
@@ -1714,6 +1785,43 @@ namespace msr
                         wind = createVectorSetting(child_json, wind);
                     }
                 }
+                { //occupancy map built at startup
+                    Settings child_json;
+                    if (settings_json.getChild("OccupancyMap", child_json)) {
+                        occupancy_map_setting.enabled = child_json.getBool("Enabled", occupancy_map_setting.enabled);
+                        occupancy_map_setting.center = createVectorSetting(child_json, occupancy_map_setting.center);
+                        occupancy_map_setting.size = child_json.getFloat("Size", occupancy_map_setting.size);
+                        occupancy_map_setting.resolution = child_json.getFloat("Resolution", occupancy_map_setting.resolution);
+                        occupancy_map_setting.file_path = child_json.getString("FilePath", occupancy_map_setting.file_path);
+                    }
+                }
+                { //geofences and separation checked every physics step
+                    Settings child_json;
+                    if (settings_json.getChild("SafetyMonitor", child_json)) {
+                        safety_monitor_setting.separation = child_json.getFloat("Separation", safety_monitor_setting.separation);
+                        Settings fences_json;
+                        if (child_json.getChild("GeoFences", fences_json)) {
+                            for (size_t i = 0; i < fences_json.size(); ++i) {
+                                Settings fence_json;
+                                if (!fences_json.getChild(i, fence_json))
+                                    continue;
+                                GeoFenceSetting fence;
+                                fence.keep_out = fence_json.getBool("KeepOut", fence.keep_out);
+                                fence.min_z = fence_json.getFloat("MinZ", fence.min_z);
+                                fence.max_z = fence_json.getFloat("MaxZ", fence.max_z);
+                                Settings vertices_json;
+                                if (fence_json.getChild("Vertices", vertices_json)) {
+                                    for (size_t j = 0; j < vertices_json.size(); ++j) {
+                                        Settings vertex_json;
+                                        if (vertices_json.getChild(j, vertex_json))
+                                            fence.vertices.push_back(Vector2r(vertex_json.getFloat("X", 0), vertex_json.getFloat("Y", 0)));
+                                    }
+                                }
+                                safety_monitor_setting.geofences.push_back(fence);
+                            }
+                        }
+                    }
+                }
                 {
                     // External Force Settings
                     Settings child_json;
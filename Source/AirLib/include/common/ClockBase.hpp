@@ -6,6 +6,7 @@
 
 #include <thread>
 #include <chrono>
+#include <atomic>
 #include "Common.hpp"
 
 namespace msr
@@ -64,6 +65,7 @@ namespace airlib
             return nowNanos();
         }
 
+        //safe to call from any thread, e.g. to find out if the physics loop has moved on to a new step
         uint64_t getStepCount() const
         {
             return step_count_;
@@ -96,7 +98,7 @@ namespace airlib
         template <typename T>
         using duration = std::chrono::duration<T>;
 
-        uint64_t step_count_ = 0;
+        std::atomic<uint64_t> step_count_{ 0 };
         TTimePoint wall_clock_start_;
     };
 }
@@ -318,6 +318,19 @@ namespace airlib
         }
     };
 
+    //change in a vehicle's safety state reported by the safety monitor
+    struct SafetyEvent
+    {
+        uint64_t step = 0; //physics step the change was detected in
+        std::string type = ""; //"GeoFence" or "Separation"
+        bool is_violation = false; //false when the violation ended
+        std::string vehicle_name = "";
+        int fence_id = -1; //GeoFence only
+        std::string other_vehicle_name = ""; //Separation only
+        Vector3r position = Vector3r::Zero(); //NED
+        float distance = 0; //to the fence boundary or to the other vehicle
+    };
+
     struct CollisionResponse
     {
         unsigned int collision_count_raw = 0;
@@ -5,18 +5,25 @@
 #define common_utils_DelayLine_hpp
 
 #include "common/Common.hpp"
+#include "common/GaussianNoise.hpp"
 #include "UpdatableObject.hpp"
-#include <list>
+#include <cmath>
 
 namespace msr
 {
 namespace airlib
 {
 
+    // Models the transport delay of a sensor. Pushed values come out after the delay (plus optional gaussian jitter)
+    // has elapsed. Pending values live in a ring buffer sized from delay and update rate, so the steady state
+    // does not allocate. With an interpolator set, the output is interpolated at (now - delay) between the
+    // two samples around that time instead of stepping from sample to sample.
     template <typename T>
     class DelayLine : public UpdatableObject
     {
     public:
+        typedef T (*Interpolator)(const T& from, const T& to, real_T alpha);
+
         DelayLine()
         {
         }
@@ -24,9 +31,16 @@ namespace airlib
         {
             initialize(delay);
         }
-        void initialize(TTimeDelta delay) //in seconds
+        // update_frequency is the rate of push_back in Hz, used to size the buffer. Jitter is the standard deviation of the delay.
+        void initialize(TTimeDelta delay, real_T update_frequency = 0, TTimeDelta jitter = 0, uint64_t seed = GaussianNoise::kDefaultSeed) //in seconds
         {
             setDelay(delay);
+            setJitter(jitter, seed);
+
+            size_t capacity = kDefaultCapacity;
+            if (update_frequency > 0)
+                capacity = static_cast<size_t>(std::ceil((delay + 4 * jitter) * update_frequency)) + 2;
+            reserve(capacity);
         }
         void setDelay(TTimeDelta delay)
         {
@@ -36,57 +50,131 @@ namespace airlib
         {
             return delay_;
         }
+        void setJitter(TTimeDelta jitter, uint64_t seed = GaussianNoise::kDefaultSeed)
+        {
+            jitter_ = jitter;
+            jitter_noise_.seed(seed);
+        }
+        void setInterpolator(Interpolator interpolator)
+        {
+            interpolator_ = interpolator;
+        }
+        // Linear interpolation for types with + and scalar *, e.g. real_T and Vector3r
+        static T lerp(const T& from, const T& to, real_T alpha)
+        {
+            return from + (to - from) * alpha;
+        }
 
         //*** Start: UpdatableState implementation ***//
         virtual void resetImplementation() override
         {
-            values_.clear();
-            times_.clear();
+            head_ = 0;
+            count_ = 0;
+            last_release_time_ = 0;
+            jitter_noise_.reset();
             last_time_ = 0;
             last_value_ = T();
+            output_value_ = T();
+            output_time_ = 0;
         }
 
         virtual void update(float delta = 0) override
         {
             UpdatableObject::update(delta);
 
-            if (!times_.empty() &&
-                ClockBase::elapsedBetween(clock()->nowNanos(), times_.front()) >= delay_) {
+            const TTimePoint now = clock()->nowNanos();
+            while (count_ > 0 && buffer_[head_].release_time <= now) {
+                last_value_ = buffer_[head_].value;
+                last_time_ = buffer_[head_].time;
+                head_ = (head_ + 1) % buffer_.size();
+                --count_;
+            }
 
-                last_value_ = values_.front();
-                last_time_ = times_.front();
+            output_value_ = last_value_;
+            output_time_ = last_time_;
 
-                times_.pop_front();
-                values_.pop_front();
+            if (interpolator_ != nullptr && count_ > 0 && last_time_ != 0) {
+                const Entry& next = buffer_[head_];
+                const TTimeDelta span = ClockBase::elapsedBetween(next.time, last_time_);
+                if (span > 0) {
+                    const TTimeDelta target = ClockBase::elapsedBetween(now, last_time_) - delay_;
+                    const real_T alpha = static_cast<real_T>(Utils::clip(target / span, 0.0, 1.0));
+                    output_value_ = interpolator_(last_value_, next.value, alpha);
+                    output_time_ = clock()->addTo(last_time_, span * alpha);
+                }
             }
         }
         //*** End: UpdatableState implementation ***//
 
         T getOutput() const
         {
-            return last_value_;
+            return output_value_;
         }
         double getOutputTime() const
         {
-            return last_time_;
+            return output_time_;
+        }
+        size_t getPendingCount() const
+        {
+            return count_;
         }
 
         void push_back(const T& val, TTimePoint time_offset = 0)
         {
-            values_.push_back(val);
-            times_.push_back(clock()->nowNanos() + time_offset);
+            if (count_ == buffer_.size())
+                reserve(std::max(kDefaultCapacity, buffer_.size() * 2));
+
+            Entry& entry = buffer_[(head_ + count_) % buffer_.size()];
+            entry.value = val;
+            entry.time = clock()->nowNanos() + time_offset;
+
+            TTimeDelta delay = delay_;
+            if (jitter_ > 0)
+                delay = std::max(0.0, delay + jitter_ * jitter_noise_.next());
+            //values leave in the order they were pushed, a late value holds back the ones behind it
+            entry.release_time = std::max(clock()->addTo(entry.time, delay), last_release_time_);
+            last_release_time_ = entry.release_time;
+
+            ++count_;
         }
 
     private:
-        template <typename TItem>
-        using list = std::list<TItem>;
+        struct Entry
+        {
+            T value;
+            TTimePoint time;
+            TTimePoint release_time;
+        };
+
+        static constexpr size_t kDefaultCapacity = 16;
 
-        list<T> values_;
-        list<TTimePoint> times_;
-        TTimeDelta delay_;
+        //grows the ring to at least capacity entries, keeping pending values in order
+        void reserve(size_t capacity)
+        {
+            if (capacity <= buffer_.size())
+                return;
+
+            vector<Entry> buffer(capacity);
+            for (size_t i = 0; i < count_; ++i)
+                buffer[i] = buffer_[(head_ + i) % buffer_.size()];
+            buffer_.swap(buffer);
+            head_ = 0;
+        }
+
+    private:
+        vector<Entry> buffer_;
+        size_t head_ = 0;
+        size_t count_ = 0;
+        TTimeDelta delay_ = 0;
+        TTimeDelta jitter_ = 0;
+        GaussianNoise jitter_noise_;
+        TTimePoint last_release_time_ = 0;
+        Interpolator interpolator_ = nullptr;
 
         T last_value_;
-        TTimePoint last_time_;
+        TTimePoint last_time_ = 0;
+        T output_value_;
+        TTimePoint output_time_ = 0;
     };
 }
 } //namespace
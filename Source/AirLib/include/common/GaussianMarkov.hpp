@@ -7,7 +7,7 @@
 #include "common/Common.hpp"
 #include "UpdatableObject.hpp"
 #include <list>
-#include "common_utils/RandomGenerator.hpp"
+#include "common/GaussianNoise.hpp"
 
 namespace msr
 {
@@ -28,7 +28,7 @@ namespace airlib
         {
             tau_ = tau;
             sigma_ = sigma;
-            rand_ = RandomGeneratorGausianR(0.0f, 1.0f);
+            rand_.reset();
 
             if (std::isnan(initial_output))
                 initial_output_ = getNextRandom() * sigma_;
@@ -64,6 +64,12 @@ namespace airlib
         }
         //*** End: UpdatableState implementation ***//
 
+        // Select the noise stream, call before initialize() when the initial output is drawn at random
+        void seed(uint64_t seed_val, uint32_t stream = 0)
+        {
+            rand_.seed(seed_val, stream);
+        }
+
         real_T getNextRandom()
         {
             return rand_.next();
@@ -75,7 +81,7 @@ namespace airlib
         }
 
     private:
-        RandomGeneratorGausianR rand_;
+        GaussianNoise rand_;
         real_T tau_, sigma_;
         real_T output_, initial_output_;
         TTimePoint last_time_;
@@ -0,0 +1,214 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#ifndef msr_airlib_GaussianNoise_hpp
+#define msr_airlib_GaussianNoise_hpp
+
+#include "common/Common.hpp"
+#include <array>
+#include <cmath>
+
+namespace msr
+{
+namespace airlib
+{
+
+    // Counter based random number generator (Philox4x32-10, Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3", SC11).
+    // The output is a pure function of (counter, key), so any sample of a stream can be computed on any thread
+    // without shared state, and the result does not depend on how work is split over threads.
+    class Philox4x32
+    {
+    public:
+        typedef std::array<uint32_t, 4> Counter;
+        typedef std::array<uint32_t, 2> Key;
+
+        static Counter generate(Counter counter, Key key)
+        {
+            for (int round = 0; round < kRounds; ++round) {
+                if (round > 0) {
+                    key[0] += kWeyl0;
+                    key[1] += kWeyl1;
+                }
+                counter = singleRound(counter, key);
+            }
+            return counter;
+        }
+
+        // Same as generate() for count consecutive counters, written lane-wise so the compiler can vectorize the rounds
+        static void generateBlock(uint64_t first_counter, uint32_t stream, Key key, uint32_t* out, size_t count)
+        {
+            static constexpr size_t kLanes = 16;
+            uint32_t c0[kLanes], c1[kLanes], c2[kLanes], c3[kLanes];
+
+            for (size_t begin = 0; begin < count; begin += kLanes) {
+                const size_t lanes = std::min(kLanes, count - begin);
+                for (size_t lane = 0; lane < kLanes; ++lane) {
+                    const uint64_t counter = first_counter + begin + lane;
+                    c0[lane] = static_cast<uint32_t>(counter);
+                    c1[lane] = static_cast<uint32_t>(counter >> 32);
+                    c2[lane] = stream;
+                    c3[lane] = 0;
+                }
+
+                Key round_key = key;
+                for (int round = 0; round < kRounds; ++round) {
+                    if (round > 0) {
+                        round_key[0] += kWeyl0;
+                        round_key[1] += kWeyl1;
+                    }
+                    for (size_t lane = 0; lane < kLanes; ++lane) {
+                        const uint64_t product0 = static_cast<uint64_t>(kMultiplier0) * c0[lane];
+                        const uint64_t product1 = static_cast<uint64_t>(kMultiplier1) * c2[lane];
+                        const uint32_t next0 = static_cast<uint32_t>(product1 >> 32) ^ c1[lane] ^ round_key[0];
+                        const uint32_t next2 = static_cast<uint32_t>(product0 >> 32) ^ c3[lane] ^ round_key[1];
+                        c1[lane] = static_cast<uint32_t>(product1);
+                        c3[lane] = static_cast<uint32_t>(product0);
+                        c0[lane] = next0;
+                        c2[lane] = next2;
+                    }
+                }
+
+                for (size_t lane = 0; lane < lanes; ++lane) {
+                    uint32_t* words = out + (begin + lane) * 4;
+                    words[0] = c0[lane];
+                    words[1] = c1[lane];
+                    words[2] = c2[lane];
+                    words[3] = c3[lane];
+                }
+            }
+        }
+
+    private:
+        static constexpr int kRounds = 10;
+        static constexpr uint32_t kMultiplier0 = 0xD2511F53;
+        static constexpr uint32_t kMultiplier1 = 0xCD9E8D57;
+        static constexpr uint32_t kWeyl0 = 0x9E3779B9;
+        static constexpr uint32_t kWeyl1 = 0xBB67AE85;
+
+        static Counter singleRound(const Counter& counter, const Key& key)
+        {
+            const uint64_t product0 = static_cast<uint64_t>(kMultiplier0) * counter[0];
+            const uint64_t product1 = static_cast<uint64_t>(kMultiplier1) * counter[2];
+            return Counter{ static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+                            static_cast<uint32_t>(product1),
+                            static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+                            static_cast<uint32_t>(product0) };
+        }
+    };
+
+    // Gaussian noise source on top of Philox4x32. Sample i of a (seed, stream) pair is always the same value,
+    // whether it is drawn sequentially with next(), in bulk with fill() or directly with at(i) from any thread.
+    // Sequential draws are served from a block that is generated and transformed in one pass.
+    class GaussianNoise
+    {
+    public:
+        static constexpr uint64_t kDefaultSeed = 42;
+
+        GaussianNoise(real_T mean = 0, real_T sigma = 1, uint64_t seed_val = kDefaultSeed, uint32_t stream = 0)
+            : mean_(mean), sigma_(sigma)
+        {
+            seed(seed_val, stream);
+        }
+
+        // Derive a per sensor seed so sensors with the same base seed still draw independent noise
+        static uint64_t makeSeed(const std::string& name, uint64_t base_seed = kDefaultSeed)
+        {
+            uint64_t hash = 14695981039346656037ull ^ base_seed;
+            for (char c : name) {
+                hash ^= static_cast<unsigned char>(c);
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        void seed(uint64_t seed_val, uint32_t stream = 0)
+        {
+            key_ = Philox4x32::Key{ static_cast<uint32_t>(seed_val), static_cast<uint32_t>(seed_val >> 32) };
+            stream_ = stream;
+            reset();
+        }
+
+        void setDistribution(real_T mean, real_T sigma)
+        {
+            mean_ = mean;
+            sigma_ = sigma;
+        }
+
+        // Restart the stream from sample 0
+        void reset()
+        {
+            next_block_ = 0;
+            position_ = kBlockSize;
+        }
+
+        real_T next()
+        {
+            if (position_ == kBlockSize)
+                refill();
+            return mean_ + sigma_ * block_[position_++];
+        }
+
+        Vector3r nextVector()
+        {
+            const real_T x = next();
+            const real_T y = next();
+            const real_T z = next();
+            return Vector3r(x, y, z);
+        }
+
+        void fill(real_T* out, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i)
+                out[i] = next();
+        }
+
+        // Sample index of this stream without touching the sequential state, safe to call concurrently
+        real_T at(uint64_t index) const
+        {
+            const Philox4x32::Counter words = Philox4x32::generate(
+                Philox4x32::Counter{ static_cast<uint32_t>(index / 4), static_cast<uint32_t>((index / 4) >> 32), stream_, 0 }, key_);
+            real_T normals[4];
+            boxMuller(words.data(), normals);
+            return mean_ + sigma_ * normals[index % 4];
+        }
+
+    private:
+        static constexpr size_t kBlockSize = 64; // normals per block, 4 per Philox call
+        static constexpr size_t kCallsPerBlock = kBlockSize / 4;
+
+        void refill()
+        {
+            uint32_t words[kBlockSize];
+            Philox4x32::generateBlock(next_block_ * kCallsPerBlock, stream_, key_, words, kCallsPerBlock);
+            for (size_t call = 0; call < kCallsPerBlock; ++call)
+                boxMuller(words + call * 4, block_.data() + call * 4);
+            ++next_block_;
+            position_ = 0;
+        }
+
+        // Four uniform words to four standard normals
+        static void boxMuller(const uint32_t* words, real_T* normals)
+        {
+            static constexpr real_T kTwoPi = static_cast<real_T>(2 * M_PI);
+            static constexpr real_T kToUnit = static_cast<real_T>(1.0 / 16777216.0); // 2^-24
+
+            for (int pair = 0; pair < 2; ++pair) {
+                // (0, 1] so the log is finite, and [0, 1) for the angle
+                const real_T u1 = ((words[pair * 2] >> 8) + 1) * kToUnit;
+                const real_T u2 = (words[pair * 2 + 1] >> 8) * kToUnit;
+                const real_T radius = std::sqrt(-2 * std::log(u1));
+                normals[pair * 2] = radius * std::cos(kTwoPi * u2);
+                normals[pair * 2 + 1] = radius * std::sin(kTwoPi * u2);
+            }
+        }
+
+    private:
+        real_T mean_, sigma_;
+        Philox4x32::Key key_;
+        uint32_t stream_;
+        uint64_t next_block_;
+        size_t position_;
+        std::array<real_T, kBlockSize> block_;
+    };
+}
+} //namespace
+#endif
@@ -0,0 +1,412 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#ifndef msr_airlib_MinimumSnapTrajectory_hpp
+#define msr_airlib_MinimumSnapTrajectory_hpp
+
+#include "common/Common.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace msr
+{
+namespace airlib
+{
+
+    // Smooth trajectory through a list of waypoints, planned once and then sampled at any rate.
+    // Each segment between two waypoints is a 7th order polynomial, or three of them when the segment is long enough
+    // to cruise. Velocity, acceleration and jerk at the interior waypoints are chosen to minimize the integral of
+    // squared snap over the whole path, which gives a block tridiagonal system that is solved in O(n). The trajectory
+    // starts at the given velocity, ends at rest and is slowed down uniformly until it stays within the velocity and
+    // acceleration limits.
+    class MinimumSnapTrajectory
+    {
+    public:
+        struct Sample
+        {
+            Vector3r position = Vector3r::Zero();
+            Vector3r velocity = Vector3r::Zero();
+            Vector3r acceleration = Vector3r::Zero();
+            //index in to the waypoints given to plan() of the waypoint this sample is heading to
+            uint waypoint_index = 0;
+            //fraction of the path length covered, measured along straight lines between waypoints
+            float progress = 0;
+        };
+
+    public:
+        // waypoints[0] is the start of the trajectory. Waypoints closer than kMinSegmentLength to the previous
+        // one are skipped. Returns false if there is nothing to fly, which leaves the trajectory empty.
+        bool plan(const vector<Vector3r>& waypoints, const Vector3r& start_velocity, float max_velocity, float max_acceleration)
+        {
+            clear();
+
+            if (!(max_velocity > 0) || !(max_acceleration > 0))
+                throw std::invalid_argument(Utils::stringf("Trajectory limits must be positive, got velocity %f and acceleration %f",
+                                                           max_velocity, max_acceleration));
+
+            //drop duplicate waypoints, they would make zero length segments
+            vector<Vector3d> points;
+            vector<uint> point_indices;
+            for (uint i = 0; i < waypoints.size(); ++i) {
+                if (waypoints[i].hasNaN())
+                    throw std::invalid_argument(VectorMath::toString(waypoints[i], "waypoint cannot have NaN: "));
+                const Vector3d point = waypoints[i].cast<double>();
+                if (points.size() == 0 || (point - points.back()).norm() >= kMinSegmentLength) {
+                    points.push_back(point);
+                    point_indices.push_back(i);
+                }
+            }
+            if (points.size() < 2)
+                return false;
+
+            //a single polynomial cannot hold a constant speed, its peak is about twice its average. So segments
+            //that cruise are split where the speed profile stops accelerating and starts braking.
+            setSegments(points, point_indices);
+            const double acceleration = max_acceleration * kAllocationAccelerationFactor;
+            const vector<double> speeds = getWaypointSpeeds(points, start_velocity.norm(), max_velocity, acceleration);
+            vector<Vector3d> knots;
+            vector<uint> knot_indices;
+            knots.push_back(points.front());
+            knot_indices.push_back(point_indices.front());
+            for (uint i = 0; i + 1 < points.size(); ++i) {
+                const double length = segments_[i].length;
+                const Vector3d direction = (points[i + 1] - points[i]) / length;
+                const double peak = getPeakSpeed(speeds[i], speeds[i + 1], length, max_velocity, acceleration);
+                const double speed_up = (peak * peak - speeds[i] * speeds[i]) / (2 * acceleration);
+                const double slow_down = (peak * peak - speeds[i + 1] * speeds[i + 1]) / (2 * acceleration);
+                const double cruise = std::max(0.0, length - speed_up - slow_down);
+                vector<double> offsets = { speed_up };
+                if (cruise >= kMinSegmentLength) {
+                    //pieces of the cruise about as long as the speed changes keep the solution from bulging
+                    const double piece = std::max({ speed_up, slow_down, cruise / kMaxCruisePieces });
+                    const uint pieces = static_cast<uint>(std::ceil(cruise / piece - 1E-6));
+                    for (uint k = 1; k <= pieces; ++k)
+                        offsets.push_back(speed_up + cruise * k / pieces);
+                }
+                for (const double offset : offsets) {
+                    if (offset >= kMinSegmentLength && length - offset >= kMinSegmentLength) {
+                        knots.push_back(points[i] + direction * offset);
+                        knot_indices.push_back(point_indices[i + 1]);
+                    }
+                }
+                knots.push_back(points[i + 1]);
+                knot_indices.push_back(point_indices[i + 1]);
+            }
+            setSegments(knots, knot_indices);
+            const uint segment_count = static_cast<uint>(segments_.size());
+            start_times_.resize(segment_count);
+            const Vector3d start_velocity_d = start_velocity.cast<double>();
+
+            //the shape of the optimal path does not change if all durations are scaled by the same factor, only the
+            //start velocity is fixed in physical units. So re-solve a few times with scaled durations and then
+            //stretch the last solution in time if it still exceeds the limits.
+            allocateDurations(knots, start_velocity_d.norm(), max_velocity, acceleration);
+            double scale = 1;
+            for (uint iteration = 0; iteration < kMaxScaleIterations; ++iteration) {
+                solve(knots, start_velocity_d);
+                scale = 1;
+                for (const Segment& segment : segments_)
+                    scale = std::max(scale, getLimitScale(segment, max_velocity, max_acceleration));
+                if (scale <= 1 + kScaleTolerance)
+                    break;
+                for (Segment& segment : segments_)
+                    segment.duration *= scale;
+            }
+            if (scale > 1 + kScaleTolerance) {
+                //normalized coefficients stay the same, only the time axis is stretched
+                for (Segment& segment : segments_)
+                    segment.duration *= scale;
+            }
+
+            double time = 0;
+            for (uint i = 0; i < segment_count; ++i) {
+                start_times_[i] = time;
+                time += segments_[i].duration;
+            }
+            duration_ = time;
+
+            return true;
+        }
+
+        void clear()
+        {
+            segments_.clear();
+            start_times_.clear();
+            duration_ = 0;
+            length_ = 0;
+        }
+
+        bool isEmpty() const
+        {
+            return segments_.size() == 0;
+        }
+
+        TTimeDelta getDuration() const
+        {
+            return duration_;
+        }
+
+        uint getSegmentCount() const
+        {
+            return static_cast<uint>(segments_.size());
+        }
+
+        // time is clamped to [0, getDuration()], the trajectory must not be empty
+        Sample sample(TTimeDelta time) const
+        {
+            time = Utils::clip<TTimeDelta>(time, 0, duration_);
+
+            //last segment that starts at or before time
+            const auto it = std::upper_bound(start_times_.begin(), start_times_.end(), time);
+            const size_t index = it == start_times_.begin() ? 0 : static_cast<size_t>(it - start_times_.begin()) - 1;
+            const Segment& segment = segments_[index];
+
+            const double tau = Utils::clip((time - start_times_[index]) / segment.duration, 0.0, 1.0);
+
+            Vector3d position, velocity, acceleration;
+            evaluate(segment, tau, position, velocity, acceleration);
+
+            Sample sample;
+            sample.position = position.cast<real_T>();
+            sample.velocity = (velocity / segment.duration).cast<real_T>();
+            sample.acceleration = (acceleration / (segment.duration * segment.duration)).cast<real_T>();
+            sample.waypoint_index = segment.waypoint_index;
+            sample.progress = length_ > 0 ? static_cast<float>((segment.start_length + tau * segment.length) / length_) : 1.0f;
+            return sample;
+        }
+
+    private:
+        typedef Eigen::Matrix<double, 3, 1> Vector3d;
+        typedef Eigen::Matrix<double, 3, 3> Block;
+        typedef Eigen::Matrix<double, 8, 8> Matrix8x8d;
+
+        struct Segment
+        {
+            //polynomial coefficients over normalized time tau = t / duration, one column per axis
+            Eigen::Matrix<double, 8, 3, Eigen::DontAlign> coefficients;
+            double duration;
+            double length;
+            double start_length;
+            uint waypoint_index;
+        };
+
+        struct Constants
+        {
+            //maps coefficients to [p, p', p'', p'''] at tau = 0 followed by the same at tau = 1
+            Matrix8x8d endpoints_to_coefficients;
+            //cost of a unit duration segment as a quadratic form of its endpoint derivatives
+            Matrix8x8d unit_cost;
+
+            Constants()
+            {
+                Matrix8x8d coefficients_to_endpoints = Matrix8x8d::Zero();
+                Matrix8x8d snap_cost = Matrix8x8d::Zero();
+                for (int k = 0; k < 4; ++k) {
+                    for (int j = k; j < 8; ++j) {
+                        const double factor = fallingFactorial(j, k);
+                        if (j == k)
+                            coefficients_to_endpoints(k, j) = factor;
+                        coefficients_to_endpoints(4 + k, j) = factor;
+                    }
+                }
+                for (int j = 4; j < 8; ++j)
+                    for (int k = 4; k < 8; ++k)
+                        snap_cost(j, k) = fallingFactorial(j, 4) * fallingFactorial(k, 4) / (j + k - 7);
+
+                endpoints_to_coefficients = coefficients_to_endpoints.inverse();
+                unit_cost = endpoints_to_coefficients.transpose() * snap_cost * endpoints_to_coefficients;
+            }
+
+            static double fallingFactorial(int n, int k)
+            {
+                double result = 1;
+                for (int i = 0; i < k; ++i)
+                    result *= n - i;
+                return result;
+            }
+        };
+
+        static const Constants& getConstants()
+        {
+            static const Constants constants;
+            return constants;
+        }
+
+        void setSegments(const vector<Vector3d>& points, const vector<uint>& point_indices)
+        {
+            segments_.resize(points.size() - 1);
+            double length = 0;
+            for (uint i = 0; i < segments_.size(); ++i) {
+                Segment& segment = segments_[i];
+                segment.length = (points[i + 1] - points[i]).norm();
+                segment.start_length = length;
+                segment.waypoint_index = point_indices[i + 1];
+                length += segment.length;
+            }
+            length_ = length;
+        }
+
+        //Speed at each waypoint of a trapezoidal speed profile along the straight lines between waypoints. Speed
+        //at a waypoint is limited by how sharp the turn is, so only the segments around sharp corners are slow and
+        //the polynomial solution needs little scaling afterwards.
+        vector<double> getWaypointSpeeds(const vector<Vector3d>& points, double start_speed, double max_velocity, double acceleration) const
+        {
+            const uint segment_count = static_cast<uint>(segments_.size());
+            vector<double> speeds(segment_count + 1, max_velocity);
+            speeds.front() = std::min(start_speed, max_velocity);
+            speeds.back() = 0;
+            for (uint i = 1; i < segment_count; ++i) {
+                const Vector3d incoming = (points[i] - points[i - 1]) / segments_[i - 1].length;
+                const Vector3d outgoing = (points[i + 1] - points[i]) / segments_[i].length;
+                //velocity turns by 2 v sin(angle / 2) while flying about half of the shorter segment
+                const double half_turn_sin = 0.5 * (outgoing - incoming).norm();
+                if (half_turn_sin > 1E-6) {
+                    const double blend_length = 0.5 * std::min(segments_[i - 1].length, segments_[i].length);
+                    speeds[i] = std::min(speeds[i], std::sqrt(acceleration * blend_length / (2 * half_turn_sin)));
+                }
+            }
+
+            //make every speed change reachable within its segment
+            for (uint i = 0; i < segment_count; ++i)
+                speeds[i + 1] = std::min(speeds[i + 1], std::sqrt(speeds[i] * speeds[i] + 2 * acceleration * segments_[i].length));
+            for (uint i = segment_count; i > 0; --i)
+                speeds[i - 1] = std::min(speeds[i - 1], std::sqrt(speeds[i] * speeds[i] + 2 * acceleration * segments_[i - 1].length));
+            return speeds;
+        }
+
+        static double getPeakSpeed(double v0, double v1, double length, double max_velocity, double acceleration)
+        {
+            return std::min(max_velocity, std::sqrt(acceleration * length + 0.5 * (v0 * v0 + v1 * v1)));
+        }
+
+        //Initial segment durations from the trapezoidal speed profile
+        void allocateDurations(const vector<Vector3d>& points, double start_speed, double max_velocity, double acceleration)
+        {
+            const vector<double> speeds = getWaypointSpeeds(points, start_speed, max_velocity, acceleration);
+            for (uint i = 0; i < segments_.size(); ++i) {
+                const double v0 = speeds[i], v1 = speeds[i + 1], length = segments_[i].length;
+                const double peak = getPeakSpeed(v0, v1, length, max_velocity, acceleration);
+                const double cruise_length = std::max(0.0, length - (2 * peak * peak - v0 * v0 - v1 * v1) / (2 * acceleration));
+                segments_[i].duration = std::max((peak - v0) / acceleration + (peak - v1) / acceleration + cruise_length / peak,
+                                                 kMinSegmentDuration);
+            }
+        }
+
+        //position and its first two derivatives with respect to normalized time
+        static void evaluate(const Segment& segment, double tau, Vector3d& position, Vector3d& velocity, Vector3d& acceleration)
+        {
+            //Horner's scheme, acceleration accumulates half of the second derivative
+            position = segment.coefficients.row(7).transpose();
+            velocity = Vector3d::Zero();
+            acceleration = Vector3d::Zero();
+            for (int j = 6; j >= 0; --j) {
+                acceleration = acceleration * tau + velocity;
+                velocity = velocity * tau + position;
+                position = position * tau + segment.coefficients.row(j).transpose();
+            }
+            acceleration *= 2;
+        }
+
+        //cost of a segment as a quadratic form of its physical endpoint derivatives
+        static Matrix8x8d getSegmentCost(double duration)
+        {
+            //a derivative of order k in normalized time is duration^k times the physical one,
+            //and the snap integral over physical time scales with duration^-7
+            Eigen::Matrix<double, 8, 1> scale;
+            for (int k = 0; k < 4; ++k)
+                scale(k) = scale(4 + k) = std::pow(duration, k);
+            return std::pow(duration, -7) * scale.asDiagonal() * getConstants().unit_cost * scale.asDiagonal();
+        }
+
+        void solve(const vector<Vector3d>& points, const Vector3d& start_velocity)
+        {
+            const uint segment_count = static_cast<uint>(segments_.size());
+            const uint knot_count = segment_count + 1;
+
+            //unknowns per waypoint are rows [v, a, j] with one column per axis
+            vector<Block> diagonal(knot_count, Block::Zero());
+            vector<Block> upper(segment_count, Block::Zero());
+            vector<Block> rhs(knot_count, Block::Zero());
+
+            for (uint i = 0; i < segment_count; ++i) {
+                const Matrix8x8d cost = getSegmentCost(segments_[i].duration);
+                const Eigen::RowVector3d start = points[i].transpose();
+                const Eigen::RowVector3d end = points[i + 1].transpose();
+
+                diagonal[i] += cost.block<3, 3>(1, 1);
+                diagonal[i + 1] += cost.block<3, 3>(5, 5);
+                upper[i] += cost.block<3, 3>(1, 5);
+                rhs[i] -= cost.block<3, 1>(1, 0) * start + cost.block<3, 1>(1, 4) * end;
+                rhs[i + 1] -= cost.block<3, 1>(5, 0) * start + cost.block<3, 1>(5, 4) * end;
+            }
+
+            //derivatives at both ends are fixed: start velocity with no acceleration or jerk, rest at the end
+            vector<Block> derivatives(knot_count, Block::Zero());
+            derivatives.front().row(0) = start_velocity.transpose();
+            if (knot_count > 2)
+                rhs[1] -= upper[0].transpose() * derivatives.front();
+
+            //block Thomas algorithm over interior knots, the system is symmetric positive definite
+            if (knot_count > 2) {
+                const uint last = knot_count - 2;
+                vector<Block> pivot_inverse(knot_count);
+                pivot_inverse[1] = diagonal[1].inverse();
+                for (uint k = 2; k <= last; ++k) {
+                    const Block factor = upper[k - 1].transpose() * pivot_inverse[k - 1];
+                    pivot_inverse[k] = (diagonal[k] - factor * upper[k - 1]).inverse();
+                    rhs[k] -= factor * rhs[k - 1];
+                }
+                derivatives[last] = pivot_inverse[last] * rhs[last];
+                for (uint k = last - 1; k >= 1; --k)
+                    derivatives[k] = pivot_inverse[k] * (rhs[k] - upper[k] * derivatives[k + 1]);
+            }
+
+            const Matrix8x8d& endpoints_to_coefficients = getConstants().endpoints_to_coefficients;
+            for (uint i = 0; i < segment_count; ++i) {
+                Segment& segment = segments_[i];
+                Eigen::Matrix<double, 8, 3> endpoints;
+                endpoints.row(0) = points[i].transpose();
+                endpoints.row(4) = points[i + 1].transpose();
+                double scale = 1;
+                for (int k = 1; k < 4; ++k) {
+                    scale *= segment.duration;
+                    endpoints.row(k) = derivatives[i].row(k - 1) * scale;
+                    endpoints.row(4 + k) = derivatives[i + 1].row(k - 1) * scale;
+                }
+                segment.coefficients = endpoints_to_coefficients * endpoints;
+            }
+        }
+
+        //how much a segment has to be slowed down to stay within the limits, 1 if it already does
+        static double getLimitScale(const Segment& segment, double max_velocity, double max_acceleration)
+        {
+            double peak_velocity = 0, peak_acceleration = 0;
+            for (uint s = 0; s <= kLimitSamples; ++s) {
+                Vector3d position, velocity, acceleration;
+                evaluate(segment, static_cast<double>(s) / kLimitSamples, position, velocity, acceleration);
+                peak_velocity = std::max(peak_velocity, velocity.norm());
+                peak_acceleration = std::max(peak_acceleration, acceleration.norm());
+            }
+            return std::max({ 1.0,
+                              peak_velocity / segment.duration / max_velocity,
+                              std::sqrt(peak_acceleration / max_acceleration) / segment.duration });
+        }
+
+    private:
+        static constexpr double kMinSegmentLength = 1E-3;
+        static constexpr uint kMaxScaleIterations = 3;
+        static constexpr double kScaleTolerance = 0.01;
+        static constexpr double kAllocationAccelerationFactor = 0.5;
+        static constexpr double kMinSegmentDuration = 1E-2;
+        static constexpr uint kLimitSamples = 8;
+        static constexpr double kMaxCruisePieces = 16;
+
+        vector<Segment> segments_;
+        //copy of segment start times for binary search
+        vector<double> start_times_;
+        double duration_ = 0;
+        double length_ = 0;
+    };
+}
+} //namespace
+#endif
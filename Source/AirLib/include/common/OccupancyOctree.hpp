@@ -0,0 +1,541 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#ifndef msr_airlib_OccupancyOctree_hpp
+#define msr_airlib_OccupancyOctree_hpp
+
+#include "common/Common.hpp"
+#include "recording/MappedFile.hpp"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Sparse occupancy octree over a cube. Nodes are free leaves, occupied leaves or inner nodes with 8 children;
+    a node is only split where the overlap query for its box reports geometry, and 8 equal leaves are merged back
+    into their parent, so open space and solid volumes cost a single node.
+
+    Nodes are 8 byte records in one array, children of a node are stored contiguously. Saved files are a header
+    followed by that array, so open() maps a file and queries it in place. Updating a mapped octree copies the
+    nodes into memory first.
+
+    Not thread safe, the owner serializes access.
+    */
+    class OccupancyOctree
+    {
+    public:
+        enum class Occupancy : int
+        {
+            Unknown = -1, // outside the octree
+            Free = 0,
+            Occupied = 1
+        };
+
+        struct Cell
+        {
+            Vector3r center;
+            real_T size;
+        };
+
+        // center and half extent of an axis aligned box, must be thread safe when a parallel function is used
+        typedef std::function<bool(const Vector3r& center, const Vector3r& half_extent)> OverlapFunction;
+        // runs body(0) .. body(count - 1), possibly in parallel
+        typedef std::function<void(int count, const std::function<void(int)>& body)> ParallelFunction;
+
+        static constexpr uint32_t kFileMagic = 0x54434f41; // "AOCT"
+        static constexpr uint32_t kVersion = 1;
+        static constexpr uint32_t kMaxDepth = 16;
+
+    public:
+        // The cube is centered on center and at least size wide, the leaves are at most resolution wide
+        void initialize(const Vector3r& center, real_T size, real_T resolution)
+        {
+            mapping_.close();
+            center_ = center;
+            depth_ = 0;
+            while (depth_ < kMaxDepth && resolution * (1u << depth_) < size)
+                ++depth_;
+            half_size_ = resolution * (1u << depth_) * 0.5f;
+
+            storage_.assign(1, Node());
+            free_blocks_.clear();
+            nodes_ = storage_.data();
+            node_count_ = storage_.size();
+        }
+
+        bool isValid() const
+        {
+            return node_count_ > 0;
+        }
+
+        Vector3r getCenter() const
+        {
+            return center_;
+        }
+
+        real_T getSize() const
+        {
+            return half_size_ * 2;
+        }
+
+        real_T getResolution() const
+        {
+            return half_size_ * 2 / (1u << depth_);
+        }
+
+        // including nodes of merged subtrees waiting for reuse
+        size_t getNodeCount() const
+        {
+            return node_count_;
+        }
+
+        // Builds the whole octree. The top levels are tested serially, the subtrees below them in parallel.
+        void build(const OverlapFunction& overlap, const ParallelFunction& parallel = nullptr)
+        {
+            makeWritable();
+            storage_.assign(1, Node());
+            free_blocks_.clear();
+
+            //split the top levels serially, every occupied node at the task level becomes a subtree task
+            const uint32_t task_level = std::min<uint32_t>(depth_, 2);
+            std::vector<Task> tasks;
+            splitTop(overlap, 0, center_, half_size_, 0, task_level, tasks);
+
+            std::vector<std::vector<Node>> subtrees(tasks.size());
+            auto body = [&](int task_index) {
+                const Task& task = tasks[task_index];
+                std::vector<Node>& nodes = subtrees[task_index];
+                nodes.assign(1, Node());
+                buildNode(nodes, overlap, 0, task.center, task.half_size, task.level);
+            };
+            if (parallel)
+                parallel(static_cast<int>(tasks.size()), body);
+            else {
+                for (int i = 0; i < static_cast<int>(tasks.size()); ++i)
+                    body(i);
+            }
+
+            //append the subtrees, their local indices are shifted behind the nodes already there
+            for (size_t i = 0; i < tasks.size(); ++i) {
+                const std::vector<Node>& nodes = subtrees[i];
+                const uint32_t offset = static_cast<uint32_t>(storage_.size()) - 1;
+                for (size_t n = 1; n < nodes.size(); ++n) {
+                    Node node = nodes[n];
+                    if (node.children != 0)
+                        node.children += offset;
+                    storage_.push_back(node);
+                }
+                Node root = nodes[0];
+                if (root.children != 0)
+                    root.children += offset;
+                storage_[tasks[i].index] = root;
+            }
+
+            mergeTop(0, 0, task_level);
+            nodes_ = storage_.data();
+            node_count_ = storage_.size();
+        }
+
+        // Retests the nodes that intersect [min, max] after the world changed there
+        void update(const Vector3r& min, const Vector3r& max, const OverlapFunction& overlap)
+        {
+            if (!isValid())
+                return;
+            makeWritable();
+            updateNode(overlap, 0, center_, half_size_, 0, min, max);
+            nodes_ = storage_.data();
+            node_count_ = storage_.size();
+        }
+
+        Occupancy getOccupancy(const Vector3r& point) const
+        {
+            if (!isValid() || !contains(center_, half_size_, point))
+                return Occupancy::Unknown;
+
+            uint32_t index = 0;
+            Vector3r center = center_;
+            real_T half_size = half_size_;
+            while (nodes_[index].state == kMixed) {
+                half_size *= 0.5f;
+                const uint32_t octant = getOctant(center, point);
+                center = getChildCenter(center, half_size, octant);
+                index = nodes_[index].children + octant;
+            }
+            return nodes_[index].state == kOccupied ? Occupancy::Occupied : Occupancy::Free;
+        }
+
+        // First occupied point on the segment from start to end
+        bool castRay(const Vector3r& start, const Vector3r& end, Vector3r& hit_point) const
+        {
+            if (!isValid())
+                return false;
+
+            const Vector3r direction = end - start;
+            Vector3r inverse_direction;
+            for (int axis = 0; axis < 3; ++axis)
+                inverse_direction[axis] = direction[axis] != 0 ? 1 / direction[axis] : std::numeric_limits<real_T>::infinity();
+
+            real_T hit_t;
+            if (!castRayNode(0, center_, half_size_, start, inverse_direction, 0, 1, hit_t))
+                return false;
+            hit_point = start + direction * hit_t;
+            return true;
+        }
+
+        // Occupied leaves that intersect [min, max], merged leaves are reported as one larger cell
+        void getOccupiedCells(const Vector3r& min, const Vector3r& max, std::vector<Cell>& cells) const
+        {
+            cells.clear();
+            if (isValid())
+                collectOccupied(0, center_, half_size_, min, max, cells);
+        }
+
+        // Writes the nodes without the unused ones, in a layout open() can map
+        bool save(const std::string& path) const
+        {
+            if (!isValid())
+                return false;
+
+            std::vector<Node> nodes(1, nodes_[0]);
+            compact(0, nodes, 0);
+
+            Header header;
+            header.center[0] = center_.x();
+            header.center[1] = center_.y();
+            header.center[2] = center_.z();
+            header.half_size = half_size_;
+            header.depth = depth_;
+            header.node_count = static_cast<uint32_t>(nodes.size());
+
+            std::ofstream file(path, std::ios::binary);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(Node));
+            return file.good();
+        }
+
+        // Maps a saved octree, queries read the file in place. The octree is empty if the file is not valid.
+        bool open(const std::string& path)
+        {
+            storage_.clear();
+            free_blocks_.clear();
+            nodes_ = nullptr;
+            node_count_ = 0;
+            if (!mapping_.open(path))
+                return false;
+
+            Header header;
+            const uint8_t* data = mapping_.at(0, sizeof(Header));
+            if (data != nullptr)
+                std::memcpy(&header, data, sizeof(header));
+            const uint8_t* nodes = data == nullptr ? nullptr : mapping_.at(sizeof(Header), static_cast<uint64_t>(header.node_count) * sizeof(Node));
+            if (nodes == nullptr || header.magic != kFileMagic || header.version > kVersion || header.depth > kMaxDepth || header.node_count == 0) {
+                mapping_.close();
+                return false;
+            }
+
+            center_ = Vector3r(header.center[0], header.center[1], header.center[2]);
+            half_size_ = header.half_size;
+            depth_ = header.depth;
+            nodes_ = reinterpret_cast<const Node*>(nodes);
+            node_count_ = header.node_count;
+            return true;
+        }
+
+    private:
+        static constexpr uint8_t kFree = 0;
+        static constexpr uint8_t kOccupied = 1;
+        static constexpr uint8_t kMixed = 2;
+
+        struct Node
+        {
+            uint32_t children = 0; // index of the first of 8 children, 0 for leaves (the root is never a child)
+            uint8_t state = kFree;
+            uint8_t reserved[3] = { 0, 0, 0 };
+        };
+
+        struct Header
+        {
+            uint32_t magic = kFileMagic;
+            uint32_t version = kVersion;
+            float center[3] = { 0, 0, 0 };
+            float half_size = 0;
+            uint32_t depth = 0;
+            uint32_t node_count = 0;
+        };
+
+        //the file is the in memory layout, little endian like every platform the simulator runs on
+        static_assert(sizeof(Node) == 8, "Node is stored as is in octree files");
+        static_assert(sizeof(Header) == 32, "Header is stored as is in octree files");
+
+        struct Task
+        {
+            uint32_t index;
+            Vector3r center;
+            real_T half_size;
+            uint32_t level;
+        };
+
+        static bool contains(const Vector3r& center, real_T half_size, const Vector3r& point)
+        {
+            return (point - center).cwiseAbs().maxCoeff() <= half_size;
+        }
+
+        static bool intersects(const Vector3r& center, real_T half_size, const Vector3r& min, const Vector3r& max)
+        {
+            return (center.array() + half_size >= min.array()).all() && (center.array() - half_size <= max.array()).all();
+        }
+
+        static uint32_t getOctant(const Vector3r& center, const Vector3r& point)
+        {
+            return (point.x() >= center.x() ? 1 : 0) | (point.y() >= center.y() ? 2 : 0) | (point.z() >= center.z() ? 4 : 0);
+        }
+
+        static Vector3r getChildCenter(const Vector3r& center, real_T child_half_size, uint32_t octant)
+        {
+            return center + Vector3r(octant & 1 ? child_half_size : -child_half_size,
+                                     octant & 2 ? child_half_size : -child_half_size,
+                                     octant & 4 ? child_half_size : -child_half_size);
+        }
+
+        void makeWritable()
+        {
+            if (!mapping_.isOpen())
+                return;
+            storage_.assign(nodes_, nodes_ + node_count_);
+            mapping_.close();
+            nodes_ = storage_.data();
+        }
+
+        static uint32_t allocateChildren(std::vector<Node>& nodes, std::vector<uint32_t>* free_blocks, uint8_t state)
+        {
+            uint32_t first;
+            if (free_blocks && !free_blocks->empty()) {
+                first = free_blocks->back();
+                free_blocks->pop_back();
+            }
+            else {
+                first = static_cast<uint32_t>(nodes.size());
+                nodes.resize(nodes.size() + 8);
+            }
+            for (uint32_t i = 0; i < 8; ++i) {
+                nodes[first + i] = Node();
+                nodes[first + i].state = state;
+            }
+            return first;
+        }
+
+        // Returns the children of a node to the free list, including all descendants
+        void releaseChildren(uint32_t index)
+        {
+            const uint32_t first = storage_[index].children;
+            if (first == 0)
+                return;
+            for (uint32_t i = 0; i < 8; ++i)
+                releaseChildren(first + i);
+            free_blocks_.push_back(first);
+            storage_[index].children = 0;
+        }
+
+        // Merges 8 equal leaves into their parent. Returns true if the node is a leaf afterwards.
+        static bool tryMerge(std::vector<Node>& nodes, std::vector<uint32_t>* free_blocks, uint32_t index)
+        {
+            const uint32_t first = nodes[index].children;
+            const uint8_t state = nodes[first].state;
+            if (state == kMixed)
+                return false;
+            for (uint32_t i = 1; i < 8; ++i) {
+                if (nodes[first + i].state != state)
+                    return false;
+            }
+            nodes[index].state = state;
+            nodes[index].children = 0;
+            if (free_blocks)
+                free_blocks->push_back(first);
+            else if (first + 8 == nodes.size())
+                nodes.resize(first); //subtree builds append, so the merged children are the last nodes
+            return true;
+        }
+
+        void buildNode(std::vector<Node>& nodes, const OverlapFunction& overlap, uint32_t index, const Vector3r& center, real_T half_size, uint32_t level) const
+        {
+            if (!overlap(center, Vector3r::Constant(half_size))) {
+                nodes[index].state = kFree;
+                return;
+            }
+            if (level == depth_) {
+                nodes[index].state = kOccupied;
+                return;
+            }
+
+            const uint32_t first = allocateChildren(nodes, nullptr, kFree);
+            nodes[index].children = first;
+            nodes[index].state = kMixed;
+            const real_T child_half_size = half_size * 0.5f;
+            for (uint32_t octant = 0; octant < 8; ++octant)
+                buildNode(nodes, overlap, first + octant, getChildCenter(center, child_half_size, octant), child_half_size, level + 1);
+            tryMerge(nodes, nullptr, index);
+        }
+
+        void splitTop(const OverlapFunction& overlap, uint32_t index, const Vector3r& center, real_T half_size, uint32_t level, uint32_t task_level, std::vector<Task>& tasks)
+        {
+            if (level == task_level) {
+                tasks.push_back(Task{ index, center, half_size, level });
+                return;
+            }
+            if (!overlap(center, Vector3r::Constant(half_size))) {
+                storage_[index].state = kFree;
+                return;
+            }
+
+            const uint32_t first = allocateChildren(storage_, nullptr, kFree);
+            storage_[index].children = first;
+            storage_[index].state = kMixed;
+            const real_T child_half_size = half_size * 0.5f;
+            for (uint32_t octant = 0; octant < 8; ++octant)
+                splitTop(overlap, first + octant, getChildCenter(center, child_half_size, octant), child_half_size, level + 1, task_level, tasks);
+        }
+
+        void mergeTop(uint32_t index, uint32_t level, uint32_t task_level)
+        {
+            if (level >= task_level || storage_[index].state != kMixed)
+                return;
+            const uint32_t first = storage_[index].children;
+            for (uint32_t octant = 0; octant < 8; ++octant)
+                mergeTop(first + octant, level + 1, task_level);
+            tryMerge(storage_, &free_blocks_, index);
+        }
+
+        void updateNode(const OverlapFunction& overlap, uint32_t index, const Vector3r& center, real_T half_size, uint32_t level, const Vector3r& min, const Vector3r& max)
+        {
+            if (!intersects(center, half_size, min, max))
+                return;
+
+            //the test covers the whole node, which is correct because the world outside [min, max] did not change
+            if (!overlap(center, Vector3r::Constant(half_size))) {
+                releaseChildren(index);
+                storage_[index].state = kFree;
+                return;
+            }
+            if (level == depth_) {
+                storage_[index].state = kOccupied;
+                return;
+            }
+
+            //a leaf is split into children with its state, the parts outside [min, max] keep it
+            if (storage_[index].state != kMixed) {
+                const uint32_t first = allocateChildren(storage_, &free_blocks_, storage_[index].state);
+                storage_[index].children = first;
+                storage_[index].state = kMixed;
+            }
+
+            const uint32_t first = storage_[index].children;
+            const real_T child_half_size = half_size * 0.5f;
+            for (uint32_t octant = 0; octant < 8; ++octant)
+                updateNode(overlap, first + octant, getChildCenter(center, child_half_size, octant), child_half_size, level + 1, min, max);
+            tryMerge(storage_, &free_blocks_, index);
+        }
+
+        bool castRayNode(uint32_t index, const Vector3r& center, real_T half_size, const Vector3r& origin, const Vector3r& inverse_direction,
+                         real_T t_begin, real_T t_end, real_T& hit_t) const
+        {
+            //slab test of the node box against the segment [t_begin, t_end]
+            real_T t_min = t_begin, t_max = t_end;
+            for (int axis = 0; axis < 3; ++axis) {
+                real_T t0 = (center[axis] - half_size - origin[axis]) * inverse_direction[axis];
+                real_T t1 = (center[axis] + half_size - origin[axis]) * inverse_direction[axis];
+                if (std::isnan(t0) || std::isnan(t1)) {
+                    //parallel to the slab, inside or outside for the whole segment
+                    if (origin[axis] < center[axis] - half_size || origin[axis] > center[axis] + half_size)
+                        return false;
+                    continue;
+                }
+                if (t0 > t1)
+                    std::swap(t0, t1);
+                t_min = std::max(t_min, t0);
+                t_max = std::min(t_max, t1);
+                if (t_min > t_max)
+                    return false;
+            }
+
+            const Node& node = nodes_[index];
+            if (node.state == kFree)
+                return false;
+            if (node.state == kOccupied) {
+                hit_t = t_min;
+                return true;
+            }
+
+            //children front to back, the first hit is the nearest
+            const real_T child_half_size = half_size * 0.5f;
+            std::pair<real_T, uint32_t> order[8];
+            for (uint32_t octant = 0; octant < 8; ++octant) {
+                const Vector3r child_center = getChildCenter(center, child_half_size, octant);
+                real_T entry = t_min;
+                for (int axis = 0; axis < 3; ++axis) {
+                    if (std::isinf(inverse_direction[axis]))
+                        continue;
+                    const real_T t0 = (child_center[axis] - child_half_size - origin[axis]) * inverse_direction[axis];
+                    const real_T t1 = (child_center[axis] + child_half_size - origin[axis]) * inverse_direction[axis];
+                    entry = std::max(entry, std::min(t0, t1));
+                }
+                order[octant] = std::make_pair(entry, octant);
+            }
+            std::sort(order, order + 8);
+            for (const auto& child : order) {
+                if (castRayNode(node.children + child.second, getChildCenter(center, child_half_size, child.second), child_half_size,
+                                origin, inverse_direction, t_min, t_max, hit_t))
+                    return true;
+            }
+            return false;
+        }
+
+        void collectOccupied(uint32_t index, const Vector3r& center, real_T half_size, const Vector3r& min, const Vector3r& max, std::vector<Cell>& cells) const
+        {
+            if (!intersects(center, half_size, min, max))
+                return;
+
+            const Node& node = nodes_[index];
+            if (node.state == kOccupied)
+                cells.push_back(Cell{ center, half_size * 2 });
+            else if (node.state == kMixed) {
+                const real_T child_half_size = half_size * 0.5f;
+                for (uint32_t octant = 0; octant < 8; ++octant)
+                    collectOccupied(node.children + octant, getChildCenter(center, child_half_size, octant), child_half_size, min, max, cells);
+            }
+        }
+
+        // Copies the subtree below index into nodes, skipping released blocks
+        void compact(uint32_t index, std::vector<Node>& nodes, uint32_t compact_index) const
+        {
+            const Node& node = nodes_[index];
+            if (node.state != kMixed)
+                return;
+
+            const uint32_t first = static_cast<uint32_t>(nodes.size());
+            nodes[compact_index].children = first;
+            for (uint32_t octant = 0; octant < 8; ++octant)
+                nodes.push_back(nodes_[node.children + octant]);
+            for (uint32_t octant = 0; octant < 8; ++octant)
+                compact(node.children + octant, nodes, first + octant);
+        }
+
+    private:
+        Vector3r center_ = Vector3r::Zero();
+        real_T half_size_ = 0;
+        uint32_t depth_ = 0;
+
+        // nodes_ points into storage_, or into mapping_ for an opened file
+        const Node* nodes_ = nullptr;
+        size_t node_count_ = 0;
+        std::vector<Node> storage_;
+        std::vector<uint32_t> free_blocks_;
+        MappedFile mapping_;
+    };
+}
+} //namespace
+#endif
@@ -0,0 +1,88 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#ifndef msr_airlib_SpscQueue_hpp
+#define msr_airlib_SpscQueue_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace msr
+{
+namespace airlib
+{
+
+    // Bounded lock-free queue for exactly one producer and one consumer thread. Slots are allocated once by the
+    // constructor and reused, so push and pop never allocate and never block, push fails when the queue is full.
+    template <typename T>
+    class SpscQueue
+    {
+    public:
+        // capacity is rounded up to a power of two
+        explicit SpscQueue(size_t capacity)
+        {
+            size_t size = 1;
+            while (size < capacity)
+                size <<= 1;
+            slots_.resize(size);
+            mask_ = size - 1;
+        }
+
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        // Producer only. fill(T&) writes the value into its slot, which avoids a copy of large values.
+        template <typename TFill>
+        bool pushWith(TFill&& fill)
+        {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - head_.load(std::memory_order_acquire) > mask_)
+                return false;
+            fill(slots_[tail & mask_]);
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool push(const T& value)
+        {
+            return pushWith([&value](T& slot) { slot = value; });
+        }
+
+        // Consumer only
+        bool pop(T& value)
+        {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            if (head == tail_.load(std::memory_order_acquire))
+                return false;
+            value = slots_[head & mask_];
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Exact on the producer and consumer thread, a snapshot anywhere else
+        size_t size() const
+        {
+            const size_t head = head_.load(std::memory_order_acquire);
+            return tail_.load(std::memory_order_acquire) - head;
+        }
+
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        size_t capacity() const
+        {
+            return slots_.size();
+        }
+
+    private:
+        std::vector<T> slots_;
+        size_t mask_ = 0;
+        //on separate cache lines, the consumer writes head_ and the producer writes tail_
+        alignas(64) std::atomic<size_t> head_{ 0 };
+        alignas(64) std::atomic<size_t> tail_{ 0 };
+    };
+}
+} //namespace
+#endif
@@ -0,0 +1,202 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#ifndef msr_airlib_VoxelGridBuilder_hpp
+#define msr_airlib_VoxelGridBuilder_hpp
+
+#include "common/Common.hpp"
+#include <atomic>
+#include <functional>
+#include <ostream>
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Builds an occupancy grid from box overlap queries without testing every cell. The grid is processed in bands
+    of kBlockSize cells along y, every band is split into blocks of kBlockSize^3 cells that are refined as an octree:
+    a box is only split into its 8 children when the overlap query for the whole box reports geometry. Because a
+    box contains all of its children the result is identical to testing every cell, but empty space costs one
+    query per block instead of one per cell.
+
+    Cells are indexed x fastest, then z, then y (the layout of the binvox files written by simCreateVoxelGrid), so
+    finished bands can be streamed out and only one band is held in memory.
+
+    The overlap function is called concurrently when a parallel function is set and must be thread safe.
+    */
+    class VoxelGridBuilder
+    {
+    public:
+        static constexpr int kBlockSize = 32;
+
+        // center and half extent of an axis aligned box in the grid frame (meters, grid center at the origin)
+        typedef std::function<bool(const Vector3r& center, const Vector3r& half_extent)> OverlapFunction;
+        // runs body(0) .. body(count - 1), possibly in parallel
+        typedef std::function<void(int count, const std::function<void(int)>& body)> ParallelFunction;
+        // fraction of the grid done and overlap queries issued so far, called after every band
+        typedef std::function<void(float fraction, uint64_t overlap_tests)> ProgressFunction;
+        // cells of the bands [y_begin, y_end) in grid order, one byte per cell (0 free, 1 occupied)
+        typedef std::function<void(const uint8_t* cells, int y_begin, int y_end)> BandFunction;
+
+        struct Stats
+        {
+            uint64_t overlap_tests = 0;
+            uint64_t occupied_cells = 0;
+        };
+
+    public:
+        VoxelGridBuilder(int ncells_x, int ncells_y, int ncells_z, float resolution)
+            : ncells_x_(std::max(0, ncells_x)), ncells_y_(std::max(0, ncells_y)), ncells_z_(std::max(0, ncells_z)), resolution_(resolution)
+        {
+        }
+
+        void setParallel(const ParallelFunction& parallel)
+        {
+            parallel_ = parallel;
+        }
+
+        void setProgress(const ProgressFunction& progress)
+        {
+            progress_ = progress;
+        }
+
+        // Center of a cell in the grid frame, the same convention as the original per cell loop
+        Vector3r getCellCenter(int x, int y, int z) const
+        {
+            return Vector3r((x - ncells_x_ / 2) * resolution_, (y - ncells_y_ / 2) * resolution_, (z - ncells_z_ / 2) * resolution_);
+        }
+
+        Stats build(const OverlapFunction& overlap, const BandFunction& band_function) const
+        {
+            Stats stats;
+            std::atomic<uint64_t> overlap_tests{ 0 };
+            std::atomic<uint64_t> occupied_cells{ 0 };
+
+            const int blocks_x = (ncells_x_ + kBlockSize - 1) / kBlockSize;
+            const int blocks_z = (ncells_z_ + kBlockSize - 1) / kBlockSize;
+            std::vector<uint8_t> band;
+
+            for (int y_begin = 0; y_begin < ncells_y_; y_begin += kBlockSize) {
+                const int y_end = std::min(ncells_y_, y_begin + kBlockSize);
+                band.assign(static_cast<size_t>(ncells_x_) * ncells_z_ * (y_end - y_begin), 0);
+
+                //one query for the whole band first, open space above and below a scene is skipped in one go
+                ++overlap_tests;
+                if (overlapBox(overlap, 0, ncells_x_, y_begin, y_end, 0, ncells_z_)) {
+                    auto body = [&](int block) {
+                        const int x_begin = (block % blocks_x) * kBlockSize;
+                        const int z_begin = (block / blocks_x) * kBlockSize;
+                        BlockContext context{ overlap, band.data(), y_begin, 0, 0 };
+                        refine(context, x_begin, std::min(ncells_x_, x_begin + kBlockSize), y_begin, y_end, z_begin, std::min(ncells_z_, z_begin + kBlockSize));
+                        overlap_tests += context.overlap_tests;
+                        occupied_cells += context.occupied_cells;
+                    };
+
+                    if (parallel_)
+                        parallel_(blocks_x * blocks_z, body);
+                    else {
+                        for (int block = 0; block < blocks_x * blocks_z; ++block)
+                            body(block);
+                    }
+                }
+
+                band_function(band.data(), y_begin, y_end);
+                if (progress_)
+                    progress_(static_cast<float>(y_end) / ncells_y_, overlap_tests.load());
+            }
+
+            stats.overlap_tests = overlap_tests.load();
+            stats.occupied_cells = occupied_cells.load();
+            return stats;
+        }
+
+        // Streams the grid as run length encoded binvox, runs are written as soon as a band is done
+        Stats writeBinvox(std::ostream& output, const OverlapFunction& overlap, float x_size, float y_size, float z_size) const
+        {
+            output << "#binvox 1\n";
+            output << "dim " << ncells_x_ << " " << ncells_z_ << " " << ncells_y_ << "\n";
+            output << "translate " << -x_size * 0.5 << " " << -y_size * 0.5 << " " << -z_size * 0.5 << "\n";
+            output << "scale " << x_size << "\n";
+            output << "data\n";
+
+            //each pair of bytes is (run value, run length), runs are at most 255 long
+            uint8_t run_value = 0;
+            unsigned int run_length = 0;
+            const Stats stats = build(overlap, [&](const uint8_t* cells, int y_begin, int y_end) {
+                const size_t count = static_cast<size_t>(ncells_x_) * ncells_z_ * (y_end - y_begin);
+                for (size_t i = 0; i < count; ++i) {
+                    if (cells[i] != run_value || run_length == 255) {
+                        if (run_length > 0) {
+                            output << static_cast<char>(run_value);
+                            output << static_cast<char>(run_length);
+                        }
+                        run_value = cells[i];
+                        run_length = 0;
+                    }
+                    ++run_length;
+                }
+            });
+            if (run_length > 0) {
+                output << static_cast<char>(run_value);
+                output << static_cast<char>(run_length);
+            }
+            return stats;
+        }
+
+    private:
+        struct BlockContext
+        {
+            const OverlapFunction& overlap;
+            uint8_t* band;
+            int y_begin;
+            uint64_t overlap_tests;
+            uint64_t occupied_cells;
+        };
+
+        bool overlapBox(const OverlapFunction& overlap, int x_begin, int x_end, int y_begin, int y_end, int z_begin, int z_end) const
+        {
+            //the box spans from the low face of the first cell to the high face of the last one
+            const Vector3r low = getCellCenter(x_begin, y_begin, z_begin);
+            const Vector3r high = getCellCenter(x_end - 1, y_end - 1, z_end - 1);
+            return overlap((low + high) * 0.5f, (high - low) * 0.5f + Vector3r::Constant(resolution_ * 0.5f));
+        }
+
+        void refine(BlockContext& context, int x_begin, int x_end, int y_begin, int y_end, int z_begin, int z_end) const
+        {
+            ++context.overlap_tests;
+            if (!overlapBox(context.overlap, x_begin, x_end, y_begin, y_end, z_begin, z_end))
+                return;
+
+            if (x_end - x_begin == 1 && y_end - y_begin == 1 && z_end - z_begin == 1) {
+                context.band[x_begin + static_cast<size_t>(ncells_x_) * (z_begin + static_cast<size_t>(ncells_z_) * (y_begin - context.y_begin))] = 1;
+                ++context.occupied_cells;
+                return;
+            }
+
+            //split every axis that is longer than one cell
+            const int x_mid = x_end - x_begin > 1 ? (x_begin + x_end) / 2 : x_end;
+            const int y_mid = y_end - y_begin > 1 ? (y_begin + y_end) / 2 : y_end;
+            const int z_mid = z_end - z_begin > 1 ? (z_begin + z_end) / 2 : z_end;
+            const int xs[3] = { x_begin, x_mid, x_end };
+            const int ys[3] = { y_begin, y_mid, y_end };
+            const int zs[3] = { z_begin, z_mid, z_end };
+            for (int ix = 0; ix < 2; ++ix) {
+                for (int iy = 0; iy < 2; ++iy) {
+                    for (int iz = 0; iz < 2; ++iz) {
+                        if (xs[ix] < xs[ix + 1] && ys[iy] < ys[iy + 1] && zs[iz] < zs[iz + 1])
+                            refine(context, xs[ix], xs[ix + 1], ys[iy], ys[iy + 1], zs[iz], zs[iz + 1]);
+                    }
+                }
+            }
+        }
+
+    private:
+        int ncells_x_, ncells_y_, ncells_z_;
+        float resolution_;
+        ParallelFunction parallel_;
+        ProgressFunction progress_;
+    };
+}
+} //namespace
+#endif
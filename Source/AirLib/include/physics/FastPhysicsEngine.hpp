@@ -22,6 +22,42 @@ namespace airlib
     class FastPhysicsEngine : public PhysicsEngineBase
     {
     public:
+        enum class Integrator
+        {
+            //velocity Verlet using the accelerations of the previous step, the original scheme
+            Verlet,
+            SemiImplicitEuler,
+            RK4,
+            //RK4 with step doubling, the sub-step shrinks and grows to keep the local error within tolerance
+            Adaptive
+        };
+
+        struct IntegratorParams
+        {
+            Integrator integrator = Integrator::Verlet;
+            //longest sub-step in seconds, a physics tick is split in to equal sub-steps no longer than this,
+            //0 integrates each physics tick in a single step (Adaptive then starts from the full tick)
+            TTimeDelta max_sub_step = 0;
+            //Adaptive only: allowed local error per sub-step in m, m/s and rad/s
+            real_T tolerance = 1E-3f;
+            //Adaptive only: sub-steps are never shorter than this, even if tolerance is not met
+            TTimeDelta min_sub_step = 1E-4;
+        };
+
+        static Integrator toIntegrator(const std::string& name)
+        {
+            if (name == "" || name == "Verlet")
+                return Integrator::Verlet;
+            else if (name == "SemiImplicitEuler")
+                return Integrator::SemiImplicitEuler;
+            else if (name == "RK4")
+                return Integrator::RK4;
+            else if (name == "Adaptive")
+                return Integrator::Adaptive;
+            else
+                throw std::invalid_argument(Utils::stringf("Integrator '%s' is not recognized", name.c_str()));
+        }
+
         FastPhysicsEngine(bool enable_ground_lock = true, Vector3r wind = Vector3r::Zero(), Vector3r ext_force = Vector3r::Zero())
             : enable_ground_lock_(enable_ground_lock), wind_(wind), ext_force_(ext_force)
         {
@@ -75,10 +111,16 @@ namespace airlib
             ext_force_ = ext_force;
         }
 
+        void setIntegratorParams(const IntegratorParams& integrator_params)
+        {
+            integrator_params_ = integrator_params;
+        }
+
     private:
         void initPhysicsBody(PhysicsBody* body_ptr)
         {
             body_ptr->last_kinematics_time = clock()->nowNanos();
+            body_ptr->integrator_step_hint = 0;
         }
 
         void updatePhysics(PhysicsBody& body)
@@ -93,7 +135,7 @@ namespace airlib
 
             //first compute the response as if there was no collision
             //this is necessary to take in to account forces and torques generated by body
-            getNextKinematicsNoCollision(dt, body, current, next, next_wrench, wind_, ext_force_);
+            getNextKinematicsNoCollision(dt, body, current, next, next_wrench, wind_, ext_force_, integrator_params_);
 
             //if there is collision, see if we need collision response
             const CollisionInfo collision_info = body.getCollisionInfo();
@@ -331,7 +373,53 @@ namespace airlib
         }
 
         static void getNextKinematicsNoCollision(TTimeDelta dt, PhysicsBody& body, const Kinematics::State& current,
-                                                 Kinematics::State& next, Wrench& next_wrench, const Vector3r& wind, const Vector3r& ext_force)
+                                                 Kinematics::State& next, Wrench& next_wrench, const Vector3r& wind, const Vector3r& ext_force,
+                                                 const IntegratorParams& params)
+        {
+            //grounded bodies are held by the ground lock, there is nothing to integrate
+            if (body.isGrounded() || dt <= 0) {
+                getNextKinematicsVerlet(dt, body, current, next, next_wrench, wind, ext_force);
+                return;
+            }
+
+            if (params.integrator == Integrator::Adaptive) {
+                integrateAdaptive(dt, body, current, next, wind, ext_force, params);
+            }
+            else {
+                uint sub_steps = 1;
+                if (params.max_sub_step > 0)
+                    sub_steps = static_cast<uint>(std::ceil(dt / params.max_sub_step - 1E-9));
+                const TTimeDelta h = dt / sub_steps;
+
+                Kinematics::State state = current;
+                for (uint i = 0; i < sub_steps; ++i) {
+                    switch (params.integrator) {
+                    case Integrator::Verlet:
+                        getNextKinematicsVerlet(h, body, state, next, next_wrench, wind, ext_force);
+                        break;
+                    case Integrator::SemiImplicitEuler:
+                        stepSemiImplicitEuler(static_cast<real_T>(h), body, state, next, wind, ext_force);
+                        break;
+                    default:
+                        stepRK4(static_cast<real_T>(h), body, state, next, wind, ext_force);
+                        break;
+                    }
+                    state = next;
+                }
+
+                //Verlet carries its accelerations and wrench from one step to the next
+                if (params.integrator == Integrator::Verlet)
+                    return;
+            }
+
+            //accelerations and wrench at the end of the tick, for sensors and the collision response
+            getAccelerations(body, next.pose.orientation, next.twist.linear, next.twist.angular, wind, ext_force,
+                             next_wrench, next.accelerations.linear, next.accelerations.angular);
+            clampVelocities(next);
+        }
+
+        static void getNextKinematicsVerlet(TTimeDelta dt, PhysicsBody& body, const Kinematics::State& current,
+                                            Kinematics::State& next, Wrench& next_wrench, const Vector3r& wind, const Vector3r& ext_force)
         {
             const real_T dt_real = static_cast<real_T>(dt);
 
@@ -400,19 +488,7 @@ namespace airlib
                 next.twist.linear = current.twist.linear + (current.accelerations.linear + next.accelerations.linear) * (0.5f * dt_real);
                 next.twist.angular = current.twist.angular + (current.accelerations.angular + next.accelerations.angular) * (0.5f * dt_real);
 
-                //if controller has bug, velocities can increase idenfinitely
-                //so we need to clip this or everything will turn in to infinity/nans
-
-                if (next.twist.linear.squaredNorm() > EarthUtils::SpeedOfLight * EarthUtils::SpeedOfLight) { //speed of light
-                    next.twist.linear /= (next.twist.linear.norm() / EarthUtils::SpeedOfLight);
-                    next.accelerations.linear = Vector3r::Zero();
-                }
-                //
-                //for disc of 1m radius which angular velocity translates to speed of light on tangent?
-                if (next.twist.angular.squaredNorm() > EarthUtils::SpeedOfLight * EarthUtils::SpeedOfLight) { //speed of light
-                    next.twist.angular /= (next.twist.angular.norm() / EarthUtils::SpeedOfLight);
-                    next.accelerations.angular = Vector3r::Zero();
-                }
+                clampVelocities(next);
             }
 
             computeNextPose(dt, current.pose, avg_linear, avg_angular, next);
@@ -421,6 +497,151 @@ namespace airlib
             //Utils::log(Utils::stringf("N-POS %s %f: ", VectorMath::toString(next.pose.position).c_str(), dt));
         }
 
+        static void clampVelocities(Kinematics::State& next)
+        {
+            //if controller has bug, velocities can increase idenfinitely
+            //so we need to clip this or everything will turn in to infinity/nans
+
+            if (next.twist.linear.squaredNorm() > EarthUtils::SpeedOfLight * EarthUtils::SpeedOfLight) { //speed of light
+                next.twist.linear /= (next.twist.linear.norm() / EarthUtils::SpeedOfLight);
+                next.accelerations.linear = Vector3r::Zero();
+            }
+            //
+            //for disc of 1m radius which angular velocity translates to speed of light on tangent?
+            if (next.twist.angular.squaredNorm() > EarthUtils::SpeedOfLight * EarthUtils::SpeedOfLight) { //speed of light
+                next.twist.angular /= (next.twist.angular.norm() / EarthUtils::SpeedOfLight);
+                next.accelerations.angular = Vector3r::Zero();
+            }
+        }
+
+        //linear acceleration in world frame and angular acceleration in body frame for the given state,
+        //the vertex wrenches are held constant over the physics tick
+        static void getAccelerations(const PhysicsBody& body, const Quaternionr& orientation, const Vector3r& linear_vel,
+                                     const Vector3r& angular_vel, const Vector3r& wind, const Vector3r& ext_force,
+                                     Wrench& wrench, Vector3r& linear_acc, Vector3r& angular_acc)
+        {
+            wrench = getBodyWrench(body, orientation) + getDragWrench(body, orientation, linear_vel, angular_vel, wind);
+            wrench.force += ext_force;
+
+            linear_acc = (wrench.force / body.getMass()) + body.getEnvironment().getState().gravity;
+
+            //Euler's rotation equation
+            const Vector3r angular_momentum = body.getInertia() * angular_vel;
+            angular_acc = body.getInertiaInv() * (wrench.torque - angular_vel.cross(angular_momentum));
+        }
+
+        static void stepSemiImplicitEuler(real_T h, const PhysicsBody& body, const Kinematics::State& current, Kinematics::State& next,
+                                          const Vector3r& wind, const Vector3r& ext_force)
+        {
+            Wrench wrench;
+            Vector3r linear_acc, angular_acc;
+            getAccelerations(body, current.pose.orientation, current.twist.linear, current.twist.angular, wind, ext_force,
+                             wrench, linear_acc, angular_acc);
+
+            //velocities first, then the pose with the new velocities
+            next.twist.linear = current.twist.linear + linear_acc * h;
+            next.twist.angular = current.twist.angular + angular_acc * h;
+            computeNextPose(h, current.pose, next.twist.linear, next.twist.angular, next);
+            next.accelerations.linear = linear_acc;
+            next.accelerations.angular = angular_acc;
+        }
+
+        //rate of change of orientation q for angular velocity w in body frame, q' = q * (0, w) / 2
+        static Quaternionr getOrientationRate(const Quaternionr& orientation, const Vector3r& angular_vel)
+        {
+            Quaternionr rate = orientation * Quaternionr(0, angular_vel.x(), angular_vel.y(), angular_vel.z());
+            rate.coeffs() *= 0.5f;
+            return rate;
+        }
+
+        static void stepRK4(real_T h, const PhysicsBody& body, const Kinematics::State& current, Kinematics::State& next,
+                            const Vector3r& wind, const Vector3r& ext_force)
+        {
+            //the quaternion is integrated as a 4-vector and re-normalized at every stage
+            Vector3r k_pos[4], k_lin[4], k_ang[4];
+            Quaternionr k_rot[4];
+            Wrench wrench;
+
+            Vector3r position = current.pose.position;
+            Quaternionr orientation = current.pose.orientation;
+            Vector3r linear = current.twist.linear;
+            Vector3r angular = current.twist.angular;
+
+            static constexpr real_T kStageOffsets[4] = { 0, 0.5f, 0.5f, 1 };
+            for (uint stage = 0; stage < 4; ++stage) {
+                if (stage > 0) {
+                    const real_T c = kStageOffsets[stage] * h;
+                    position = current.pose.position + k_pos[stage - 1] * c;
+                    orientation.coeffs() = current.pose.orientation.coeffs() + k_rot[stage - 1].coeffs() * c;
+                    orientation.normalize();
+                    linear = current.twist.linear + k_lin[stage - 1] * c;
+                    angular = current.twist.angular + k_ang[stage - 1] * c;
+                }
+
+                getAccelerations(body, orientation, linear, angular, wind, ext_force, wrench, k_lin[stage], k_ang[stage]);
+                k_pos[stage] = linear;
+                k_rot[stage] = getOrientationRate(orientation, angular);
+            }
+
+            const real_T w = h / 6;
+            next.pose.position = current.pose.position + (k_pos[0] + 2.0f * k_pos[1] + 2.0f * k_pos[2] + k_pos[3]) * w;
+            next.pose.orientation.coeffs() = current.pose.orientation.coeffs() +
+                                             (k_rot[0].coeffs() + 2.0f * k_rot[1].coeffs() + 2.0f * k_rot[2].coeffs() + k_rot[3].coeffs()) * w;
+            next.pose.orientation.normalize();
+            next.twist.linear = current.twist.linear + (k_lin[0] + 2.0f * k_lin[1] + 2.0f * k_lin[2] + k_lin[3]) * w;
+            next.twist.angular = current.twist.angular + (k_ang[0] + 2.0f * k_ang[1] + 2.0f * k_ang[2] + k_ang[3]) * w;
+            next.accelerations.linear = k_lin[0];
+            next.accelerations.angular = k_ang[0];
+        }
+
+        //largest difference between two states relative to tolerance, <= 1 means within tolerance
+        static real_T getScaledError(const Kinematics::State& a, const Kinematics::State& b, real_T tolerance)
+        {
+            real_T error = (a.pose.position - b.pose.position).cwiseAbs().maxCoeff();
+            error = std::max(error, (a.twist.linear - b.twist.linear).cwiseAbs().maxCoeff());
+            error = std::max(error, (a.twist.angular - b.twist.angular).cwiseAbs().maxCoeff());
+            //q and -q are the same orientation
+            error = std::max(error, 2 * std::min((a.pose.orientation.coeffs() - b.pose.orientation.coeffs()).cwiseAbs().maxCoeff(),
+                                                 (a.pose.orientation.coeffs() + b.pose.orientation.coeffs()).cwiseAbs().maxCoeff()));
+            return error / tolerance;
+        }
+
+        static void integrateAdaptive(TTimeDelta dt, PhysicsBody& body, const Kinematics::State& current, Kinematics::State& next,
+                                      const Vector3r& wind, const Vector3r& ext_force, const IntegratorParams& params)
+        {
+            const TTimeDelta max_step = params.max_sub_step > 0 ? std::min(params.max_sub_step, dt) : dt;
+            const TTimeDelta min_step = std::min(params.min_sub_step, max_step);
+            TTimeDelta h = body.integrator_step_hint > 0 ? Utils::clip(body.integrator_step_hint, min_step, max_step) : max_step;
+
+            Kinematics::State state = current;
+            Kinematics::State full, half;
+            TTimeDelta remaining = dt;
+            while (remaining > 0) {
+                //do not leave a sliver at the end of the tick
+                const bool is_last = h >= remaining * 0.999;
+                const TTimeDelta step = is_last ? remaining : h;
+                const real_T step_real = static_cast<real_T>(step);
+
+                //one full step against two half steps, the difference estimates the error of the half steps
+                stepRK4(step_real, body, state, full, wind, ext_force);
+                stepRK4(step_real * 0.5f, body, state, half, wind, ext_force);
+                stepRK4(step_real * 0.5f, body, half, next, wind, ext_force);
+                const real_T error = getScaledError(full, next, params.tolerance);
+
+                if (error <= 1 || step <= min_step) {
+                    state = next;
+                    remaining = is_last ? 0 : remaining - step;
+                }
+
+                //RK4 local error is O(h^5)
+                const real_T factor = error > 0 ? 0.9f * std::pow(error, -0.2f) : 5.0f;
+                if (!is_last || error > 1)
+                    h = Utils::clip(step * Utils::clip(factor, 0.2f, 5.0f), min_step, max_step);
+            }
+            next = state;
+            body.integrator_step_hint = h;
+        }
+
         static void computeNextPose(TTimeDelta dt, const Pose& current_pose, const Vector3r& avg_linear, const Vector3r& avg_angular, Kinematics::State& next)
         {
             real_T dt_real = static_cast<real_T>(dt);
@@ -472,6 +693,7 @@ namespace airlib
         TTimePoint last_message_time;
         Vector3r wind_;
         Vector3r ext_force_;
+        IntegratorParams integrator_params_;
     };
 }
 } //namespace
@@ -248,6 +248,8 @@ namespace airlib
     public:
         //for use in physics engine: //TODO: use getter/setter or friend method?
         TTimePoint last_kinematics_time;
+        //sub-step the adaptive integrator starts the next physics tick with, 0 if not known yet
+        TTimeDelta integrator_step_hint = 0;
 
     private:
         real_T mass_, mass_inv_;
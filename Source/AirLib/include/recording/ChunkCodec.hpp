@@ -0,0 +1,181 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#ifndef msr_airlib_ChunkCodec_hpp
+#define msr_airlib_ChunkCodec_hpp
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace msr
+{
+namespace airlib
+{
+
+    // Block compression for recording chunks. The Lz codec is a small LZ77 variant in the style of LZ4
+    // (token with literal and match length nibbles, 16 bit offsets, greedy matching on a 4 byte hash) that has no
+    // external dependency, so the reader builds anywhere AirLib builds. It favours speed over ratio: pose and
+    // sensor records compress well, already compressed PNG payloads pass through at almost no cost.
+    class ChunkCodec
+    {
+    public:
+        enum class Type : uint8_t
+        {
+            None = 0,
+            Lz = 1
+        };
+
+        //largest raw chunk a reader accepts, far above the writer's default chunk size so that chunks grown past it by
+        //a single large record (a full resolution float image) still decode, and low enough that a corrupt header
+        //cannot make the reader allocate gigabytes
+        static constexpr size_t kMaxChunkSize = 256u << 20;
+
+        static void compress(Type type, const uint8_t* src, size_t size, std::vector<uint8_t>& out)
+        {
+            out.clear();
+            if (type == Type::None) {
+                out.assign(src, src + size);
+                return;
+            }
+
+            out.reserve(size + size / 255 + 16);
+            std::vector<uint32_t> table(kHashSize, kNoPosition);
+
+            size_t anchor = 0;
+            size_t pos = 0;
+            while (size >= kMinMatch && pos + kMinMatch <= size) {
+                const uint32_t hash = hash4(src + pos);
+                const uint32_t candidate = table[hash];
+                table[hash] = static_cast<uint32_t>(pos);
+
+                if (candidate == kNoPosition || pos - candidate > kMaxOffset || std::memcmp(src + candidate, src + pos, kMinMatch) != 0) {
+                    ++pos;
+                    continue;
+                }
+
+                size_t match_length = kMinMatch;
+                while (pos + match_length < size && src[candidate + match_length] == src[pos + match_length])
+                    ++match_length;
+
+                writeSequence(src + anchor, pos - anchor, static_cast<uint16_t>(pos - candidate), match_length, out);
+                pos += match_length;
+                anchor = pos;
+            }
+
+            //trailing literals without a match
+            writeSequence(src + anchor, size - anchor, 0, 0, out);
+        }
+
+        static bool decompress(Type type, const uint8_t* src, size_t size, size_t raw_size, std::vector<uint8_t>& out)
+        {
+            out.clear();
+            if (raw_size > kMaxChunkSize)
+                return false;
+            if (type == Type::None) {
+                if (size != raw_size)
+                    return false;
+                out.assign(src, src + size);
+                return true;
+            }
+            if (type != Type::Lz)
+                return false;
+
+            out.reserve(raw_size);
+            size_t pos = 0;
+            bool terminated = false;
+            while (pos < size) {
+                const uint8_t token = src[pos++];
+
+                size_t literal_length = token >> 4;
+                if (!readLength(src, size, pos, literal_length) || literal_length > size - pos || literal_length > raw_size - out.size())
+                    return false;
+                out.insert(out.end(), src + pos, src + pos + literal_length);
+                pos += literal_length;
+
+                if (pos == size) {
+                    terminated = true;
+                    break; //last sequence carries literals only
+                }
+
+                if (pos + 2 > size)
+                    return false;
+                const size_t offset = src[pos] | (src[pos + 1] << 8);
+                pos += 2;
+
+                size_t match_length = token & 0x0F;
+                if (!readLength(src, size, pos, match_length))
+                    return false;
+                match_length += kMinMatch;
+                if (match_length > raw_size - out.size())
+                    return false;
+
+                if (offset == 0 || offset > out.size())
+                    return false;
+                //byte wise so overlapping matches repeat the pattern
+                size_t from = out.size() - offset;
+                for (size_t i = 0; i < match_length; ++i)
+                    out.push_back(out[from + i]);
+            }
+
+            //compress always ends with a literal only sequence, a stream ending on a match was cut short
+            return terminated && out.size() == raw_size;
+        }
+
+    private:
+        static constexpr size_t kMinMatch = 4;
+        static constexpr size_t kMaxOffset = 0xFFFF;
+        static constexpr uint32_t kHashBits = 14;
+        static constexpr uint32_t kHashSize = 1u << kHashBits;
+        static constexpr uint32_t kNoPosition = 0xFFFFFFFF;
+
+        static uint32_t hash4(const uint8_t* p)
+        {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return (value * 2654435761u) >> (32 - kHashBits);
+        }
+
+        static void writeLength(size_t length, std::vector<uint8_t>& out)
+        {
+            while (length >= 255) {
+                out.push_back(255);
+                length -= 255;
+            }
+            out.push_back(static_cast<uint8_t>(length));
+        }
+
+        static bool readLength(const uint8_t* src, size_t size, size_t& pos, size_t& length)
+        {
+            if (length != 15)
+                return true;
+            uint8_t extra;
+            do {
+                if (pos >= size)
+                    return false;
+                extra = src[pos++];
+                length += extra;
+            } while (extra == 255);
+            return true;
+        }
+
+        // match_length 0 writes a literal only sequence, which must be the last one
+        static void writeSequence(const uint8_t* literals, size_t literal_length, uint16_t offset, size_t match_length, std::vector<uint8_t>& out)
+        {
+            const size_t match_code = match_length > 0 ? match_length - kMinMatch : 0;
+            out.push_back(static_cast<uint8_t>((std::min<size_t>(literal_length, 15) << 4) | std::min<size_t>(match_code, 15)));
+            if (literal_length >= 15)
+                writeLength(literal_length - 15, out);
+            out.insert(out.end(), literals, literals + literal_length);
+
+            if (match_length == 0)
+                return;
+            out.push_back(static_cast<uint8_t>(offset & 0xFF));
+            out.push_back(static_cast<uint8_t>(offset >> 8));
+            if (match_code >= 15)
+                writeLength(match_code - 15, out);
+        }
+    };
+}
+} //namespace
+#endif
@@ -0,0 +1,149 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#ifndef msr_airlib_MappedFile_hpp
+#define msr_airlib_MappedFile_hpp
+
+#include "common/Common.hpp"
+
+#ifdef _WIN32
+#include "common/common_utils/WindowsApisCommonPre.hpp"
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include "common/common_utils/WindowsApisCommonPost.hpp"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace msr
+{
+namespace airlib
+{
+
+    // Read only memory mapping of a whole file. Pages are loaded by the OS on first access, so opening a large
+    // recording is cheap and random access (seeking) does not read the skipped parts.
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        ~MappedFile()
+        {
+            close();
+        }
+
+        bool open(const std::string& path)
+        {
+            close();
+
+#ifdef _WIN32
+            file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file_ == INVALID_HANDLE_VALUE)
+                return false;
+
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(file_, &size)) {
+                close();
+                return false;
+            }
+            size_ = static_cast<uint64_t>(size.QuadPart);
+            is_open_ = true;
+            if (size_ == 0)
+                return true;
+
+            mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping_ == nullptr) {
+                close();
+                return false;
+            }
+            data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+#else
+            file_ = ::open(path.c_str(), O_RDONLY);
+            if (file_ < 0)
+                return false;
+
+            struct stat info;
+            if (fstat(file_, &info) != 0) {
+                close();
+                return false;
+            }
+            size_ = static_cast<uint64_t>(info.st_size);
+            is_open_ = true;
+            //mmap does not accept an empty range
+            if (size_ == 0)
+                return true;
+
+            void* data = mmap(nullptr, static_cast<size_t>(size_), PROT_READ, MAP_SHARED, file_, 0);
+            data_ = data == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(data);
+#endif
+            if (data_ == nullptr) {
+                close();
+                return false;
+            }
+            return true;
+        }
+
+        void close()
+        {
+#ifdef _WIN32
+            if (data_)
+                UnmapViewOfFile(data_);
+            if (mapping_)
+                CloseHandle(mapping_);
+            if (file_ != INVALID_HANDLE_VALUE)
+                CloseHandle(file_);
+            mapping_ = nullptr;
+            file_ = INVALID_HANDLE_VALUE;
+#else
+            if (data_)
+                munmap(const_cast<uint8_t*>(data_), static_cast<size_t>(size_));
+            if (file_ >= 0)
+                ::close(file_);
+            file_ = -1;
+#endif
+            data_ = nullptr;
+            size_ = 0;
+            is_open_ = false;
+        }
+
+        bool isOpen() const
+        {
+            return is_open_;
+        }
+
+        const uint8_t* data() const
+        {
+            return data_;
+        }
+
+        uint64_t size() const
+        {
+            return size_;
+        }
+
+        // nullptr if the range is outside the file
+        const uint8_t* at(uint64_t offset, uint64_t size) const
+        {
+            return offset + size <= size_ && offset + size >= offset ? data_ + offset : nullptr;
+        }
+
+    private:
+#ifdef _WIN32
+        HANDLE file_ = INVALID_HANDLE_VALUE;
+        HANDLE mapping_ = nullptr;
+#else
+        int file_ = -1;
+#endif
+        const uint8_t* data_ = nullptr;
+        uint64_t size_ = 0;
+        bool is_open_ = false;
+    };
+}
+} //namespace
+#endif
@@ -0,0 +1,726 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#ifndef msr_airlib_RecordingContainer_hpp
+#define msr_airlib_RecordingContainer_hpp
+
+#include "common/Common.hpp"
+#include "recording/ChunkCodec.hpp"
+#include "recording/MappedFile.hpp"
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Single file container for recordings. Records belong to typed channels and carry a sim time stamp in nanoseconds.
+    Records are collected in chunks that are compressed as a whole and written back to back. The footer indexes
+    every chunk by file offset and time range, so a reader finds the chunk for a given time with a binary search.
+
+        FileHeader | Chunk 0 | Chunk 1 | ... | Footer | Trailer
+
+        Chunk   : ChunkHeader, stored (compressed) payload
+        Payload : repeated { uint16 channel, uint64 time, uint32 size, size bytes }
+        Footer  : channel table, chunk index
+        Trailer : uint64 footer offset, uint32 trailer magic
+
+    All integers are little endian. Channel definitions are also written as records on kDefinitionChannel,
+    so a file that was cut short (no footer) can still be indexed by scanning the chunk headers.
+    */
+    class RecordingContainer
+    {
+    public:
+        enum class ChannelType : uint8_t
+        {
+            TextLine = 0, // one legacy record file line per record, channel metadata holds the header line
+            ImageFile = 1, // file name and encoded image file (png, ppm or pfm) as written by the legacy recorder
+            SensorMessage = 2 // binary sensor output, layout defined by the channel metadata
+        };
+
+        struct Channel
+        {
+            uint16_t id = 0;
+            ChannelType type = ChannelType::SensorMessage;
+            std::string name;
+            std::string metadata;
+        };
+
+        struct ChunkInfo
+        {
+            uint64_t offset = 0;
+            TTimePoint start_time = 0;
+            TTimePoint end_time = 0;
+            uint32_t record_count = 0;
+        };
+
+        struct Record
+        {
+            uint16_t channel = 0;
+            TTimePoint time = 0;
+            std::vector<uint8_t> data;
+        };
+
+        static constexpr uint16_t kDefinitionChannel = 0xFFFF;
+        static constexpr uint32_t kFileMagic = 0x43525341; // "ASRC"
+        static constexpr uint32_t kChunkMagic = 0x4b4e4843; // "CHNK"
+        static constexpr uint32_t kFooterMagic = 0x544f4f46; // "FOOT"
+        static constexpr uint32_t kTrailerMagic = 0x45525341; // "ASRE"
+        static constexpr uint32_t kVersion = 1;
+        static constexpr size_t kFileHeaderSize = 8;
+        static constexpr size_t kChunkHeaderSize = 36;
+        static constexpr size_t kTrailerSize = 12;
+        static constexpr const char* kExtension = ".asrec";
+
+        // little endian serialization helpers shared by writer, reader and converter
+        template <typename T>
+        static void put(std::vector<uint8_t>& out, T value)
+        {
+            for (size_t i = 0; i < sizeof(T); ++i)
+                out.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i)));
+        }
+
+        static void putString(std::vector<uint8_t>& out, const std::string& value)
+        {
+            put<uint32_t>(out, static_cast<uint32_t>(value.size()));
+            out.insert(out.end(), value.begin(), value.end());
+        }
+
+        template <typename T>
+        static bool get(const uint8_t* data, size_t size, size_t& pos, T& value)
+        {
+            if (pos + sizeof(T) > size)
+                return false;
+            uint64_t result = 0;
+            for (size_t i = 0; i < sizeof(T); ++i)
+                result |= static_cast<uint64_t>(data[pos + i]) << (8 * i);
+            value = static_cast<T>(result);
+            pos += sizeof(T);
+            return true;
+        }
+
+        static bool getString(const uint8_t* data, size_t size, size_t& pos, std::string& value)
+        {
+            uint32_t length;
+            if (!get(data, size, pos, length) || pos + length > size)
+                return false;
+            value.assign(reinterpret_cast<const char*>(data + pos), length);
+            pos += length;
+            return true;
+        }
+
+        static void encodeChannel(const Channel& channel, std::vector<uint8_t>& out)
+        {
+            put<uint16_t>(out, channel.id);
+            put<uint8_t>(out, static_cast<uint8_t>(channel.type));
+            putString(out, channel.name);
+            putString(out, channel.metadata);
+        }
+
+        static bool decodeChannel(const uint8_t* data, size_t size, size_t& pos, Channel& channel)
+        {
+            uint8_t type;
+            if (!get(data, size, pos, channel.id) || !get(data, size, pos, type))
+                return false;
+            channel.type = static_cast<ChannelType>(type);
+            return getString(data, size, pos, channel.name) && getString(data, size, pos, channel.metadata);
+        }
+    };
+
+    // Writes a container. Not thread safe, callers serialize access (the recorder writes from its ordered commit step).
+    // With max_file_bytes set the recording rolls over to <path>_1.asrec, <path>_2.asrec, ... and every file is self contained.
+    class RecordingContainerWriter
+    {
+    public:
+        typedef RecordingContainer::Channel Channel;
+        typedef RecordingContainer::ChannelType ChannelType;
+
+        ~RecordingContainerWriter()
+        {
+            close();
+        }
+
+        bool open(const std::string& path, ChunkCodec::Type codec = ChunkCodec::Type::Lz, size_t chunk_bytes = 4 << 20, uint64_t max_file_bytes = 0)
+        {
+            close();
+
+            base_path_ = path;
+            codec_ = codec;
+            chunk_bytes_ = std::max<size_t>(chunk_bytes, 1024);
+            max_file_bytes_ = max_file_bytes;
+            file_index_ = 0;
+            channels_.clear();
+            return openFile();
+        }
+
+        bool isOpen() const
+        {
+            return file_.is_open();
+        }
+
+        uint16_t addChannel(const std::string& name, ChannelType type, const std::string& metadata = "")
+        {
+            Channel channel;
+            channel.id = static_cast<uint16_t>(channels_.size());
+            channel.type = type;
+            channel.name = name;
+            channel.metadata = metadata;
+            channels_.push_back(channel);
+
+            writeDefinition(channel, chunk_start_time_);
+            return channel.id;
+        }
+
+        void write(uint16_t channel, TTimePoint time, const void* data, size_t size)
+        {
+            if (!isOpen())
+                return;
+            //the reader refuses chunks above ChunkCodec::kMaxChunkSize
+            if (size + kRecordHeaderSize > ChunkCodec::kMaxChunkSize) {
+                Utils::log(Utils::stringf("Recording record of %zu bytes on channel %u is too large and is dropped", size, static_cast<unsigned>(channel)), Utils::kLogLevelWarn);
+                return;
+            }
+            if (chunk_.size() + size + kRecordHeaderSize > ChunkCodec::kMaxChunkSize)
+                flushChunk();
+
+            appendRecord(channel, time, static_cast<const uint8_t*>(data), size);
+
+            if (chunk_.size() >= chunk_bytes_) {
+                flushChunk();
+                if (max_file_bytes_ > 0 && static_cast<uint64_t>(file_.tellp()) >= max_file_bytes_)
+                    rollOver();
+            }
+        }
+
+        void write(uint16_t channel, TTimePoint time, const std::vector<uint8_t>& data)
+        {
+            write(channel, time, data.data(), data.size());
+        }
+
+        void write(uint16_t channel, TTimePoint time, const std::string& data)
+        {
+            write(channel, time, data.data(), data.size());
+        }
+
+        const vector<Channel>& getChannels() const
+        {
+            return channels_;
+        }
+
+        const std::string& getPath() const
+        {
+            return path_;
+        }
+
+        void close()
+        {
+            if (!isOpen())
+                return;
+
+            flushChunk();
+            writeFooter();
+            file_.close();
+        }
+
+    private:
+        bool openFile()
+        {
+            path_ = base_path_;
+            if (file_index_ > 0) {
+                const size_t extension = path_.rfind(RecordingContainer::kExtension);
+                const std::string suffix = "_" + std::to_string(file_index_);
+                if (extension != std::string::npos && extension + std::strlen(RecordingContainer::kExtension) == path_.size())
+                    path_.insert(extension, suffix);
+                else
+                    path_ += suffix;
+            }
+
+            file_.open(path_, std::ios::binary | std::ios::trunc);
+            if (!file_.is_open())
+                return false;
+
+            std::vector<uint8_t> header;
+            RecordingContainer::put<uint32_t>(header, RecordingContainer::kFileMagic);
+            RecordingContainer::put<uint32_t>(header, RecordingContainer::kVersion);
+            writeBytes(header);
+
+            chunks_.clear();
+            chunk_.clear();
+            chunk_records_ = 0;
+            chunk_start_time_ = 0;
+            chunk_end_time_ = 0;
+            return true;
+        }
+
+        void rollOver()
+        {
+            writeFooter();
+            file_.close();
+
+            ++file_index_;
+            if (!openFile())
+                return;
+            for (const auto& channel : channels_)
+                writeDefinition(channel, chunk_start_time_);
+        }
+
+        void writeDefinition(const Channel& channel, TTimePoint time)
+        {
+            std::vector<uint8_t> definition;
+            RecordingContainer::encodeChannel(channel, definition);
+            appendRecord(RecordingContainer::kDefinitionChannel, time, definition.data(), definition.size());
+        }
+
+        void appendRecord(uint16_t channel, TTimePoint time, const uint8_t* data, size_t size)
+        {
+            if (channel != RecordingContainer::kDefinitionChannel) {
+                if (chunk_data_records_ == 0 || time < chunk_start_time_)
+                    chunk_start_time_ = time;
+                //keep end times monotonic over the file so the chunk index stays sorted
+                chunk_end_time_ = std::max({ chunk_end_time_, time, last_end_time_ });
+                ++chunk_data_records_;
+            }
+
+            RecordingContainer::put<uint16_t>(chunk_, channel);
+            RecordingContainer::put<uint64_t>(chunk_, time);
+            RecordingContainer::put<uint32_t>(chunk_, static_cast<uint32_t>(size));
+            chunk_.insert(chunk_.end(), data, data + size);
+            ++chunk_records_;
+        }
+
+        void flushChunk()
+        {
+            if (chunk_records_ == 0)
+                return;
+
+            ChunkCodec::Type codec = codec_;
+            ChunkCodec::compress(codec, chunk_.data(), chunk_.size(), stored_);
+            if (codec != ChunkCodec::Type::None && stored_.size() >= chunk_.size()) {
+                //incompressible, typically a chunk of png images
+                codec = ChunkCodec::Type::None;
+                stored_.assign(chunk_.begin(), chunk_.end());
+            }
+
+            RecordingContainer::ChunkInfo info;
+            info.offset = static_cast<uint64_t>(file_.tellp());
+            info.start_time = chunk_start_time_;
+            info.end_time = chunk_end_time_;
+            info.record_count = chunk_records_;
+            chunks_.push_back(info);
+            last_end_time_ = chunk_end_time_;
+
+            std::vector<uint8_t> header;
+            RecordingContainer::put<uint32_t>(header, RecordingContainer::kChunkMagic);
+            RecordingContainer::put<uint8_t>(header, static_cast<uint8_t>(codec));
+            RecordingContainer::put<uint8_t>(header, 0);
+            RecordingContainer::put<uint16_t>(header, 0);
+            RecordingContainer::put<uint32_t>(header, chunk_records_);
+            RecordingContainer::put<uint32_t>(header, static_cast<uint32_t>(chunk_.size()));
+            RecordingContainer::put<uint32_t>(header, static_cast<uint32_t>(stored_.size()));
+            RecordingContainer::put<uint64_t>(header, chunk_start_time_);
+            RecordingContainer::put<uint64_t>(header, chunk_end_time_);
+            writeBytes(header);
+            writeBytes(stored_);
+
+            chunk_.clear();
+            chunk_records_ = 0;
+            chunk_data_records_ = 0;
+            chunk_start_time_ = chunk_end_time_;
+        }
+
+        void writeFooter()
+        {
+            std::vector<uint8_t> footer;
+            const uint64_t footer_offset = static_cast<uint64_t>(file_.tellp());
+
+            RecordingContainer::put<uint32_t>(footer, RecordingContainer::kFooterMagic);
+            RecordingContainer::put<uint32_t>(footer, static_cast<uint32_t>(channels_.size()));
+            for (const auto& channel : channels_)
+                RecordingContainer::encodeChannel(channel, footer);
+
+            RecordingContainer::put<uint32_t>(footer, static_cast<uint32_t>(chunks_.size()));
+            for (const auto& chunk : chunks_) {
+                RecordingContainer::put<uint64_t>(footer, chunk.offset);
+                RecordingContainer::put<uint64_t>(footer, chunk.start_time);
+                RecordingContainer::put<uint64_t>(footer, chunk.end_time);
+                RecordingContainer::put<uint32_t>(footer, chunk.record_count);
+            }
+
+            RecordingContainer::put<uint64_t>(footer, footer_offset);
+            RecordingContainer::put<uint32_t>(footer, RecordingContainer::kTrailerMagic);
+            writeBytes(footer);
+        }
+
+        void writeBytes(const std::vector<uint8_t>& bytes)
+        {
+            file_.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        }
+
+    private:
+        static constexpr size_t kRecordHeaderSize = sizeof(uint16_t) + sizeof(uint64_t) + sizeof(uint32_t);
+
+        std::ofstream file_;
+        std::string base_path_;
+        std::string path_;
+        ChunkCodec::Type codec_ = ChunkCodec::Type::Lz;
+        size_t chunk_bytes_ = 0;
+        uint64_t max_file_bytes_ = 0;
+        uint32_t file_index_ = 0;
+
+        vector<Channel> channels_;
+        vector<RecordingContainer::ChunkInfo> chunks_;
+
+        std::vector<uint8_t> chunk_;
+        std::vector<uint8_t> stored_;
+        uint32_t chunk_records_ = 0;
+        uint32_t chunk_data_records_ = 0;
+        TTimePoint chunk_start_time_ = 0;
+        TTimePoint chunk_end_time_ = 0;
+        TTimePoint last_end_time_ = 0;
+    };
+
+    // Reads a container file through a memory mapping. Opens through the footer, or by scanning the chunks when the
+    // footer is missing.
+    class RecordingContainerReader
+    {
+    public:
+        typedef RecordingContainer::Channel Channel;
+        typedef RecordingContainer::ChunkInfo ChunkInfo;
+        typedef RecordingContainer::Record Record;
+
+        bool open(const std::string& path)
+        {
+            close();
+
+            if (!file_.open(path))
+                return false;
+            file_size_ = file_.size();
+
+            std::vector<uint8_t> header;
+            uint32_t magic = 0, version = 0;
+            size_t pos = 0;
+            if (!readBytes(0, RecordingContainer::kFileHeaderSize, header) ||
+                !RecordingContainer::get(header.data(), header.size(), pos, magic) || magic != RecordingContainer::kFileMagic ||
+                !RecordingContainer::get(header.data(), header.size(), pos, version) || version > RecordingContainer::kVersion) {
+                close();
+                return false;
+            }
+
+            if (!readFooter()) {
+                recovered_ = scanChunks();
+                if (!recovered_) {
+                    close();
+                    return false;
+                }
+            }
+
+            seekChunk(0);
+            return true;
+        }
+
+        void close()
+        {
+            file_.close();
+            file_size_ = 0;
+            channels_.clear();
+            chunks_.clear();
+            records_.clear();
+            chunk_index_ = 0;
+            record_index_ = 0;
+            recovered_ = false;
+        }
+
+        bool isOpen() const
+        {
+            return file_.isOpen();
+        }
+
+        // true if the footer was missing and the index was rebuilt from the chunk headers
+        bool isRecovered() const
+        {
+            return recovered_;
+        }
+
+        const vector<Channel>& getChannels() const
+        {
+            return channels_;
+        }
+
+        // -1 if there is no channel with this name
+        int findChannel(const std::string& name) const
+        {
+            for (const auto& channel : channels_) {
+                if (channel.name == name)
+                    return channel.id;
+            }
+            return -1;
+        }
+
+        const vector<ChunkInfo>& getChunks() const
+        {
+            return chunks_;
+        }
+
+        TTimePoint getStartTime() const
+        {
+            return chunks_.empty() ? 0 : chunks_.front().start_time;
+        }
+
+        TTimePoint getEndTime() const
+        {
+            return chunks_.empty() ? 0 : chunks_.back().end_time;
+        }
+
+        // Decoded payload of one chunk. Uncompressed chunks point into the mapping and buffer stays unused, compressed
+        // chunks are decoded into buffer. data stays valid while the reader is open and buffer is unchanged.
+        bool getChunkPayload(size_t chunk_index, const uint8_t*& data, size_t& size, std::vector<uint8_t>& buffer) const
+        {
+            if (chunk_index >= chunks_.size())
+                return false;
+
+            const uint8_t* header = file_.at(chunks_[chunk_index].offset, RecordingContainer::kChunkHeaderSize);
+            if (header == nullptr)
+                return false;
+
+            uint32_t magic, record_count, raw_size, stored_size;
+            uint8_t codec, reserved8;
+            uint16_t reserved16;
+            size_t pos = 0;
+            if (!RecordingContainer::get(header, RecordingContainer::kChunkHeaderSize, pos, magic) || magic != RecordingContainer::kChunkMagic ||
+                !RecordingContainer::get(header, RecordingContainer::kChunkHeaderSize, pos, codec) || !RecordingContainer::get(header, RecordingContainer::kChunkHeaderSize, pos, reserved8) ||
+                !RecordingContainer::get(header, RecordingContainer::kChunkHeaderSize, pos, reserved16) || !RecordingContainer::get(header, RecordingContainer::kChunkHeaderSize, pos, record_count) ||
+                !RecordingContainer::get(header, RecordingContainer::kChunkHeaderSize, pos, raw_size) || !RecordingContainer::get(header, RecordingContainer::kChunkHeaderSize, pos, stored_size))
+                return false;
+
+            const uint8_t* stored = file_.at(chunks_[chunk_index].offset + RecordingContainer::kChunkHeaderSize, stored_size);
+            if (stored == nullptr)
+                return false;
+
+            if (static_cast<ChunkCodec::Type>(codec) == ChunkCodec::Type::None) {
+                if (stored_size != raw_size)
+                    return false;
+                data = stored;
+                size = stored_size;
+                return true;
+            }
+
+            if (!ChunkCodec::decompress(static_cast<ChunkCodec::Type>(codec), stored, stored_size, raw_size, buffer))
+                return false;
+            data = buffer.data();
+            size = buffer.size();
+            return true;
+        }
+
+        // Calls visitor(channel, time, data, size) for every record of one chunk, including channel definitions,
+        // without copying the record data
+        template <typename TVisitor>
+        bool visitChunk(size_t chunk_index, std::vector<uint8_t>& buffer, TVisitor&& visitor) const
+        {
+            const uint8_t* payload;
+            size_t payload_size;
+            return getChunkPayload(chunk_index, payload, payload_size, buffer) && visitPayload(payload, payload_size, visitor);
+        }
+
+        template <typename TVisitor>
+        static bool visitPayload(const uint8_t* payload, size_t payload_size, TVisitor&& visitor)
+        {
+            size_t pos = 0;
+            while (pos < payload_size) {
+                uint16_t channel;
+                uint64_t time;
+                uint32_t size;
+                if (!RecordingContainer::get(payload, payload_size, pos, channel) ||
+                    !RecordingContainer::get(payload, payload_size, pos, time) ||
+                    !RecordingContainer::get(payload, payload_size, pos, size) || pos + size > payload_size)
+                    return false;
+                visitor(channel, static_cast<TTimePoint>(time), payload + pos, static_cast<size_t>(size));
+                pos += size;
+            }
+            return true;
+        }
+
+        // All records of one chunk, including channel definitions
+        bool readChunk(size_t chunk_index, vector<Record>& records)
+        {
+            records.clear();
+            return visitChunk(chunk_index, raw_, [&records](uint16_t channel, TTimePoint time, const uint8_t* data, size_t size) {
+                records.emplace_back();
+                Record& record = records.back();
+                record.channel = channel;
+                record.time = time;
+                record.data.assign(data, data + size);
+            });
+        }
+
+        // Positions the cursor on the first record at or after time, O(log chunks) plus one chunk decode
+        bool seek(TTimePoint time)
+        {
+            //end times are monotonic over the file, see RecordingContainerWriter::appendRecord
+            const auto it = std::lower_bound(chunks_.begin(), chunks_.end(), time,
+                                             [](const ChunkInfo& chunk, TTimePoint value) { return chunk.end_time < value; });
+            if (!seekChunk(static_cast<size_t>(it - chunks_.begin())))
+                return false;
+
+            while (record_index_ < records_.size() && records_[record_index_].time < time)
+                ++record_index_;
+            return true;
+        }
+
+        // Next data record in file order, channel definitions are skipped
+        bool next(Record& record)
+        {
+            while (true) {
+                while (record_index_ < records_.size()) {
+                    Record& candidate = records_[record_index_++];
+                    if (candidate.channel != RecordingContainer::kDefinitionChannel) {
+                        record = std::move(candidate);
+                        return true;
+                    }
+                }
+
+                if (chunk_index_ + 1 >= chunks_.size() || !seekChunk(chunk_index_ + 1))
+                    return false;
+            }
+        }
+
+    private:
+        bool seekChunk(size_t chunk_index)
+        {
+            chunk_index_ = chunk_index;
+            record_index_ = 0;
+            if (chunk_index >= chunks_.size()) {
+                records_.clear();
+                return false;
+            }
+            return readChunk(chunk_index, records_);
+        }
+
+        bool readFooter()
+        {
+            if (file_size_ < RecordingContainer::kFileHeaderSize + RecordingContainer::kTrailerSize)
+                return false;
+
+            std::vector<uint8_t> trailer;
+            uint64_t footer_offset;
+            uint32_t magic;
+            size_t pos = 0;
+            if (!readBytes(file_size_ - RecordingContainer::kTrailerSize, RecordingContainer::kTrailerSize, trailer) ||
+                !RecordingContainer::get(trailer.data(), trailer.size(), pos, footer_offset) ||
+                !RecordingContainer::get(trailer.data(), trailer.size(), pos, magic) || magic != RecordingContainer::kTrailerMagic ||
+                footer_offset >= file_size_ - RecordingContainer::kTrailerSize)
+                return false;
+
+            std::vector<uint8_t> footer;
+            if (!readBytes(footer_offset, file_size_ - RecordingContainer::kTrailerSize - footer_offset, footer))
+                return false;
+
+            pos = 0;
+            const uint8_t* data = footer.data();
+            uint32_t channel_count, chunk_count;
+            if (!RecordingContainer::get(data, footer.size(), pos, magic) || magic != RecordingContainer::kFooterMagic ||
+                !RecordingContainer::get(data, footer.size(), pos, channel_count))
+                return false;
+
+            vector<Channel> channels(channel_count);
+            for (auto& channel : channels) {
+                if (!RecordingContainer::decodeChannel(data, footer.size(), pos, channel))
+                    return false;
+            }
+
+            if (!RecordingContainer::get(data, footer.size(), pos, chunk_count))
+                return false;
+            vector<ChunkInfo> chunks(chunk_count);
+            for (auto& chunk : chunks) {
+                uint64_t start_time, end_time;
+                if (!RecordingContainer::get(data, footer.size(), pos, chunk.offset) ||
+                    !RecordingContainer::get(data, footer.size(), pos, start_time) ||
+                    !RecordingContainer::get(data, footer.size(), pos, end_time) ||
+                    !RecordingContainer::get(data, footer.size(), pos, chunk.record_count))
+                    return false;
+                chunk.start_time = start_time;
+                chunk.end_time = end_time;
+            }
+
+            channels_ = std::move(channels);
+            chunks_ = std::move(chunks);
+            return true;
+        }
+
+        // Rebuilds the index of a file without footer, the last partially written chunk is ignored
+        bool scanChunks()
+        {
+            uint64_t offset = RecordingContainer::kFileHeaderSize;
+            std::vector<uint8_t> header;
+            while (offset + RecordingContainer::kChunkHeaderSize <= file_size_) {
+                if (!readBytes(offset, RecordingContainer::kChunkHeaderSize, header))
+                    break;
+
+                uint32_t magic, record_count, raw_size, stored_size;
+                uint8_t codec, reserved8;
+                uint16_t reserved16;
+                uint64_t start_time, end_time;
+                size_t pos = 0;
+                const uint8_t* data = header.data();
+                if (!RecordingContainer::get(data, header.size(), pos, magic) || magic != RecordingContainer::kChunkMagic ||
+                    !RecordingContainer::get(data, header.size(), pos, codec) || !RecordingContainer::get(data, header.size(), pos, reserved8) ||
+                    !RecordingContainer::get(data, header.size(), pos, reserved16) || !RecordingContainer::get(data, header.size(), pos, record_count) ||
+                    !RecordingContainer::get(data, header.size(), pos, raw_size) || !RecordingContainer::get(data, header.size(), pos, stored_size) ||
+                    !RecordingContainer::get(data, header.size(), pos, start_time) || !RecordingContainer::get(data, header.size(), pos, end_time))
+                    break;
+                if (offset + RecordingContainer::kChunkHeaderSize + stored_size > file_size_)
+                    break;
+
+                ChunkInfo chunk;
+                chunk.offset = offset;
+                chunk.start_time = start_time;
+                chunk.end_time = end_time;
+                chunk.record_count = record_count;
+                chunks_.push_back(chunk);
+                offset += RecordingContainer::kChunkHeaderSize + stored_size;
+            }
+
+            //channel definitions are records in the chunks
+            vector<Record> records;
+            for (size_t i = 0; i < chunks_.size(); ++i) {
+                if (!readChunk(i, records)) {
+                    chunks_.resize(i);
+                    break;
+                }
+                for (const auto& record : records) {
+                    if (record.channel != RecordingContainer::kDefinitionChannel)
+                        continue;
+                    Channel channel;
+                    size_t pos = 0;
+                    if (RecordingContainer::decodeChannel(record.data.data(), record.data.size(), pos, channel) && channel.id >= channels_.size())
+                        channels_.push_back(channel);
+                }
+            }
+            return !chunks_.empty();
+        }
+
+        bool readBytes(uint64_t offset, uint64_t size, std::vector<uint8_t>& out) const
+        {
+            const uint8_t* data = file_.at(offset, size);
+            if (data == nullptr && size > 0)
+                return false;
+            out.assign(data, data + size);
+            return true;
+        }
+
+    private:
+        MappedFile file_;
+        uint64_t file_size_ = 0;
+        bool recovered_ = false;
+        vector<Channel> channels_;
+        vector<ChunkInfo> chunks_;
+
+        vector<Record> records_;
+        size_t chunk_index_ = 0;
+        size_t record_index_ = 0;
+        std::vector<uint8_t> raw_;
+    };
+}
+} //namespace
+#endif
@@ -0,0 +1,215 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#ifndef msr_airlib_RecordingConverter_hpp
+#define msr_airlib_RecordingConverter_hpp
+
+#include "common/Common.hpp"
+#include "common/ImageCaptureBase.hpp"
+#include "common/common_utils/FileSystem.hpp"
+#include "recording/RecordingContainer.hpp"
+#include <sstream>
+
+namespace msr
+{
+namespace airlib
+{
+
+    // Conversion between the legacy recording layout (airsim_rec.txt plus one file per image in images/) and the
+    // container. The container keeps the legacy record lines on a TextLine channel "pose" with the header line as
+    // metadata, and every image file byte for byte on an ImageFile channel "images", so a round trip is lossless.
+    class RecordingConverter
+    {
+    public:
+        static constexpr const char* kLegacyRecordFile = "airsim_rec.txt";
+        static constexpr const char* kLegacyImageFolder = "images";
+        static constexpr const char* kPoseChannel = "pose";
+        static constexpr const char* kImageChannel = "images";
+
+        // Image file as the legacy recorder writes it (png as captured, ppm or pfm with header)
+        static void encodeImageFile(const ImageCaptureBase::ImageResponse& response, std::vector<uint8_t>& out)
+        {
+            out.clear();
+            if (response.pixels_as_float) {
+                float scalef = Utils::isLittleEndian() ? -1.0f : 1.0f;
+                std::ostringstream header;
+                header << "Pf\n"
+                       << response.width << " " << response.height << "\n"
+                       << scalef << "\n";
+                const std::string header_str = header.str();
+                const size_t pixel_count = static_cast<size_t>(response.width) * response.height;
+                out.reserve(header_str.size() + pixel_count * sizeof(float));
+                out.insert(out.end(), header_str.begin(), header_str.end());
+                const uint8_t* pixels = reinterpret_cast<const uint8_t*>(response.image_data_float.data());
+                out.insert(out.end(), pixels, pixels + pixel_count * sizeof(float));
+            }
+            else if (!response.compress) {
+                std::ostringstream header;
+                header << "P6\n"
+                       << response.width << " " << response.height << "\n"
+                       << "255\n";
+                const std::string header_str = header.str();
+                const size_t pixel_count = static_cast<size_t>(response.width) * response.height;
+                out.resize(header_str.size() + pixel_count * 3);
+                std::copy(header_str.begin(), header_str.end(), out.begin());
+                //image is in BGR, written as RGB
+                uint8_t* dst = out.data() + header_str.size();
+                const uint8_t* src = response.image_data_uint8.data();
+                for (size_t i = 0; i < pixel_count; ++i) {
+                    dst[i * 3] = src[i * 3 + 2];
+                    dst[i * 3 + 1] = src[i * 3 + 1];
+                    dst[i * 3 + 2] = src[i * 3];
+                }
+            }
+            else {
+                out.assign(response.image_data_uint8.begin(), response.image_data_uint8.end());
+            }
+        }
+
+        static void encodeImageRecord(const std::string& file_name, const std::vector<uint8_t>& file_data, std::vector<uint8_t>& out)
+        {
+            out.clear();
+            out.reserve(file_name.size() + file_data.size() + 4);
+            RecordingContainer::putString(out, file_name);
+            out.insert(out.end(), file_data.begin(), file_data.end());
+        }
+
+        static bool decodeImageRecord(const std::vector<uint8_t>& record, std::string& file_name, const uint8_t*& file_data, size_t& file_size)
+        {
+            size_t pos = 0;
+            if (!RecordingContainer::getString(record.data(), record.size(), pos, file_name))
+                return false;
+            file_data = record.data() + pos;
+            file_size = record.size() - pos;
+            return true;
+        }
+
+        // Tab separated columns, empty columns are kept
+        static std::vector<std::string> splitColumns(const std::string& line)
+        {
+            std::vector<std::string> columns;
+            size_t start = 0;
+            while (true) {
+                const size_t end = line.find('\t', start);
+                columns.push_back(line.substr(start, end == std::string::npos ? std::string::npos : end - start));
+                if (end == std::string::npos)
+                    break;
+                start = end + 1;
+            }
+            return columns;
+        }
+
+        static void fromLegacy(const std::string& legacy_folder, const std::string& container_path, ChunkCodec::Type codec = ChunkCodec::Type::Lz)
+        {
+            std::ifstream record_file(common_utils::FileSystem::combine(legacy_folder, kLegacyRecordFile));
+            if (!record_file.is_open())
+                throw std::runtime_error("Cannot open legacy record file in " + legacy_folder);
+
+            std::string header;
+            if (!std::getline(record_file, header))
+                throw std::runtime_error("Legacy record file has no header line");
+            stripCarriageReturn(header);
+
+            const std::vector<std::string> header_columns = splitColumns(header);
+            const int time_column = findColumn(header_columns, "TimeStamp");
+            const int image_column = findColumn(header_columns, "ImageFile");
+            if (time_column < 0)
+                throw std::runtime_error("Legacy record file has no TimeStamp column");
+
+            RecordingContainerWriter writer;
+            if (!writer.open(container_path, codec))
+                throw std::runtime_error("Cannot create container " + container_path);
+            const uint16_t pose_channel = writer.addChannel(kPoseChannel, RecordingContainer::ChannelType::TextLine, header);
+            const uint16_t image_channel = writer.addChannel(kImageChannel, RecordingContainer::ChannelType::ImageFile);
+
+            const std::string image_folder = common_utils::FileSystem::combine(legacy_folder, kLegacyImageFolder);
+            std::string line;
+            std::vector<uint8_t> file_data, record;
+            while (std::getline(record_file, line)) {
+                stripCarriageReturn(line);
+                if (line.empty())
+                    continue;
+
+                const std::vector<std::string> columns = splitColumns(line);
+                //legacy time stamps are in milliseconds
+                const TTimePoint time = time_column < static_cast<int>(columns.size()) ? std::stoull(columns[time_column]) * 1000000ull : 0;
+
+                if (image_column >= 0 && image_column < static_cast<int>(columns.size())) {
+                    for (const auto& image_name : Utils::split(columns[image_column], ";", 1)) {
+                        if (!readFile(common_utils::FileSystem::combine(image_folder, image_name), file_data))
+                            throw std::runtime_error("Missing legacy image file " + image_name);
+                        encodeImageRecord(image_name, file_data, record);
+                        writer.write(image_channel, time, record);
+                    }
+                }
+
+                writer.write(pose_channel, time, line);
+            }
+
+            writer.close();
+        }
+
+        static void toLegacy(const std::string& container_path, const std::string& legacy_folder)
+        {
+            RecordingContainerReader reader;
+            if (!reader.open(container_path))
+                throw std::runtime_error("Cannot open container " + container_path);
+
+            const int pose_channel = reader.findChannel(kPoseChannel);
+            if (pose_channel < 0)
+                throw std::runtime_error("Container has no pose channel");
+
+            common_utils::FileSystem::ensureFolder(legacy_folder);
+            const std::string image_folder = common_utils::FileSystem::ensureFolder(legacy_folder, kLegacyImageFolder);
+
+            std::ofstream record_file(common_utils::FileSystem::combine(legacy_folder, kLegacyRecordFile), std::ios::binary);
+            record_file << reader.getChannels()[pose_channel].metadata << "\n";
+
+            RecordingContainer::Record record;
+            std::string file_name;
+            while (reader.next(record)) {
+                const auto& channel = reader.getChannels()[record.channel];
+                if (channel.id == pose_channel) {
+                    record_file.write(reinterpret_cast<const char*>(record.data.data()), record.data.size());
+                    record_file << "\n";
+                }
+                else if (channel.type == RecordingContainer::ChannelType::ImageFile) {
+                    const uint8_t* file_data;
+                    size_t file_size;
+                    if (!decodeImageRecord(record.data, file_name, file_data, file_size))
+                        throw std::runtime_error("Corrupt image record in " + container_path);
+                    std::ofstream image_file(common_utils::FileSystem::combine(image_folder, file_name), std::ios::binary);
+                    image_file.write(reinterpret_cast<const char*>(file_data), file_size);
+                }
+            }
+        }
+
+    private:
+        static int findColumn(const std::vector<std::string>& columns, const std::string& name)
+        {
+            for (size_t i = 0; i < columns.size(); ++i) {
+                if (columns[i] == name)
+                    return static_cast<int>(i);
+            }
+            return -1;
+        }
+
+        static void stripCarriageReturn(std::string& line)
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+        }
+
+        static bool readFile(const std::string& path, std::vector<uint8_t>& data)
+        {
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            if (!file.is_open())
+                return false;
+            data.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(reinterpret_cast<char*>(data.data()), data.size());
+            return true;
+        }
+    };
+}
+} //namespace
+#endif
@@ -0,0 +1,662 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#ifndef msr_airlib_RecordingReplay_hpp
+#define msr_airlib_RecordingReplay_hpp
+
+#include "common/Common.hpp"
+#include "common/ImageCaptureBase.hpp"
+#include "physics/Kinematics.hpp"
+#include "recording/RecordingContainer.hpp"
+#include "recording/RecordingConverter.hpp"
+#include "recording/SensorMessageCodec.hpp"
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Plays back recording containers. The files are memory mapped and indexed once on open: every record gets an
+    entry with its time stamp and location, nothing else is read until a record is requested. Decoded chunks are
+    kept in a small cache, uncompressed chunks are used straight from the mapping.
+
+    The playhead is in recording time. In TimeScaled mode it follows the wall clock multiplied by the speed, in
+    AsFastAsPossible mode it only moves on advanceFrame() (replayAdvanceFrame over RPC), one recorded frame (pose
+    line) at a time, so a client runs as fast as it can consume the data. Queries return the latest record at or before the playhead, which
+    makes the result depend only on the playhead and not on when or how often the client asks.
+
+    Thread safe, the RPC server calls in from several threads.
+    */
+    class RecordingReplay
+    {
+    public:
+        enum class PlaybackMode
+        {
+            TimeScaled,
+            AsFastAsPossible
+        };
+
+        static constexpr size_t kChunkCacheSize = 8;
+
+    public:
+        // Adds a container to the replay, call for every file of a recording (rolled over files, airsim_sensors.asrec).
+        // Throws std::runtime_error if the file cannot be read.
+        void addFile(const std::string& path)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            std::unique_ptr<RecordingContainerReader> reader(new RecordingContainerReader());
+            if (!reader->open(path))
+                throw std::runtime_error("Cannot open recording " + path);
+
+            const uint32_t file_index = static_cast<uint32_t>(readers_.size());
+            const auto& channels = reader->getChannels();
+
+            //pose lines are parsed up front, they are small and every kinematics query needs two of them
+            std::vector<PoseColumns> pose_columns(channels.size());
+            for (const auto& channel : channels) {
+                if (channel.type == RecordingContainer::ChannelType::TextLine)
+                    pose_columns[channel.id] = PoseColumns(RecordingConverter::splitColumns(channel.metadata));
+            }
+
+            std::vector<uint8_t> buffer;
+            std::string file_name;
+            for (size_t chunk_index = 0; chunk_index < reader->getChunks().size(); ++chunk_index) {
+                const uint8_t* payload;
+                size_t payload_size;
+                if (!reader->getChunkPayload(chunk_index, payload, payload_size, buffer))
+                    throw std::runtime_error("Corrupt chunk in recording " + path);
+
+                const bool visited = RecordingContainerReader::visitPayload(payload, payload_size, [&](uint16_t channel_id, TTimePoint time, const uint8_t* data, size_t size) {
+                    if (channel_id >= channels.size())
+                        return;
+                    const auto& channel = channels[channel_id];
+
+                    Sample sample;
+                    sample.time = time;
+                    sample.file = file_index;
+                    sample.chunk = static_cast<uint32_t>(chunk_index);
+                    sample.offset = static_cast<uint32_t>(data - payload);
+                    sample.size = static_cast<uint32_t>(size);
+
+                    switch (channel.type) {
+                    case RecordingContainer::ChannelType::TextLine:
+                        addPoseLine(pose_columns[channel_id], time, std::string(reinterpret_cast<const char*>(data), size));
+                        break;
+                    case RecordingContainer::ChannelType::ImageFile: {
+                        size_t pos = 0;
+                        if (RecordingContainer::getString(data, size, pos, file_name))
+                            images_[getImageKey(file_name)].push_back(sample);
+                        break;
+                    }
+                    case RecordingContainer::ChannelType::SensorMessage: {
+                        SensorBase::SensorType sensor_type;
+                        if (!SensorMessageCodec::parseMetadata(channel.metadata, sensor_type))
+                            break;
+                        //channel names are sensors/<vehicle>/<sensor>
+                        const size_t vehicle_end = channel.name.find('/', 8);
+                        if (channel.name.compare(0, 8, "sensors/") != 0 || vehicle_end == std::string::npos)
+                            break;
+                        SensorStream& stream = sensors_[channel.name.substr(8)];
+                        stream.vehicle_name = channel.name.substr(8, vehicle_end - 8);
+                        stream.sensor_name = channel.name.substr(vehicle_end + 1);
+                        stream.sensor_type = sensor_type;
+                        stream.samples.push_back(sample);
+                        break;
+                    }
+                    }
+                });
+                if (!visited)
+                    throw std::runtime_error("Corrupt chunk in recording " + path);
+            }
+
+            readers_.push_back(std::move(reader));
+
+            //files of one recording may interleave in time
+            auto by_time = [](const Sample& a, const Sample& b) { return a.time < b.time; };
+            for (auto& image : images_)
+                std::stable_sort(image.second.begin(), image.second.end(), by_time);
+            for (auto& sensor : sensors_)
+                std::stable_sort(sensor.second.samples.begin(), sensor.second.samples.end(), by_time);
+            for (auto& poses : poses_)
+                std::stable_sort(poses.second.begin(), poses.second.end(), [](const PoseSample& a, const PoseSample& b) { return a.time < b.time; });
+
+            updateRange();
+        }
+
+        TTimePoint getStartTime() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return start_time_;
+        }
+
+        TTimePoint getEndTime() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return end_time_;
+        }
+
+        std::vector<std::string> getVehicleNames() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::vector<std::string> names;
+            for (const auto& poses : poses_)
+                names.push_back(poses.first);
+            for (const auto& sensor : sensors_) {
+                if (std::find(names.begin(), names.end(), sensor.second.vehicle_name) == names.end())
+                    names.push_back(sensor.second.vehicle_name);
+            }
+            return names;
+        }
+
+        /************************* playback control *************************/
+
+        // speed is the ratio of recording time to wall time in TimeScaled mode, 10 plays ten times faster than recorded
+        void setPlayback(PlaybackMode mode, double speed = 1)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            TTimePoint playhead = getPlayheadLocked();
+            mode_ = mode;
+            speed_ = std::max(0.0, speed);
+            if (mode_ == PlaybackMode::AsFastAsPossible && !frames_.empty()) {
+                frame_index_ = findFrame(playhead);
+                playhead = frames_[frame_index_];
+            }
+            anchor(playhead);
+        }
+
+        void setLoop(bool loop)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const TTimePoint playhead = getPlayheadLocked();
+            loop_ = loop;
+            anchor(playhead);
+        }
+
+        void setPaused(bool paused)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const TTimePoint playhead = getPlayheadLocked();
+            paused_ = paused;
+            anchor(playhead);
+        }
+
+        // Moves the playhead to a recording time, clamped to the recording
+        void seek(TTimePoint time)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            time = clampTime(time);
+            frame_index_ = findFrame(time);
+            if (mode_ == PlaybackMode::AsFastAsPossible && !frames_.empty())
+                time = frames_[frame_index_];
+            anchor(time);
+        }
+
+        // Seconds from the start of the recording
+        void seekRelative(TTimeDelta seconds)
+        {
+            seek(getStartTime() + static_cast<TTimePoint>(std::max(0.0, seconds) * 1E9));
+        }
+
+        // AsFastAsPossible mode: moves the playhead to the next frame. Returns false at the end of a recording
+        // without looping, the playhead then stays on the last frame.
+        bool advanceFrame()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (mode_ != PlaybackMode::AsFastAsPossible || paused_ || frames_.empty())
+                return false;
+
+            //the first request gets the frame the playhead was put on
+            if (!frame_served_) {
+                frame_served_ = true;
+                return true;
+            }
+
+            if (frame_index_ + 1 < frames_.size())
+                ++frame_index_;
+            else if (loop_)
+                frame_index_ = 0;
+            else
+                return false;
+
+            anchor(frames_[frame_index_]);
+            frame_served_ = true;
+            return true;
+        }
+
+        TTimePoint getPlayhead() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return getPlayheadLocked();
+        }
+
+        /************************* data *************************/
+
+        // Kinematics interpolated from the recorded poses. Velocities and accelerations are finite differences.
+        bool getKinematics(const std::string& vehicle_name, Kinematics::State& state) const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto it = poses_.find(vehicle_name);
+            if (it == poses_.end() || it->second.empty())
+                return false;
+
+            const auto& poses = it->second;
+            const TTimePoint playhead = getPlayheadLocked();
+            state = Kinematics::State::zero();
+
+            if (poses.size() == 1) {
+                state.pose = poses[0].pose;
+                return true;
+            }
+
+            //interpolate between the enclosing poses so the kinematics are smooth at any playback speed
+            const size_t next = std::min(findLatest(poses, playhead) + 1, poses.size() - 1);
+            const size_t prev = next - 1;
+            const real_T span = static_cast<real_T>((poses[next].time - poses[prev].time) * 1E-9);
+            const real_T alpha = span > 0 ? static_cast<real_T>(std::min<double>(1.0, std::max<double>(0.0, (static_cast<double>(playhead) - poses[prev].time) * 1E-9 / span))) : 1;
+            state.pose.position = poses[prev].pose.position + alpha * (poses[next].pose.position - poses[prev].pose.position);
+            state.pose.orientation = poses[prev].pose.orientation.slerp(alpha, poses[next].pose.orientation);
+
+            if (span > 0) {
+                state.twist.linear = (poses[next].pose.position - poses[prev].pose.position) / span;
+                //body frame angular velocity from the relative rotation
+                const Eigen::AngleAxis<real_T> delta(poses[prev].pose.orientation.conjugate() * poses[next].pose.orientation);
+                state.twist.angular = delta.axis() * (delta.angle() / span);
+
+                if (prev > 0) {
+                    const real_T prev_span = static_cast<real_T>((poses[prev].time - poses[prev - 1].time) * 1E-9);
+                    if (prev_span > 0) {
+                        const Vector3r prev_linear = (poses[prev].pose.position - poses[prev - 1].pose.position) / prev_span;
+                        state.accelerations.linear = (state.twist.linear - prev_linear) / (0.5f * (span + prev_span));
+                    }
+                }
+            }
+            return true;
+        }
+
+        // Recorded sensor output of the given type at the playhead. An empty sensor name selects the first sensor of
+        // that type on the vehicle, as VehicleApiBase does.
+        template <typename TOutput>
+        bool getSensorOutput(const std::string& vehicle_name, const std::string& sensor_name, SensorBase::SensorType sensor_type, TOutput& output) const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const SensorStream* stream = findSensor(vehicle_name, sensor_name, sensor_type);
+            if (stream == nullptr || stream->samples.empty())
+                return false;
+
+            const Sample& sample = stream->samples[findLatest(stream->samples, getPlayheadLocked())];
+            const uint8_t* data = getSampleData(sample);
+            return data != nullptr && SensorMessageCodec::decode(data, sample.size, output);
+        }
+
+        // Recorded images at the playhead. The recorded format is returned whatever pixels_as_float and compress
+        // the request asks for, requests for images that were not recorded get a response with an error message.
+        void getImages(const std::string& vehicle_name, const std::vector<ImageCaptureBase::ImageRequest>& requests,
+                       std::vector<ImageCaptureBase::ImageResponse>& responses) const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const TTimePoint playhead = getPlayheadLocked();
+
+            responses.clear();
+            for (const auto& request : requests) {
+                responses.emplace_back();
+                ImageCaptureBase::ImageResponse& response = responses.back();
+                response.camera_name = request.camera_name;
+                response.image_type = request.image_type;
+                response.annotation_name = request.annotation_name;
+                response.pixels_as_float = request.pixels_as_float;
+                response.compress = request.compress;
+
+                const auto it = images_.find(getImageKey(vehicle_name, request));
+                if (it == images_.end() || it->second.empty()) {
+                    response.message = "Image was not recorded";
+                    continue;
+                }
+
+                const Sample& sample = it->second[findLatest(it->second, playhead)];
+                const uint8_t* data = getSampleData(sample);
+                std::string file_name;
+                size_t pos = 0;
+                if (data == nullptr || !RecordingContainer::getString(data, sample.size, pos, file_name) ||
+                    !decodeImageFile(file_name, data + pos, sample.size - pos, response)) {
+                    response.message = "Corrupt image record";
+                    continue;
+                }
+                response.time_stamp = sample.time;
+
+                //camera mounting is not recorded, the vehicle pose is the closest available
+                const auto poses = poses_.find(vehicle_name);
+                if (poses != poses_.end() && !poses->second.empty()) {
+                    const Pose& pose = poses->second[findLatest(poses->second, sample.time)].pose;
+                    response.camera_position = pose.position;
+                    response.camera_orientation = pose.orientation;
+                }
+            }
+        }
+
+        // Inverse of RecordingConverter::encodeImageFile
+        static bool decodeImageFile(const std::string& file_name, const uint8_t* data, size_t size, ImageCaptureBase::ImageResponse& response)
+        {
+            const std::string extension = file_name.size() >= 4 ? file_name.substr(file_name.size() - 4) : "";
+            if (extension == ".png") {
+                //width and height are the first fields of the IHDR chunk
+                if (size < 24)
+                    return false;
+                response.width = static_cast<int>(readBigEndian(data + 16));
+                response.height = static_cast<int>(readBigEndian(data + 20));
+                response.compress = true;
+                response.pixels_as_float = false;
+                response.image_data_uint8.assign(data, data + size);
+                return true;
+            }
+
+            size_t pos = 0;
+            std::string magic;
+            int width, height;
+            float scale;
+            if (!readHeaderToken(data, size, pos, magic) || !readHeaderToken(data, size, pos, width) ||
+                !readHeaderToken(data, size, pos, height) || !readHeaderToken(data, size, pos, scale) ||
+                width < 0 || height < 0)
+                return false;
+            //a single whitespace character ends the header
+            ++pos;
+
+            const size_t pixel_count = static_cast<size_t>(width) * height;
+            response.width = width;
+            response.height = height;
+            if (magic == "Pf") {
+                if (pos + pixel_count * sizeof(float) > size)
+                    return false;
+                response.pixels_as_float = true;
+                response.compress = false;
+                response.image_data_float.resize(pixel_count);
+                std::memcpy(response.image_data_float.data(), data + pos, pixel_count * sizeof(float));
+                return true;
+            }
+            if (magic == "P6") {
+                if (pos + pixel_count * 3 > size)
+                    return false;
+                response.pixels_as_float = false;
+                response.compress = false;
+                //written as RGB, captured as BGR
+                response.image_data_uint8.resize(pixel_count * 3);
+                const uint8_t* src = data + pos;
+                uint8_t* dst = response.image_data_uint8.data();
+                for (size_t i = 0; i < pixel_count; ++i) {
+                    dst[i * 3] = src[i * 3 + 2];
+                    dst[i * 3 + 1] = src[i * 3 + 1];
+                    dst[i * 3 + 2] = src[i * 3];
+                }
+                return true;
+            }
+            return false;
+        }
+
+    private:
+        struct Sample
+        {
+            TTimePoint time = 0;
+            uint32_t file = 0;
+            uint32_t chunk = 0;
+            uint32_t offset = 0; // in the decoded chunk payload
+            uint32_t size = 0;
+        };
+
+        struct PoseSample
+        {
+            TTimePoint time = 0;
+            Pose pose;
+        };
+
+        struct SensorStream
+        {
+            std::string vehicle_name;
+            std::string sensor_name;
+            SensorBase::SensorType sensor_type = SensorBase::SensorType::Imu;
+            std::vector<Sample> samples;
+        };
+
+        struct CachedChunk
+        {
+            uint32_t file = 0;
+            uint32_t chunk = 0;
+            std::vector<uint8_t> buffer;
+            const uint8_t* data = nullptr;
+            size_t size = 0;
+            uint64_t last_use = 0;
+        };
+
+        // Column indices of the pose fields in the legacy record line, see PawnSimApi::getRecordFileLine
+        struct PoseColumns
+        {
+            int vehicle = -1, x = -1, y = -1, z = -1, qw = -1, qx = -1, qy = -1, qz = -1;
+
+            PoseColumns()
+            {
+            }
+
+            explicit PoseColumns(const std::vector<std::string>& header)
+            {
+                for (int i = 0; i < static_cast<int>(header.size()); ++i) {
+                    const std::string& name = header[i];
+                    int* column = name == "VehicleName" ? &vehicle : name == "POS_X" ? &x : name == "POS_Y" ? &y : name == "POS_Z" ? &z : name == "Q_W" ? &qw : name == "Q_X" ? &qx : name == "Q_Y" ? &qy : name == "Q_Z" ? &qz : nullptr;
+                    if (column)
+                        *column = i;
+                }
+            }
+
+            bool isValid() const
+            {
+                return vehicle >= 0 && x >= 0 && y >= 0 && z >= 0 && qw >= 0 && qx >= 0 && qy >= 0 && qz >= 0;
+            }
+        };
+
+        void addPoseLine(const PoseColumns& columns, TTimePoint time, const std::string& line)
+        {
+            if (!columns.isValid())
+                return;
+
+            const std::vector<std::string> values = RecordingConverter::splitColumns(line);
+            const int last = std::max({ columns.vehicle, columns.x, columns.y, columns.z, columns.qw, columns.qx, columns.qy, columns.qz });
+            if (last >= static_cast<int>(values.size()))
+                return;
+
+            try {
+                PoseSample sample;
+                sample.time = time;
+                sample.pose.position = Vector3r(std::stof(values[columns.x]), std::stof(values[columns.y]), std::stof(values[columns.z]));
+                sample.pose.orientation = Quaternionr(std::stof(values[columns.qw]), std::stof(values[columns.qx]), std::stof(values[columns.qy]), std::stof(values[columns.qz]));
+                poses_[values[columns.vehicle]].push_back(sample);
+            }
+            catch (const std::exception&) {
+                //malformed lines are skipped
+            }
+        }
+
+        // img_<vehicle>_<camera>_<type>[_<annotation>]_<nanos>.<ext> as written by RecordingFile::appendRecord
+        static std::string getImageKey(const std::string& file_name)
+        {
+            const size_t end = file_name.rfind('_');
+            const size_t start = file_name.compare(0, 4, "img_") == 0 ? 4 : 0;
+            return end == std::string::npos || end < start ? file_name : file_name.substr(start, end - start);
+        }
+
+        static std::string getImageKey(const std::string& vehicle_name, const ImageCaptureBase::ImageRequest& request)
+        {
+            std::string key = vehicle_name + "_" + request.camera_name + "_" + std::to_string(common_utils::Utils::toNumeric(request.image_type));
+            if (request.annotation_name != "")
+                key += "_" + request.annotation_name;
+            return key;
+        }
+
+        const SensorStream* findSensor(const std::string& vehicle_name, const std::string& sensor_name, SensorBase::SensorType sensor_type) const
+        {
+            if (sensor_name != "") {
+                const auto it = sensors_.find(vehicle_name + "/" + sensor_name);
+                return it != sensors_.end() && it->second.sensor_type == sensor_type ? &it->second : nullptr;
+            }
+            for (const auto& sensor : sensors_) {
+                if (sensor.second.vehicle_name == vehicle_name && sensor.second.sensor_type == sensor_type)
+                    return &sensor.second;
+            }
+            return nullptr;
+        }
+
+        // Index of the last entry at or before time, the first entry if time is before all of them
+        template <typename T>
+        static size_t findLatest(const std::vector<T>& entries, TTimePoint time)
+        {
+            const auto it = std::upper_bound(entries.begin(), entries.end(), time, [](TTimePoint value, const T& entry) { return value < entry.time; });
+            return it == entries.begin() ? 0 : static_cast<size_t>(it - entries.begin()) - 1;
+        }
+
+        const uint8_t* getSampleData(const Sample& sample) const
+        {
+            CachedChunk* cached = nullptr;
+            for (auto& chunk : chunk_cache_) {
+                if (chunk.file == sample.file && chunk.chunk == sample.chunk) {
+                    cached = &chunk;
+                    break;
+                }
+            }
+
+            if (cached == nullptr) {
+                if (chunk_cache_.size() < kChunkCacheSize)
+                    chunk_cache_.emplace_back();
+                //least recently used slot
+                cached = &*std::min_element(chunk_cache_.begin(), chunk_cache_.end(),
+                                            [](const CachedChunk& a, const CachedChunk& b) { return a.last_use < b.last_use; });
+                cached->file = sample.file;
+                cached->chunk = sample.chunk;
+                cached->data = nullptr;
+                if (!readers_[sample.file]->getChunkPayload(sample.chunk, cached->data, cached->size, cached->buffer)) {
+                    cached->data = nullptr;
+                    cached->last_use = 0;
+                    return nullptr;
+                }
+            }
+
+            cached->last_use = ++cache_clock_;
+            return cached->data != nullptr && sample.offset + static_cast<size_t>(sample.size) <= cached->size ? cached->data + sample.offset : nullptr;
+        }
+
+        void updateRange()
+        {
+            bool first = true;
+            auto include = [&](TTimePoint start, TTimePoint end) {
+                start_time_ = first ? start : std::min(start_time_, start);
+                end_time_ = first ? end : std::max(end_time_, end);
+                first = false;
+            };
+            for (const auto& reader : readers_) {
+                if (!reader->getChunks().empty())
+                    include(reader->getStartTime(), reader->getEndTime());
+            }
+
+            //frames are the pose lines, or the images when a recording has no poses
+            frames_.clear();
+            for (const auto& poses : poses_) {
+                for (const auto& pose : poses.second)
+                    frames_.push_back(pose.time);
+            }
+            if (frames_.empty()) {
+                for (const auto& image : images_) {
+                    for (const auto& sample : image.second)
+                        frames_.push_back(sample.time);
+                }
+            }
+            std::sort(frames_.begin(), frames_.end());
+            frames_.erase(std::unique(frames_.begin(), frames_.end()), frames_.end());
+
+            frame_index_ = 0;
+            frame_served_ = false;
+            anchor(frames_.empty() ? start_time_ : frames_.front());
+        }
+
+        TTimePoint clampTime(TTimePoint time) const
+        {
+            return std::min(std::max(time, start_time_), end_time_);
+        }
+
+        // Last frame at or before time
+        size_t findFrame(TTimePoint time) const
+        {
+            const auto it = std::upper_bound(frames_.begin(), frames_.end(), time);
+            return it == frames_.begin() ? 0 : static_cast<size_t>(it - frames_.begin()) - 1;
+        }
+
+        void anchor(TTimePoint playhead)
+        {
+            anchor_time_ = playhead;
+            anchor_wall_ = std::chrono::steady_clock::now();
+            if (mode_ == PlaybackMode::AsFastAsPossible)
+                frame_served_ = false;
+        }
+
+        TTimePoint getPlayheadLocked() const
+        {
+            if (mode_ == PlaybackMode::AsFastAsPossible || paused_)
+                return anchor_time_;
+
+            const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - anchor_wall_).count() * speed_;
+            const TTimePoint time = anchor_time_ + static_cast<TTimePoint>(elapsed * 1E9);
+            if (time <= end_time_)
+                return time;
+            if (!loop_ || end_time_ <= start_time_)
+                return end_time_;
+            return start_time_ + (time - start_time_) % (end_time_ - start_time_);
+        }
+
+        static uint32_t readBigEndian(const uint8_t* data)
+        {
+            return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+                   (static_cast<uint32_t>(data[2]) << 8) | static_cast<uint32_t>(data[3]);
+        }
+
+        template <typename T>
+        static bool readHeaderToken(const uint8_t* data, size_t size, size_t& pos, T& value)
+        {
+            while (pos < size && std::isspace(data[pos]))
+                ++pos;
+            const size_t start = pos;
+            while (pos < size && !std::isspace(data[pos]))
+                ++pos;
+            if (pos == start)
+                return false;
+            std::istringstream token(std::string(reinterpret_cast<const char*>(data + start), pos - start));
+            token >> value;
+            return !token.fail();
+        }
+
+    private:
+        mutable std::mutex mutex_;
+        std::vector<std::unique_ptr<RecordingContainerReader>> readers_;
+        std::unordered_map<std::string, std::vector<Sample>> images_; // by image key
+        std::unordered_map<std::string, SensorStream> sensors_; // by <vehicle>/<sensor>
+        std::map<std::string, std::vector<PoseSample>> poses_; // by vehicle
+
+        mutable std::vector<CachedChunk> chunk_cache_;
+        mutable uint64_t cache_clock_ = 0;
+
+        TTimePoint start_time_ = 0;
+        TTimePoint end_time_ = 0;
+        std::vector<TTimePoint> frames_;
+        size_t frame_index_ = 0;
+        bool frame_served_ = false;
+
+        PlaybackMode mode_ = PlaybackMode::TimeScaled;
+        double speed_ = 1;
+        bool loop_ = false;
+        bool paused_ = false;
+        TTimePoint anchor_time_ = 0;
+        std::chrono::steady_clock::time_point anchor_wall_;
+    };
+}
+} //namespace
+#endif
@@ -0,0 +1,267 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#ifndef msr_airlib_ReplayApi_hpp
+#define msr_airlib_ReplayApi_hpp
+
+#include "common/Common.hpp"
+#include "api/ApiProvider.hpp"
+#include "api/VehicleApiBase.hpp"
+#include "api/VehicleSimApiBase.hpp"
+#include "recording/RecordingReplay.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    // Serves the images of one vehicle from a replay at the playhead. Image requests never move it, in
+    // AsFastAsPossible mode the client steps with replayAdvanceFrame, so the images of every vehicle come from the
+    // same frame.
+    class ReplayImageCapture : public ImageCaptureBase
+    {
+    public:
+        ReplayImageCapture(RecordingReplay* replay, const std::string& vehicle_name)
+            : replay_(replay), vehicle_name_(vehicle_name)
+        {
+        }
+
+        virtual void getImages(const std::vector<ImageRequest>& requests, std::vector<ImageResponse>& responses) const override
+        {
+            replay_->getImages(vehicle_name_, requests, responses);
+        }
+
+    private:
+        RecordingReplay* replay_;
+        std::string vehicle_name_;
+    };
+
+    // Vehicle API that answers the sensor getters from a replay. Commands are rejected, there is nothing to control.
+    class ReplayVehicleApi : public VehicleApiBase
+    {
+    public:
+        ReplayVehicleApi(RecordingReplay* replay, const std::string& vehicle_name)
+            : replay_(replay), vehicle_name_(vehicle_name)
+        {
+        }
+
+        virtual void enableApiControl(bool is_enabled) override
+        {
+            unused(is_enabled);
+        }
+        virtual bool isApiControlEnabled() const override
+        {
+            return false;
+        }
+        virtual bool armDisarm(bool arm) override
+        {
+            unused(arm);
+            return false;
+        }
+        virtual GeoPoint getHomeGeoPoint() const override
+        {
+            return GeoPoint();
+        }
+
+        virtual const LidarData& getLidarData(const std::string& lidar_name) const override
+        {
+            return getOutput<LidarData>(lidar_name, SensorBase::SensorType::Lidar, "lidar");
+        }
+        virtual GPULidarData getGPULidarData(const std::string& lidar_name) const override
+        {
+            return getOutput<GPULidarData>(lidar_name, SensorBase::SensorType::GPULidar, "GPU lidar");
+        }
+        virtual EchoData getEchoData(const std::string& echo_name) const override
+        {
+            return getOutput<EchoData>(echo_name, SensorBase::SensorType::Echo, "echo");
+        }
+        virtual const ImuBase::Output& getImuData(const std::string& imu_name) const override
+        {
+            return getOutput<ImuBase::Output>(imu_name, SensorBase::SensorType::Imu, "IMU");
+        }
+        virtual const BarometerBase::Output& getBarometerData(const std::string& barometer_name) const override
+        {
+            return getOutput<BarometerBase::Output>(barometer_name, SensorBase::SensorType::Barometer, "barometer");
+        }
+        virtual const MagnetometerBase::Output& getMagnetometerData(const std::string& magnetometer_name) const override
+        {
+            return getOutput<MagnetometerBase::Output>(magnetometer_name, SensorBase::SensorType::Magnetometer, "magnetometer");
+        }
+        virtual const GpsBase::Output& getGpsData(const std::string& gps_name) const override
+        {
+            return getOutput<GpsBase::Output>(gps_name, SensorBase::SensorType::Gps, "gps");
+        }
+        virtual const DistanceSensorData& getDistanceSensorData(const std::string& distance_sensor_name) const override
+        {
+            return getOutput<DistanceSensorData>(distance_sensor_name, SensorBase::SensorType::Distance, "distance sensor");
+        }
+
+    protected:
+        virtual void resetImplementation() override
+        {
+        }
+
+    private:
+        // The getters return references, the RPC server copies the result on the calling thread before the next call
+        template <typename TOutput>
+        const TOutput& getOutput(const std::string& sensor_name, SensorBase::SensorType sensor_type, const char* description) const
+        {
+            thread_local TOutput output;
+            if (!replay_->getSensorOutput(vehicle_name_, sensor_name, sensor_type, output))
+                throw VehicleControllerException(Utils::stringf("No %s with name %s was recorded for vehicle %s", description, sensor_name.c_str(), vehicle_name_.c_str()));
+            return output;
+        }
+
+    private:
+        RecordingReplay* replay_;
+        std::string vehicle_name_;
+    };
+
+    // Vehicle simulation API that answers pose and kinematics from a replay. Setters are not supported.
+    class ReplayVehicleSimApi : public VehicleSimApiBase
+    {
+    public:
+        ReplayVehicleSimApi(RecordingReplay* replay, const std::string& vehicle_name)
+            : replay_(replay), vehicle_name_(vehicle_name), image_capture_(replay, vehicle_name)
+        {
+        }
+
+        virtual const ImageCaptureBase* getImageCapture() const override
+        {
+            return &image_capture_;
+        }
+
+        virtual void initialize() override
+        {
+        }
+
+        virtual bool testLineOfSightToPoint(const GeoPoint& point) const override
+        {
+            unused(point);
+            throw notSupported("testLineOfSightToPoint");
+        }
+
+        virtual Pose getPose() const override
+        {
+            return getGroundTruthKinematics()->pose;
+        }
+        virtual void setPose(const Pose& pose, bool ignore_collision) override
+        {
+            unused(pose);
+            unused(ignore_collision);
+            throw notSupported("setPose");
+        }
+        virtual const Kinematics::State* getGroundTruthKinematics() const override
+        {
+            thread_local Kinematics::State state;
+            if (!replay_->getKinematics(vehicle_name_, state))
+                throw VehicleApiBase::VehicleControllerException("No poses were recorded for vehicle " + vehicle_name_);
+            return &state;
+        }
+        virtual void setKinematics(const Kinematics::State& state, bool ignore_collision) override
+        {
+            unused(state);
+            unused(ignore_collision);
+            throw notSupported("setKinematics");
+        }
+        virtual Kinematics::State getPhysicsRawKinematics() override
+        {
+            return *getGroundTruthKinematics();
+        }
+        virtual void setPhysicsRawKinematics(const Kinematics::State& state) override
+        {
+            unused(state);
+            throw notSupported("setPhysicsRawKinematics");
+        }
+        virtual const msr::airlib::Environment* getGroundTruthEnvironment() const override
+        {
+            throw notSupported("getGroundTruthEnvironment");
+        }
+
+        virtual CameraInfo getCameraInfo(const std::string& camera_name) const override
+        {
+            unused(camera_name);
+            throw notSupported("getCameraInfo");
+        }
+        virtual void setCameraOrientation(const std::string& camera_name, const Quaternionr& orientation) override
+        {
+            unused(camera_name);
+            unused(orientation);
+            throw notSupported("setCameraOrientation");
+        }
+
+        virtual CollisionInfo getCollisionInfo() const override
+        {
+            return CollisionInfo();
+        }
+        virtual CollisionInfo getCollisionInfoAndReset() override
+        {
+            return CollisionInfo();
+        }
+        virtual int getRemoteControlID() const override
+        {
+            return -1;
+        }
+        virtual RCData getRCData() const override
+        {
+            return RCData();
+        }
+        virtual std::string getVehicleName() const override
+        {
+            return vehicle_name_;
+        }
+        virtual std::string getRecordFileLine(bool is_header_line) const override
+        {
+            unused(is_header_line);
+            return "";
+        }
+        virtual void toggleTrace() override
+        {
+        }
+        virtual void setTraceLine(const std::vector<float>& color_rgba, float thickness) override
+        {
+            unused(color_rgba);
+            unused(thickness);
+        }
+
+    protected:
+        virtual void resetImplementation() override
+        {
+        }
+
+    private:
+        static VehicleApiBase::VehicleCommandNotImplementedException notSupported(const std::string& api)
+        {
+            return VehicleApiBase::VehicleCommandNotImplementedException(api + " is not available in a replay");
+        }
+
+    private:
+        RecordingReplay* replay_;
+        std::string vehicle_name_;
+        ReplayImageCapture image_capture_;
+    };
+
+    // Api provider for a replay, with a vehicle and vehicle simulation API for every vehicle in the recording. There
+    // is no world, RpcLibServerBase serves simGetImages from the vehicle image capture in that case.
+    class ReplayApiProvider : public ApiProvider
+    {
+    public:
+        ReplayApiProvider(RecordingReplay* replay)
+            : ApiProvider(nullptr)
+        {
+            const std::vector<std::string> vehicle_names = replay->getVehicleNames();
+            for (const auto& vehicle_name : vehicle_names) {
+                vehicle_apis_.emplace_back(new ReplayVehicleApi(replay, vehicle_name));
+                vehicle_sim_apis_.emplace_back(new ReplayVehicleSimApi(replay, vehicle_name));
+                insert_or_assign(vehicle_name, vehicle_apis_.back().get(), vehicle_sim_apis_.back().get());
+            }
+            if (!vehicle_names.empty())
+                makeDefaultVehicle(vehicle_names.front());
+        }
+
+    private:
+        std::vector<std::unique_ptr<ReplayVehicleApi>> vehicle_apis_;
+        std::vector<std::unique_ptr<ReplayVehicleSimApi>> vehicle_sim_apis_;
+    };
+}
+} //namespace
+#endif
@@ -0,0 +1,32 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#ifndef msr_airlib_ReplayRpcLibClient_hpp
+#define msr_airlib_ReplayRpcLibClient_hpp
+
+#include "common/Common.hpp"
+#include "api/RpcLibClientBase.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    // Client for ReplayRpcLibServer, the regular RpcLibClientBase calls read the replayed data
+    class ReplayRpcLibClient : public RpcLibClientBase
+    {
+    public:
+        ReplayRpcLibClient(const string& ip_address = "localhost", uint16_t port = RpcLibPort, float timeout_sec = 60);
+
+        void replaySetPlayback(bool as_fast_as_possible, double speed = 1);
+        void replaySetLoop(bool loop);
+        void replaySetPaused(bool paused);
+        void replaySeek(double seconds);
+        double replayGetTime();
+        double replayGetDuration();
+        bool replayAdvanceFrame();
+
+        virtual ~ReplayRpcLibClient(); //required for pimpl
+    };
+}
+} //namespace
+#endif
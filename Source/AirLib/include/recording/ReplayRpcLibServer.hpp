@@ -0,0 +1,38 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#ifndef msr_airlib_ReplayRpcLibServer_hpp
+#define msr_airlib_ReplayRpcLibServer_hpp
+
+#ifndef AIRLIB_NO_RPC
+
+#include "common/Common.hpp"
+#include "api/RpcLibServerBase.hpp"
+#include "recording/RecordingReplay.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    // Serves a replay through the regular API (simGetImages, getImuData, getLidarData, simGetGroundTruthKinematics, ...)
+    // and adds the playback controls. Use with a ReplayApiProvider:
+    //
+    //     RecordingReplay replay;
+    //     replay.addFile(path);
+    //     ReplayApiProvider provider(&replay);
+    //     ReplayRpcLibServer server(&replay, &provider, "");
+    //     server.start(true, 4);
+    class ReplayRpcLibServer : public RpcLibServerBase
+    {
+    public:
+        ReplayRpcLibServer(RecordingReplay* replay, ApiProvider* api_provider, string server_address, uint16_t port = RpcLibPort);
+        virtual ~ReplayRpcLibServer();
+
+    private:
+        RecordingReplay* replay_;
+    };
+}
+} //namespace
+
+#endif
+#endif
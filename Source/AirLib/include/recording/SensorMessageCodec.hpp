@@ -0,0 +1,413 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#ifndef msr_airlib_SensorMessageCodec_hpp
+#define msr_airlib_SensorMessageCodec_hpp
+
+#include "common/Common.hpp"
+#include "recording/RecordingContainer.hpp"
+#include "sensors/imu/ImuBase.hpp"
+#include "sensors/gps/GpsBase.hpp"
+#include "sensors/barometer/BarometerBase.hpp"
+#include "sensors/magnetometer/MagnetometerBase.hpp"
+#include "sensors/distance/DistanceBase.hpp"
+#include "sensors/lidar/LidarBase.hpp"
+#include "sensors/lidar/GPULidarBase.hpp"
+#include "sensors/echo/EchoBase.hpp"
+#include "sensors/MarLocUwb/MarLocUwbBase.hpp"
+#include "sensors/wifi/WifiBase.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    // Compact binary encoding of sensor outputs for SensorMessage channels. Fixed size fields are written in order,
+    // arrays as a uint32 count followed by the elements, point clouds as one block copy. Little endian hosts only,
+    // which covers every platform the simulator runs on.
+    class SensorMessageCodec
+    {
+    public:
+        static constexpr uint32_t kVersion = 1;
+
+        // Channel metadata, identifies the decoder
+        static std::string getMetadata(SensorBase::SensorType sensor_type)
+        {
+            return std::string(getTypeName(sensor_type)) + ";" + std::to_string(kVersion);
+        }
+
+        static bool parseMetadata(const std::string& metadata, SensorBase::SensorType& sensor_type)
+        {
+            const std::string type_name = metadata.substr(0, metadata.find(';'));
+            for (uint type = static_cast<uint>(SensorBase::SensorType::Barometer); type <= static_cast<uint>(SensorBase::SensorType::Wifi); ++type) {
+                if (type_name == getTypeName(static_cast<SensorBase::SensorType>(type))) {
+                    sensor_type = static_cast<SensorBase::SensorType>(type);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        static const char* getTypeName(SensorBase::SensorType sensor_type)
+        {
+            switch (sensor_type) {
+            case SensorBase::SensorType::Barometer:
+                return "Barometer";
+            case SensorBase::SensorType::Imu:
+                return "Imu";
+            case SensorBase::SensorType::Gps:
+                return "Gps";
+            case SensorBase::SensorType::Magnetometer:
+                return "Magnetometer";
+            case SensorBase::SensorType::Distance:
+                return "Distance";
+            case SensorBase::SensorType::Lidar:
+                return "Lidar";
+            case SensorBase::SensorType::Echo:
+                return "Echo";
+            case SensorBase::SensorType::GPULidar:
+                return "GPULidar";
+            case SensorBase::SensorType::SensorTemplate:
+                return "SensorTemplate";
+            case SensorBase::SensorType::MarlocUwb:
+                return "MarlocUwb";
+            case SensorBase::SensorType::Wifi:
+                return "Wifi";
+            default:
+                return "Unknown";
+            }
+        }
+
+        // output points to the output type of sensor_type, as passed to ISensorOutputSink. Returns false for unsupported types.
+        // Appends to out.
+        static bool encode(SensorBase::SensorType sensor_type, const void* output, std::vector<uint8_t>& out)
+        {
+            switch (sensor_type) {
+            case SensorBase::SensorType::Imu:
+                encode(*static_cast<const ImuBase::Output*>(output), out);
+                return true;
+            case SensorBase::SensorType::Gps:
+                encode(*static_cast<const GpsBase::Output*>(output), out);
+                return true;
+            case SensorBase::SensorType::Barometer:
+                encode(*static_cast<const BarometerBase::Output*>(output), out);
+                return true;
+            case SensorBase::SensorType::Magnetometer:
+                encode(*static_cast<const MagnetometerBase::Output*>(output), out);
+                return true;
+            case SensorBase::SensorType::Distance:
+                encode(*static_cast<const DistanceSensorData*>(output), out);
+                return true;
+            case SensorBase::SensorType::Lidar:
+                encode(*static_cast<const LidarData*>(output), out);
+                return true;
+            case SensorBase::SensorType::GPULidar:
+                encode(*static_cast<const GPULidarData*>(output), out);
+                return true;
+            case SensorBase::SensorType::Echo:
+                encode(*static_cast<const EchoData*>(output), out);
+                return true;
+            case SensorBase::SensorType::MarlocUwb:
+                encode(*static_cast<const MarLocUwbSensorData*>(output), out);
+                return true;
+            case SensorBase::SensorType::Wifi:
+                encode(*static_cast<const WifiSensorData*>(output), out);
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        static void encode(const ImuBase::Output& output, std::vector<uint8_t>& out)
+        {
+            RecordingContainer::put<uint64_t>(out, output.time_stamp);
+            putQuaternion(out, output.orientation);
+            putVector(out, output.angular_velocity);
+            putVector(out, output.linear_acceleration);
+        }
+
+        static bool decode(const uint8_t* data, size_t size, ImuBase::Output& output)
+        {
+            size_t pos = 0;
+            return getTime(data, size, pos, output.time_stamp) && getQuaternion(data, size, pos, output.orientation) &&
+                   getVector(data, size, pos, output.angular_velocity) && getVector(data, size, pos, output.linear_acceleration);
+        }
+
+        static void encode(const GpsBase::Output& output, std::vector<uint8_t>& out)
+        {
+            RecordingContainer::put<uint64_t>(out, output.time_stamp);
+            putPod(out, output.gnss.geo_point.latitude);
+            putPod(out, output.gnss.geo_point.longitude);
+            putPod(out, output.gnss.geo_point.altitude);
+            putPod(out, output.gnss.eph);
+            putPod(out, output.gnss.epv);
+            putVector(out, output.gnss.velocity);
+            RecordingContainer::put<uint8_t>(out, static_cast<uint8_t>(output.gnss.fix_type));
+            RecordingContainer::put<uint64_t>(out, output.gnss.time_utc);
+            RecordingContainer::put<uint8_t>(out, output.is_valid ? 1 : 0);
+        }
+
+        static bool decode(const uint8_t* data, size_t size, GpsBase::Output& output)
+        {
+            size_t pos = 0;
+            uint8_t fix_type = 0, is_valid = 0;
+            const bool ok = getTime(data, size, pos, output.time_stamp) &&
+                            getPod(data, size, pos, output.gnss.geo_point.latitude) && getPod(data, size, pos, output.gnss.geo_point.longitude) &&
+                            getPod(data, size, pos, output.gnss.geo_point.altitude) && getPod(data, size, pos, output.gnss.eph) &&
+                            getPod(data, size, pos, output.gnss.epv) && getVector(data, size, pos, output.gnss.velocity) &&
+                            RecordingContainer::get(data, size, pos, fix_type) && RecordingContainer::get(data, size, pos, output.gnss.time_utc) &&
+                            RecordingContainer::get(data, size, pos, is_valid);
+            output.gnss.fix_type = static_cast<GpsBase::GnssFixType>(fix_type);
+            output.is_valid = is_valid != 0;
+            return ok;
+        }
+
+        static void encode(const BarometerBase::Output& output, std::vector<uint8_t>& out)
+        {
+            RecordingContainer::put<uint64_t>(out, output.time_stamp);
+            putPod(out, output.altitude);
+            putPod(out, output.pressure);
+            putPod(out, output.qnh);
+        }
+
+        static bool decode(const uint8_t* data, size_t size, BarometerBase::Output& output)
+        {
+            size_t pos = 0;
+            return getTime(data, size, pos, output.time_stamp) && getPod(data, size, pos, output.altitude) &&
+                   getPod(data, size, pos, output.pressure) && getPod(data, size, pos, output.qnh);
+        }
+
+        static void encode(const MagnetometerBase::Output& output, std::vector<uint8_t>& out)
+        {
+            RecordingContainer::put<uint64_t>(out, output.time_stamp);
+            putVector(out, output.magnetic_field_body);
+            putArray(out, output.magnetic_field_covariance);
+        }
+
+        static bool decode(const uint8_t* data, size_t size, MagnetometerBase::Output& output)
+        {
+            size_t pos = 0;
+            return getTime(data, size, pos, output.time_stamp) && getVector(data, size, pos, output.magnetic_field_body) &&
+                   getArray(data, size, pos, output.magnetic_field_covariance);
+        }
+
+        static void encode(const DistanceSensorData& output, std::vector<uint8_t>& out)
+        {
+            RecordingContainer::put<uint64_t>(out, output.time_stamp);
+            putPod(out, output.distance);
+            putPod(out, output.min_distance);
+            putPod(out, output.max_distance);
+            putPose(out, output.relative_pose);
+        }
+
+        static bool decode(const uint8_t* data, size_t size, DistanceSensorData& output)
+        {
+            size_t pos = 0;
+            return getTime(data, size, pos, output.time_stamp) && getPod(data, size, pos, output.distance) &&
+                   getPod(data, size, pos, output.min_distance) && getPod(data, size, pos, output.max_distance) &&
+                   getPose(data, size, pos, output.relative_pose);
+        }
+
+        static void encode(const LidarData& output, std::vector<uint8_t>& out)
+        {
+            RecordingContainer::put<uint64_t>(out, output.time_stamp);
+            putPose(out, output.pose);
+            putArray(out, output.point_cloud);
+            putStrings(out, output.groundtruth);
+        }
+
+        static bool decode(const uint8_t* data, size_t size, LidarData& output)
+        {
+            size_t pos = 0;
+            return getTime(data, size, pos, output.time_stamp) && getPose(data, size, pos, output.pose) &&
+                   getArray(data, size, pos, output.point_cloud) && getStrings(data, size, pos, output.groundtruth);
+        }
+
+        static void encode(const GPULidarData& output, std::vector<uint8_t>& out)
+        {
+            RecordingContainer::put<uint64_t>(out, output.time_stamp);
+            putPose(out, output.pose);
+            putArray(out, output.point_cloud);
+        }
+
+        static bool decode(const uint8_t* data, size_t size, GPULidarData& output)
+        {
+            size_t pos = 0;
+            return getTime(data, size, pos, output.time_stamp) && getPose(data, size, pos, output.pose) &&
+                   getArray(data, size, pos, output.point_cloud);
+        }
+
+        static void encode(const EchoData& output, std::vector<uint8_t>& out)
+        {
+            RecordingContainer::put<uint64_t>(out, output.time_stamp);
+            putPose(out, output.pose);
+            putArray(out, output.point_cloud);
+            putStrings(out, output.groundtruth);
+            putArray(out, output.passive_beacons_point_cloud);
+            putStrings(out, output.passive_beacons_groundtruth);
+        }
+
+        static bool decode(const uint8_t* data, size_t size, EchoData& output)
+        {
+            size_t pos = 0;
+            return getTime(data, size, pos, output.time_stamp) && getPose(data, size, pos, output.pose) &&
+                   getArray(data, size, pos, output.point_cloud) && getStrings(data, size, pos, output.groundtruth) &&
+                   getArray(data, size, pos, output.passive_beacons_point_cloud) && getStrings(data, size, pos, output.passive_beacons_groundtruth);
+        }
+
+        // UWB and Wifi outputs share their layout
+        template <typename TBeaconData>
+        static void encodeBeacons(const TBeaconData& output, std::vector<uint8_t>& out)
+        {
+            RecordingContainer::put<uint64_t>(out, output.time_stamp);
+            putPose(out, output.pose);
+            putStrings(out, output.beaconsActiveID);
+            putArray(out, output.beaconsActiveRssi);
+            putArray(out, output.beaconsActivePosX);
+            putArray(out, output.beaconsActivePosY);
+            putArray(out, output.beaconsActivePosZ);
+            putArray(out, output.beaconsActiveDistance);
+            putArray(out, output.allBeaconsId);
+            putArray(out, output.allBeaconsX);
+            putArray(out, output.allBeaconsY);
+            putArray(out, output.allBeaconsZ);
+        }
+
+        template <typename TBeaconData>
+        static bool decodeBeacons(const uint8_t* data, size_t size, TBeaconData& output)
+        {
+            size_t pos = 0;
+            return getTime(data, size, pos, output.time_stamp) && getPose(data, size, pos, output.pose) &&
+                   getStrings(data, size, pos, output.beaconsActiveID) && getArray(data, size, pos, output.beaconsActiveRssi) &&
+                   getArray(data, size, pos, output.beaconsActivePosX) && getArray(data, size, pos, output.beaconsActivePosY) &&
+                   getArray(data, size, pos, output.beaconsActivePosZ) && getArray(data, size, pos, output.beaconsActiveDistance) &&
+                   getArray(data, size, pos, output.allBeaconsId) && getArray(data, size, pos, output.allBeaconsX) &&
+                   getArray(data, size, pos, output.allBeaconsY) && getArray(data, size, pos, output.allBeaconsZ);
+        }
+
+        static void encode(const MarLocUwbSensorData& output, std::vector<uint8_t>& out)
+        {
+            encodeBeacons(output, out);
+        }
+
+        static bool decode(const uint8_t* data, size_t size, MarLocUwbSensorData& output)
+        {
+            return decodeBeacons(data, size, output);
+        }
+
+        static void encode(const WifiSensorData& output, std::vector<uint8_t>& out)
+        {
+            encodeBeacons(output, out);
+        }
+
+        static bool decode(const uint8_t* data, size_t size, WifiSensorData& output)
+        {
+            return decodeBeacons(data, size, output);
+        }
+
+    private:
+        template <typename T>
+        static void putPod(std::vector<uint8_t>& out, const T& value)
+        {
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+            out.insert(out.end(), bytes, bytes + sizeof(T));
+        }
+
+        template <typename T>
+        static bool getPod(const uint8_t* data, size_t size, size_t& pos, T& value)
+        {
+            if (pos + sizeof(T) > size)
+                return false;
+            std::memcpy(&value, data + pos, sizeof(T));
+            pos += sizeof(T);
+            return true;
+        }
+
+        static bool getTime(const uint8_t* data, size_t size, size_t& pos, TTimePoint& time_stamp)
+        {
+            uint64_t value;
+            if (!RecordingContainer::get(data, size, pos, value))
+                return false;
+            time_stamp = value;
+            return true;
+        }
+
+        static void putVector(std::vector<uint8_t>& out, const Vector3r& value)
+        {
+            putPod(out, value.x());
+            putPod(out, value.y());
+            putPod(out, value.z());
+        }
+
+        static bool getVector(const uint8_t* data, size_t size, size_t& pos, Vector3r& value)
+        {
+            return getPod(data, size, pos, value.x()) && getPod(data, size, pos, value.y()) && getPod(data, size, pos, value.z());
+        }
+
+        static void putQuaternion(std::vector<uint8_t>& out, const Quaternionr& value)
+        {
+            putPod(out, value.w());
+            putPod(out, value.x());
+            putPod(out, value.y());
+            putPod(out, value.z());
+        }
+
+        static bool getQuaternion(const uint8_t* data, size_t size, size_t& pos, Quaternionr& value)
+        {
+            return getPod(data, size, pos, value.w()) && getPod(data, size, pos, value.x()) &&
+                   getPod(data, size, pos, value.y()) && getPod(data, size, pos, value.z());
+        }
+
+        static void putPose(std::vector<uint8_t>& out, const Pose& pose)
+        {
+            putVector(out, pose.position);
+            putQuaternion(out, pose.orientation);
+        }
+
+        static bool getPose(const uint8_t* data, size_t size, size_t& pos, Pose& pose)
+        {
+            return getVector(data, size, pos, pose.position) && getQuaternion(data, size, pos, pose.orientation);
+        }
+
+        template <typename T>
+        static void putArray(std::vector<uint8_t>& out, const vector<T>& values)
+        {
+            RecordingContainer::put<uint32_t>(out, static_cast<uint32_t>(values.size()));
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(values.data());
+            out.insert(out.end(), bytes, bytes + values.size() * sizeof(T));
+        }
+
+        template <typename T>
+        static bool getArray(const uint8_t* data, size_t size, size_t& pos, vector<T>& values)
+        {
+            uint32_t count;
+            if (!RecordingContainer::get(data, size, pos, count) || pos + static_cast<size_t>(count) * sizeof(T) > size)
+                return false;
+            values.resize(count);
+            std::memcpy(values.data(), data + pos, count * sizeof(T));
+            pos += count * sizeof(T);
+            return true;
+        }
+
+        static void putStrings(std::vector<uint8_t>& out, const vector<std::string>& values)
+        {
+            RecordingContainer::put<uint32_t>(out, static_cast<uint32_t>(values.size()));
+            for (const auto& value : values)
+                RecordingContainer::putString(out, value);
+        }
+
+        static bool getStrings(const uint8_t* data, size_t size, size_t& pos, vector<std::string>& values)
+        {
+            uint32_t count;
+            if (!RecordingContainer::get(data, size, pos, count))
+                return false;
+            values.resize(count);
+            for (auto& value : values) {
+                if (!RecordingContainer::getString(data, size, pos, value))
+                    return false;
+            }
+            return true;
+        }
+    };
+}
+} //namespace
+#endif
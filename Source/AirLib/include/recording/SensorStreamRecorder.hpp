@@ -0,0 +1,215 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#ifndef msr_airlib_SensorStreamRecorder_hpp
+#define msr_airlib_SensorStreamRecorder_hpp
+
+#include "common/Common.hpp"
+#include "recording/SensorMessageCodec.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace msr
+{
+namespace airlib
+{
+
+    // Records sensor outputs at the rate the sensors produce them. The recorder attaches itself as output sink,
+    // every new output is encoded on the sensor thread into a buffer of that thread, which is then swapped into the
+    // pending list instead of copied, and a flush thread hands the pending samples to the write function. Buffers
+    // come back to the sensor threads once written, so steady state neither allocates nor copies. Outputs that repeat the previous time stamp of a
+    // sensor are skipped, so sensors that republish their last output every tick are recorded once per sample.
+    // The pending buffer is bounded, samples that do not fit are dropped and counted.
+    class SensorStreamRecorder : public ISensorOutputSink
+    {
+    public:
+        typedef std::function<void(uint16_t channel, TTimePoint time_stamp, const uint8_t* data, size_t size)> WriteFunction;
+
+        struct Stats
+        {
+            uint64_t samples = 0; // encoded and queued
+            uint64_t duplicates = 0; // same time stamp as the previous output of the sensor
+            uint64_t dropped = 0; // pending buffer full
+            uint64_t bytes = 0;
+            double overhead_seconds = 0; // time spent on the sensor threads
+            double max_overhead_seconds = 0;
+        };
+
+        SensorStreamRecorder(size_t max_pending_bytes = 64 << 20, TTimeDelta flush_interval = 0.05)
+            : max_pending_bytes_(max_pending_bytes), flush_interval_(flush_interval)
+        {
+        }
+
+        ~SensorStreamRecorder()
+        {
+            stop();
+        }
+
+        // Register before start()
+        void addSensor(const SensorBase* sensor, SensorBase::SensorType sensor_type, uint16_t channel)
+        {
+            std::unique_ptr<Stream> stream(new Stream());
+            stream->sensor_type = sensor_type;
+            stream->channel = channel;
+            streams_[sensor] = std::move(stream);
+        }
+
+        size_t getSensorCount() const
+        {
+            return streams_.size();
+        }
+
+        void start(const WriteFunction& write_function)
+        {
+            stop();
+
+            write_function_ = write_function;
+            stop_flush_ = false;
+            flush_thread_ = std::thread(&SensorStreamRecorder::flushLoop, this);
+
+            for (const auto& stream : streams_)
+                stream.first->setOutputSink(this);
+        }
+
+        void stop()
+        {
+            //waits for sensor threads still inside onSensorOutput
+            for (const auto& stream : streams_)
+                stream.first->setOutputSink(nullptr);
+
+            if (flush_thread_.joinable()) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    stop_flush_ = true;
+                }
+                flush_signal_.notify_all();
+                flush_thread_.join();
+            }
+        }
+
+        Stats getStats() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return stats_;
+        }
+
+        virtual void onSensorOutput(const SensorBase& sensor, SensorBase::SensorType sensor_type, TTimePoint time_stamp, const void* output) override
+        {
+            const auto start = std::chrono::steady_clock::now();
+
+            const auto it = streams_.find(&sensor);
+            if (it == streams_.end() || it->second->sensor_type != sensor_type)
+                return;
+            Stream& stream = *it->second;
+
+            //only the sensor thread writes its stream, so a republished output is recognized without the lock
+            const bool is_duplicate = stream.last_time_stamp.exchange(time_stamp) == time_stamp;
+
+            //encoding is the expensive part, it goes to a buffer of this thread so other sensors are not held up
+            static thread_local std::vector<uint8_t> encoded;
+            encoded.clear();
+            if (!is_duplicate)
+                SensorMessageCodec::encode(sensor_type, output, encoded);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (is_duplicate) {
+                ++stats_.duplicates;
+            }
+            else if (pending_bytes_ >= max_pending_bytes_) {
+                //lets the next republish of this output try again
+                stream.last_time_stamp = 0;
+                ++stats_.dropped;
+            }
+            else {
+                const size_t size = encoded.size();
+                pending_.emplace_back();
+                PendingSample& sample = pending_.back();
+                sample.channel = stream.channel;
+                sample.time_stamp = time_stamp;
+                sample.data.swap(encoded);
+
+                //the next encode of this thread reuses a written buffer
+                if (!free_buffers_.empty()) {
+                    encoded.swap(free_buffers_.back());
+                    free_buffers_.pop_back();
+                }
+
+                pending_bytes_ += size;
+                ++stats_.samples;
+                stats_.bytes += size;
+            }
+
+            const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            stats_.overhead_seconds += elapsed;
+            stats_.max_overhead_seconds = std::max(stats_.max_overhead_seconds, elapsed);
+        }
+
+    private:
+        struct Stream
+        {
+            SensorBase::SensorType sensor_type;
+            uint16_t channel = 0;
+            std::atomic<TTimePoint> last_time_stamp{ 0 };
+        };
+
+        struct PendingSample
+        {
+            uint16_t channel = 0;
+            TTimePoint time_stamp = 0;
+            std::vector<uint8_t> data;
+        };
+
+        void flushLoop()
+        {
+            const auto interval = std::chrono::duration<double>(flush_interval_);
+            while (true) {
+                bool stopping;
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    flush_signal_.wait_for(lock, interval, [this]() { return stop_flush_; });
+                    stopping = stop_flush_;
+                    //flushing_ is empty here, swapping keeps the capacity of both lists
+                    flushing_.swap(pending_);
+                    pending_bytes_ = 0;
+                }
+
+                for (const PendingSample& sample : flushing_)
+                    write_function_(sample.channel, sample.time_stamp, sample.data.data(), sample.data.size());
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    for (PendingSample& sample : flushing_)
+                        free_buffers_.push_back(std::move(sample.data));
+                    flushing_.clear();
+                }
+
+                if (stopping)
+                    return;
+            }
+        }
+
+    private:
+        std::unordered_map<const SensorBase*, std::unique_ptr<Stream>> streams_;
+        size_t max_pending_bytes_;
+        TTimeDelta flush_interval_;
+        WriteFunction write_function_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable flush_signal_;
+        std::thread flush_thread_;
+        bool stop_flush_ = false;
+
+        std::vector<PendingSample> pending_;
+        std::vector<PendingSample> flushing_;
+        size_t pending_bytes_ = 0;
+        //encode buffers already written, with their capacity
+        std::vector<std::vector<uint8_t>> free_buffers_;
+        Stats stats_;
+    };
+}
+} //namespace
+#endif
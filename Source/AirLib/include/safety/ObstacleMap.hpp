@@ -4,6 +4,7 @@
 #ifndef air_ObstacleMap_hpp
 #define air_ObstacleMap_hpp
 
+#include <atomic>
 #include <mutex>
 #include "common/Common.hpp"
 
@@ -36,61 +37,117 @@ namespace airlib
 
     Another design criteria is that this class is thread safe for concurrent updates and queries.
     We fully expect one thread to continuously update the obstacles while another to query the map.
+    Queries never lock: updates are made on a private copy of the map which is then published as a
+    new snapshot. Queries pin the latest snapshot, so they always see one complete update and never
+    wait for a writer. Three snapshots are kept so that a writer can always fill one that is neither
+    the latest nor pinned, unless readers hold on to both older ones.
+
+    The map can also be split in elevation sectors, so that each tick covers a stack of cones from
+    straight down (sector 0) to straight up. Queries without sectors look at all of them.
 */
 
     class ObstacleMap
     {
-    private:
-        //stores distances for each tick segment
-        vector<float> distances_;
-        //what is the confidence in these values? This should typically be the standard deviation
-        vector<float> confidences_;
-        //number of ticks, this decides reolution
-        int ticks_;
-        //blind spots don't get updated so we get its value from neighbours
-        vector<bool> blindspots_;
-
     public:
         //this will be return result of the queries
         struct ObstacleInfo
         {
-            int tick; //at what tick we found obstacle
-            float distance; //what is the distance from obstacle
-            float confidence;
+            int tick = 0; //at what tick we found obstacle
+            int sector = 0; //at what elevation sector we found obstacle
+            float distance = 0; //what is the distance from obstacle
+            float confidence = 0;
 
             string toString() const
             {
-                return Utils::stringf("Obs: tick=%i, distance=%f, confidence=%f", tick, distance, confidence);
+                return Utils::stringf("Obs: tick=%i, sector=%i, distance=%f, confidence=%f", tick, sector, distance, confidence);
             }
         };
 
-        //private version of hasObstacle doesn't do lock or check inputs
-        ObstacleInfo hasObstacle_(int from_tick, int to_tick) const;
+    private:
+        struct Snapshot
+        {
+            //stores distances for each sector and tick, sector major
+            vector<float> distances;
+            //what is the confidence in these values? This should typically be the standard deviation
+            vector<float> confidences;
+            //closest obstacle over all sectors for each tick, used by queries without sectors
+            vector<float> tick_distances;
+            vector<float> tick_confidences;
+            vector<int> tick_sectors;
+            //blind spots don't get updated so we get its value from neighbours
+            vector<uint8_t> blindspots;
+        };
+
+        //pins the latest snapshot for the lifetime of the reader
+        class SnapshotReader
+        {
+        public:
+            SnapshotReader(const ObstacleMap* map);
+            ~SnapshotReader();
+            const Snapshot& get() const;
+
+        private:
+            const ObstacleMap* map_;
+            int index_;
+        };
 
     private:
+        //handles +/- tick and wraps around circle
         int wrap(int tick) const;
+        int clampSector(int sector) const;
+        //private version of hasObstacle doesn't pin a snapshot or check inputs
+        ObstacleInfo hasObstacle_(const Snapshot& snapshot, int from_tick, int to_tick, int from_sector, int to_sector, bool all_sectors) const;
+        //copies the working map in to a free snapshot and makes it the latest, writer_mutex_ must be held
+        void publish();
 
-        //currently we employ simple thread safe model: just serialize queries and updates
-        std::mutex mutex_;
+    private:
+        //number of ticks, this decides azimuth reolution
+        int ticks_;
+        //number of elevation sectors, this decides elevation resolution
+        int sectors_;
+
+        //map that updates are applied to before they are published
+        Snapshot working_;
+        //serializes writers only, queries never take it
+        std::mutex writer_mutex_;
+        //scratch space for binning point clouds, one column per point
+        Eigen::Matrix<float, 3, Eigen::Dynamic, Eigen::RowMajor> scan_points_;
+        Eigen::Array<float, 1, Eigen::Dynamic> scan_horizontal_, scan_ranges_, scan_angles_;
+        Eigen::Array<int, 1, Eigen::Dynamic> scan_ticks_, scan_bins_;
+
+        static constexpr int kSnapshotCount = 3;
+        Snapshot snapshots_[kSnapshotCount];
+        std::atomic<int> latest_{ 0 };
+        mutable std::atomic<int> readers_[kSnapshotCount];
 
     public:
         //if odd_blindspots = true then set all odd ticks as blind spots
-        ObstacleMap(int ticks, bool odd_blindspots = false);
+        ObstacleMap(int ticks, bool odd_blindspots = false, int sectors = 1);
 
-        //update the map for tick direction within +/-window ticks
+        //update the map for tick direction within +/-window ticks, in all sectors
         void update(float distance, int tick, int window, float confidence);
+        //distances and confidences have one value per tick, in all sectors
         void update(float distances[], float confidences[]);
 
+        //replace the map with one lidar scan. point_cloud holds x, y, z triplets in the frame of the sensor which is
+        //at sensor_pose in the vehicle body frame. The closest return in each tick and sector becomes the new distance,
+        //ticks and sectors without returns are clear up to max_range.
+        void update(const vector<real_T>& point_cloud, const Pose& sensor_pose, float max_range, float confidence);
+
         void setBlindspot(int tick, bool blindspot);
 
         //query if we have obstacle in segment that starts at from to segment that starts at to
-        ObstacleInfo hasObstacle(int from_tick, int to_tick);
+        ObstacleInfo hasObstacle(int from_tick, int to_tick) const;
+        //same as above but only within the sectors from_sector to to_sector
+        ObstacleInfo hasObstacle(int from_tick, int to_tick, int from_sector, int to_sector) const;
 
         //search entire map to find obstacle at minimum distance
-        ObstacleInfo getClosestObstacle();
+        ObstacleInfo getClosestObstacle() const;
 
         //number of ticks the map was initialized with
         int getTicks() const;
+        //number of elevation sectors the map was initialized with
+        int getSectors() const;
         //convert angle (in body frame) in radians to tick number
         int angleToTick(float angle_rad) const;
         //convert tick to start of angle (in body frame) in radians
@@ -99,6 +156,10 @@ namespace airlib
         float tickToAngleEnd(int tick) const;
         //convert tick to mid of the cone in radians
         float tickToAngleMid(int tick) const;
+        //convert elevation (in body frame, up is positive) in radians to sector number
+        int elevationToSector(float elevation_rad) const;
+        //convert sector to mid of its elevation range in radians
+        float sectorToElevationMid(int sector) const;
     };
 }
 } //namespace
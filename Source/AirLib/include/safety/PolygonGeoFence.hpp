@@ -0,0 +1,232 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#ifndef air_PolygonGeoFence_hpp
+#define air_PolygonGeoFence_hpp
+
+#include "common/Common.hpp"
+#include "IGeoFence.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace msr
+{
+namespace airlib
+{
+
+    // Prism geofence: a simple polygon in the NED x-y plane extruded between two NED z values.
+    // The polygon y range is cut into horizontal bands that list the edges spanning them, so a point
+    // query only runs the crossing test over the edges of its band. Edges are kept as flat float arrays
+    // and the crossing test has no branches so compilers vectorize it, which matters for fences with
+    // thousands of vertices.
+    class PolygonGeoFence : public IGeoFence
+    {
+    public:
+        //vertices in order with either winding, the last vertex connects back to the first
+        PolygonGeoFence(const vector<Vector2r>& vertices, float min_z, float max_z, float distance_accuracy = 0.1f)
+            : distance_accuracy_(distance_accuracy)
+        {
+            setPolygon(vertices, min_z, max_z);
+        }
+
+        void setPolygon(const vector<Vector2r>& vertices, float min_z, float max_z)
+        {
+            if (vertices.size() < 3)
+                throw std::invalid_argument(Utils::stringf("PolygonGeoFence needs at least 3 vertices, got %d", static_cast<int>(vertices.size())));
+
+            vertices_ = vertices;
+            min_z_ = std::min(min_z, max_z);
+            max_z_ = std::max(min_z, max_z);
+            buildEdges();
+        }
+
+        //square of 2 * xy_length around origin, same as CubeGeoFence
+        void setBoundry(const Vector3r& origin, float xy_length, float max_z, float min_z) override
+        {
+            vector<Vector2r> vertices{ Vector2r(-xy_length, -xy_length), Vector2r(xy_length, -xy_length),
+                                       Vector2r(xy_length, xy_length), Vector2r(-xy_length, xy_length) };
+            for (auto& vertex : vertices)
+                vertex += origin.head<2>();
+            setPolygon(vertices, min_z, max_z);
+
+            Utils::log(Utils::stringf("PolygonGeoFence: %s", toString().c_str()));
+        }
+
+        void checkFence(const Vector3r& cur_loc, const Vector3r& dest_loc,
+                        bool& in_fence, bool& allow) override
+        {
+            in_fence = contains(dest_loc);
+
+            if (!in_fence) {
+                //are we better off with dest than cur location?
+                allow = distanceOutside(cur_loc) - distanceOutside(dest_loc) >= -distance_accuracy_;
+            }
+            else
+                allow = true;
+        }
+
+        bool contains(const Vector3r& point) const
+        {
+            if (!(point.x() >= box_min_.x() && point.x() <= box_max_.x() && point.y() >= box_min_.y() && point.y() <= box_max_.y() &&
+                  point.z() >= box_min_.z() && point.z() <= box_max_.z()))
+                return false;
+
+            const int band = std::min(static_cast<int>((point.y() - box_min_.y()) * band_scale_), band_count_ - 1);
+            const uint32_t first = band_offsets_[band], last = band_offsets_[band + 1];
+            const float x = point.x(), y = point.y();
+            const float* y0 = band_y0_.data();
+            const float* y1 = band_y1_.data();
+            const float* x0 = band_x0_.data();
+            const float* dxdy = band_dxdy_.data();
+
+            //even-odd rule, horizontal edges were never added so dxdy is finite
+            int crossings = 0;
+            for (uint32_t i = first; i < last; ++i)
+                crossings += ((y0[i] > y) != (y1[i] > y)) & (x < x0[i] + (y - y0[i]) * dxdy[i]);
+            return (crossings & 1) != 0;
+        }
+
+        //distance to the closest point on the prism surface, inside or outside
+        float distanceToBoundary(const Vector3r& point) const
+        {
+            const float horizontal = std::sqrt(squaredDistanceToEdges(point.x(), point.y()));
+            const float below = point.z() - max_z_, above = min_z_ - point.z();
+            if (contains(point))
+                return std::min(horizontal, std::min(-below, -above));
+
+            const bool inside_xy = contains(Vector3r(point.x(), point.y(), (min_z_ + max_z_) / 2));
+            const float vertical = std::max(0.0f, std::max(below, above));
+            return inside_xy ? vertical : std::sqrt(horizontal * horizontal + vertical * vertical);
+        }
+
+        float distanceOutside(const Vector3r& point) const
+        {
+            return contains(point) ? 0.0f : distanceToBoundary(point);
+        }
+
+        const Vector3r& getBoxMin() const
+        {
+            return box_min_;
+        }
+
+        const Vector3r& getBoxMax() const
+        {
+            return box_max_;
+        }
+
+        const vector<Vector2r>& getVertices() const
+        {
+            return vertices_;
+        }
+
+        string toString() const override
+        {
+            return Utils::stringf("vertices=%d, min=%s, max=%s", static_cast<int>(vertices_.size()),
+                                  VectorMath::toString(box_min_).c_str(), VectorMath::toString(box_max_).c_str());
+        }
+
+        virtual ~PolygonGeoFence(){};
+
+    private:
+        void buildEdges()
+        {
+            const size_t count = vertices_.size();
+            box_min_ = Vector3r(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), min_z_);
+            box_max_ = Vector3r(-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), max_z_);
+            for (const auto& vertex : vertices_) {
+                box_min_.head<2>() = box_min_.head<2>().cwiseMin(vertex);
+                box_max_.head<2>() = box_max_.head<2>().cwiseMax(vertex);
+            }
+
+            //all edges for distance queries
+            edge_x0_.resize(count);
+            edge_y0_.resize(count);
+            edge_dx_.resize(count);
+            edge_dy_.resize(count);
+            edge_inv_length2_.resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                const Vector2r& a = vertices_[i];
+                const Vector2r& b = vertices_[(i + 1) % count];
+                edge_x0_[i] = a.x();
+                edge_y0_[i] = a.y();
+                edge_dx_[i] = b.x() - a.x();
+                edge_dy_[i] = b.y() - a.y();
+                const float length2 = edge_dx_[i] * edge_dx_[i] + edge_dy_[i] * edge_dy_[i];
+                edge_inv_length2_[i] = length2 > 0 ? 1 / length2 : 0;
+            }
+
+            //bands as high as the average edge, so an edge lands in about two bands and a query only
+            //sees the edges near its y
+            const float height = box_max_.y() - box_min_.y();
+            float edge_height = 0;
+            for (size_t i = 0; i < count; ++i)
+                edge_height += std::abs(edge_dy_[i]);
+            band_count_ = height > 0 && edge_height > 0 ? std::max(1, std::min(static_cast<int>(count), static_cast<int>(height * count / edge_height))) : 1;
+            band_scale_ = height > 0 ? band_count_ / height : 0;
+
+            //count edges per band, then fill them in band order
+            band_offsets_.assign(band_count_ + 1, 0);
+            for (int pass = 0; pass < 2; ++pass) {
+                vector<uint32_t> fill(band_offsets_.begin(), band_offsets_.end() - 1);
+                for (size_t i = 0; i < count; ++i) {
+                    if (edge_dy_[i] == 0)
+                        continue;
+                    //y1 straight from the vertex so edges sharing it agree exactly on which side y is
+                    const float y1 = vertices_[(i + 1) % count].y();
+                    const float low = std::min(edge_y0_[i], y1), high = std::max(edge_y0_[i], y1);
+                    const int first_band = std::min(static_cast<int>((low - box_min_.y()) * band_scale_), band_count_ - 1);
+                    const int last_band = std::min(static_cast<int>((high - box_min_.y()) * band_scale_), band_count_ - 1);
+                    for (int band = first_band; band <= last_band; ++band) {
+                        if (pass == 0) {
+                            ++band_offsets_[band + 1];
+                            continue;
+                        }
+                        const uint32_t slot = fill[band]++;
+                        band_x0_[slot] = edge_x0_[i];
+                        band_y0_[slot] = edge_y0_[i];
+                        band_y1_[slot] = y1;
+                        band_dxdy_[slot] = edge_dx_[i] / edge_dy_[i];
+                    }
+                }
+                if (pass == 0) {
+                    for (int band = 0; band < band_count_; ++band)
+                        band_offsets_[band + 1] += band_offsets_[band];
+                    const size_t slots = band_offsets_[band_count_];
+                    band_x0_.resize(slots);
+                    band_y0_.resize(slots);
+                    band_y1_.resize(slots);
+                    band_dxdy_.resize(slots);
+                }
+            }
+        }
+
+        float squaredDistanceToEdges(float x, float y) const
+        {
+            float closest = std::numeric_limits<float>::max();
+            for (size_t i = 0; i < edge_x0_.size(); ++i) {
+                const float px = x - edge_x0_[i], py = y - edge_y0_[i];
+                const float t = std::min(1.0f, std::max(0.0f, (px * edge_dx_[i] + py * edge_dy_[i]) * edge_inv_length2_[i]));
+                const float dx = px - t * edge_dx_[i], dy = py - t * edge_dy_[i];
+                closest = std::min(closest, dx * dx + dy * dy);
+            }
+            return closest;
+        }
+
+    private:
+        vector<Vector2r> vertices_;
+        float min_z_, max_z_;
+        float distance_accuracy_;
+        Vector3r box_min_, box_max_;
+
+        //edge i goes from vertex i to vertex i + 1
+        vector<float> edge_x0_, edge_y0_, edge_dx_, edge_dy_, edge_inv_length2_;
+
+        //edges of band b are [band_offsets_[b], band_offsets_[b + 1]), without horizontal edges
+        int band_count_ = 1;
+        float band_scale_ = 0;
+        vector<uint32_t> band_offsets_;
+        vector<float> band_x0_, band_y0_, band_y1_, band_dxdy_;
+    };
+}
+} //namespace
+#endif
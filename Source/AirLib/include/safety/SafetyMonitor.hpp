@@ -0,0 +1,153 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#ifndef air_SafetyMonitor_hpp
+#define air_SafetyMonitor_hpp
+
+#include "common/Common.hpp"
+#include "common/UpdatableObject.hpp"
+#include "common/SpscQueue.hpp"
+#include "physics/Kinematics.hpp"
+#include "PolygonGeoFence.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace msr
+{
+namespace airlib
+{
+
+    // Checks every registered vehicle against all geofences and against each other on every physics step.
+    // Insert it into the physics world, it sees the kinematics the physics engine produced in the last step.
+    //
+    // Fences are prisms (PolygonGeoFence) indexed by a BVH over their bounding boxes. A vehicle violates a
+    // keep out fence when it is inside it, and violates the keep in fences when there are any and it is
+    // inside none of them, so several keep in fences form one allowed area. Vehicles closer than the
+    // separation distance violate separation; pairs are found by sweeping vehicles sorted along x, the order
+    // is kept between steps so sorting is close to linear.
+    //
+    // Only changes are reported: an event when a vehicle starts violating and another when it stops. Events
+    // go through a lock free queue written by the physics thread, poll it with popEvent from one thread.
+    class SafetyMonitor : public UpdatableObject
+    {
+    public:
+        enum class EventType : uint
+        {
+            GeoFence = 0,
+            Separation = 1
+        };
+
+        struct Event
+        {
+            uint64_t step = 0; //clock step the change was detected in
+            EventType type = EventType::GeoFence;
+            bool is_violation = false; //false when the violation ended
+            int vehicle = -1;
+            int other = -1; //fence id for GeoFence, vehicle index for Separation
+            Vector3r position = Vector3r::Zero(); //NED position of vehicle
+            float distance = 0; //to the fence boundary or to the other vehicle
+
+            string toString() const
+            {
+                return Utils::stringf("SafetyMonitor::Event: step=%llu, type=%u, is_violation=%i, vehicle=%d, other=%d, position=%s, distance=%f",
+                                      static_cast<unsigned long long>(step), uint(type), is_violation, vehicle, other,
+                                      VectorMath::toString(position).c_str(), distance);
+            }
+        };
+
+    public:
+        SafetyMonitor(size_t event_capacity = 4096);
+
+        //kinematics must stay valid while the monitor is updated, returns the vehicle index used in events
+        int addVehicle(const std::string& name, const Kinematics::State* kinematics);
+        std::string getVehicleName(int vehicle) const;
+        int getVehicleCount() const;
+
+        //returns the fence id used in events
+        int addFence(const shared_ptr<PolygonGeoFence>& fence, bool keep_out);
+        bool removeFence(int fence_id);
+        void clearFences();
+        int getFenceCount() const;
+
+        //minimum distance between vehicles, 0 turns the check off
+        void setSeparation(float distance);
+        float getSeparation() const;
+
+        //consumer side of the event queue, call from one thread only
+        bool popEvent(Event& event);
+        uint64_t getDroppedEventCount() const;
+
+        virtual void update(float delta = 0) override;
+        virtual void reportState(StateReporter& reporter) override;
+
+    protected:
+        virtual void resetImplementation() override;
+
+    private:
+        static constexpr int kNone = -1;
+
+        struct Fence
+        {
+            int id;
+            shared_ptr<PolygonGeoFence> fence;
+            bool keep_out;
+        };
+
+        // Leaf when count > 0 (fences [first, first + count)), otherwise children are first and first + 1
+        struct Node
+        {
+            Vector3r box_min;
+            Vector3r box_max;
+            uint32_t first = 0;
+            uint32_t count = 0;
+        };
+
+        static constexpr uint32_t kMaxLeafSize = 2;
+        static constexpr int kMaxStackDepth = 64;
+
+        //fences with their BVH, never changed once published so edits build a new one without holding mutex_
+        struct FenceIndex
+        {
+            vector<Fence> fences; //sorted by id, ids only grow
+            bool has_keep_in = false;
+            vector<uint32_t> fence_indices;
+            vector<Node> nodes;
+
+            void build();
+            void buildNode(uint32_t node_index, uint32_t first, uint32_t count);
+            int find(int fence_id) const;
+        };
+
+        void publishFences(vector<Fence>&& fences);
+        int checkFences(int vehicle, const Vector3r& position) const;
+        int closestKeepInFence(const Vector3r& position) const;
+        void checkSeparation();
+        float fenceDistance(int fence_id, const Vector3r& position) const;
+        void pushEvent(EventType type, bool is_violation, int vehicle, int other, float distance);
+
+    private:
+        mutable std::mutex mutex_; //configuration against update
+        std::mutex fence_edit_mutex_; //serializes fence edits, only held while building a FenceIndex
+
+        vector<std::string> vehicle_names_;
+        vector<const Kinematics::State*> vehicle_kinematics_;
+        //positions of the current step, struct of arrays for the sweep
+        vector<float> xs_, ys_, zs_;
+        //current violation of each vehicle, kNone when there is none
+        vector<int> fence_states_, separation_states_;
+        //sweep order and closest neighbor within separation of each vehicle
+        vector<int> sweep_order_, closest_neighbors_;
+        vector<float> closest_distances2_;
+
+        //swapped under mutex_, read by update under mutex_ and by fence edits under fence_edit_mutex_
+        shared_ptr<const FenceIndex> fence_index_;
+        int next_fence_id_ = 0;
+
+        float separation_ = 0;
+
+        SpscQueue<Event> events_;
+        std::atomic<uint64_t> dropped_events_{ 0 };
+    };
+}
+} //namespace
+#endif
@@ -70,6 +70,7 @@ protected:
     void setOutput(const MarLocUwbSensorData& output)
     {
         output_ = output;
+        notifyOutput(SensorType::MarlocUwb, output_.time_stamp, &output_);
     }
 
 private:
@@ -9,12 +9,16 @@
 #include "common/CommonStructs.hpp"
 #include "physics/Environment.hpp"
 #include "physics/Kinematics.hpp"
+#include <atomic>
+#include <thread>
 
 namespace msr
 {
 namespace airlib
 {
 
+    class ISensorOutputSink;
+
     /*
     Derived classes should not do any work in constructor which requires ground truth.
     After construction of the derived class an initialize(...) must be made which would
@@ -67,13 +71,49 @@ namespace airlib
             return name_;
         }
 
+        // Observer for every new output, e.g. the recorder. Attaching does not change the sensor so this is allowed on const sensors.
+        // Returns once no output is being delivered to the previous sink, so it can be destroyed after detaching it. Never call
+        // from inside onSensorOutput.
+        void setOutputSink(ISensorOutputSink* sink) const
+        {
+            output_sink_ = sink;
+            while (output_sink_users_ > 0)
+                std::this_thread::yield();
+        }
+
         virtual ~SensorBase() = default;
 
+    protected:
+        // Called by the derived classes from setOutput, output points to the derived Output type matching sensor_type
+        void notifyOutput(SensorType sensor_type, TTimePoint time_stamp, const void* output) const;
+
     private:
         //ground truth can be shared between many sensors
         GroundTruth ground_truth_ = { nullptr, nullptr };
         std::string name_ = "";
+        mutable std::atomic<ISensorOutputSink*> output_sink_{ nullptr };
+        //notifyOutput calls that may hold a sink, counted before the sink is read
+        mutable std::atomic<int> output_sink_users_{ 0 };
     };
+
+    // Receives sensor outputs on the thread that produced them. The output is only valid during the call,
+    // implementations must copy or encode what they keep and return quickly.
+    class ISensorOutputSink
+    {
+    public:
+        virtual void onSensorOutput(const SensorBase& sensor, SensorBase::SensorType sensor_type, TTimePoint time_stamp, const void* output) = 0;
+        virtual ~ISensorOutputSink() = default;
+    };
+
+    inline void SensorBase::notifyOutput(SensorType sensor_type, TTimePoint time_stamp, const void* output) const
+    {
+        //the sink is pinned before it is read, setOutputSink sees the count of any call that may have read the old sink
+        ++output_sink_users_;
+        ISensorOutputSink* sink = output_sink_;
+        if (sink != nullptr)
+            sink->onSensorOutput(*this, sensor_type, time_stamp, output);
+        --output_sink_users_;
+    }
 }
 } //namespace
 #endif
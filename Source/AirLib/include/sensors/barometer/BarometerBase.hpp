@@ -47,6 +47,7 @@ namespace airlib
         void setOutput(const Output& output)
         {
             output_ = output;
+            notifyOutput(SensorType::Barometer, output_.time_stamp, &output_);
         }
 
     private:
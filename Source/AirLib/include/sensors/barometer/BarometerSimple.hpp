@@ -10,6 +10,7 @@
 #include "BarometerSimpleParams.hpp"
 #include "BarometerBase.hpp"
 #include "common/GaussianMarkov.hpp"
+#include "common/GaussianNoise.hpp"
 #include "common/DelayLine.hpp"
 #include "common/FrequencyLimiter.hpp"
 
@@ -27,15 +28,20 @@ namespace airlib
             // initialize params
             params_.initializeFromSettings(setting);
 
+            //pressure factor and uncorrelated noise draw from separate streams of the sensor seed
+            const uint64_t noise_seed = GaussianNoise::makeSeed(setting.sensor_name, setting.settings.getInt("NoiseSeed", GaussianNoise::kDefaultSeed));
+
             //GM process that would do random walk for pressure factor
+            pressure_factor_.seed(noise_seed, 0);
             pressure_factor_.initialize(params_.pressure_factor_tau, params_.pressure_factor_sigma, 0);
 
-            uncorrelated_noise_ = RandomGeneratorGausianR(0.0f, params_.uncorrelated_noise_sigma);
+            uncorrelated_noise_ = GaussianNoise(0.0f, params_.uncorrelated_noise_sigma, noise_seed, 1);
             //correlated_noise_.initialize(params_.correlated_noise_tau, params_.correlated_noise_sigma, 0.0f);
 
             //initialize frequency limiter
             freq_limiter_.initialize(params_.update_frequency, params_.startup_delay);
-            delay_line_.initialize(params_.update_latency);
+            delay_line_.initialize(params_.update_latency, params_.update_frequency, params_.update_latency_jitter,
+                                   GaussianNoise::makeSeed(setting.sensor_name + "/latency", setting.settings.getInt("NoiseSeed", GaussianNoise::kDefaultSeed)));
         }
 
         //*** Start: UpdatableState implementation ***//
@@ -104,7 +110,7 @@ namespace airlib
 
         GaussianMarkov pressure_factor_;
         //GaussianMarkov correlated_noise_;
-        RandomGeneratorGausianR uncorrelated_noise_;
+        GaussianNoise uncorrelated_noise_;
 
         FrequencyLimiter freq_limiter_;
         DelayLine<Output> delay_line_;
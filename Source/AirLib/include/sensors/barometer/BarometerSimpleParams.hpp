@@ -47,6 +47,7 @@ namespace airlib
 
         //see PX4 param reference for EKF: https://dev.px4.io/en/advanced/parameter_reference.html
         real_T update_latency = 0.0f; //sec
+        real_T update_latency_jitter = 0.0f; //sec, standard deviation of the latency
         real_T update_frequency = 50; //Hz
         real_T startup_delay = 0; //sec
 
@@ -57,6 +58,7 @@ namespace airlib
             pressure_factor_tau = json.getFloat("PressureFactorTau", pressure_factor_tau);
             uncorrelated_noise_sigma = json.getFloat("UncorrelatedNoiseSigma", uncorrelated_noise_sigma);
             update_latency = json.getFloat("UpdateLatency", update_latency);
+            update_latency_jitter = json.getFloat("UpdateLatencyJitter", update_latency_jitter);
             update_frequency = json.getFloat("UpdateFrequency", update_frequency);
             startup_delay = json.getFloat("StartupDelay", startup_delay);
         }
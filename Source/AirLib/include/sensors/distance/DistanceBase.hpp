@@ -37,6 +37,7 @@ namespace airlib
         void setOutput(const DistanceSensorData& output)
         {
             output_ = output;
+            notifyOutput(SensorType::Distance, output_.time_stamp, &output_);
         }
 
     private:
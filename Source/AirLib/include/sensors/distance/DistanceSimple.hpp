@@ -9,6 +9,7 @@
 #include "DistanceSimpleParams.hpp"
 #include "DistanceBase.hpp"
 #include "common/GaussianMarkov.hpp"
+#include "common/GaussianNoise.hpp"
 #include "common/DelayLine.hpp"
 #include "common/FrequencyLimiter.hpp"
 
@@ -26,12 +27,12 @@ namespace airlib
             // initialize params
             params_.initializeFromSettings(setting);
 
-            uncorrelated_noise_ = RandomGeneratorGausianR(0.0f, params_.uncorrelated_noise_sigma);
+            uncorrelated_noise_ = GaussianNoise(0.0f, params_.uncorrelated_noise_sigma, GaussianNoise::makeSeed(setting.sensor_name, setting.settings.getInt("NoiseSeed", GaussianNoise::kDefaultSeed)));
             //correlated_noise_.initialize(params_.correlated_noise_tau, params_.correlated_noise_sigma, 0.0f);
 
             //initialize frequency limiter
             freq_limiter_.initialize(params_.update_frequency, params_.startup_delay);
-            delay_line_.initialize(params_.update_latency);
+            delay_line_.initialize(params_.update_latency, params_.update_frequency);
         }
 
         //*** Start: UpdatableState implementation ***//
@@ -98,7 +99,7 @@ namespace airlib
         DistanceSimpleParams params_;
 
         //GaussianMarkov correlated_noise_;
-        RandomGeneratorGausianR uncorrelated_noise_;
+        GaussianNoise uncorrelated_noise_;
 
         FrequencyLimiter freq_limiter_;
         DelayLine<DistanceSensorData> delay_line_;
@@ -53,6 +53,7 @@ protected:
     void setOutput(const EchoData& output)
     {
         output_ = output;
+        notifyOutput(SensorType::Echo, output_.time_stamp, &output_);
     }
 
 private:
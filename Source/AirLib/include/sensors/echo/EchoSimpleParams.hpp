@@ -40,6 +40,7 @@ struct EchoSimpleParams {
 	bool passive = false;                   // Sense and capture passive echo beacon data
 	bool active = true;                     // Sense and capture active echo beacon data (enable emission)
 	bool parallel = true;                   // Use ParallelFor for speeding up sampling. This disables all debug drawing except for the final reflected points if enabled.
+	std::string raycast_mesh_file = "";     // Trace against the meshes in this simGetMeshPositionVertexBuffers dump instead of the Unreal world
 
 	bool draw_reflected_points = false;				// Draw debug points in world where reflected points are captured by the echo sensor
 	bool draw_reflected_lines = false;				// Draw debug lines in world from reflected points to the echo sensor
@@ -110,6 +111,7 @@ struct EchoSimpleParams {
 		draw_initial_points = settings_json.getBool("DrawInitialPoints", draw_initial_points);
 		draw_bounce_lines = settings_json.getBool("DrawBounceLines", draw_bounce_lines);
 		draw_sensor = settings_json.getBool("DrawSensor", draw_sensor);
+		raycast_mesh_file = settings_json.getString("RaycastMeshFile", raycast_mesh_file);
 		draw_external_points = settings_json.getBool("DrawExternalPoints", draw_external_points);
 		draw_passive_sources = settings_json.getBool("DrawPassiveSources", draw_passive_sources);
 		draw_passive_lines = settings_json.getBool("DrawPassiveLines", draw_passive_lines);
@@ -130,6 +130,7 @@ namespace airlib
         void setOutput(const Output& output)
         {
             output_ = output;
+            notifyOutput(SensorType::Gps, output_.time_stamp, &output_);
         }
 
     private:
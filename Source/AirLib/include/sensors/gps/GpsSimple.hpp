@@ -28,7 +28,8 @@ namespace airlib
 
             //initialize frequency limiter
             freq_limiter_.initialize(params_.update_frequency, params_.startup_delay);
-            delay_line_.initialize(params_.update_latency);
+            delay_line_.initialize(params_.update_latency, params_.update_frequency, params_.update_latency_jitter,
+                                   GaussianNoise::makeSeed(setting.sensor_name + "/latency", setting.settings.getInt("NoiseSeed", GaussianNoise::kDefaultSeed)));
 
             //initialize filters
             eph_filter.initialize(params_.eph_time_constant, params_.eph_final, params_.eph_initial); //starting dilution set to 100 which we will reduce over time to targeted 0.3f, with 45% accuracy within 100 updates, each update occurring at 0.2s interval
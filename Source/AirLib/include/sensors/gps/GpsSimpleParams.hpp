@@ -19,6 +19,7 @@ namespace airlib
         real_T eph_min_3d = 3.0f, eph_min_2d = 4.0f;
 
         real_T update_latency = 0.2f; //sec
+        real_T update_latency_jitter = 0.0f; //sec, standard deviation of the latency
         real_T update_frequency = 50; //Hz
         real_T startup_delay = 1; //sec
 
@@ -34,6 +35,7 @@ namespace airlib
             eph_min_3d = json.getFloat("EphMin3d", eph_min_3d);
             eph_min_2d = json.getFloat("EphMin2d", eph_min_2d);
             update_latency = json.getFloat("UpdateLatency", update_latency);
+            update_latency_jitter = json.getFloat("UpdateLatencyJitter", update_latency_jitter);
             update_frequency = json.getFloat("UpdateFrequency", update_frequency);
             startup_delay = json.getFloat("StartupDelay", startup_delay);
         }
@@ -48,6 +48,7 @@ namespace airlib
         void setOutput(const Output& output)
         {
             output_ = output;
+            notifyOutput(SensorType::Imu, output_.time_stamp, &output_);
         }
 
     private:
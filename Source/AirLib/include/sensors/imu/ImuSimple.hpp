@@ -7,6 +7,7 @@
 #include "common/Common.hpp"
 #include "ImuSimpleParams.hpp"
 #include "ImuBase.hpp"
+#include "common/GaussianNoise.hpp"
 
 namespace msr
 {
@@ -22,6 +23,7 @@ namespace airlib
         {
             // initialize params
             add_noise = params_.initializeFromSettings(setting);
+            gauss_dist.seed(GaussianNoise::makeSeed(setting.sensor_name, setting.settings.getInt("NoiseSeed", GaussianNoise::kDefaultSeed)));
 
             gyro_bias_stability_norm = params_.gyro.bias_stability / sqrt(params_.gyro.tau);
             accel_bias_stability_norm = params_.accel.bias_stability / sqrt(params_.accel.tau);
@@ -86,23 +88,23 @@ namespace airlib
             // Gyrosocpe
             //convert arw to stddev
             real_T gyro_sigma_arw = params_.gyro.arw / sqrt_dt;
-            angular_velocity += gauss_dist.next() * gyro_sigma_arw + state_.gyroscope_bias;
+            angular_velocity += gauss_dist.nextVector() * gyro_sigma_arw + state_.gyroscope_bias;
             //update bias random walk
             real_T gyro_sigma_bias = gyro_bias_stability_norm * sqrt_dt;
-            state_.gyroscope_bias += gauss_dist.next() * gyro_sigma_bias;
+            state_.gyroscope_bias += gauss_dist.nextVector() * gyro_sigma_bias;
 
             //accelerometer
             //convert vrw to stddev
             real_T accel_sigma_vrw = params_.accel.vrw / sqrt_dt;
-            linear_acceleration += gauss_dist.next() * accel_sigma_vrw + state_.accelerometer_bias;
+            linear_acceleration += gauss_dist.nextVector() * accel_sigma_vrw + state_.accelerometer_bias;
             //update bias random walk
             real_T accel_sigma_bias = accel_bias_stability_norm * sqrt_dt;
-            state_.accelerometer_bias += gauss_dist.next() * accel_sigma_bias;
+            state_.accelerometer_bias += gauss_dist.nextVector() * accel_sigma_bias;
         }
 
     private: //fields
         ImuSimpleParams params_;
-        RandomVectorGaussianR gauss_dist = RandomVectorGaussianR(0, 1);
+        GaussianNoise gauss_dist;
 
         //cached calculated values
         real_T gyro_bias_stability_norm, accel_bias_stability_norm;
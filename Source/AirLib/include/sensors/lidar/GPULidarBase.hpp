@@ -33,6 +33,7 @@ namespace msr {
 			void setOutput(const GPULidarData& output)
 			{
 				output_ = output;
+				notifyOutput(SensorType::GPULidar, output_.time_stamp, &output_);
 			}
 
 		private:
@@ -38,6 +38,7 @@ namespace airlib
         void setOutput(const LidarData& output)
         {
             output_ = output;
+            notifyOutput(SensorType::Lidar, output_.time_stamp, &output_);
         }
 
     private:
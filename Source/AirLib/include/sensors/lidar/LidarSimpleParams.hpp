@@ -34,6 +34,7 @@ namespace airlib
         bool external = false;                    // define if a sensor is attached to the vehicle itself(false), or to the world and is an external sensor (true)
         bool external_ned = true;                 // define if the external sensor coordinates should be reported back by the API in local NED or Unreal coordinates
         bool draw_sensor = false;
+        std::string raycast_mesh_file = "";       // Trace against the meshes in this simGetMeshPositionVertexBuffers dump instead of the Unreal world
 
         uint measurement_per_cycle = 512;
         uint horizontal_rotation_frequency = 10; // rotations/sec
@@ -72,6 +73,7 @@ namespace airlib
 		    pause_after_measurement = settings_json.getBool("settings.pause_after_measurement", pause_after_measurement);
             draw_debug_points = settings_json.getBool("DrawDebugPoints", draw_debug_points);
             draw_sensor = settings_json.getBool("DrawSensor", draw_sensor);
+            raycast_mesh_file = settings_json.getString("RaycastMeshFile", raycast_mesh_file);
             external = settings_json.getBool("External", external);
             external_ned = settings_json.getBool("ExternalLocal", external_ned);
             generate_noise = settings_json.getBool("GenerateNoise", generate_noise);
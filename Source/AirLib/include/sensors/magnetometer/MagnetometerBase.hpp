@@ -45,6 +45,7 @@ namespace airlib
         void setOutput(const Output& output)
         {
             output_ = output;
+            notifyOutput(SensorType::Magnetometer, output_.time_stamp, &output_);
         }
 
     private:
@@ -11,6 +11,7 @@
 #include "MagnetometerBase.hpp"
 #include "common/FrequencyLimiter.hpp"
 #include "common/DelayLine.hpp"
+#include "common/GaussianNoise.hpp"
 
 namespace msr
 {
@@ -26,12 +27,13 @@ namespace airlib
             // initialize params
             params_.initializeFromSettings(setting);
 
-            noise_vec_ = RandomVectorGaussianR(Vector3r::Zero(), params_.noise_sigma);
+            noise_vec_.seed(GaussianNoise::makeSeed(setting.sensor_name, setting.settings.getInt("NoiseSeed", GaussianNoise::kDefaultSeed)));
             bias_vec_ = RandomVectorR(-params_.noise_bias, params_.noise_bias).next();
 
             //initialize frequency limiter
             freq_limiter_.initialize(params_.update_frequency, params_.startup_delay);
-            delay_line_.initialize(params_.update_latency);
+            delay_line_.initialize(params_.update_latency, params_.update_frequency, params_.update_latency_jitter,
+                                   GaussianNoise::makeSeed(setting.sensor_name + "/latency", setting.settings.getInt("NoiseSeed", GaussianNoise::kDefaultSeed)));
         }
 
         //*** Start: UpdatableObject implementation ***//
@@ -94,7 +96,7 @@ namespace airlib
                                                                           ground_truth.kinematics->pose.orientation,
                                                                           true) *
                                              params_.scale_factor +
-                                         noise_vec_.next() + bias_vec_;
+                                         noise_vec_.nextVector().cwiseProduct(params_.noise_sigma) + bias_vec_;
 
             // todo output.magnetic_field_covariance ?
             output.time_stamp = clock()->nowNanos();
@@ -103,7 +105,7 @@ namespace airlib
         }
 
     private:
-        RandomVectorGaussianR noise_vec_;
+        GaussianNoise noise_vec_;
         Vector3r bias_vec_;
 
         Vector3r magnetic_field_true_;
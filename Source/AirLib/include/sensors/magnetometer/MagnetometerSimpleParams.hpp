@@ -32,6 +32,7 @@ namespace airlib
 
         //see PX4 param reference for EKF: https://dev.px4.io/en/advanced/parameter_reference.html
         real_T update_latency = 0.0f; //sec: from PX4 doc
+        real_T update_latency_jitter = 0.0f; //sec, standard deviation of the latency
         real_T update_frequency = 50; //Hz
         real_T startup_delay = 0; //sec
 
@@ -44,6 +45,7 @@ namespace airlib
             float bias = json.getFloat("NoiseBias", noise_bias.x());
             noise_bias = Vector3r(bias, bias, bias);
             update_latency = json.getFloat("UpdateLatency", update_latency);
+            update_latency_jitter = json.getFloat("UpdateLatencyJitter", update_latency_jitter);
             update_frequency = json.getFloat("UpdateFrequency", update_frequency);
             startup_delay = json.getFloat("StartupDelay", startup_delay);
         }
@@ -0,0 +1,354 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#ifndef msr_airlib_BvhRaycastBackend_hpp
+#define msr_airlib_BvhRaycastBackend_hpp
+
+#include "common/Common.hpp"
+#include "common/CommonStructs.hpp"
+#include "IRaycastBackend.hpp"
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
+STRICT_MODE_OFF
+#undef min
+#include "common/common_utils/json.hpp"
+STRICT_MODE_ON
+
+namespace msr
+{
+namespace airlib
+{
+
+    // Pure C++ raycast backend over static triangle meshes, so the sensor ray logic can run without an Unreal world.
+    // Meshes use the layout returned by simGetMeshPositionVertexBuffers: vertices already in Unreal world space (cm),
+    // the mesh position and orientation are informational and not applied again.
+    class BvhRaycastBackend : public IRaycastBackend
+    {
+    public:
+        // Adds one mesh, every mesh gets the next label id
+        int addMesh(const MeshPositionVertexBuffersResponse& mesh, const std::string& material = "")
+        {
+            const int label_id = static_cast<int>(objects_.size());
+            objects_.push_back(Object{ mesh.name, material });
+
+            const size_t vertex_count = mesh.vertices.size() / 3;
+            vector<Vector3r> world_vertices(vertex_count);
+            for (size_t i = 0; i < vertex_count; ++i)
+                world_vertices[i] = Vector3r(mesh.vertices[i * 3], mesh.vertices[i * 3 + 1], mesh.vertices[i * 3 + 2]);
+
+            for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+                if (mesh.indices[i] >= vertex_count || mesh.indices[i + 1] >= vertex_count || mesh.indices[i + 2] >= vertex_count)
+                    continue;
+                Triangle triangle;
+                triangle.v0 = world_vertices[mesh.indices[i]];
+                triangle.v1 = world_vertices[mesh.indices[i + 1]];
+                triangle.v2 = world_vertices[mesh.indices[i + 2]];
+                triangle.centroid = (triangle.v0 + triangle.v1 + triangle.v2) / 3.0f;
+                triangle.label_id = label_id;
+                triangles_.push_back(triangle);
+            }
+
+            is_built_ = false;
+            return label_id;
+        }
+
+        // Loads a JSON array of meshes as dumped from simGetMeshPositionVertexBuffers, each entry holding
+        // "name", "vertices" [x0, y0, z0, ...] in world space, "indices" [...] and optionally "position" [x, y, z],
+        // "orientation" [w, x, y, z] and "material"
+        bool loadMeshFile(const std::string& file_path)
+        {
+            std::ifstream file(file_path);
+            if (!file.is_open())
+                return false;
+
+            nlohmann::json doc;
+            try {
+                file >> doc;
+            }
+            catch (const std::exception&) {
+                return false;
+            }
+            if (!doc.is_array())
+                return false;
+
+            for (const auto& item : doc) {
+                MeshPositionVertexBuffersResponse mesh;
+                mesh.name = item.value("name", std::string());
+                if (item.contains("position")) {
+                    const auto& position = item.at("position");
+                    mesh.position = Vector3r(position[0].get<float>(), position[1].get<float>(), position[2].get<float>());
+                }
+                if (item.contains("orientation")) {
+                    const auto& orientation = item.at("orientation");
+                    mesh.orientation = Quaternionr(orientation[0].get<float>(), orientation[1].get<float>(), orientation[2].get<float>(), orientation[3].get<float>());
+                }
+                mesh.vertices = item.at("vertices").get<std::vector<float>>();
+                mesh.indices = item.at("indices").get<std::vector<uint32_t>>();
+                addMesh(mesh, item.value("material", std::string()));
+            }
+
+            build();
+            return true;
+        }
+
+        void build()
+        {
+            nodes_.clear();
+            triangle_indices_.resize(triangles_.size());
+            for (size_t i = 0; i < triangles_.size(); ++i)
+                triangle_indices_[i] = static_cast<uint32_t>(i);
+
+            if (!triangles_.empty()) {
+                nodes_.reserve(triangles_.size() * 2);
+                nodes_.emplace_back();
+                buildNode(0, 0, static_cast<uint32_t>(triangles_.size()));
+            }
+            is_built_ = true;
+        }
+
+        size_t getTriangleCount() const
+        {
+            return triangles_.size();
+        }
+
+        size_t getObjectCount() const
+        {
+            return objects_.size();
+        }
+
+        virtual bool raycast(const Vector3r& start, const Vector3r& end, RaycastHit& hit) const override
+        {
+            hit = RaycastHit();
+            RayData ray(start, end);
+            if (!is_built_ || nodes_.empty() || ray.length <= 0)
+                return false;
+
+            float closest_t = ray.length;
+            int closest_triangle = -1;
+
+            uint32_t stack[kMaxStackDepth];
+            int stack_size = 0;
+            stack[stack_size++] = 0;
+            while (stack_size > 0) {
+                const Node& node = nodes_[stack[--stack_size]];
+                if (!intersectBox(ray, node, closest_t))
+                    continue;
+
+                if (node.count > 0) {
+                    for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                        float t;
+                        if (intersectTriangle(ray, triangles_[triangle_indices_[i]], t) && t < closest_t) {
+                            closest_t = t;
+                            closest_triangle = static_cast<int>(triangle_indices_[i]);
+                        }
+                    }
+                }
+                else if (stack_size + 2 <= kMaxStackDepth) {
+                    stack[stack_size++] = node.first;
+                    stack[stack_size++] = node.first + 1;
+                }
+            }
+
+            if (closest_triangle < 0)
+                return false;
+            fillHit(ray, triangles_[closest_triangle], closest_t, hit);
+            return true;
+        }
+
+        virtual int raycastMulti(const Vector3r& start, const Vector3r& end, vector<RaycastHit>& hits, int max_hits = 16) const override
+        {
+            hits.clear();
+            RayData ray(start, end);
+            if (!is_built_ || nodes_.empty() || ray.length <= 0)
+                return 0;
+
+            vector<std::pair<float, uint32_t>> candidates;
+            uint32_t stack[kMaxStackDepth];
+            int stack_size = 0;
+            stack[stack_size++] = 0;
+            while (stack_size > 0) {
+                const Node& node = nodes_[stack[--stack_size]];
+                if (!intersectBox(ray, node, ray.length))
+                    continue;
+
+                if (node.count > 0) {
+                    for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                        float t;
+                        if (intersectTriangle(ray, triangles_[triangle_indices_[i]], t))
+                            candidates.emplace_back(t, triangle_indices_[i]);
+                    }
+                }
+                else if (stack_size + 2 <= kMaxStackDepth) {
+                    stack[stack_size++] = node.first;
+                    stack[stack_size++] = node.first + 1;
+                }
+            }
+
+            std::sort(candidates.begin(), candidates.end());
+            const size_t hit_count = std::min(candidates.size(), static_cast<size_t>(std::max(max_hits, 0)));
+            hits.resize(hit_count);
+            for (size_t i = 0; i < hit_count; ++i)
+                fillHit(ray, triangles_[candidates[i].second], candidates[i].first, hits[i]);
+            return static_cast<int>(hit_count);
+        }
+
+    private:
+        struct Object
+        {
+            std::string name;
+            std::string material;
+        };
+
+        struct Triangle
+        {
+            Vector3r v0, v1, v2;
+            Vector3r centroid;
+            int label_id;
+        };
+
+        // Leaf when count > 0 (triangles [first, first + count)), otherwise children are first and first + 1
+        struct Node
+        {
+            Vector3r box_min;
+            Vector3r box_max;
+            uint32_t first = 0;
+            uint32_t count = 0;
+        };
+
+        struct RayData
+        {
+            Vector3r origin;
+            Vector3r direction;
+            Vector3r inverse_direction;
+            float length;
+
+            RayData(const Vector3r& start, const Vector3r& end)
+                : origin(start)
+            {
+                Vector3r delta = end - start;
+                length = delta.norm();
+                direction = length > 0 ? Vector3r(delta / length) : Vector3r::Zero();
+                for (int axis = 0; axis < 3; ++axis)
+                    inverse_direction[axis] = direction[axis] != 0 ? 1.0f / direction[axis] : std::numeric_limits<float>::infinity();
+            }
+        };
+
+        static constexpr uint32_t kMaxLeafSize = 4;
+        static constexpr int kMaxStackDepth = 128;
+
+        void buildNode(uint32_t node_index, uint32_t first, uint32_t count)
+        {
+            Vector3r box_min = Vector3r::Constant(std::numeric_limits<float>::max());
+            Vector3r box_max = Vector3r::Constant(-std::numeric_limits<float>::max());
+            Vector3r centroid_min = box_min, centroid_max = box_max;
+            for (uint32_t i = first; i < first + count; ++i) {
+                const Triangle& triangle = triangles_[triangle_indices_[i]];
+                box_min = box_min.cwiseMin(triangle.v0).cwiseMin(triangle.v1).cwiseMin(triangle.v2);
+                box_max = box_max.cwiseMax(triangle.v0).cwiseMax(triangle.v1).cwiseMax(triangle.v2);
+                centroid_min = centroid_min.cwiseMin(triangle.centroid);
+                centroid_max = centroid_max.cwiseMax(triangle.centroid);
+            }
+            nodes_[node_index].box_min = box_min;
+            nodes_[node_index].box_max = box_max;
+
+            // Split on the median centroid along the widest axis
+            Vector3r extent = centroid_max - centroid_min;
+            int axis = 0;
+            if (extent[1] > extent[axis])
+                axis = 1;
+            if (extent[2] > extent[axis])
+                axis = 2;
+
+            if (count <= kMaxLeafSize || extent[axis] <= 0) {
+                nodes_[node_index].first = first;
+                nodes_[node_index].count = count;
+                return;
+            }
+
+            const uint32_t half = count / 2;
+            std::nth_element(triangle_indices_.begin() + first, triangle_indices_.begin() + first + half, triangle_indices_.begin() + first + count,
+                             [this, axis](uint32_t a, uint32_t b) { return triangles_[a].centroid[axis] < triangles_[b].centroid[axis]; });
+
+            const uint32_t left_index = static_cast<uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+            nodes_.emplace_back();
+            nodes_[node_index].first = left_index;
+            nodes_[node_index].count = 0;
+
+            buildNode(left_index, first, half);
+            buildNode(left_index + 1, first + half, count - half);
+        }
+
+        static bool intersectBox(const RayData& ray, const Node& node, float max_t)
+        {
+            float t_min = 0, t_max = max_t;
+            for (int axis = 0; axis < 3; ++axis) {
+                float t0 = (node.box_min[axis] - ray.origin[axis]) * ray.inverse_direction[axis];
+                float t1 = (node.box_max[axis] - ray.origin[axis]) * ray.inverse_direction[axis];
+                if (t0 > t1)
+                    std::swap(t0, t1);
+                // NaN from 0 * inf means the ray lies on a slab plane, treat as inside
+                if (!(t0 != t0))
+                    t_min = std::max(t_min, t0);
+                if (!(t1 != t1))
+                    t_max = std::min(t_max, t1);
+                if (t_min > t_max)
+                    return false;
+            }
+            return true;
+        }
+
+        // Moller-Trumbore, two sided
+        static bool intersectTriangle(const RayData& ray, const Triangle& triangle, float& t)
+        {
+            constexpr float kEpsilon = 1e-7f;
+            Vector3r edge1 = triangle.v1 - triangle.v0;
+            Vector3r edge2 = triangle.v2 - triangle.v0;
+            Vector3r p = ray.direction.cross(edge2);
+            float determinant = edge1.dot(p);
+            if (std::abs(determinant) < kEpsilon)
+                return false;
+
+            float inverse_determinant = 1.0f / determinant;
+            Vector3r s = ray.origin - triangle.v0;
+            float u = s.dot(p) * inverse_determinant;
+            if (u < 0 || u > 1)
+                return false;
+
+            Vector3r q = s.cross(edge1);
+            float v = ray.direction.dot(q) * inverse_determinant;
+            if (v < 0 || u + v > 1)
+                return false;
+
+            t = edge2.dot(q) * inverse_determinant;
+            return t > 0 && t <= ray.length;
+        }
+
+        void fillHit(const RayData& ray, const Triangle& triangle, float t, RaycastHit& hit) const
+        {
+            hit.is_hit = true;
+            hit.distance = t;
+            hit.point = ray.origin + ray.direction * t;
+
+            // Report the face normal on the side the ray came from, like the engine does
+            Vector3r normal = (triangle.v1 - triangle.v0).cross(triangle.v2 - triangle.v0).normalized();
+            if (normal.dot(ray.direction) > 0)
+                normal = -normal;
+            hit.normal = normal;
+
+            hit.label_id = triangle.label_id;
+            hit.label = objects_[triangle.label_id].name;
+            hit.material = objects_[triangle.label_id].material;
+        }
+
+    private:
+        vector<Object> objects_;
+        vector<Triangle> triangles_;
+        vector<uint32_t> triangle_indices_;
+        vector<Node> nodes_;
+        bool is_built_ = false;
+    };
+}
+} //namespace
+#endif
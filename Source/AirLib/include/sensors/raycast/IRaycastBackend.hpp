@@ -0,0 +1,63 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#ifndef msr_airlib_IRaycastBackend_hpp
+#define msr_airlib_IRaycastBackend_hpp
+
+#include "common/Common.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    // Ray queries used by the ray traced sensors, independent of the engine that answers them.
+    // Positions are expressed in the frame of the backend, which is Unreal world space (cm) for all current backends.
+    class IRaycastBackend
+    {
+    public: //types
+        struct Ray
+        {
+            Vector3r start;
+            Vector3r end;
+
+            Ray()
+            {
+            }
+
+            Ray(const Vector3r& start_val, const Vector3r& end_val)
+                : start(start_val), end(end_val)
+            {
+            }
+        };
+
+        struct RaycastHit
+        {
+            bool is_hit = false;
+            Vector3r point = Vector3r::Zero();
+            Vector3r normal = Vector3r::Zero();
+            real_T distance = 0;            // distance from the ray start to the hit point
+            int label_id = -1;              // backend specific id of the object that was hit
+            std::string label;              // name of the object that was hit
+            std::string material;           // name of the physical material that was hit, empty if unknown
+        };
+
+    public: //methods
+        // Closest hit along the segment from start to end
+        virtual bool raycast(const Vector3r& start, const Vector3r& end, RaycastHit& hit) const = 0;
+
+        // All surfaces crossed along the segment from start to end, sorted by distance
+        virtual int raycastMulti(const Vector3r& start, const Vector3r& end, vector<RaycastHit>& hits, int max_hits = 16) const = 0;
+
+        // Closest hit for every ray, hits[i] belongs to rays[i]
+        virtual void raycastBatch(const vector<Ray>& rays, vector<RaycastHit>& hits) const
+        {
+            hits.resize(rays.size());
+            for (size_t i = 0; i < rays.size(); ++i)
+                raycast(rays[i].start, rays[i].end, hits[i]);
+        }
+
+        virtual ~IRaycastBackend() = default;
+    };
+}
+} //namespace
+#endif
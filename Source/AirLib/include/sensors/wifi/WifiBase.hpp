@@ -67,6 +67,7 @@ protected:
     void setOutput(const WifiSensorData& output)
     {
         output_ = output;
+        notifyOutput(SensorType::Wifi, output_.time_stamp, &output_);
     }
 
 private:
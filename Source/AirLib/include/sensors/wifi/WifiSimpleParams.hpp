@@ -17,6 +17,12 @@ struct WifiSimpleParams {
     bool external_ned = true;               // define if the external sensor coordinates should be reported back by the API in local NED or Unreal coordinates
     bool draw_sensor = false;						// Draw the physical sensor in the world on the vehicle
 
+    bool radio_map = false;                         // Interpolate measurements from a precomputed propagation map around the beacons instead of tracing every measurement, needs a 360 degree opening angle
+    float radio_map_cell_size = 1.0f;               // Grid resolution of the propagation map (m)
+    float radio_map_margin = 10.0f;                 // Distance the propagation map extends beyond the outermost beacons (m)
+    float radio_map_dynamic_radius = 2.0f;          // Trace live instead when a dynamic actor is within this distance of the sensor (m)
+    float radio_map_validation_fraction = 0.0f;     // Fraction of cached measurements that is also traced live to report the error of the map
+
 
     Pose relative_pose {
         Vector3r(0,0,-1),                   // position - a little above vehicle (especially for cars) or Vector3r::Zero()
@@ -42,6 +48,11 @@ struct WifiSimpleParams {
         external = settings_json.getBool("External", external);
         external_ned = settings_json.getBool("ExternalLocal", external_ned);
         draw_sensor = settings_json.getBool("DrawSensor", draw_sensor);
+        radio_map = settings_json.getBool("RadioMap", radio_map);
+        radio_map_cell_size = settings_json.getFloat("RadioMapCellSize", radio_map_cell_size);
+        radio_map_margin = settings_json.getFloat("RadioMapMargin", radio_map_margin);
+        radio_map_dynamic_radius = settings_json.getFloat("RadioMapDynamicRadius", radio_map_dynamic_radius);
+        radio_map_validation_fraction = settings_json.getFloat("RadioMapValidationFraction", radio_map_validation_fraction);
         data_frame = settings_json.getString("DataFrame", data_frame);
 
 
@@ -0,0 +1,592 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#ifndef msr_airlib_ArduPilotBridge_hpp
+#define msr_airlib_ArduPilotBridge_hpp
+
+#include "common/Common.hpp"
+#include "common/CommonStructs.hpp"
+#include "common/AirSimSettings.hpp"
+#include "common/StateReporter.hpp"
+#include "sensors/SensorCollection.hpp"
+#include "sensors/imu/ImuBase.hpp"
+#include "sensors/gps/GpsBase.hpp"
+#include "sensors/distance/DistanceSimple.hpp"
+#include "sensors/lidar/LidarSimple.hpp"
+
+#include "UdpSocket.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace msr
+{
+namespace airlib
+{
+
+    // JSON writer over a buffer that is reused between documents. Numbers are formatted by hand in fixed notation,
+    // so once the buffer has grown to the document size writing a document does not allocate.
+    class ArduPilotJsonWriter
+    {
+    public:
+        void clear()
+        {
+            size_ = 0;
+        }
+
+        const char* data() const
+        {
+            return buffer_.data();
+        }
+
+        size_t size() const
+        {
+            return size_;
+        }
+
+        ArduPilotJsonWriter& append(const char* text)
+        {
+            const size_t length = std::strlen(text);
+            std::memcpy(reserve(length), text, length);
+            size_ += length;
+            return *this;
+        }
+
+        ArduPilotJsonWriter& append(char c)
+        {
+            *reserve(1) = c;
+            ++size_;
+            return *this;
+        }
+
+        ArduPilotJsonWriter& appendUInt(uint64_t value)
+        {
+            size_ = writeUInt(reserve(20), value) - buffer_.data();
+            return *this;
+        }
+
+        // Same output as std::fixed with std::setprecision(decimals), up to 9 decimals
+        ArduPilotJsonWriter& appendFixed(double value, int decimals)
+        {
+            static const uint64_t kPowers[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+            decimals = std::min(std::max(decimals, 0), 9);
+
+            const double scaled = std::abs(value) * kPowers[decimals];
+            if (!(scaled < 1.0e18)) {
+                //NaN, infinity and huge values, not worth a fast path
+                const int length = std::snprintf(reserve(64), 64, "%.*f", decimals, value);
+                size_ += std::min(std::max(length, 0), 63);
+                return *this;
+            }
+
+            //ties round to even like printf, they are exact for floats scaled by a power of 10
+            const double integral = std::floor(scaled);
+            uint64_t fixed = static_cast<uint64_t>(integral);
+            if (scaled - integral > 0.5 || (scaled - integral == 0.5 && (fixed & 1) != 0))
+                ++fixed;
+
+            //sign, 18 integer digits, point and 9 decimals
+            char* out = reserve(32);
+            if (std::signbit(value))
+                *out++ = '-';
+            out = writeUInt(out, fixed / kPowers[decimals]);
+            if (decimals > 0) {
+                *out = '.';
+                uint64_t remainder = fixed % kPowers[decimals];
+                for (int i = decimals; i > 0; --i) {
+                    out[i] = static_cast<char>('0' + remainder % 10);
+                    remainder /= 10;
+                }
+                out += decimals + 1;
+            }
+            size_ = out - buffer_.data();
+            return *this;
+        }
+
+        // Comma separated values, decimated to every stride'th group of group_size values
+        ArduPilotJsonWriter& appendArray(const vector<real_T>& values, int decimals, size_t group_size = 1, size_t stride = 1)
+        {
+            const size_t begin = size_;
+            for (size_t group = 0; group + group_size <= values.size(); group += group_size * stride) {
+                for (size_t i = 0; i < group_size; ++i)
+                    appendFixed(values[group + i], decimals).append(',');
+            }
+            //drop the trailing comma
+            if (size_ > begin)
+                --size_;
+            return *this;
+        }
+
+    private:
+        // Writes the decimal digits of value and returns the end, out needs room for 20 characters
+        static char* writeUInt(char* out, uint64_t value)
+        {
+            char digits[20];
+            int count = 0;
+            do {
+                digits[sizeof(digits) - 1 - count++] = static_cast<char>('0' + value % 10);
+                value /= 10;
+            } while (value != 0);
+            std::memcpy(out, digits + sizeof(digits) - count, count);
+            return out + count;
+        }
+
+        char* reserve(size_t count)
+        {
+            if (size_ + count > buffer_.size())
+                buffer_.resize(std::max(buffer_.size() * 2, size_ + count));
+            return buffer_.data() + size_;
+        }
+
+    private:
+        vector<char> buffer_;
+        size_t size_ = 0;
+    };
+
+    // Latest value handoff between one producer and one consumer thread (triple buffer). Neither side blocks or
+    // allocates, the consumer only sees the newest value and older unread values are dropped.
+    template <typename T>
+    class ArduPilotLatestValue
+    {
+    public:
+        void publish(const T& value)
+        {
+            buffers_[back_] = value;
+            back_ = middle_.exchange(back_ | kUnread, std::memory_order_acq_rel) & kIndexMask;
+        }
+
+        bool consume(T& value)
+        {
+            if ((middle_.load(std::memory_order_acquire) & kUnread) == 0)
+                return false;
+            front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+            value = buffers_[front_];
+            return true;
+        }
+
+    private:
+        static constexpr uint8_t kIndexMask = 0x3;
+        static constexpr uint8_t kUnread = 0x4;
+
+        T buffers_[3];
+        std::atomic<uint8_t> middle_{ 1 };
+        uint8_t back_ = 0; //producer only
+        uint8_t front_ = 2; //consumer only
+    };
+
+    /*
+    UDP link to the AirSim backend of ArduPilot SITL, shared by the copter and rover APIs.
+
+    ArduPilot only accepts sensor data as a JSON document terminated by a newline, it collects datagrams until it
+    sees the newline. The document is written with ArduPilotJsonWriter and sent in datagrams that fit a 1500 byte
+    MTU, the lidar point cloud is decimated so the document fits the 65000 byte receive buffer of ArduPilot.
+
+    Control packets of type TControlMessage are received on a dedicated thread and handed to the physics thread
+    through ArduPilotLatestValue, so the physics tick never waits for the autopilot. When no new packet arrived
+    the vehicle keeps the last controls.
+
+    With LockStep set explicitly in the vehicle settings (it is off by default for ArduPilot, unlike for PX4) every
+    sensor document is a numbered frame and receiveControl waits for the control packet that
+    answers it. ArduPilot only parses a document once the datagram with its newline arrived, then steps once and
+    answers with one control packet. Its packets carry no frame number, so a packet answers the last frame whose
+    final datagram went out before it arrived, packets arriving while a document is only partly sent still belong
+    to the frame before. A frame that is not answered within
+    LockStepTimeoutMs is resent (ArduPilot steps by zero time on a repeated timestamp) up to LockStepMaxResends
+    times, after that the step is counted as a stall and the bridge runs free until ArduPilot answers again. Lock
+    step only makes runs repeatable when the simulation time does not advance while waiting, which is the case
+    with ClockType SteppableClock, and with a ClockSpeed above 1 the pair then runs as fast as both sides allow.
+    */
+    template <typename TControlMessage>
+    class ArduPilotBridge
+    {
+    public:
+        static constexpr size_t kMaxDatagramSize = 1400;
+        static constexpr size_t kMaxDocumentSize = 65000;
+
+        struct Stats
+        {
+            uint64_t ticks = 0;
+            uint64_t datagrams_sent = 0;
+            uint64_t packets_received = 0;
+            uint64_t packets_malformed = 0;
+            uint64_t lidar_points_dropped = 0;
+            // time spent in the bridge per physics tick, encoding, sending and taking the latest controls (including
+            // the lock step wait)
+            double last_tick_latency_us = 0;
+            double average_tick_latency_us = 0;
+            double max_tick_latency_us = 0;
+            // lock step: frames sent and answered, frames resent and steps given up waiting for an answer
+            uint64_t frames_sent = 0;
+            uint64_t frames_answered = 0;
+            uint64_t resends = 0;
+            uint64_t stalls = 0;
+            // time from sending a frame to receiving its answer
+            double last_step_latency_us = 0;
+            double average_step_latency_us = 0;
+            double max_step_latency_us = 0;
+        };
+
+    public:
+        ArduPilotBridge() = default;
+        ArduPilotBridge(const ArduPilotBridge&) = delete;
+        ArduPilotBridge& operator=(const ArduPilotBridge&) = delete;
+
+        ~ArduPilotBridge()
+        {
+            stop();
+        }
+
+        void start(const AirSimSettings::MavLinkConnectionInfo& connection_info)
+        {
+            stop();
+
+            remote_port_ = static_cast<uint16_t>(connection_info.udp_port);
+            remote_ip_ = connection_info.udp_address;
+
+            if (remote_ip_ == "") {
+                throw std::invalid_argument("UdpIp setting is invalid.");
+            }
+
+            if (remote_port_ == 0) {
+                throw std::invalid_argument("UdpPort setting has an invalid value.");
+            }
+
+            Utils::log(Utils::stringf("Using UDP port %d, local IP %s, remote IP %s for sending sensor data", remote_port_, connection_info.local_host_ip.c_str(), remote_ip_.c_str()), Utils::kLogLevelInfo);
+            Utils::log(Utils::stringf("Using UDP port %d for receiving controls", connection_info.control_port_local), Utils::kLogLevelInfo);
+
+            is_lock_step_ = connection_info.ardupilot_lock_step;
+            lock_step_timeout_ = std::chrono::milliseconds(std::max(1, connection_info.lock_step_timeout_ms));
+            lock_step_max_resends_ = std::max(0, connection_info.lock_step_max_resends);
+            if (is_lock_step_) {
+                Utils::log(Utils::stringf("ArduPilot lock step enabled, timeout %d ms, %d resends", connection_info.lock_step_timeout_ms, lock_step_max_resends_), Utils::kLogLevelInfo);
+                if (AirSimSettings::singleton().clock_type != "SteppableClock")
+                    Utils::log("ArduPilot lock step with a wall clock is not repeatable, use ClockType SteppableClock", Utils::kLogLevelWarn);
+            }
+
+            udp_socket_ = std::make_unique<mavlinkcom::UdpSocket>();
+            udp_socket_->bind(connection_info.local_host_ip, connection_info.control_port_local);
+
+            is_running_ = true;
+            receive_thread_ = std::thread(&ArduPilotBridge::receiveLoop, this);
+        }
+
+        void stop()
+        {
+            is_running_ = false;
+            //the receive thread wakes up at least every receive timeout to check the flag
+            if (receive_thread_.joinable())
+                receive_thread_.join();
+            if (udp_socket_ != nullptr)
+                udp_socket_->close();
+        }
+
+        // Starts a physics tick, the returned writer is cleared for the next sensor document
+        ArduPilotJsonWriter& beginTick()
+        {
+            tick_start_ = std::chrono::steady_clock::now();
+            writer_.clear();
+            return writer_;
+        }
+
+        // Writes the sensor document in the format of the ArduPilot AirSim backend
+        void writeSensors(const SensorCollection& sensors, const ImuBase::Output& imu_output, const GpsBase::Output* gps_output, const RCData* rc_data)
+        {
+            ArduPilotJsonWriter& buf = writer_;
+
+            buf.append("{\"timestamp\": ").appendUInt(ClockFactory::get()->nowNanos() / 1000).append(',');
+
+            buf.append("\"imu\": {\"angular_velocity\": [")
+                .appendFixed(imu_output.angular_velocity[0], 7)
+                .append(',')
+                .appendFixed(imu_output.angular_velocity[1], 7)
+                .append(',')
+                .appendFixed(imu_output.angular_velocity[2], 7)
+                .append("],\"linear_acceleration\": [")
+                .appendFixed(imu_output.linear_acceleration[0], 7)
+                .append(',')
+                .appendFixed(imu_output.linear_acceleration[1], 7)
+                .append(',')
+                .appendFixed(imu_output.linear_acceleration[2], 7)
+                .append("]}");
+
+            float pitch, roll, yaw;
+            VectorMath::toEulerianAngle(imu_output.orientation, pitch, roll, yaw);
+
+            buf.append(",\"pose\": {\"pitch\": ")
+                .appendFixed(pitch, 7)
+                .append(",\"roll\": ")
+                .appendFixed(roll, 7)
+                .append(",\"yaw\": ")
+                .appendFixed(yaw, 7)
+                .append('}');
+
+            if (gps_output != nullptr) {
+                buf.append(",\"gps\": {\"lat\": ")
+                    .appendFixed(gps_output->gnss.geo_point.latitude, 7)
+                    .append(",\"lon\": ")
+                    .appendFixed(gps_output->gnss.geo_point.longitude, 7)
+                    .append(",\"alt\": ")
+                    .appendFixed(gps_output->gnss.geo_point.altitude, 3)
+                    .append("},\"velocity\": {\"world_linear_velocity\": [")
+                    .appendFixed(gps_output->gnss.velocity[0], 3)
+                    .append(',')
+                    .appendFixed(gps_output->gnss.velocity[1], 3)
+                    .append(',')
+                    .appendFixed(gps_output->gnss.velocity[2], 3)
+                    .append("]}");
+            }
+
+            if (rc_data != nullptr) {
+                //4 sticks and 8 switches, with the precision the stream encoder left them: 3 decimals after the gps
+                //altitude, 7 without gps
+                const int rc_decimals = gps_output != nullptr ? 3 : 7;
+                buf.append(",\"rc\": {\"channels\": [")
+                    .appendFixed((rc_data->roll + 1) * 0.5f, rc_decimals)
+                    .append(',')
+                    .appendFixed((rc_data->yaw + 1) * 0.5f, rc_decimals)
+                    .append(',')
+                    .appendFixed((rc_data->throttle + 1) * 0.5f, rc_decimals)
+                    .append(',')
+                    .appendFixed((-rc_data->pitch + 1) * 0.5f, rc_decimals);
+                for (uint16_t i = 0; i < 8; ++i)
+                    buf.append(',').appendFixed(static_cast<float>(rc_data->getSwitch(i)), rc_decimals);
+                buf.append("]}");
+            }
+
+            // More than mm level accuracy isn't needed or expected for distances and points, AP uses meters
+            const uint count_distance_sensors = sensors.size(SensorBase::SensorType::Distance);
+            if (count_distance_sensors != 0) {
+                buf.append(",\"rng\": {\"distances\": [");
+                const char* separator = "";
+                for (uint i = 0; i < count_distance_sensors; ++i) {
+                    const auto* distance_sensor = static_cast<const DistanceSimple*>(sensors.getByType(SensorBase::SensorType::Distance, i));
+                    // Don't send the data if sending to external controller is disabled in settings
+                    if (distance_sensor && distance_sensor->getParams().external_controller) {
+                        buf.append(separator).appendFixed(distance_sensor->getOutput().distance, 3);
+                        separator = ",";
+                    }
+                }
+                buf.append("]}");
+            }
+
+            const uint count_lidars = sensors.size(SensorBase::SensorType::Lidar);
+            if (count_lidars != 0) {
+                buf.append(",\"lidar\": {\"point_cloud\": [");
+                for (uint i = 0; i < count_lidars; ++i) {
+                    const auto* lidar = static_cast<const LidarSimple*>(sensors.getByType(SensorBase::SensorType::Lidar, i));
+                    if (lidar && lidar->getParams().external_controller) {
+                        appendPointCloud(lidar->getOutput().point_cloud);
+                        // AP backend only takes in a single Lidar sensor data currently
+                        break;
+                    }
+                }
+                buf.append("]}");
+            }
+
+            // End of JSON data, AP Parser needs newline
+            buf.append("}\n");
+        }
+
+        // Sends the document as the next frame
+        void sendSensors()
+        {
+            if (udp_socket_ == nullptr)
+                return;
+
+            frame_sent_time_ = std::chrono::steady_clock::now();
+            sendDocument(++stats_.frames_sent);
+        }
+
+        // Takes the newest control packet received since the last call, false if there is none. In lock step this
+        // first waits for the answer to the last frame sent.
+        bool receiveControl(TControlMessage& message)
+        {
+            if (is_lock_step_ && udp_socket_ != nullptr && isLockStepActive())
+                waitForAnswer(sent_frame_.load());
+
+            ControlFrame control;
+            if (!latest_control_.consume(control))
+                return false;
+            message = control.message;
+            return true;
+        }
+
+        // Ends the physics tick started by beginTick and records its latency
+        void endTick()
+        {
+            const double latency_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - tick_start_).count();
+            ++stats_.ticks;
+            stats_.last_tick_latency_us = latency_us;
+            stats_.average_tick_latency_us += (latency_us - stats_.average_tick_latency_us) / static_cast<double>(stats_.ticks);
+            stats_.max_tick_latency_us = std::max(stats_.max_tick_latency_us, latency_us);
+        }
+
+        Stats getStats() const
+        {
+            Stats stats = stats_;
+            stats.packets_received = packets_received_.load();
+            stats.packets_malformed = packets_malformed_.load();
+            return stats;
+        }
+
+        void reportState(StateReporter& reporter) const
+        {
+            const Stats stats = getStats();
+            reporter.writeValue("AP-Ticks", stats.ticks);
+            reporter.writeValue("AP-Latency-us", stats.last_tick_latency_us);
+            reporter.writeValue("AP-Latency-Avg-us", stats.average_tick_latency_us);
+            reporter.writeValue("AP-Latency-Max-us", stats.max_tick_latency_us);
+            reporter.writeValue("AP-Datagrams", stats.datagrams_sent);
+            reporter.writeValue("AP-Received", stats.packets_received);
+            reporter.writeValue("AP-Malformed", stats.packets_malformed);
+            if (is_lock_step_) {
+                reporter.writeValue("AP-Frames", stats.frames_sent);
+                reporter.writeValue("AP-Answered", stats.frames_answered);
+                reporter.writeValue("AP-Resends", stats.resends);
+                reporter.writeValue("AP-Stalls", stats.stalls);
+                reporter.writeValue("AP-Step-us", stats.last_step_latency_us);
+                reporter.writeValue("AP-Step-Avg-us", stats.average_step_latency_us);
+                reporter.writeValue("AP-Step-Max-us", stats.max_step_latency_us);
+            }
+        }
+
+    private:
+        struct ControlFrame
+        {
+            TControlMessage message;
+            uint64_t frame;
+        };
+
+        // Datagrams of at most kMaxDatagramSize bytes, only the last one holds the newline. The last one is sent
+        // and the frame marked as sent under answer_mutex_, so the receive thread, which tags packets under the
+        // same lock, cannot take an answer to the frame before for this one, nor an answer to this one for the
+        // frame before.
+        void sendDocument(uint64_t frame)
+        {
+            size_t offset = 0;
+            for (; offset + kMaxDatagramSize < writer_.size(); offset += kMaxDatagramSize) {
+                udp_socket_->sendto(writer_.data() + offset, static_cast<int>(kMaxDatagramSize), remote_ip_, remote_port_);
+                ++stats_.datagrams_sent;
+            }
+
+            std::lock_guard<std::mutex> lock(answer_mutex_);
+            udp_socket_->sendto(writer_.data() + offset, static_cast<int>(writer_.size() - offset), remote_ip_, remote_port_);
+            ++stats_.datagrams_sent;
+            sent_frame_ = frame;
+        }
+
+        // Lock step starts with the first answer from ArduPilot and is suspended by a stall until the next one
+        bool isLockStepActive() const
+        {
+            return answered_frame_.load() > stalled_frame_;
+        }
+
+        void waitForAnswer(uint64_t frame)
+        {
+            const auto is_answered = [this, frame]() { return answered_frame_.load() >= frame; };
+
+            std::unique_lock<std::mutex> lock(answer_mutex_);
+            for (int attempt = 0;; ++attempt) {
+                if (answer_signal_.wait_for(lock, lock_step_timeout_, is_answered)) {
+                    const double latency_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - frame_sent_time_).count();
+                    ++stats_.frames_answered;
+                    stats_.last_step_latency_us = latency_us;
+                    stats_.average_step_latency_us += (latency_us - stats_.average_step_latency_us) / static_cast<double>(stats_.frames_answered);
+                    stats_.max_step_latency_us = std::max(stats_.max_step_latency_us, latency_us);
+                    return;
+                }
+                if (attempt == lock_step_max_resends_)
+                    break;
+
+                lock.unlock();
+                sendDocument(frame);
+                ++stats_.resends;
+                lock.lock();
+            }
+
+            ++stats_.stalls;
+            stalled_frame_ = frame;
+            Utils::log(Utils::stringf("No controls from ArduPilot for frame %llu, lock step suspended", static_cast<unsigned long long>(frame)), Utils::kLogLevelWarn);
+        }
+
+        void appendPointCloud(const vector<real_T>& point_cloud)
+        {
+            //a point takes at most 3 * 12 characters at mm precision within +-10km, keep a margin for the closing
+            static constexpr size_t kMaxPointSize = 36;
+            static constexpr size_t kDocumentMargin = 64;
+
+            const size_t point_count = point_cloud.size() / 3;
+            const size_t budget = kMaxDocumentSize > writer_.size() + kDocumentMargin ? kMaxDocumentSize - writer_.size() - kDocumentMargin : 0;
+            const size_t max_points = budget / kMaxPointSize;
+            if (max_points == 0)
+                return;
+
+            const size_t stride = (point_count + max_points - 1) / max_points;
+            if (stride > 1)
+                stats_.lidar_points_dropped += point_count - (point_count + stride - 1) / stride;
+            writer_.appendArray(point_cloud, 3, 3, std::max<size_t>(stride, 1));
+        }
+
+        void receiveLoop()
+        {
+            ControlFrame control;
+            bool is_connected = false;
+            while (is_running_) {
+                const int received = udp_socket_->recv(&control.message, sizeof(control.message), kReceiveTimeoutMs);
+                if (received == static_cast<int>(sizeof(control.message))) {
+                    {
+                        std::lock_guard<std::mutex> lock(answer_mutex_);
+                        control.frame = sent_frame_.load();
+                        latest_control_.publish(control);
+                        answered_frame_ = control.frame;
+                    }
+                    ++packets_received_;
+                    answer_signal_.notify_one();
+                    if (!is_connected) {
+                        Utils::log("Receiving controls from ArduPilot", Utils::kLogLevelInfo);
+                        is_connected = true;
+                    }
+                }
+                else if (received > 0) {
+                    ++packets_malformed_;
+                }
+                //timeouts and errors are retried, the physics thread keeps the last controls meanwhile
+            }
+        }
+
+    private:
+        static constexpr int kReceiveTimeoutMs = 100;
+
+        std::unique_ptr<mavlinkcom::UdpSocket> udp_socket_;
+        uint16_t remote_port_ = 0;
+        std::string remote_ip_;
+
+        std::thread receive_thread_;
+        std::atomic<bool> is_running_{ false };
+        ArduPilotLatestValue<ControlFrame> latest_control_;
+        std::atomic<uint64_t> packets_received_{ 0 };
+        std::atomic<uint64_t> packets_malformed_{ 0 };
+
+        bool is_lock_step_ = false;
+        std::chrono::milliseconds lock_step_timeout_{ 100 };
+        int lock_step_max_resends_ = 0;
+        std::atomic<uint64_t> sent_frame_{ 0 };
+        std::atomic<uint64_t> answered_frame_{ 0 };
+        std::mutex answer_mutex_;
+        std::condition_variable answer_signal_;
+
+        //physics thread only
+        ArduPilotJsonWriter writer_;
+        std::chrono::steady_clock::time_point frame_sent_time_;
+        uint64_t stalled_frame_ = 0;
+        std::chrono::steady_clock::time_point tick_start_;
+        Stats stats_;
+    };
+}
+} //namespace
+#endif
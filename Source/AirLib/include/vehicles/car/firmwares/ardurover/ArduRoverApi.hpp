@@ -18,9 +18,7 @@
 #include "sensors/distance/DistanceSimple.hpp"
 #include "sensors/lidar/LidarSimple.hpp"
 
-#include "UdpSocket.hpp"
-
-#include <sstream>
+#include "vehicles/ArduPilotBridge.hpp"
 
 namespace msr
 {
@@ -58,8 +56,17 @@ namespace airlib
         {
             CarApiBase::update(delta);
 
+            bridge_.beginTick();
             sendSensors();
             recvRoverControl();
+            bridge_.endTick();
+        }
+
+        virtual void reportState(StateReporter& reporter) override
+        {
+            CarApiBase::reportState(reporter);
+
+            bridge_.reportState(reporter);
         }
 
         virtual const SensorCollection& getSensors() const override
@@ -122,48 +129,21 @@ namespace airlib
     protected:
         void closeConnections()
         {
-            if (udp_socket_ != nullptr)
-                udp_socket_->close();
+            bridge_.stop();
         }
 
         void connect()
         {
-            port_ = static_cast<uint16_t>(connection_info_.udp_port);
-            ip_ = connection_info_.udp_address;
-
-            closeConnections();
-
-            if (ip_ == "") {
-                throw std::invalid_argument("UdpIp setting is invalid.");
-            }
-
-            if (port_ == 0) {
-                throw std::invalid_argument("UdpPort setting has an invalid value.");
-            }
-
-            Utils::log(Utils::stringf("Using UDP port %d, local IP %s, remote IP %s for sending sensor data", port_, connection_info_.local_host_ip.c_str(), ip_.c_str()), Utils::kLogLevelInfo);
-            Utils::log(Utils::stringf("Using UDP port %d for receiving rotor power", connection_info_.control_port_local, connection_info_.local_host_ip.c_str(), ip_.c_str()), Utils::kLogLevelInfo);
-
-            udp_socket_ = std::make_unique<mavlinkcom::UdpSocket>();
-            udp_socket_->bind(connection_info_.local_host_ip, connection_info_.control_port_local);
+            bridge_.start(connection_info_);
         }
 
     private:
         void recvRoverControl()
         {
-            // Receive motor data
+            // Take the newest control data, keep the last controls until ArduPilot sends new ones
             RoverControlMessage pkt;
-            int recv_ret = udp_socket_->recv(&pkt, sizeof(pkt), 100);
-            while (recv_ret != sizeof(pkt)) {
-                if (recv_ret <= 0) {
-                    Utils::log(Utils::stringf("Error while receiving rotor control data - ErrorNo: %d", recv_ret), Utils::kLogLevelInfo);
-                }
-                else {
-                    Utils::log(Utils::stringf("Received %d bytes instead of %zu bytes", recv_ret, sizeof(pkt)), Utils::kLogLevelInfo);
-                }
-
-                recv_ret = udp_socket_->recv(&pkt, sizeof(pkt), 100);
-            }
+            if (!bridge_.receiveControl(pkt))
+                return;
 
             last_controls_.throttle = pkt.throttle;
             last_controls_.steering = pkt.steering;
@@ -180,126 +160,13 @@ namespace airlib
 
         void sendSensors()
         {
-            if (sensors_ == nullptr || udp_socket_ == nullptr)
+            if (sensors_ == nullptr)
                 return;
 
-            std::ostringstream buf;
-
-            // Start of JSON element
-            buf << "{";
-
-            buf << "\"timestamp\": " << ClockFactory::get()->nowNanos() / 1000 << ",";
-
-            const auto& imu_output = getImuData("");
-
-            buf << "\"imu\": {"
-                << std::fixed << std::setprecision(7)
-                << "\"angular_velocity\": ["
-                << imu_output.angular_velocity[0] << ","
-                << imu_output.angular_velocity[1] << ","
-                << imu_output.angular_velocity[2] << "]"
-                << ","
-                << "\"linear_acceleration\": ["
-                << imu_output.linear_acceleration[0] << ","
-                << imu_output.linear_acceleration[1] << ","
-                << imu_output.linear_acceleration[2] << "]"
-                << "}";
-
-            float pitch, roll, yaw;
-            VectorMath::toEulerianAngle(imu_output.orientation, pitch, roll, yaw);
-
-            buf << ","
-                << "\"pose\": {"
-                << "\"pitch\": " << pitch << ","
-                << "\"roll\": " << roll << ","
-                << "\"yaw\": " << yaw
-                << "}";
-
-            const uint count_gps_sensors = sensors_->size(SensorBase::SensorType::Gps);
-            if (count_gps_sensors != 0) {
-                const auto& gps_output = getGpsData("");
-
-                buf << ","
-                       "\"gps\": {"
-                    << std::fixed << std::setprecision(7)
-                    << "\"lat\": " << gps_output.gnss.geo_point.latitude << ","
-                    << "\"lon\": " << gps_output.gnss.geo_point.longitude << ","
-                    << std::setprecision(3) << "\"alt\": " << gps_output.gnss.geo_point.altitude
-                    << "},"
-
-                    << "\"velocity\": {"
-                    << "\"world_linear_velocity\": ["
-                    << gps_output.gnss.velocity[0] << ","
-                    << gps_output.gnss.velocity[1] << ","
-                    << gps_output.gnss.velocity[2] << "]"
-                                                      "}";
-            }
+            const GpsBase::Output* gps_output = sensors_->size(SensorBase::SensorType::Gps) != 0 ? &getGpsData("") : nullptr;
 
-            // Send Distance Sensors data if present
-            const uint count_distance_sensors = sensors_->size(SensorBase::SensorType::Distance);
-            if (count_distance_sensors != 0) {
-                // Start JSON element
-                buf << ","
-                       "\"rng\": {"
-                       "\"distances\": [";
-
-                // More than mm level accuracy isn't needed or used
-                buf << std::fixed << std::setprecision(3);
-
-                // Used to avoid trailing comma
-                std::string sep = "";
-
-                // Add sensor outputs in the array
-                for (uint i = 0; i < count_distance_sensors; ++i) {
-                    const auto* distance_sensor = static_cast<const DistanceSimple*>(
-                        sensors_->getByType(SensorBase::SensorType::Distance, i));
-                    // Don't send the data if sending to external controller is disabled in settings
-                    if (distance_sensor && distance_sensor->getParams().external_controller) {
-                        const auto& distance_output = distance_sensor->getOutput();
-                        // AP uses meters so no need to convert here
-                        buf << sep << distance_output.distance;
-                        sep = ",";
-                    }
-                }
-
-                // Close JSON array & element
-                buf << "]}";
-            }
-
-            const uint count_lidars = sensors_->size(SensorBase::SensorType::Lidar);
-            if (count_lidars != 0) {
-                buf << ","
-                       "\"lidar\": {"
-                       "\"point_cloud\": [";
-
-                // More than mm level accuracy isn't needed or used
-                buf << std::fixed << std::setprecision(3);
-
-                // Add sensor outputs in the array
-                for (uint i = 0; i < count_lidars; ++i) {
-                    const auto* lidar = static_cast<const LidarSimple*>(sensors_->getByType(SensorBase::SensorType::Lidar, i));
-
-                    if (lidar && lidar->getParams().external_controller) {
-                        const auto& lidar_output = lidar->getOutput();
-                        std::copy(lidar_output.point_cloud.begin(), lidar_output.point_cloud.end(), std::ostream_iterator<real_T>(buf, ","));
-                        // AP backend only takes in a single Lidar sensor data currently
-                        break;
-                    }
-                }
-
-                // Close JSON array & element
-                buf << "]}";
-            }
-
-            // End of JSON, AP Parser needs newline
-            buf << "}\n";
-
-            // str copy is made since if later on something like -
-            //  const char* ptr = buf.str().c_str()
-            // is written, ptr is invalid since buf.str() is a temporary copy
-            // Currently there's no way to get pointer to underlying buffer
-            const std::string sensor_data = buf.str();
-            udp_socket_->sendto(sensor_data.c_str(), sensor_data.length(), ip_, port_);
+            bridge_.writeSensors(*sensors_, getImuData(""), gps_output, nullptr);
+            bridge_.sendSensors();
         }
 
     private:
@@ -311,10 +178,7 @@ namespace airlib
 
         AirSimSettings::MavLinkConnectionInfo connection_info_;
 
-        std::unique_ptr<mavlinkcom::UdpSocket> udp_socket_;
-
-        uint16_t port_;
-        std::string ip_;
+        ArduPilotBridge<RoverControlMessage> bridge_;
 
         const SensorCollection* sensors_;
 
@@ -42,6 +42,11 @@ namespace airlib
 
         virtual void update(float delta = 0) override
         {
+            //controllers that run in a swarm deliver their output after all vehicles were updated, or here when
+            //a vehicle of the swarm was not updated in the last step. Pick it up before the rotors use it.
+            vehicle_api_->completeActuation();
+            transferActuation();
+
             //update forces on vertices that we will use next
             PhysicsBody::update(delta);
 
@@ -89,7 +94,12 @@ namespace airlib
             //update controller which will update actuator control signal
             vehicle_api_->update();
 
-            //transfer new input values from controller to rotors
+            transferActuation();
+        }
+
+        //transfer new input values from controller to rotors
+        void transferActuation()
+        {
             for (uint rotor_index = 0; rotor_index < rotors_.size(); ++rotor_index) {
                 rotors_.at(rotor_index).setControlSignal(vehicle_api_->getActuation(rotor_index));
             }
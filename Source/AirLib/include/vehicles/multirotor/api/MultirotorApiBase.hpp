@@ -10,10 +10,13 @@
 #include "physics/Kinematics.hpp"
 #include "physics/Environment.hpp"
 #include "api/VehicleApiBase.hpp"
+#include "common/MinimumSnapTrajectory.hpp"
 
 #include <atomic>
 #include <thread>
 #include <memory>
+#include <mutex>
+#include <exception>
 
 namespace msr
 {
@@ -80,6 +83,9 @@ namespace airlib
 
         virtual void resetImplementation() override;
 
+        //derived classes must call this from their update so moveOnPath can track its trajectory
+        virtual void update(float delta = 0) override;
+
     public: //these APIs uses above low level APIs
         virtual ~MultirotorApiBase() = default;
 
@@ -102,8 +108,13 @@ namespace airlib
         virtual bool moveByAngleRatesThrottle(float roll_rate, float pitch_rate, float yaw_rate, float throttle, float duration);
         virtual bool moveByVelocity(float vx, float vy, float vz, float duration, DrivetrainType drivetrain, const YawMode& yaw_mode);
         virtual bool moveByVelocityZ(float vx, float vy, float z, float duration, DrivetrainType drivetrain, const YawMode& yaw_mode);
+        //moveOnPath, moveToPosition, moveToZ and moveToGPS plan a trajectory and track it, lookahead and adaptive_lookahead
+        //of the old carrot follower are deprecated and ignored
         virtual bool moveOnPath(const vector<Vector3r>& path, float velocity, float timeout_sec, DrivetrainType drivetrain, const YawMode& yaw_mode,
                                 float lookahead, float adaptive_lookahead);
+        //applies commands[i] to apis[i], or commands[0] to all of them, in the same physics step. Waits until every
+        //vehicle or the first vehicle is done and returns which vehicles completed their command.
+        static vector<bool> moveSwarm(const vector<MultirotorApiBase*>& apis, const vector<SwarmCommand>& commands, SwarmWaitMode wait_mode);
         virtual bool moveToPosition(float x, float y, float z, float velocity, float timeout_sec, DrivetrainType drivetrain,
                                     const YawMode& yaw_mode, float lookahead, float adaptive_lookahead);
         virtual bool moveToZ(float z, float velocity, float timeout_sec, const YawMode& yaw_mode,
@@ -145,6 +156,8 @@ namespace airlib
             return state;
         }
 
+        PathProgress getPathProgress() const;
+
         /******************* Task management Apis ********************/
         virtual void cancelLastTask() override
         {
@@ -297,31 +310,30 @@ namespace airlib
         };
 
     private: //types
-        struct PathPosition
-        {
-            uint seg_index;
-            float offset;
-            Vector3r position;
-        };
-
-        struct PathSegment
+        //command flown by update() on the physics thread while the caller only waits, see moveOnPath and moveSwarm
+        struct TrackedTask
         {
-            Vector3r seg_normalized;
-            Vector3r seg;
-            float seg_length;
-            float seg_velocity;
-            float start_z;
-            float seg_path_length;
-
-            PathSegment(const Vector3r& start, const Vector3r& end, float velocity, float path_length)
+            //trajectory to track, null holds velocity for duration instead
+            std::shared_ptr<const MinimumSnapTrajectory> trajectory;
+            Vector3r velocity = Vector3r::Zero();
+            TTimeDelta duration = 0;
+            TTimeDelta timeout_sec = Utils::max<TTimeDelta>();
+            //swarm tasks wait for this physics step so that they all start together, 0 while the swarm is being set up
+            //and kSwarmStartReleased until the physics thread picks the step
+            std::shared_ptr<std::atomic<uint64_t>> start_step;
+            DrivetrainType drivetrain = DrivetrainType::MaxDegreeOfFreedom;
+            YawMode yaw_mode;
+
+            bool is_started = false;
+            TTimePoint start_time = 0;
+            TTimePoint last_command_time = 0;
+            bool is_complete = false;
+            bool is_timeout = false;
+            std::exception_ptr error;
+
+            bool isDone() const
             {
-                seg = end - start;
-                seg_length = seg.norm();
-                seg_normalized = seg.normalized();
-                start_z = start.z();
-                seg_path_length = path_length;
-
-                seg_velocity = velocity;
+                return is_complete || is_timeout || error != nullptr;
             }
         };
 
@@ -346,11 +358,13 @@ namespace airlib
         };
 
     private: //methods
-        float setNextPathPosition(const vector<Vector3r>& path, const vector<PathSegment>& path_segs,
-                                  const PathPosition& cur_path_loc, float next_dist, PathPosition& next_path_loc);
+        std::unique_ptr<TrackedTask> createPathTask(const vector<Vector3r>& path, float velocity, DrivetrainType drivetrain, const YawMode& yaw_mode);
+        void setTrackedTask(std::unique_ptr<TrackedTask> task);
+        std::unique_ptr<TrackedTask> takeTrackedTask();
+        bool isTrackedTaskDone() const;
+        void updateTrackedTask();
         void adjustYaw(const Vector3r& heading, DrivetrainType drivetrain, YawMode& yaw_mode);
         void adjustYaw(float x, float y, DrivetrainType drivetrain, YawMode& yaw_mode);
-        void moveToPathPosition(const Vector3r& dest, float velocity, DrivetrainType drivetrain, /* pass by value */ YawMode yaw_mode, float last_z);
         bool isYawWithinMargin(float yaw_target, float margin) const;
 
     private: //variables
@@ -365,6 +379,13 @@ namespace airlib
         float approx_zero_vel_ = 0.05f;
         float approx_zero_angular_vel_ = 0.01f;
         RotorStates rotor_states_;
+
+        mutable std::mutex tracked_task_mutex_;
+        std::unique_ptr<TrackedTask> tracked_task_;
+
+        //command periods moveSwarm waits beyond its longest task, covers the step the tasks start at
+        static constexpr float kSwarmStartSlackPeriods = 10;
+        static constexpr uint64_t kSwarmStartReleased = std::numeric_limits<uint64_t>::max();
     };
 }
 } //namespace
@@ -110,6 +110,78 @@ namespace airlib
         //what is the +/-window we should check on obstacle map?
         //for example 2 means check from ticks -2 to 2
         int obs_window = 0;
+        //same for the elevation sectors of a 3D obstacle map, 0 checks only the sector of the destination
+        int obs_sector_window = 0;
+
+        //moveOnPath plans a trajectory with this acceleration limit and tracks it with velocity commands,
+        //position error is corrected with path_position_gain (1/s)
+        float path_max_acceleration = 4.0f;
+        float path_position_gain = 1.0f;
+        //the planned velocity is commanded this many seconds early to make up for the lag of the velocity controller
+        float path_velocity_lead = 0.0f;
+        //moveOnPath completes once the trajectory has ended and the vehicle is within this distance of the last point
+        float path_end_margin = 0.5f;
+    };
+
+    struct PathProgress
+    {
+        bool is_active = false;
+        //index in to the moveOnPath path of the waypoint the vehicle is heading to
+        uint waypoint_index = 0;
+        //fraction of the path length covered, measured along straight lines between waypoints
+        float progress = 0;
+        float elapsed_sec = 0;
+        float remaining_sec = 0;
+    };
+
+    enum class SwarmWaitMode : uint
+    {
+        WaitAll = 0,
+        WaitAny = 1
+    };
+
+    //one vehicle's share of MultirotorApiBase::moveSwarm
+    struct SwarmCommand
+    {
+        enum class Type
+        {
+            Velocity = 0,
+            Path
+        };
+
+        Type type = Type::Velocity;
+        //Velocity: hold this velocity in world frame for duration seconds
+        Vector3r velocity = Vector3r::Zero();
+        float duration = 0;
+        //Path: fly from the current position through the path, completes on arrival or fails after timeout_sec
+        vector<Vector3r> path;
+        float max_velocity = 0;
+        float timeout_sec = 0;
+        DrivetrainType drivetrain = DrivetrainType::MaxDegreeOfFreedom;
+        YawMode yaw_mode;
+
+        static SwarmCommand byVelocity(const Vector3r& velocity_val, float duration_val, DrivetrainType drivetrain_val, const YawMode& yaw_mode_val)
+        {
+            SwarmCommand command;
+            command.type = Type::Velocity;
+            command.velocity = velocity_val;
+            command.duration = duration_val;
+            command.drivetrain = drivetrain_val;
+            command.yaw_mode = yaw_mode_val;
+            return command;
+        }
+
+        static SwarmCommand onPath(const vector<Vector3r>& path_val, float max_velocity_val, float timeout_sec_val, DrivetrainType drivetrain_val, const YawMode& yaw_mode_val)
+        {
+            SwarmCommand command;
+            command.type = Type::Path;
+            command.path = path_val;
+            command.max_velocity = max_velocity_val;
+            command.timeout_sec = timeout_sec_val;
+            command.drivetrain = drivetrain_val;
+            command.yaw_mode = yaw_mode_val;
+            return command;
+        }
     };
 
     struct MultirotorState
@@ -99,6 +99,41 @@ namespace airlib_rpclib
             }
         };
 
+        struct PathProgress
+        {
+            bool is_active;
+            uint waypoint_index;
+            float progress;
+            float elapsed_sec;
+            float remaining_sec;
+
+            MSGPACK_DEFINE_MAP(is_active, waypoint_index, progress, elapsed_sec, remaining_sec);
+
+            PathProgress()
+            {
+            }
+
+            PathProgress(const msr::airlib::PathProgress& s)
+            {
+                is_active = s.is_active;
+                waypoint_index = s.waypoint_index;
+                progress = s.progress;
+                elapsed_sec = s.elapsed_sec;
+                remaining_sec = s.remaining_sec;
+            }
+
+            msr::airlib::PathProgress to() const
+            {
+                msr::airlib::PathProgress d;
+                d.is_active = is_active;
+                d.waypoint_index = waypoint_index;
+                d.progress = progress;
+                d.elapsed_sec = elapsed_sec;
+                d.remaining_sec = remaining_sec;
+                return d;
+            }
+        };
+
         struct MultirotorState
         {
             CollisionInfo collision;
@@ -143,5 +178,6 @@ namespace airlib_rpclib
 
 MSGPACK_ADD_ENUM(msr::airlib::DrivetrainType);
 MSGPACK_ADD_ENUM(msr::airlib::LandedState);
+MSGPACK_ADD_ENUM(msr::airlib::SwarmWaitMode);
 
 #endif
@@ -26,6 +26,7 @@ namespace airlib
         MultirotorRpcLibClient* landAsync(float timeout_sec = 60, const std::string& vehicle_name = "");
         MultirotorRpcLibClient* goHomeAsync(float timeout_sec = Utils::max<float>(), const std::string& vehicle_name = "");
 
+        //lookahead and adaptive_lookahead of the move*Async path calls are deprecated and ignored by the server
         MultirotorRpcLibClient* moveToGPSAsync(float latitude, float longitude, float altitude, float velocity, float timeout_sec = Utils::max<float>(),
                                                DrivetrainType drivetrain = DrivetrainType::MaxDegreeOfFreedom, const YawMode& yaw_mode = YawMode(),
                                                float lookahead = -1, float adaptive_lookahead = 1, const std::string& vehicle_name = "");
@@ -58,6 +59,15 @@ namespace airlib
         MultirotorRpcLibClient* rotateByYawRateAsync(float yaw_rate, float duration, const std::string& vehicle_name = "");
         MultirotorRpcLibClient* hoverAsync(const std::string& vehicle_name = "");
 
+        //swarm commands start all vehicles in the same physics step, pass one argument for all vehicles or one per vehicle.
+        //They block until all or any of the vehicles are done and return which vehicles completed.
+        vector<bool> moveSwarmByVelocity(const vector<std::string>& vehicle_names, const vector<Vector3r>& velocities, float duration,
+                                         DrivetrainType drivetrain = DrivetrainType::MaxDegreeOfFreedom, const YawMode& yaw_mode = YawMode(), SwarmWaitMode wait_mode = SwarmWaitMode::WaitAll);
+        vector<bool> moveSwarmToPosition(const vector<std::string>& vehicle_names, const vector<Vector3r>& positions, float velocity, float timeout_sec = Utils::max<float>(),
+                                         DrivetrainType drivetrain = DrivetrainType::MaxDegreeOfFreedom, const YawMode& yaw_mode = YawMode(), SwarmWaitMode wait_mode = SwarmWaitMode::WaitAll);
+        vector<bool> moveSwarmOnPath(const vector<std::string>& vehicle_names, const vector<vector<Vector3r>>& paths, float velocity, float timeout_sec = Utils::max<float>(),
+                                     DrivetrainType drivetrain = DrivetrainType::MaxDegreeOfFreedom, const YawMode& yaw_mode = YawMode(), SwarmWaitMode wait_mode = SwarmWaitMode::WaitAll);
+
         void setAngleLevelControllerGains(const vector<float>& kp, const vector<float>& ki, const vector<float>& kd, const std::string& vehicle_name = "");
         void setAngleRateControllerGains(const vector<float>& kp, const vector<float>& ki, const vector<float>& kd, const std::string& vehicle_name = "");
         void setVelocityControllerGains(const vector<float>& kp, const vector<float>& ki, const vector<float>& kd, const std::string& vehicle_name = "");
@@ -66,6 +76,7 @@ namespace airlib
 
         MultirotorState getMultirotorState(const std::string& vehicle_name = "");
         RotorStates getRotorStates(const std::string& vehicle_name = "");
+        PathProgress getPathProgress(const std::string& vehicle_name = "");
 
         bool setSafety(SafetyEval::SafetyViolationType enable_reasons, float obs_clearance, SafetyEval::ObsAvoidanceStrategy obs_startegy,
                        float obs_avoidance_vel, const Vector3r& origin, float xy_length, float max_z, float min_z, const std::string& vehicle_name = "");
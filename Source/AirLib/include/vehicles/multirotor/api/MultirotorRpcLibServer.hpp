@@ -25,6 +25,15 @@ namespace airlib
         {
             return static_cast<MultirotorApiBase*>(RpcLibServerBase::getVehicleApi(vehicle_name));
         }
+
+        vector<MultirotorApiBase*> getVehicleApis(const vector<std::string>& vehicle_names)
+        {
+            vector<MultirotorApiBase*> apis;
+            apis.reserve(vehicle_names.size());
+            for (const auto& vehicle_name : vehicle_names)
+                apis.push_back(getVehicleApi(vehicle_name));
+            return apis;
+        }
     };
 }
 } //namespace
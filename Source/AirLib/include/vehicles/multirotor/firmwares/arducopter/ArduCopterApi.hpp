@@ -21,9 +21,7 @@
 #include "sensors/distance/DistanceSimple.hpp"
 #include "sensors/lidar/LidarSimple.hpp"
 
-#include "UdpSocket.hpp"
-
-#include <sstream>
+#include "vehicles/ArduPilotBridge.hpp"
 
 namespace msr
 {
@@ -60,8 +58,17 @@ namespace airlib
         {
             MultirotorApiBase::update(delta);
 
+            bridge_.beginTick();
             sendSensors();
             recvRotorControl();
+            bridge_.endTick();
+        }
+
+        virtual void reportState(StateReporter& reporter) override
+        {
+            MultirotorApiBase::reportState(reporter);
+
+            bridge_.reportState(reporter);
         }
 
         // TODO:VehicleApiBase implementation
@@ -298,30 +305,12 @@ namespace airlib
     protected:
         void closeConnections()
         {
-            if (udp_socket_ != nullptr)
-                udp_socket_->close();
+            bridge_.stop();
         }
 
         void connect()
         {
-            port_ = static_cast<uint16_t>(connection_info_.udp_port);
-            ip_ = connection_info_.udp_address;
-
-            closeConnections();
-
-            if (ip_ == "") {
-                throw std::invalid_argument("UdpIp setting is invalid.");
-            }
-
-            if (port_ == 0) {
-                throw std::invalid_argument("UdpPort setting has an invalid value.");
-            }
-
-            Utils::log(Utils::stringf("Using UDP port %d, local IP %s, remote IP %s for sending sensor data", port_, connection_info_.local_host_ip.c_str(), ip_.c_str()), Utils::kLogLevelInfo);
-            Utils::log(Utils::stringf("Using UDP port %d for receiving rotor power", connection_info_.control_port_local, connection_info_.local_host_ip.c_str(), ip_.c_str()), Utils::kLogLevelInfo);
-
-            udp_socket_ = std::make_unique<mavlinkcom::UdpSocket>();
-            udp_socket_->bind(connection_info_.local_host_ip, connection_info_.control_port_local);
+            bridge_.start(connection_info_);
         }
 
     private:
@@ -335,162 +324,23 @@ namespace airlib
 
         void sendSensors()
         {
-            if (sensors_ == nullptr || udp_socket_ == nullptr)
+            if (sensors_ == nullptr)
                 return;
 
-            std::ostringstream buf;
-
-            // Start of JSON element
-            buf << "{";
-
-            buf << "\"timestamp\": " << ClockFactory::get()->nowNanos() / 1000 << ",";
-
-            const auto& imu_output = getImuData("");
-
-            buf << "\"imu\": {"
-                << std::fixed << std::setprecision(7)
-                << "\"angular_velocity\": ["
-                << imu_output.angular_velocity[0] << ","
-                << imu_output.angular_velocity[1] << ","
-                << imu_output.angular_velocity[2] << "]"
-                << ","
-                << "\"linear_acceleration\": ["
-                << imu_output.linear_acceleration[0] << ","
-                << imu_output.linear_acceleration[1] << ","
-                << imu_output.linear_acceleration[2] << "]"
-                << "}";
-
-            float pitch, roll, yaw;
-            VectorMath::toEulerianAngle(imu_output.orientation, pitch, roll, yaw);
-
-            buf << ","
-                << "\"pose\": {"
-                << "\"pitch\": " << pitch << ","
-                << "\"roll\": " << roll << ","
-                << "\"yaw\": " << yaw
-                << "}";
-
-            const uint count_gps_sensors = sensors_->size(SensorBase::SensorType::Gps);
-            if (count_gps_sensors != 0) {
-                const auto& gps_output = getGpsData("");
-
-                buf << ","
-                       "\"gps\": {"
-                    << std::fixed << std::setprecision(7)
-                    << "\"lat\": " << gps_output.gnss.geo_point.latitude << ","
-                    << "\"lon\": " << gps_output.gnss.geo_point.longitude << ","
-                    << std::setprecision(3) << "\"alt\": " << gps_output.gnss.geo_point.altitude
-                    << "},"
-
-                    << "\"velocity\": {"
-                    << "\"world_linear_velocity\": ["
-                    << gps_output.gnss.velocity[0] << ","
-                    << gps_output.gnss.velocity[1] << ","
-                    << gps_output.gnss.velocity[2] << "]"
-                                                      "}";
-            }
-
+            const GpsBase::Output* gps_output = sensors_->size(SensorBase::SensorType::Gps) != 0 ? &getGpsData("") : nullptr;
             // Send RC channels to Ardupilot if present
-            if (is_rc_connected_ && last_rcData_.is_valid) {
-                buf << ","
-                       "\"rc\": {"
-                       "\"channels\": ["
-                    << (last_rcData_.roll + 1) * 0.5f << ","
-                    << (last_rcData_.yaw + 1) * 0.5f << ","
-                    << (last_rcData_.throttle + 1) * 0.5f << ","
-                    << (-last_rcData_.pitch + 1) * 0.5f;
-
-                // Add switches to RC channels array, 8 switches
-                for (uint8_t i = 0; i < 8; ++i) {
-                    buf << "," << static_cast<float>(last_rcData_.getSwitch(i));
-                }
-
-                // Close JSON array & element
-                buf << "]}";
-            }
-
-            // Send Distance Sensors data if present
-            const uint count_distance_sensors = sensors_->size(SensorBase::SensorType::Distance);
-            if (count_distance_sensors != 0) {
-                // Start JSON element
-                buf << ","
-                       "\"rng\": {"
-                       "\"distances\": [";
-
-                // More than mm level accuracy isn't needed or expected
-                buf << std::fixed << std::setprecision(3);
-
-                // Used to avoid trailing comma
-                std::string sep = "";
-
-                // Add sensor outputs in the array
-                for (uint i = 0; i < count_distance_sensors; ++i) {
-                    const auto* distance_sensor = static_cast<const DistanceSimple*>(
-                        sensors_->getByType(SensorBase::SensorType::Distance, i));
-                    // Don't send the data if sending to external controller is disabled in settings
-                    if (distance_sensor && distance_sensor->getParams().external_controller) {
-                        const auto& distance_output = distance_sensor->getOutput();
-                        // AP uses meters so no need to convert here
-                        buf << sep << distance_output.distance;
-                        sep = ",";
-                    }
-                }
-
-                // Close JSON array & element
-                buf << "]}";
-            }
+            const RCData* rc_data = is_rc_connected_ && last_rcData_.is_valid ? &last_rcData_ : nullptr;
 
-            const uint count_lidars = sensors_->size(SensorBase::SensorType::Lidar);
-            if (count_lidars != 0) {
-                buf << ","
-                       "\"lidar\": {"
-                       "\"point_cloud\": [";
-
-                // More than mm level accuracy isn't needed or expected
-                buf << std::fixed << std::setprecision(3);
-
-                // Add sensor outputs in the array
-                for (uint i = 0; i < count_lidars; ++i) {
-                    const auto* lidar = static_cast<const LidarSimple*>(sensors_->getByType(SensorBase::SensorType::Lidar, i));
-
-                    if (lidar && lidar->getParams().external_controller) {
-                        const auto& lidar_output = lidar->getOutput();
-                        std::copy(lidar_output.point_cloud.begin(), lidar_output.point_cloud.end(), std::ostream_iterator<real_T>(buf, ","));
-                        // AP backend only takes in a single Lidar sensor data currently
-                        break;
-                    }
-                }
-
-                // Close JSON array & element
-                buf << "]}";
-            }
-
-            // End of JSON data, AP Parser needs newline
-            buf << "}\n";
-
-            // str copy is made since if later on something like -
-            //  const char* ptr = buf.str().c_str()
-            // is written, ptr is invalid since buf.str() is a temporary copy
-            // Currently there's no way to get pointer to underlying buffer
-            const std::string sensor_data = buf.str();
-            udp_socket_->sendto(sensor_data.c_str(), sensor_data.length(), ip_, port_);
+            bridge_.writeSensors(*sensors_, getImuData(""), gps_output, rc_data);
+            bridge_.sendSensors();
         }
 
         void recvRotorControl()
         {
-            // Receive motor data
+            // Take the newest motor data, keep the last rotor controls until ArduPilot sends new ones
             RotorControlMessage pkt;
-            int recv_ret = udp_socket_->recv(&pkt, sizeof(pkt), 100);
-            while (recv_ret != sizeof(pkt)) {
-                if (recv_ret <= 0) {
-                    Utils::log(Utils::stringf("Error while receiving rotor control data - ErrorNo: %d", recv_ret), Utils::kLogLevelInfo);
-                }
-                else {
-                    Utils::log(Utils::stringf("Received %d bytes instead of %zu bytes", recv_ret, sizeof(pkt)), Utils::kLogLevelInfo);
-                }
-
-                recv_ret = udp_socket_->recv(&pkt, sizeof(pkt), 100);
-            }
+            if (!bridge_.receiveControl(pkt))
+                return;
 
             for (auto i = 0; i < kArduCopterRotorControlCount; ++i) {
                 rotor_controls_[i] = pkt.pwm[i];
@@ -507,20 +357,18 @@ namespace airlib
             uint16_t pwm[kArduCopterRotorControlCount];
         };
 
-        std::unique_ptr<mavlinkcom::UdpSocket> udp_socket_;
+        ArduPilotBridge<RotorControlMessage> bridge_;
 
         AirSimSettings::MavLinkConnectionInfo connection_info_;
-        uint16_t port_;
-        std::string ip_;
         const SensorCollection* sensors_;
         const MultiRotorParams* vehicle_params_;
 
         MultirotorApiParams safety_params_;
 
         RCData last_rcData_;
-        bool is_rc_connected_;
+        bool is_rc_connected_ = false;
 
-        float rotor_controls_[kArduCopterRotorControlCount];
+        float rotor_controls_[kArduCopterRotorControlCount] = {};
     };
 }
 } //namespace
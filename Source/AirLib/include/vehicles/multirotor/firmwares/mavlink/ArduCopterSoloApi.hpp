@@ -20,9 +20,10 @@ namespace airlib
 
 	virtual void update(float delta = 0)
 	{
+		MultirotorApiBase::update(delta);
+
 		if (sensors_ == nullptr)
 			return;
-		unused(delta);
 
             // send GPS and other sensor updates
             const uint count_gps_sensors = getSensors().size(SensorBase::SensorType::Gps);
@@ -0,0 +1,366 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#ifndef msr_airlib_MavLinkHilPipeline_hpp
+#define msr_airlib_MavLinkHilPipeline_hpp
+
+#include "MavLinkMessages.hpp"
+#include "MavLinkNode.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "common/Common.hpp"
+#include "common/SpscQueue.hpp"
+#include "common/StateReporter.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Moves HIL message I/O off the physics thread. The physics thread fills HIL_SENSOR, HIL_GPS and SYSTEM_TIME
+    messages and pushes them into an SPSC queue, a dedicated I/O thread encodes and sends them (including the
+    message logging of the connection). Actuator controls come back the other way: the mavlink receive thread
+    pushes them into a second SPSC queue and the physics thread takes the newest at the start of its update.
+    Neither queue blocks or allocates, a full queue drops the message and counts it.
+
+    Send errors cannot be handled on the I/O thread, they are kept for the physics thread which runs the usual
+    reconnect. Rates, queue depths and latencies are counted with atomics written by a single thread each.
+    */
+    class MavLinkHilPipeline
+    {
+    public:
+        static constexpr size_t kQueueSize = 64;
+        static constexpr int kActuatorCount = 8;
+
+        enum class Channel
+        {
+            HilSensor = 0, //enqueued -> sent
+            HilGps, //enqueued -> sent
+            SystemTime, //enqueued -> sent
+            ActuatorControls, //received -> applied by the physics thread
+            RoundTrip, //HIL_SENSOR sent -> next actuator controls received
+            Count
+        };
+
+        struct ChannelStats
+        {
+            uint64_t count = 0;
+            uint64_t dropped = 0;
+            double rate_hz = 0;
+            double average_latency_us = 0;
+            double max_latency_us = 0;
+        };
+
+        struct Stats
+        {
+            ChannelStats channels[static_cast<int>(Channel::Count)];
+            size_t output_queue_depth = 0;
+            size_t output_queue_max_depth = 0;
+            size_t actuator_queue_depth = 0;
+            size_t actuator_queue_max_depth = 0;
+        };
+
+        struct ActuatorControls
+        {
+            float values[kActuatorCount];
+            bool normalize; //values are raw firmware output that still need normalizeRotorControls
+            std::chrono::steady_clock::time_point received;
+        };
+
+    public:
+        MavLinkHilPipeline()
+            : output_queue_(kQueueSize), actuator_queue_(kQueueSize)
+        {
+        }
+
+        ~MavLinkHilPipeline()
+        {
+            stop();
+        }
+
+        void start(const std::shared_ptr<mavlinkcom::MavLinkNode>& node)
+        {
+            stop();
+
+            is_running_ = true;
+            io_thread_ = std::thread(&MavLinkHilPipeline::ioLoop, this, node);
+        }
+
+        void stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(wake_mutex_);
+                is_running_ = false;
+            }
+            wake_signal_.notify_one();
+            if (io_thread_.joinable())
+                io_thread_.join();
+
+            //messages for the old connection are not sent to a new one
+            OutputMessage message;
+            while (output_queue_.pop(message)) {
+            }
+        }
+
+        // Physics thread, false if the pipeline is stopped or the queue is full, either counts as a drop
+        bool send(const mavlinkcom::MavLinkHilSensor& message)
+        {
+            return enqueue(Channel::HilSensor, [&message](OutputMessage& slot) { slot.hil_sensor = message; });
+        }
+
+        bool send(const mavlinkcom::MavLinkHilGps& message)
+        {
+            return enqueue(Channel::HilGps, [&message](OutputMessage& slot) { slot.hil_gps = message; });
+        }
+
+        bool send(const mavlinkcom::MavLinkSystemTime& message)
+        {
+            return enqueue(Channel::SystemTime, [&message](OutputMessage& slot) { slot.system_time = message; });
+        }
+
+        // Mavlink receive thread
+        void pushActuatorControls(const float* values, bool normalize)
+        {
+            const auto now = std::chrono::steady_clock::now();
+
+            const int64_t sensor_sent = last_sensor_sent_ns_.exchange(0);
+            if (sensor_sent != 0)
+                channel(Channel::RoundTrip).record(now, toNanos(now) - sensor_sent);
+
+            const bool pushed = actuator_queue_.pushWith([&](ActuatorControls& slot) {
+                std::copy(values, values + kActuatorCount, slot.values);
+                slot.normalize = normalize;
+                slot.received = now;
+            });
+            if (!pushed)
+                ++channel(Channel::ActuatorControls).dropped;
+            updateMax(actuator_queue_max_depth_, actuator_queue_.size());
+        }
+
+        // Physics thread, takes the newest actuator controls and discards older ones
+        bool takeActuatorControls(ActuatorControls& controls)
+        {
+            bool has_controls = false;
+            while (actuator_queue_.pop(controls))
+                has_controls = true;
+
+            if (has_controls) {
+                const auto now = std::chrono::steady_clock::now();
+                channel(Channel::ActuatorControls).record(now, toNanos(now) - toNanos(controls.received));
+            }
+            return has_controls;
+        }
+
+        // Physics thread, the last send error of the I/O thread if there was one since the previous call
+        bool takeSendError(std::string& message)
+        {
+            if (!has_send_error_.exchange(false))
+                return false;
+            std::lock_guard<std::mutex> lock(send_error_mutex_);
+            message = send_error_;
+            return true;
+        }
+
+        Stats getStats() const
+        {
+            Stats stats;
+            for (int i = 0; i < static_cast<int>(Channel::Count); ++i)
+                stats.channels[i] = channels_[i].get();
+            stats.output_queue_depth = output_queue_.size();
+            stats.output_queue_max_depth = output_queue_max_depth_.load();
+            stats.actuator_queue_depth = actuator_queue_.size();
+            stats.actuator_queue_max_depth = actuator_queue_max_depth_.load();
+            return stats;
+        }
+
+        void reportState(StateReporter& reporter) const
+        {
+            static const char* const kChannelNames[] = { "HilSensor", "HilGps", "SystemTime", "Actuators", "RoundTrip" };
+
+            const Stats stats = getStats();
+            for (int i = 0; i < static_cast<int>(Channel::Count); ++i) {
+                const ChannelStats& channel_stats = stats.channels[i];
+                reporter.writeValue(Utils::stringf("HIL-%s-Hz", kChannelNames[i]), channel_stats.rate_hz);
+                reporter.writeValue(Utils::stringf("HIL-%s-Avg-us", kChannelNames[i]), channel_stats.average_latency_us);
+                reporter.writeValue(Utils::stringf("HIL-%s-Max-us", kChannelNames[i]), channel_stats.max_latency_us);
+                reporter.writeValue(Utils::stringf("HIL-%s-Dropped", kChannelNames[i]), channel_stats.dropped);
+            }
+            reporter.writeValue("HIL-OutQueue", stats.output_queue_depth);
+            reporter.writeValue("HIL-OutQueue-Max", stats.output_queue_max_depth);
+            reporter.writeValue("HIL-ActQueue", stats.actuator_queue_depth);
+            reporter.writeValue("HIL-ActQueue-Max", stats.actuator_queue_max_depth);
+        }
+
+    private:
+        struct OutputMessage
+        {
+            Channel channel;
+            std::chrono::steady_clock::time_point enqueued;
+            mavlinkcom::MavLinkHilSensor hil_sensor;
+            mavlinkcom::MavLinkHilGps hil_gps;
+            mavlinkcom::MavLinkSystemTime system_time;
+        };
+
+        // Counters of one channel, every channel is written by a single thread
+        class ChannelCounter
+        {
+        public:
+            void record(std::chrono::steady_clock::time_point now, int64_t latency_ns)
+            {
+                const uint64_t latency = static_cast<uint64_t>(std::max<int64_t>(latency_ns, 0));
+                ++count_;
+                latency_total_ns_ += latency;
+                if (latency > latency_max_ns_.load(std::memory_order_relaxed))
+                    latency_max_ns_ = latency;
+
+                //rate from a moving average of the interval between messages
+                if (last_time_ != std::chrono::steady_clock::time_point()) {
+                    const double interval = std::chrono::duration<double>(now - last_time_).count();
+                    const double average = interval_average_s_.load(std::memory_order_relaxed);
+                    interval_average_s_ = average == 0 ? interval : average + (interval - average) * 0.05;
+                }
+                last_time_ = now;
+            }
+
+            ChannelStats get() const
+            {
+                ChannelStats stats;
+                stats.count = count_.load();
+                stats.dropped = dropped.load();
+                const double interval = interval_average_s_.load();
+                stats.rate_hz = interval > 0 ? 1 / interval : 0;
+                stats.average_latency_us = stats.count > 0 ? latency_total_ns_.load() * 1.0E-3 / stats.count : 0;
+                stats.max_latency_us = latency_max_ns_.load() * 1.0E-3;
+                return stats;
+            }
+
+            std::atomic<uint64_t> dropped{ 0 }; //written by the producer of the channel
+
+        private:
+            std::atomic<uint64_t> count_{ 0 };
+            std::atomic<uint64_t> latency_total_ns_{ 0 };
+            std::atomic<uint64_t> latency_max_ns_{ 0 };
+            std::atomic<double> interval_average_s_{ 0 };
+            std::chrono::steady_clock::time_point last_time_;
+        };
+
+        static int64_t toNanos(std::chrono::steady_clock::time_point time)
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+        }
+
+        static void updateMax(std::atomic<size_t>& max_value, size_t value)
+        {
+            if (value > max_value.load(std::memory_order_relaxed))
+                max_value = value;
+        }
+
+        ChannelCounter& channel(Channel id)
+        {
+            return channels_[static_cast<int>(id)];
+        }
+
+        template <typename TFill>
+        bool enqueue(Channel message_channel, TFill&& fill)
+        {
+            if (!is_running_) {
+                ++channel(message_channel).dropped;
+                return false;
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            const bool pushed = output_queue_.pushWith([&](OutputMessage& slot) {
+                slot.channel = message_channel;
+                slot.enqueued = now;
+                fill(slot);
+            });
+            if (!pushed) {
+                ++channel(message_channel).dropped;
+                return false;
+            }
+            updateMax(output_queue_max_depth_, output_queue_.size());
+
+            //only take the lock when the I/O thread may be sleeping, see ioLoop
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (is_io_waiting_) {
+                std::lock_guard<std::mutex> lock(wake_mutex_);
+                wake_signal_.notify_one();
+            }
+            return true;
+        }
+
+        void ioLoop(std::shared_ptr<mavlinkcom::MavLinkNode> node)
+        {
+            OutputMessage message;
+            while (is_running_) {
+                if (!output_queue_.pop(message)) {
+                    std::unique_lock<std::mutex> lock(wake_mutex_);
+                    is_io_waiting_ = true;
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    //the timeout only bounds a missed wake up, the producer notifies after every push
+                    if (is_running_ && output_queue_.empty())
+                        wake_signal_.wait_for(lock, std::chrono::milliseconds(10));
+                    is_io_waiting_ = false;
+                    continue;
+                }
+
+                try {
+                    switch (message.channel) {
+                    case Channel::HilSensor:
+                        node->sendMessage(message.hil_sensor);
+                        last_sensor_sent_ns_ = toNanos(std::chrono::steady_clock::now());
+                        break;
+                    case Channel::HilGps:
+                        node->sendMessage(message.hil_gps);
+                        break;
+                    case Channel::SystemTime:
+                        node->sendMessage(message.system_time);
+                        break;
+                    default:
+                        break;
+                    }
+                }
+                catch (std::exception& e) {
+                    {
+                        std::lock_guard<std::mutex> lock(send_error_mutex_);
+                        send_error_ = e.what();
+                    }
+                    has_send_error_ = true;
+                    continue;
+                }
+
+                const auto now = std::chrono::steady_clock::now();
+                channel(message.channel).record(now, toNanos(now) - toNanos(message.enqueued));
+            }
+        }
+
+    private:
+        SpscQueue<OutputMessage> output_queue_; //physics thread -> I/O thread
+        SpscQueue<ActuatorControls> actuator_queue_; //mavlink receive thread -> physics thread
+
+        std::thread io_thread_;
+        std::atomic<bool> is_running_{ false };
+        std::atomic<bool> is_io_waiting_{ false };
+        std::mutex wake_mutex_;
+        std::condition_variable wake_signal_;
+
+        std::atomic<bool> has_send_error_{ false };
+        std::mutex send_error_mutex_;
+        std::string send_error_;
+
+        ChannelCounter channels_[static_cast<int>(Channel::Count)];
+        std::atomic<int64_t> last_sensor_sent_ns_{ 0 };
+        std::atomic<size_t> output_queue_max_depth_{ 0 };
+        std::atomic<size_t> actuator_queue_max_depth_{ 0 };
+    };
+}
+} //namespace
+#endif
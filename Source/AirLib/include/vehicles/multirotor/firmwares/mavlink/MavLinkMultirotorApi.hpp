@@ -5,6 +5,7 @@
 #define msr_airlib_MavLinkDroneController_hpp
 
 #include "MavLinkConnection.hpp"
+#include "MavLinkHilPipeline.hpp"
 #include "MavLinkMessages.hpp"
 #include "MavLinkNode.hpp"
 #include "MavLinkVehicle.hpp"
@@ -129,6 +130,12 @@ namespace airlib
                 auto now = clock()->nowNanos() / 1000;
                 MultirotorApiBase::update(delta);
 
+                applyActuatorControls();
+
+                std::string send_error;
+                if (hil_pipeline_.takeSendError(send_error))
+                    throw std::runtime_error(send_error);
+
                 if (sensors_ == nullptr || !connected_ || connection_ == nullptr || !connection_->isOpen() || !got_first_heartbeat_)
                     return;
 
@@ -231,6 +238,13 @@ namespace airlib
                 was_reset_ = false;
         }
 
+        virtual void reportState(StateReporter& reporter) override
+        {
+            MultirotorApiBase::reportState(reporter);
+
+            hil_pipeline_.reportState(reporter);
+        }
+
         virtual bool isReady(std::string& message) const override
         {
             if (!is_ready_ && is_ready_message_.size() > 0) {
@@ -922,6 +936,7 @@ namespace airlib
                 connection_->close();
             }
 
+            hil_pipeline_.stop();
             if (hil_node_ != nullptr) {
                 hil_node_->close();
             }
@@ -1147,6 +1162,19 @@ namespace airlib
             }
         }
 
+        void applyActuatorControls()
+        {
+            MavLinkHilPipeline::ActuatorControls controls;
+            if (!hil_pipeline_.takeActuatorControls(controls))
+                return;
+
+            std::lock_guard<std::mutex> guard(hil_controls_mutex_);
+            std::copy(controls.values, controls.values + RotorControlsCount, rotor_controls_);
+            if (controls.normalize) {
+                normalizeRotorControls();
+            }
+        }
+
         bool sendTestMessage(std::shared_ptr<mavlinkcom::MavLinkNode> node)
         {
             try {
@@ -1321,6 +1349,7 @@ namespace airlib
 
             hil_node_ = std::make_shared<mavlinkcom::MavLinkNode>(connection_info_.sim_sysid, connection_info_.sim_compid);
             hil_node_->connect(connection_);
+            hil_pipeline_.start(hil_node_);
 
             if (connection_info.use_tcp) {
                 addStatusMessage(std::string("Connected to SITL over TCP."));
@@ -1494,6 +1523,7 @@ namespace airlib
                     connection_->ignoreMessage(mavlinkcom::MavLinkAttPosMocap::kMessageId); //TODO: find better way to communicate debug pose instead of using fake Mo-cap messages
                     hil_node_ = std::make_shared<mavlinkcom::MavLinkNode>(connection_info_.sim_sysid, connection_info_.sim_compid);
                     hil_node_->connect(connection_);
+                    hil_pipeline_.start(hil_node_);
                     addStatusMessage(Utils::stringf("Connected to PX4 over serial port: %s", port_name_auto.c_str()));
 
                     // start listening to the HITL connection.
@@ -1669,41 +1699,35 @@ namespace airlib
             }
             else if (msg.msgid == HilControlsMessage.msgid) {
                 if (!actuators_message_supported_) {
-                    std::lock_guard<std::mutex> guard_controls(hil_controls_mutex_);
-
                     HilControlsMessage.decode(msg);
-                    rotor_controls_[0] = HilControlsMessage.roll_ailerons;
-                    rotor_controls_[1] = HilControlsMessage.pitch_elevator;
-                    rotor_controls_[2] = HilControlsMessage.yaw_rudder;
-                    rotor_controls_[3] = HilControlsMessage.throttle;
-                    rotor_controls_[4] = HilControlsMessage.aux1;
-                    rotor_controls_[5] = HilControlsMessage.aux2;
-                    rotor_controls_[6] = HilControlsMessage.aux3;
-                    rotor_controls_[7] = HilControlsMessage.aux4;
-
-                    normalizeRotorControls();
+                    const float controls[RotorControlsCount] = {
+                        HilControlsMessage.roll_ailerons,
+                        HilControlsMessage.pitch_elevator,
+                        HilControlsMessage.yaw_rudder,
+                        HilControlsMessage.throttle,
+                        HilControlsMessage.aux1,
+                        HilControlsMessage.aux2,
+                        HilControlsMessage.aux3,
+                        HilControlsMessage.aux4
+                    };
+
+                    //applied by the physics thread in update
+                    hil_pipeline_.pushActuatorControls(controls, true);
                     handleLockStep();
                 }
             }
             else if (msg.msgid == HilActuatorControlsMessage.msgid) {
                 actuators_message_supported_ = true;
 
-                std::lock_guard<std::mutex> guard_actuator(hil_controls_mutex_); //use same mutex as HIL_CONTROl
-
                 HilActuatorControlsMessage.decode(msg);
                 bool isarmed = (HilActuatorControlsMessage.mode & 128) != 0;
-                for (auto i = 0; i < 8; ++i) {
-                    if (isarmed) {
-                        rotor_controls_[i] = HilActuatorControlsMessage.controls[i];
-                    }
-                    else {
-                        rotor_controls_[i] = 0;
-                    }
-                }
-                if (isarmed) {
-                    normalizeRotorControls();
+                float controls[RotorControlsCount];
+                for (auto i = 0; i < RotorControlsCount; ++i) {
+                    controls[i] = isarmed ? HilActuatorControlsMessage.controls[i] : 0;
                 }
 
+                //applied by the physics thread in update
+                hil_pipeline_.pushActuatorControls(controls, isarmed);
                 handleLockStep();
             }
             else if (msg.msgid == MavLinkGpsRawInt.msgid) {
@@ -1788,11 +1812,19 @@ namespace airlib
             }
 
             if (hil_node_ != nullptr) {
-                hil_node_->sendMessage(hil_sensor);
+                // pause before the message is queued, the actuator controls answering it resume the world
                 received_actuator_controls_ = false;
                 if (lock_step_active_ && world_ != nullptr) {
                     world_->pauseForTime(1); // 1 second delay max waiting for actuator controls.
                 }
+                if (!hil_pipeline_.send(hil_sensor)) {
+                    // the dropped message gets no answer, resume now and let the next update send again
+                    // instead of staying paused until the lock step timeout
+                    received_actuator_controls_ = true;
+                    if (lock_step_active_ && world_ != nullptr) {
+                        world_->pause(false);
+                    }
+                }
             }
 
             std::lock_guard<std::mutex> guard(last_message_mutex_);
@@ -1810,7 +1842,7 @@ namespace airlib
                 msg_system_time.time_unix_usec = tu;
                 msg_system_time.time_boot_ms = last_sys_time_;
                 if (hil_node_ != nullptr) {
-                    hil_node_->sendMessage(msg_system_time);
+                    hil_pipeline_.send(msg_system_time);
                 }
             }
         }
@@ -1873,7 +1905,7 @@ namespace airlib
             hil_gps.satellites_visible = static_cast<uint8_t>(15);
 
             if (hil_node_ != nullptr) {
-                hil_node_->sendMessage(hil_gps);
+                hil_pipeline_.send(hil_gps);
             }
 
             if (hil_gps.lat < 0.1f && hil_gps.lat > -0.1f) {
@@ -1958,6 +1990,7 @@ namespace airlib
         size_t status_messages_MaxSize = 5000;
 
         std::shared_ptr<mavlinkcom::MavLinkNode> hil_node_;
+        MavLinkHilPipeline hil_pipeline_;
         std::shared_ptr<mavlinkcom::MavLinkConnection> connection_;
         std::shared_ptr<mavlinkcom::MavLinkVideoServer> video_server_;
         std::shared_ptr<MultirotorApiBase> mav_vehicle_control_;
@@ -68,6 +68,13 @@ namespace airlib
             return conv;
         }
 
+        //same result as AirSimSimpleFlightEstimator::transformToBodyFrame for a body with this orientation
+        static simple_flight::Axis3r transformToBodyFrame(const simple_flight::Axis4r& orientation, const simple_flight::Axis3r& world_frame_val)
+        {
+            const Vector3r& trans = VectorMath::transformToBodyFrame(toVector3r(world_frame_val), toQuaternion(orientation));
+            return toAxis3r(trans);
+        }
+
         static simple_flight::GeoPoint toSimpleFlightGeoPoint(const GeoPoint& geo_point)
         {
             simple_flight::GeoPoint conv;
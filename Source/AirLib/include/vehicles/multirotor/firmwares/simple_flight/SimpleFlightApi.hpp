@@ -17,6 +17,7 @@
 #include "AirSimSimpleFlightCommon.hpp"
 #include "physics/PhysicsBody.hpp"
 #include "common/AirSimSettings.hpp"
+#include <mutex>
 
 //TODO: we need to protect contention between physics thread and API server thread
 
@@ -36,14 +37,20 @@ namespace airlib
 
             //TODO: set below properly for better high speed safety
             safety_params_.vel_to_breaking_dist = safety_params_.min_breaking_dist = 0;
+            //velocity steps settle in about a second, see benchmarks/MoveOnPathTrackingCheck.cpp
+            safety_params_.path_velocity_lead = 0.9f;
 
             //create sim implementations of board and commlink
             board_.reset(new AirSimSimpleFlightBoard(&params_));
             comm_link_.reset(new AirSimSimpleFlightCommLink());
             estimator_.reset(new AirSimSimpleFlightEstimator());
 
+            //vehicles with the swarm controller share one controller engine
+            if (vehicle_setting->swarm_controller)
+                swarm_ = getSharedSwarm();
+
             //create firmware
-            firmware_.reset(new simple_flight::Firmware(&params_, board_.get(), comm_link_.get(), estimator_.get()));
+            firmware_.reset(new simple_flight::Firmware(&params_, board_.get(), comm_link_.get(), estimator_.get(), swarm_.get()));
         }
 
     public: //VehicleApiBase implementation
@@ -106,6 +113,13 @@ namespace airlib
         {
             return vehicle_params_->getParams().rotor_count;
         }
+        virtual void completeActuation() override
+        {
+            //runs the members of the swarm that were updated even if another member was not, only the first vehicle
+            //of a step finds anything left to run
+            if (swarm_ != nullptr)
+                swarm_->update();
+        }
         virtual void moveByRC(const RCData& rc_data) override
         {
             setRCData(rc_data);
@@ -411,12 +425,29 @@ namespace airlib
             params_.rc.allow_api_always = vehicle_setting.allow_api_always;
         }
 
+        static std::shared_ptr<simple_flight::SwarmCascadeController> getSharedSwarm()
+        {
+            //created by the first vehicle that joins, destroyed with the last one
+            static std::mutex mutex;
+            static std::weak_ptr<simple_flight::SwarmCascadeController> shared_swarm;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            std::shared_ptr<simple_flight::SwarmCascadeController> swarm = shared_swarm.lock();
+            if (swarm == nullptr) {
+                swarm = std::make_shared<simple_flight::SwarmCascadeController>(&AirSimSimpleFlightCommon::transformToBodyFrame);
+                shared_swarm = swarm;
+            }
+            return swarm;
+        }
+
     private:
         const MultiRotorParams* vehicle_params_;
 
         int remote_control_id_ = 0;
         simple_flight::Params params_;
 
+        //must outlive firmware_
+        std::shared_ptr<simple_flight::SwarmCascadeController> swarm_;
         unique_ptr<AirSimSimpleFlightBoard> board_;
         unique_ptr<AirSimSimpleFlightCommLink> comm_link_;
         unique_ptr<AirSimSimpleFlightEstimator> estimator_;
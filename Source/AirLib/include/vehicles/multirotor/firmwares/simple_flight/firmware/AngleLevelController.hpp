@@ -22,7 +22,7 @@ class AngleLevelController : public IAxisController
 {
 public:
     AngleLevelController(Params* params, const IBoardClock* clock = nullptr)
-        : params_(params), clock_(clock)
+        : params_(params), clock_(clock), pid_(clock), rate_controller_(params, clock)
     {
     }
 
@@ -36,12 +36,10 @@ public:
         state_estimator_ = state_estimator;
 
         //initialize level PID
-        pid_.reset(new PidController<float>(clock_,
-                                            PidConfig<float>(params_->angle_level_pid.p[axis], params_->angle_level_pid.i[axis], params_->angle_level_pid.d[axis])));
+        pid_.setConfig(PidConfig<float>(params_->angle_level_pid.p[axis], params_->angle_level_pid.i[axis], params_->angle_level_pid.d[axis]));
 
         //initialize rate controller
-        rate_controller_.reset(new AngleRateController(params_, clock_));
-        rate_controller_->initialize(axis, this, state_estimator_);
+        rate_controller_.initialize(axis, this, state_estimator_);
 
         //we will be setting goal for rate controller so we need these two things
         rate_mode_ = GoalMode::getUnknown();
@@ -52,8 +50,8 @@ public:
     {
         IAxisController::reset();
 
-        pid_->reset();
-        rate_controller_->reset();
+        pid_.reset();
+        rate_controller_.reset();
         rate_goal_ = Axis4r();
         output_ = TReal();
     }
@@ -70,16 +68,16 @@ public:
 
         adjustToMinDistanceAngles(measured_angle, goal_angle);
 
-        pid_->setGoal(goal_angle);
-        pid_->setMeasured(measured_angle);
-        pid_->update();
+        pid_.setGoal(goal_angle);
+        pid_.setMeasured(measured_angle);
+        pid_.update();
 
         //use this to drive rate controller
-        rate_goal_[axis_] = pid_->getOutput() * params_->angle_rate_pid.max_limit[axis_];
-        rate_controller_->update();
+        rate_goal_[axis_] = pid_.getOutput() * params_->angle_rate_pid.max_limit[axis_];
+        rate_controller_.update();
 
         //rate controller's output is final output
-        output_ = rate_controller_->getOutput();
+        output_ = rate_controller_.getOutput();
     }
 
     virtual TReal getOutput() override
@@ -87,6 +85,13 @@ public:
         return output_;
     }
 
+    virtual void preloadOutput(TReal output) override
+    {
+        //output comes from the rate controller
+        rate_controller_.preloadOutput(output);
+        output_ = output;
+    }
+
     /********************  IGoal ********************/
     virtual const Axis4r& getGoalValue() const override
     {
@@ -136,8 +141,8 @@ private:
 
     Params* params_;
     const IBoardClock* clock_;
-    std::unique_ptr<PidController<float>> pid_;
-    std::unique_ptr<AngleRateController> rate_controller_;
+    PidController<float> pid_;
+    AngleRateController rate_controller_;
 };
 
 } //namespace
\ No newline at end of file
@@ -18,7 +18,7 @@ class AngleRateController : public IAxisController
 {
 public:
     AngleRateController(Params* params, const IBoardClock* clock)
-        : params_(params), clock_(clock)
+        : params_(params), clock_(clock), pid_(clock)
     {
     }
 
@@ -31,15 +31,14 @@ public:
         goal_ = goal;
         state_estimator_ = state_estimator;
 
-        pid_.reset(new PidController<float>(clock_,
-                                            PidConfig<float>(params_->angle_rate_pid.p[axis], params_->angle_rate_pid.i[axis], params_->angle_rate_pid.d[axis])));
+        pid_.setConfig(PidConfig<float>(params_->angle_rate_pid.p[axis], params_->angle_rate_pid.i[axis], params_->angle_rate_pid.d[axis]));
     }
 
     virtual void reset() override
     {
         IAxisController::reset();
 
-        pid_->reset();
+        pid_.reset();
         output_ = TReal();
     }
 
@@ -47,11 +46,11 @@ public:
     {
         IAxisController::update();
 
-        pid_->setGoal(goal_->getGoalValue()[axis_]);
-        pid_->setMeasured(state_estimator_->getAngularVelocity()[axis_]);
-        pid_->update();
+        pid_.setGoal(goal_->getGoalValue()[axis_]);
+        pid_.setMeasured(state_estimator_->getAngularVelocity()[axis_]);
+        pid_.update();
 
-        output_ = pid_->getOutput();
+        output_ = pid_.getOutput();
     }
 
     virtual TReal getOutput() override
@@ -59,6 +58,12 @@ public:
         return output_;
     }
 
+    virtual void preloadOutput(TReal output) override
+    {
+        pid_.preloadOutput(output);
+        output_ = output;
+    }
+
 private:
     unsigned int axis_;
     const IGoal* goal_;
@@ -68,7 +73,7 @@ private:
 
     Params* params_;
     const IBoardClock* clock_;
-    std::unique_ptr<PidController<float>> pid_;
+    PidController<float> pid_;
 };
 
 } //namespace
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <exception>
+#include <memory>
 #include "interfaces/IController.hpp"
 #include "interfaces/IStateEstimator.hpp"
 #include "interfaces/ICommLink.hpp"
@@ -23,6 +24,9 @@ public:
     CascadeController(Params* params, const IBoardClock* clock, ICommLink* comm_link)
         : params_(params), clock_(clock), comm_link_(comm_link)
     {
+        //all axis controllers are created once here, mode changes only rebind them
+        for (unsigned int axis = 0; axis < Axis4r::AxisCount(); ++axis)
+            controller_sets_[axis].reset(new AxisControllerSet(params, clock));
     }
 
     virtual void initialize(const IGoal* goal, const IStateEstimator* state_estimator) override
@@ -62,39 +66,43 @@ public:
         }
 
         for (unsigned int axis = 0; axis < Axis4r::AxisCount(); ++axis) {
-            //re-create axis controllers if goal mode was changed since last time, or if gains have been updated
+            //switch axis controllers if goal mode was changed since last time, or if gains have been updated
             if (goal_mode[axis] != last_goal_mode_[axis] || params_->gains_changed == true) {
+                const bool had_controller = axis_controllers_[axis] != nullptr;
+                AxisControllerSet& set = *controller_sets_[axis];
                 switch (goal_mode[axis]) {
                 case GoalModeType::AngleRate:
-                    axis_controllers_[axis].reset(new AngleRateController(params_, clock_));
+                    axis_controllers_[axis] = &set.angle_rate;
                     break;
                 case GoalModeType::AngleLevel:
-                    axis_controllers_[axis].reset(new AngleLevelController(params_, clock_));
+                    axis_controllers_[axis] = &set.angle_level;
                     break;
                 case GoalModeType::VelocityWorld:
-                    axis_controllers_[axis].reset(new VelocityController(params_, clock_));
+                    axis_controllers_[axis] = &set.velocity;
                     break;
                 case GoalModeType::PositionWorld:
-                    axis_controllers_[axis].reset(new PositionController(params_, clock_));
+                    axis_controllers_[axis] = &set.position;
                     break;
                 case GoalModeType::Passthrough:
-                    axis_controllers_[axis].reset(new PassthroughController());
+                    axis_controllers_[axis] = &set.passthrough;
                     break;
                 case GoalModeType::Unknown:
-                    axis_controllers_[axis].reset(nullptr);
+                    axis_controllers_[axis] = nullptr;
                     break;
                 case GoalModeType::ConstantOutput:
-                    axis_controllers_[axis].reset(new ConstantOutputController());
+                    axis_controllers_[axis] = &set.constant_output;
                     break;
                 default:
                     throw std::invalid_argument("Axis controller type is not yet implemented for axis " + std::to_string(axis));
                 }
                 last_goal_mode_[axis] = goal_mode[axis];
 
-                //initialize axis controller
+                //initialize axis controller, this also picks up changed gains
                 if (axis_controllers_[axis] != nullptr) {
                     axis_controllers_[axis]->initialize(axis, goal_, state_estimator_);
                     axis_controllers_[axis]->reset();
+                    if (params_->bumpless_transfer && had_controller)
+                        axis_controllers_[axis]->preloadOutput(output_[axis]);
                 }
             }
 
@@ -127,6 +135,23 @@ public:
         return is_last_goal_mode_all_passthrough_;
     }
 
+private:
+    //every controller an axis can use, switching modes must not allocate in the control loop
+    struct AxisControllerSet
+    {
+        AxisControllerSet(Params* params, const IBoardClock* clock)
+            : angle_rate(params, clock), angle_level(params, clock), velocity(params, clock), position(params, clock)
+        {
+        }
+
+        AngleRateController angle_rate;
+        AngleLevelController angle_level;
+        VelocityController velocity;
+        PositionController position;
+        PassthroughController passthrough;
+        ConstantOutputController constant_output;
+    };
+
 private:
     Params* params_;
     const IBoardClock* clock_;
@@ -141,6 +166,7 @@ private:
     Axis4r last_goal_val_;
     bool is_last_goal_mode_all_passthrough_;
 
-    std::unique_ptr<IAxisController> axis_controllers_[Axis4r::AxisCount()];
+    std::unique_ptr<AxisControllerSet> controller_sets_[Axis4r::AxisCount()];
+    IAxisController* axis_controllers_[Axis4r::AxisCount()] = {};
 };
 }
\ No newline at end of file
@@ -43,6 +43,12 @@ public:
         return output_;
     }
 
+    virtual void preloadOutput(TReal output) override
+    {
+        //output does not depend on history
+        unused(output);
+    }
+
 private:
     unsigned int axis_;
     TReal update_output_;
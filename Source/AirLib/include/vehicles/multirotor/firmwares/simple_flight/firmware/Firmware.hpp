@@ -12,6 +12,7 @@
 #include "Mixer.hpp"
 #include "CascadeController.hpp"
 #include "AdaptiveController.hpp"
+#include "SwarmCascadeController.hpp"
 
 namespace simple_flight
 {
@@ -19,12 +20,18 @@ namespace simple_flight
 class Firmware : public IFirmware
 {
 public:
-    Firmware(Params* params, IBoard* board, ICommLink* comm_link, IStateEstimator* state_estimator)
+    //with a swarm the cascade controller of this vehicle runs in the swarm and motor outputs are written when the
+    //swarm has run, which can be after update() returned
+    Firmware(Params* params, IBoard* board, ICommLink* comm_link, IStateEstimator* state_estimator, SwarmCascadeController* swarm = nullptr)
         : params_(params), board_(board), comm_link_(comm_link), state_estimator_(state_estimator), offboard_api_(params, board, board, state_estimator, comm_link), mixer_(params)
     {
         switch (params->controller_type) {
         case Params::ControllerType::Cascade:
-            controller_ = std::unique_ptr<CascadeController>(new CascadeController(params, board, comm_link));
+            if (swarm != nullptr)
+                controller_ = std::unique_ptr<SwarmMemberController>(new SwarmMemberController(swarm, params, board, comm_link, [this]() { writeMotorOutputs(); }));
+            else
+                controller_ = std::unique_ptr<CascadeController>(new CascadeController(params, board, comm_link));
+            is_output_deferred_ = swarm != nullptr;
             break;
         case Params::ControllerType::Adaptive:
             controller_ = std::unique_ptr<AdaptiveController>(new AdaptiveController());
@@ -56,6 +63,20 @@ public:
         offboard_api_.update();
         controller_->update();
 
+        if (!is_output_deferred_)
+            writeMotorOutputs();
+
+        comm_link_->update();
+    }
+
+    virtual IOffboardApi& offboardApi() override
+    {
+        return offboard_api_;
+    }
+
+private:
+    void writeMotorOutputs()
+    {
         const Axis4r& output_controls = controller_->getOutput();
 
         // if last goal mode is passthrough for all axes (which means moveByMotorPWMs was called),
@@ -73,13 +94,6 @@ public:
         //finally write the motor outputs
         for (uint16_t motor_index = 0; motor_index < params_->motor.motor_count; ++motor_index)
             board_->writeOutput(motor_index, motor_outputs_.at(motor_index));
-
-        comm_link_->update();
-    }
-
-    virtual IOffboardApi& offboardApi() override
-    {
-        return offboard_api_;
     }
 
 private:
@@ -92,6 +106,7 @@ private:
     OffboardApi offboard_api_;
     Mixer mixer_;
     std::unique_ptr<IController> controller_;
+    bool is_output_deferred_ = false;
 
     std::vector<float> motor_outputs_;
 };
@@ -135,7 +135,9 @@ public:
     VehicleStateType default_vehicle_state = VehicleStateType::Inactive;
     uint64_t api_goal_timeout = 60; //milliseconds
     ControllerType controller_type = ControllerType::Cascade;
-    bool gains_changed;
+    bool gains_changed = false;
+    //when the cascade controller switches the controller of an axis, start the new one from the last output
+    bool bumpless_transfer = false;
 };
 
 } //namespace
\ No newline at end of file
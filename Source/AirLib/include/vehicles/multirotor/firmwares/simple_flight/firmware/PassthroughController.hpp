@@ -38,6 +38,12 @@ public:
         return output_;
     }
 
+    virtual void preloadOutput(TReal output) override
+    {
+        //output does not depend on history
+        unused(output);
+    }
+
 private:
     unsigned int axis_;
     const IGoal* goal_;
@@ -15,20 +15,15 @@ class PidController : public IUpdatable
 {
 public:
     PidController(const IBoardClock* clock = nullptr, const PidConfig<T>& config = PidConfig<T>())
-        : clock_(clock), config_(config)
+        : clock_(clock), config_(config), std_integrator_(config), runge_kutta_integrator_(config)
     {
-        switch (config.integrator_type) {
-        case PidConfig<T>::IntegratorType::Standard:
-            integrator = std::unique_ptr<StdPidIntegrator<T>>(new StdPidIntegrator<T>(config_));
-            break;
-        case PidConfig<T>::IntegratorType::RungKutta:
-            integrator = std::unique_ptr<RungKuttaPidIntegrator<T>>(new RungKuttaPidIntegrator<T>(config_));
-            break;
-        default:
-            throw std::invalid_argument("PID integrator type is not recognized");
-        }
+        selectIntegrator();
     }
 
+    //integrator points into this object
+    PidController(const PidController&) = delete;
+    PidController& operator=(const PidController&) = delete;
+
     void setGoal(const T& goal)
     {
         goal_ = goal;
@@ -52,11 +47,14 @@ public:
         return config_;
     }
 
-    //allow changing config at runtime
+    //allow changing config at runtime, this does not allocate
     void setConfig(const PidConfig<T>& config)
     {
         bool renabled = !config_.enabled && config.enabled;
         config_ = config;
+        std_integrator_.setConfig(config_);
+        runge_kutta_integrator_.setConfig(config_);
+        selectIntegrator();
 
         if (renabled) {
             last_error_ = goal_ - measured_;
@@ -69,6 +67,14 @@ public:
         return output_;
     }
 
+    //start the integrator so that the output without proportional and derivative terms is the given output,
+    //used for bumpless transfer after reset
+    void preloadOutput(T output)
+    {
+        integrator->set(output - config_.output_bias);
+        output_ = output;
+    }
+
     virtual void reset() override
     {
         IUpdatable::reset();
@@ -111,6 +117,20 @@ public:
     }
 
 private:
+    void selectIntegrator()
+    {
+        switch (config_.integrator_type) {
+        case PidConfig<T>::IntegratorType::Standard:
+            integrator = &std_integrator_;
+            break;
+        case PidConfig<T>::IntegratorType::RungKutta:
+            integrator = &runge_kutta_integrator_;
+            break;
+        default:
+            throw std::invalid_argument("PID integrator type is not recognized");
+        }
+    }
+
     //TODO: replace with std::clamp after moving to C++17
     static T clip(T val, T min_value, T max_value)
     {
@@ -125,9 +145,12 @@ private:
 
     float last_error_;
     float min_dt_;
-    const PidConfig<T> config_;
+    PidConfig<T> config_;
 
-    std::unique_ptr<IPidIntegrator<T>> integrator;
+    //both integrators live in the controller so that changing the config never allocates
+    StdPidIntegrator<T> std_integrator_;
+    RungKuttaPidIntegrator<T> runge_kutta_integrator_;
+    IPidIntegrator<T>* integrator;
 };
 
 } //namespace
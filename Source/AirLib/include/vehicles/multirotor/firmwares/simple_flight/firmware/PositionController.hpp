@@ -20,7 +20,7 @@ class PositionController : public IAxisController
 {
 public:
     PositionController(Params* params, const IBoardClock* clock = nullptr)
-        : params_(params), clock_(clock)
+        : params_(params), clock_(clock), pid_(clock), velocity_controller_(params, clock)
     {
     }
 
@@ -34,12 +34,10 @@ public:
         state_estimator_ = state_estimator;
 
         //initialize parent PID
-        pid_.reset(new PidController<float>(clock_,
-                                            PidConfig<float>(params_->position_pid.p[axis], params_->position_pid.i[axis], params_->position_pid.d[axis])));
+        pid_.setConfig(PidConfig<float>(params_->position_pid.p[axis], params_->position_pid.i[axis], params_->position_pid.d[axis]));
 
         //initialize child controller
-        velocity_controller_.reset(new VelocityController(params_, clock_));
-        velocity_controller_->initialize(axis, this, state_estimator_);
+        velocity_controller_.initialize(axis, this, state_estimator_);
 
         //we will be setting goal for child controller so we need these two things
         velocity_mode_ = GoalMode::getUnknown();
@@ -50,8 +48,8 @@ public:
     {
         IAxisController::reset();
 
-        pid_->reset();
-        velocity_controller_->reset();
+        pid_.reset();
+        velocity_controller_.reset();
         velocity_goal_ = Axis4r();
         output_ = TReal();
     }
@@ -61,18 +59,18 @@ public:
         IAxisController::update();
 
         const Axis4r& goal_position_world = goal_->getGoalValue();
-        pid_->setGoal(goal_position_world[axis_]);
+        pid_.setGoal(goal_position_world[axis_]);
         const Axis4r& measured_position_world = Axis4r::xyzToAxis4(
             state_estimator_->getPosition(), true);
-        pid_->setMeasured(measured_position_world[axis_]);
-        pid_->update();
+        pid_.setMeasured(measured_position_world[axis_]);
+        pid_.update();
 
         //use this to drive child controller
-        velocity_goal_[axis_] = pid_->getOutput() * params_->velocity_pid.max_limit[axis_];
-        velocity_controller_->update();
+        velocity_goal_[axis_] = pid_.getOutput() * params_->velocity_pid.max_limit[axis_];
+        velocity_controller_.update();
 
         //final output
-        output_ = velocity_controller_->getOutput();
+        output_ = velocity_controller_.getOutput();
     }
 
     virtual TReal getOutput() override
@@ -80,6 +78,13 @@ public:
         return output_;
     }
 
+    virtual void preloadOutput(TReal output) override
+    {
+        //output comes from the velocity controller
+        velocity_controller_.preloadOutput(output);
+        output_ = output;
+    }
+
     /********************  IGoal ********************/
     virtual const Axis4r& getGoalValue() const override
     {
@@ -103,8 +108,8 @@ private:
 
     Params* params_;
     const IBoardClock* clock_;
-    std::unique_ptr<PidController<float>> pid_;
-    std::unique_ptr<VelocityController> velocity_controller_;
+    PidController<float> pid_;
+    VelocityController velocity_controller_;
 };
 
 } //namespace
\ No newline at end of file
@@ -21,6 +21,11 @@ public:
         iterm_int_ = T();
     }
 
+    virtual void setConfig(const PidConfig<T>& config) override
+    {
+        config_ = config;
+    }
+
     virtual void set(T val) override
     {
         iterm_int_ = val;
@@ -58,7 +63,7 @@ private:
 
 private:
     float iterm_int_;
-    const PidConfig<T> config_;
+    PidConfig<T> config_;
 };
 
 } //namespace
\ No newline at end of file
@@ -0,0 +1,693 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "interfaces/IController.hpp"
+#include "interfaces/IGoal.hpp"
+#include "interfaces/IStateEstimator.hpp"
+#include "interfaces/IBoardClock.hpp"
+#include "interfaces/ICommLink.hpp"
+#include "interfaces/CommonStructs.hpp"
+#include "Params.hpp"
+#include "common/common_utils/Utils.hpp"
+
+namespace simple_flight
+{
+
+class SwarmMemberController;
+
+/*
+Runs the cascade controller of many vehicles together. Instead of a tree of controller objects per vehicle, the PID
+states, gains, goals and estimator outputs of all vehicles are kept in flat arrays with one lane per vehicle axis,
+and every tick the position, velocity, angle level and angle rate PIDs of all lanes are computed in one pass each.
+
+The math and the mode switching follow CascadeController, PositionController, VelocityController,
+AngleLevelController and AngleRateController exactly, so the output is the same as running each vehicle on its
+own (bumpless transfer included). Only the standard PID integrator is supported, which is the one these
+controllers use.
+
+Vehicles take part through SwarmMemberController. Its update() only copies the goal and the estimator state into
+the arrays, the swarm runs as soon as every member has done so and then hands each member its output. A member that
+misses a tick would hold the others back, so whoever drives the ticks calls update() once a tick is over to run the
+members that were staged (SimpleFlightApi::completeActuation does so before the next physics step reads the motor
+outputs). The member that missed the tick keeps its previous output, just like a CascadeController that is not
+updated. Without that call the swarm runs when the first member comes back for the next tick. All members must be
+updated from the same thread.
+*/
+class SwarmCascadeController
+{
+public:
+    //same as IStateEstimator::transformToBodyFrame for a vehicle with the given orientation, the swarm applies
+    //it to goals that are only known while it runs
+    typedef Axis3r (*BodyFrameTransform)(const Axis4r& orientation, const Axis3r& world_frame_val);
+
+public:
+    explicit SwarmCascadeController(BodyFrameTransform body_frame_transform)
+        : body_frame_transform_(body_frame_transform)
+    {
+    }
+
+    SwarmCascadeController(const SwarmCascadeController&) = delete;
+    SwarmCascadeController& operator=(const SwarmCascadeController&) = delete;
+
+    unsigned int getMemberCount() const
+    {
+        return member_count_;
+    }
+
+    //runs all members that were staged since the last run, normally this happens by itself
+    void update()
+    {
+        if (staged_count_ == 0)
+            return;
+
+        const size_t lane_count = lanes_.size();
+        for (size_t lane = 0; lane < lane_count; ++lane)
+            lanes_.active[lane] = members_[lane / kAxisCount].staged ? 1 : 0;
+
+        //position -> velocity -> angle level -> angle rate, every stage runs for all lanes and each lane only
+        //uses the stages of the controller bound to it
+        stages_[kPosition].update(lanes_.millis, lanes_.active);
+        prepareVelocityGoals();
+        stages_[kVelocity].update(lanes_.millis, lanes_.active);
+        prepareAngleLevelGoals();
+        stages_[kAngleLevel].update(lanes_.millis, lanes_.active);
+        prepareAngleRateGoals();
+        stages_[kAngleRate].update(lanes_.millis, lanes_.active);
+        collectOutputs();
+
+        //hand out outputs after all staged flags are cleared so members can stage again from the callback
+        std::vector<SwarmMemberController*>& finished = finished_members_;
+        finished.clear();
+        for (Member& member : members_) {
+            if (member.staged) {
+                member.staged = false;
+                finished.push_back(member.controller);
+            }
+        }
+        staged_count_ = 0;
+        for (SwarmMemberController* controller : finished)
+            notifyOutput(controller);
+    }
+
+private: //members are managed by SwarmMemberController
+    friend class SwarmMemberController;
+
+    unsigned int addMember(SwarmMemberController* controller, Params* params, const IBoardClock* clock)
+    {
+        unsigned int slot = 0;
+        while (slot < members_.size() && members_[slot].controller != nullptr)
+            ++slot;
+        if (slot == members_.size()) {
+            members_.emplace_back();
+            lanes_.resize(members_.size() * kAxisCount);
+            for (PidStage& stage : stages_)
+                stage.resize(members_.size() * kAxisCount);
+        }
+
+        Member& member = members_[slot];
+        member = Member();
+        member.controller = controller;
+        member.params = params;
+        member.clock = clock;
+        for (unsigned int axis = 0; axis < kAxisCount; ++axis) {
+            const size_t lane = slot * kAxisCount + axis;
+            lanes_.bound_mode[lane] = kNoController;
+            lanes_.last_goal_mode[lane] = GoalModeType::Unknown;
+            lanes_.output[lane] = 0;
+        }
+        ++member_count_;
+        return slot;
+    }
+
+    void removeMember(unsigned int slot)
+    {
+        Member& member = members_.at(slot);
+        if (member.staged)
+            --staged_count_;
+        member = Member();
+        --member_count_;
+
+        //the remaining members may all be waiting for this one
+        if (staged_count_ > 0 && staged_count_ == member_count_)
+            update();
+    }
+
+    //same as CascadeController::reset
+    void resetMember(unsigned int slot)
+    {
+        Member& member = members_.at(slot);
+        if (member.staged) {
+            member.staged = false;
+            --staged_count_;
+        }
+
+        const uint64_t millis = getMillis(member);
+        for (unsigned int axis = 0; axis < kAxisCount; ++axis) {
+            const size_t lane = slot * kAxisCount + axis;
+            lanes_.last_goal_mode[lane] = GoalModeType::Unknown;
+            lanes_.output[lane] = 0;
+            if (lanes_.bound_mode[lane] != kNoController)
+                resetLane(lane, millis);
+        }
+    }
+
+    //copies what the controllers of this member read during update, the first half of CascadeController::update
+    void stageMember(unsigned int slot, const IGoal* goal, const IStateEstimator* state_estimator, ICommLink* comm_link)
+    {
+        //a member that comes back before the others finished its last tick starts the next one
+        if (members_.at(slot).staged)
+            update();
+
+        Member& member = members_[slot];
+        const GoalMode& goal_mode = goal->getGoalMode();
+        const Axis4r& goal_val = goal->getGoalValue();
+        const uint64_t millis = getMillis(member);
+        const size_t first_lane = slot * kAxisCount;
+
+        for (unsigned int axis = 0; axis < kAxisCount; ++axis) {
+            const size_t lane = first_lane + axis;
+            //switch axis controllers if goal mode was changed since last time, or if gains have been updated
+            if (goal_mode[axis] != lanes_.last_goal_mode[lane] || member.params->gains_changed == true) {
+                bindLane(slot, axis, goal_mode[axis], millis);
+                lanes_.last_goal_mode[lane] = goal_mode[axis];
+            }
+
+            if (lanes_.bound_mode[lane] == kNoController)
+                comm_link->log(std::string("Axis controller type is not set for axis ").append(std::to_string(axis)), ICommLink::kLogLevelInfo);
+        }
+        member.params->gains_changed = false;
+
+        //estimator outputs, each controller reads the same values during one update
+        const Axis3r angles = state_estimator->getAngles();
+        const Axis3r angular_velocity = state_estimator->getAngularVelocity();
+        const Axis4r position = Axis4r::xyzToAxis4(state_estimator->getPosition(), true);
+        const Axis4r velocity_local = Axis4r::xyzToAxis4(
+            state_estimator->transformToBodyFrame(state_estimator->getLinearVelocity()), true);
+        member.orientation = state_estimator->getOrientation();
+
+        //velocity goals from the api are known now, goals coming out of the position stage are rotated later
+        bool has_velocity_goal = false;
+        for (unsigned int axis = 0; axis < kAxisCount; ++axis)
+            has_velocity_goal |= lanes_.bound_mode[first_lane + axis] == static_cast<int>(GoalModeType::VelocityWorld);
+        Axis4r velocity_goal_local;
+        if (has_velocity_goal)
+            velocity_goal_local = Axis4r::xyzToAxis4(
+                state_estimator->transformToBodyFrame(Axis4r::axis4ToXyz(goal_val, true)), true);
+
+        for (unsigned int axis = 0; axis < kAxisCount; ++axis) {
+            const size_t lane = first_lane + axis;
+            lanes_.millis[lane] = millis;
+            lanes_.goal[lane] = goal_val[axis];
+            lanes_.velocity_goal_local[lane] = velocity_goal_local[axis];
+            stages_[kPosition].goal[lane] = goal_val[axis];
+            stages_[kPosition].measured[lane] = position[axis];
+            stages_[kVelocity].measured[lane] = velocity_local[axis];
+            stages_[kAngleLevel].measured[lane] = axis < 3 ? angles[axis] : 0;
+            stages_[kAngleRate].measured[lane] = axis < 3 ? angular_velocity[axis] : 0;
+        }
+
+        member.staged = true;
+        if (++staged_count_ == member_count_)
+            update();
+    }
+
+    void getOutput(unsigned int slot, Axis4r& output) const
+    {
+        for (unsigned int axis = 0; axis < kAxisCount; ++axis)
+            output[axis] = lanes_.output[slot * kAxisCount + axis];
+    }
+
+    bool isLastGoalModeAllPassthrough(unsigned int slot) const
+    {
+        for (unsigned int axis = 0; axis < kAxisCount; ++axis) {
+            if (lanes_.last_goal_mode[slot * kAxisCount + axis] != GoalModeType::Passthrough)
+                return false;
+        }
+        return true;
+    }
+
+    static void notifyOutput(SwarmMemberController* controller);
+
+private:
+    static constexpr unsigned int kAxisCount = 4;
+    static constexpr int kNoController = -1;
+
+    enum StageIndex
+    {
+        kPosition = 0,
+        kVelocity,
+        kAngleLevel,
+        kAngleRate,
+        kStageCount
+    };
+
+    //one PidController per lane, see PidController and StdPidIntegrator for the math
+    struct PidStage
+    {
+        //gains
+        std::vector<float> kp, ki, kd;
+        std::vector<float> min_output, max_output;
+        std::vector<float> output_bias, iterm_discount;
+        std::vector<float> time_scale, min_dt;
+        //state
+        std::vector<float> goal, measured;
+        std::vector<float> iterm, last_error, output;
+        std::vector<uint64_t> last_time;
+        //scratch
+        std::vector<float> dt;
+
+        void resize(size_t lane_count)
+        {
+            for (std::vector<float>* values : { &kp, &ki, &kd, &min_output, &max_output, &output_bias, &iterm_discount,
+                                                &time_scale, &min_dt, &goal, &measured, &iterm, &last_error, &output, &dt })
+                values->resize(lane_count, 0);
+            last_time.resize(lane_count, 0);
+        }
+
+        void setConfig(size_t lane, const PidConfig<float>& config)
+        {
+            kp[lane] = config.kp;
+            ki[lane] = config.ki;
+            kd[lane] = config.kd;
+            min_output[lane] = config.min_output;
+            max_output[lane] = config.max_output;
+            output_bias[lane] = config.output_bias;
+            iterm_discount[lane] = config.iterm_discount;
+            time_scale[lane] = config.time_scale;
+        }
+
+        void reset(size_t lane, uint64_t millis)
+        {
+            goal[lane] = 0;
+            measured[lane] = 0;
+            last_time[lane] = millis;
+            iterm[lane] = 0;
+            last_error[lane] = 0;
+            min_dt[lane] = time_scale[lane] * time_scale[lane];
+        }
+
+        void preloadOutput(size_t lane, float value)
+        {
+            iterm[lane] = clip(value - output_bias[lane], min_output[lane], max_output[lane]);
+            output[lane] = value;
+        }
+
+        void update(const std::vector<uint64_t>& millis, const std::vector<uint32_t>& active)
+        {
+            const size_t lane_count = goal.size();
+            for (size_t lane = 0; lane < lane_count; ++lane)
+                dt[lane] = (millis[lane] - last_time[lane]) * time_scale[lane];
+
+            //every value is computed for every lane and then selected, lanes that are not active keep their state
+            for (size_t lane = 0; lane < lane_count; ++lane) {
+                const float error = goal[lane] - measured[lane];
+                const float lane_dt = dt[lane];
+                const bool step = (active[lane] != 0) & (lane_dt > min_dt[lane]);
+
+                const float pterm = error * kp[lane];
+                const float next_iterm = clip(iterm[lane] * iterm_discount[lane] + lane_dt * error * ki[lane], min_output[lane], max_output[lane]);
+                const float lane_iterm = step ? next_iterm : iterm[lane];
+                //safe_dt equals lane_dt wherever the derivative is used
+                const float safe_dt = std::max(lane_dt, min_dt[lane]);
+                const float next_dterm = (error - last_error[lane]) / safe_dt * kd[lane];
+                const float dterm = step ? next_dterm : 0;
+                const float next_output = clip(output_bias[lane] + pterm + lane_iterm + dterm, min_output[lane], max_output[lane]);
+
+                iterm[lane] = lane_iterm;
+                last_error[lane] = step ? error : last_error[lane];
+                output[lane] = active[lane] != 0 ? next_output : output[lane];
+            }
+
+            for (size_t lane = 0; lane < lane_count; ++lane)
+                last_time[lane] = active[lane] != 0 ? millis[lane] : last_time[lane];
+        }
+    };
+
+    //per lane values that are not owned by one stage
+    struct Lanes
+    {
+        std::vector<int> bound_mode; //GoalModeType of the bound controller or kNoController
+        std::vector<GoalModeType> last_goal_mode;
+        std::vector<uint64_t> millis;
+        std::vector<uint32_t> active;
+        std::vector<float> goal;
+        std::vector<float> velocity_goal_local;
+        std::vector<float> output;
+
+        size_t size() const
+        {
+            return output.size();
+        }
+
+        void resize(size_t lane_count)
+        {
+            bound_mode.resize(lane_count, kNoController);
+            last_goal_mode.resize(lane_count, GoalModeType::Unknown);
+            millis.resize(lane_count, 0);
+            active.resize(lane_count, 0);
+            goal.resize(lane_count, 0);
+            velocity_goal_local.resize(lane_count, 0);
+            output.resize(lane_count, 0);
+        }
+    };
+
+    struct Member
+    {
+        SwarmMemberController* controller = nullptr;
+        Params* params = nullptr;
+        const IBoardClock* clock = nullptr;
+        Axis4r orientation;
+        bool staged = false;
+    };
+
+private:
+    static uint64_t getMillis(const Member& member)
+    {
+        return member.clock == nullptr ? 0 : member.clock->millis();
+    }
+
+    //TODO: replace with std::clamp after moving to C++17
+    static float clip(float val, float min_value, float max_value)
+    {
+        return std::max(min_value, std::min(val, max_value));
+    }
+
+    //same checks and configs as initialize() of the axis controllers
+    void bindLane(unsigned int slot, unsigned int axis, GoalModeType mode, uint64_t millis)
+    {
+        const size_t lane = slot * kAxisCount + axis;
+        const Params* params = members_[slot].params;
+        const int previous_mode = lanes_.bound_mode[lane];
+
+        switch (mode) {
+        case GoalModeType::AngleRate:
+            if (axis > 2)
+                throw std::invalid_argument("AngleRateController only supports axis 0-2 but it was " + std::to_string(axis));
+            break;
+        case GoalModeType::AngleLevel:
+            if (axis > 2)
+                throw std::invalid_argument("AngleLevelController only supports axis 0-2 but it was " + std::to_string(axis));
+            break;
+        case GoalModeType::VelocityWorld:
+            if (axis == 2)
+                throw std::invalid_argument("axis must be 0, 1 or 3 but it was " + std::to_string(axis) + " because yaw cannot be controlled by VelocityController");
+            break;
+        case GoalModeType::PositionWorld:
+            if (axis == 2)
+                throw std::invalid_argument("PositionController does not support yaw axis i.e. " + std::to_string(axis));
+            break;
+        case GoalModeType::Passthrough:
+        case GoalModeType::ConstantOutput:
+            break;
+        case GoalModeType::Unknown:
+            lanes_.bound_mode[lane] = kNoController;
+            return;
+        default:
+            throw std::invalid_argument("Axis controller type is not yet implemented for axis " + std::to_string(axis));
+        }
+        lanes_.bound_mode[lane] = static_cast<int>(mode);
+
+        //initialize, this also picks up changed gains
+        stages_[kPosition].setConfig(lane, PidConfig<float>(params->position_pid.p[axis], params->position_pid.i[axis], params->position_pid.d[axis]));
+        PidConfig<float> velocity_config(params->velocity_pid.p[axis], params->velocity_pid.i[axis], params->velocity_pid.d[axis]);
+        velocity_config.iterm_discount = params->velocity_pid.iterm_discount[axis];
+        velocity_config.output_bias = params->velocity_pid.output_bias[axis];
+        stages_[kVelocity].setConfig(lane, velocity_config);
+        stages_[kAngleLevel].setConfig(lane, PidConfig<float>(params->angle_level_pid.p[axis], params->angle_level_pid.i[axis], params->angle_level_pid.d[axis]));
+        stages_[kAngleRate].setConfig(lane, PidConfig<float>(params->angle_rate_pid.p[axis], params->angle_rate_pid.i[axis], params->angle_rate_pid.d[axis]));
+
+        resetLane(lane, millis);
+
+        if (params->bumpless_transfer && previous_mode != kNoController)
+            preloadLane(lane, axis, mode, lanes_.output[lane]);
+    }
+
+    void resetLane(size_t lane, uint64_t millis)
+    {
+        for (PidStage& stage : stages_)
+            stage.reset(lane, millis);
+    }
+
+    //same as preloadOutput() of the axis controllers
+    void preloadLane(size_t lane, unsigned int axis, GoalModeType mode, float output)
+    {
+        switch (mode) {
+        case GoalModeType::AngleRate:
+        case GoalModeType::AngleLevel:
+            stages_[kAngleRate].preloadOutput(lane, output);
+            break;
+        case GoalModeType::VelocityWorld:
+        case GoalModeType::PositionWorld:
+            if (axis == 3)
+                stages_[kVelocity].preloadOutput(lane, 1 - 2 * output); //inverse of the throttle mapping
+            else
+                stages_[kAngleRate].preloadOutput(lane, output);
+            break;
+        default:
+            //output does not depend on history
+            break;
+        }
+    }
+
+    void prepareVelocityGoals()
+    {
+        const PidStage& position = stages_[kPosition];
+        PidStage& velocity = stages_[kVelocity];
+
+        for (size_t slot = 0; slot < members_.size(); ++slot) {
+            const Member& member = members_[slot];
+            if (!member.staged)
+                continue;
+
+            for (unsigned int axis = 0; axis < kAxisCount; ++axis) {
+                const size_t lane = slot * kAxisCount + axis;
+                if (lanes_.bound_mode[lane] == static_cast<int>(GoalModeType::PositionWorld)) {
+                    //PositionController only sets its own axis in the goal of its velocity controller
+                    Axis4r velocity_goal_world;
+                    velocity_goal_world[axis] = position.output[lane] * member.params->velocity_pid.max_limit[axis];
+                    const Axis4r velocity_goal_local = Axis4r::xyzToAxis4(
+                        body_frame_transform_(member.orientation, Axis4r::axis4ToXyz(velocity_goal_world, true)), true);
+                    velocity.goal[lane] = velocity_goal_local[axis];
+                }
+                else
+                    velocity.goal[lane] = lanes_.velocity_goal_local[lane];
+            }
+        }
+    }
+
+    void prepareAngleLevelGoals()
+    {
+        const PidStage& velocity = stages_[kVelocity];
+        PidStage& angle_level = stages_[kAngleLevel];
+
+        for (size_t slot = 0; slot < members_.size(); ++slot) {
+            const Member& member = members_[slot];
+            if (!member.staged)
+                continue;
+
+            for (unsigned int axis = 0; axis < 3; ++axis) {
+                const size_t lane = slot * kAxisCount + axis;
+                const int mode = lanes_.bound_mode[lane];
+                TReal goal_angle;
+                if (mode == static_cast<int>(GoalModeType::VelocityWorld) || mode == static_cast<int>(GoalModeType::PositionWorld)) {
+                    //+vy is +ve roll, +vx is -ve pitch
+                    const float level_output = axis == 0 ? velocity.output[lane] : -velocity.output[lane];
+                    goal_angle = level_output * member.params->angle_level_pid.max_limit[axis];
+                }
+                else
+                    goal_angle = lanes_.goal[lane];
+
+                TReal measured_angle = angle_level.measured[lane];
+                adjustToMinDistanceAngles(measured_angle, goal_angle);
+                angle_level.goal[lane] = goal_angle;
+                angle_level.measured[lane] = measured_angle;
+            }
+        }
+    }
+
+    void prepareAngleRateGoals()
+    {
+        const PidStage& angle_level = stages_[kAngleLevel];
+        PidStage& angle_rate = stages_[kAngleRate];
+
+        for (size_t slot = 0; slot < members_.size(); ++slot) {
+            const Member& member = members_[slot];
+            if (!member.staged)
+                continue;
+
+            for (unsigned int axis = 0; axis < 3; ++axis) {
+                const size_t lane = slot * kAxisCount + axis;
+                angle_rate.goal[lane] = lanes_.bound_mode[lane] == static_cast<int>(GoalModeType::AngleRate)
+                                            ? lanes_.goal[lane]
+                                            : angle_level.output[lane] * member.params->angle_rate_pid.max_limit[axis];
+            }
+        }
+    }
+
+    void collectOutputs()
+    {
+        const PidStage& velocity = stages_[kVelocity];
+        const PidStage& angle_rate = stages_[kAngleRate];
+
+        for (size_t slot = 0; slot < members_.size(); ++slot) {
+            const Member& member = members_[slot];
+            if (!member.staged)
+                continue;
+
+            for (unsigned int axis = 0; axis < kAxisCount; ++axis) {
+                const size_t lane = slot * kAxisCount + axis;
+                switch (lanes_.bound_mode[lane]) {
+                case static_cast<int>(GoalModeType::AngleRate):
+                case static_cast<int>(GoalModeType::AngleLevel):
+                    lanes_.output[lane] = angle_rate.output[lane];
+                    break;
+                case static_cast<int>(GoalModeType::VelocityWorld):
+                case static_cast<int>(GoalModeType::PositionWorld):
+                    if (axis == 3) {
+                        //+vz is -ve throttle (NED coordinates)
+                        const float output = (-velocity.output[lane] + 1) / 2; //-1 to 1 --> 0 to 1
+                        lanes_.output[lane] = std::max(output, member.params->velocity_pid.min_throttle);
+                    }
+                    else
+                        lanes_.output[lane] = angle_rate.output[lane];
+                    break;
+                case static_cast<int>(GoalModeType::Passthrough):
+                    lanes_.output[lane] = lanes_.goal[lane];
+                    break;
+                case static_cast<int>(GoalModeType::ConstantOutput):
+                    lanes_.output[lane] = 0;
+                    break;
+                default:
+                    //no controller, output stays as it was
+                    break;
+                }
+            }
+        }
+    }
+
+    //same as AngleLevelController::adjustToMinDistanceAngles
+    static void adjustToMinDistanceAngles(TReal& angle1, TReal& angle2)
+    {
+        static constexpr TReal TwoPi = 2 * M_PIf;
+
+        //first make sure both angles are restricted from -360 to +360
+        angle1 = static_cast<TReal>(std::fmod(angle1, TwoPi));
+        angle2 = static_cast<TReal>(std::fmod(angle2, TwoPi));
+
+        //now make sure both angles are restricted from 0 to 360
+        if (angle1 < 0)
+            angle1 = TwoPi + angle1;
+        if (angle2 < 0)
+            angle2 = TwoPi + angle2;
+
+        //measure distance between two angles
+        auto dist = angle1 - angle2;
+
+        //if its > 180 then invert first angle
+        if (dist > M_PIf)
+            angle1 = angle1 - TwoPi;
+        //if two much on other side then invert second angle
+        else if (dist < -M_PIf)
+            angle2 = angle2 - TwoPi;
+    }
+
+private:
+    BodyFrameTransform body_frame_transform_;
+
+    std::vector<Member> members_;
+    unsigned int member_count_ = 0;
+    unsigned int staged_count_ = 0;
+    std::vector<SwarmMemberController*> finished_members_;
+
+    Lanes lanes_;
+    PidStage stages_[kStageCount];
+};
+
+/*
+IController of one vehicle in a SwarmCascadeController. update() stages the inputs, the output is ready once the
+swarm has run, which is signalled through the output callback.
+*/
+class SwarmMemberController : public IController
+{
+public:
+    typedef std::function<void()> OutputCallback;
+
+public:
+    SwarmMemberController(SwarmCascadeController* swarm, Params* params, const IBoardClock* clock, ICommLink* comm_link,
+                          const OutputCallback& output_callback)
+        : swarm_(swarm), comm_link_(comm_link), output_callback_(output_callback)
+    {
+        slot_ = swarm_->addMember(this, params, clock);
+    }
+
+    virtual ~SwarmMemberController()
+    {
+        swarm_->removeMember(slot_);
+    }
+
+    SwarmMemberController(const SwarmMemberController&) = delete;
+    SwarmMemberController& operator=(const SwarmMemberController&) = delete;
+
+    virtual void initialize(const IGoal* goal, const IStateEstimator* state_estimator) override
+    {
+        goal_ = goal;
+        state_estimator_ = state_estimator;
+    }
+
+    virtual void reset() override
+    {
+        IController::reset();
+
+        swarm_->resetMember(slot_);
+        output_ = Axis4r();
+    }
+
+    virtual void update() override
+    {
+        IController::update();
+
+        swarm_->stageMember(slot_, goal_, state_estimator_, comm_link_);
+    }
+
+    virtual const Axis4r& getOutput() override
+    {
+        return output_;
+    }
+
+    virtual bool isLastGoalModeAllPassthrough() override
+    {
+        return swarm_->isLastGoalModeAllPassthrough(slot_);
+    }
+
+private:
+    friend class SwarmCascadeController;
+
+    void onOutput()
+    {
+        swarm_->getOutput(slot_, output_);
+        if (output_callback_)
+            output_callback_();
+    }
+
+private:
+    SwarmCascadeController* swarm_;
+    ICommLink* comm_link_;
+    OutputCallback output_callback_;
+    unsigned int slot_;
+
+    const IGoal* goal_ = nullptr;
+    const IStateEstimator* state_estimator_ = nullptr;
+    Axis4r output_;
+};
+
+inline void SwarmCascadeController::notifyOutput(SwarmMemberController* controller)
+{
+    controller->onOutput();
+}
+
+} //namespace
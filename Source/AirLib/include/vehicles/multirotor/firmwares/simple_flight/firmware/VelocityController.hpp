@@ -7,6 +7,7 @@
 #include "interfaces/CommonStructs.hpp"
 #include "interfaces/IAxisController.hpp"
 #include "AngleLevelController.hpp"
+#include "PassthroughController.hpp"
 #include "Params.hpp"
 #include "PidController.hpp"
 #include "common/common_utils/Utils.hpp"
@@ -20,7 +21,7 @@ class VelocityController : public IAxisController
 {
 public:
     VelocityController(Params* params, const IBoardClock* clock = nullptr)
-        : params_(params), clock_(clock)
+        : params_(params), clock_(clock), pid_(clock), angle_level_controller_(params, clock)
     {
     }
 
@@ -36,17 +37,17 @@ public:
         pid_config.iterm_discount = params_->velocity_pid.iterm_discount[axis];
         pid_config.output_bias = params_->velocity_pid.output_bias[axis];
 
-        pid_.reset(new PidController<float>(clock_, pid_config));
+        pid_.setConfig(pid_config);
 
         //we will be setting goal for child controller so we need these two things
         child_mode_ = GoalMode::getUnknown();
         switch (axis_) {
         case 0:
-            child_controller_.reset(new AngleLevelController(params_, clock_));
+            child_controller_ = &angle_level_controller_;
             child_mode_[axis_] = GoalModeType::AngleLevel; //vy = roll
             break;
         case 1:
-            child_controller_.reset(new AngleLevelController(params_, clock_));
+            child_controller_ = &angle_level_controller_;
             child_mode_[axis_] = GoalModeType::AngleLevel; //vx = - pitch
             break;
         case 2:
@@ -56,7 +57,7 @@ public:
             //not really required
             //output of parent controller is -1 to 1 which
             //we will transform to 0 to 1
-            child_controller_.reset(new PassthroughController());
+            child_controller_ = &passthrough_controller_;
             child_mode_[axis_] = GoalModeType::Passthrough;
             break;
         default:
@@ -71,7 +72,7 @@ public:
     {
         IAxisController::reset();
 
-        pid_->reset();
+        pid_.reset();
         child_controller_->reset();
         child_goal_ = Axis4r();
         output_ = TReal();
@@ -86,18 +87,18 @@ public:
             goal_->getGoalValue(), true);
         const Axis4r& goal_velocity_local = Axis4r::xyzToAxis4(
             state_estimator_->transformToBodyFrame(goal_velocity_world), true);
-        pid_->setGoal(goal_velocity_local[axis_]);
+        pid_.setGoal(goal_velocity_local[axis_]);
 
         const Axis3r& measured_velocity_world = state_estimator_->getLinearVelocity();
         const Axis4r& measured_velocity_local = Axis4r::xyzToAxis4(
             state_estimator_->transformToBodyFrame(measured_velocity_world), true);
-        pid_->setMeasured(measured_velocity_local[axis_]);
-        pid_->update();
+        pid_.setMeasured(measured_velocity_local[axis_]);
+        pid_.update();
 
         //use this to drive child controller
         switch (axis_) {
         case 0: //+vy is +ve roll
-            child_goal_[axis_] = pid_->getOutput() * params_->angle_level_pid.max_limit[axis_];
+            child_goal_[axis_] = pid_.getOutput() * params_->angle_level_pid.max_limit[axis_];
             child_controller_->update();
             output_ = child_controller_->getOutput();
 
@@ -108,12 +109,12 @@ public:
 
             break;
         case 1: //+vx is -ve pitch
-            child_goal_[axis_] = -pid_->getOutput() * params_->angle_level_pid.max_limit[axis_];
+            child_goal_[axis_] = -pid_.getOutput() * params_->angle_level_pid.max_limit[axis_];
             child_controller_->update();
             output_ = child_controller_->getOutput();
             break;
         case 3: //+vz is -ve throttle (NED coordinates)
-            output_ = (-pid_->getOutput() + 1) / 2; //-1 to 1 --> 0 to 1
+            output_ = (-pid_.getOutput() + 1) / 2; //-1 to 1 --> 0 to 1
             output_ = std::max(output_, params_->velocity_pid.min_throttle);
             break;
         default:
@@ -126,6 +127,15 @@ public:
         return output_;
     }
 
+    virtual void preloadOutput(TReal output) override
+    {
+        if (axis_ == 3)
+            pid_.preloadOutput(1 - 2 * output); //inverse of the throttle mapping in update
+        else
+            child_controller_->preloadOutput(output);
+        output_ = output;
+    }
+
     /********************  IGoal ********************/
     virtual const Axis4r& getGoalValue() const override
     {
@@ -149,8 +159,10 @@ private:
 
     Params* params_;
     const IBoardClock* clock_;
-    std::unique_ptr<PidController<float>> pid_;
-    std::unique_ptr<IAxisController> child_controller_;
+    PidController<float> pid_;
+    AngleLevelController angle_level_controller_;
+    PassthroughController passthrough_controller_;
+    IAxisController* child_controller_ = nullptr;
 };
 
 } //namespace
\ No newline at end of file
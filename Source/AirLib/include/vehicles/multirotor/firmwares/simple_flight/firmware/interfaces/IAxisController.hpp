@@ -15,6 +15,10 @@ public:
     virtual void initialize(unsigned int axis, const IGoal* goal, const IStateEstimator* state_estimator) = 0;
     virtual TReal getOutput() = 0;
 
+    //called after reset when the controller takes over an axis from another controller, controllers that can
+    //should continue from this output instead of jumping (bumpless transfer)
+    virtual void preloadOutput(TReal output) = 0;
+
     virtual void reset() override
     {
         //disable checks for reset/update sequence because
@@ -708,6 +708,57 @@ __pragma(warning(disable : 4239))
             return pimpl_->client.call("simCreateVoxelGrid", RpcLibAdaptorsBase::Vector3r(position), x, y, z, res, output_file).as<bool>();
         }
 
+        bool RpcLibClientBase::simBuildOccupancyMap(const msr::airlib::Vector3r& center, float size, float resolution)
+        {
+            return pimpl_->client.call("simBuildOccupancyMap", RpcLibAdaptorsBase::Vector3r(center), size, resolution).as<bool>();
+        }
+
+        int RpcLibClientBase::simGetOccupancy(const msr::airlib::Vector3r& point)
+        {
+            return pimpl_->client.call("simGetOccupancy", RpcLibAdaptorsBase::Vector3r(point)).as<int>();
+        }
+
+        msr::airlib::Vector3r RpcLibClientBase::simCastRayOccupancyMap(const msr::airlib::Vector3r& start, const msr::airlib::Vector3r& end)
+        {
+            return pimpl_->client.call("simCastRayOccupancyMap", RpcLibAdaptorsBase::Vector3r(start), RpcLibAdaptorsBase::Vector3r(end)).as<RpcLibAdaptorsBase::Vector3r>().to();
+        }
+
+        std::vector<float> RpcLibClientBase::simGetOccupancyMapRegion(const msr::airlib::Vector3r& min, const msr::airlib::Vector3r& max)
+        {
+            return pimpl_->client.call("simGetOccupancyMapRegion", RpcLibAdaptorsBase::Vector3r(min), RpcLibAdaptorsBase::Vector3r(max)).as<std::vector<float>>();
+        }
+
+        bool RpcLibClientBase::simSaveOccupancyMap(const std::string& file_path)
+        {
+            return pimpl_->client.call("simSaveOccupancyMap", file_path).as<bool>();
+        }
+
+        bool RpcLibClientBase::simLoadOccupancyMap(const std::string& file_path)
+        {
+            return pimpl_->client.call("simLoadOccupancyMap", file_path).as<bool>();
+        }
+
+        int RpcLibClientBase::simAddGeoFence(const std::vector<float>& vertices, float min_z, float max_z, bool keep_out)
+        {
+            return pimpl_->client.call("simAddGeoFence", vertices, min_z, max_z, keep_out).as<int>();
+        }
+
+        bool RpcLibClientBase::simRemoveGeoFence(int fence_id)
+        {
+            return pimpl_->client.call("simRemoveGeoFence", fence_id).as<bool>();
+        }
+
+        bool RpcLibClientBase::simSetSafetySeparation(float distance)
+        {
+            return pimpl_->client.call("simSetSafetySeparation", distance).as<bool>();
+        }
+
+        std::vector<SafetyEvent> RpcLibClientBase::simGetSafetyEvents()
+        {
+            const auto& result = pimpl_->client.call("simGetSafetyEvents").as<std::vector<RpcLibAdaptorsBase::SafetyEvent>>();
+            return RpcLibAdaptorsBase::SafetyEvent::to(result);
+        }
+
 
         void RpcLibClientBase::cancelLastTask(const std::string& vehicle_name)
         {
@@ -161,6 +161,12 @@ namespace airlib
         });
 
         pimpl_->server.bind("simGetImages", [&](const std::vector<RpcLibAdaptorsBase::ImageRequest>& request_adapter, const std::string& vehicle_name) -> vector<RpcLibAdaptorsBase::ImageResponse> {
+            //without a world (recording replay) the vehicle serves its own images
+            if (api_provider_->getWorldSimApi() == nullptr) {
+                std::vector<ImageCaptureBase::ImageResponse> response;
+                getVehicleSimApi(vehicle_name)->getImageCapture()->getImages(RpcLibAdaptorsBase::ImageRequest::to(request_adapter), response);
+                return RpcLibAdaptorsBase::ImageResponse::from(response);
+            }
             const auto& response = getWorldSimApi()->getImages(RpcLibAdaptorsBase::ImageRequest::to(request_adapter), vehicle_name);
             return RpcLibAdaptorsBase::ImageResponse::from(response);
         });
@@ -565,6 +571,46 @@ namespace airlib
         pimpl_->server.bind("simCreateVoxelGrid", [&](const RpcLibAdaptorsBase::Vector3r& position, const int& x, const int& y, const int& z, const float& res, const std::string& output_file) -> bool {
             return getWorldSimApi()->createVoxelGrid(position.to(), x, y, z, res, output_file);
         });
+
+        pimpl_->server.bind("simBuildOccupancyMap", [&](const RpcLibAdaptorsBase::Vector3r& center, float size, float resolution) -> bool {
+            return getWorldSimApi()->buildOccupancyMap(center.to(), size, resolution);
+        });
+
+        pimpl_->server.bind("simGetOccupancy", [&](const RpcLibAdaptorsBase::Vector3r& point) -> int {
+            return getWorldSimApi()->getOccupancy(point.to());
+        });
+
+        pimpl_->server.bind("simCastRayOccupancyMap", [&](const RpcLibAdaptorsBase::Vector3r& start, const RpcLibAdaptorsBase::Vector3r& end) -> RpcLibAdaptorsBase::Vector3r {
+            return RpcLibAdaptorsBase::Vector3r(getWorldSimApi()->castRayOccupancyMap(start.to(), end.to()));
+        });
+
+        pimpl_->server.bind("simGetOccupancyMapRegion", [&](const RpcLibAdaptorsBase::Vector3r& min, const RpcLibAdaptorsBase::Vector3r& max) -> std::vector<float> {
+            return getWorldSimApi()->getOccupancyMapRegion(min.to(), max.to());
+        });
+
+        pimpl_->server.bind("simSaveOccupancyMap", [&](const std::string& file_path) -> bool {
+            return getWorldSimApi()->saveOccupancyMap(file_path);
+        });
+
+        pimpl_->server.bind("simLoadOccupancyMap", [&](const std::string& file_path) -> bool {
+            return getWorldSimApi()->loadOccupancyMap(file_path);
+        });
+
+        pimpl_->server.bind("simAddGeoFence", [&](const std::vector<float>& vertices, float min_z, float max_z, bool keep_out) -> int {
+            return getWorldSimApi()->addGeoFence(vertices, min_z, max_z, keep_out);
+        });
+
+        pimpl_->server.bind("simRemoveGeoFence", [&](int fence_id) -> bool {
+            return getWorldSimApi()->removeGeoFence(fence_id);
+        });
+
+        pimpl_->server.bind("simSetSafetySeparation", [&](float distance) -> bool {
+            return getWorldSimApi()->setSafetySeparation(distance);
+        });
+
+        pimpl_->server.bind("simGetSafetyEvents", [&]() -> std::vector<RpcLibAdaptorsBase::SafetyEvent> {
+            return RpcLibAdaptorsBase::SafetyEvent::from(getWorldSimApi()->getSafetyEvents());
+        });
         
         pimpl_->server.bind("getUWBData", [&](const std::string& sensor_name, const std::string& vehicle_name) -> RpcLibAdaptorsBase::MarLocUwbReturnMessage {
             const auto& marLocUwbReturnMessage = getVehicleApi(vehicle_name)->getUWBData(sensor_name);
@@ -0,0 +1,89 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+//in header only mode, control library is not available
+#ifndef AIRLIB_HEADER_ONLY
+//RPC code requires C++14. If build system like Unreal doesn't support it then use compiled binaries
+#ifndef AIRLIB_NO_RPC
+//if using Unreal Build system then include precompiled header file first
+
+#include "recording/ReplayRpcLibClient.hpp"
+
+#include "common/Common.hpp"
+STRICT_MODE_OFF
+
+#ifndef RPCLIB_MSGPACK
+#define RPCLIB_MSGPACK clmdep_msgpack
+#endif // !RPCLIB_MSGPACK
+
+#ifdef nil
+#undef nil
+#endif // nil
+
+#include "common/common_utils/WindowsApisCommonPre.hpp"
+#undef FLOAT
+#undef check
+#include "rpc/client.h"
+//TODO: HACK: UE4 defines macro with stupid names like "check" that conflicts with msgpack library
+#ifndef check
+#define check(expr) (static_cast<void>((expr)))
+#endif
+#include "common/common_utils/WindowsApisCommonPost.hpp"
+
+STRICT_MODE_ON
+#ifdef _MSC_VER
+__pragma(warning(disable : 4239))
+#endif
+
+namespace msr
+{
+namespace airlib
+{
+
+    ReplayRpcLibClient::ReplayRpcLibClient(const string& ip_address, uint16_t port, float timeout_sec)
+        : RpcLibClientBase(ip_address, port, timeout_sec)
+    {
+    }
+
+    ReplayRpcLibClient::~ReplayRpcLibClient()
+    {
+    }
+
+    void ReplayRpcLibClient::replaySetPlayback(bool as_fast_as_possible, double speed)
+    {
+        static_cast<rpc::client*>(getClient())->call("replaySetPlayback", as_fast_as_possible, speed);
+    }
+
+    void ReplayRpcLibClient::replaySetLoop(bool loop)
+    {
+        static_cast<rpc::client*>(getClient())->call("replaySetLoop", loop);
+    }
+
+    void ReplayRpcLibClient::replaySetPaused(bool paused)
+    {
+        static_cast<rpc::client*>(getClient())->call("replaySetPaused", paused);
+    }
+
+    void ReplayRpcLibClient::replaySeek(double seconds)
+    {
+        static_cast<rpc::client*>(getClient())->call("replaySeek", seconds);
+    }
+
+    double ReplayRpcLibClient::replayGetTime()
+    {
+        return static_cast<rpc::client*>(getClient())->call("replayGetTime").as<double>();
+    }
+
+    double ReplayRpcLibClient::replayGetDuration()
+    {
+        return static_cast<rpc::client*>(getClient())->call("replayGetDuration").as<double>();
+    }
+
+    bool ReplayRpcLibClient::replayAdvanceFrame()
+    {
+        return static_cast<rpc::client*>(getClient())->call("replayAdvanceFrame").as<bool>();
+    }
+}
+} //namespace
+
+#endif
+#endif
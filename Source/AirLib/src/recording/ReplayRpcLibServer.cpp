@@ -0,0 +1,81 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+//in header only mode, control library is not available
+#ifndef AIRLIB_HEADER_ONLY
+//RPC code requires C++14. If build system like Unreal doesn't support it then use compiled binaries
+#ifndef AIRLIB_NO_RPC
+//if using Unreal Build system then include precompiled header file first
+
+#include "recording/ReplayRpcLibServer.hpp"
+
+#include "common/Common.hpp"
+STRICT_MODE_OFF
+
+#ifndef RPCLIB_MSGPACK
+#define RPCLIB_MSGPACK clmdep_msgpack
+#endif // !RPCLIB_MSGPACK
+#include "common/common_utils/MinWinDefines.hpp"
+#undef NOUSER
+
+#include "common/common_utils/WindowsApisCommonPre.hpp"
+#undef FLOAT
+#undef check
+#include "rpc/server.h"
+//TODO: HACK: UE4 defines macro with stupid names like "check" that conflicts with msgpack library
+#ifndef check
+#define check(expr) (static_cast<void>((expr)))
+#endif
+#include "common/common_utils/WindowsApisCommonPost.hpp"
+
+STRICT_MODE_ON
+
+namespace msr
+{
+namespace airlib
+{
+
+    ReplayRpcLibServer::ReplayRpcLibServer(RecordingReplay* replay, ApiProvider* api_provider, string server_address, uint16_t port)
+        : RpcLibServerBase(api_provider, server_address, port), replay_(replay)
+    {
+        rpc::server* server = static_cast<rpc::server*>(getServer());
+
+        //speed is ignored when as_fast_as_possible is set
+        server->bind("replaySetPlayback", [&](bool as_fast_as_possible, double speed) -> void {
+            replay_->setPlayback(as_fast_as_possible ? RecordingReplay::PlaybackMode::AsFastAsPossible : RecordingReplay::PlaybackMode::TimeScaled, speed);
+        });
+
+        server->bind("replaySetLoop", [&](bool loop) -> void {
+            replay_->setLoop(loop);
+        });
+
+        server->bind("replaySetPaused", [&](bool paused) -> void {
+            replay_->setPaused(paused);
+        });
+
+        //times are in seconds from the start of the recording
+        server->bind("replaySeek", [&](double seconds) -> void {
+            replay_->seekRelative(seconds);
+        });
+
+        server->bind("replayGetTime", [&]() -> double {
+            return (replay_->getPlayhead() - replay_->getStartTime()) * 1E-9;
+        });
+
+        server->bind("replayGetDuration", [&]() -> double {
+            return (replay_->getEndTime() - replay_->getStartTime()) * 1E-9;
+        });
+
+        server->bind("replayAdvanceFrame", [&]() -> bool {
+            return replay_->advanceFrame();
+        });
+    }
+
+    //required for pimpl
+    ReplayRpcLibServer::~ReplayRpcLibServer()
+    {
+    }
+}
+} //namespace
+
+#endif
+#endif
@@ -5,6 +5,8 @@
 #ifndef AIRLIB_HEADER_ONLY
 
 #include <thread>
+#include <algorithm>
+#include <cmath>
 #include "safety/ObstacleMap.hpp"
 #include "common/common_utils/Utils.hpp"
 
@@ -13,15 +15,64 @@ namespace msr
 namespace airlib
 {
 
-    ObstacleMap::ObstacleMap(int ticks, bool odd_blindspots)
-        : distances_(ticks, Utils::max<float>() / 2), confidences_(ticks, 1), ticks_(ticks), blindspots_(ticks_, false) //init with all distances at max/2 (setting it to max can cause overflow later)
+    //atan2 as array operations that Eigen vectorizes, error is within 1E-5 radians which is far below the
+    //resolution of any map
+    template <typename TY, typename TX>
+    static void fastAtan2(const Eigen::ArrayBase<TY>& y, const Eigen::ArrayBase<TX>& x, Eigen::Array<float, 1, Eigen::Dynamic>& angles)
     {
+        angles = x.abs().min(y.abs()) / (x.abs().max(y.abs()) + 1E-30f);
+        angles = angles * (0.99997726f + angles.square() * (-0.33262347f + angles.square() * (0.19354346f + angles.square() * (-0.11643287f + angles.square() * (0.05265332f + angles.square() * -0.01172120f)))));
+        angles = (y.abs() > x.abs()).select(M_PIf / 2 - angles, angles);
+        angles = (x < 0).select(M_PIf - angles, angles);
+        angles = (y < 0).select(-angles, angles);
+    }
+
+    ObstacleMap::SnapshotReader::SnapshotReader(const ObstacleMap* map)
+        : map_(map)
+    {
+        while (true) {
+            index_ = map_->latest_.load();
+            map_->readers_[index_].fetch_add(1);
+            //writer may have published again and picked this snapshot before we pinned it
+            if (map_->latest_.load() == index_)
+                break;
+            map_->readers_[index_].fetch_sub(1);
+        }
+    }
+
+    ObstacleMap::SnapshotReader::~SnapshotReader()
+    {
+        map_->readers_[index_].fetch_sub(1);
+    }
+
+    const ObstacleMap::Snapshot& ObstacleMap::SnapshotReader::get() const
+    {
+        return map_->snapshots_[index_];
+    }
+
+    ObstacleMap::ObstacleMap(int ticks, bool odd_blindspots, int sectors)
+        : ticks_(ticks), sectors_(sectors)
+    {
+        if (ticks_ <= 0 || sectors_ <= 0)
+            throw std::invalid_argument(Utils::stringf("ObstacleMap needs at least one tick and one sector, got %d ticks and %d sectors", ticks_, sectors_));
+
+        //init with all distances at max/2 (setting it to max can cause overflow later)
+        working_.distances.assign(ticks_ * sectors_, Utils::max<float>() / 2);
+        working_.confidences.assign(ticks_ * sectors_, 1);
+        working_.tick_distances.resize(ticks_);
+        working_.tick_confidences.resize(ticks_);
+        working_.tick_sectors.resize(ticks_);
+        working_.blindspots.assign(ticks_, 0);
         if (odd_blindspots)
-            for (uint i = 1; i < distances_.size(); i += 2)
-                blindspots_.at(i) = true;
+            for (int i = 1; i < ticks_; i += 2)
+                working_.blindspots.at(i) = 1;
+
+        for (int i = 0; i < kSnapshotCount; ++i)
+            readers_[i] = 0;
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        publish();
     }
 
-    //handles +/- tick and wraps around circle
     //return value of this function is always >= 0 and < ticks_ (i.e. valid indices)
     int ObstacleMap::wrap(int tick) const
     {
@@ -31,32 +82,127 @@ namespace airlib
         return iw;
     }
 
+    int ObstacleMap::clampSector(int sector) const
+    {
+        return std::min(std::max(sector, 0), sectors_ - 1);
+    }
+
+    void ObstacleMap::publish()
+    {
+        //collapse sectors for queries that look in all of them, kept branch free so it vectorizes
+        std::copy(working_.distances.begin(), working_.distances.begin() + ticks_, working_.tick_distances.begin());
+        std::copy(working_.confidences.begin(), working_.confidences.begin() + ticks_, working_.tick_confidences.begin());
+        std::fill(working_.tick_sectors.begin(), working_.tick_sectors.end(), 0);
+        for (int s = 1; s < sectors_; ++s) {
+            const float* distances = working_.distances.data() + s * ticks_;
+            const float* confidences = working_.confidences.data() + s * ticks_;
+            for (int i = 0; i < ticks_; ++i) {
+                const bool closer = distances[i] < working_.tick_distances[i];
+                working_.tick_distances[i] = closer ? distances[i] : working_.tick_distances[i];
+                working_.tick_confidences[i] = closer ? confidences[i] : working_.tick_confidences[i];
+                working_.tick_sectors[i] = closer ? s : working_.tick_sectors[i];
+            }
+        }
+
+        //find a snapshot that is not the latest and that no query is reading
+        int index = -1;
+        while (index < 0) {
+            const int latest = latest_.load();
+            for (int i = 0; i < kSnapshotCount && index < 0; ++i)
+                if (i != latest && readers_[i].load() == 0)
+                    index = i;
+            if (index < 0)
+                std::this_thread::yield();
+        }
+
+        //sizes never change so these copies don't allocate
+        Snapshot& snapshot = snapshots_[index];
+        snapshot.distances = working_.distances;
+        snapshot.confidences = working_.confidences;
+        snapshot.tick_distances = working_.tick_distances;
+        snapshot.tick_confidences = working_.tick_confidences;
+        snapshot.tick_sectors = working_.tick_sectors;
+        snapshot.blindspots = working_.blindspots;
+
+        latest_.store(index);
+    }
+
     void ObstacleMap::update(float distance, int tick, int window, float confidence)
     {
-        std::lock_guard<std::mutex> lock(mutex_); //lock the map before update
+        std::lock_guard<std::mutex> lock(writer_mutex_);
 
         //update the specified window on the map
         for (int i = tick - window; i <= tick + window; ++i) {
             int iw = wrap(i);
-            distances_[iw] = distance;
-            confidences_[iw] = confidence;
+            for (int s = 0; s < sectors_; ++s) {
+                working_.distances[s * ticks_ + iw] = distance;
+                working_.confidences[s * ticks_ + iw] = confidence;
+            }
         }
+
+        publish();
     }
 
     void ObstacleMap::update(float distances[], float confidences[])
     {
-        std::lock_guard<std::mutex> lock(mutex_); //lock the map before update
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+
+        for (int s = 0; s < sectors_; ++s) {
+            std::copy(distances, distances + ticks_, working_.distances.begin() + s * ticks_);
+            std::copy(confidences, confidences + ticks_, working_.confidences.begin() + s * ticks_);
+        }
+
+        publish();
+    }
+
+    void ObstacleMap::update(const vector<real_T>& point_cloud, const Pose& sensor_pose, float max_range, float confidence)
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+
+        const int bin_count = ticks_ * sectors_;
+        const Eigen::Index point_count = static_cast<Eigen::Index>(point_cloud.size() / 3);
+
+        //range and bin of every point as array operations so they run in SIMD lanes,
+        //points we don't want go to an extra bin at bin_count
+        const Eigen::Map<const Eigen::Matrix<real_T, 3, Eigen::Dynamic>> sensor_points(point_cloud.data(), 3, point_count);
+        scan_points_.noalias() = sensor_pose.orientation.toRotationMatrix() * sensor_points;
+        scan_points_.colwise() += sensor_pose.position;
+        const auto x = scan_points_.row(0).array();
+        const auto y = scan_points_.row(1).array();
+        const auto z = scan_points_.row(2).array();
+        scan_horizontal_ = (x.square() + y.square()).sqrt();
+        scan_ranges_ = (scan_horizontal_.square() + z.square()).sqrt();
+
+        //same as angleToTick, shifted by one turn so truncation rounds down
+        fastAtan2(y, x, scan_angles_);
+        scan_ticks_ = ((scan_angles_ * (ticks_ / M_PIf) + 1) / 2 + ticks_).cast<int>();
+        scan_ticks_ = (scan_ticks_ >= ticks_).select(scan_ticks_ - ticks_, scan_ticks_);
+        //z is down in body frame
+        fastAtan2(-z, scan_horizontal_, scan_angles_);
+        scan_bins_ = ((scan_angles_ + M_PIf / 2) * (sectors_ / M_PIf)).cast<int>().min(sectors_ - 1) * ticks_ + scan_ticks_;
+        scan_bins_ = (scan_ranges_ > 0 && scan_ranges_ < max_range).select(scan_bins_, bin_count);
 
-        std::copy(distances, distances + ticks_, std::begin(distances_));
-        std::copy(confidences, confidences + ticks_, std::begin(confidences_));
+        //closest return in each bin
+        vector<float>& distances = working_.distances;
+        distances.resize(bin_count + 1);
+        std::fill(distances.begin(), distances.end(), max_range);
+        for (Eigen::Index i = 0; i < point_count; ++i)
+            distances[scan_bins_[i]] = std::min(distances[scan_bins_[i]], scan_ranges_[i]);
+        distances.resize(bin_count);
+        std::fill(working_.confidences.begin(), working_.confidences.end(), confidence);
+
+        publish();
     }
 
     void ObstacleMap::setBlindspot(int tick, bool blindspot)
     {
-        blindspots_.at(tick) = blindspot;
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+
+        working_.blindspots.at(tick) = blindspot ? 1 : 0;
+        publish();
     }
 
-    ObstacleMap::ObstacleInfo ObstacleMap::hasObstacle_(int from_tick, int to_tick) const
+    ObstacleMap::ObstacleInfo ObstacleMap::hasObstacle_(const Snapshot& snapshot, int from_tick, int to_tick, int from_sector, int to_sector, bool all_sectors) const
     {
         //make sure from <= to
         if (from_tick > to_tick) {
@@ -74,36 +220,71 @@ namespace airlib
         ObstacleMap::ObstacleInfo obs;
         obs.distance = Utils::max<float>();
         obs.confidence = 0;
-        for (int i = from_tick; i <= to_tick; ++i) {
-            int iw = wrap(i);
-            if (obs.distance > distances_[iw]) {
-                obs.tick = iw;
-                obs.distance = distances_[iw];
-                obs.confidence = confidences_[iw];
+        if (all_sectors) {
+            for (int i = from_tick; i <= to_tick; ++i) {
+                int iw = wrap(i);
+                if (obs.distance > snapshot.tick_distances[iw]) {
+                    obs.tick = iw;
+                    obs.sector = snapshot.tick_sectors[iw];
+                    obs.distance = snapshot.tick_distances[iw];
+                    obs.confidence = snapshot.tick_confidences[iw];
+                }
+            }
+        }
+        else {
+            for (int s = from_sector; s <= to_sector; ++s) {
+                for (int i = from_tick; i <= to_tick; ++i) {
+                    int iw = wrap(i);
+                    if (obs.distance > snapshot.distances[s * ticks_ + iw]) {
+                        obs.tick = iw;
+                        obs.sector = s;
+                        obs.distance = snapshot.distances[s * ticks_ + iw];
+                        obs.confidence = snapshot.confidences[s * ticks_ + iw];
+                    }
+                }
             }
         }
 
         return obs;
     }
 
-    ObstacleMap::ObstacleInfo ObstacleMap::hasObstacle(int from_tick, int to_tick)
+    ObstacleMap::ObstacleInfo ObstacleMap::hasObstacle(int from_tick, int to_tick) const
+    {
+        SnapshotReader reader(this);
+        const Snapshot& snapshot = reader.get();
+
+        if (snapshot.blindspots.at(wrap(from_tick)))
+            from_tick--;
+        if (snapshot.blindspots.at(wrap(to_tick)))
+            to_tick++;
+
+        return hasObstacle_(snapshot, from_tick, to_tick, 0, sectors_ - 1, true);
+    }
+
+    ObstacleMap::ObstacleInfo ObstacleMap::hasObstacle(int from_tick, int to_tick, int from_sector, int to_sector) const
     {
-        std::lock_guard<std::mutex> lock(mutex_); //lock the map before query
+        SnapshotReader reader(this);
+        const Snapshot& snapshot = reader.get();
 
-        if (blindspots_.at(wrap(from_tick)))
+        if (snapshot.blindspots.at(wrap(from_tick)))
             from_tick--;
-        if (blindspots_.at(wrap(to_tick)))
+        if (snapshot.blindspots.at(wrap(to_tick)))
             to_tick++;
 
-        return hasObstacle_(from_tick, to_tick);
+        from_sector = clampSector(from_sector);
+        to_sector = clampSector(to_sector);
+        if (from_sector > to_sector)
+            std::swap(from_sector, to_sector);
+
+        return hasObstacle_(snapshot, from_tick, to_tick, from_sector, to_sector, false);
     }
 
     //search whole map to find closest obstacle
-    ObstacleMap::ObstacleInfo ObstacleMap::getClosestObstacle()
+    ObstacleMap::ObstacleInfo ObstacleMap::getClosestObstacle() const
     {
-        std::lock_guard<std::mutex> lock(mutex_);
+        SnapshotReader reader(this);
 
-        return hasObstacle_(0, ticks_ - 1);
+        return hasObstacle_(reader.get(), 0, ticks_ - 1, 0, sectors_ - 1, true);
     }
 
     int ObstacleMap::getTicks() const
@@ -111,6 +292,11 @@ namespace airlib
         return ticks_;
     }
 
+    int ObstacleMap::getSectors() const
+    {
+        return sectors_;
+    }
+
     int ObstacleMap::angleToTick(float angle_rad) const
     {
         return Utils::floorToInt(
@@ -131,6 +317,16 @@ namespace airlib
     {
         return 2 * M_PIf * tick / ticks_;
     }
+
+    int ObstacleMap::elevationToSector(float elevation_rad) const
+    {
+        return clampSector(Utils::floorToInt((elevation_rad + M_PIf / 2) * sectors_ / M_PIf));
+    }
+
+    float ObstacleMap::sectorToElevationMid(int sector) const
+    {
+        return M_PIf * (sector + 0.5f) / sectors_ - M_PIf / 2;
+    }
 }
 } //namespace
 
@@ -118,8 +118,13 @@ namespace airlib
             //yaw to ticks
             int point_tick = obs_xy_ptr_->angleToTick(point_angle);
 
-            //get obstacles in the window at the tick direction around the window
-            result.dest_obs = obs_xy_ptr_->hasObstacle(point_tick - vehicle_params_.obs_window, point_tick + vehicle_params_.obs_window);
+            //elevation to sectors, body frame z is down
+            float point_elevation = std::atan2(-result.cur_dest_body[2], result.cur_dest_body.head<2>().norm());
+            int point_sector = obs_xy_ptr_->elevationToSector(point_elevation);
+
+            //get obstacles in the tick and sector windows around the destination direction
+            result.dest_obs = obs_xy_ptr_->hasObstacle(point_tick - vehicle_params_.obs_window, point_tick + vehicle_params_.obs_window,
+                                                       point_sector - vehicle_params_.obs_sector_window, point_sector + vehicle_params_.obs_sector_window);
 
             //less risk distance is better
             result.dest_risk_dist = cur_dest_norm + adjustClearanceForPrStl(vehicle_params_.obs_clearance, result.dest_obs.confidence) - result.dest_obs.distance;
@@ -0,0 +1,401 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+//in header only mode, control library is not available
+#ifndef AIRLIB_HEADER_ONLY
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "safety/SafetyMonitor.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    SafetyMonitor::SafetyMonitor(size_t event_capacity)
+        : fence_index_(std::make_shared<FenceIndex>()), events_(event_capacity)
+    {
+        setName("SafetyMonitor");
+    }
+
+    int SafetyMonitor::addVehicle(const std::string& name, const Kinematics::State* kinematics)
+    {
+        if (kinematics == nullptr)
+            throw std::invalid_argument(Utils::stringf("SafetyMonitor: vehicle '%s' has no kinematics", name.c_str()));
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        const int vehicle = static_cast<int>(vehicle_names_.size());
+        vehicle_names_.push_back(name);
+        vehicle_kinematics_.push_back(kinematics);
+        xs_.push_back(kinematics->pose.position.x());
+        ys_.push_back(kinematics->pose.position.y());
+        zs_.push_back(kinematics->pose.position.z());
+        fence_states_.push_back(kNone);
+        separation_states_.push_back(kNone);
+        sweep_order_.push_back(vehicle);
+        closest_neighbors_.push_back(kNone);
+        closest_distances2_.push_back(0);
+        return vehicle;
+    }
+
+    std::string SafetyMonitor::getVehicleName(int vehicle) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return vehicle_names_.at(vehicle);
+    }
+
+    int SafetyMonitor::getVehicleCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return static_cast<int>(vehicle_names_.size());
+    }
+
+    int SafetyMonitor::addFence(const shared_ptr<PolygonGeoFence>& fence, bool keep_out)
+    {
+        if (!fence)
+            throw std::invalid_argument("SafetyMonitor: fence must not be null");
+
+        std::lock_guard<std::mutex> edit_lock(fence_edit_mutex_);
+        const int fence_id = next_fence_id_++;
+        vector<Fence> fences = fence_index_->fences;
+        fences.push_back(Fence{ fence_id, fence, keep_out });
+        publishFences(std::move(fences));
+        return fence_id;
+    }
+
+    bool SafetyMonitor::removeFence(int fence_id)
+    {
+        std::lock_guard<std::mutex> edit_lock(fence_edit_mutex_);
+        const int index = fence_index_->find(fence_id);
+        if (index == kNone)
+            return false;
+
+        //violations of this fence end on the next update
+        vector<Fence> fences = fence_index_->fences;
+        fences.erase(fences.begin() + index);
+        publishFences(std::move(fences));
+        return true;
+    }
+
+    void SafetyMonitor::clearFences()
+    {
+        std::lock_guard<std::mutex> edit_lock(fence_edit_mutex_);
+        publishFences(vector<Fence>());
+    }
+
+    int SafetyMonitor::getFenceCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return static_cast<int>(fence_index_->fences.size());
+    }
+
+    void SafetyMonitor::publishFences(vector<Fence>&& fences)
+    {
+        //the physics step only waits for the pointer swap, not for the BVH build
+        auto index = std::make_shared<FenceIndex>();
+        index->fences = std::move(fences);
+        index->build();
+
+        shared_ptr<const FenceIndex> published = std::move(index);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            fence_index_.swap(published);
+        }
+        //the previous index is released here, outside the lock
+    }
+
+    void SafetyMonitor::setSeparation(float distance)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        separation_ = std::max(0.0f, distance);
+    }
+
+    float SafetyMonitor::getSeparation() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return separation_;
+    }
+
+    bool SafetyMonitor::popEvent(Event& event)
+    {
+        return events_.pop(event);
+    }
+
+    uint64_t SafetyMonitor::getDroppedEventCount() const
+    {
+        return dropped_events_.load(std::memory_order_relaxed);
+    }
+
+    void SafetyMonitor::resetImplementation()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::fill(fence_states_.begin(), fence_states_.end(), kNone);
+        std::fill(separation_states_.begin(), separation_states_.end(), kNone);
+    }
+
+    void SafetyMonitor::update(float delta)
+    {
+        UpdatableObject::update(delta);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        const int vehicle_count = static_cast<int>(vehicle_kinematics_.size());
+        for (int vehicle = 0; vehicle < vehicle_count; ++vehicle) {
+            const Vector3r& position = vehicle_kinematics_[vehicle]->pose.position;
+            xs_[vehicle] = position.x();
+            ys_[vehicle] = position.y();
+            zs_[vehicle] = position.z();
+        }
+
+        for (int vehicle = 0; vehicle < vehicle_count; ++vehicle) {
+            const Vector3r position(xs_[vehicle], ys_[vehicle], zs_[vehicle]);
+            const int previous = fence_states_[vehicle];
+            const int current = checkFences(vehicle, position);
+            if (current == previous)
+                continue;
+
+            fence_states_[vehicle] = current;
+            if (previous != kNone)
+                pushEvent(EventType::GeoFence, false, vehicle, previous, fenceDistance(previous, position));
+            if (current != kNone)
+                pushEvent(EventType::GeoFence, true, vehicle, current, fenceDistance(current, position));
+        }
+
+        const float separation2 = separation_ * separation_;
+        if (separation_ > 0)
+            checkSeparation();
+        else
+            std::fill(closest_neighbors_.begin(), closest_neighbors_.end(), kNone);
+
+        for (int vehicle = 0; vehicle < vehicle_count; ++vehicle) {
+            const int previous = separation_states_[vehicle];
+            auto distance2 = [this, vehicle](int other) {
+                const float dx = xs_[other] - xs_[vehicle], dy = ys_[other] - ys_[vehicle], dz = zs_[other] - zs_[vehicle];
+                return dx * dx + dy * dy + dz * dz;
+            };
+
+            //stay with the same neighbor while it is too close, the closest one may alternate
+            int current = closest_neighbors_[vehicle];
+            if (previous != kNone && distance2(previous) < separation2)
+                current = previous;
+            if (current == previous)
+                continue;
+
+            separation_states_[vehicle] = current;
+            if (previous != kNone)
+                pushEvent(EventType::Separation, false, vehicle, previous, std::sqrt(distance2(previous)));
+            if (current != kNone)
+                pushEvent(EventType::Separation, true, vehicle, current, std::sqrt(distance2(current)));
+        }
+    }
+
+    void SafetyMonitor::reportState(StateReporter& reporter)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reporter.writeValue("Safety fences", static_cast<int>(fence_index_->fences.size()));
+        reporter.writeValue("Safety separation", separation_);
+        const auto violating = [](const vector<int>& states) {
+            return static_cast<int>(states.size() - std::count(states.begin(), states.end(), kNone));
+        };
+        reporter.writeValue("Fence violations", violating(fence_states_));
+        reporter.writeValue("Separation violations", violating(separation_states_));
+        reporter.writeValue("Dropped safety events", getDroppedEventCount());
+    }
+
+    void SafetyMonitor::FenceIndex::build()
+    {
+        has_keep_in = std::any_of(fences.begin(), fences.end(), [](const Fence& fence) { return !fence.keep_out; });
+
+        nodes.clear();
+        fence_indices.resize(fences.size());
+        for (size_t i = 0; i < fences.size(); ++i)
+            fence_indices[i] = static_cast<uint32_t>(i);
+
+        if (!fences.empty()) {
+            nodes.reserve(fences.size() * 2);
+            nodes.emplace_back();
+            buildNode(0, 0, static_cast<uint32_t>(fences.size()));
+        }
+    }
+
+    void SafetyMonitor::FenceIndex::buildNode(uint32_t node_index, uint32_t first, uint32_t count)
+    {
+        Vector3r box_min = Vector3r::Constant(std::numeric_limits<float>::max());
+        Vector3r box_max = Vector3r::Constant(-std::numeric_limits<float>::max());
+        Vector3r center_min = box_min, center_max = box_max;
+        for (uint32_t i = first; i < first + count; ++i) {
+            const PolygonGeoFence& fence = *fences[fence_indices[i]].fence;
+            box_min = box_min.cwiseMin(fence.getBoxMin());
+            box_max = box_max.cwiseMax(fence.getBoxMax());
+            const Vector3r center = (fence.getBoxMin() + fence.getBoxMax()) / 2;
+            center_min = center_min.cwiseMin(center);
+            center_max = center_max.cwiseMax(center);
+        }
+        nodes[node_index].box_min = box_min;
+        nodes[node_index].box_max = box_max;
+
+        //split on the median center along the widest axis
+        Vector3r extent = center_max - center_min;
+        int axis = 0;
+        if (extent[1] > extent[axis])
+            axis = 1;
+        if (extent[2] > extent[axis])
+            axis = 2;
+
+        if (count <= kMaxLeafSize || extent[axis] <= 0) {
+            nodes[node_index].first = first;
+            nodes[node_index].count = count;
+            return;
+        }
+
+        const uint32_t half = count / 2;
+        std::nth_element(fence_indices.begin() + first, fence_indices.begin() + first + half, fence_indices.begin() + first + count,
+                         [this, axis](uint32_t a, uint32_t b) {
+                             return fences[a].fence->getBoxMin()[axis] + fences[a].fence->getBoxMax()[axis] <
+                                    fences[b].fence->getBoxMin()[axis] + fences[b].fence->getBoxMax()[axis];
+                         });
+
+        const uint32_t left_index = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+        nodes.emplace_back();
+        nodes[node_index].first = left_index;
+        nodes[node_index].count = 0;
+
+        buildNode(left_index, first, half);
+        buildNode(left_index + 1, first + half, count - half);
+    }
+
+    int SafetyMonitor::FenceIndex::find(int fence_id) const
+    {
+        const auto found = std::lower_bound(fences.begin(), fences.end(), fence_id,
+                                            [](const Fence& fence, int id) { return fence.id < id; });
+        return found != fences.end() && found->id == fence_id ? static_cast<int>(found - fences.begin()) : kNone;
+    }
+
+    int SafetyMonitor::checkFences(int vehicle, const Vector3r& position) const
+    {
+        const FenceIndex& index = *fence_index_;
+
+        //a vehicle keeps reporting the fence it is already violating as long as that still holds
+        const int previous = index.find(fence_states_[vehicle]);
+        if (previous != kNone && index.fences[previous].keep_out && index.fences[previous].fence->contains(position))
+            return index.fences[previous].id;
+
+        bool inside_keep_in = false;
+        if (!index.nodes.empty()) {
+            uint32_t stack[kMaxStackDepth];
+            int stack_size = 0;
+            stack[stack_size++] = 0;
+            while (stack_size > 0) {
+                const Node& node = index.nodes[stack[--stack_size]];
+                if (!(position.x() >= node.box_min.x() && position.x() <= node.box_max.x() &&
+                      position.y() >= node.box_min.y() && position.y() <= node.box_max.y() &&
+                      position.z() >= node.box_min.z() && position.z() <= node.box_max.z()))
+                    continue;
+
+                if (node.count > 0) {
+                    for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                        const Fence& fence = index.fences[index.fence_indices[i]];
+                        if (!fence.keep_out && inside_keep_in)
+                            continue;
+                        if (!fence.fence->contains(position))
+                            continue;
+                        if (fence.keep_out)
+                            return fence.id;
+                        inside_keep_in = true;
+                    }
+                }
+                else if (stack_size + 2 <= kMaxStackDepth) {
+                    stack[stack_size++] = node.first;
+                    stack[stack_size++] = node.first + 1;
+                }
+            }
+        }
+
+        if (!index.has_keep_in || inside_keep_in)
+            return kNone;
+        if (previous != kNone && !index.fences[previous].keep_out)
+            return index.fences[previous].id;
+        return closestKeepInFence(position);
+    }
+
+    int SafetyMonitor::closestKeepInFence(const Vector3r& position) const
+    {
+        int closest = kNone;
+        float closest_distance = std::numeric_limits<float>::max();
+        for (const Fence& fence : fence_index_->fences) {
+            if (fence.keep_out)
+                continue;
+            const float distance = fence.fence->distanceToBoundary(position);
+            if (distance < closest_distance) {
+                closest_distance = distance;
+                closest = fence.id;
+            }
+        }
+        return closest;
+    }
+
+    void SafetyMonitor::checkSeparation()
+    {
+        const int vehicle_count = static_cast<int>(sweep_order_.size());
+
+        //insertion sort on x, vehicles move little per step so the last order is nearly sorted
+        for (int a = 1; a < vehicle_count; ++a) {
+            const int vehicle = sweep_order_[a];
+            const float x = xs_[vehicle];
+            int b = a;
+            for (; b > 0 && xs_[sweep_order_[b - 1]] > x; --b)
+                sweep_order_[b] = sweep_order_[b - 1];
+            sweep_order_[b] = vehicle;
+        }
+
+        const float separation2 = separation_ * separation_;
+        std::fill(closest_neighbors_.begin(), closest_neighbors_.end(), kNone);
+        std::fill(closest_distances2_.begin(), closest_distances2_.end(), separation2);
+        for (int a = 0; a < vehicle_count; ++a) {
+            const int vehicle = sweep_order_[a];
+            for (int b = a + 1; b < vehicle_count; ++b) {
+                const int other = sweep_order_[b];
+                const float dx = xs_[other] - xs_[vehicle];
+                if (dx >= separation_)
+                    break;
+                const float dy = ys_[other] - ys_[vehicle], dz = zs_[other] - zs_[vehicle];
+                const float distance2 = dx * dx + dy * dy + dz * dz;
+                if (distance2 < closest_distances2_[vehicle]) {
+                    closest_distances2_[vehicle] = distance2;
+                    closest_neighbors_[vehicle] = other;
+                }
+                if (distance2 < closest_distances2_[other]) {
+                    closest_distances2_[other] = distance2;
+                    closest_neighbors_[other] = vehicle;
+                }
+            }
+        }
+    }
+
+    float SafetyMonitor::fenceDistance(int fence_id, const Vector3r& position) const
+    {
+        //removed fences report 0
+        const int index = fence_index_->find(fence_id);
+        return index == kNone ? 0 : fence_index_->fences[index].fence->distanceToBoundary(position);
+    }
+
+    void SafetyMonitor::pushEvent(EventType type, bool is_violation, int vehicle, int other, float distance)
+    {
+        const uint64_t step = clock()->getStepCount();
+        const bool pushed = events_.pushWith([&](Event& event) {
+            event.step = step;
+            event.type = type;
+            event.is_violation = is_violation;
+            event.vehicle = vehicle;
+            event.other = other;
+            event.position = Vector3r(xs_[vehicle], ys_[vehicle], zs_[vehicle]);
+            event.distance = distance;
+        });
+        if (!pushed)
+            dropped_events_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+} //namespace
+
+#endif
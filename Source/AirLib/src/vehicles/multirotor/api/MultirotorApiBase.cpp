@@ -20,6 +20,8 @@ namespace airlib
     {
         cancelLastTask();
         SingleTaskCall lock(this); //cancel previous tasks
+
+        setTrackedTask(nullptr);
     }
 
     bool MultirotorApiBase::takeoff(float timeout_sec)
@@ -273,6 +275,12 @@ namespace airlib
     bool MultirotorApiBase::moveOnPath(const vector<Vector3r>& path, float velocity, float timeout_sec, DrivetrainType drivetrain, const YawMode& yaw_mode,
                                        float lookahead, float adaptive_lookahead)
     {
+        //the planned trajectory is tracked directly so there is no carrot to chase, the lookahead arguments only stay
+        //for compatibility. Clients pass -1 and 1 unless they set them, 0 used to be rejected.
+        if (lookahead >= 0 || adaptive_lookahead != 1)
+            Utils::log(Utils::stringf("moveOnPath: lookahead (%f) and adaptive_lookahead (%f) are deprecated and ignored", lookahead, adaptive_lookahead),
+                       Utils::kLogLevelWarn);
+
         SingleTaskCall lock(this);
 
         //validate path size
@@ -281,172 +289,143 @@ namespace airlib
             return true;
         }
 
-        //validate yaw mode
-        if (drivetrain == DrivetrainType::ForwardOnly && yaw_mode.is_rate)
-            throw std::invalid_argument("Yaw cannot be specified as rate if drivetrain is ForwardOnly");
+        auto task = createPathTask(path, velocity, drivetrain, yaw_mode);
+        if (task == nullptr)
+            return true; //already at the end of the path
 
-        //validate and set auto-lookahead value
-        float command_period_dist = velocity * getCommandPeriod();
-        if (lookahead == 0)
-            throw std::invalid_argument("lookahead distance cannot be 0"); //won't allow progress on path
-        else if (lookahead > 0) {
-            if (command_period_dist > lookahead)
-                throw std::invalid_argument(Utils::stringf("lookahead value %f is too small for velocity %f. It must be at least %f", lookahead, velocity, command_period_dist));
-            if (getDistanceAccuracy() > lookahead)
-                throw std::invalid_argument(Utils::stringf("lookahead value %f is smaller than drone's distance accuracy %f.", lookahead, getDistanceAccuracy()));
-        }
-        else {
-            //if auto mode requested for lookahead then calculate based on velocity
-            lookahead = getAutoLookahead(velocity, adaptive_lookahead);
-            Utils::log(Utils::stringf("lookahead = %f, adaptive_lookahead = %f", lookahead, adaptive_lookahead));
-        }
+        Utils::log(Utils::stringf("moveOnPath planned %u segments, duration = %f", task->trajectory->getSegmentCount(), task->trajectory->getDuration()));
+        setTrackedTask(std::move(task));
 
-        //add current position as starting point
-        vector<Vector3r> path3d;
-        vector<PathSegment> path_segs;
-        path3d.push_back(getKinematicsEstimated().pose.position);
-
-        Vector3r point;
-        float path_length = 0;
-        //append the input path and compute segments
-        for (uint i = 0; i < path.size(); ++i) {
-            point = path.at(i);
-            PathSegment path_seg(path3d.at(i), point, velocity, path_length);
-            path_length += path_seg.seg_length;
-            path_segs.push_back(path_seg);
-            path3d.push_back(point);
-        }
-        //add last segment as zero length segment so we have equal number of segments and points.
-        //path_segs[i] refers to segment that starts at point i
-        path_segs.push_back(PathSegment(point, point, velocity, path_length));
-
-        //when path ends, we want to slow down
-        float breaking_dist = 0;
-        if (velocity > getMultirotorApiParams().breaking_vel) {
-            breaking_dist = Utils::clip(velocity * getMultirotorApiParams().vel_to_breaking_dist,
-                                        getMultirotorApiParams().min_breaking_dist,
-                                        getMultirotorApiParams().max_breaking_dist);
-        }
-        //else no need to change velocities for last segments
+        //update() flies the trajectory, we only wait for it to finish or fail
+        auto waiter = waitForFunction([&]() {
+            return isTrackedTaskDone();
+        },
+                                      timeout_sec);
 
-        //setup current position on path to 0 offset
-        PathPosition cur_path_loc, next_path_loc;
-        cur_path_loc.seg_index = 0;
-        cur_path_loc.offset = 0;
-        cur_path_loc.position = path3d[0];
+        task = takeTrackedTask();
+        if (task != nullptr && task->error != nullptr)
+            std::rethrow_exception(task->error);
 
-        float lookahead_error_increasing = 0;
-        float lookahead_error = 0;
-        Waiter waiter(getCommandPeriod(), timeout_sec, getCancelToken());
+        return waiter.isComplete() && task != nullptr && task->is_complete;
+    }
 
-        //initialize next path position
-        setNextPathPosition(path3d, path_segs, cur_path_loc, lookahead + lookahead_error, next_path_loc);
-        float overshoot = 0;
-        float goal_dist = 0;
+    vector<bool> MultirotorApiBase::moveSwarm(const vector<MultirotorApiBase*>& apis, const vector<SwarmCommand>& commands, SwarmWaitMode wait_mode)
+    {
+        const size_t count = apis.size();
+        if (commands.size() != 1 && commands.size() != count)
+            throw std::invalid_argument(Utils::stringf("moveSwarm needs one command for all vehicles or one per vehicle, got %d commands for %d vehicles",
+                                                       static_cast<int>(commands.size()), static_cast<int>(count)));
+        for (size_t i = 0; i < count; ++i) {
+            if (apis[i] == nullptr)
+                throw std::invalid_argument("moveSwarm vehicle cannot be null");
+            if (std::find(apis.begin(), apis.begin() + i, apis[i]) != apis.begin() + i)
+                throw std::invalid_argument("moveSwarm cannot command the same vehicle twice");
+        }
 
-        //until we are at the end of the path (last seg is always zero size)
-        while (!waiter.isTimeout() && (next_path_loc.seg_index < path_segs.size() - 1 || goal_dist > 0)) { //current position is approximately at the last end point
+        //each vehicle is taken over as if it received its own command, which cancels whatever it was doing.
+        //Vehicles are locked in address order so that swarms sharing vehicles cannot each hold what the other waits for,
+        //calls stays in the caller's order for the results.
+        vector<size_t> lock_order(count);
+        for (size_t i = 0; i < count; ++i)
+            lock_order[i] = i;
+        std::sort(lock_order.begin(), lock_order.end(), [&apis](size_t a, size_t b) {
+            return std::less<const MultirotorApiBase*>()(apis[a], apis[b]);
+        });
+        vector<std::unique_ptr<SingleTaskCall>> calls(count);
+        for (size_t i : lock_order)
+            calls[i].reset(new SingleTaskCall(apis[i]));
+
+        vector<std::unique_ptr<TrackedTask>> tasks(count);
+        TTimeDelta max_task_sec = 0;
+        float command_period = Utils::max<float>();
+        for (size_t i = 0; i < count; ++i) {
+            MultirotorApiBase* api = apis[i];
+            const SwarmCommand& command = commands.size() == 1 ? commands[0] : commands[i];
+
+            if (command.type == SwarmCommand::Type::Path) {
+                tasks[i] = api->createPathTask(command.path, command.max_velocity, command.drivetrain, command.yaw_mode);
+                if (tasks[i] != nullptr)
+                    tasks[i]->timeout_sec = command.timeout_sec;
+                max_task_sec = std::max<TTimeDelta>(max_task_sec, command.timeout_sec);
+            }
+            else {
+                if (command.velocity.hasNaN())
+                    throw std::invalid_argument(VectorMath::toString(command.velocity, "velocity cannot have NaN: "));
+                tasks[i].reset(new TrackedTask());
+                tasks[i]->velocity = command.velocity;
+                tasks[i]->duration = tasks[i]->timeout_sec = command.duration;
+                tasks[i]->drivetrain = command.drivetrain;
+                tasks[i]->yaw_mode = command.yaw_mode;
+                max_task_sec = std::max<TTimeDelta>(max_task_sec, command.duration);
+            }
+            command_period = std::min(command_period, api->getCommandPeriod());
+        }
 
-            float seg_velocity = path_segs.at(next_path_loc.seg_index).seg_velocity;
-            float path_length_remaining = path_length - path_segs.at(cur_path_loc.seg_index).seg_path_length - cur_path_loc.offset;
-            if (seg_velocity > getMultirotorApiParams().min_vel_for_breaking && path_length_remaining <= breaking_dist) {
-                seg_velocity = getMultirotorApiParams().breaking_vel;
-                //Utils::logMessage("path_length_remaining = %f, Switched to breaking vel %f", path_length_remaining, seg_velocity);
+        //every task is in place before the swarm is released. The start step is not read from the clock here, a step
+        //could begin between reading and storing it and update some vehicles without it. The physics thread decides it
+        //instead, see updateTrackedTask.
+        auto start_step = std::make_shared<std::atomic<uint64_t>>(0);
+        for (size_t i = 0; i < count; ++i) {
+            if (tasks[i] != nullptr) {
+                tasks[i]->start_step = start_step;
+                apis[i]->setTrackedTask(std::move(tasks[i]));
             }
+        }
+        start_step->store(kSwarmStartReleased);
 
-            //send drone command to get to next lookahead
-            moveToPathPosition(next_path_loc.position, seg_velocity, drivetrain, yaw_mode, path_segs.at(cur_path_loc.seg_index).start_z);
-
-            //sleep for rest of the cycle
-            if (!waiter.sleep())
-                return false;
-
-            /*  Below, P is previous position on path, N is next goal and C is our current position.
-
-        N
-        ^
-        |
-        |
-        |
-        C'|---C
-        |  /
-        | /
-        |/
-        P
-
-        Note that PC could be at any angle relative to PN, including 0 or -ve. We increase lookahead distance
-        by the amount of |PC|. For this, we project PC on to PN to get vector PC' and length of
-        CC'is our adaptive lookahead error by which we will increase lookahead distance. 
-
-        For next iteration, we first update our current position by goal_dist and then
-        set next goal by the amount lookahead + lookahead_error.
-
-        We need to take care of following cases:
-
-        1. |PN| == 0 => lookahead_error = |PC|, goal_dist = 0
-        2. |PC| == 0 => lookahead_error = 0, goal_dist = 0
-        3. PC in opposite direction => lookahead_error = |PC|, goal_dist = 0
-
-        One good test case is if C just keeps moving perpendicular to the path (instead of along the path).
-        In that case, we expect next goal to come up and down by the amount of lookahead_error. However
-        under no circumstances we should go back on the path (i.e. current pos on path can only move forward).
-        */
-
-            //how much have we moved towards last goal?
-            const Vector3r& goal_vect = next_path_loc.position - cur_path_loc.position;
-
-            if (!goal_vect.isZero()) { //goal can only be zero if we are at the end of path
-                const Vector3r& actual_vect = getPosition() - cur_path_loc.position;
-
-                //project actual vector on goal vector
-                const Vector3r& goal_normalized = goal_vect.normalized();
-                goal_dist = actual_vect.dot(goal_normalized); //dist could be -ve if drone moves away from goal
-
-                //if adaptive lookahead is enabled the calculate lookahead error (see above fig)
-                if (adaptive_lookahead) {
-                    const Vector3r& actual_on_goal = goal_normalized * goal_dist;
-                    float error = (actual_vect - actual_on_goal).norm() * adaptive_lookahead;
-                    if (error > lookahead_error) {
-                        lookahead_error_increasing++;
-                        //TODO: below should be lower than 1E3 and configurable
-                        //but lower values like 100 doesn't work for simple_flight + ScalableClock
-                        if (lookahead_error_increasing > 1E5) {
-                            throw std::runtime_error("lookahead error is continually increasing so we do not have safe control, aborting moveOnPath operation");
-                        }
-                    }
-                    else {
-                        lookahead_error_increasing = 0;
-                    }
-                    lookahead_error = error;
+        //tasks time out by themselves from the start step, the wait only adds slack for reaching that step
+        CancelToken wait_token;
+        Waiter waiter(command_period, max_task_sec + kSwarmStartSlackPeriods * command_period, wait_token);
+        do {
+            size_t done_count = 0, complete_count = 0;
+            for (size_t i = 0; i < count; ++i) {
+                if (calls[i] == nullptr) {
+                    ++done_count;
+                    continue;
                 }
+                //another command for this vehicle cancels only its share of the swarm command
+                if (apis[i]->getCancelToken().isCancelled()) {
+                    apis[i]->takeTrackedTask();
+                    calls[i].reset();
+                    ++done_count;
+                    continue;
+                }
+
+                std::lock_guard<std::mutex> task_lock(apis[i]->tracked_task_mutex_);
+                const auto& task = apis[i]->tracked_task_;
+                if (task == nullptr || task->isDone())
+                    ++done_count;
+                if (task == nullptr || task->is_complete)
+                    ++complete_count;
             }
-            else {
-                lookahead_error_increasing = 0;
-                goal_dist = 0;
-                lookahead_error = 0; //this is not really required because we will exit
+
+            if (done_count == count || (wait_mode == SwarmWaitMode::WaitAny && complete_count > 0)) {
                 waiter.complete();
+                break;
             }
+        } while (waiter.sleep());
 
-            // Utils::logMessage("PF: cur=%s, goal_dist=%f, cur_path_loc=%s, next_path_loc=%s, lookahead_error=%f",
-            //     VectorMath::toString(getPosition()).c_str(), goal_dist, VectorMath::toString(cur_path_loc.position).c_str(),
-            //     VectorMath::toString(next_path_loc.position).c_str(), lookahead_error);
-
-            //if drone moved backward, we don't want goal to move backward as well
-            //so only climb forward on the path, never back. Also note >= which means
-            //we climb path even if distance was 0 to take care of duplicated points on path
-            if (goal_dist >= 0) {
-                overshoot = setNextPathPosition(path3d, path_segs, cur_path_loc, goal_dist, cur_path_loc);
-                if (overshoot)
-                    Utils::log(Utils::stringf("overshoot=%f", overshoot));
-            }
-            //else
-            //    Utils::logMessage("goal_dist was negative: %f", goal_dist);
+        //vehicles that did not finish stop tracking when the call returns, just as a single command would
+        vector<bool> results(count, false);
+        for (size_t i = 0; i < count; ++i) {
+            if (calls[i] == nullptr)
+                continue;
 
-            //compute next target on path
-            overshoot = setNextPathPosition(path3d, path_segs, cur_path_loc, lookahead + lookahead_error, next_path_loc);
+            auto task = apis[i]->takeTrackedTask();
+            if (task == nullptr)
+                results[i] = true; //nothing to fly
+            else if (task->error != nullptr) {
+                try {
+                    std::rethrow_exception(task->error);
+                }
+                catch (const std::exception& ex) {
+                    Utils::log(Utils::stringf("moveSwarm vehicle %d failed: %s", static_cast<int>(i), ex.what()), Utils::kLogLevelWarn);
+                }
+            }
+            else
+                results[i] = task->is_complete;
         }
-
-        return waiter.isComplete();
+        return results;
     }
 
     bool MultirotorApiBase::moveToGPS(float latitude, float longitude, float altitude, float velocity, float timeout_sec, DrivetrainType drivetrain,
@@ -745,47 +724,6 @@ namespace airlib
         return rc_data_trims_;
     }
 
-    void MultirotorApiBase::moveToPathPosition(const Vector3r& dest, float velocity, DrivetrainType drivetrain, /* pass by value */ YawMode yaw_mode, float last_z)
-    {
-        unused(last_z);
-        //validate dest
-        if (dest.hasNaN())
-            throw std::invalid_argument(VectorMath::toString(dest, "dest vector cannot have NaN: "));
-
-        //what is the distance we will travel at this velocity?
-        float expected_dist = velocity * getCommandPeriod();
-
-        //get velocity vector
-        const Vector3r cur = getPosition();
-        const Vector3r cur_dest = dest - cur;
-        float cur_dest_norm = cur_dest.norm();
-
-        //yaw for the direction of travel
-        adjustYaw(cur_dest, drivetrain, yaw_mode);
-
-        //find velocity vector
-        Vector3r velocity_vect;
-        if (cur_dest_norm < getDistanceAccuracy()) //our dest is approximately same as current
-            velocity_vect = Vector3r::Zero();
-        else if (cur_dest_norm >= expected_dist) {
-            velocity_vect = (cur_dest / cur_dest_norm) * velocity;
-            //Utils::logMessage("velocity_vect=%s", VectorMath::toString(velocity_vect).c_str());
-        }
-        else { //cur dest is too close than the distance we would travel
-            //generate velocity vector that is same size as cur_dest_norm / command period
-            //this velocity vect when executed for command period would yield cur_dest_norm
-            Utils::log(Utils::stringf("Too close dest: cur_dest_norm=%f, expected_dist=%f", cur_dest_norm, expected_dist));
-            velocity_vect = (cur_dest / cur_dest_norm) * (cur_dest_norm / getCommandPeriod());
-        }
-
-        //send commands
-        //try to maintain altitude if path was in XY plan only, velocity based control is not as good
-        if (std::abs(cur.z() - dest.z()) <= getDistanceAccuracy()) //for paths in XY plan current code leaves z untouched, so we can compare with strict equality
-            moveByVelocityInternal(velocity_vect.x(), velocity_vect.y(), 0, yaw_mode);
-        else
-            moveByVelocityInternal(velocity_vect.x(), velocity_vect.y(), velocity_vect.z(), yaw_mode);
-    }
-
     bool MultirotorApiBase::setSafety(SafetyEval::SafetyViolationType enable_reasons, float obs_clearance, SafetyEval::ObsAvoidanceStrategy obs_startegy,
                                       float obs_avoidance_vel, const Vector3r& origin, float xy_length, float max_z, float min_z)
     {
@@ -853,38 +791,148 @@ namespace airlib
         return emergencyManeuverIfUnsafe(result);
     }
 
-    float MultirotorApiBase::setNextPathPosition(const vector<Vector3r>& path, const vector<PathSegment>& path_segs,
-                                                 const PathPosition& cur_path_loc, float next_dist, PathPosition& next_path_loc)
+    void MultirotorApiBase::update(float delta)
+    {
+        VehicleApiBase::update(delta);
+
+        updateTrackedTask();
+    }
+
+    std::unique_ptr<MultirotorApiBase::TrackedTask> MultirotorApiBase::createPathTask(const vector<Vector3r>& path, float velocity,
+                                                                                    DrivetrainType drivetrain, const YawMode& yaw_mode)
+    {
+        //validate yaw mode
+        if (drivetrain == DrivetrainType::ForwardOnly && yaw_mode.is_rate)
+            throw std::invalid_argument("Yaw cannot be specified as rate if drivetrain is ForwardOnly");
+
+        //add current position as starting point
+        const auto& kinematics = getKinematicsEstimated();
+        vector<Vector3r> waypoints;
+        waypoints.reserve(path.size() + 1);
+        waypoints.push_back(kinematics.pose.position);
+        waypoints.insert(waypoints.end(), path.begin(), path.end());
+
+        auto trajectory = std::make_shared<MinimumSnapTrajectory>();
+        if (!trajectory->plan(waypoints, kinematics.twist.linear, velocity, getMultirotorApiParams().path_max_acceleration))
+            return nullptr;
+
+        std::unique_ptr<TrackedTask> task(new TrackedTask());
+        task->trajectory = trajectory;
+        task->drivetrain = drivetrain;
+        task->yaw_mode = yaw_mode;
+        return task;
+    }
+
+    void MultirotorApiBase::setTrackedTask(std::unique_ptr<TrackedTask> task)
+    {
+        std::lock_guard<std::mutex> task_lock(tracked_task_mutex_);
+        tracked_task_ = std::move(task);
+    }
+
+    std::unique_ptr<MultirotorApiBase::TrackedTask> MultirotorApiBase::takeTrackedTask()
+    {
+        std::lock_guard<std::mutex> task_lock(tracked_task_mutex_);
+        return std::move(tracked_task_);
+    }
+
+    bool MultirotorApiBase::isTrackedTaskDone() const
+    {
+        std::lock_guard<std::mutex> task_lock(tracked_task_mutex_);
+        return tracked_task_ == nullptr || tracked_task_->isDone();
+    }
+
+    void MultirotorApiBase::updateTrackedTask()
     {
-        //note: cur_path_loc and next_path_loc may both point to same object
-        uint i = cur_path_loc.seg_index;
-        float offset = cur_path_loc.offset;
-        while (i < path.size() - 1) {
-            const PathSegment& seg = path_segs.at(i);
-            if (seg.seg_length > 0 && //protect against duplicate points in path, normalized seg will have NaN
-                seg.seg_length >= next_dist + offset) {
+        std::lock_guard<std::mutex> task_lock(tracked_task_mutex_);
+        TrackedTask* task = tracked_task_.get();
+        if (task == nullptr || task->isDone())
+            return;
+
+        //exceptions belong to the caller that is waiting for the task, not to the physics loop
+        try {
+            const TTimePoint now = clock()->nowNanos();
+            if (!task->is_started) {
+                //swarm tasks start together. The first vehicle updated after the swarm is released picks the next step,
+                //the step count does not change while a step updates its vehicles so every one of them is updated
+                //again in that step and starts there.
+                if (task->start_step != nullptr) {
+                    const uint64_t step = clock()->getStepCount();
+                    uint64_t start_step = task->start_step->load();
+                    if (start_step == kSwarmStartReleased && task->start_step->compare_exchange_strong(start_step, step + 1))
+                        start_step = step + 1;
+                    if (start_step == 0 || step < start_step)
+                        return;
+                }
+                task->is_started = true;
+                task->start_time = now;
+            }
+
+            const TTimeDelta elapsed = clock()->elapsedBetween(now, task->start_time);
+            if (task->trajectory == nullptr && elapsed >= task->duration) {
+                task->is_complete = true;
+                return;
+            }
+            if (elapsed >= task->timeout_sec) {
+                task->is_timeout = true;
+                return;
+            }
+
+            //velocity commands are only needed once per command period
+            if (clock()->elapsedBetween(now, task->last_command_time) < getCommandPeriod())
+                return;
+            task->last_command_time = now;
 
-                next_path_loc.seg_index = i;
-                next_path_loc.offset = next_dist + offset; //how much total distance we will travel on this segment
-                next_path_loc.position = path.at(i) + seg.seg_normalized * next_path_loc.offset;
-                return 0;
+            YawMode yaw_mode = task->yaw_mode;
+            if (task->trajectory == nullptr) {
+                adjustYaw(task->velocity.x(), task->velocity.y(), task->drivetrain, yaw_mode);
+                moveByVelocityInternal(task->velocity.x(), task->velocity.y(), task->velocity.z(), yaw_mode);
+                return;
             }
-            //otherwise use up this segment, move on to next one
-            next_dist -= seg.seg_length - offset;
-            offset = 0;
 
-            if (&cur_path_loc == &next_path_loc)
-                Utils::log(Utils::stringf("segment %d done: x=%f, y=%f, z=%f", i, path.at(i).x(), path.at(i).y(), path.at(i).z()));
+            const MinimumSnapTrajectory& trajectory = *task->trajectory;
+            const auto& sample = trajectory.sample(elapsed);
+            const Vector3r position = getPosition();
 
-            ++i;
+            if (elapsed >= trajectory.getDuration() && (sample.position - position).norm() <= getMultirotorApiParams().path_end_margin) {
+                task->is_complete = true;
+                moveByVelocityInternal(0, 0, 0, YawMode::Zero());
+                return;
+            }
+
+            //feed forward the planned velocity ahead by the lag of the velocity controller and pull back on to the trajectory
+            const Vector3r planned_velocity = trajectory.sample(elapsed + getMultirotorApiParams().path_velocity_lead).velocity;
+            const Vector3r velocity = planned_velocity + (sample.position - position) * getMultirotorApiParams().path_position_gain;
+
+            //yaw for the direction of travel on the trajectory, not of the correction
+            adjustYaw(sample.velocity * getCommandPeriod(), task->drivetrain, yaw_mode);
+
+            moveByVelocityInternal(velocity.x(), velocity.y(), velocity.z(), yaw_mode);
+        }
+        catch (...) {
+            task->error = std::current_exception();
         }
+    }
+
+    PathProgress MultirotorApiBase::getPathProgress() const
+    {
+        PathProgress progress;
+
+        std::lock_guard<std::mutex> task_lock(tracked_task_mutex_);
+        const TrackedTask* task = tracked_task_.get();
+        if (task == nullptr || task->trajectory == nullptr)
+            return progress;
+
+        const MinimumSnapTrajectory& trajectory = *task->trajectory;
+        const TTimeDelta elapsed = task->is_started ? clock()->elapsedSince(task->start_time) : 0;
+        const auto& sample = trajectory.sample(elapsed);
 
-        //if we are here then we ran out of segments
-        //consider last segment as zero length segment
-        next_path_loc.seg_index = i;
-        next_path_loc.offset = 0;
-        next_path_loc.position = path.at(i);
-        return next_dist;
+        progress.is_active = !task->isDone();
+        //waypoint 0 of the trajectory is the start position which is not part of the caller's path
+        progress.waypoint_index = sample.waypoint_index > 0 ? sample.waypoint_index - 1 : 0;
+        progress.progress = sample.progress;
+        progress.elapsed_sec = static_cast<float>(elapsed);
+        progress.remaining_sec = static_cast<float>(std::max<TTimeDelta>(0, trajectory.getDuration() - elapsed));
+        return progress;
     }
 
     void MultirotorApiBase::adjustYaw(const Vector3r& heading, DrivetrainType drivetrain, YawMode& yaw_mode)
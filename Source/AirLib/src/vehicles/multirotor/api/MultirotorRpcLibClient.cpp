@@ -238,6 +238,36 @@ __pragma(warning(disable : 4239))
         {
             return static_cast<rpc::client*>(getClient())->call("getMultirotorState", vehicle_name).as<MultirotorRpcLibAdaptors::MultirotorState>().to();
         }
+        vector<bool> MultirotorRpcLibClient::moveSwarmByVelocity(const vector<std::string>& vehicle_names, const vector<Vector3r>& velocities, float duration,
+                                                                 DrivetrainType drivetrain, const YawMode& yaw_mode, SwarmWaitMode wait_mode)
+        {
+            vector<MultirotorRpcLibAdaptors::Vector3r> conv_velocities;
+            MultirotorRpcLibAdaptors::from(velocities, conv_velocities);
+            return static_cast<rpc::client*>(getClient())->call("moveSwarmByVelocity", vehicle_names, conv_velocities, duration, drivetrain, MultirotorRpcLibAdaptors::YawMode(yaw_mode), wait_mode).as<vector<bool>>();
+        }
+
+        vector<bool> MultirotorRpcLibClient::moveSwarmToPosition(const vector<std::string>& vehicle_names, const vector<Vector3r>& positions, float velocity, float timeout_sec,
+                                                                 DrivetrainType drivetrain, const YawMode& yaw_mode, SwarmWaitMode wait_mode)
+        {
+            vector<MultirotorRpcLibAdaptors::Vector3r> conv_positions;
+            MultirotorRpcLibAdaptors::from(positions, conv_positions);
+            return static_cast<rpc::client*>(getClient())->call("moveSwarmToPosition", vehicle_names, conv_positions, velocity, timeout_sec, drivetrain, MultirotorRpcLibAdaptors::YawMode(yaw_mode), wait_mode).as<vector<bool>>();
+        }
+
+        vector<bool> MultirotorRpcLibClient::moveSwarmOnPath(const vector<std::string>& vehicle_names, const vector<vector<Vector3r>>& paths, float velocity, float timeout_sec,
+                                                             DrivetrainType drivetrain, const YawMode& yaw_mode, SwarmWaitMode wait_mode)
+        {
+            vector<vector<MultirotorRpcLibAdaptors::Vector3r>> conv_paths(paths.size());
+            for (size_t i = 0; i < paths.size(); ++i)
+                MultirotorRpcLibAdaptors::from(paths[i], conv_paths[i]);
+            return static_cast<rpc::client*>(getClient())->call("moveSwarmOnPath", vehicle_names, conv_paths, velocity, timeout_sec, drivetrain, MultirotorRpcLibAdaptors::YawMode(yaw_mode), wait_mode).as<vector<bool>>();
+        }
+
+        // moveOnPath progress getter
+        PathProgress MultirotorRpcLibClient::getPathProgress(const std::string& vehicle_name)
+        {
+            return static_cast<rpc::client*>(getClient())->call("getPathProgress", vehicle_name).as<MultirotorRpcLibAdaptors::PathProgress>().to();
+        }
 
         void MultirotorRpcLibClient::moveByRC(const RCData& rc_data, const std::string& vehicle_name)
         {
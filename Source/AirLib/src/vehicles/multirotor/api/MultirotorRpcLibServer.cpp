@@ -89,6 +89,27 @@ namespace airlib
             MultirotorRpcLibAdaptors::to(path, conv_path);
             return getVehicleApi(vehicle_name)->moveOnPath(conv_path, velocity, timeout_sec, drivetrain, yaw_mode.to(), lookahead, adaptive_lookahead);
         });
+        (static_cast<rpc::server*>(getServer()))->bind("moveSwarmByVelocity", [&](const vector<std::string>& vehicle_names, const vector<MultirotorRpcLibAdaptors::Vector3r>& velocities, float duration, DrivetrainType drivetrain, const MultirotorRpcLibAdaptors::YawMode& yaw_mode, SwarmWaitMode wait_mode) -> vector<bool> {
+            vector<SwarmCommand> commands;
+            for (const auto& velocity : velocities)
+                commands.push_back(SwarmCommand::byVelocity(velocity.to(), duration, drivetrain, yaw_mode.to()));
+            return MultirotorApiBase::moveSwarm(getVehicleApis(vehicle_names), commands, wait_mode);
+        });
+        (static_cast<rpc::server*>(getServer()))->bind("moveSwarmToPosition", [&](const vector<std::string>& vehicle_names, const vector<MultirotorRpcLibAdaptors::Vector3r>& positions, float velocity, float timeout_sec, DrivetrainType drivetrain, const MultirotorRpcLibAdaptors::YawMode& yaw_mode, SwarmWaitMode wait_mode) -> vector<bool> {
+            vector<SwarmCommand> commands;
+            for (const auto& position : positions)
+                commands.push_back(SwarmCommand::onPath(vector<Vector3r>{ position.to() }, velocity, timeout_sec, drivetrain, yaw_mode.to()));
+            return MultirotorApiBase::moveSwarm(getVehicleApis(vehicle_names), commands, wait_mode);
+        });
+        (static_cast<rpc::server*>(getServer()))->bind("moveSwarmOnPath", [&](const vector<std::string>& vehicle_names, const vector<vector<MultirotorRpcLibAdaptors::Vector3r>>& paths, float velocity, float timeout_sec, DrivetrainType drivetrain, const MultirotorRpcLibAdaptors::YawMode& yaw_mode, SwarmWaitMode wait_mode) -> vector<bool> {
+            vector<SwarmCommand> commands;
+            for (const auto& path : paths) {
+                vector<Vector3r> conv_path;
+                MultirotorRpcLibAdaptors::to(path, conv_path);
+                commands.push_back(SwarmCommand::onPath(conv_path, velocity, timeout_sec, drivetrain, yaw_mode.to()));
+            }
+            return MultirotorApiBase::moveSwarm(getVehicleApis(vehicle_names), commands, wait_mode);
+        });
         (static_cast<rpc::server*>(getServer()))->bind("moveToGPS", [&](float latitude, float longitude, float altitude, float velocity, float timeout_sec, DrivetrainType drivetrain, const MultirotorRpcLibAdaptors::YawMode& yaw_mode, float lookahead, float adaptive_lookahead, const std::string& vehicle_name) -> bool {
             return getVehicleApi(vehicle_name)->moveToGPS(latitude, longitude, altitude, velocity, timeout_sec, drivetrain, yaw_mode.to(), lookahead, adaptive_lookahead);
         });
@@ -140,6 +161,10 @@ namespace airlib
         (static_cast<rpc::server*>(getServer()))->bind("getMultirotorState", [&](const std::string& vehicle_name) -> MultirotorRpcLibAdaptors::MultirotorState {
             return MultirotorRpcLibAdaptors::MultirotorState(getVehicleApi(vehicle_name)->getMultirotorState());
         });
+        // moveOnPath progress
+        (static_cast<rpc::server*>(getServer()))->bind("getPathProgress", [&](const std::string& vehicle_name) -> MultirotorRpcLibAdaptors::PathProgress {
+            return MultirotorRpcLibAdaptors::PathProgress(getVehicleApi(vehicle_name)->getPathProgress());
+        });
     }
 
     //required for pimpl
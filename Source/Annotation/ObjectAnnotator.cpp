@@ -8,6 +8,8 @@
 #include "Runtime/Launch/Resources/Version.h"
 #include "AnnotationComponent.h"
 #include "AirBlueprintLib.h"
+#include <algorithm>
+#include <cctype>
 
 // For UE4 < 17
 // check https://github.com/unrealcv/unrealcv/blob/1369a72be8428547318d8a52ae2d63e1eb57a001/Source/UnrealCV/Private/Controller/ObjectAnnotator.cpp#L1
@@ -508,7 +510,7 @@ bool FObjectAnnotator::AnnotateNewActorInstanceSegmentation(AActor* actor) {
 					});
 				if (found_tag == nullptr) {
 					uint32 ObjectIndex = name_to_component_map_.Num();
-					name_to_component_map_.Emplace(it.Key(), it.Value());
+					AddComponentName(it.Key(), it.Value());
 					component_to_name_map_.Emplace(it.Value(), it.Key());
 					FColor new_color = ColorGenerator_.GetColorFromColorMap(ObjectIndex);
 					name_to_color_index_map_.Emplace(it.Key(), ObjectIndex);
@@ -586,7 +588,7 @@ bool FObjectAnnotator::AnnotateNewActorRGB(AActor* actor) {
 					}
 				}
 				else {
-					name_to_component_map_.Emplace(it.Key(), it.Value());
+					AddComponentName(it.Key(), it.Value());
 					component_to_name_map_.Emplace(it.Value(), it.Key());
 					name_to_color_index_map_.Emplace(it.Key(), color_index);
 					color_to_name_map_.Emplace(color_string, it.Key());
@@ -602,7 +604,7 @@ bool FObjectAnnotator::AnnotateNewActorRGB(AActor* actor) {
 					}
 				}
 			}else if (show_by_default_ && !it.Key().Contains("hidden_sphere") && !it.Key().Contains("AnnotationSphere")) {
-				name_to_component_map_.Emplace(it.Key(), it.Value());
+				AddComponentName(it.Key(), it.Value());
 				component_to_name_map_.Emplace(it.Value(), it.Key());
 				FColor new_color = FColor(0, 0, 0);
 				name_to_color_index_map_.Emplace(it.Key(), 2744000 - 1);
@@ -670,7 +672,7 @@ bool FObjectAnnotator::AnnotateNewActorGreyscale(AActor* actor) {
 					UE_LOG(LogTemp, Log, TEXT("AirSim Annotation [%s]: Updated greyscale annotated object %s with value %f (RGB: %s)"), *name_, *it.Key(), greyscale_value, *color_string_gammacorrected);
 			}
 				else {
-					name_to_component_map_.Emplace(it.Key(), it.Value());
+					AddComponentName(it.Key(), it.Value());
 					component_to_name_map_.Emplace(it.Value(), it.Key());
 					color_to_name_map_.Emplace(color_string, it.Key());
 					gammacorrected_color_to_name_map_.Emplace(color_string_gammacorrected, it.Key());
@@ -680,7 +682,7 @@ bool FObjectAnnotator::AnnotateNewActorGreyscale(AActor* actor) {
 					UE_LOG(LogTemp, Log, TEXT("AirSim Annotation [%s]: Added new greyscale annotated object %s with value %f (RGB: %s)"), *name_, *it.Key(), greyscale_value, *color_string_gammacorrected);
 				}
 			}else if (show_by_default_ && !it.Key().Contains("hidden_sphere") && !it.Key().Contains("AnnotationSphere")) {
-				name_to_component_map_.Emplace(it.Key(), it.Value());
+				AddComponentName(it.Key(), it.Value());
 				component_to_name_map_.Emplace(it.Value(), it.Key());
 				FColor new_color = FColor(0, 0, 0);
 				FString color_string = FString::FromInt(new_color.R) + "," + FString::FromInt(new_color.G) + "," + FString::FromInt(new_color.B);
@@ -747,7 +749,7 @@ bool FObjectAnnotator::AnnotateNewActorTexture(AActor* actor) {
 					}
 				}
 				else {
-					name_to_component_map_.Emplace(it.Key(), it.Value());
+					AddComponentName(it.Key(), it.Value());
 					component_to_name_map_.Emplace(it.Value(), it.Key());
 					name_to_texture_path_map_.Emplace(it.Key(), new_texture);
 					check(PaintTextureComponent(it.Value(), new_texture, it.Key()));
@@ -760,7 +762,7 @@ bool FObjectAnnotator::AnnotateNewActorTexture(AActor* actor) {
 					}
 				}
 			}else if (show_by_default_ && !it.Key().Contains("hidden_sphere") && !it.Key().Contains("AnnotationSphere")) {
-				name_to_component_map_.Emplace(it.Key(), it.Value());
+				AddComponentName(it.Key(), it.Value());
 				component_to_name_map_.Emplace(it.Value(), it.Key());
 				FString new_texture = "/AirSim/HUDAssets/k";
 				name_to_texture_path_map_.Emplace(it.Key(), new_texture);
@@ -785,7 +787,7 @@ bool FObjectAnnotator::DeleteActor(AActor* actor)
 			if (name_to_component_map_.Contains(it.Key())) {
 				component_to_name_map_.Remove(it.Value());
 				check(DeleteComponent(it.Value()));
-				name_to_component_map_.Remove(it.Key());				
+				RemoveComponentName(it.Key());
 				UE_LOG(LogTemp, Log, TEXT("AirSim Annotation [%s]: Deleted object %s."), *name_, *it.Key());
 
 			}
@@ -878,7 +880,7 @@ void FObjectAnnotator::InitializeInstanceSegmentation(ULevel* InLevel)
 			for (auto it = paintable_components_meshes.CreateConstIterator(); it; ++it)
 			{
 				if(!it.Key().Contains("hidden_sphere") && !it.Key().Contains("AnnotationSphere")) {
-					name_to_component_map_.Emplace(it.Key(), it.Value());
+					AddComponentName(it.Key(), it.Value());
 					component_to_name_map_.Emplace(it.Value(), it.Key());
 					FColor new_color = ColorGenerator_.GetColorFromColorMap(color_index);
 					name_to_color_index_map_.Emplace(it.Key(), color_index);
@@ -919,7 +921,7 @@ void FObjectAnnotator::InitializeRGB(ULevel* InLevel)
 					FString tag = found_tag->ToString();
 					TArray<FString> splitTag;
 					tag.ParseIntoArray(splitTag, TEXT("_"), true);
-					name_to_component_map_.Emplace(it.Key(), it.Value());
+					AddComponentName(it.Key(), it.Value());
 					component_to_name_map_.Emplace(it.Value(), it.Key());
 
 					FColor new_color;
@@ -948,7 +950,7 @@ void FObjectAnnotator::InitializeRGB(ULevel* InLevel)
 					}
 				}
 				else if (show_by_default_ && !it.Key().Contains("hidden_sphere") && !it.Key().Contains("AnnotationSphere")) {
-					name_to_component_map_.Emplace(it.Key(), it.Value());
+					AddComponentName(it.Key(), it.Value());
 					component_to_name_map_.Emplace(it.Value(), it.Key());
 					FColor new_color = FColor(0, 0, 0);
 					name_to_color_index_map_.Emplace(it.Key(), 2744000 - 1);
@@ -989,7 +991,7 @@ void FObjectAnnotator::InitializeGreyscale(ULevel* InLevel)
 					FString tag = found_tag->ToString();
 					TArray<FString> splitTag;
 					tag.ParseIntoArray(splitTag, TEXT("_"), true);
-					name_to_component_map_.Emplace(it.Key(), it.Value());
+					AddComponentName(it.Key(), it.Value());
 					component_to_name_map_.Emplace(it.Value(), it.Key());
 
 					float greyscale_value = FCString::Atof(*splitTag[1]);
@@ -1012,7 +1014,7 @@ void FObjectAnnotator::InitializeGreyscale(ULevel* InLevel)
 					UE_LOG(LogTemp, Log, TEXT("AirSim Annotation [%s]: Added new greyscale annotated object %s with direct greyscale value %f (RGB: %s)"), *name_, *it.Key(), greyscale_value , *color_string_gammacorrected);
 				}
 				else if (show_by_default_ && !it.Key().Contains("hidden_sphere") && !it.Key().Contains("AnnotationSphere")) {
-					name_to_component_map_.Emplace(it.Key(), it.Value());
+					AddComponentName(it.Key(), it.Value());
 					component_to_name_map_.Emplace(it.Value(), it.Key());
 					FColor new_color = FColor(0, 0, 0);
 					FString color_string = FString::FromInt(new_color.R) + "," + FString::FromInt(new_color.G) + "," + FString::FromInt(new_color.B);
@@ -1052,7 +1054,7 @@ void FObjectAnnotator::InitializeTexture(ULevel* InLevel)
 					FString tag = found_tag->ToString();
 					TArray<FString> splitTag;
 					tag.ParseIntoArray(splitTag, TEXT("_"), true);
-					name_to_component_map_.Emplace(it.Key(), it.Value());
+					AddComponentName(it.Key(), it.Value());
 					component_to_name_map_.Emplace(it.Value(), it.Key());
 
 					FString new_texture;
@@ -1084,7 +1086,7 @@ void FObjectAnnotator::InitializeTexture(ULevel* InLevel)
 					}
 				}
 				else if (show_by_default_ && !it.Key().Contains("hidden_sphere") && !it.Key().Contains("AnnotationSphere")) {
-					name_to_component_map_.Emplace(it.Key(), it.Value());
+					AddComponentName(it.Key(), it.Value());
 					component_to_name_map_.Emplace(it.Value(), it.Key());
 					FString new_texture = "/AirSim/HUDAssets/k";
 					name_to_texture_path_map_.Emplace(it.Key(), new_texture);
@@ -1295,11 +1297,156 @@ std::vector<std::string> FObjectAnnotator::GetAllComponentNames() {
 }
 
 
-TMap<FString, UMeshComponent*> FObjectAnnotator::GetNameToComponentMap() {
+// GetComponentNamesMatching reads name_to_component_map_ under the name index lock, so it is only changed while holding it
+void FObjectAnnotator::AddComponentName(const FString& component_name, UMeshComponent* component)
+{
+	std::lock_guard<std::mutex> lock(name_index_->mutex);
+	name_to_component_map_.Emplace(component_name, component);
+	name_index_->dirty = true;
+}
+
+void FObjectAnnotator::RemoveComponentName(const FString& component_name)
+{
+	std::lock_guard<std::mutex> lock(name_index_->mutex);
+	name_to_component_map_.Remove(component_name);
+	name_index_->dirty = true;
+}
+
+namespace
+{
+	using ENamePatternKind = FObjectAnnotator::FNamePattern::EKind;
+
+	// Patterns of the form [.*]literal[.*] where the literal has no regex operators, escaped punctuation is allowed
+	ENamePatternKind ParseNamePattern(const std::string& pattern, std::string& lower_literal)
+	{
+		size_t begin = 0;
+		size_t end = pattern.size();
+		const bool any_prefix = pattern.compare(0, 2, ".*") == 0;
+		if (any_prefix)
+			begin = 2;
+		const bool any_suffix = end >= begin + 2 && pattern.compare(end - 2, 2, ".*") == 0 && (end < 3 || pattern[end - 3] != '\\');
+		if (any_suffix)
+			end -= 2;
+
+		static const std::string operators = ".[]{}()*+?^$|";
+		lower_literal.clear();
+		for (size_t i = begin; i < end; ++i) {
+			char c = pattern[i];
+			if (c == '\\') {
+				//\d, \w and friends are character classes
+				if (i + 1 >= end || std::isalnum(static_cast<unsigned char>(pattern[i + 1])))
+					return ENamePatternKind::Regex;
+				c = pattern[++i];
+			}
+			else if (operators.find(c) != std::string::npos)
+				return ENamePatternKind::Regex;
+			lower_literal.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+		}
+
+		if (any_prefix && any_suffix)
+			return ENamePatternKind::Substring;
+		if (any_prefix)
+			return ENamePatternKind::Suffix;
+		if (any_suffix)
+			return ENamePatternKind::Prefix;
+		return ENamePatternKind::Exact;
+	}
+}
+
+FObjectAnnotator::FNamePattern FObjectAnnotator::CompileNamePattern(const std::string& name_regex)
+{
+	FNamePattern pattern;
+	pattern.kind = ParseNamePattern(name_regex, pattern.lower_literal);
+	if (pattern.kind != ENamePatternKind::Regex)
+		return pattern;
+
+	FNameIndex& index = *name_index_;
+	{
+		std::lock_guard<std::mutex> lock(index.mutex);
+		auto cached = index.regex_cache.find(name_regex);
+		if (cached != index.regex_cache.end()) {
+			pattern.regex = cached->second;
+			return pattern;
+		}
+	}
+
+	//compile without the lock, an invalid pattern throws and is not cached
+	pattern.regex = std::make_shared<const std::regex>(name_regex, std::regex_constants::icase);
+	std::lock_guard<std::mutex> lock(index.mutex);
+	if (index.regex_cache.size() >= 64)
+		index.regex_cache.clear();
+	index.regex_cache.emplace(name_regex, pattern.regex);
+	return pattern;
+}
+
+TArray<FString> FObjectAnnotator::GetComponentNamesMatching(const FNamePattern& pattern)
+{
+	FNameIndex& index = *name_index_;
+	std::lock_guard<std::mutex> lock(index.mutex);
+
+	if (index.dirty) {
+		index.entries.clear();
+		index.entries.reserve(name_to_component_map_.Num());
+		for (const auto& element : name_to_component_map_) {
+			FNameIndex::FEntry entry;
+			entry.utf8_name = TCHAR_TO_UTF8(*element.Key);
+			entry.lower_name = entry.utf8_name;
+			for (char& c : entry.lower_name)
+				c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+			entry.name = element.Key;
+			index.entries.push_back(MoveTemp(entry));
+		}
+		std::sort(index.entries.begin(), index.entries.end(), [](const FNameIndex::FEntry& a, const FNameIndex::FEntry& b) {
+			return a.lower_name < b.lower_name;
+		});
+		index.dirty = false;
+	}
+
+	const std::string& literal = pattern.lower_literal;
+	const auto first_not_below = [&index](const std::string& lower_name) {
+		return std::lower_bound(index.entries.begin(), index.entries.end(), lower_name, [](const FNameIndex::FEntry& entry, const std::string& value) {
+			return entry.lower_name < value;
+		});
+	};
+
+	TArray<FString> names;
+	switch (pattern.kind)
+	{
+	case ENamePatternKind::Exact:
+		for (auto it = first_not_below(literal); it != index.entries.end() && it->lower_name == literal; ++it)
+			names.Add(it->name);
+		break;
+	case ENamePatternKind::Prefix:
+		for (auto it = first_not_below(literal); it != index.entries.end() && it->lower_name.compare(0, literal.size(), literal) == 0; ++it)
+			names.Add(it->name);
+		break;
+	case ENamePatternKind::Suffix:
+		for (const auto& entry : index.entries) {
+			if (entry.lower_name.size() >= literal.size() && entry.lower_name.compare(entry.lower_name.size() - literal.size(), literal.size(), literal) == 0)
+				names.Add(entry.name);
+		}
+		break;
+	case ENamePatternKind::Substring:
+		for (const auto& entry : index.entries) {
+			if (entry.lower_name.find(literal) != std::string::npos)
+				names.Add(entry.name);
+		}
+		break;
+	default:
+		for (const auto& entry : index.entries) {
+			if (std::regex_match(entry.utf8_name, *pattern.regex))
+				names.Add(entry.name);
+		}
+		break;
+	}
+	return names;
+}
+
+const TMap<FString, UMeshComponent*>& FObjectAnnotator::GetNameToComponentMap() {
 	return name_to_component_map_;
 }
 
-TMap<UMeshComponent*, FString> FObjectAnnotator::GetComponentToNameMap() {
+const TMap<UMeshComponent*, FString>& FObjectAnnotator::GetComponentToNameMap() {
 	return component_to_name_map_;
 }
 
@@ -1312,7 +1459,7 @@ TMap<FString, float> FObjectAnnotator::GetComponentToValueMap() {
 	return name_to_value_map_;
 }
 
-TArray<FColor> FObjectAnnotator::GetColorMap(){
+const TArray<FColor>& FObjectAnnotator::GetColorMap(){
 	return ColorGenerator_.GetColorMap();
 }
 
@@ -1339,7 +1486,11 @@ void FObjectAnnotator::EndPlay() {
 	name_to_color_index_map_.Empty();
 	color_to_name_map_.Empty();
 	gammacorrected_color_to_name_map_.Empty();
-	name_to_component_map_.Empty();
+	{
+		std::lock_guard<std::mutex> lock(name_index_->mutex);
+		name_to_component_map_.Empty();
+		name_index_->dirty = true;
+	}
 	annotation_component_list_.Empty();
 	name_to_gammacorrected_color_map_.Empty();
 	name_to_value_map_.Empty();
@@ -1349,24 +1500,24 @@ void FObjectAnnotator::EndPlay() {
 
 int32 FColorGenerator::GetChannelValue(uint32 index)
 {
-	static int32 values[256] = { 0 };
-	static bool init = false;
-	if (!init)
-	{
+	//magic statics are initialized once, even when several threads get here first
+	static const TArray<int32> values = []() {
+		TArray<int32> channel_values;
+		channel_values.Init(0, 256);
 		float step = 256;
 		uint32 iter = 0;
-		values[0] = 0;
 		while (step >= 1)
 		{
 			for (uint32 value = step - 1; value <= 256; value += step * 2)
 			{
 				iter++;
-				values[iter] = value;
+				if (iter < 256)
+					channel_values[iter] = value;
 			}
 			step /= 2;
 		}
-		init = true;
-	}
+		return channel_values;
+	}();
 	if (index >= 0 && index <= 255)
 	{
 		return values[index];
@@ -1378,7 +1529,7 @@ int32 FColorGenerator::GetChannelValue(uint32 index)
 	}
 }
 
-void FColorGenerator::GetColors(int32 max_val, bool enable_1, bool enable_2, bool enable_3, TArray<FColor>& color_map, TArray<int32>& ok_values)
+void FColorGenerator::GetColors(int32 max_val, bool enable_1, bool enable_2, bool enable_3, TArray<FColor>& color_map, const bool* ok_values)
 {
 
 	for (int32 I = 0; I <= (enable_1 ? 0 : max_val - 1); I++)
@@ -1390,7 +1541,7 @@ void FColorGenerator::GetColors(int32 max_val, bool enable_1, bool enable_2, boo
 				uint8 R = GetChannelValue(enable_1 ? max_val : I);
 				uint8 G = GetChannelValue(enable_2 ? max_val : J);
 				uint8 B = GetChannelValue(enable_3 ? max_val : K);
-				if (ok_values.Contains(R) && ok_values.Contains(G) && ok_values.Contains(B) && R != 149 && B != 149 && G != 149) {
+				if (ok_values[R] && ok_values[G] && ok_values[B]) {
 					FColor color(R, G, B, 255);
 					color_map.Add(color);
 				}
@@ -1399,54 +1550,81 @@ void FColorGenerator::GetColors(int32 max_val, bool enable_1, bool enable_2, boo
 	}
 }
 
-TArray<FColor> FColorGenerator::color_map_;
-
-FColor FColorGenerator::GetColorFromColorMap(int32 color_index)
+const FColorGenerator::FColorTable& FColorGenerator::GetColorTable()
 {
-	static TArray<int32> ok_values_;
-	int num_per_channel = 256;
-	int uneven_start = 79;
-	int full_start = 149;
-	int uneven_count = FMath::FloorToInt((full_start - uneven_start + 2) / 2.0f);
-	if (color_map_.Num() == 0) {
-
-		for (int32 i = uneven_start; i <= full_start; i += 2) {
-			ok_values_.Emplace(i);
+	static const FColorTable table = []() {
+		FColorTable color_table;
+		int num_per_channel = 256;
+		int uneven_start = 79;
+		int full_start = 149;
+
+		//uneven values from 79, every value from 150, 149 is not used
+		bool ok_values[256] = { false };
+		for (int32 i = uneven_start; i < full_start; i += 2) {
+			ok_values[i] = true;
 		}
 		for (int32 i = full_start + 1; i < num_per_channel; i++) {
-			ok_values_.Emplace(i);
+			ok_values[i] = true;
 		}
+		for (int32 i = 0; i < num_per_channel; i++) {
+			color_table.ChannelRank[i] = ok_values[i] ? color_table.RankCount++ : INDEX_NONE;
+		}
+
+		const int32 rank_count = color_table.RankCount;
+		color_table.Colors.Reserve(rank_count * rank_count * rank_count);
 		for (int32 max_channel_index = 0; max_channel_index < num_per_channel; max_channel_index++)
 		{
-			GetColors(max_channel_index, false, false, true, color_map_, ok_values_);
-			GetColors(max_channel_index, false, true, false, color_map_, ok_values_);
-			GetColors(max_channel_index, false, true, true, color_map_, ok_values_);
-			GetColors(max_channel_index, true, false, false, color_map_, ok_values_);
-			GetColors(max_channel_index, true, false, true, color_map_, ok_values_);
-			GetColors(max_channel_index, true, true, false, color_map_, ok_values_);
-			GetColors(max_channel_index, true, true, true, color_map_, ok_values_);
+			GetColors(max_channel_index, false, false, true, color_table.Colors, ok_values);
+			GetColors(max_channel_index, false, true, false, color_table.Colors, ok_values);
+			GetColors(max_channel_index, false, true, true, color_table.Colors, ok_values);
+			GetColors(max_channel_index, true, false, false, color_table.Colors, ok_values);
+			GetColors(max_channel_index, true, false, true, color_table.Colors, ok_values);
+			GetColors(max_channel_index, true, true, false, color_table.Colors, ok_values);
+			GetColors(max_channel_index, true, true, true, color_table.Colors, ok_values);
 		}
-	}
-	if (color_index < 0 || color_index >= pow((num_per_channel - full_start) + uneven_count - 3, 3))
+
+		color_table.IndexByRank.Init(INDEX_NONE, rank_count * rank_count * rank_count);
+		for (int32 color_index = 0; color_index < color_table.Colors.Num(); color_index++) {
+			const FColor& color = color_table.Colors[color_index];
+			int32& index = color_table.IndexByRank[(color_table.ChannelRank[color.R] * rank_count + color_table.ChannelRank[color.G]) * rank_count + color_table.ChannelRank[color.B]];
+			if (index == INDEX_NONE)
+				index = color_index;
+		}
+		return color_table;
+	}();
+	return table;
+}
+
+FColor FColorGenerator::GetColorFromColorMap(int32 color_index)
+{
+	const FColorTable& color_table = GetColorTable();
+	const int32 max_index = (color_table.RankCount - 1) * (color_table.RankCount - 1) * (color_table.RankCount - 1);
+	if (color_index < 0 || color_index >= max_index)
 	{
-		UE_LOG(LogTemp, Error, TEXT("AirSim Annotation: Object index %i is out of the available color map boundary [0, %s]"), color_index, *FString::SanitizeFloat(pow((num_per_channel - full_start) + uneven_count - 3, 3)));
+		UE_LOG(LogTemp, Error, TEXT("AirSim Annotation: Object index %i is out of the available color map boundary [0, %i]"), color_index, max_index);
 		return FColor(0, 0, 0);
 	}
 	else {
-		return color_map_[color_index];
+		return color_table.Colors[color_index];
 	}
 }
 
 int FColorGenerator::GetIndexForColor(FColor color) {
-	return color_map_.Find(color);
+	const FColorTable& color_table = GetColorTable();
+	const int32 rank_r = color_table.ChannelRank[color.R];
+	const int32 rank_g = color_table.ChannelRank[color.G];
+	const int32 rank_b = color_table.ChannelRank[color.B];
+	if (color.A != 255 || rank_r == INDEX_NONE || rank_g == INDEX_NONE || rank_b == INDEX_NONE)
+		return INDEX_NONE;
+	return color_table.IndexByRank[(rank_r * color_table.RankCount + rank_g) * color_table.RankCount + rank_b];
 }
 
 int FColorGenerator::GetGammaCorrectedColor(int color_index) {
 	return GammaCorrectionTable_[color_index];
 }
 
- TArray<FColor> FColorGenerator::GetColorMap(){
-	return color_map_;
+const TArray<FColor>& FColorGenerator::GetColorMap(){
+	return GetColorTable().Colors;
 }
 
 int32 FColorGenerator::GammaCorrectionTable_[256] =
@@ -5,6 +5,10 @@
 
 #include <vector>
 #include <string>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <unordered_map>
 #include "Components/MeshComponent.h"
 #include "Components/SceneComponent.h"
 #include "UObject/ObjectMacros.h"
@@ -14,19 +18,30 @@
 #include "UObject/ScriptMacros.h"
 #include "Runtime/Engine/Classes/GameFramework/Actor.h"
 
+// The color map is generated once, on first use, and is shared and read only afterwards so all lookups are thread safe
 class FColorGenerator
 {
 public:
 	FColor GetColorFromColorMap(int32 ObjectIndex);
 	int GetIndexForColor(FColor color);
 	int GetGammaCorrectedColor(int color_index);
-	TArray<FColor> GetColorMap();
+	const TArray<FColor>& GetColorMap();
 
 private:
-	int32 GetChannelValue(uint32 Index);
-	void GetColors(int32 max_val, bool enable_1, bool enable_2, bool enable_3, TArray<FColor>& color_map, TArray<int32>& ok_values);
+	struct FColorTable
+	{
+		TArray<FColor> Colors;
+		// rank of every allowed channel value, INDEX_NONE for values that are never used
+		int32 ChannelRank[256];
+		int32 RankCount = 0;
+		// color index for every combination of channel ranks, so finding a color is a single array access
+		TArray<int32> IndexByRank;
+	};
+
+	static const FColorTable& GetColorTable();
+	static int32 GetChannelValue(uint32 Index);
+	static void GetColors(int32 max_val, bool enable_1, bool enable_2, bool enable_3, TArray<FColor>& color_map, const bool* ok_values);
 	static int GammaCorrectionTable_[256];
-	static TArray<FColor> color_map_;
 };
 
 class AIRSIM_API FObjectAnnotator
@@ -79,7 +94,7 @@ public:
 
 	static void SetViewForAnnotationRender(FEngineShowFlags& show_flags);
 
-	TArray<FColor> GetColorMap();
+	const TArray<FColor>& GetColorMap();
 
 	bool IsDirect();
 	FObjectAnnotator::AnnotatorType GetType();
@@ -87,10 +102,30 @@ public:
 	void EndPlay();
 
 	std::vector<std::string> GetAllComponentNames();
-	TMap<FString, UMeshComponent*> GetNameToComponentMap();
+	// Case insensitive mesh name regex, parsed and if needed compiled once per request
+	struct FNamePattern
+	{
+		enum class EKind
+		{
+			Exact,
+			Prefix,
+			Suffix,
+			Substring,
+			Regex
+		};
+
+		EKind kind = EKind::Exact;
+		std::string lower_literal;
+		std::shared_ptr<const std::regex> regex;
+	};
+	// Throws std::regex_error for an invalid regex, call it where the error can reach the client
+	FNamePattern CompileNamePattern(const std::string& name_regex);
+	// Names of the annotated components that match the pattern
+	TArray<FString> GetComponentNamesMatching(const FNamePattern& pattern);
+	const TMap<FString, UMeshComponent*>& GetNameToComponentMap();
 	TMap<FString, FString> GetColorToComponentNameMap();
 	TMap<FString, float> GetComponentToValueMap();
-	TMap<UMeshComponent*, FString> GetComponentToNameMap();
+	const TMap<UMeshComponent*, FString>& GetComponentToNameMap();
 
 private:
 	FColorGenerator ColorGenerator_;
@@ -111,6 +146,9 @@ private:
 
 	bool DeleteComponent(UMeshComponent* component);
 
+	void AddComponentName(const FString& component_name, UMeshComponent* component);
+	void RemoveComponentName(const FString& component_name);
+
 	void getPaintableComponentMeshes(AActor* actor, TMap<FString, UMeshComponent*>* paintable_components_meshes);
 	void getPaintableComponentMeshesAndTags(AActor* actor, TMap<FString, UMeshComponent*>* paintable_components_meshes, TMap<FString, TArray<FName>>* paintable_components_tags);
 	bool IsPaintable(AActor* actor);
@@ -125,5 +163,46 @@ private:
 	TMap<FString, UMeshComponent*> name_to_component_map_;
 	TMap<UMeshComponent*, FString> component_to_name_map_;
 	TArray<TWeakObjectPtr<UPrimitiveComponent>> annotation_component_list_;
+
+	/*
+	UTF-8 copies of the component names sorted on their lower case form, rebuilt after the names changed, and the
+	compiled regexes of recent patterns. Exact names and prefix, suffix and substring patterns (abc, abc.*, .*abc,
+	.*abc.*) are resolved without a regex.
+	*/
+	struct FNameIndex
+	{
+		struct FEntry
+		{
+			std::string lower_name;
+			std::string utf8_name;
+			FString name;
+		};
+
+		std::mutex mutex;
+		bool dirty = true;
+		std::vector<FEntry> entries;
+		std::unordered_map<std::string, std::shared_ptr<const std::regex>> regex_cache;
+	};
+
+	// Keeps the annotator copyable without sharing the index or its mutex: a copy or assignment gets an empty index of
+	// its own, which is rebuilt on first use
+	class FNameIndexPtr
+	{
+	public:
+		FNameIndexPtr() : index_(MakeUnique<FNameIndex>()) {}
+		FNameIndexPtr(const FNameIndexPtr&) : FNameIndexPtr() {}
+		FNameIndexPtr& operator=(const FNameIndexPtr&)
+		{
+			index_ = MakeUnique<FNameIndex>();
+			return *this;
+		}
+
+		FNameIndex* operator->() const { return index_.Get(); }
+		FNameIndex& operator*() const { return *index_; }
+
+	private:
+		TUniquePtr<FNameIndex> index_;
+	};
+	FNameIndexPtr name_index_;
 };
 
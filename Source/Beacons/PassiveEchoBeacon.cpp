@@ -2,6 +2,7 @@
 
 #include "PassiveEchoBeacon.h"
 #include "AirBlueprintLib.h"
+#include "UnrealSensors/UnrealRaycastBackend.h"
 #include "UObject/ConstructorHelpers.h"
 #include "Components/StaticMeshComponent.h"
 
@@ -32,6 +33,7 @@ void APassiveEchoBeacon::getPointCloud()
 {
 	FVector trace_start_position;
 	trace_start_position = ned_transform_->fromLocalNed(beacon_reference_frame_.position);
+	UnrealRaycastBackend raycast_backend(this, ignore_actors_);
 
 
 
@@ -57,7 +59,7 @@ void APassiveEchoBeacon::getPointCloud()
 
 		// Shoot trace and get the impact point and remaining attenuation, if any returns
 		UnrealEchoCommon::traceDirection(0, false, trace_start_position, trace_end_position, point_cloud_, groundtruth_, point_cloud_draw_reflected_points_, ned_transform_, beacon_reference_frame_,
-			distance_limit_, reflection_limit_, attenuation_limit_, reflection_distance_limit_cm_, 0, attenuation_per_distance_, attenuation_per_reflection_, ignore_actors_, this, false, true,
+			distance_limit_, reflection_limit_, attenuation_limit_, reflection_distance_limit_cm_, 0, attenuation_per_distance_, attenuation_per_reflection_, &raycast_backend, this, false, true,
 			draw_debug_duration_, line_thickness_ / 2, false, draw_debug_all_lines_, false, false, false, false, true, true, reflection_only_final_, std::string(TCHAR_TO_UTF8(*name_)));
 	}
 }
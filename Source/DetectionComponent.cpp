@@ -13,6 +13,10 @@
 #include <Kismet/KismetSystemLibrary.h>
 #include <Kismet/KismetMathLibrary.h>
 #include <Engine/EngineTypes.h>
+#include <Runtime/Launch/Resources/Version.h>
+#if ENGINE_MAJOR_VERSION > 5 || (ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 3)
+#include <Engine/OverlapResult.h>
+#endif
 
 UDetectionComponent::UDetectionComponent()
     : max_distance_to_camera_(20000.f)
@@ -33,6 +37,7 @@ void UDetectionComponent::BeginPlay()
         this->Deactivate();
     }
     object_filter_ = FObjectFilter();
+    resetFilterCache();
 }
 
 void UDetectionComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
@@ -40,24 +45,98 @@ void UDetectionComponent::TickComponent(float DeltaTime, ELevelTick TickType, FA
     Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 }
 
-const TArray<FDetectionInfo> &UDetectionComponent::getDetections(TMap<UMeshComponent*, FString>  component_to_name_map, bool component_based)
+const TArray<FDetectionInfo> &UDetectionComponent::getDetections(const TMap<UMeshComponent*, FString>& component_to_name_map, bool component_based)
 {
-    cached_detections_.Empty();
+    if (!texture_target_ || !scene_capture_component_2D_)
+    {
+        cached_detections_.Empty();
+        has_cached_detections_ = false;
+        return cached_detections_;
+    }
+
+    const FDetectionView view = makeDetectionView();
+
+    // Tags, class and mesh of an actor can change at any time, filter results are only reused within a frame
+    if (filter_cache_frame_ != GFrameCounter)
+    {
+        actor_filter_cache_.Empty();
+        component_filter_cache_.Empty();
+        filter_cache_frame_ = GFrameCounter;
+    }
 
-    for (TActorIterator<AActor> actor_itr(GetWorld()); actor_itr; ++actor_itr)
+    // Only components that respond to ECC_WorldStatic can pass the line of sight test below, so the physics scene
+    // is the spatial index: it returns the candidates within range without visiting the rest of the world
+    TArray<FOverlapResult> overlaps;
+    FCollisionQueryParams query_params(SCENE_QUERY_STAT(DetectionCandidates), false);
+    GetWorld()->OverlapMultiByChannel(overlaps, view.Location, FQuat::Identity, ECC_WorldStatic, FCollisionShape::MakeSphere(max_distance_to_camera_), query_params);
+
+    TArray<AActor*> candidate_actors;
+    TMap<AActor*, TArray<UMeshComponent*>> candidate_components;
+    TArray<FCandidateState> candidates;
+    candidates.Reserve(overlaps.Num());
+    for (const FOverlapResult& overlap : overlaps)
     {
-        AActor *actor = *actor_itr;
-        if (object_filter_.matchesActor(actor, component_based))
+        UPrimitiveComponent* component = overlap.GetComponent();
+        AActor* actor = overlap.GetActor();
+        if (!component || !actor)
+            continue;
+
+        UMeshComponent* mesh_component = Cast<UMeshComponent>(component);
+        FCandidateState candidate;
+        candidate.Component = component;
+        candidate.Transform = component->GetComponentTransform();
+        candidate.Bounds = component->Bounds;
+        candidate.ActorMatches = matchesActor(actor, component_based);
+        candidate.ComponentMatches = component_based && mesh_component && matchesComponent(mesh_component);
+        candidates.Add(candidate);
+
+        TArray<UMeshComponent*>* actor_components = candidate_components.Find(actor);
+        if (!actor_components)
+        {
+            candidate_actors.Add(actor);
+            actor_components = &candidate_components.Add(actor);
+        }
+        if (mesh_component)
+            actor_components->Add(mesh_component);
+    }
+
+    // Nothing moved and nothing was filtered or named differently since the last call, the detections are still valid
+    const FTransform camera_transform = GetComponentTransform();
+    const FIntPoint texture_size(texture_target_->SizeX, texture_target_->SizeY);
+    bool is_unchanged = has_cached_detections_ && cached_component_based_ == component_based && cached_texture_size_ == texture_size &&
+                        cached_fov_ == scene_capture_component_2D_->FOVAngle && cached_max_distance_ == max_distance_to_camera_ &&
+                        cached_camera_transform_.Equals(camera_transform, 0) && cached_candidates_.Num() == candidates.Num();
+    for (int32 i = 0; is_unchanged && i < candidates.Num(); ++i)
+    {
+        const FCandidateState& cached = cached_candidates_[i];
+        is_unchanged = cached.Component == candidates[i].Component && cached.Transform.Equals(candidates[i].Transform, 0) &&
+                       cached.Bounds.Origin.Equals(candidates[i].Bounds.Origin, 0) && cached.Bounds.BoxExtent.Equals(candidates[i].Bounds.BoxExtent, 0) &&
+                       cached.ActorMatches == candidates[i].ActorMatches && cached.ComponentMatches == candidates[i].ComponentMatches;
+    }
+    for (int32 i = 0; is_unchanged && i < cached_detections_.Num(); ++i)
+    {
+        const FDetectionInfo& detection = cached_detections_[i];
+        is_unchanged = detection.DetectionName == getDetectionName(detection.Actor, detection.Component, component_to_name_map);
+    }
+    if (is_unchanged)
+    {
+        return cached_detections_;
+    }
+
+    cached_detections_.Reset();
+    for (AActor* actor : candidate_actors)
+    {
+        if (matchesActor(actor, component_based))
         {
             if (FVector::Distance(actor->GetActorLocation(), GetComponentLocation()) <= max_distance_to_camera_)
             {
                 FBox2D box_2D_out;
-                if (texture_target_ && calcBoundingFromViewInfo(actor, box_2D_out))
+                if (calcBoundingFromViewInfo(actor, view, box_2D_out))
                 {
                     FDetectionInfo detection;
                     detection.Actor = actor;
                     detection.Box2D = box_2D_out;
-                    detection.DetectionName = actor->GetName();
+                    detection.DetectionName = getDetectionName(actor, nullptr, component_to_name_map);
 
                     FBox box_3D = actor->GetComponentsBoundingBox(true);
                     detection.Box3D = FBox(getRelativeLocation(box_3D.Min), getRelativeLocation(box_3D.Max));
@@ -69,77 +148,20 @@ const TArray<FDetectionInfo> &UDetectionComponent::getDetections(TMap<UMeshCompo
             }
         }
         if (component_based) {
-            TArray<UMeshComponent*> actor_components;
-            actor->GetComponents<UMeshComponent>(actor_components);
-            for (auto component : actor_components)
+            for (UMeshComponent* component : candidate_components[actor])
             {
-                if (object_filter_.matchesComponent(component))
+                if (matchesComponent(component))
                 {
                     if (FVector::Distance(component->GetComponentLocation(), GetComponentLocation()) <= max_distance_to_camera_)
                     {
                         FBox2D box_2D_out;
-                        if (texture_target_ && calcBoundingFromViewInfoComponent(component, box_2D_out))
+                        if (calcBoundingFromViewInfoComponent(component, view, box_2D_out))
                         {
                             FDetectionInfo detection;
                             detection.Actor = actor;
                             detection.Component = component;
                             detection.Box2D = box_2D_out;
-                            if(component_to_name_map.Contains(component)) {
-								detection.DetectionName = component_to_name_map[component];
-							}
-							else {
-                                int index = 0;
-                                if (actor_components.Num() == 1) {
-                                    if (UStaticMeshComponent* staticmesh_component = Cast<UStaticMeshComponent>(component)) {
-                                        if (actor->GetParentActor()) {
-                                            if (staticmesh_component->GetStaticMesh() != nullptr) {
-                                                FString component_name = staticmesh_component->GetStaticMesh()->GetName();
-                                                component_name.Append("_");
-                                                component_name.Append(FString::FromInt(0));
-                                                component_name.Append("_");
-                                                if (actor->GetRootComponent()->GetAttachParent()) {
-                                                    component_name.Append(actor->GetRootComponent()->GetAttachParent()->GetName());
-                                                    component_name.Append("_");
-                                                }
-                                                component_name.Append(actor->GetParentActor()->GetName());
-                                                detection.DetectionName = component_name;
-                                            }
-                                        }
-                                        else {
-                                            detection.DetectionName = actor->GetName();
-                                        }
-                                    }
-                                    if (USkinnedMeshComponent* SkinnedMeshComponent = Cast<USkinnedMeshComponent>(component)) {
-                                        detection.DetectionName = actor->GetName();
-                                    }
-                                }
-                                else {
-                                    FString component_name;
-                                    if (UStaticMeshComponent* staticmesh_component = Cast<UStaticMeshComponent>(component)) {
-                                        if (staticmesh_component->GetStaticMesh() != nullptr) {
-                                            component_name = staticmesh_component->GetStaticMesh()->GetName();
-                                            component_name.Append("_");
-                                            component_name.Append(FString::FromInt(index));
-                                            component_name.Append("_");
-                                            if (actor->GetParentActor()) {
-                                                if (actor->GetRootComponent()->GetAttachParent()) {
-                                                    component_name.Append(actor->GetRootComponent()->GetAttachParent()->GetName());
-                                                    component_name.Append("_");
-                                                }
-                                                component_name.Append(actor->GetParentActor()->GetName());
-                                            }
-                                            else {
-                                                component_name.Append(actor->GetName());
-                                            }
-                                        }
-                                    }
-                                    if (USkinnedMeshComponent* skinnedmesh_component = Cast<USkinnedMeshComponent>(component)) {
-                                        component_name = actor->GetName();
-                                    }
-                                    detection.DetectionName = component_name;
-                                    index++;
-                                }
-							}                            
+                            detection.DetectionName = getDetectionName(actor, component, component_to_name_map);
 
                             FBox box_3D = component->Bounds.GetBox();
                             detection.Box3D = FBox(getRelativeLocation(box_3D.Min), getRelativeLocation(box_3D.Max));
@@ -154,22 +176,113 @@ const TArray<FDetectionInfo> &UDetectionComponent::getDetections(TMap<UMeshCompo
         }
     }
 
+    cached_candidates_ = MoveTemp(candidates);
+    cached_camera_transform_ = camera_transform;
+    cached_texture_size_ = texture_size;
+    cached_fov_ = scene_capture_component_2D_->FOVAngle;
+    cached_max_distance_ = max_distance_to_camera_;
+    cached_component_based_ = component_based;
+    has_cached_detections_ = true;
+
     return cached_detections_;
 }
 
-bool UDetectionComponent::calcBoundingFromViewInfo(AActor *actor, FBox2D &box_out)
+FString UDetectionComponent::getDetectionName(AActor* actor, UMeshComponent* component, const TMap<UMeshComponent*, FString>& component_to_name_map) const
 {
-    FVector origin;
-    FVector extend;
-    actor->GetActorBounds(true, origin, extend);
+    if (!component)
+        return actor->GetName();
+    const FString* component_name = component_to_name_map.Find(component);
+    return component_name ? *component_name : getComponentDetectionName(actor, component);
+}
 
-    TArray<FVector> points;
-    TArray<FVector2D> points_2D;
-    bool is_in_camera_view = false;
+FString UDetectionComponent::getComponentDetectionName(AActor* actor, UMeshComponent* component) const
+{
+    TArray<UMeshComponent*> actor_components;
+    actor->GetComponents<UMeshComponent>(actor_components);
+
+    FString detection_name;
+    int index = 0;
+    if (actor_components.Num() == 1) {
+        if (UStaticMeshComponent* staticmesh_component = Cast<UStaticMeshComponent>(component)) {
+            if (actor->GetParentActor()) {
+                if (staticmesh_component->GetStaticMesh() != nullptr) {
+                    FString component_name = staticmesh_component->GetStaticMesh()->GetName();
+                    component_name.Append("_");
+                    component_name.Append(FString::FromInt(0));
+                    component_name.Append("_");
+                    if (actor->GetRootComponent()->GetAttachParent()) {
+                        component_name.Append(actor->GetRootComponent()->GetAttachParent()->GetName());
+                        component_name.Append("_");
+                    }
+                    component_name.Append(actor->GetParentActor()->GetName());
+                    detection_name = component_name;
+                }
+            }
+            else {
+                detection_name = actor->GetName();
+            }
+        }
+        if (USkinnedMeshComponent* SkinnedMeshComponent = Cast<USkinnedMeshComponent>(component)) {
+            detection_name = actor->GetName();
+        }
+    }
+    else {
+        FString component_name;
+        if (UStaticMeshComponent* staticmesh_component = Cast<UStaticMeshComponent>(component)) {
+            if (staticmesh_component->GetStaticMesh() != nullptr) {
+                component_name = staticmesh_component->GetStaticMesh()->GetName();
+                component_name.Append("_");
+                component_name.Append(FString::FromInt(index));
+                component_name.Append("_");
+                if (actor->GetParentActor()) {
+                    if (actor->GetRootComponent()->GetAttachParent()) {
+                        component_name.Append(actor->GetRootComponent()->GetAttachParent()->GetName());
+                        component_name.Append("_");
+                    }
+                    component_name.Append(actor->GetParentActor()->GetName());
+                }
+                else {
+                    component_name.Append(actor->GetName());
+                }
+            }
+        }
+        if (USkinnedMeshComponent* skinnedmesh_component = Cast<USkinnedMeshComponent>(component)) {
+            component_name = actor->GetName();
+        }
+        detection_name = component_name;
+    }
+    return detection_name;
+}
+
+bool UDetectionComponent::matchesActor(AActor* actor, bool component_based)
+{
+    if (filter_cache_component_based_ != component_based)
+    {
+        actor_filter_cache_.Empty();
+        filter_cache_component_based_ = component_based;
+    }
+
+    if (const bool* matches = actor_filter_cache_.Find(actor))
+        return *matches;
+    return actor_filter_cache_.Add(actor, object_filter_.matchesActor(actor, component_based));
+}
 
-    // get render target for texture size
-    FRenderTarget *render_target = texture_target_->GameThread_GetRenderTargetResource();
+bool UDetectionComponent::matchesComponent(UMeshComponent* component)
+{
+    if (const bool* matches = component_filter_cache_.Find(component))
+        return *matches;
+    return component_filter_cache_.Add(component, object_filter_.matchesComponent(component));
+}
 
+void UDetectionComponent::resetFilterCache()
+{
+    actor_filter_cache_.Empty();
+    component_filter_cache_.Empty();
+    has_cached_detections_ = false;
+}
+
+UDetectionComponent::FDetectionView UDetectionComponent::makeDetectionView() const
+{
     // initialize viewinfo for projection matrix
     FMinimalViewInfo info;
     info.Location = scene_capture_component_2D_->GetComponentTransform().GetLocation();
@@ -181,20 +294,9 @@ bool UDetectionComponent::calcBoundingFromViewInfo(AActor *actor, FBox2D &box_ou
     info.OrthoFarClipPlane = 100000;
     info.bConstrainAspectRatio = true;
 
-    // calculate 3D corner Points of bounding box
-    points.Add(origin + FVector(extend.X, extend.Y, extend.Z));
-    points.Add(origin + FVector(-extend.X, extend.Y, extend.Z));
-    points.Add(origin + FVector(extend.X, -extend.Y, extend.Z));
-    points.Add(origin + FVector(-extend.X, -extend.Y, extend.Z));
-    points.Add(origin + FVector(extend.X, extend.Y, -extend.Z));
-    points.Add(origin + FVector(-extend.X, extend.Y, -extend.Z));
-    points.Add(origin + FVector(extend.X, -extend.Y, -extend.Z));
-    points.Add(origin + FVector(-extend.X, -extend.Y, -extend.Z));
-
-    // initialize pixel values
-    FVector2D min_pixel(texture_target_->SizeX, texture_target_->SizeY);
-    FVector2D max_pixel(0, 0);
-    FIntRect screen_rect(0, 0, texture_target_->SizeX, texture_target_->SizeY);
+    FDetectionView view;
+    view.Location = GetComponentLocation();
+    view.ScreenRect = FIntRect(0, 0, texture_target_->SizeX, texture_target_->SizeY);
 
     // initialize projection data for sceneview
     FSceneViewProjectionData projection_data;
@@ -215,138 +317,68 @@ bool UDetectionComponent::calcBoundingFromViewInfo(AActor *actor, FBox2D &box_ou
     {
         projection_data.ProjectionMatrix = info.CalculateProjectionMatrix();
     }
-    projection_data.SetConstrainedViewRectangle(screen_rect);
+    projection_data.SetConstrainedViewRectangle(view.ScreenRect);
 
-    // Project Points to pixels and get the corner pixels
-    for (FVector &point : points)
-    {
-        FVector2D Pixel(0, 0);
-        FSceneView::ProjectWorldToScreen((point), screen_rect, projection_data.ComputeViewProjectionMatrix(), Pixel);
-        is_in_camera_view |= (Pixel != screen_rect.Min) && (Pixel != screen_rect.Max) && screen_rect.Contains(FIntPoint(Pixel.X, Pixel.Y));
-        points_2D.Add(Pixel);
-        max_pixel.X = FMath::Max(Pixel.X, max_pixel.X);
-        max_pixel.Y = FMath::Max(Pixel.Y, max_pixel.Y);
-        min_pixel.X = FMath::Min(Pixel.X, min_pixel.X);
-        min_pixel.Y = FMath::Min(Pixel.Y, min_pixel.Y);
-    }
-
-    // If actor in camera view - check if it's actually visible or hidden
-    // Check against 8 extend points
-    bool is_visible = false;
-    if (is_in_camera_view)
-    {
-        FHitResult result;
-        bool is_world_hit;
-        for (FVector &point : points)
-        {
-            is_world_hit = GetWorld()->LineTraceSingleByChannel(result, GetComponentLocation(), point, ECC_WorldStatic);
-            if (is_world_hit)
-            {
-                if (result.GetActor() == actor)
-                {
-                    is_visible = true;
-                    break;
-                }
-            }
-        }
-
-        // If actor in camera view but didn't hit any point out of 8 extend points,
-        // check against 10 random points
-        if (!is_visible)
-        {
-            for (int i = 0; i < 10; i++)
-            {
-                FVector point = UKismetMathLibrary::RandomPointInBoundingBox(origin, extend);
-                is_world_hit = GetWorld()->LineTraceSingleByChannel(result, GetComponentLocation(), point, ECC_WorldStatic);
-                if (is_world_hit)
-                {
-                    if (result.GetActor() == actor)
-                    {
-                        is_visible = true;
-                        break;
-                    }
-                }
-            }
-        }
-    }
+    view.ViewProjectionMatrix = projection_data.ComputeViewProjectionMatrix();
+    GetViewFrustumBounds(view.Frustum, view.ViewProjectionMatrix, false);
+    return view;
+}
 
-    FBox2D box_out_temp = FBox2D(min_pixel, max_pixel);
+bool UDetectionComponent::calcBoundingFromViewInfo(AActor *actor, const FDetectionView& view, FBox2D &box_out)
+{
+    FVector origin;
+    FVector extend;
+    actor->GetActorBounds(true, origin, extend);
 
-    box_out.Min.X = FMath::Clamp<float>(box_out_temp.Min.X, 0, texture_target_->SizeX);
-    box_out.Min.Y = FMath::Clamp<float>(box_out_temp.Min.Y, 0, texture_target_->SizeY);
-    box_out.Max.X = FMath::Clamp<float>(box_out_temp.Max.X, 0, texture_target_->SizeX);
-    box_out.Max.Y = FMath::Clamp<float>(box_out_temp.Max.Y, 0, texture_target_->SizeY);
+    return calcBoundingFromBox(FBox(origin - extend, origin + extend), view, [actor](const FHitResult& result) {
+        return result.GetActor() == actor;
+    }, box_out);
+}
 
-    return is_in_camera_view && is_visible;
+bool UDetectionComponent::calcBoundingFromViewInfoComponent(UMeshComponent *component, const FDetectionView& view, FBox2D &box_out)
+{
+    return calcBoundingFromBox(component->Bounds.GetBox(), view, [component](const FHitResult& result) {
+        return result.GetComponent() == component;
+    }, box_out);
 }
 
-bool UDetectionComponent::calcBoundingFromViewInfoComponent(UMeshComponent *component, FBox2D &box_out)
+bool UDetectionComponent::calcBoundingFromBox(const FBox& bounds, const FDetectionView& view, TFunctionRef<bool(const FHitResult&)> is_target, FBox2D& box_out)
 {
     FVector origin;
     FVector extend;
-    component->Bounds.GetBox().GetCenterAndExtents(origin, extend);
+    bounds.GetCenterAndExtents(origin, extend);
 
-    TArray<FVector> points;
-    TArray<FVector2D> points_2D;
-    bool is_in_camera_view = false;
-
-    // get render target for texture size
-    FRenderTarget *render_target = texture_target_->GameThread_GetRenderTargetResource();
+    // boxes outside the frustum can not have a corner on screen, skip the projection and the traces
+    if (!view.Frustum.IntersectBox(origin, extend))
+    {
+        return false;
+    }
 
-    // initialize viewinfo for projection matrix
-    FMinimalViewInfo info;
-    info.Location = scene_capture_component_2D_->GetComponentTransform().GetLocation();
-    info.Rotation = scene_capture_component_2D_->GetComponentTransform().GetRotation().Rotator();
-    info.FOV = scene_capture_component_2D_->FOVAngle;
-    info.ProjectionMode = scene_capture_component_2D_->ProjectionType;
-    info.AspectRatio = float(texture_target_->SizeX) / float(texture_target_->SizeY);
-    info.OrthoNearClipPlane = 1;
-    info.OrthoFarClipPlane = 100000;
-    info.bConstrainAspectRatio = true;
+    bool is_in_camera_view = false;
 
     // calculate 3D corner Points of bounding box
-    points.Add(origin + FVector(extend.X, extend.Y, extend.Z));
-    points.Add(origin + FVector(-extend.X, extend.Y, extend.Z));
-    points.Add(origin + FVector(extend.X, -extend.Y, extend.Z));
-    points.Add(origin + FVector(-extend.X, -extend.Y, extend.Z));
-    points.Add(origin + FVector(extend.X, extend.Y, -extend.Z));
-    points.Add(origin + FVector(-extend.X, extend.Y, -extend.Z));
-    points.Add(origin + FVector(extend.X, -extend.Y, -extend.Z));
-    points.Add(origin + FVector(-extend.X, -extend.Y, -extend.Z));
+    const FVector points[8] = {
+        origin + FVector(extend.X, extend.Y, extend.Z),
+        origin + FVector(-extend.X, extend.Y, extend.Z),
+        origin + FVector(extend.X, -extend.Y, extend.Z),
+        origin + FVector(-extend.X, -extend.Y, extend.Z),
+        origin + FVector(extend.X, extend.Y, -extend.Z),
+        origin + FVector(-extend.X, extend.Y, -extend.Z),
+        origin + FVector(extend.X, -extend.Y, -extend.Z),
+        origin + FVector(-extend.X, -extend.Y, -extend.Z)
+    };
 
     // initialize pixel values
     FVector2D min_pixel(texture_target_->SizeX, texture_target_->SizeY);
     FVector2D max_pixel(0, 0);
-    FIntRect screen_rect(0, 0, texture_target_->SizeX, texture_target_->SizeY);
-
-    // initialize projection data for sceneview
-    FSceneViewProjectionData projection_data;
-    projection_data.ViewOrigin = info.Location;
-
-    // do some voodoo rotation that is somehow mandatory and stolen from UGameplayStatics::ProjectWorldToScreen
-    projection_data.ViewRotationMatrix = FInverseRotationMatrix(info.Rotation) * FMatrix(
-                                                                                     FPlane(0, 0, 1, 0),
-                                                                                     FPlane(1, 0, 0, 0),
-                                                                                     FPlane(0, 1, 0, 0),
-                                                                                     FPlane(0, 0, 0, 1));
-
-    if (scene_capture_component_2D_->bUseCustomProjectionMatrix)
-    {
-        projection_data.ProjectionMatrix = scene_capture_component_2D_->CustomProjectionMatrix;
-    }
-    else
-    {
-        projection_data.ProjectionMatrix = info.CalculateProjectionMatrix();
-    }
-    projection_data.SetConstrainedViewRectangle(screen_rect);
+    const FIntRect& screen_rect = view.ScreenRect;
 
     // Project Points to pixels and get the corner pixels
-    for (FVector &point : points)
+    for (const FVector &point : points)
     {
         FVector2D Pixel(0, 0);
-        FSceneView::ProjectWorldToScreen((point), screen_rect, projection_data.ComputeViewProjectionMatrix(), Pixel);
+        FSceneView::ProjectWorldToScreen(point, screen_rect, view.ViewProjectionMatrix, Pixel);
         is_in_camera_view |= (Pixel != screen_rect.Min) && (Pixel != screen_rect.Max) && screen_rect.Contains(FIntPoint(Pixel.X, Pixel.Y));
-        points_2D.Add(Pixel);
         max_pixel.X = FMath::Max(Pixel.X, max_pixel.X);
         max_pixel.Y = FMath::Max(Pixel.Y, max_pixel.Y);
         min_pixel.X = FMath::Min(Pixel.X, min_pixel.X);
@@ -360,12 +392,12 @@ bool UDetectionComponent::calcBoundingFromViewInfoComponent(UMeshComponent *comp
     {
         FHitResult result;
         bool is_world_hit;
-        for (FVector &point : points)
+        for (const FVector &point : points)
         {
-            is_world_hit = GetWorld()->LineTraceSingleByChannel(result, GetComponentLocation(), point, ECC_WorldStatic);
+            is_world_hit = GetWorld()->LineTraceSingleByChannel(result, view.Location, point, ECC_WorldStatic);
             if (is_world_hit)
             {
-                if (result.GetComponent() == component)
+                if (is_target(result))
                 {
                     is_visible = true;
                     break;
@@ -380,10 +412,10 @@ bool UDetectionComponent::calcBoundingFromViewInfoComponent(UMeshComponent *comp
             for (int i = 0; i < 10; i++)
             {
                 FVector point = UKismetMathLibrary::RandomPointInBoundingBox(origin, extend);
-                is_world_hit = GetWorld()->LineTraceSingleByChannel(result, GetComponentLocation(), point, ECC_WorldStatic);
+                is_world_hit = GetWorld()->LineTraceSingleByChannel(result, view.Location, point, ECC_WorldStatic);
                 if (is_world_hit)
                 {
-                    if (result.GetComponent() == component)
+                    if (is_target(result))
                     {
                         is_visible = true;
                         break;
@@ -422,6 +454,7 @@ void UDetectionComponent::addMeshName(const std::string &mesh_name)
     if (!object_filter_.wildcard_mesh_names_.Contains(name))
     {
         object_filter_.wildcard_mesh_names_.Add(name);
+        resetFilterCache();
     }
 }
 
@@ -433,4 +466,5 @@ void UDetectionComponent::setFilterRadius(const float radius_cm)
 void UDetectionComponent::clearMeshNames()
 {
     object_filter_.wildcard_mesh_names_.Empty();
+    resetFilterCache();
 }
\ No newline at end of file
@@ -12,6 +12,7 @@
 #include "TextureResource.h"
 #include "Components/SceneCaptureComponent2D.h"
 #include "Components/SkinnedMeshComponent.h"
+#include "ConvexVolume.h"
 #include "ObjectFilter.h"
 #include <string>
 #include "DetectionComponent.generated.h"
@@ -67,15 +68,42 @@ public:
     // Called every frame
     virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
-    const TArray<FDetectionInfo>& getDetections(TMap<UMeshComponent*, FString>  component_to_name_map, bool component_based = true);
+    const TArray<FDetectionInfo>& getDetections(const TMap<UMeshComponent*, FString>& component_to_name_map, bool component_based = true);
 
     void addMeshName(const std::string& mesh_name);
     void setFilterRadius(const float radius_cm);
     void clearMeshNames();
 
 private:
-    bool calcBoundingFromViewInfo(AActor* actor, FBox2D& box_out);
-    bool calcBoundingFromViewInfoComponent(UMeshComponent* component, FBox2D& box_out);
+    // Camera projection and frustum, computed once per getDetections call
+    struct FDetectionView
+    {
+        FVector Location;
+        FMatrix ViewProjectionMatrix;
+        FIntRect ScreenRect;
+        FConvexVolume Frustum;
+    };
+
+    // World transform, bounds and filter results of a candidate, the previous result is reused when none of them and the camera changed.
+    // Bounds change without the transform when a mesh is swapped or an animated mesh moves.
+    struct FCandidateState
+    {
+        TWeakObjectPtr<UPrimitiveComponent> Component;
+        FTransform Transform;
+        FBoxSphereBounds Bounds;
+        bool ActorMatches = false;
+        bool ComponentMatches = false;
+    };
+
+    FDetectionView makeDetectionView() const;
+    bool calcBoundingFromViewInfo(AActor* actor, const FDetectionView& view, FBox2D& box_out);
+    bool calcBoundingFromViewInfoComponent(UMeshComponent* component, const FDetectionView& view, FBox2D& box_out);
+    bool calcBoundingFromBox(const FBox& bounds, const FDetectionView& view, TFunctionRef<bool(const FHitResult&)> is_target, FBox2D& box_out);
+    FString getDetectionName(AActor* actor, UMeshComponent* component, const TMap<UMeshComponent*, FString>& component_to_name_map) const;
+    FString getComponentDetectionName(AActor* actor, UMeshComponent* component) const;
+    bool matchesActor(AActor* actor, bool component_based);
+    bool matchesComponent(UMeshComponent* component);
+    void resetFilterCache();
 
     FVector getRelativeLocation(FVector in_location);
 
@@ -97,4 +125,17 @@ private:
 
     UPROPERTY()
     TArray<FDetectionInfo> cached_detections_;
+
+    TMap<TWeakObjectPtr<AActor>, bool> actor_filter_cache_;
+    TMap<TWeakObjectPtr<UMeshComponent>, bool> component_filter_cache_;
+    bool filter_cache_component_based_ = true;
+    uint64 filter_cache_frame_ = 0;
+
+    TArray<FCandidateState> cached_candidates_;
+    FTransform cached_camera_transform_;
+    FIntPoint cached_texture_size_ = FIntPoint::ZeroValue;
+    float cached_fov_ = 0;
+    float cached_max_distance_ = 0;
+    bool cached_component_based_ = true;
+    bool has_cached_detections_ = false;
 };
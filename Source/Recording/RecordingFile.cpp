@@ -5,17 +5,18 @@
 #include "ImageUtils.h"
 #include "common/ClockFactory.hpp"
 #include "common/common_utils/FileSystem.hpp"
+#include "recording/RecordingConverter.hpp"
 
-void RecordingFile::appendRecord(const std::vector<msr::airlib::ImageCaptureBase::ImageResponse>& responses,
-                                 msr::airlib::VehicleSimApiBase* vehicle_sim_api) const
+bool RecordingFile::appendRecord(std::vector<msr::airlib::ImageCaptureBase::ImageResponse>&& responses,
+                                 msr::airlib::VehicleSimApiBase* vehicle_sim_api)
 {
-    bool save_success = false;
+    PendingRecord record;
     std::ostringstream image_file_names;
 
     for (auto i = 0; i < responses.size(); ++i) {
         const auto& response = responses.at(i);
 
-        //build image file name
+        //build image file name, the time stamp is the capture time rather than the write time
         std::ostringstream image_file_name;
 
         image_file_name << "img_"
@@ -38,14 +39,69 @@ void RecordingFile::appendRecord(const std::vector<msr::airlib::ImageCaptureBase
         if (i > 0)
             image_file_names << ";";
         image_file_names << image_file_name.str();
-        std::string image_full_file_path = common_utils::FileSystem::combine(image_path_, image_file_name.str());
+        record.image_file_list.push_back(image_file_name.str());
+    }
+
+    record.image_file_names = image_file_names.str();
+    record.record_line = vehicle_sim_api->getRecordFileLine(false);
+    record.time_stamp = msr::airlib::ClockFactory::get()->nowNanos();
+    record.responses = std::move(responses);
+
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        ++stats_.captured;
+
+        if (!writers_.empty()) {
+            if (queue_.size() >= queue_size_) {
+                if (drop_when_full_) {
+                    ++stats_.dropped;
+                    return false;
+                }
+                //backpressure: hold the capture thread until a writer frees a slot
+                queue_not_full_.wait(lock, [this]() { return queue_.size() < queue_size_ || stop_writers_; });
+            }
+
+            //writers that stopped during the wait may already have drained the queue, write the record here instead
+            if (!stop_writers_) {
+                record.sequence = next_sequence_++;
+                queue_.push_back(std::move(record));
+                stats_.max_queue_depth = std::max<uint64>(stats_.max_queue_depth, queue_.size());
+                lock.unlock();
+                queue_not_empty_.notify_one();
+                return true;
+            }
+        }
+
+        record.sequence = next_sequence_++;
+    }
 
-        //write image file
+    writeRecord(record);
+    return true;
+}
+
+void RecordingFile::writeRecord(const PendingRecord& record)
+{
+    bool save_success = false;
+    FinishedRecord finished;
+    finished.time_stamp = record.time_stamp;
+
+    for (auto i = 0; i < record.responses.size(); ++i) {
+        const auto& response = record.responses.at(i);
+        const std::string& image_file_name = record.image_file_list.at(i);
+        std::string image_full_file_path = common_utils::FileSystem::combine(image_path_, image_file_name);
+
+        //encode into the container record, or write the image file
         try {
-            if (extension == ".pfm") {
+            if (container_) {
+                std::vector<uint8> file_data;
+                msr::airlib::RecordingConverter::encodeImageFile(response, file_data);
+                finished.image_records.emplace_back();
+                msr::airlib::RecordingConverter::encodeImageRecord(image_file_name, file_data, finished.image_records.back());
+            }
+            else if (response.pixels_as_float) {
                 common_utils::Utils::writePFMfile(response.image_data_float.data(), response.width, response.height, image_full_file_path);
             }
-            else if (extension == ".ppm") {
+            else if (!response.compress) {
                 common_utils::Utils::writePPMfile(response.image_data_uint8.data(), response.width, response.height, image_full_file_path);
             }
             else {
@@ -63,20 +119,124 @@ void RecordingFile::appendRecord(const std::vector<msr::airlib::ImageCaptureBase
         }
     }
 
-    //write to CSV file
-    if (save_success || (responses.size() == 0)) {
-        // Either images were saved successfully, or there were no images
-        writeString(vehicle_sim_api->getRecordFileLine(false).append(image_file_names.str()).append("\n"));
+    // Either images were saved successfully, or there were no images
+    finished.success = save_success || (record.responses.size() == 0);
+    if (finished.success)
+        finished.line = record.record_line + record.image_file_names;
+    commitRecord(record.sequence, std::move(finished));
+}
+
+void RecordingFile::commitRecord(uint64 sequence, FinishedRecord&& record)
+{
+    std::lock_guard<std::mutex> lock(line_mutex_);
+    finished_records_[sequence] = std::move(record);
+
+    //flush every record whose predecessors are all done, failed records only advance the sequence
+    auto it = finished_records_.begin();
+    while (it != finished_records_.end() && it->first == next_commit_sequence_) {
+        const FinishedRecord& finished = it->second;
+        if (finished.success) {
+            if (container_) {
+                for (const auto& image_record : finished.image_records)
+                    container_->write(image_channel_, finished.time_stamp, image_record);
+                container_->write(pose_channel_, finished.time_stamp, finished.line);
+            }
+            else {
+                writeString(finished.line + "\n");
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> stats_lock(queue_mutex_);
+            if (finished.success)
+                ++stats_.written;
+            else
+                ++stats_.failed;
+        }
+
+        it = finished_records_.erase(it);
+        ++next_commit_sequence_;
+    }
+}
+
+void RecordingFile::startWriters(int writer_threads, int queue_size, bool drop_when_full)
+{
+    stopWriters();
+
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    queue_size_ = static_cast<size_t>(std::max(1, queue_size));
+    drop_when_full_ = drop_when_full;
+    stop_writers_ = false;
+    for (int i = 0; i < writer_threads; ++i)
+        writers_.emplace_back(&RecordingFile::writerLoop, this);
+}
+
+void RecordingFile::writerLoop()
+{
+    while (true) {
+        PendingRecord record;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            queue_not_empty_.wait(lock, [this]() { return !queue_.empty() || stop_writers_; });
 
-        //UAirBlueprintLib::LogMessage(TEXT("Screenshot saved to:"), filePath, LogDebugLevel::Success);
+            //on stop the queue is drained before the writer exits
+            if (queue_.empty())
+                return;
+
+            record = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        queue_not_full_.notify_one();
+
+        writeRecord(record);
     }
 }
 
+void RecordingFile::stopWriters()
+{
+    //appendRecord checks writers_ under the same lock, from here on it writes records itself
+    std::vector<std::thread> writers;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        stop_writers_ = true;
+        writers.swap(writers_);
+    }
+    queue_not_empty_.notify_all();
+    queue_not_full_.notify_all();
+
+    for (auto& writer : writers)
+        writer.join();
+}
+
+RecordingFile::WriterStats RecordingFile::getStats() const
+{
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    return stats_;
+}
+
 void RecordingFile::appendColumnHeader(const std::string& header_columns)
 {
     writeString(header_columns + "ImageFile" + "\n");
 }
 
+void RecordingFile::createContainer(const std::string& file_path, const std::string& header_columns, bool compress_chunks, uint64 max_file_bytes)
+{
+    try {
+        closeFile();
+
+        container_.reset(new msr::airlib::RecordingContainerWriter());
+        if (!container_->open(file_path, compress_chunks ? msr::airlib::ChunkCodec::Type::Lz : msr::airlib::ChunkCodec::Type::None, 4 << 20, max_file_bytes)) {
+            container_.reset();
+            return;
+        }
+        pose_channel_ = container_->addChannel(msr::airlib::RecordingConverter::kPoseChannel, msr::airlib::RecordingContainer::ChannelType::TextLine, header_columns + "ImageFile");
+        image_channel_ = container_->addChannel(msr::airlib::RecordingConverter::kImageChannel, msr::airlib::RecordingContainer::ChannelType::ImageFile);
+    }
+    catch (std::exception& ex) {
+        UAirBlueprintLib::LogMessageString(std::string("createContainer Failed for ") + file_path, ex.what(), LogDebugLevel::Failure);
+    }
+}
+
 void RecordingFile::createFile(const std::string& file_path, const std::string& header_columns)
 {
     try {
@@ -93,15 +253,19 @@ void RecordingFile::createFile(const std::string& file_path, const std::string&
 
 bool RecordingFile::isFileOpen() const
 {
-    return log_file_handle_ != nullptr;
+    return log_file_handle_ != nullptr || container_ != nullptr;
 }
 
 void RecordingFile::closeFile()
 {
-    if (isFileOpen())
+    if (log_file_handle_)
         delete log_file_handle_;
 
     log_file_handle_ = nullptr;
+    //writes the chunk index
+    sensor_container_ = nullptr;
+    sensor_only_container_.reset();
+    container_.reset();
 }
 
 void RecordingFile::writeString(const std::string& str) const
@@ -124,19 +288,44 @@ RecordingFile::~RecordingFile()
     stopRecording(true);
 }
 
-void RecordingFile::startRecording(msr::airlib::VehicleSimApiBase* vehicle_sim_api, const std::string& folder)
+void RecordingFile::startRecording(msr::airlib::VehicleSimApiBase* vehicle_sim_api, const std::string& folder,
+                                   bool use_container, bool compress_chunks, uint64 max_file_bytes, uint64 sensor_buffer_bytes)
 {
     try {
         std::string log_folderpath = common_utils::FileSystem::getLogFolderPath(true, folder);
-        image_path_ = common_utils::FileSystem::ensureFolder(log_folderpath, "images");
-        std::string log_filepath = common_utils::FileSystem::getLogFileNamePath(log_folderpath, record_filename, "", ".txt", false);
-        if (log_filepath != "")
+        image_path_ = use_container ? log_folderpath : common_utils::FileSystem::ensureFolder(log_folderpath, "images");
+        std::string log_filepath = common_utils::FileSystem::getLogFileNamePath(log_folderpath, record_filename, "",
+                                                                                use_container ? msr::airlib::RecordingContainer::kExtension : ".txt", false);
+        if (log_filepath != "" && use_container)
+            createContainer(log_filepath, vehicle_sim_api->getRecordFileLine(true), compress_chunks, max_file_bytes);
+        else if (log_filepath != "")
             createFile(log_filepath, vehicle_sim_api->getRecordFileLine(true));
         else {
             UAirBlueprintLib::LogMessageString("Cannot start recording because path for log file is not available", "", LogDebugLevel::Failure);
             return;
         }
 
+        if (isFileOpen() && sensor_buffer_bytes > 0) {
+            if (container_) {
+                sensor_container_ = container_.get();
+            }
+            else {
+                //the text record file cannot hold binary samples, they get a container of their own
+                std::string sensor_filepath = common_utils::FileSystem::getLogFileNamePath(log_folderpath, sensor_record_filename, "",
+                                                                                           msr::airlib::RecordingContainer::kExtension, false);
+                sensor_only_container_.reset(new msr::airlib::RecordingContainerWriter());
+                if (sensor_only_container_->open(sensor_filepath, compress_chunks ? msr::airlib::ChunkCodec::Type::Lz : msr::airlib::ChunkCodec::Type::None, 4 << 20, max_file_bytes))
+                    sensor_container_ = sensor_only_container_.get();
+                else {
+                    sensor_only_container_.reset();
+                    UAirBlueprintLib::LogMessageString("Cannot create sensor recording file", sensor_filepath, LogDebugLevel::Failure);
+                }
+            }
+
+            if (sensor_container_)
+                sensor_recorder_.reset(new msr::airlib::SensorStreamRecorder(static_cast<size_t>(sensor_buffer_bytes)));
+        }
+
         if (isFileOpen()) {
             is_recording_ = true;
 
@@ -150,8 +339,61 @@ void RecordingFile::startRecording(msr::airlib::VehicleSimApiBase* vehicle_sim_a
     }
 }
 
+void RecordingFile::addSensorStream(const std::string& vehicle_name, const msr::airlib::SensorBase* sensor, msr::airlib::SensorBase::SensorType sensor_type)
+{
+    if (!sensor_recorder_ || !sensor)
+        return;
+
+    std::lock_guard<std::mutex> lock(line_mutex_);
+    const uint16 channel = sensor_container_->addChannel("sensors/" + vehicle_name + "/" + sensor->getName(), msr::airlib::RecordingContainer::ChannelType::SensorMessage,
+                                                         msr::airlib::SensorMessageCodec::getMetadata(sensor_type));
+    sensor_recorder_->addSensor(sensor, sensor_type, channel);
+}
+
+void RecordingFile::startSensorRecording(float overhead_budget_us)
+{
+    if (!sensor_recorder_)
+        return;
+
+    if (sensor_recorder_->getSensorCount() == 0) {
+        UAirBlueprintLib::LogMessageString("Sensor recording: ", "no matching sensors", LogDebugLevel::Failure);
+        sensor_recorder_.reset();
+        return;
+    }
+
+    sensor_overhead_budget_us_ = overhead_budget_us;
+    //runs on the flush thread of the recorder, the container is shared with the record writers
+    sensor_recorder_->start([this](uint16 channel, msr::airlib::TTimePoint time_stamp, const uint8* data, size_t size) {
+        std::lock_guard<std::mutex> lock(line_mutex_);
+        sensor_container_->write(channel, time_stamp, data, size);
+    });
+    UAirBlueprintLib::LogMessageString("Sensor recording: ", std::to_string(sensor_recorder_->getSensorCount()) + " sensors", LogDebugLevel::Success);
+}
+
+void RecordingFile::stopSensorRecording()
+{
+    if (!sensor_recorder_)
+        return;
+
+    //flushes the pending samples, so this has to run before the container is closed
+    sensor_recorder_->stop();
+
+    const msr::airlib::SensorStreamRecorder::Stats stats = sensor_recorder_->getStats();
+    const double average_us = stats.samples + stats.dropped > 0 ? stats.overhead_seconds * 1E6 / (stats.samples + stats.dropped) : 0;
+    std::ostringstream message;
+    message << stats.samples << " samples, " << stats.dropped << " dropped, " << stats.bytes / (1024 * 1024) << " MB, "
+            << average_us << " us average overhead (budget " << sensor_overhead_budget_us_ << " us), " << stats.max_overhead_seconds * 1E6 << " us max";
+    UAirBlueprintLib::LogMessageString("Sensor recording: ", message.str(),
+                                       stats.dropped > 0 || average_us > sensor_overhead_budget_us_ ? LogDebugLevel::Failure : LogDebugLevel::Success);
+
+    sensor_recorder_.reset();
+}
+
 void RecordingFile::stopRecording(bool ignore_if_stopped)
 {
+    stopSensorRecording();
+    stopWriters();
+
     is_recording_ = false;
     if (!isFileOpen()) {
         if (ignore_if_stopped)
@@ -164,6 +406,11 @@ void RecordingFile::stopRecording(bool ignore_if_stopped)
 
     UAirBlueprintLib::LogMessage(TEXT("Recording: "), TEXT("Stopped"), LogDebugLevel::Success);
     UAirBlueprintLib::LogMessage(TEXT("Data saved to: "), FString(image_path_.c_str()), LogDebugLevel::Success);
+
+    const WriterStats stats = getStats();
+    UAirBlueprintLib::LogMessageString("Records: ", std::to_string(stats.written) + " written, " + std::to_string(stats.dropped) + " dropped, " +
+        std::to_string(stats.failed) + " failed, max queue depth " + std::to_string(stats.max_queue_depth),
+        stats.dropped + stats.failed > 0 ? LogDebugLevel::Failure : LogDebugLevel::Success);
 }
 
 bool RecordingFile::isRecording() const
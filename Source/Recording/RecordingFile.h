@@ -2,31 +2,107 @@
 
 #include "CoreMinimal.h"
 #include <string>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 #include "AirBlueprintLib.h"
 #include "physics/Kinematics.hpp"
 #include "HAL/FileManager.h"
 #include "PawnSimApi.h"
+#include "recording/RecordingContainer.hpp"
+#include "recording/SensorStreamRecorder.hpp"
 
 class RecordingFile
 {
+public:
+    struct WriterStats {
+        uint64 captured = 0;        // records handed to appendRecord
+        uint64 written = 0;         // records with all images on disk and a line in the record file
+        uint64 dropped = 0;         // records dropped because the queue was full
+        uint64 failed = 0;          // records where an image could not be written
+        uint64 max_queue_depth = 0;
+    };
+
 public:
     ~RecordingFile();
 
-    void appendRecord(const std::vector<msr::airlib::ImageCaptureBase::ImageResponse>& responses, msr::airlib::VehicleSimApiBase* vehicle_sim_api) const;
+    // Queues the responses for the writer threads, or writes them inline without writers. Returns false if the record was dropped.
+    bool appendRecord(std::vector<msr::airlib::ImageCaptureBase::ImageResponse>&& responses, msr::airlib::VehicleSimApiBase* vehicle_sim_api);
     void appendColumnHeader(const std::string& header_columns);
-    void startRecording(msr::airlib::VehicleSimApiBase* vehicle_sim_api, const std::string& folder = "");
+    // With use_container the record lines and images go to a single chunked airsim_rec.asrec instead of airsim_rec.txt and images/.
+    // A non zero sensor_buffer_bytes enables sensor stream recording, into the same container or into airsim_sensors.asrec
+    // next to airsim_rec.txt.
+    void startRecording(msr::airlib::VehicleSimApiBase* vehicle_sim_api, const std::string& folder = "",
+                        bool use_container = false, bool compress_chunks = true, uint64 max_file_bytes = 0, uint64 sensor_buffer_bytes = 0);
+    void startWriters(int writer_threads, int queue_size, bool drop_when_full);
+    // Register the sensor streams after startRecording, then start them together
+    void addSensorStream(const std::string& vehicle_name, const msr::airlib::SensorBase* sensor, msr::airlib::SensorBase::SensorType sensor_type);
+    void startSensorRecording(float overhead_budget_us);
     void stopRecording(bool ignore_if_stopped);
     bool isRecording() const;
+    WriterStats getStats() const;
 
 private:
+    struct PendingRecord {
+        uint64 sequence = 0;
+        std::vector<msr::airlib::ImageCaptureBase::ImageResponse> responses;
+        std::vector<std::string> image_file_list;
+        std::string image_file_names;
+        std::string record_line;
+        msr::airlib::TTimePoint time_stamp = 0;
+    };
+
+    struct FinishedRecord {
+        bool success = false;
+        std::string line;
+        std::vector<std::vector<uint8>> image_records; // container only
+        msr::airlib::TTimePoint time_stamp = 0;
+    };
+
     void createFile(const std::string& file_path, const std::string& header_columns);
+    void createContainer(const std::string& file_path, const std::string& header_columns, bool compress_chunks, uint64 max_file_bytes);
     void closeFile();
     void writeString(const std::string& line) const;
     bool isFileOpen() const;
 
+    void writerLoop();
+    void stopWriters();
+    void stopSensorRecording();
+    void writeRecord(const PendingRecord& record);
+    void commitRecord(uint64 sequence, FinishedRecord&& record);
+
 private:
     std::string record_filename = "airsim_rec";
+    std::string sensor_record_filename = "airsim_sensors";
     std::string image_path_;
     bool is_recording_ = false;
     IFileHandle* log_file_handle_ = nullptr;
-};
\ No newline at end of file
+    std::unique_ptr<msr::airlib::RecordingContainerWriter> container_;
+    uint16 pose_channel_ = 0;
+    uint16 image_channel_ = 0;
+
+    // sensor_container_ is container_, or sensor_only_container_ when the records go to airsim_rec.txt
+    msr::airlib::RecordingContainerWriter* sensor_container_ = nullptr;
+    std::unique_ptr<msr::airlib::RecordingContainerWriter> sensor_only_container_;
+    std::unique_ptr<msr::airlib::SensorStreamRecorder> sensor_recorder_;
+    float sensor_overhead_budget_us_ = 0;
+
+    std::vector<std::thread> writers_;
+    std::deque<PendingRecord> queue_;
+    size_t queue_size_ = 0;
+    bool drop_when_full_ = false;
+    bool stop_writers_ = false;
+    uint64 next_sequence_ = 0;
+    mutable std::mutex queue_mutex_;
+    std::condition_variable queue_not_empty_;
+    std::condition_variable queue_not_full_;
+
+    // records are written in capture order even when writers finish out of order
+    std::map<uint64, FinishedRecord> finished_records_;
+    uint64 next_commit_sequence_ = 0;
+    std::mutex line_mutex_;
+
+    WriterStats stats_;
+};
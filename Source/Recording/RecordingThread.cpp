@@ -41,12 +41,61 @@ void FRecordingThread::startRecording(const RecordingSetting& settings,
 
     running_instance_->recording_file_.reset(new RecordingFile());
     // Just need any 1 instance, to set the header line of the record file
-    running_instance_->recording_file_->startRecording(*(vehicle_sim_apis.begin()), settings.folder);
+    running_instance_->recording_file_->startRecording(*(vehicle_sim_apis.begin()), settings.folder, settings.format == "Container",
+                                                       settings.compress_chunks, static_cast<uint64>(settings.max_file_size_mb * 1024 * 1024),
+                                                       settings.sensors.empty() ? 0 : static_cast<uint64>(settings.sensor_buffer_mb * 1024 * 1024));
+    running_instance_->recording_file_->startWriters(settings.writer_threads, settings.queue_size, settings.drop_when_full);
+
+    if (!settings.sensors.empty()) {
+        running_instance_->addSensorStreams(vehicle_sim_apis);
+        running_instance_->recording_file_->startSensorRecording(settings.sensor_overhead_budget_us);
+    }
 
     // Set is_ready at the end, setting this before can cause a race when the file isn't open yet
     running_instance_->is_ready_ = true;
 }
 
+void FRecordingThread::addSensorStreams(const common_utils::UniqueValueMap<std::string, VehicleSimApiBase*>& vehicle_sim_apis)
+{
+    typedef msr::airlib::SensorBase::SensorType SensorType;
+
+    for (const auto& vehicle_sim_api : vehicle_sim_apis) {
+        const std::string& vehicle_name = vehicle_sim_api->getVehicleName();
+        auto sensor_names = settings_.sensors.find(vehicle_name);
+        if (sensor_names == settings_.sensors.end())
+            continue;
+
+        const msr::airlib::VehicleApiBase* vehicle_api = static_cast<PawnSimApi*>(vehicle_sim_api)->getVehicleApiBase();
+        if (vehicle_api == nullptr)
+            continue;
+
+        const msr::airlib::SensorCollection* sensors = nullptr;
+        try {
+            sensors = &vehicle_api->getSensors();
+        }
+        catch (const std::exception& ex) {
+            UAirBlueprintLib::LogMessageString("Cannot record sensors of " + vehicle_name, ex.what(), LogDebugLevel::Failure);
+            continue;
+        }
+
+        for (uint type = static_cast<uint>(SensorType::Barometer); type <= static_cast<uint>(SensorType::Wifi); ++type) {
+            const SensorType sensor_type = static_cast<SensorType>(type);
+            if (sensor_type == SensorType::SensorTemplate)
+                continue;
+
+            for (uint index = 0; index < sensors->size(sensor_type); ++index) {
+                const msr::airlib::SensorBase* sensor = sensors->getByType(sensor_type, index);
+                for (const auto& name : sensor_names->second) {
+                    if (name == "*" || name == sensor->getName()) {
+                        recording_file_->addSensorStream(vehicle_name, sensor, sensor_type);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
 FRecordingThread::~FRecordingThread()
 {
     if (this == running_instance_.get()) stopRecording();
@@ -104,31 +153,40 @@ uint32 FRecordingThread::Run()
 {
     while (stop_task_counter_.GetValue() == 0) {
         //make sure all vars are set up
-        if (is_ready_) {
-            bool interval_elapsed = msr::airlib::ClockFactory::get()->elapsedSince(last_screenshot_on_) > settings_.record_interval;
+        if (!is_ready_) {
+            FPlatformProcess::Sleep(kMaxWaitSeconds);
+            continue;
+        }
 
-            if (interval_elapsed) {
-                last_screenshot_on_ = msr::airlib::ClockFactory::get()->nowNanos();
+        //sleep until the next capture is due instead of polling the clock, capped so a stop request or a change
+        //in clock speed is picked up quickly. The interval is in sim time, so a paused sim does not capture.
+        msr::airlib::TTimeDelta remaining = settings_.record_interval - msr::airlib::ClockFactory::get()->elapsedSince(last_screenshot_on_);
+        if (remaining > 0) {
+            FPlatformProcess::Sleep(static_cast<float>(std::min<msr::airlib::TTimeDelta>(remaining, kMaxWaitSeconds)));
+            continue;
+        }
 
-                for (const auto& vehicle_sim_api : vehicle_sim_apis_) {
-                    const auto& vehicle_name = vehicle_sim_api->getVehicleName();
+        last_screenshot_on_ = msr::airlib::ClockFactory::get()->nowNanos();
 
-                    const auto* kinematics = vehicle_sim_api->getGroundTruthKinematics();
-                    bool is_pose_unequal = kinematics && last_poses_[vehicle_name] != kinematics->pose;
+        for (const auto& vehicle_sim_api : vehicle_sim_apis_) {
+            const auto& vehicle_name = vehicle_sim_api->getVehicleName();
 
-                    if (!settings_.record_on_move || is_pose_unequal) {
-                        last_poses_[vehicle_name] = kinematics->pose;
+            const auto* kinematics = vehicle_sim_api->getGroundTruthKinematics();
+            bool is_pose_unequal = kinematics && last_poses_[vehicle_name] != kinematics->pose;
 
-                        std::vector<ImageCaptureBase::ImageResponse> responses;
+            if (!settings_.record_on_move || is_pose_unequal) {
+                last_poses_[vehicle_name] = kinematics->pose;
 
-                        image_captures_[vehicle_name]->getImages(settings_.requests[vehicle_name], responses);
-                        recording_file_->appendRecord(responses, vehicle_sim_api);
-                    }
-                }
+                std::vector<ImageCaptureBase::ImageResponse> responses;
+
+                //only the capture runs here, encoding and disk writes happen on the writer threads of the recording file
+                image_captures_[vehicle_name]->getImages(settings_.requests[vehicle_name], responses);
+                recording_file_->appendRecord(std::move(responses), vehicle_sim_api);
             }
         }
     }
 
+    //drains the writer queue before closing the file
     recording_file_.reset();
 
     return 0;
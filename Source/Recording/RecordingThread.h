@@ -37,6 +37,10 @@ protected:
     virtual void Exit() override;
 
 private:
+    static constexpr float kMaxWaitSeconds = 0.005f;
+
+    void addSensorStreams(const common_utils::UniqueValueMap<std::string, VehicleSimApiBase*>& vehicle_sim_apis);
+
     FThreadSafeCounter stop_task_counter_;
 
     static std::unique_ptr<FRecordingThread> running_instance_;
@@ -149,6 +149,13 @@ void ASimModeBase::BeginPlay()
     AirSimSettings::TimeOfDaySetting tod_setting = getSettings().tod_setting;
     setTimeOfDay(tod_setting.enabled, tod_setting.start_datetime, tod_setting.is_start_datetime_dst, tod_setting.celestial_clock_speed, tod_setting.update_interval_secs, tod_setting.move_sun);
 
+    //before the vehicles are spawned, they would show up as occupied
+    const AirSimSettings::OccupancyMapSetting& occupancy_map_setting = getSettings().occupancy_map_setting;
+    if (occupancy_map_setting.enabled) {
+        if (occupancy_map_setting.file_path.empty() || !world_sim_api_->loadOccupancyMap(occupancy_map_setting.file_path))
+            world_sim_api_->buildOccupancyMap(occupancy_map_setting.center, occupancy_map_setting.size, occupancy_map_setting.resolution);
+    }
+
     UAirBlueprintLib::LogMessage(TEXT("Press F1 to see help"), TEXT(""), LogDebugLevel::Informational);
 
     setupVehiclesAndCamera();
@@ -770,65 +777,66 @@ std::vector<std::string> ASimModeBase::GetAllInstanceSegmentationMeshIDs() {
 }
 
 std::vector<msr::airlib::Vector3r> ASimModeBase::GetInstanceSegmentationColorMap() {
-    TArray<FColor> color_map = instance_segmentation_annotator_.GetColorMap();
+    const TArray<FColor>& color_map = instance_segmentation_annotator_.GetColorMap();
     std::vector<msr::airlib::Vector3r> color_map_vector;
-    for (FColor color : color_map) {
+    color_map_vector.reserve(color_map.Num());
+    for (const FColor& color : color_map) {
         color_map_vector.push_back(msr::airlib::Vector3r(color.R, color.G, color.B));
     }
     return color_map_vector;
 }
 
-TMap<UMeshComponent*, FString> ASimModeBase::GetInstanceSegmentationComponentToNameMap() {
+const TMap<UMeshComponent*, FString>& ASimModeBase::GetInstanceSegmentationComponentToNameMap() {
     return instance_segmentation_annotator_.GetComponentToNameMap();
 }
 
 std::vector<msr::airlib::Pose> ASimModeBase::GetAllInstanceSegmentationMeshPoses(bool ned, bool only_visible) {
-    std::vector<msr::airlib::Pose> retval;
-    TMap<FString, UMeshComponent*> nameToComponentMapTemp = instance_segmentation_annotator_.GetNameToComponentMap();
-    for (auto const& element : nameToComponentMapTemp) {
-        UAirBlueprintLib::RunCommandOnGameThread([ned, only_visible, &retval, element, this]() {
-            if (element.Value->HasBegunPlay() && element.Value->IsRenderStateCreated()) {
-                if (!element.Value->IsBeingDestroyed() && IsValid(element.Value)) {
-                    if (!only_visible || element.Value->GetVisibleFlag()) {
-                        if (ned) {
-                            retval.emplace_back(getGlobalNedTransform().toGlobalNed(FTransform(element.Value->GetComponentRotation(), element.Value->GetComponentLocation())));
-                        }
-                        else {
-                            retval.emplace_back(getGlobalNedTransform().toLocalNed(FTransform(element.Value->GetComponentRotation(), element.Value->GetComponentLocation())));
-                        }
-                    }
-                    else {
-                        retval.emplace_back(msr::airlib::Pose::nanPose());
-                    }
-                }
-                else {
-                    retval.emplace_back(msr::airlib::Pose::nanPose());
-                }
-            }
-            else{
-                retval.emplace_back(msr::airlib::Pose::nanPose());
-            }
-        }, true);
-    }
-    return retval;
+    return getMeshPoses(instance_segmentation_annotator_, ned, only_visible);
+}
+
+std::vector<msr::airlib::Pose> ASimModeBase::getMeshPoses(FObjectAnnotator& annotator, bool ned, bool only_visible)
+{
+    //the game thread changes the component map, so it is read in the same task that reads the poses
+    std::vector<msr::airlib::Pose> poses;
+    UAirBlueprintLib::RunCommandOnGameThread([this, &annotator, &poses, ned, only_visible]() {
+        const TMap<FString, UMeshComponent*>& components = annotator.GetNameToComponentMap();
+        poses.reserve(components.Num());
+        for (const auto& element : components)
+            poses.push_back(getMeshPose(element.Value, ned, only_visible));
+    }, true);
+    return poses;
+}
+
+msr::airlib::Pose ASimModeBase::getMeshPose(UMeshComponent* component, bool ned, bool only_visible)
+{
+    if (!IsValid(component) || component->IsBeingDestroyed() || !component->HasBegunPlay() || !component->IsRenderStateCreated())
+        return msr::airlib::Pose::nanPose();
+    if (only_visible && !component->GetVisibleFlag())
+        return msr::airlib::Pose::nanPose();
+
+    const FTransform transform(component->GetComponentRotation(), component->GetComponentLocation());
+    return ned ? getGlobalNedTransform().toGlobalNed(transform) : getGlobalNedTransform().toLocalNed(transform);
+}
+
+int ASimModeBase::applyToMatchingMeshes(FObjectAnnotator& annotator, const std::string& mesh_name_regex, TFunctionRef<void(const FString&)> apply)
+{
+    //an invalid regex throws here, on the calling thread, matching and applying is one game thread task
+    const FObjectAnnotator::FNamePattern pattern = annotator.CompileNamePattern(mesh_name_regex);
+    int changes = 0;
+    UAirBlueprintLib::RunCommandOnGameThread([&annotator, &pattern, &apply, &changes]() {
+        const TArray<FString> keys = annotator.GetComponentNamesMatching(pattern);
+        for (const FString& key : keys)
+            apply(key);
+        changes = keys.Num();
+    }, true);
+    return changes;
 }
 
 bool ASimModeBase::SetMeshInstanceSegmentationID(const std::string& mesh_name, int object_id, bool is_name_regex, bool update_annotation) {
 	if (is_name_regex) {
-		std::regex name_regex;
-		name_regex.assign(mesh_name, std::regex_constants::icase);
-		int changes = 0;
-		for (auto It = instance_segmentation_annotator_.GetNameToComponentMap().CreateConstIterator(); It; ++It)
-		{
-			if (std::regex_match(TCHAR_TO_UTF8(*It.Key()), name_regex)) {
-				bool success;
-				FString key = It.Key();
-				UAirBlueprintLib::RunCommandOnGameThread([this, key, object_id, &success]() {
-					success = instance_segmentation_annotator_.SetComponentRGBColorByIndex(key, object_id);
-				}, true);
-				changes++;
-			}
-		}
+		const int changes = applyToMatchingMeshes(instance_segmentation_annotator_, mesh_name, [this, object_id](const FString& key) {
+			instance_segmentation_annotator_.SetComponentRGBColorByIndex(key, object_id);
+		});
         if(update_annotation && changes > 0)updateInstanceSegmentationAnnotation();
         return changes > 0;
 	}
@@ -865,33 +873,7 @@ std::vector<msr::airlib::Pose> ASimModeBase::GetAllAnnotationMeshPoses(const std
         UE_LOG(LogTemp, Log, TEXT("AirSim Annotation [%s]: Could not find annotation layer %s"), *FString(annotation_name.c_str()), *FString(annotation_name.c_str()));
         return retval;
     }
-    TMap<FString, UMeshComponent*> nameToComponentMapTemp = annotators_[FString(annotation_name.c_str())].GetNameToComponentMap();
-    for (auto const& element : nameToComponentMapTemp) {
-        UAirBlueprintLib::RunCommandOnGameThread([ned, only_visible, &retval, element, this]() {
-            if (element.Value->HasBegunPlay() && element.Value->IsRenderStateCreated()) {
-                if (!element.Value->IsBeingDestroyed() && IsValid(element.Value)) {
-                    if (!only_visible || element.Value->GetVisibleFlag()) {
-                        if (ned) {
-                            retval.emplace_back(getGlobalNedTransform().toGlobalNed(FTransform(element.Value->GetComponentRotation(), element.Value->GetComponentLocation())));
-                        }
-                        else {
-                            retval.emplace_back(getGlobalNedTransform().toLocalNed(FTransform(element.Value->GetComponentRotation(), element.Value->GetComponentLocation())));
-                        }
-                    }
-                    else {
-                        retval.emplace_back(msr::airlib::Pose::nanPose());
-                    }
-                }
-                else {
-                    retval.emplace_back(msr::airlib::Pose::nanPose());
-                }
-            }
-            else {
-                retval.emplace_back(msr::airlib::Pose::nanPose());
-            }
-            }, true);
-    }
-    return retval;
+    return getMeshPoses(annotators_[FString(annotation_name.c_str())], ned, only_visible);
 }
 
 bool ASimModeBase::SetMeshRGBAnnotationID(const std::string& annotation_name, const std::string& mesh_name, int object_id, bool is_name_regex, bool update_annotation) {
@@ -909,20 +891,10 @@ bool ASimModeBase::SetMeshRGBAnnotationID(const std::string& annotation_name, co
     }
 
     if (is_name_regex) {
-        std::regex name_regex;
-        name_regex.assign(mesh_name, std::regex_constants::icase);
-        int changes = 0;
-        for (auto It = annotators_[FString(annotation_name.c_str())].GetNameToComponentMap().CreateConstIterator(); It; ++It)
-        {
-            if (std::regex_match(TCHAR_TO_UTF8(*It.Key()), name_regex)) {
-                bool success;
-                FString key = It.Key();
-                UAirBlueprintLib::RunCommandOnGameThread([this, key, object_id, &success, annotation_name]() {
-                    success = annotators_[FString(annotation_name.c_str())].SetComponentRGBColorByIndex(key, object_id);
-                    }, true);
-                changes++;
-            }
-        }
+        FObjectAnnotator& annotator = annotators_[FString(annotation_name.c_str())];
+        const int changes = applyToMatchingMeshes(annotator, mesh_name, [&annotator, object_id](const FString& key) {
+            annotator.SetComponentRGBColorByIndex(key, object_id);
+        });
         if (update_annotation && changes > 0)updateAnnotation(FString(annotation_name.c_str()));
         return changes > 0;
     }
@@ -957,20 +929,10 @@ bool ASimModeBase::SetMeshRGBAnnotationColor(const std::string& annotation_name,
     FColor color = FColor(r, g, b);
 
     if (is_name_regex) {
-        std::regex name_regex;
-        name_regex.assign(mesh_name, std::regex_constants::icase);
-        int changes = 0;
-        for (auto It = annotators_[FString(annotation_name.c_str())].GetNameToComponentMap().CreateConstIterator(); It; ++It)
-        {
-            if (std::regex_match(TCHAR_TO_UTF8(*It.Key()), name_regex)) {
-                bool success;
-                FString key = It.Key();
-                UAirBlueprintLib::RunCommandOnGameThread([this, key, color, &success, annotation_name]() {
-                    success = annotators_[FString(annotation_name.c_str())].SetComponentRGBColorByColor(key, color);
-                    }, true);
-                changes++;
-            }
-        }
+        FObjectAnnotator& annotator = annotators_[FString(annotation_name.c_str())];
+        const int changes = applyToMatchingMeshes(annotator, mesh_name, [&annotator, color](const FString& key) {
+            annotator.SetComponentRGBColorByColor(key, color);
+        });
         if (update_annotation && changes > 0)updateAnnotation(FString(annotation_name.c_str()));
         return changes > 0;
     }
@@ -1000,20 +962,10 @@ bool ASimModeBase::SetMeshGreyscaleAnnotationValue(const std::string& annotation
     }
     
     if (is_name_regex) {
-        std::regex name_regex;
-        name_regex.assign(mesh_name, std::regex_constants::icase);
-        int changes = 0;
-        for (auto It = annotators_[FString(annotation_name.c_str())].GetNameToComponentMap().CreateConstIterator(); It; ++It)
-        {
-            if (std::regex_match(TCHAR_TO_UTF8(*It.Key()), name_regex)) {
-                bool success;
-                FString key = It.Key();
-                UAirBlueprintLib::RunCommandOnGameThread([this, key, greyscale_value, &success, annotation_name]() {
-                    success = annotators_[FString(annotation_name.c_str())].SetComponentGreyScaleColorByValue(key, greyscale_value);
-                    }, true);
-                changes++;
-            }
-        }
+        FObjectAnnotator& annotator = annotators_[FString(annotation_name.c_str())];
+        const int changes = applyToMatchingMeshes(annotator, mesh_name, [&annotator, greyscale_value](const FString& key) {
+            annotator.SetComponentGreyScaleColorByValue(key, greyscale_value);
+        });
         if (update_annotation && changes > 0)updateAnnotation(FString(annotation_name.c_str()));
         return changes > 0;
     }
@@ -1061,20 +1013,10 @@ bool ASimModeBase::SetMeshTextureAnnotationPath(const std::string& annotation_na
     FString texture_path_fstring = FString(texture_path.c_str());
 
     if (is_name_regex) {
-        std::regex name_regex;
-        name_regex.assign(mesh_name, std::regex_constants::icase);
-        int changes = 0;
-        for (auto It = annotators_[FString(annotation_name.c_str())].GetNameToComponentMap().CreateConstIterator(); It; ++It)
-        {
-            if (std::regex_match(TCHAR_TO_UTF8(*It.Key()), name_regex)) {
-                bool success;
-                FString key = It.Key();
-                UAirBlueprintLib::RunCommandOnGameThread([this, key, texture_path_fstring, &success, annotation_name]() {
-                    success = annotators_[FString(annotation_name.c_str())].SetComponentTextureByDirectPath(key, texture_path_fstring);
-                    }, true);
-                changes++;
-            }
-        }
+        FObjectAnnotator& annotator = annotators_[FString(annotation_name.c_str())];
+        const int changes = applyToMatchingMeshes(annotator, mesh_name, [&annotator, &texture_path_fstring](const FString& key) {
+            annotator.SetComponentTextureByDirectPath(key, texture_path_fstring);
+        });
         if (update_annotation && changes > 0)updateAnnotation(FString(annotation_name.c_str()));
         return changes > 0;
     }
@@ -1108,20 +1050,10 @@ bool ASimModeBase::EnableMeshTextureAnnotationByPath(const std::string& annotati
     }
 
     if (is_name_regex) {
-        std::regex name_regex;
-        name_regex.assign(mesh_name, std::regex_constants::icase);
-        int changes = 0;
-        for (auto It = annotators_[FString(annotation_name.c_str())].GetNameToComponentMap().CreateConstIterator(); It; ++It)
-        {
-            if (std::regex_match(TCHAR_TO_UTF8(*It.Key()), name_regex)) {
-                bool success;
-                FString key = It.Key();
-                UAirBlueprintLib::RunCommandOnGameThread([this, key, &success, annotation_name]() {
-                    success = annotators_[FString(annotation_name.c_str())].SetComponentTextureByRelativePath(key);
-                    }, true);
-                changes++;
-            }
-        }
+        FObjectAnnotator& annotator = annotators_[FString(annotation_name.c_str())];
+        const int changes = applyToMatchingMeshes(annotator, mesh_name, [&annotator](const FString& key) {
+            annotator.SetComponentTextureByRelativePath(key);
+        });
         if (update_annotation && changes > 0)updateAnnotation(FString(annotation_name.c_str()));
         return changes > 0;
     }
@@ -1494,6 +1426,11 @@ void ASimModeBase::setExtForce(const msr::airlib::Vector3r& ext_force) const
     throw std::domain_error("setExtForce not implemented by SimMode");
 }
 
+msr::airlib::SafetyMonitor* ASimModeBase::getSafetyMonitor() const
+{
+    return nullptr;
+}
+
 std::unique_ptr<msr::airlib::ApiServerBase> ASimModeBase::createApiServer() const
 {
     //this will be the case when compilation with RPCLIB is disabled or simmode doesn't support APIs
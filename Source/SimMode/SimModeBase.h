@@ -17,6 +17,7 @@
 #include "api/ApiProvider.hpp"
 #include "PawnSimApi.h"
 #include "common/StateReporterWrapper.hpp"
+#include "safety/SafetyMonitor.hpp"
 #include "LoadingScreenWidget.h"
 #include "UnrealImageCapture.h"
 #include "Beacons/TemplateBeacon.h"
@@ -166,6 +167,8 @@ public:
 
     virtual void setWind(const msr::airlib::Vector3r& wind) const;
     virtual void setExtForce(const msr::airlib::Vector3r& ext_force) const;
+    //null when the sim mode has no physics loop
+    virtual msr::airlib::SafetyMonitor* getSafetyMonitor() const;
 
     virtual void setTimeOfDay(bool is_enabled, const std::string& start_datetime, bool is_start_datetime_dst,
                               float celestial_clock_speed, float update_interval_secs, bool move_sun);
@@ -199,7 +202,7 @@ public:
     }
 	std::vector<std::string> GetAllInstanceSegmentationMeshIDs();
     std::vector<msr::airlib::Pose> GetAllInstanceSegmentationMeshPoses(bool ned = true, bool only_visible = false);
-    TMap<UMeshComponent*, FString> GetInstanceSegmentationComponentToNameMap();
+    const TMap<UMeshComponent*, FString>& GetInstanceSegmentationComponentToNameMap();
     std::vector<msr::airlib::Vector3r> GetInstanceSegmentationColorMap();
 
 	bool SetMeshInstanceSegmentationID(const std::string& mesh_name, int object_id, bool is_name_regex, bool update_annotation = true);
@@ -344,4 +347,7 @@ private:
     void setupPhysicsLoopPeriod();
     void showClockStats();
     void drawDistanceSensorDebugPoints();
+    std::vector<msr::airlib::Pose> getMeshPoses(FObjectAnnotator& annotator, bool ned, bool only_visible);
+    msr::airlib::Pose getMeshPose(UMeshComponent* component, bool ned, bool only_visible);
+    int applyToMatchingMeshes(FObjectAnnotator& annotator, const std::string& mesh_name_regex, TFunctionRef<void(const FString&)> apply);
 };
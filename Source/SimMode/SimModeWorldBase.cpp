@@ -72,11 +72,14 @@ void ASimModeWorldBase::BeginPlay()
 void ASimModeWorldBase::initializeForPlay()
 {
     std::vector<msr::airlib::UpdatableObject*> vehicles;
+    //a world from an earlier call may still be updating safety_monitor_, so it is only replaced after that world is gone
+    std::unique_ptr<msr::airlib::SafetyMonitor> safety_monitor(new msr::airlib::SafetyMonitor());
 
     for (auto& api : getApiProvider()->getVehicleSimApis())
     {
         if (isAirLibManagedVehicle(api)) {
             vehicles.push_back(api);
+            addToSafetyMonitor(safety_monitor.get(), api);
         }
         else {
             UAirBlueprintLib::LogMessageString(
@@ -92,6 +95,9 @@ void ASimModeWorldBase::initializeForPlay()
 
     unreal_only_vehicles_reset_done_ = true;
 
+    initializeSafetyMonitor(safety_monitor.get());
+    vehicles.push_back(safety_monitor.get());
+
     std::unique_ptr<PhysicsEngineBase> physics_engine = createPhysicsEngine();
     physics_engine_ = physics_engine.get();
 
@@ -99,6 +105,9 @@ void ASimModeWorldBase::initializeForPlay()
         std::move(physics_engine),
         vehicles,
         getPhysicsLoopPeriod()));
+
+    //the previous world and its physics thread were destroyed by the reset above
+    safety_monitor_ = std::move(safety_monitor);
 }
 
 
@@ -114,6 +123,27 @@ void ASimModeWorldBase::registerPhysicsBody(msr::airlib::VehicleSimApiBase* phys
     }
 
     physics_world_.get()->addBody(physicsBody);
+    addToSafetyMonitor(safety_monitor_.get(), physicsBody);
+}
+
+void ASimModeWorldBase::initializeSafetyMonitor(msr::airlib::SafetyMonitor* safety_monitor)
+{
+    const AirSimSettings::SafetyMonitorSetting& setting = getSettings().safety_monitor_setting;
+    safety_monitor->setSeparation(setting.separation);
+    for (const auto& fence : setting.geofences) {
+        try {
+            safety_monitor->addFence(std::make_shared<msr::airlib::PolygonGeoFence>(fence.vertices, fence.min_z, fence.max_z), fence.keep_out);
+        }
+        catch (const std::invalid_argument& ex) {
+            UAirBlueprintLib::LogMessageString("SafetyMonitor: skipping geofence: ", ex.what(), LogDebugLevel::Failure);
+        }
+    }
+}
+
+void ASimModeWorldBase::addToSafetyMonitor(msr::airlib::SafetyMonitor* safety_monitor, msr::airlib::VehicleSimApiBase* api)
+{
+    if (api != nullptr && api->getGroundTruthKinematics() != nullptr)
+        safety_monitor->addVehicle(api->getVehicleName(), api->getGroundTruthKinematics());
 }
 
 void ASimModeWorldBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
@@ -126,6 +156,7 @@ void ASimModeWorldBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
     }
 
     physics_world_.reset();
+    safety_monitor_.reset();
     Super::EndPlay(EndPlayReason);
 }
 
@@ -160,8 +191,17 @@ std::unique_ptr<ASimModeWorldBase::PhysicsEngineBase> ASimModeWorldBase::createP
     else if (physics_engine_name == "FastPhysicsEngine") {
         msr::airlib::Settings fast_phys_settings;
         if (msr::airlib::Settings::singleton().getChild("FastPhysicsEngine", fast_phys_settings)) {
-            physics_engine.reset(new msr::airlib::FastPhysicsEngine(
-                fast_phys_settings.getBool("EnableGroundLock", true)));
+            auto* fast_physics_engine = new msr::airlib::FastPhysicsEngine(
+                fast_phys_settings.getBool("EnableGroundLock", true));
+            physics_engine.reset(fast_physics_engine);
+
+            msr::airlib::FastPhysicsEngine::IntegratorParams integrator_params;
+            integrator_params.integrator = msr::airlib::FastPhysicsEngine::toIntegrator(
+                fast_phys_settings.getString("Integrator", "Verlet"));
+            integrator_params.max_sub_step = fast_phys_settings.getDouble("MaxSubStep", integrator_params.max_sub_step);
+            integrator_params.tolerance = fast_phys_settings.getFloat("IntegratorTolerance", integrator_params.tolerance);
+            integrator_params.min_sub_step = fast_phys_settings.getDouble("MinSubStep", integrator_params.min_sub_step);
+            fast_physics_engine->setIntegratorParams(integrator_params);
         }
         else {
             physics_engine.reset(new msr::airlib::FastPhysicsEngine());
@@ -235,6 +275,11 @@ void ASimModeWorldBase::setExtForce(const msr::airlib::Vector3r& ext_force) cons
     physics_engine_->setExtForce(ext_force);
 }
 
+msr::airlib::SafetyMonitor* ASimModeWorldBase::getSafetyMonitor() const
+{
+    return safety_monitor_.get();
+}
+
 void ASimModeWorldBase::updateDebugReport(msr::airlib::StateReporterWrapper& debug_reporter)
 {
     unused(debug_reporter);
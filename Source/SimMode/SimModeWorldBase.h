@@ -39,6 +39,7 @@ public:
 
     virtual void setWind(const msr::airlib::Vector3r& wind) const override;
     virtual void setExtForce(const msr::airlib::Vector3r& ext_force) const override;
+    virtual msr::airlib::SafetyMonitor* getSafetyMonitor() const override;
 
 protected:
     void startAsyncUpdator();
@@ -47,6 +48,8 @@ protected:
 
     void initializeForPlay();
     virtual void registerPhysicsBody(msr::airlib::VehicleSimApiBase* physicsBody) override;
+    void initializeSafetyMonitor(msr::airlib::SafetyMonitor* safety_monitor);
+    void addToSafetyMonitor(msr::airlib::SafetyMonitor* safety_monitor, msr::airlib::VehicleSimApiBase* api);
 
     long long getPhysicsLoopPeriod() const;
     void setPhysicsLoopPeriod(long long period);
@@ -62,6 +65,7 @@ private:
 
 
 private:
+    std::unique_ptr<msr::airlib::SafetyMonitor> safety_monitor_;
     std::unique_ptr<msr::airlib::PhysicsWorld> physics_world_;
     PhysicsEngineBase* physics_engine_ = nullptr;
 
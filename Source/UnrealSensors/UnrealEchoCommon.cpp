@@ -1,5 +1,6 @@
 #include "UnrealEchoCommon.h"
 #include "AirBlueprintLib.h"
+#include "UnrealRaycastBackend.h"
 
 UnrealEchoCommon::UnrealEchoCommon()
 {
@@ -96,39 +97,37 @@ float UnrealEchoCommon::remainingDistance(float signal_attenuation, float total_
 
 void UnrealEchoCommon::traceDirection(uint32 current_sample_index, bool use_indexing, FVector trace_start_position, FVector trace_end_position, msr::airlib::vector<msr::airlib::real_T>& points, msr::airlib::vector<std::string>& groundtruth,
 	msr::airlib::vector<FVector>& draw_points, const NedTransform* ned_transform, const msr::airlib::Pose& pose, float distance_limit, int reflection_limit, float attenuation_limit, float reflection_distance_limit,
-	float reflection_opening_angle, float attenuation_per_distance, float attenuation_per_reflection, TArray<AActor*> ignore_actors, AActor* cur_actor, bool external, bool result_uu,
+	float reflection_opening_angle, float attenuation_per_distance, float attenuation_per_reflection, const msr::airlib::IRaycastBackend* raycast_backend, AActor* cur_actor, bool external, bool result_uu,
 	float draw_time, float line_thickness, bool debug_draw_reflected_paths, bool debug_draw_bounce_lines, bool debug_draw_initial_points, bool debug_draw_reflected_points,
 	bool debug_draw_reflected_lines, bool check_return, bool save_normal, bool save_source, bool only_final_reflection, std::string source_label) {
 	float total_distance = 0.0f;
 	float signal_attenuation = 0.0f;
 	int reflection_count = 0;
 	TArray<FVector> trace_path = TArray<FVector>{};
-	FHitResult trace_hit_result, hit_result_temp, trace_hit_previous;
+	RaycastHit trace_hit_result, hit_result_temp, trace_hit_previous;
 	bool trace_hit;
 	std::string label;
-	AActor* hitActor;
 	FVector previous_direction;
 	bool persistent_lines = false;
 
 	if (draw_time == -1)persistent_lines = true;
 	while (total_distance < distance_limit && reflection_count < reflection_limit && signal_attenuation > attenuation_limit) {
-		trace_hit_result = FHitResult(ForceInit);
-		trace_hit = UAirBlueprintLib::GetObstacleAdv(cur_actor, trace_start_position, trace_end_position, trace_hit_result, ignore_actors, ECC_Visibility, true);
+		trace_hit = raycast_backend->raycast(UnrealRaycastBackend::toVector3r(trace_start_position), UnrealRaycastBackend::toVector3r(trace_end_position), trace_hit_result);
+		FVector impact_point = UnrealRaycastBackend::toFVector(trace_hit_result.point);
 
 		if (debug_draw_bounce_lines) {
 			FColor line_color = FColor::MakeRedToGreenColorFromScalar(1 - (signal_attenuation / attenuation_limit));
-			UAirBlueprintLib::DrawLine(cur_actor->GetWorld(), trace_start_position, trace_hit ? trace_hit_result.ImpactPoint : trace_end_position, line_color, persistent_lines, draw_time, 0, line_thickness);
+			UAirBlueprintLib::DrawLine(cur_actor->GetWorld(), trace_start_position, trace_hit ? impact_point : trace_end_position, line_color, persistent_lines, draw_time, 0, line_thickness);
 		}
 
 		// Stop if nothing was hit to reflect off, or 
 		// if distance between reflections is above distance limit (after emission)
-		if (!trace_hit || (reflection_count > 0 && FVector::Distance(trace_start_position, trace_hit_result.ImpactPoint) > reflection_distance_limit)) {
+		if (!trace_hit || (reflection_count > 0 && FVector::Distance(trace_start_position, impact_point) > reflection_distance_limit)) {
 
 			if (!check_return && only_final_reflection && reflection_count > 0) {
-				hitActor = trace_hit_previous.GetActor();
-				if (hitActor != nullptr)
+				if (!trace_hit_previous.label.empty())
 				{
-					label = TCHAR_TO_UTF8(*hitActor->GetName());
+					label = trace_hit_previous.label;
 				}
 				SavePoint(current_sample_index, use_indexing, trace_hit_previous, previous_direction, signal_attenuation, total_distance, reflection_count, label, ned_transform, pose, points, groundtruth, external, result_uu, save_normal, save_source, source_label);
 			}
@@ -136,7 +135,7 @@ void UnrealEchoCommon::traceDirection(uint32 current_sample_index, bool use_inde
 		}
 
 		if (debug_draw_initial_points && signal_attenuation == 0) {
-			UAirBlueprintLib::DrawPoint(cur_actor->GetWorld(), trace_hit_result.ImpactPoint, 5, FColor::Green, persistent_lines, draw_time);
+			UAirBlueprintLib::DrawPoint(cur_actor->GetWorld(), impact_point, 5, FColor::Green, persistent_lines, draw_time);
 		}
 
 		// Bounce trace
@@ -155,10 +154,9 @@ void UnrealEchoCommon::traceDirection(uint32 current_sample_index, bool use_inde
 			sensor_position = ned_transform->fromLocalNed(pose.position);
 		}
 
-		hitActor = trace_hit_result.GetActor();
-		if (hitActor != nullptr)
+		if (!trace_hit_result.label.empty())
 		{
-			label = TCHAR_TO_UTF8(*hitActor->GetName());
+			label = trace_hit_result.label;
 		}
 
 		if (check_return) {
@@ -181,8 +179,7 @@ void UnrealEchoCommon::traceDirection(uint32 current_sample_index, bool use_inde
 					continue;
 				}
 
-				hit_result_temp = FHitResult(ForceInit);
-				trace_hit = UAirBlueprintLib::GetObstacleAdv(cur_actor, trace_start_position, sensor_position, hit_result_temp, ignore_actors, ECC_Visibility, true);
+				trace_hit = raycast_backend->raycast(UnrealRaycastBackend::toVector3r(trace_start_position), UnrealRaycastBackend::toVector3r(sensor_position), hit_result_temp);
 				if (trace_hit) {  // Hit = no clear LoS to sensor
 					continue;
 				}
@@ -238,30 +235,31 @@ void UnrealEchoCommon::traceDirection(uint32 current_sample_index, bool use_inde
 	}
 }
 
-void UnrealEchoCommon::SavePoint(uint32 current_sample_index, bool use_indexing, FHitResult trace_hit_result, FVector direction, float signal_attenuation, float total_distance, float reflection_count, std::string label,
+void UnrealEchoCommon::SavePoint(uint32 current_sample_index, bool use_indexing, const RaycastHit& trace_hit_result, FVector direction, float signal_attenuation, float total_distance, float reflection_count, std::string label,
 	const NedTransform* ned_transform, const msr::airlib::Pose& pose, msr::airlib::vector<msr::airlib::real_T>& points, msr::airlib::vector<std::string>& groundtruth,
 	bool external, bool result_uu, bool save_normal, bool save_source, std::string source_label) {
 	uint32 step_size = 6;
+	FVector impact_point = UnrealRaycastBackend::toFVector(trace_hit_result.point);
 	if (save_normal)
 		step_size += 3;
 	if (result_uu) {
 		if (use_indexing) {
-			points[current_sample_index * step_size] = trace_hit_result.ImpactPoint.X;
-			points[current_sample_index * step_size + 1] = trace_hit_result.ImpactPoint.Y;
-			points[current_sample_index * step_size + 2] = trace_hit_result.ImpactPoint.Z;
+			points[current_sample_index * step_size] = impact_point.X;
+			points[current_sample_index * step_size + 1] = impact_point.Y;
+			points[current_sample_index * step_size + 2] = impact_point.Z;
 		} {
-			points.emplace_back(trace_hit_result.ImpactPoint.X);
-			points.emplace_back(trace_hit_result.ImpactPoint.Y);
-			points.emplace_back(trace_hit_result.ImpactPoint.Z);
+			points.emplace_back(impact_point.X);
+			points.emplace_back(impact_point.Y);
+			points.emplace_back(impact_point.Z);
 		}
 	}
 	else {
 		Vector3r point_sensor_frame;
 		if (external) {
-			point_sensor_frame = ned_transform->toVector3r(trace_hit_result.ImpactPoint, 0.01, true);
+			point_sensor_frame = ned_transform->toVector3r(impact_point, 0.01, true);
 		}
 		else {
-			point_sensor_frame = ned_transform->toLocalNed(trace_hit_result.ImpactPoint);
+			point_sensor_frame = ned_transform->toLocalNed(impact_point);
 		}
 		point_sensor_frame = VectorMath::transformToBodyFrame(point_sensor_frame, pose, true);
 
@@ -318,12 +316,15 @@ void UnrealEchoCommon::SavePoint(uint32 current_sample_index, bool use_indexing,
 	}
 }
 
-void UnrealEchoCommon::bounceTrace(FVector& trace_start_position, FVector& trace_direction, float& trace_length, const FHitResult& trace_hit_result,
+void UnrealEchoCommon::bounceTrace(FVector& trace_start_position, FVector& trace_direction, float& trace_length, const RaycastHit& trace_hit_result,
 	float& total_distance, float& signal_attenuation, float attenuation_per_distance, float attenuation_per_reflection, float distance_limit, float attenuation_limit,
 	const NedTransform* ned_transform) {
 
+	FVector impact_point = UnrealRaycastBackend::toFVector(trace_hit_result.point);
+	FVector impact_normal = UnrealRaycastBackend::toFVector(trace_hit_result.normal);
+
 	// Attenuate signal
-	float distance_traveled = ned_transform->toNed(FVector::Distance(trace_start_position, trace_hit_result.ImpactPoint));
+	float distance_traveled = ned_transform->toNed(FVector::Distance(trace_start_position, impact_point));
 	applyFreeSpaceLoss(signal_attenuation, total_distance, distance_traveled);
 	signal_attenuation += distance_traveled * attenuation_per_distance;
 	signal_attenuation += attenuation_per_reflection;
@@ -331,9 +332,9 @@ void UnrealEchoCommon::bounceTrace(FVector& trace_start_position, FVector& trace
 	total_distance += distance_traveled;
 
 	// Reflect signal 
-	trace_direction = (trace_hit_result.ImpactPoint - trace_start_position).MirrorByVector(trace_hit_result.ImpactNormal);
+	trace_direction = (impact_point - trace_start_position).MirrorByVector(impact_normal);
 	trace_direction.Normalize();
-	trace_start_position = trace_hit_result.ImpactPoint;
+	trace_start_position = impact_point;
 	trace_length = ned_transform->fromNed(remainingDistance(signal_attenuation, total_distance, attenuation_limit, distance_limit));
 }
 
@@ -5,6 +5,7 @@
 #include "common/Common.hpp"
 #include "Async/ParallelFor.h"
 #include "NedTransform.h"
+#include "UnrealRaycastBackend.h"
 #include "DrawDebugHelpers.h"
 #include "EngineUtils.h"
 #include "Engine/Engine.h"
@@ -39,6 +40,7 @@ UnrealEchoSensor::UnrealEchoSensor(const AirSimSettings::EchoSetting& setting, A
 			if (Actor && Actor != actor && Actor->Tags.Contains(lidar_ignore_tag))ignore_actors_.Add(Actor);
 		}
 	}
+	raycast_backend_ = UnrealRaycastBackend::create(actor_, ignore_actors_, false, sensor_params_.raycast_mesh_file);
 
 	TSubclassOf<APassiveEchoBeacon> passive_beacon_class = APassiveEchoBeacon::StaticClass();
 	TArray<AActor*> found_beacons;
@@ -123,7 +125,7 @@ void UnrealEchoSensor::getPointCloud(const msr::airlib::Pose& sensor_pose, const
 
 					// Shoot trace and get the impact point and remaining attenuation, if any returns
 					UnrealEchoCommon::traceDirection(current_sample_index, true, trace_start_position, trace_end_position, point_cloud, groundtruth, point_cloud_draw_reflected_points_, ned_transform_, sensor_reference_frame_,
-						distance_limit_, reflection_limit_, attenuation_limit_, reflection_distance_limit_, reflection_opening_angle_, attenuation_per_distance_, attenuation_per_reflection_, ignore_actors_, actor_, external_, false,
+						distance_limit_, reflection_limit_, attenuation_limit_, reflection_distance_limit_, reflection_opening_angle_, attenuation_per_distance_, attenuation_per_reflection_, raycast_backend_.get(), actor_, external_, false,
 						draw_time_, line_thickness_, false, false, false, sensor_params_.draw_reflected_points, false);
 				}
 			);
@@ -159,7 +161,7 @@ void UnrealEchoSensor::getPointCloud(const msr::airlib::Pose& sensor_pose, const
 
 				// Shoot trace and get the impact point and remaining attenuation, if any returns
 				UnrealEchoCommon::traceDirection(current_sample_index, false, trace_start_position, trace_end_position, point_cloud, groundtruth, point_cloud_draw_reflected_points_, ned_transform_, sensor_reference_frame_,
-					distance_limit_, reflection_limit_, attenuation_limit_, reflection_distance_limit_, reflection_opening_angle_, attenuation_per_distance_, attenuation_per_reflection_, ignore_actors_, actor_, external_, false,
+					distance_limit_, reflection_limit_, attenuation_limit_, reflection_distance_limit_, reflection_opening_angle_, attenuation_per_distance_, attenuation_per_reflection_, raycast_backend_.get(), actor_, external_, false,
 					draw_time_, line_thickness_, sensor_params_.draw_reflected_paths, sensor_params_.draw_bounce_lines, sensor_params_.draw_initial_points, sensor_params_.draw_reflected_points, sensor_params_.draw_reflected_lines);
 			}
 		}
@@ -205,10 +207,10 @@ void UnrealEchoSensor::getPointCloud(const msr::airlib::Pose& sensor_pose, const
 			float az = FMath::RadiansToDegrees(FMath::Atan2(rotated_local_point_position.y(), rotated_local_point_position.x()));
 			float el = FMath::RadiansToDegrees(FMath::Atan2(rotated_local_point_position.z(), FMath::Sqrt(FMath::Pow(rotated_local_point_position.x(), 2) + FMath::Pow(rotated_local_point_position.y(), 2))));
 			if (az > sensor_params_.sensor_lower_azimuth_limit && az < sensor_params_.sensor_upper_azimuth_limit && el > -sensor_params_.sensor_upper_elevation_limit && el < -sensor_params_.sensor_lower_elevation_limit) {
-				FHitResult trace_hit_result = FHitResult(ForceInit);
-				bool trace_hit = UAirBlueprintLib::GetObstacleAdv(actor_, trace_start_position, passive_point_allowed.point, trace_hit_result, ignore_actors_, ECC_Visibility, true);
+				msr::airlib::IRaycastBackend::RaycastHit trace_hit_result;
+				bool trace_hit = raycast_backend_->raycast(UnrealRaycastBackend::toVector3r(trace_start_position), UnrealRaycastBackend::toVector3r(passive_point_allowed.point), trace_hit_result);
 
-				if (!trace_hit || FVector::Dist(trace_hit_result.ImpactPoint, passive_point_allowed.point) <= 0.1) {
+				if (!trace_hit || FVector::Dist(UnrealRaycastBackend::toFVector(trace_hit_result.point), passive_point_allowed.point) <= 0.1) {
 
 					if (sensor_params_.draw_passive_sources) {
 						UAirBlueprintLib::DrawPoint(actor_->GetWorld(), passive_point_allowed.point, 5, FColor::Red, persistent_lines, draw_time_);
@@ -10,6 +10,7 @@
 #include "Components/StaticMeshComponent.h"
 #include "NedTransform.h"
 #include "AirBlueprintLib.h"
+#include "sensors/raycast/IRaycastBackend.hpp"
 
 // UnrealEchoSensor implementation that uses Ray Tracing in Unreal.
 class UnrealEchoSensor : public msr::airlib::EchoSimple {
@@ -48,6 +49,7 @@ private:
 	msr::airlib::vector<msr::airlib::Vector3r> sample_direction_points_;
 	msr::airlib::Pose sensor_reference_frame_;
 	TArray<AActor*> ignore_actors_;
+	std::unique_ptr<msr::airlib::IRaycastBackend> raycast_backend_;
 
 	const msr::airlib::EchoSimpleParams sensor_params_;
 	const float attenuation_per_distance_;
@@ -6,9 +6,9 @@
 #include "common/Common.hpp"
 #include "Async/ParallelFor.h"
 #include "NedTransform.h"
+#include "UnrealRaycastBackend.h"
 #include "DrawDebugHelpers.h"
 #include "Engine/Engine.h"
-#include <random>
 
 // ctor
 UnrealLidarSensor::UnrealLidarSensor(const AirSimSettings::LidarSetting& setting,
@@ -18,11 +18,11 @@ UnrealLidarSensor::UnrealLidarSensor(const AirSimSettings::LidarSetting& setting
 	draw_time_(1.05f / sensor_params_.horizontal_rotation_frequency),
 	external_(getParams().external)
 {
-	// Seed and initiate noise
-	std::random_device rd;
-	gen_ = std::mt19937(rd());
-	dist_ = std::normal_distribution<float>(0, getParams().min_noise_standard_deviation);
+	// Seed and initiate noise, every laser shot draws its own sample of the stream so the result does not depend on threading
+	range_noise_ = msr::airlib::GaussianNoise(0, getParams().min_noise_standard_deviation,
+		msr::airlib::GaussianNoise::makeSeed(setting.sensor_name, setting.settings.getInt("NoiseSeed", msr::airlib::GaussianNoise::kDefaultSeed)));
 	point_cloud_draw_.clear();
+	raycast_backend_ = UnrealRaycastBackend::create(actor_, TArray<AActor*>(), true, sensor_params_.raycast_mesh_file);
 	createLasers();
 }
 
@@ -186,6 +186,9 @@ bool UnrealLidarSensor::getPointCloud(const msr::airlib::Pose& lidar_pose, const
 			continue;
 		}
 
+		const uint64 noise_base_index = noise_shot_index_ * number_of_lasers;
+		++noise_shot_index_;
+
 		ParallelFor(number_of_lasers, [&](uint32 laser) {
 			float vertical_angle = laser_angles_[laser];
 			uint32 current_point_index = number_of_lasers * current_horizontal_angle_index_ + laser;
@@ -195,7 +198,7 @@ bool UnrealLidarSensor::getPointCloud(const msr::airlib::Pose& lidar_pose, const
 			std::string label;
 
 			// shoot laser and get the impact point, if any
-			if (shootLaser(lidar_pose, vehicle_pose, laser, horizontal_angle, vertical_angle, params, point, label, draw_point))
+			if (shootLaser(lidar_pose, vehicle_pose, laser, horizontal_angle, vertical_angle, params, noise_base_index + laser, point, label, draw_point))
 			{
 				point_cloud[current_point_index * 3] = point.x();
 				point_cloud[current_point_index * 3 + 1] = point.y();
@@ -234,7 +237,7 @@ FVector UnrealLidarSensor::Vector3rToFVector(const Vector3r& input_vector) {
 // simulate shooting a laser via Unreal ray-tracing.
 bool UnrealLidarSensor::shootLaser(const msr::airlib::Pose& lidar_pose, const msr::airlib::Pose& vehicle_pose,
 	const uint32 laser, const float horizontal_angle, const float vertical_angle,
-	const msr::airlib::LidarSimpleParams params, Vector3r &point, std::string &label, FVector& raw_point)
+	const msr::airlib::LidarSimpleParams params, const uint64 noise_index, Vector3r &point, std::string &label, FVector& raw_point)
 {
 	// start position
 	Vector3r start = VectorMath::add(lidar_pose, vehicle_pose).position;
@@ -257,31 +260,27 @@ bool UnrealLidarSensor::shootLaser(const msr::airlib::Pose& lidar_pose, const ms
 	// get ray vector (end position)
 	Vector3r end = VectorMath::rotateVector(VectorMath::front(), ray_q_w, true) * params.range + start;
 
-	FHitResult hit_result = FHitResult(ForceInit);
-	TArray<AActor*> actorArray;
-	//actorArray.Add(actor_);
-	bool is_hit;
+	msr::airlib::IRaycastBackend::RaycastHit hit_result;
+	FVector trace_start, trace_end;
 	if (params.external) {
-		is_hit = UAirBlueprintLib::GetObstacleAdv(actor_, ned_transform_->toFVector(start, 100, true), ned_transform_->toFVector(end, 100, true), hit_result, actorArray, ECC_Visibility, true, true);
+		trace_start = ned_transform_->toFVector(start, 100, true);
+		trace_end = ned_transform_->toFVector(end, 100, true);
 	}
 	else {
-		is_hit = UAirBlueprintLib::GetObstacleAdv(actor_, ned_transform_->fromLocalNed(start), ned_transform_->fromLocalNed(end), hit_result, actorArray, ECC_Visibility, true, true);
-	}
-	bool ignoreMaterial = false;
-	if (hit_result.PhysMaterial != nullptr) {
-		if (hit_result.PhysMaterial.Get()->GetFName().ToString().Contains("Lidar_Ignore_PhysicalMaterial"))
-			ignoreMaterial = true;
+		trace_start = ned_transform_->fromLocalNed(start);
+		trace_end = ned_transform_->fromLocalNed(end);
 	}
+	bool is_hit = raycast_backend_->raycast(UnrealRaycastBackend::toVector3r(trace_start), UnrealRaycastBackend::toVector3r(trace_end), hit_result);
+	bool ignoreMaterial = msr::airlib::Utils::toLower(hit_result.material).find("lidar_ignore_physicalmaterial") != std::string::npos;
 	if (is_hit && !ignoreMaterial)
 	{
 
-		FVector impact_point = hit_result.ImpactPoint;
+		FVector impact_point = UnrealRaycastBackend::toFVector(hit_result.point);
 
 		//Store the name the hit object.
-		auto hitActor = hit_result.GetActor();
-		if (hitActor != nullptr)
+		if (!hit_result.label.empty())
 		{
-			label = TCHAR_TO_UTF8(*hitActor->GetName());
+			label = hit_result.label;
 		}
 
 		raw_point = impact_point;
@@ -293,9 +292,9 @@ bool UnrealLidarSensor::shootLaser(const msr::airlib::Pose& lidar_pose, const ms
 		// If enabled add range noise
 		if (params.generate_noise) {
 			// Add noise based on normal distribution taking into account scaling of noise with distance
-			float distance_noise = dist_(gen_) * (1 + ((hit_result.Distance / 100) / params.range) * (params.noise_distance_scale - 1));
+			float distance_noise = range_noise_.at(noise_index) * (1 + ((hit_result.distance / 100) / params.range) * (params.noise_distance_scale - 1));
 
-			Vector3r impact_point_local = VectorMath::rotateVector(VectorMath::front(), ray_q_w, true) * ((hit_result.Distance / 100) + distance_noise) + start;
+			Vector3r impact_point_local = VectorMath::rotateVector(VectorMath::front(), ray_q_w, true) * ((hit_result.distance / 100) + distance_noise) + start;
 			if (params.external) {
 				impact_point = ned_transform_->fromRelativeNed(impact_point_local);
 			} else {
@@ -8,6 +8,8 @@
 #include "PhysicalMaterials/PhysicalMaterial.h"
 #include "sensors/lidar/LidarSimple.hpp"
 #include "NedTransform.h"
+#include "sensors/raycast/IRaycastBackend.hpp"
+#include "common/GaussianNoise.hpp"
 
 // UnrealLidarSensor implementation that uses Ray Tracing in Unreal.
 // The implementation uses a model similar to CARLA Lidar implementation.
@@ -38,7 +40,7 @@ private:
     void createLasers();
     bool shootLaser(const msr::airlib::Pose& lidar_pose, const msr::airlib::Pose& vehicle_pose,
         const uint32 channel, const float horizontal_angle, const float vertical_angle, 
-        const msr::airlib::LidarSimpleParams params, Vector3r &point, std::string &label, FVector& raw_point);
+        const msr::airlib::LidarSimpleParams params, const uint64 noise_index, Vector3r &point, std::string &label, FVector& raw_point);
     FVector Vector3rToFVector(const Vector3r& input_vector);
 
 private:
@@ -49,10 +51,11 @@ private:
     msr::airlib::vector<FVector> point_cloud_draw_;
 	uint32 current_horizontal_angle_index_ = 0;
 	TArray<float> horizontal_angles_;
-	std::mt19937 gen_;
-	std::normal_distribution<float> dist_;
+	msr::airlib::GaussianNoise range_noise_;
+	uint64 noise_shot_index_ = 0;
     const msr::airlib::LidarSimpleParams sensor_params_;
     msr::airlib::Pose sensor_reference_frame_;
     const float draw_time_;
     const bool external_;
+    std::unique_ptr<msr::airlib::IRaycastBackend> raycast_backend_;
 };
\ No newline at end of file
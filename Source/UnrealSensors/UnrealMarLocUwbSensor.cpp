@@ -12,13 +12,12 @@
 #include "PhysicalMaterials/PhysicalMaterial.h"
 #include "Runtime/Core/Public/Async/ParallelFor.h"
 #include "Beacons/UWBBeacon.h"
+#include "Misc/Crc.h"
 #include <typeinfo>
-#include <mutex>
 #include "Engine/Engine.h"
 #include "common/CommonStructs.hpp"
 
 using std::fill_n;
-std::mutex mtx;
 // ctor
 UnrealMarLocUwbSensor::UnrealMarLocUwbSensor(const AirSimSettings::MarLocUwbSetting& setting, AActor* actor, const NedTransform* ned_transform)
 	: MarLocUwbSimple(setting), actor_(actor), ned_transform_(ned_transform), saved_clockspeed_(1), sensor_params_(getParams()), external_(getParams().external)
@@ -42,6 +41,30 @@ UnrealMarLocUwbSensor::UnrealMarLocUwbSensor(const AirSimSettings::MarLocUwbSett
 		//posi.orientation = It->GetActorRotation();
 		beacon_poses.Add(posi);
 		//beacon_actors.Add(*It);
+
+		UnrealRadioMap::BeaconInfo beacon_info;
+		beacon_info.id = TCHAR_TO_UTF8(*It->GetName());
+		beacon_info.position = It->GetActorLocation();
+		beacon_info.actor = *It;
+		radio_map_beacons.Add(beacon_info);
+	}
+
+	// The map stores one measurement per cell, traced with the sensor facing forward. That only holds for every orientation
+	// when the traces cover the full sphere, a narrower opening angle always traces live.
+	if (sensor_params_.radio_map && sensor_params_.sensor_opening_angle < 360) {
+		UAirBlueprintLib::LogMessageString("Radio map disabled, it needs a sensor opening angle of 360 degrees: ", getName(), LogDebugLevel::Failure);
+	}
+	else if (sensor_params_.radio_map) {
+		float trace_settings[5] = { (float)sample_directions_.size(), sensor_params_.sensor_opening_angle, traceRayMaxDistance, traceRayMaxBounces, traceRayMinSignalStrength };
+		radio_map_.initialize(actor_, "uwb", radio_map_beacons, FCrc::MemCrc32(trace_settings, sizeof(trace_settings)),
+			ned_transform_->fromNed(sensor_params_.radio_map_cell_size), ned_transform_->fromNed(sensor_params_.radio_map_margin),
+			ned_transform_->fromNed(sensor_params_.radio_map_dynamic_radius), sensor_params_.radio_map_validation_fraction,
+			[this, direction_hit_buffers = TArray<TArray<msr::airlib::UWBHit>>()](const FVector& position, TArray<UnrealRadioMap::BeaconSample>& samples) mutable {
+				// Runs on the build thread while the game thread traces live, so it has hit buffers of its own
+				TArray<msr::airlib::UWBHit> hits;
+				traceAllDirections(position, FRotator::ZeroRotator, hits, direction_hit_buffers, true);
+				hitsToSamples(hits, samples);
+			});
 	}
 }
 
@@ -87,47 +110,122 @@ TArray<msr::airlib::Pose> UnrealMarLocUwbSensor::getBeaconActors() {
 }
 
 void UnrealMarLocUwbSensor::updateUWBRays() {
-	const GroundTruth& ground_truth = getGroundTruth();
-	
 	Vector3r sensorBase_local = Vector3r(sensor_reference_frame_.position);
 	FVector sensorBase_global = ned_transform_->fromLocalNed(sensorBase_local);
 
-	//actor_->GetWorld()->GetPhysicsScene()->GetPxScene()->lockRead();
+	// Sensor orientation is the same for every trace direction, so compute it once per update
+	float roll, pitch, yaw;
+	msr::airlib::VectorMath::toEulerianAngle(sensor_reference_frame_.orientation, roll, pitch, yaw);
+	const FRotator sensorOrientationEulerDegree = FRotator(FMath::RadiansToDegrees(pitch), FMath::RadiansToDegrees(yaw), FMath::RadiansToDegrees(roll));
 
 	// Clear oldest UWB Hits 
 	while (beaconsActive_.IsValidIndex(maxUWBHits)) {
 		beaconsActive_.RemoveAt(0);
 	}
-	// Create new log record for newest UWB measurements
+
+	// Create new log record for newest UWB measurements, from the radio map when possible
 	TArray<msr::airlib::UWBHit> UWBHitLog;
+	if (radio_map_.isValid() && radio_map_.lookup(sensorBase_global, radio_map_samples_)) {
+		if (radio_map_.shouldValidate()) {
+			TArray<UnrealRadioMap::BeaconSample> live_samples;
+			traceAllDirections(sensorBase_global, sensorOrientationEulerDegree, UWBHitLog, direction_hit_buffers_);
+			hitsToSamples(UWBHitLog, live_samples);
+			radio_map_.recordValidation(radio_map_samples_, live_samples);
+			UWBHitLog.Reset();
+		}
+		samplesToHits(radio_map_samples_, UWBHitLog);
+	}
+	else {
+		traceAllDirections(sensorBase_global, sensorOrientationEulerDegree, UWBHitLog, direction_hit_buffers_);
+	}
+	beaconsActive_.Add(MoveTemp(UWBHitLog));
+}
 
-	//FVector lineEnd = uwbTraceMaxDistances[direction_count] * FVector(sample_direction[0], sample_direction[1], sample_direction[2]);
-	//UAirBlueprintLib::DrawLine(actor_->GetWorld(), sensorBase_global, lineEnd, FColor::Red, false, 1);
+void UnrealMarLocUwbSensor::traceAllDirections(const FVector& sensor_position, const FRotator& sensor_rotation, TArray<msr::airlib::UWBHit>& UWBHitLog,
+	TArray<TArray<msr::airlib::UWBHit>>& direction_hit_buffers, bool from_radio_map_build) {
+	// Every trace direction writes into its own hit buffer so no locking is needed in the workers
+	const int32 num_directions = sample_directions_.size();
+	direction_hit_buffers.SetNum(num_directions);
 
-	//ParallelFor(sample_directions_.size(), [&](int32 direction_count) {
-	for (int32 direction_count = 0; direction_count< sample_directions_.size(); direction_count++){
-		Vector3r sample_direction = sample_directions_[direction_count];
+	ParallelFor(num_directions, [&](int32 direction_count) {
+		const Vector3r& sample_direction = sample_directions_[direction_count];
+		TArray<msr::airlib::UWBHit>& direction_hits = direction_hit_buffers[direction_count];
+		direction_hits.Reset();
 
-		//FVector trace_direction = ned_transform_->toFVector(VectorMath::rotateVector(sample_direction, sensor_reference_frame_.orientation, 1), 1.0f, true); 
+		FVector lineEnd = uwbTraceMaxDistances[direction_count] * FVector(sample_direction[0], sample_direction[1], sample_direction[2]);
+		lineEnd = sensor_rotation.RotateVector(lineEnd);
+		lineEnd += sensor_position;
 
-		msr::airlib::Quaternionr sensorOrientationQuat = sensor_reference_frame_.orientation;
-		float roll, pitch, yaw;
+		// Trace ray, bounce and add to hitlog if beacon was hit
+		traceDirection(sensor_position, lineEnd, direction_hits, false, sensor_position, from_radio_map_build);
+	});
 
-		msr::airlib::VectorMath::toEulerianAngle(sensorOrientationQuat, roll, pitch, yaw);
-		FRotator sensorOrientationEulerDegree = FRotator(FMath::RadiansToDegrees(pitch), FMath::RadiansToDegrees(yaw), FMath::RadiansToDegrees(roll));
+	// Merge the per-direction buffers in direction order so the log is identical for every run
+	int32 total_hits = UWBHitLog.Num();
+	for (const TArray<msr::airlib::UWBHit>& direction_hits : direction_hit_buffers) {
+		total_hits += direction_hits.Num();
+	}
+	UWBHitLog.Reserve(total_hits);
+	for (const TArray<msr::airlib::UWBHit>& direction_hits : direction_hit_buffers) {
+		UWBHitLog.Append(direction_hits);
+	}
+}
 
-		FVector lineEnd = uwbTraceMaxDistances[direction_count] * FVector(sample_direction[0], sample_direction[1], sample_direction[2]);
-		lineEnd = sensorOrientationEulerDegree.RotateVector(lineEnd);
-		lineEnd += sensorBase_global;
-		//UAirBlueprintLib::DrawLine(actor_->GetWorld(), sensorBase_global, lineEnd, FColor::Red, false, 1);
+void UnrealMarLocUwbSensor::hitsToSamples(const TArray<msr::airlib::UWBHit>& UWBHitLog, TArray<UnrealRadioMap::BeaconSample>& samples) {
+	samples.Reset();
+	samples.SetNum(radio_map_.getBeaconCount());
+	for (const msr::airlib::UWBHit& hit : UWBHitLog) {
+		int beacon_index = radio_map_.getBeaconIndex(hit.beaconID);
+		if (beacon_index < 0) {
+			continue;
+		}
+		UnrealRadioMap::BeaconSample& sample = samples[beacon_index];
+		sample.rssi += hit.rssi;
+		sample.distance += hit.distance;
+		sample.path_count++;
+	}
+	for (UnrealRadioMap::BeaconSample& sample : samples) {
+		if (sample.path_count > 0) {
+			sample.rssi /= sample.path_count;
+			sample.distance /= sample.path_count;
+		}
+	}
+}
 
-		// Trace ray, bounce and add to hitlog if beacon was hit
-		traceDirection(sensorBase_global, lineEnd, &UWBHitLog, 0, 0, 1, 0, sensorBase_global);
-	//});
+void UnrealMarLocUwbSensor::samplesToHits(const TArray<UnrealRadioMap::BeaconSample>& samples, TArray<msr::airlib::UWBHit>& UWBHitLog) {
+	FVector startPos = ned_transform_->getGlobalOffset();
+	for (int beacon_index = 0; beacon_index < samples.Num(); beacon_index++) {
+		const UnrealRadioMap::BeaconSample& sample = samples[beacon_index];
+		const UnrealRadioMap::BeaconInfo& beacon = radio_map_.getBeacon(beacon_index);
+		FVector beaconPos = beacon.position - startPos;
+
+		msr::airlib::UWBHit thisHit;
+		thisHit.beaconID = beacon.id;
+		thisHit.rssi = sample.rssi;
+		thisHit.beaconPosX = beaconPos[0];
+		thisHit.beaconPosY = beaconPos[1];
+		thisHit.beaconPosZ = beaconPos[2];
+		thisHit.distance = sample.distance;
+
+		// One hit per path, like the live trace reports them
+		for (int path = 0; path < sample.path_count; path++) {
+			UWBHitLog.Add(thisHit);
+		}
+	}
+}
+
+void UnrealMarLocUwbSensor::reportState(msr::airlib::StateReporter& reporter) {
+	MarLocUwbSimple::reportState(reporter);
+
+	if (radio_map_.isValid()) {
+		const UnrealRadioMap::Stats& stats = radio_map_.getStats();
+		reporter.writeValue("MarLocUwb-RadioMapHitRate", stats.queries > 0 ? (float)stats.cache_hits / stats.queries : 0.0f);
+		reporter.writeValue("MarLocUwb-RadioMapDynamicFallbacks", stats.dynamic_fallbacks);
+		reporter.writeValue("MarLocUwb-RadioMapOutOfBounds", stats.out_of_bounds_fallbacks);
+		reporter.writeValue("MarLocUwb-RadioMapRssiError", stats.validated_beacons > 0 ? stats.rssi_error_sum / stats.validated_beacons : 0.0);
+		reporter.writeValue("MarLocUwb-RadioMapDistanceError", stats.validated_beacons > 0 ? stats.distance_error_sum / stats.validated_beacons : 0.0);
+		reporter.writeValue("MarLocUwb-RadioMapPresenceMismatches", stats.presence_mismatches);
 	}
-	//actor_->GetWorld()->GetPhysicsScene()->GetPxScene()->unlockRead();
-	//UWBHits.Add(UWBHitLog);
-	beaconsActive_.Add(UWBHitLog);
 }
 
 // Thanks Girmi
@@ -177,77 +275,64 @@ void UnrealMarLocUwbSensor::sampleSphereCap(int num_points, float opening_angle)
 	}
 }
 
-int UnrealMarLocUwbSensor::traceDirection(FVector trace_start_position, FVector trace_end_position, TArray<msr::airlib::UWBHit> *UWBHitLog, float traceRayCurrentDistance, float traceRayCurrentbounces, float traceRayCurrentSignalStrength, bool drawDebug, FVector trace_origin) {
+int UnrealMarLocUwbSensor::traceDirection(FVector trace_start_position, FVector trace_end_position, TArray<msr::airlib::UWBHit>& UWBHitLog, bool drawDebug, FVector trace_origin,
+	bool from_radio_map_build) {
 	FHitResult trace_hit_result;
-	bool trace_hit;
 	TArray<AActor*> ignore_actors_;
+	float traceRayCurrentDistance = 0;
+	float traceRayCurrentSignalStrength = 1;
+	int beacon_hits = 0;
 
 	FVector startPos = this->ned_transform_->getGlobalOffset();
 
-	if (traceRayCurrentDistance < traceRayMaxDistance) {
-		if (traceRayCurrentbounces < traceRayMaxBounces) {
-			if (traceRayCurrentSignalStrength > traceRayMinSignalStrength) {
-				trace_hit_result = FHitResult(ForceInit);
-				trace_hit = UAirBlueprintLib::GetObstacleAdv(actor_, trace_start_position, trace_end_position, trace_hit_result, ignore_actors_, ECC_Visibility, true, true);
-
-				// Stop if nothing was hit to reflect off
-				if (!trace_hit) {
-					if (drawDebug) {
-						UAirBlueprintLib::DrawLine(actor_->GetWorld(), trace_start_position, trace_end_position, FColor::Red, false, 0.1);
-					}
-					return 1;
-				}
-
-				// Bounce trace
-				FVector trace_direction;
-				float trace_length;
-				FVector trace_start_original = trace_start_position;
-				bounceTrace(trace_start_position, trace_direction, trace_length, trace_hit_result, traceRayCurrentDistance, traceRayCurrentSignalStrength);
-				trace_end_position = trace_start_position + trace_direction * trace_length;
-				traceRayCurrentbounces += 1;
-
-				// If beacon was hit
-				if (trace_hit_result.GetActor() != nullptr) {
-					//if ((trace_hit_result.Actor->GetName().Len() >= 9) && (trace_hit_result.Actor->GetName().Left(9) == "uwbBeacon")) {
-					if (trace_hit_result.GetActor()->IsA(AUWBBeacon::StaticClass())) {
-						mtx.lock();
-						auto hitActor = trace_hit_result.GetActor();
-						//FString tmpName, tmpId;
-						//FString tmpName;
-						//UAirBlueprintLib::LogMessageString("Calculating the name", "as BEACON", LogDebugLevel::Informational, 1);
-
-						//std::string aaa (TCHAR_TO_UTF8(*trace_hit_result.Actor->GetFName().ToString().Split(TEXT("_"), &tmpName, &tmpId)));
-						//trace_hit_result.Actor->GetFName().ToString().Split(TEXT("_"), &tmpName, &tmpId);
-						//tmpName = trace_hit_result.Actor->GetFName().ToString();
-						int tmpRssi = (int)traceRayCurrentSignalStrength;
-						FVector beaconPos = trace_hit_result.GetActor()->GetActorLocation() - startPos;
-
-						//FVector beaconPos = trace_hit_result.Actor->
-						//UWBHit thisHit = { FCString::Atoi(*tmpId),  tmpRssi, beaconPos[0], beaconPos[1] , beaconPos[2] };
-						msr::airlib::UWBHit thisHit;
-						
-						thisHit.beaconID = TCHAR_TO_UTF8(*hitActor->GetName());
-						
-						thisHit.rssi = tmpRssi;
-						thisHit.beaconPosX = beaconPos[0];
-						thisHit.beaconPosY = beaconPos[1];
-						thisHit.beaconPosZ = beaconPos[2];
-
-						thisHit.distance = sqrt(pow(beaconPos[0] - trace_origin.X, 2) + pow(beaconPos[1] - trace_origin.Y, 2) + pow(beaconPos[2] - trace_origin.Z, 2)) / 100;
-						UWBHitLog->Add(thisHit);
-						mtx.unlock();
-					}
-				}
-
-				if (drawDebug) {
-					UAirBlueprintLib::DrawLine(actor_->GetWorld(), trace_start_original, trace_start_position, FColor::Red, false, 0.1);
-				}
-
-				return(traceDirection(trace_start_position, trace_end_position, UWBHitLog, traceRayCurrentDistance, traceRayCurrentbounces, traceRayCurrentSignalStrength, drawDebug, trace_origin));
+	// Follow the ray through its reflections until one of the limits is reached
+	for (int traceRayCurrentbounces = 0; traceRayCurrentbounces < traceRayMaxBounces; traceRayCurrentbounces++) {
+		if (traceRayCurrentDistance >= traceRayMaxDistance || traceRayCurrentSignalStrength <= traceRayMinSignalStrength) {
+			break;
+		}
+
+		trace_hit_result = FHitResult(ForceInit);
+		bool trace_hit = from_radio_map_build ? radio_map_.traceScene(trace_start_position, trace_end_position, trace_hit_result)
+			: UAirBlueprintLib::GetObstacleAdv(actor_, trace_start_position, trace_end_position, trace_hit_result, ignore_actors_, ECC_Visibility, true, true);
+
+		// Stop if nothing was hit to reflect off
+		if (!trace_hit) {
+			if (drawDebug) {
+				UAirBlueprintLib::DrawLine(actor_->GetWorld(), trace_start_position, trace_end_position, FColor::Red, false, 0.1);
 			}
+			break;
+		}
+
+		// Bounce trace
+		FVector trace_direction;
+		float trace_length;
+		FVector trace_start_original = trace_start_position;
+		bounceTrace(trace_start_position, trace_direction, trace_length, trace_hit_result, traceRayCurrentDistance, traceRayCurrentSignalStrength);
+		trace_end_position = trace_start_position + trace_direction * trace_length;
+
+		// If beacon was hit, the radio map build only compares the hit actor with the beacons the game thread listed
+		AActor* hitActor = trace_hit_result.GetActor();
+		const int beacon_index = from_radio_map_build ? radio_map_.getBeaconIndex(hitActor) : -1;
+		if (beacon_index >= 0 || (!from_radio_map_build && hitActor != nullptr && hitActor->IsA(AUWBBeacon::StaticClass()))) {
+			const UnrealRadioMap::BeaconInfo* beacon = beacon_index >= 0 ? &radio_map_.getBeacon(beacon_index) : nullptr;
+			FVector beaconPos = (beacon != nullptr ? beacon->position : hitActor->GetActorLocation()) - startPos;
+
+			msr::airlib::UWBHit thisHit;
+			thisHit.beaconID = beacon != nullptr ? beacon->id : std::string(TCHAR_TO_UTF8(*hitActor->GetName()));
+			thisHit.rssi = (int)traceRayCurrentSignalStrength;
+			thisHit.beaconPosX = beaconPos[0];
+			thisHit.beaconPosY = beaconPos[1];
+			thisHit.beaconPosZ = beaconPos[2];
+			thisHit.distance = FVector::Distance(beaconPos, trace_origin) / 100;
+			UWBHitLog.Add(thisHit);
+			beacon_hits++;
+		}
+
+		if (drawDebug) {
+			UAirBlueprintLib::DrawLine(actor_->GetWorld(), trace_start_original, trace_start_position, FColor::Red, false, 0.1);
 		}
 	}
-	return 1;
+	return beacon_hits;
 }
 
 void UnrealMarLocUwbSensor::bounceTrace(FVector &trace_start_position, FVector &trace_direction, float &trace_length, const FHitResult &trace_hit_result, float &total_distance, float &signal_attenuation) {
@@ -0,0 +1,361 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#include "UnrealRadioMap.h"
+#include "AirBlueprintLib.h"
+#include "Engine/World.h"
+#include "HAL/PlatformFileManager.h"
+#include "Async/MappedFileHandle.h"
+#include "Async/Async.h"
+#include "Misc/Paths.h"
+#include "Misc/Crc.h"
+#include <fstream>
+
+UnrealRadioMap::UnrealRadioMap()
+	: actor_(nullptr), world_(nullptr), dynamic_radius_(0), validation_fraction_(0), mapped_file_(nullptr), mapped_region_(nullptr), cells_(nullptr), cancel_build_(false), validation_counter_(0)
+{
+	FMemory::Memzero(header_);
+}
+
+UnrealRadioMap::~UnrealRadioMap()
+{
+	// The trace function belongs to the sensor that owns this map, it must not run after the map is gone
+	cancel_build_ = true;
+	if (build_future_.IsValid()) {
+		build_future_.Wait();
+	}
+	delete mapped_region_;
+	delete mapped_file_;
+}
+
+bool UnrealRadioMap::initialize(AActor* actor, const std::string& sensor_kind, const TArray<BeaconInfo>& beacons, uint32 trace_settings_key,
+	float cell_size, float margin, float dynamic_radius, float validation_fraction, const TraceFunction& trace_function)
+{
+	actor_ = actor;
+	world_ = actor->GetWorld();
+	beacons_ = beacons;
+	dynamic_radius_ = dynamic_radius;
+	validation_fraction_ = validation_fraction;
+	beacon_indices_.Empty();
+	beacon_actor_indices_.Empty();
+	for (int i = 0; i < beacons_.Num(); i++) {
+		beacon_indices_.Add(FString(UTF8_TO_TCHAR(beacons_[i].id.c_str())), i);
+		if (beacons_[i].actor != nullptr) {
+			beacon_actor_indices_.Add(beacons_[i].actor, i);
+		}
+	}
+
+	if (beacons_.Num() == 0 || cell_size <= 0) {
+		return false;
+	}
+
+	computeGrid(cell_size, margin);
+
+	FString map_name = world_->GetMapName();
+	uint32 layout_key = computeLayoutKey(TCHAR_TO_UTF8(*map_name), trace_settings_key, margin);
+	FString path = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("RadioMaps"),
+		FString::Printf(TEXT("%s_%s_%08x.radiomap"), *map_name, UTF8_TO_TCHAR(sensor_kind.c_str()), layout_key));
+	header_.layout_key = layout_key;
+
+	if (mapFile(path, layout_key)) {
+		UAirBlueprintLib::LogMessageString("Radio map loaded: ", TCHAR_TO_UTF8(*path), LogDebugLevel::Informational);
+		return true;
+	}
+
+	// No usable map on disk for this layout, trace it in the background and keep it for the next run
+	UAirBlueprintLib::LogMessageString("Building radio map, cells: ", std::to_string(header_.size_x * header_.size_y * header_.size_z), LogDebugLevel::Informational);
+	build_future_ = Async(EAsyncExecution::Thread, [this, path, layout_key, trace_function]() {
+		build(path, layout_key, trace_function);
+	});
+	return true;
+}
+
+bool UnrealRadioMap::isValid() const
+{
+	return cells_.load(std::memory_order_acquire) != nullptr;
+}
+
+bool UnrealRadioMap::traceScene(const FVector& start, const FVector& end, FHitResult& hit) const
+{
+	hit = FHitResult(ForceInit);
+
+	FCollisionQueryParams trace_params;
+	trace_params.bReturnPhysicalMaterial = true;
+	trace_params.bTraceComplex = true;
+
+	return world_->LineTraceSingleByChannel(hit, start, end, ECC_Visibility, trace_params);
+}
+
+uint32 UnrealRadioMap::computeLayoutKey(const std::string& map_name, uint32 trace_settings_key, float margin) const
+{
+	uint32 key = FCrc::MemCrc32(map_name.data(), map_name.size(), trace_settings_key);
+	for (const BeaconInfo& beacon : beacons_) {
+		key = FCrc::MemCrc32(beacon.id.data(), beacon.id.size(), key);
+		float position[3] = { beacon.position.X, beacon.position.Y, beacon.position.Z };
+		key = FCrc::MemCrc32(position, sizeof(position), key);
+	}
+
+	// Maps of the same beacons with another grid get their own file instead of replacing each other, computeGrid runs first
+	float grid[5] = { header_.cell_size, margin, header_.origin_x, header_.origin_y, header_.origin_z };
+	key = FCrc::MemCrc32(grid, sizeof(grid), key);
+	int32 grid_size[3] = { header_.size_x, header_.size_y, header_.size_z };
+	return FCrc::MemCrc32(grid_size, sizeof(grid_size), key);
+}
+
+void UnrealRadioMap::computeGrid(float cell_size, float margin)
+{
+	FBox bounds(ForceInit);
+	for (const BeaconInfo& beacon : beacons_) {
+		bounds += beacon.position;
+	}
+	bounds = bounds.ExpandBy(margin);
+
+	FVector extent = bounds.GetSize();
+	header_.magic = kFileMagic;
+	header_.version = kFileVersion;
+	header_.num_beacons = beacons_.Num();
+	header_.size_x = FMath::Max(2, FMath::CeilToInt(extent.X / cell_size) + 1);
+	header_.size_y = FMath::Max(2, FMath::CeilToInt(extent.Y / cell_size) + 1);
+	header_.size_z = FMath::Max(2, FMath::CeilToInt(extent.Z / cell_size) + 1);
+	header_.origin_x = bounds.Min.X;
+	header_.origin_y = bounds.Min.Y;
+	header_.origin_z = bounds.Min.Z;
+	header_.cell_size = cell_size;
+}
+
+void UnrealRadioMap::build(const FString& path, uint32 layout_key, const TraceFunction& trace_function)
+{
+	const int num_cells = header_.size_x * header_.size_y * header_.size_z;
+	const int num_beacons = header_.num_beacons;
+	built_cells_.SetNumUninitialized(num_cells * num_beacons);
+
+	TArray<BeaconSample> samples;
+	int cell_index = 0;
+	for (int z = 0; z < header_.size_z; z++) {
+		for (int y = 0; y < header_.size_y; y++) {
+			for (int x = 0; x < header_.size_x; x++) {
+				if (cancel_build_) {
+					return;
+				}
+
+				FVector position(header_.origin_x + x * header_.cell_size, header_.origin_y + y * header_.cell_size, header_.origin_z + z * header_.cell_size);
+				samples.Reset();
+				samples.SetNum(num_beacons);
+				trace_function(position, samples);
+
+				for (int b = 0; b < num_beacons; b++) {
+					CellSample& cell_sample = built_cells_[cell_index * num_beacons + b];
+					cell_sample.rssi = samples[b].rssi;
+					cell_sample.distance = samples[b].distance;
+					cell_sample.path_count = samples[b].path_count;
+				}
+				cell_index++;
+			}
+		}
+	}
+
+	// Publish the mapped file when it could be written, the traced cells otherwise. Log messages belong to the game thread.
+	const bool is_written = writeFile(path) && mapFile(path, layout_key);
+	if (is_written) {
+		built_cells_.Empty();
+	}
+	else {
+		cells_.store(built_cells_.GetData(), std::memory_order_release);
+	}
+	AsyncTask(ENamedThreads::GameThread, [is_written, path]() {
+		if (is_written) {
+			UAirBlueprintLib::LogMessageString("Radio map built: ", TCHAR_TO_UTF8(*path), LogDebugLevel::Informational);
+		}
+		else {
+			UAirBlueprintLib::LogMessageString("Radio map could not be written, keeping it in memory: ", TCHAR_TO_UTF8(*path), LogDebugLevel::Failure);
+		}
+	});
+}
+
+bool UnrealRadioMap::writeFile(const FString& path) const
+{
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(path), true);
+
+	std::ofstream file(TCHAR_TO_UTF8(*path), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		return false;
+	}
+
+	file.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+	for (const BeaconInfo& beacon : beacons_) {
+		char id[kBeaconIdLength] = {};
+		FCStringAnsi::Strncpy(id, beacon.id.c_str(), kBeaconIdLength);
+		float position[3] = { beacon.position.X, beacon.position.Y, beacon.position.Z };
+		file.write(id, kBeaconIdLength);
+		file.write(reinterpret_cast<const char*>(position), sizeof(position));
+	}
+	file.write(reinterpret_cast<const char*>(built_cells_.GetData()), built_cells_.Num() * sizeof(CellSample));
+	return file.good();
+}
+
+bool UnrealRadioMap::mapFile(const FString& path, uint32 layout_key)
+{
+	if (!FPaths::FileExists(path)) {
+		return false;
+	}
+
+	IMappedFileHandle* mapped_file = FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*path);
+	if (mapped_file == nullptr) {
+		return false;
+	}
+	IMappedFileRegion* mapped_region = mapped_file->MapRegion();
+	if (mapped_region == nullptr || mapped_region->GetMappedSize() < (int64)sizeof(FileHeader)) {
+		delete mapped_region;
+		delete mapped_file;
+		return false;
+	}
+
+	// Only accept a file that was traced for exactly this map, beacon layout and grid
+	const FileHeader* header = reinterpret_cast<const FileHeader*>(mapped_region->GetMappedPtr());
+	const int64 beacon_table_size = (int64)header->num_beacons * (kBeaconIdLength + 3 * sizeof(float));
+	const int64 cells_size = (int64)header->size_x * header->size_y * header->size_z * header->num_beacons * sizeof(CellSample);
+	if (header->magic != kFileMagic || header->version != kFileVersion || header->layout_key != layout_key ||
+		header->num_beacons != header_.num_beacons || header->size_x != header_.size_x || header->size_y != header_.size_y ||
+		header->size_z != header_.size_z || header->cell_size != header_.cell_size ||
+		mapped_region->GetMappedSize() < (int64)sizeof(FileHeader) + beacon_table_size + cells_size) {
+		delete mapped_region;
+		delete mapped_file;
+		return false;
+	}
+
+	delete mapped_region_;
+	delete mapped_file_;
+	mapped_file_ = mapped_file;
+	mapped_region_ = mapped_region;
+	cells_.store(reinterpret_cast<const CellSample*>(mapped_region->GetMappedPtr() + sizeof(FileHeader) + beacon_table_size), std::memory_order_release);
+	return true;
+}
+
+bool UnrealRadioMap::isNearDynamicActor(const FVector& position) const
+{
+	if (dynamic_radius_ <= 0) {
+		return false;
+	}
+
+	FCollisionObjectQueryParams object_params;
+	object_params.AddObjectTypesToQuery(ECC_WorldDynamic);
+	object_params.AddObjectTypesToQuery(ECC_Pawn);
+	object_params.AddObjectTypesToQuery(ECC_PhysicsBody);
+	object_params.AddObjectTypesToQuery(ECC_Vehicle);
+
+	FCollisionQueryParams query_params;
+	query_params.AddIgnoredActor(actor_);
+
+	return world_->OverlapAnyTestByObjectType(position, FQuat::Identity, object_params, FCollisionShape::MakeSphere(dynamic_radius_), query_params);
+}
+
+const UnrealRadioMap::CellSample& UnrealRadioMap::cell(const CellSample* cells, int x, int y, int z, int beacon_index) const
+{
+	return cells[((z * header_.size_y + y) * header_.size_x + x) * header_.num_beacons + beacon_index];
+}
+
+bool UnrealRadioMap::lookup(const FVector& position, TArray<BeaconSample>& samples)
+{
+	stats_.queries++;
+
+	// Null while the map is still being built
+	const CellSample* cells = cells_.load(std::memory_order_acquire);
+	float gx = (position.X - header_.origin_x) / header_.cell_size;
+	float gy = (position.Y - header_.origin_y) / header_.cell_size;
+	float gz = (position.Z - header_.origin_z) / header_.cell_size;
+	if (cells == nullptr || gx < 0 || gy < 0 || gz < 0 || gx > header_.size_x - 1 || gy > header_.size_y - 1 || gz > header_.size_z - 1) {
+		stats_.out_of_bounds_fallbacks++;
+		return false;
+	}
+	if (isNearDynamicActor(position)) {
+		stats_.dynamic_fallbacks++;
+		return false;
+	}
+
+	int x0 = FMath::Min((int)gx, header_.size_x - 2);
+	int y0 = FMath::Min((int)gy, header_.size_y - 2);
+	int z0 = FMath::Min((int)gz, header_.size_z - 2);
+	float fx = gx - x0, fy = gy - y0, fz = gz - z0;
+
+	// Trilinear interpolation, RSSI and distance only over the corners that actually reached the beacon
+	samples.SetNum(header_.num_beacons);
+	for (uint32 b = 0; b < header_.num_beacons; b++) {
+		float weight_sum = 0, rssi = 0, distance = 0, path_count = 0;
+		for (int corner = 0; corner < 8; corner++) {
+			int dx = corner & 1, dy = (corner >> 1) & 1, dz = (corner >> 2) & 1;
+			float weight = (dx ? fx : 1 - fx) * (dy ? fy : 1 - fy) * (dz ? fz : 1 - fz);
+			const CellSample& cell_sample = cell(cells, x0 + dx, y0 + dy, z0 + dz, b);
+			path_count += weight * cell_sample.path_count;
+			if (cell_sample.path_count > 0) {
+				weight_sum += weight;
+				rssi += weight * cell_sample.rssi;
+				distance += weight * cell_sample.distance;
+			}
+		}
+
+		BeaconSample& sample = samples[b];
+		sample.path_count = FMath::RoundToInt(path_count);
+		if (sample.path_count > 0 && weight_sum > 0) {
+			sample.rssi = rssi / weight_sum;
+			sample.distance = distance / weight_sum;
+		}
+		else {
+			sample = BeaconSample();
+		}
+	}
+
+	stats_.cache_hits++;
+	return true;
+}
+
+bool UnrealRadioMap::shouldValidate()
+{
+	if (validation_fraction_ <= 0) {
+		return false;
+	}
+	uint64 interval = FMath::Max<uint64>(1, (uint64)FMath::RoundToInt(1.0f / validation_fraction_));
+	return (validation_counter_++ % interval) == 0;
+}
+
+void UnrealRadioMap::recordValidation(const TArray<BeaconSample>& cached, const TArray<BeaconSample>& live)
+{
+	stats_.validations++;
+	for (int b = 0; b < cached.Num() && b < live.Num(); b++) {
+		bool cached_present = cached[b].path_count > 0;
+		bool live_present = live[b].path_count > 0;
+		if (cached_present != live_present) {
+			stats_.presence_mismatches++;
+		}
+		else if (cached_present) {
+			stats_.validated_beacons++;
+			stats_.rssi_error_sum += FMath::Abs(cached[b].rssi - live[b].rssi);
+			stats_.distance_error_sum += FMath::Abs(cached[b].distance - live[b].distance);
+		}
+	}
+}
+
+int UnrealRadioMap::getBeaconIndex(const std::string& beacon_id) const
+{
+	const int* index = beacon_indices_.Find(FString(UTF8_TO_TCHAR(beacon_id.c_str())));
+	return index != nullptr ? *index : -1;
+}
+
+int UnrealRadioMap::getBeaconIndex(const AActor* beacon_actor) const
+{
+	const int* index = beacon_actor != nullptr ? beacon_actor_indices_.Find(beacon_actor) : nullptr;
+	return index != nullptr ? *index : -1;
+}
+
+const UnrealRadioMap::BeaconInfo& UnrealRadioMap::getBeacon(int beacon_index) const
+{
+	return beacons_[beacon_index];
+}
+
+int UnrealRadioMap::getBeaconCount() const
+{
+	return beacons_.Num();
+}
+
+const UnrealRadioMap::Stats& UnrealRadioMap::getStats() const
+{
+	return stats_;
+}
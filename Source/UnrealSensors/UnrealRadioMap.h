@@ -0,0 +1,132 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Async/Future.h"
+#include "common/Common.hpp"
+#include <atomic>
+#include <functional>
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+struct FHitResult;
+
+// Precomputed propagation map for a set of static beacons (UWB or Wifi).
+// The volume around the beacons is sampled on a regular grid. For every cell and every beacon the map stores
+// the mean RSSI, the mean distance and the number of traced paths that reached the beacon from that cell.
+// The map is traced once, written to disk and memory-mapped on every later run with the same map and beacon layout.
+// Tracing runs on a worker thread, the sensors trace live until it is done. Afterwards they interpolate the map at
+// their position and only trace live when a dynamic actor is close by. The worker only runs scene queries, the world
+// and the beacon actors and locations are taken on the game thread when the map is initialized.
+class AIRSIM_API UnrealRadioMap
+{
+public:
+	struct BeaconInfo {
+		std::string id;
+		FVector position;		// Unreal world location
+		const AActor* actor = nullptr;	// matched against trace hits, never dereferenced by the build worker
+	};
+
+	struct BeaconSample {
+		float rssi = 0;
+		float distance = 0;
+		int path_count = 0;
+	};
+
+	struct Stats {
+		uint64 queries = 0;
+		uint64 cache_hits = 0;
+		uint64 dynamic_fallbacks = 0;
+		uint64 out_of_bounds_fallbacks = 0;
+		uint64 validations = 0;
+		uint64 validated_beacons = 0;
+		uint64 presence_mismatches = 0;
+		double rssi_error_sum = 0;
+		double distance_error_sum = 0;
+	};
+
+	// Traces a full measurement at the given world position and fills one sample per beacon. Called from the build
+	// worker thread, it must not share state with the traces of the game thread. It may only trace with traceScene and
+	// must take beacon ids and locations from getBeaconIndex(const AActor*) and getBeacon, not from the actors.
+	typedef std::function<void(const FVector& position, TArray<BeaconSample>& samples)> TraceFunction;
+
+public:
+	UnrealRadioMap();
+	~UnrealRadioMap();
+
+	// Owns the mapped file and the build thread
+	UnrealRadioMap(const UnrealRadioMap&) = delete;
+	UnrealRadioMap& operator=(const UnrealRadioMap&) = delete;
+
+	// Returns false when there is no map to load or build, otherwise the map becomes valid once it is loaded or built
+	bool initialize(AActor* actor, const std::string& sensor_kind, const TArray<BeaconInfo>& beacons, uint32 trace_settings_key,
+		float cell_size, float margin, float dynamic_radius, float validation_fraction, const TraceFunction& trace_function);
+	bool isValid() const;
+
+	// Line trace in the world the map was initialized in, with the channel and parameters of the live sensor traces
+	bool traceScene(const FVector& start, const FVector& end, FHitResult& hit) const;
+
+	// Interpolates the samples at the given world position. Returns false when the caller has to trace live instead.
+	bool lookup(const FVector& position, TArray<BeaconSample>& samples);
+	bool shouldValidate();
+	void recordValidation(const TArray<BeaconSample>& cached, const TArray<BeaconSample>& live);
+
+	int getBeaconIndex(const std::string& beacon_id) const;
+	// Index of the beacon a trace hit, -1 for any other actor. Only compares the pointer, safe on the build worker.
+	int getBeaconIndex(const AActor* beacon_actor) const;
+	const BeaconInfo& getBeacon(int beacon_index) const;
+	int getBeaconCount() const;
+	const Stats& getStats() const;
+
+private:
+	struct CellSample {
+		float rssi;
+		float distance;
+		float path_count;
+	};
+
+	struct FileHeader {
+		uint32 magic;
+		uint32 version;
+		uint32 layout_key;
+		uint32 num_beacons;
+		int32 size_x, size_y, size_z;
+		float origin_x, origin_y, origin_z;
+		float cell_size;
+	};
+
+	static constexpr uint32 kFileMagic = 0x50414d52; // "RMAP"
+	static constexpr uint32 kFileVersion = 1;
+	static constexpr int kBeaconIdLength = 64;
+
+	uint32 computeLayoutKey(const std::string& map_name, uint32 trace_settings_key, float margin) const;
+	void computeGrid(float cell_size, float margin);
+	void build(const FString& path, uint32 layout_key, const TraceFunction& trace_function);
+	bool writeFile(const FString& path) const;
+	bool mapFile(const FString& path, uint32 layout_key);
+	bool isNearDynamicActor(const FVector& position) const;
+	const CellSample& cell(const CellSample* cells, int x, int y, int z, int beacon_index) const;
+
+private:
+	AActor* actor_;
+	UWorld* world_;
+	TArray<BeaconInfo> beacons_;
+	TMap<FString, int> beacon_indices_;
+	TMap<const AActor*, int> beacon_actor_indices_;
+	FileHeader header_;
+	float dynamic_radius_;
+	float validation_fraction_;
+
+	// Written by the build worker until cells_ is published, the destructor waits for it
+	TArray<CellSample> built_cells_;
+	IMappedFileHandle* mapped_file_;
+	IMappedFileRegion* mapped_region_;
+	std::atomic<const CellSample*> cells_;
+	TFuture<void> build_future_;
+	std::atomic<bool> cancel_build_;
+
+	Stats stats_;
+	uint64 validation_counter_;
+};
@@ -0,0 +1,97 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#include "UnrealRaycastBackend.h"
+#include "AirBlueprintLib.h"
+#include "Async/ParallelFor.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "sensors/raycast/BvhRaycastBackend.hpp"
+
+UnrealRaycastBackend::UnrealRaycastBackend(const AActor* actor, const TArray<AActor*>& ignore_actors, bool return_material,
+	ECollisionChannel collision_channel, bool trace_complex)
+	: actor_(actor), ignore_actors_(ignore_actors), return_material_(return_material), collision_channel_(collision_channel), trace_complex_(trace_complex)
+{
+}
+
+std::unique_ptr<msr::airlib::IRaycastBackend> UnrealRaycastBackend::create(const AActor* actor, const TArray<AActor*>& ignore_actors, bool return_material, const std::string& mesh_file)
+{
+	if (!mesh_file.empty()) {
+		std::unique_ptr<msr::airlib::BvhRaycastBackend> bvh_backend(new msr::airlib::BvhRaycastBackend());
+		if (bvh_backend->loadMeshFile(mesh_file)) {
+			UAirBlueprintLib::LogMessageString("Raycast backend: BVH over ", std::to_string(bvh_backend->getTriangleCount()) + " triangles from " + mesh_file, LogDebugLevel::Informational);
+			return std::move(bvh_backend);
+		}
+		UAirBlueprintLib::LogMessageString("Raycast backend: could not load mesh file, using Unreal: ", mesh_file, LogDebugLevel::Failure);
+	}
+	return std::unique_ptr<msr::airlib::IRaycastBackend>(new UnrealRaycastBackend(actor, ignore_actors, return_material));
+}
+
+bool UnrealRaycastBackend::raycast(const msr::airlib::Vector3r& start, const msr::airlib::Vector3r& end, RaycastHit& hit) const
+{
+	FHitResult hit_result(ForceInit);
+	hit = RaycastHit();
+	if (!UAirBlueprintLib::GetObstacleAdv(actor_, toFVector(start), toFVector(end), hit_result, ignore_actors_, collision_channel_, trace_complex_, return_material_))
+		return false;
+
+	toRaycastHit(hit_result, hit);
+	return true;
+}
+
+int UnrealRaycastBackend::raycastMulti(const msr::airlib::Vector3r& start, const msr::airlib::Vector3r& end, msr::airlib::vector<RaycastHit>& hits, int max_hits) const
+{
+	// Line traces stop at the first blocking hit, so step through the surfaces one trace at a time
+	constexpr float kSurfaceOffset = 0.1f;
+	hits.clear();
+
+	const msr::airlib::Vector3r direction = (end - start).normalized();
+	const float length = (end - start).norm();
+	float travelled = 0;
+	msr::airlib::Vector3r trace_start = start;
+	while (static_cast<int>(hits.size()) < max_hits && travelled < length) {
+		RaycastHit hit;
+		if (!raycast(trace_start, end, hit))
+			break;
+
+		travelled += hit.distance;
+		hit.distance = travelled;
+		hits.push_back(hit);
+
+		travelled += kSurfaceOffset;
+		trace_start = start + direction * travelled;
+	}
+	return static_cast<int>(hits.size());
+}
+
+void UnrealRaycastBackend::raycastBatch(const msr::airlib::vector<Ray>& rays, msr::airlib::vector<RaycastHit>& hits) const
+{
+	hits.resize(rays.size());
+	ParallelFor(rays.size(), [&](int32 ray_index) {
+		raycast(rays[ray_index].start, rays[ray_index].end, hits[ray_index]);
+	});
+}
+
+void UnrealRaycastBackend::toRaycastHit(const FHitResult& hit_result, RaycastHit& hit) const
+{
+	hit.is_hit = true;
+	hit.point = toVector3r(hit_result.ImpactPoint);
+	hit.normal = toVector3r(hit_result.ImpactNormal);
+	hit.distance = hit_result.Distance;
+
+	AActor* hit_actor = hit_result.GetActor();
+	if (hit_actor != nullptr) {
+		hit.label = TCHAR_TO_UTF8(*hit_actor->GetName());
+		hit.label_id = hit_actor->GetUniqueID();
+	}
+	if (hit_result.PhysMaterial.IsValid()) {
+		hit.material = TCHAR_TO_UTF8(*hit_result.PhysMaterial->GetFName().ToString());
+	}
+}
+
+FVector UnrealRaycastBackend::toFVector(const msr::airlib::Vector3r& vector)
+{
+	return FVector(vector.x(), vector.y(), vector.z());
+}
+
+msr::airlib::Vector3r UnrealRaycastBackend::toVector3r(const FVector& vector)
+{
+	return msr::airlib::Vector3r(vector.X, vector.Y, vector.Z);
+}
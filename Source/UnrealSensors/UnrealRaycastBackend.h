@@ -0,0 +1,37 @@
+// Developed by Cosys-Lab, University of Antwerp
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "common/Common.hpp"
+#include "sensors/raycast/IRaycastBackend.hpp"
+
+// IRaycastBackend implementation that answers ray queries with line traces in the Unreal world.
+// Positions are Unreal world coordinates (cm) stored in Vector3r without any axis conversion.
+class AIRSIM_API UnrealRaycastBackend : public msr::airlib::IRaycastBackend
+{
+public:
+	UnrealRaycastBackend(const AActor* actor, const TArray<AActor*>& ignore_actors = TArray<AActor*>(), bool return_material = false,
+		ECollisionChannel collision_channel = ECC_Visibility, bool trace_complex = true);
+
+	virtual bool raycast(const msr::airlib::Vector3r& start, const msr::airlib::Vector3r& end, RaycastHit& hit) const override;
+	virtual int raycastMulti(const msr::airlib::Vector3r& start, const msr::airlib::Vector3r& end, msr::airlib::vector<RaycastHit>& hits, int max_hits = 16) const override;
+	virtual void raycastBatch(const msr::airlib::vector<Ray>& rays, msr::airlib::vector<RaycastHit>& hits) const override;
+
+	// Uses the BVH backend over the meshes in mesh_file when it loads, the Unreal world otherwise
+	static std::unique_ptr<msr::airlib::IRaycastBackend> create(const AActor* actor, const TArray<AActor*>& ignore_actors, bool return_material, const std::string& mesh_file);
+
+	static FVector toFVector(const msr::airlib::Vector3r& vector);
+	static msr::airlib::Vector3r toVector3r(const FVector& vector);
+
+private:
+	void toRaycastHit(const FHitResult& hit_result, RaycastHit& hit) const;
+
+private:
+	const AActor* actor_;
+	mutable TArray<AActor*> ignore_actors_;	// only read by the line traces, GetObstacleAdv takes it by reference
+	bool return_material_;
+	ECollisionChannel collision_channel_;
+	bool trace_complex_;
+};
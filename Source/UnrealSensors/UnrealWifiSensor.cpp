@@ -12,6 +12,7 @@
 #include "PhysicalMaterials/PhysicalMaterial.h"
 #include "Runtime/Core/Public/Async/ParallelFor.h"
 #include "Beacons/WifiBeacon.h"
+#include "Misc/Crc.h"
 #include <typeinfo>
 #include "Engine/Engine.h"
 #include <mutex>
@@ -42,6 +43,29 @@ UnrealWifiSensor::UnrealWifiSensor(const AirSimSettings::WifiSetting& setting, A
 		//posi.orientation = It->GetActorRotation();
 		beacon_poses.Add(posi);
 		//beacon_actors.Add(*It);
+
+		UnrealRadioMap::BeaconInfo beacon_info;
+		beacon_info.id = TCHAR_TO_UTF8(*It->GetName());
+		beacon_info.position = It->GetActorLocation();
+		beacon_info.actor = *It;
+		radio_map_beacons.Add(beacon_info);
+	}
+
+	// The map stores one measurement per cell, traced with the sensor facing forward. That only holds for every orientation
+	// when the traces cover the full sphere, a narrower opening angle always traces live.
+	if (sensor_params_.radio_map && sensor_params_.sensor_opening_angle < 360) {
+		UAirBlueprintLib::LogMessageString("Radio map disabled, it needs a sensor opening angle of 360 degrees: ", getName(), LogDebugLevel::Failure);
+	}
+	else if (sensor_params_.radio_map) {
+		float trace_settings[5] = { (float)sample_directions_.size(), sensor_params_.sensor_opening_angle, traceRayMaxDistance, traceRayMaxBounces, traceRayMinSignalStrength };
+		radio_map_.initialize(actor_, "wifi", radio_map_beacons, FCrc::MemCrc32(trace_settings, sizeof(trace_settings)),
+			ned_transform_->fromNed(sensor_params_.radio_map_cell_size), ned_transform_->fromNed(sensor_params_.radio_map_margin),
+			ned_transform_->fromNed(sensor_params_.radio_map_dynamic_radius), sensor_params_.radio_map_validation_fraction,
+			[this](const FVector& position, TArray<UnrealRadioMap::BeaconSample>& samples) {
+				TArray<msr::airlib::WifiHit> hits;
+				traceAllDirections(position, FRotator::ZeroRotator, hits, true);
+				hitsToSamples(hits, samples);
+			});
 	}
 }
 
@@ -87,43 +111,104 @@ TArray<msr::airlib::Pose> UnrealWifiSensor::getBeaconActors() {
 }
 
 void UnrealWifiSensor::updateWifiRays() {
-	const GroundTruth& ground_truth = getGroundTruth();
-	
 	Vector3r sensorBase_local = Vector3r(sensor_reference_frame_.position);
 	FVector sensorBase_global = ned_transform_->fromLocalNed(sensorBase_local);
 
-	//actor_->GetWorld()->GetPhysicsScene()->GetPxScene()->lockRead();
+	float roll, pitch, yaw;
+	msr::airlib::VectorMath::toEulerianAngle(sensor_reference_frame_.orientation, roll, pitch, yaw);
+	const FRotator sensorOrientationEulerDegree = FRotator(FMath::RadiansToDegrees(pitch), FMath::RadiansToDegrees(yaw), FMath::RadiansToDegrees(roll));
 
 	// Clear oldest Wifi Hits 
 	while (beaconsActive_.IsValidIndex(maxWifiHits)) {
 		beaconsActive_.RemoveAt(0);
 	}
-	// Create new log record for newest Wifi measurements
+
+	// Create new log record for newest Wifi measurements, from the radio map when possible
 	TArray<msr::airlib::WifiHit> WifiHitLog;
+	if (radio_map_.isValid() && radio_map_.lookup(sensorBase_global, radio_map_samples_)) {
+		if (radio_map_.shouldValidate()) {
+			TArray<UnrealRadioMap::BeaconSample> live_samples;
+			traceAllDirections(sensorBase_global, sensorOrientationEulerDegree, WifiHitLog);
+			hitsToSamples(WifiHitLog, live_samples);
+			radio_map_.recordValidation(radio_map_samples_, live_samples);
+			WifiHitLog.Reset();
+		}
+		samplesToHits(radio_map_samples_, WifiHitLog);
+	}
+	else {
+		traceAllDirections(sensorBase_global, sensorOrientationEulerDegree, WifiHitLog);
+	}
+	beaconsActive_.Add(WifiHitLog);
+}
 
-	//ParallelFor(sample_directions_.size(), [&](int32 direction_count) {
-	for (int32 direction_count = 0; direction_count< sample_directions_.size(); direction_count++){
+void UnrealWifiSensor::traceAllDirections(const FVector& sensor_position, const FRotator& sensor_rotation, TArray<msr::airlib::WifiHit>& WifiHitLog, bool from_radio_map_build) {
+	for (int32 direction_count = 0; direction_count < sample_directions_.size(); direction_count++) {
 		Vector3r sample_direction = sample_directions_[direction_count];
 
-		//FVector trace_direction = ned_transform_->toFVector(VectorMath::rotateVector(sample_direction, sensor_reference_frame_.orientation, 1), 1.0f, true); 
+		FVector lineEnd = wifiTraceMaxDistances[direction_count] * FVector(sample_direction[0], sample_direction[1], sample_direction[2]);
+		lineEnd = sensor_rotation.RotateVector(lineEnd);
+		lineEnd += sensor_position;
 
-		msr::airlib::Quaternionr sensorOrientationQuat = sensor_reference_frame_.orientation;
-		float roll, pitch, yaw;
+		// Trace ray, bounce and add to hitlog if beacon was hit
+		traceDirection(sensor_position, lineEnd, &WifiHitLog, 0, 0, 1, 0, sensor_position, from_radio_map_build);
+	}
+}
 
-		msr::airlib::VectorMath::toEulerianAngle(sensorOrientationQuat, roll, pitch, yaw);
-		FRotator sensorOrientationEulerDegree = FRotator(FMath::RadiansToDegrees(pitch), FMath::RadiansToDegrees(yaw), FMath::RadiansToDegrees(roll));
+void UnrealWifiSensor::hitsToSamples(const TArray<msr::airlib::WifiHit>& WifiHitLog, TArray<UnrealRadioMap::BeaconSample>& samples) {
+	samples.Reset();
+	samples.SetNum(radio_map_.getBeaconCount());
+	for (const msr::airlib::WifiHit& hit : WifiHitLog) {
+		int beacon_index = radio_map_.getBeaconIndex(hit.beaconID);
+		if (beacon_index < 0) {
+			continue;
+		}
+		UnrealRadioMap::BeaconSample& sample = samples[beacon_index];
+		sample.rssi += hit.rssi;
+		sample.distance += hit.distance;
+		sample.path_count++;
+	}
+	for (UnrealRadioMap::BeaconSample& sample : samples) {
+		if (sample.path_count > 0) {
+			sample.rssi /= sample.path_count;
+			sample.distance /= sample.path_count;
+		}
+	}
+}
 
-		FVector lineEnd = wifiTraceMaxDistances[direction_count] * FVector(sample_direction[0], sample_direction[1], sample_direction[2]);
-		lineEnd = sensorOrientationEulerDegree.RotateVector(lineEnd);
-		lineEnd += sensorBase_global;
-		//UAirBlueprintLib::DrawLine(actor_->GetWorld(), sensorBase_global, lineEnd, FColor::Red, false, 1);
+void UnrealWifiSensor::samplesToHits(const TArray<UnrealRadioMap::BeaconSample>& samples, TArray<msr::airlib::WifiHit>& WifiHitLog) {
+	FVector startPos = ned_transform_->getGlobalOffset();
+	for (int beacon_index = 0; beacon_index < samples.Num(); beacon_index++) {
+		const UnrealRadioMap::BeaconSample& sample = samples[beacon_index];
+		const UnrealRadioMap::BeaconInfo& beacon = radio_map_.getBeacon(beacon_index);
+		FVector beaconPos = beacon.position - startPos;
+
+		msr::airlib::WifiHit thisHit;
+		thisHit.beaconID = beacon.id;
+		thisHit.rssi = sample.rssi;
+		thisHit.beaconPosX = beaconPos[0];
+		thisHit.beaconPosY = beaconPos[1];
+		thisHit.beaconPosZ = beaconPos[2];
+		thisHit.distance = sample.distance;
+
+		// One hit per path, like the live trace reports them
+		for (int path = 0; path < sample.path_count; path++) {
+			WifiHitLog.Add(thisHit);
+		}
+	}
+}
 
-		// Trace ray, bounce and add to hitlog if beacon was hit
-		traceDirection(sensorBase_global, lineEnd, &WifiHitLog, 0, 0, 1, 0, sensorBase_global);
-	//});
+void UnrealWifiSensor::reportState(msr::airlib::StateReporter& reporter) {
+	WifiSimple::reportState(reporter);
+
+	if (radio_map_.isValid()) {
+		const UnrealRadioMap::Stats& stats = radio_map_.getStats();
+		reporter.writeValue("Wifi-RadioMapHitRate", stats.queries > 0 ? (float)stats.cache_hits / stats.queries : 0.0f);
+		reporter.writeValue("Wifi-RadioMapDynamicFallbacks", stats.dynamic_fallbacks);
+		reporter.writeValue("Wifi-RadioMapOutOfBounds", stats.out_of_bounds_fallbacks);
+		reporter.writeValue("Wifi-RadioMapRssiError", stats.validated_beacons > 0 ? stats.rssi_error_sum / stats.validated_beacons : 0.0);
+		reporter.writeValue("Wifi-RadioMapDistanceError", stats.validated_beacons > 0 ? stats.distance_error_sum / stats.validated_beacons : 0.0);
+		reporter.writeValue("Wifi-RadioMapPresenceMismatches", stats.presence_mismatches);
 	}
-	//actor_->GetWorld()->GetPhysicsScene()->GetPxScene()->unlockRead();
-	beaconsActive_.Add(WifiHitLog);
 }
 
 // Thanks Girmi
@@ -173,7 +258,7 @@ void UnrealWifiSensor::sampleSphereCap(int num_points, float opening_angle) {
 	}
 }
 
-int UnrealWifiSensor::traceDirection(FVector trace_start_position, FVector trace_end_position, TArray<msr::airlib::WifiHit> *WifiHitLog, float traceRayCurrentDistance, float traceRayCurrentbounces, float traceRayCurrentSignalStrength, bool drawDebug, FVector trace_origin) {
+int UnrealWifiSensor::traceDirection(FVector trace_start_position, FVector trace_end_position, TArray<msr::airlib::WifiHit> *WifiHitLog, float traceRayCurrentDistance, float traceRayCurrentbounces, float traceRayCurrentSignalStrength, bool drawDebug, FVector trace_origin, bool from_radio_map_build) {
 	FHitResult trace_hit_result;
 	bool trace_hit;
 	TArray<AActor*> ignore_actors_;
@@ -183,7 +268,8 @@ int UnrealWifiSensor::traceDirection(FVector trace_start_position, FVector trace
 		if (traceRayCurrentbounces < traceRayMaxBounces) {
 			if (traceRayCurrentSignalStrength > traceRayMinSignalStrength) {
 				trace_hit_result = FHitResult(ForceInit);
-				trace_hit = UAirBlueprintLib::GetObstacleAdv(actor_, trace_start_position, trace_end_position, trace_hit_result, ignore_actors_, ECC_Visibility, true, true);
+				trace_hit = from_radio_map_build ? radio_map_.traceScene(trace_start_position, trace_end_position, trace_hit_result)
+					: UAirBlueprintLib::GetObstacleAdv(actor_, trace_start_position, trace_end_position, trace_hit_result, ignore_actors_, ECC_Visibility, true, true);
 				
 
 				// Stop if nothing was hit to reflect off
@@ -202,19 +288,21 @@ int UnrealWifiSensor::traceDirection(FVector trace_start_position, FVector trace
 				trace_end_position = trace_start_position + trace_direction * trace_length;
 				traceRayCurrentbounces += 1;
 
-				// If beacon was hit
-				if (trace_hit_result.GetActor() != nullptr) {
+				// If beacon was hit, the radio map build only compares the hit actor with the beacons the game thread listed
+				auto hitActor = trace_hit_result.GetActor();
+				const int beacon_index = from_radio_map_build ? radio_map_.getBeaconIndex(hitActor) : -1;
+				if (beacon_index >= 0 || (!from_radio_map_build && hitActor != nullptr)) {
 					//if ((trace_hit_result.Actor->GetName().Len() >= 10) && (trace_hit_result.Actor->GetName().Left(10) == "wifiBeacon")) {
-					if (trace_hit_result.GetActor()->IsA(AWifiBeacon::StaticClass())) {
+					if (beacon_index >= 0 || hitActor->IsA(AWifiBeacon::StaticClass())) {
 						mtxWifi.lock();
-						auto hitActor = trace_hit_result.GetActor();
+						const UnrealRadioMap::BeaconInfo* beacon = beacon_index >= 0 ? &radio_map_.getBeacon(beacon_index) : nullptr;
 						
 						int tmpRssi = (int)traceRayCurrentSignalStrength;
-						FVector beaconPos = trace_hit_result.GetActor()->GetActorLocation() - startPos;
+						FVector beaconPos = (beacon != nullptr ? beacon->position : hitActor->GetActorLocation()) - startPos;
 						
 						msr::airlib::WifiHit thisHit;
 						
-						thisHit.beaconID = TCHAR_TO_UTF8(*hitActor->GetName());
+						thisHit.beaconID = beacon != nullptr ? beacon->id : std::string(TCHAR_TO_UTF8(*hitActor->GetName()));
 						
 						thisHit.rssi = tmpRssi;
 						thisHit.beaconPosX = beaconPos[0];
@@ -230,7 +318,7 @@ int UnrealWifiSensor::traceDirection(FVector trace_start_position, FVector trace
 					UAirBlueprintLib::DrawLine(actor_->GetWorld(), trace_start_original, trace_start_position, FColor::Red, false, 0.1);
 				}
 
-				return(traceDirection(trace_start_position, trace_end_position, WifiHitLog, traceRayCurrentDistance, traceRayCurrentbounces, traceRayCurrentSignalStrength, drawDebug, trace_origin));
+				return(traceDirection(trace_start_position, trace_end_position, WifiHitLog, traceRayCurrentDistance, traceRayCurrentbounces, traceRayCurrentSignalStrength, drawDebug, trace_origin, from_radio_map_build));
 			}
 		}
 	}
@@ -10,6 +10,7 @@
 #include "NedTransform.h"
 #include "AirBlueprintLib.h"
 #include "Weather/WeatherLib.h"
+#include "UnrealRadioMap.h"
 #include "map"
 
 // UnrealWifiSensor implementation that uses Ray Tracing in Unreal.
@@ -22,6 +23,8 @@ public:
 	UnrealWifiSensor(const AirSimSettings::WifiSetting& setting,
 		AActor* actor, const NedTransform* ned_transform);
 
+	virtual void reportState(msr::airlib::StateReporter& reporter) override;
+
 protected:
 	//virtual void getPointCloud(const msr::airlib::Pose& sensor_pose, const msr::airlib::Pose& vehicle_pose, msr::airlib::vector<msr::airlib::real_T>& point_cloud) override;
 
@@ -50,7 +53,11 @@ private:
 	std::vector<float> wifiTraceMaxDistances; // in meter
 
 	void sampleSphereCap(int num_points, float opening_angle);
-	int traceDirection(FVector trace_start_position, FVector trace_end_position, TArray<msr::airlib::WifiHit> *WifiHitLogfloat, float traceRayCurrentDistance, float traceRayCurrentbounces, float traceRayCurrentSignalStrength, bool drawDebug, FVector trace_origin);
+	// from_radio_map_build traces through the radio map and takes the beacons from its snapshot, for the build worker thread
+	void traceAllDirections(const FVector& sensor_position, const FRotator& sensor_rotation, TArray<msr::airlib::WifiHit>& WifiHitLog, bool from_radio_map_build = false);
+	void hitsToSamples(const TArray<msr::airlib::WifiHit>& WifiHitLog, TArray<UnrealRadioMap::BeaconSample>& samples);
+	void samplesToHits(const TArray<UnrealRadioMap::BeaconSample>& samples, TArray<msr::airlib::WifiHit>& WifiHitLog);
+	int traceDirection(FVector trace_start_position, FVector trace_end_position, TArray<msr::airlib::WifiHit> *WifiHitLogfloat, float traceRayCurrentDistance, float traceRayCurrentbounces, float traceRayCurrentSignalStrength, bool drawDebug, FVector trace_origin, bool from_radio_map_build = false);
 	void bounceTrace(FVector &trace_start_position, FVector &trace_direction, float &trace_length, const FHitResult &trace_hit_result, float &total_distance, float &signal_attenuation);
 	float angleBetweenVectors(FVector vector1, FVector vector2);
 	float getFreeSpaceLoss(float previous_distance, float added_distance);
@@ -69,5 +76,11 @@ private:
 
 	int maxWifiHits = 5;
 
+	// Optional precomputed propagation map around the static beacons. Declared after everything the build traces use,
+	// its destructor waits for the build
+	TArray<UnrealRadioMap::BeaconInfo> radio_map_beacons;
+	UnrealRadioMap radio_map_;
+	TArray<UnrealRadioMap::BeaconSample> radio_map_samples_;
+
 	void updateActiveBeacons();
 };
\ No newline at end of file
@@ -15,6 +15,7 @@
 #include <memory>
 #include "vehicles/multirotor/api/MultirotorRpcLibServer.hpp"
 #include "common/SteppableClock.hpp"
+#include "common/Settings.hpp"
 
 void ASimModeWorldMultiRotor::BeginPlay()
 {
@@ -36,6 +37,15 @@ void ASimModeWorldMultiRotor::setupClockSpeed()
 {
     typedef msr::airlib::ClockFactory ClockFactory;
 
+    //a longer physics period is cheaper per simulated second, FastPhysicsEngine sub-steps (MaxSubStep) keep the
+    //dynamics accurate while vehicle controllers still run once per physics period
+    msr::airlib::Settings fast_phys_settings;
+    if (msr::airlib::Settings::singleton().getChild("FastPhysicsEngine", fast_phys_settings)) {
+        const double physics_loop_period = fast_phys_settings.getDouble("PhysicsLoopPeriod", 0);
+        if (physics_loop_period > 0)
+            setPhysicsLoopPeriod(static_cast<long long>(physics_loop_period * 1E9));
+    }
+
     float clock_speed = getSettings().clock_speed;
 
     //setup clock in ClockFactory
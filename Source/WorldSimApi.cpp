@@ -9,6 +9,9 @@
 #include "Runtime/Engine/Classes/Engine/Engine.h"
 #include "Misc/OutputDeviceNull.h"
 #include "ImageUtils.h"
+#include "Async/ParallelFor.h"
+#include "common/VoxelGridBuilder.hpp"
+#include "common/OccupancyOctree.hpp"
 #include <cstdlib>
 #include <ctime>
 #include <algorithm>
@@ -62,9 +65,11 @@ void WorldSimApi::spawnPlayer()
 bool WorldSimApi::destroyObject(const std::string& object_name)
 {
     bool result{ false };
-    UAirBlueprintLib::RunCommandOnGameThread([this, &object_name, &result]() {
+    FBox bounds(ForceInit);
+    UAirBlueprintLib::RunCommandOnGameThread([this, &object_name, &result, &bounds]() {
         AActor* actor = UAirBlueprintLib::FindActor<AActor>(simmode_, FString(object_name.c_str()));
         if (actor) {
+            bounds = actor->GetComponentsBoundingBox();
             actor->Destroy();
             result = !IsValid(actor);
         }
@@ -74,6 +79,8 @@ bool WorldSimApi::destroyObject(const std::string& object_name)
         GEngine->ForceGarbageCollection(true);
     },
                                              true);
+    if (result)
+        updateOccupancyMap(bounds);
     return result;
 }
 
@@ -102,8 +109,9 @@ std::string WorldSimApi::spawnObject(const std::string& object_name, const std::
 
     bool spawned_object = false;
     std::string final_object_name = object_name;
+    FBox bounds(ForceInit);
 
-    UAirBlueprintLib::RunCommandOnGameThread([this, load_asset, &final_object_name, &spawned_object, &actor_transform, &scale, &physics_enabled, &is_blueprint]() {
+    UAirBlueprintLib::RunCommandOnGameThread([this, load_asset, &final_object_name, &spawned_object, &bounds, &actor_transform, &scale, &physics_enabled, &is_blueprint]() {
         // Ensure new non-matching name for the object
         std::vector<std::string> matching_names = UAirBlueprintLib::ListMatchingActors(simmode_, ".*" + final_object_name + ".*");
         if (matching_names.size() > 0) {
@@ -133,6 +141,7 @@ std::string WorldSimApi::spawnObject(const std::string& object_name, const std::
         if (IsValid(NewActor)) {
             spawned_object = true;
             simmode_->scene_object_map.Add(FString(final_object_name.c_str()), NewActor);
+            bounds = NewActor->GetComponentsBoundingBox();
         }
 
         UAirBlueprintLib::setSimulatePhysics(NewActor, physics_enabled);
@@ -143,6 +152,7 @@ std::string WorldSimApi::spawnObject(const std::string& object_name, const std::
         throw std::invalid_argument(
             "Engine could not spawn " + load_object + " because of a stale reference of same name");
     }
+    updateOccupancyMap(bounds);
     return final_object_name;
 }
 
@@ -176,69 +186,204 @@ AActor* WorldSimApi::createNewBPActor(const FActorSpawnParameters& spawn_params,
 
 bool WorldSimApi::createVoxelGrid(const Vector3r& position, const int& x_size, const int& y_size, const int& z_size, const float& res, const std::string& output_file)
 {
-    bool success = false;
     int ncells_x = x_size / res;
     int ncells_y = y_size / res;
     int ncells_z = z_size / res;
 
-    voxel_grid_.resize(ncells_x * ncells_y * ncells_z);
+    std::ofstream output(output_file, std::ios::out | std::ios::binary);
+    if (!output.good()) {
+        UE_LOG(LogTemp, Error, TEXT("Could not open output file to write voxel grid!"));
+        return false;
+    }
 
-    float scale_cm = res * 100;
     FCollisionQueryParams params;
     params.bFindInitialOverlaps = true;
     params.bTraceComplex = false;
     params.TraceTag = "";
-    auto position_in_UE_frame = simmode_->getGlobalNedTransform().fromGlobalNed(position);
-    for (float i = 0; i < ncells_x; i++) {
-        for (float k = 0; k < ncells_z; k++) {
-            for (float j = 0; j < ncells_y; j++) {
-                int idx = i + ncells_x * (k + ncells_z * j);
-                FVector vposition = FVector((i - ncells_x / 2) * scale_cm, (j - ncells_y / 2) * scale_cm, (k - ncells_z / 2) * scale_cm) + position_in_UE_frame;
-                voxel_grid_[idx] = simmode_->GetWorld()->OverlapBlockingTestByChannel(vposition, FQuat::Identity, ECollisionChannel::ECC_Pawn, FCollisionShape::MakeBox(FVector(scale_cm / 2)), params);
-            }
-        }
+    const FVector position_in_UE_frame = simmode_->getGlobalNedTransform().fromGlobalNed(position);
+    UWorld* world = simmode_->GetWorld();
+
+    //the grid frame is the Unreal frame in meters, centered on the requested position
+    msr::airlib::VoxelGridBuilder builder(ncells_x, ncells_y, ncells_z, res);
+    builder.setParallel([](int count, const std::function<void(int)>& body) {
+        ParallelFor(count, [&body](int32 index) { body(index); });
+    });
+    builder.setProgress([](float fraction, uint64 overlap_tests) {
+        UAirBlueprintLib::LogMessageString("Voxel grid: ", std::to_string(static_cast<int>(fraction * 100)) + "% done, " + std::to_string(overlap_tests) + " overlap tests", LogDebugLevel::Informational);
+    });
+
+    const msr::airlib::VoxelGridBuilder::Stats stats = builder.writeBinvox(output, [world, &params, &position_in_UE_frame](const Vector3r& center, const Vector3r& half_extent) {
+        const FVector box_center = FVector(center.x(), center.y(), center.z()) * 100 + position_in_UE_frame;
+        return world->OverlapBlockingTestByChannel(box_center, FQuat::Identity, ECollisionChannel::ECC_Pawn,
+                                                   FCollisionShape::MakeBox(FVector(half_extent.x(), half_extent.y(), half_extent.z()) * 100), params);
+    }, x_size, y_size, z_size);
+    output.close();
+
+    UAirBlueprintLib::LogMessageString("Voxel grid: ", std::to_string(stats.occupied_cells) + " occupied cells, " + std::to_string(stats.overlap_tests) + " overlap tests for " +
+        std::to_string(static_cast<uint64>(ncells_x) * ncells_y * ncells_z) + " cells", LogDebugLevel::Success);
+    return output.good();
+}
+
+msr::airlib::OccupancyOctree::OverlapFunction WorldSimApi::getOccupancyOverlapFunction() const
+{
+    FCollisionQueryParams params;
+    params.bFindInitialOverlaps = true;
+    params.bTraceComplex = false;
+    params.TraceTag = "";
+    UWorld* world = simmode_->GetWorld();
+    const NedTransform& ned_transform = simmode_->getGlobalNedTransform();
+
+    //the octree is in NED meters, an axis aligned box stays axis aligned in the Unreal frame
+    return [world, params, &ned_transform](const Vector3r& center, const Vector3r& half_extent) {
+        return world->OverlapBlockingTestByChannel(ned_transform.fromGlobalNed(center), FQuat::Identity, ECollisionChannel::ECC_Pawn,
+                                                   FCollisionShape::MakeBox(FVector(half_extent.x(), half_extent.y(), half_extent.z()) * ned_transform.fromNed(1.0f)), params);
+    };
+}
+
+void WorldSimApi::updateOccupancyMap(const FBox& bounds)
+{
+    if (!bounds.IsValid)
+        return;
+
+    std::lock_guard<std::mutex> lock(occupancy_map_mutex_);
+    if (!occupancy_map_ || !occupancy_map_->isValid())
+        return;
+
+    const Vector3r corner1 = simmode_->getGlobalNedTransform().toGlobalNed(bounds.Min);
+    const Vector3r corner2 = simmode_->getGlobalNedTransform().toGlobalNed(bounds.Max);
+    occupancy_map_->update(corner1.cwiseMin(corner2), corner1.cwiseMax(corner2), getOccupancyOverlapFunction());
+}
+
+bool WorldSimApi::buildOccupancyMap(const Vector3r& center, float size, float resolution)
+{
+    if (size <= 0 || resolution <= 0) {
+        UAirBlueprintLib::LogMessageString("Occupancy map: ", "size and resolution must be positive", LogDebugLevel::Failure);
+        return false;
     }
 
-    std::ofstream output(output_file, std::ios::out | std::ios::binary);
-    if (!output.good()) {
-        UE_LOG(LogTemp, Error, TEXT("Could not open output file to write voxel grid!"));
-        return success;
+    std::unique_ptr<msr::airlib::OccupancyOctree> occupancy_map(new msr::airlib::OccupancyOctree());
+    occupancy_map->initialize(center, size, resolution);
+    occupancy_map->build(getOccupancyOverlapFunction(), [](int count, const std::function<void(int)>& body) {
+        ParallelFor(count, [&body](int32 index) { body(index); });
+    });
+
+    UAirBlueprintLib::LogMessageString("Occupancy map: ", std::to_string(occupancy_map->getNodeCount()) + " nodes, " + std::to_string(occupancy_map->getSize()) + " m wide at " + std::to_string(occupancy_map->getResolution()) + " m", LogDebugLevel::Success);
+
+    std::lock_guard<std::mutex> lock(occupancy_map_mutex_);
+    occupancy_map_ = std::move(occupancy_map);
+    return true;
+}
+
+int WorldSimApi::getOccupancy(const Vector3r& point) const
+{
+    std::lock_guard<std::mutex> lock(occupancy_map_mutex_);
+    if (!occupancy_map_)
+        return static_cast<int>(msr::airlib::OccupancyOctree::Occupancy::Unknown);
+    return static_cast<int>(occupancy_map_->getOccupancy(point));
+}
+
+WorldSimApi::Vector3r WorldSimApi::castRayOccupancyMap(const Vector3r& start, const Vector3r& end) const
+{
+    std::lock_guard<std::mutex> lock(occupancy_map_mutex_);
+    Vector3r hit_point;
+    if (!occupancy_map_ || !occupancy_map_->castRay(start, end, hit_point))
+        return Vector3r::Constant(std::numeric_limits<float>::quiet_NaN());
+    return hit_point;
+}
+
+std::vector<float> WorldSimApi::getOccupancyMapRegion(const Vector3r& min, const Vector3r& max) const
+{
+    std::vector<msr::airlib::OccupancyOctree::Cell> cells;
+    {
+        std::lock_guard<std::mutex> lock(occupancy_map_mutex_);
+        if (occupancy_map_)
+            occupancy_map_->getOccupiedCells(min.cwiseMin(max), min.cwiseMax(max), cells);
     }
 
-    // Write the binvox file using run-length encoding
-    // where each pair of bytes is of the format (run value, run length)
-    output << "#binvox 1\n";
-    output << "dim " << ncells_x << " " << ncells_z << " " << ncells_y << "\n";
-    output << "translate " << -x_size * 0.5 << " " << -y_size * 0.5 << " " << -z_size * 0.5 << "\n";
-    output << "scale " << x_size << "\n";
-    output << "data\n";
-    bool run_value = voxel_grid_[0];
-    unsigned int run_length = 0;
-    for (size_t i = 0; i < voxel_grid_.size(); ++i) {
-        if (voxel_grid_[i] == run_value) {
-            // This is a run (repeated bit value)
-            run_length++;
-            if (run_length == 255) {
-                output << static_cast<char>(run_value);
-                output << static_cast<char>(run_length);
-                run_length = 0;
-            }
+    std::vector<float> result;
+    result.reserve(cells.size() * 4);
+    for (const auto& cell : cells) {
+        result.push_back(cell.center.x());
+        result.push_back(cell.center.y());
+        result.push_back(cell.center.z());
+        result.push_back(cell.size);
+    }
+    return result;
+}
+
+bool WorldSimApi::saveOccupancyMap(const std::string& file_path) const
+{
+    std::lock_guard<std::mutex> lock(occupancy_map_mutex_);
+    return occupancy_map_ && occupancy_map_->save(file_path);
+}
+
+bool WorldSimApi::loadOccupancyMap(const std::string& file_path)
+{
+    std::unique_ptr<msr::airlib::OccupancyOctree> occupancy_map(new msr::airlib::OccupancyOctree());
+    if (!occupancy_map->open(file_path))
+        return false;
+
+    std::lock_guard<std::mutex> lock(occupancy_map_mutex_);
+    occupancy_map_ = std::move(occupancy_map);
+    return true;
+}
+
+int WorldSimApi::addGeoFence(const std::vector<float>& vertices, float min_z, float max_z, bool keep_out)
+{
+    msr::airlib::SafetyMonitor* safety_monitor = simmode_->getSafetyMonitor();
+    if (safety_monitor == nullptr)
+        return -1;
+    if (vertices.size() % 2 != 0)
+        throw std::invalid_argument("Geofence vertices must be x, y pairs");
+
+    std::vector<msr::airlib::Vector2r> polygon(vertices.size() / 2);
+    for (size_t i = 0; i < polygon.size(); ++i)
+        polygon[i] = msr::airlib::Vector2r(vertices[2 * i], vertices[2 * i + 1]);
+    return safety_monitor->addFence(std::make_shared<msr::airlib::PolygonGeoFence>(polygon, min_z, max_z), keep_out);
+}
+
+bool WorldSimApi::removeGeoFence(int fence_id)
+{
+    msr::airlib::SafetyMonitor* safety_monitor = simmode_->getSafetyMonitor();
+    return safety_monitor != nullptr && safety_monitor->removeFence(fence_id);
+}
+
+bool WorldSimApi::setSafetySeparation(float distance)
+{
+    msr::airlib::SafetyMonitor* safety_monitor = simmode_->getSafetyMonitor();
+    if (safety_monitor == nullptr)
+        return false;
+    safety_monitor->setSeparation(distance);
+    return true;
+}
+
+std::vector<msr::airlib::SafetyEvent> WorldSimApi::getSafetyEvents()
+{
+    std::vector<msr::airlib::SafetyEvent> result;
+    msr::airlib::SafetyMonitor* safety_monitor = simmode_->getSafetyMonitor();
+    if (safety_monitor == nullptr)
+        return result;
+
+    std::lock_guard<std::mutex> lock(safety_events_mutex_);
+    msr::airlib::SafetyMonitor::Event event;
+    while (safety_monitor->popEvent(event)) {
+        msr::airlib::SafetyEvent info;
+        info.step = event.step;
+        info.is_violation = event.is_violation;
+        info.vehicle_name = safety_monitor->getVehicleName(event.vehicle);
+        if (event.type == msr::airlib::SafetyMonitor::EventType::GeoFence) {
+            info.type = "GeoFence";
+            info.fence_id = event.other;
         }
         else {
-            // End of a run
-            output << static_cast<char>(run_value);
-            output << static_cast<char>(run_length);
-            run_value = voxel_grid_[i];
-            run_length = 1;
+            info.type = "Separation";
+            info.other_vehicle_name = safety_monitor->getVehicleName(event.other);
         }
+        info.position = event.position;
+        info.distance = event.distance;
+        result.push_back(info);
     }
-    if (run_length > 0) {
-        output << static_cast<char>(run_value);
-        output << static_cast<char>(run_length);
-    }
-    output.close();
-    success = true;
-    return success;
+    return result;
 }
 
 bool WorldSimApi::isPaused() const
@@ -456,20 +601,26 @@ WorldSimApi::Vector3r WorldSimApi::getObjectScale(const std::string& object_name
 bool WorldSimApi::setObjectPose(const std::string& object_name, const WorldSimApi::Pose& pose, bool teleport)
 {
     bool result;
-    UAirBlueprintLib::RunCommandOnGameThread([this, &object_name, &pose, teleport, &result]() {
+    FBox bounds(ForceInit);
+    UAirBlueprintLib::RunCommandOnGameThread([this, &object_name, &pose, teleport, &result, &bounds]() {
         FTransform actor_transform = simmode_->getGlobalNedTransform().fromGlobalNed(pose);
         // AActor* actor = UAirBlueprintLib::FindActor<AActor>(simmode_, FString(object_name.c_str()));
         AActor* actor = simmode_->scene_object_map.FindRef(FString(object_name.c_str()));
         if (actor) {
+            //both the old and the new location changed
+            bounds = actor->GetComponentsBoundingBox();
             if (teleport)
                 result = actor->SetActorLocationAndRotation(actor_transform.GetLocation(), actor_transform.GetRotation(), false, nullptr, ETeleportType::TeleportPhysics);
             else
                 result = actor->SetActorLocationAndRotation(actor_transform.GetLocation(), actor_transform.GetRotation(), true);
+            bounds += actor->GetComponentsBoundingBox();
         }
         else
             result = false;
     },
                                              true);
+    if (result)
+        updateOccupancyMap(bounds);
     return result;
 }
 
@@ -1110,8 +1261,8 @@ std::vector<msr::airlib::DetectionInfo> WorldSimApi::getDetections(ImageCaptureB
 
     const APIPCamera* camera = simmode_->getCamera(camera_details);
     const NedTransform& ned_transform = simmode_->getVehicleSimApi(camera_details.vehicle_name)->getNedTransform();
-    TMap<UMeshComponent*, FString> component_to_name_map = simmode_->GetInstanceSegmentationComponentToNameMap();
-    UAirBlueprintLib::RunCommandOnGameThread([camera, image_type, component_to_name_map , &result, &ned_transform, annotation_name]() {
+    UAirBlueprintLib::RunCommandOnGameThread([this, camera, image_type, &result, &ned_transform, annotation_name]() {
+        const TMap<UMeshComponent*, FString>& component_to_name_map = simmode_->GetInstanceSegmentationComponentToNameMap();
         const TArray<FDetectionInfo>& detections = camera->getDetectionComponent(image_type, false, annotation_name)->getDetections(component_to_name_map);
         result.resize(detections.Num());
 
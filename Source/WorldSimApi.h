@@ -8,6 +8,9 @@
 #include "Components/StaticMeshComponent.h"
 #include "AssetRegistry/AssetData.h"
 #include "Runtime/Engine/Classes/Engine/StaticMesh.h"
+#include "common/OccupancyOctree.hpp"
+#include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 
@@ -104,6 +107,16 @@ public:
     virtual void setWind(const Vector3r& wind) const override;
     virtual void setExtForce(const Vector3r& ext_force) const override;
     virtual bool createVoxelGrid(const Vector3r& position, const int& x_size, const int& y_size, const int& z_size, const float& res, const std::string& output_file) override;
+    virtual bool buildOccupancyMap(const Vector3r& center, float size, float resolution) override;
+    virtual int getOccupancy(const Vector3r& point) const override;
+    virtual Vector3r castRayOccupancyMap(const Vector3r& start, const Vector3r& end) const override;
+    virtual std::vector<float> getOccupancyMapRegion(const Vector3r& min, const Vector3r& max) const override;
+    virtual bool saveOccupancyMap(const std::string& file_path) const override;
+    virtual bool loadOccupancyMap(const std::string& file_path) override;
+    virtual int addGeoFence(const std::vector<float>& vertices, float min_z, float max_z, bool keep_out) override;
+    virtual bool removeGeoFence(int fence_id) override;
+    virtual bool setSafetySeparation(float distance) override;
+    virtual std::vector<msr::airlib::SafetyEvent> getSafetyEvents() override;
     virtual std::vector<std::string> listVehicles() const override;
 
     virtual std::string getSettingsString() const override;
@@ -149,8 +162,16 @@ private:
     AActor* createNewStaticMeshActor(const FActorSpawnParameters& spawn_params, const FTransform& actor_transform, const Vector3r& scale, UStaticMesh* static_mesh);
     AActor* createNewBPActor(const FActorSpawnParameters& spawn_params, const FTransform& actor_transform, const Vector3r& scale, UBlueprint* blueprint);
     void spawnPlayer();
+    msr::airlib::OccupancyOctree::OverlapFunction getOccupancyOverlapFunction() const;
+    void updateOccupancyMap(const FBox& bounds);
 
 private:
     ASimModeBase* simmode_;
-    std::vector<bool> voxel_grid_;
+
+    //NED frame, rebuilt by buildOccupancyMap and kept in sync by the object APIs
+    std::unique_ptr<msr::airlib::OccupancyOctree> occupancy_map_;
+    mutable std::mutex occupancy_map_mutex_;
+
+    //the safety monitor's event queue has a single consumer, RPC calls can come from several threads
+    std::mutex safety_events_mutex_;
 };